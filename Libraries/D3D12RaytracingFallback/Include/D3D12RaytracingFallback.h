@@ -44,6 +44,15 @@ typedef struct D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC
     WRAPPED_GPU_POINTER AccelerationStructure;
 }     D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC;
 
+typedef struct D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS
+{
+    UINT64 NumLookups;
+    UINT64 NumMemoryHits;
+    UINT64 NumDiskHits;
+    UINT64 NumLinks;
+    double TotalLinkTimeInMilliseconds;
+}     D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS;
+
 class
 _declspec(uuid("539e5c40-df25-4c7d-81d8-6537f54306ed"))
 ID3D12RaytracingFallbackStateObject : public IUnknown
@@ -133,6 +142,19 @@ public:
         _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS *pDesc,
         _Out_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO *pInfo) = 0;
 
+    // Checks whether data written by COPY_MODE_SERIALIZE can be deserialized on this device
+    virtual D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS STDMETHODCALLTYPE CheckDriverMatchingIdentifier(
+        _In_  D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+        _In_  const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck) = 0;
+
+    // Linked raytracing pipelines are cached in memory and reused when a state object with the
+    // same contents is created again. Setting a directory also persists them across runs.
+    // Only applies to the compute fallback, drivers manage their own shader caches.
+    virtual void SetStateObjectCacheDirectory(_In_opt_ LPCWSTR pDirectory) = 0;
+
+    virtual void GetStateObjectCacheStatistics(
+        _Out_ D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS *pStatistics) = 0;
+
     virtual void QueryRaytracingCommandList(
         ID3D12GraphicsCommandList *pCommandList, 
         REFIID riid,
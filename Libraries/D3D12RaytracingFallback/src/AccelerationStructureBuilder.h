@@ -17,6 +17,8 @@ namespace FallbackLayer
     enum AccelerationStructureLayoutType
     {
         BVH2 = 0,
+        CompressedBVH4,
+        CompressedBVH8,
         NumAccelerationStructureLayoutTypes
     };
 
@@ -46,6 +48,10 @@ namespace FallbackLayer
             _In_  UINT NumSourceAccelerationStructures,
             _In_reads_(NumSourceAccelerationStructures)  const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData) = 0;
 
+        virtual D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS CheckDriverMatchingIdentifier(
+            _In_  D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+            _In_  const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck) = 0;
+
         virtual AccelerationStructureLayoutType GetAccelerationStructureType() = 0;
     };
 
@@ -23,6 +23,16 @@ namespace FallbackLayer
                 static BvhValidator bvhValidator;
                 return bvhValidator;
             }
+        case CompressedBVH4:
+            {
+                static CompressedWideBvhValidator compressedBvh4Validator(CompressedBVH4);
+                return compressedBvh4Validator;
+            }
+        case CompressedBVH8:
+            {
+                static CompressedWideBvhValidator compressedBvh8Validator(CompressedBVH8);
+                return compressedBvh8Validator;
+            }
 
         default:
             ThrowInternalFailure(E_INVALIDARG);
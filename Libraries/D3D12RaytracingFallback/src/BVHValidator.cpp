@@ -14,41 +14,53 @@
 namespace FallbackLayer
 {
 
-    // TODO: Likely too large, but good enough for current validation
-#define TEST_EPSILON 0.001
+    // TODO: Likely too large near the origin, but good enough for current validation
+    const float AbsoluteValidationEpsilon = 0.001f;
 
-    bool IsChildContainedByParent(const AABB &parent, const AABB &child)
+    // Far from the origin a float can't resolve the absolute epsilon, and the rounding of
+    // a decompressed box grows with its coordinates, so the epsilon grows with them too.
+    const float RelativeValidationEpsilon = 0.000001f;
+
+    float GetValidationEpsilon(const AABB &sceneBounds)
+    {
+        const float largestCoordinate = std::max({
+            std::abs(sceneBounds.min.x), std::abs(sceneBounds.min.y), std::abs(sceneBounds.min.z),
+            std::abs(sceneBounds.max.x), std::abs(sceneBounds.max.y), std::abs(sceneBounds.max.z) });
+        return std::max(AbsoluteValidationEpsilon, largestCoordinate * RelativeValidationEpsilon);
+    }
+
+    bool IsChildContainedByParent(const AABB &parent, const AABB &child, float epsilon)
     {
         return
-            parent.min.x - TEST_EPSILON <= child.min.x &&
-            parent.min.y - TEST_EPSILON <= child.min.y &&
-            parent.min.z - TEST_EPSILON <= child.min.z &&
+            parent.min.x - epsilon <= child.min.x &&
+            parent.min.y - epsilon <= child.min.y &&
+            parent.min.z - epsilon <= child.min.z &&
 
-            parent.max.x + TEST_EPSILON >= child.max.x &&
-            parent.max.y + TEST_EPSILON >= child.max.y &&
-            parent.max.z + TEST_EPSILON >= child.max.z;
+            parent.max.x + epsilon >= child.max.x &&
+            parent.max.y + epsilon >= child.max.y &&
+            parent.max.z + epsilon >= child.max.z;
     }
 
-    bool IsFloatEqual(float a, float b)
+    bool IsFloatEqual(float a, float b, float epsilon)
     {
-        return fabs(a - b) < TEST_EPSILON;
+        return fabs(a - b) < epsilon;
     }
 
-    bool BvhValidator::IsVertexEqual(const BvhValidator::Vertex &vertex1, const BvhValidator::Vertex &vertex2)
+    bool BvhValidator::IsVertexEqual(const BvhValidator::Vertex &vertex1, const BvhValidator::Vertex &vertex2, float epsilon)
     {
-        return IsFloatEqual(vertex1.x, vertex2.x) &&
-            IsFloatEqual(vertex1.y, vertex2.y) &&
-            IsFloatEqual(vertex1.z, vertex2.z);
+        return IsFloatEqual(vertex1.x, vertex2.x, epsilon) &&
+            IsFloatEqual(vertex1.y, vertex2.y, epsilon) &&
+            IsFloatEqual(vertex1.z, vertex2.z, epsilon);
     }
 
-    bool BvhValidator::IsVertexContainedByAABB(const AABB &aabb, const BvhValidator::Vertex &v)
+    bool BvhValidator::IsVertexContainedByAABB(const AABB &aabb, const BvhValidator::Vertex &v, float epsilon)
     {
-        return v.x + TEST_EPSILON >= aabb.min.x &&
-            v.y + TEST_EPSILON >= aabb.min.y &&
-            v.z + TEST_EPSILON >= aabb.min.z &&
-            v.x - TEST_EPSILON <= aabb.max.x &&
-            v.y - TEST_EPSILON <= aabb.max.y &&
-            v.z - TEST_EPSILON <= aabb.max.z;
+        return v.x + epsilon >= aabb.min.x &&
+            v.y + epsilon >= aabb.min.y &&
+            v.z + epsilon >= aabb.min.z &&
+            v.x - epsilon <= aabb.max.x &&
+            v.y - epsilon <= aabb.max.y &&
+            v.z - epsilon <= aabb.max.z;
     }
 
     bool IsChildNodeIndexValid(UINT nodeIndex)
@@ -58,6 +70,7 @@ namespace FallbackLayer
 
     bool BvhValidator::VerifyBVHOutput(
         std::vector<LeafNodePtr> &pExpectedLeafNodes,
+        float epsilon,
         const BYTE *pOutputCpuData,
         std::wstring &errorMessage)
     {
@@ -114,7 +127,7 @@ namespace FallbackLayer
                         AABBNode *pLeftNode = &pNodeArray[pCompressedNode->internalNode.leftNodeIndex];
                         AABB leftAABB;
                         FallbackLayer::DecompressAABB(leftAABB, *pLeftNode);
-                        ThrowErrorIfFalse(IsChildContainedByParent(parentAABB, leftAABB), L"AABB not contained by parent");
+                        ThrowErrorIfFalse(IsChildContainedByParent(parentAABB, leftAABB, epsilon), L"AABB not contained by parent");
 
                         nodeQueue.push_back(pLeftNode);
                     }
@@ -126,7 +139,7 @@ namespace FallbackLayer
                         AABBNode *pRightNode = &pNodeArray[rightNodeIndex];
                         AABB rightAABB;
                         FallbackLayer::DecompressAABB(rightAABB, *pRightNode);
-                        ThrowErrorIfFalse(IsChildContainedByParent(parentAABB, rightAABB), L"AABB not contained by parent");
+                        ThrowErrorIfFalse(IsChildContainedByParent(parentAABB, rightAABB, epsilon), L"AABB not contained by parent");
 
                         nodeQueue.push_back(pRightNode);
                     }
@@ -181,13 +194,13 @@ namespace FallbackLayer
 
     bool BvhValidator::AABBLeafNode::IsContainedByBox(const AABB &parentBox)
     {
-        return IsChildContainedByParent(parentBox, box);
+        return IsChildContainedByParent(parentBox, box, Epsilon);
     };
 
     bool BvhValidator::AABBLeafNode::IsLeafEqual(void *pLeafData, const AABB &leafAABB)
     {
         UNREFERENCED_PARAMETER(pLeafData);
-        return IsChildContainedByParent(leafAABB, box);
+        return IsChildContainedByParent(leafAABB, box, Epsilon);
     }
 
     template<typename V>
@@ -232,25 +245,34 @@ namespace FallbackLayer
         const BYTE *pOutputCpuData,
         std::wstring &errorMessage)
     {
-        std::vector<LeafNodePtr> pLeafNodes;
+        std::vector<AABB> boxes(numBoxes);
+        AABB sceneBounds = {};
         for (UINT i = 0; i < numBoxes; i ++)
         {
-            AABB aabb = pReferenceBoxes[i];
+            boxes[i] = pReferenceBoxes[i];
             if (ppInstanceTransforms)
             {
-                aabb = TransformAABB(aabb, ppInstanceTransforms[i]);
+                boxes[i] = TransformAABB(boxes[i], ppInstanceTransforms[i]);
             }
-            pLeafNodes.push_back(std::unique_ptr<LeafNode>(new AABBLeafNode(aabb)));
+            sceneBounds.min = min(sceneBounds.min, boxes[i].min);
+            sceneBounds.max = max(sceneBounds.max, boxes[i].max);
+        }
+
+        const float epsilon = GetValidationEpsilon(sceneBounds);
+        std::vector<LeafNodePtr> pLeafNodes;
+        for (auto &box : boxes)
+        {
+            pLeafNodes.push_back(std::unique_ptr<LeafNode>(new AABBLeafNode(box, epsilon)));
         }
 
-        return VerifyBVHOutput(pLeafNodes, pOutputCpuData, errorMessage);
+        return VerifyBVHOutput(pLeafNodes, epsilon, pOutputCpuData, errorMessage);
     }
 
     bool BvhValidator::TriangleLeafNode::IsContainedByBox(const AABB &box)
     {
-        return IsVertexContainedByAABB(box, v0) &&
-            IsVertexContainedByAABB(box, v1) &&
-            IsVertexContainedByAABB(box, v2);
+        return IsVertexContainedByAABB(box, v0, Epsilon) &&
+            IsVertexContainedByAABB(box, v1, Epsilon) &&
+            IsVertexContainedByAABB(box, v2, Epsilon);
     }
 
     bool BvhValidator::TriangleLeafNode::IsLeafEqual(void *pLeafData, const AABB &leafAABB)
@@ -258,7 +280,7 @@ namespace FallbackLayer
         UNREFERENCED_PARAMETER(leafAABB);
         Primitive *pPrimitive = (Primitive *)pLeafData;
         Triangle *pTriangle = &pPrimitive->triangle;
-        return IsTriangleEqual(*this, pTriangle);
+        return IsTriangleEqual(*this, pTriangle, Epsilon);
     }
 
     UINT CalculateBaseIndex(UINT triangleIndex)
@@ -293,7 +315,8 @@ namespace FallbackLayer
         UINT geometryCount,
         const BYTE *pBVHData, std::wstring &errorMessage)
     {
-        std::vector<std::unique_ptr<LeafNode>> pLeafNodes;
+        std::vector<Vertex> vertices;
+        AABB sceneBounds = {};
 
         for (UINT geometryIndex = 0; geometryIndex < geometryCount; geometryIndex++)
         {
@@ -318,13 +341,23 @@ namespace FallbackLayer
                     v[vertexIndex] = { pVertex[0], pVertex[1], pVertex[2] };
 
                     v[vertexIndex] = Transform(v[vertexIndex], geometryDescriptor.transform.data());
-                }
+                    vertices.push_back(v[vertexIndex]);
 
-                pLeafNodes.push_back(std::unique_ptr<LeafNode>(new TriangleLeafNode(v[0], v[1], v[2])));
+                    const float3 position = { v[vertexIndex].x, v[vertexIndex].y, v[vertexIndex].z };
+                    sceneBounds.min = min(sceneBounds.min, position);
+                    sceneBounds.max = max(sceneBounds.max, position);
+                }
             }
         }
 
-        return VerifyBVHOutput(pLeafNodes, pBVHData, errorMessage);
+        const float epsilon = GetValidationEpsilon(sceneBounds);
+        std::vector<std::unique_ptr<LeafNode>> pLeafNodes;
+        for (size_t i = 0; i + 3 <= vertices.size(); i += 3)
+        {
+            pLeafNodes.push_back(std::unique_ptr<LeafNode>(new TriangleLeafNode(vertices[i], vertices[i + 1], vertices[i + 2], epsilon)));
+        }
+
+        return VerifyBVHOutput(pLeafNodes, epsilon, pBVHData, errorMessage);
     }
 
     void DecompressAABB(
@@ -31,9 +31,11 @@ namespace FallbackLayer
         class LeafNode
         {
         public:
+            LeafNode(float epsilon) : Epsilon(epsilon) {}
             virtual bool IsContainedByBox(const AABB &box) = 0;
             virtual bool IsLeafEqual(void *pLeafData, const AABB &leafAABB) = 0;
             bool LeafFound = false;
+            float Epsilon;
         };
 
         struct Vertex
@@ -46,7 +48,7 @@ namespace FallbackLayer
         class AABBLeafNode : public LeafNode
         {
         public:
-            AABBLeafNode(const AABB &nBox) : box(nBox) {}
+            AABBLeafNode(const AABB &nBox, float epsilon) : LeafNode(epsilon), box(nBox) {}
             virtual bool IsLeafEqual(void *pLeafData, const AABB &leafAABB);
             virtual bool IsContainedByBox(const AABB &box);
 
@@ -56,7 +58,7 @@ namespace FallbackLayer
         class TriangleLeafNode : public LeafNode
         {
         public:
-            TriangleLeafNode(Vertex nV0, Vertex nV1, Vertex nV2) : v0(nV0), v1(nV1), v2(nV2) {}
+            TriangleLeafNode(Vertex nV0, Vertex nV1, Vertex nV2, float epsilon) : LeafNode(epsilon), v0(nV0), v1(nV1), v2(nV2) {}
             virtual bool IsContainedByBox(const AABB &box);
             virtual bool IsLeafEqual(void *pLeafData, const AABB &leafAABB);
             Vertex v0, v1, v2;
@@ -66,14 +68,15 @@ namespace FallbackLayer
 
         bool VerifyBVHOutput(
             std::vector<LeafNodePtr> &pExpectedLeafNodes,
+            float epsilon,
             const BYTE *pOutputCpuData,
             std::wstring &errorMessage);
 
-        static bool IsVertexContainedByAABB(const AABB &aabb, const BvhValidator::Vertex &v);
-        static bool IsVertexEqual(const Vertex &vertex1, const Vertex &vertex2);
+        static bool IsVertexContainedByAABB(const AABB &aabb, const BvhValidator::Vertex &v, float epsilon);
+        static bool IsVertexEqual(const Vertex &vertex1, const Vertex &vertex2, float epsilon);
 
         template <typename TriangleNode>
-        static bool IsTriangleEqual(const TriangleNode triangle, const Triangle *pTriangle)
+        static bool IsTriangleEqual(const TriangleNode triangle, const Triangle *pTriangle, float epsilon)
         {
             BvhValidator::Vertex v[3];
             for (UINT vertexIndex = 0; vertexIndex < 3; vertexIndex++)
@@ -83,13 +86,17 @@ namespace FallbackLayer
                 v[vertexIndex].z = pTriangle->v[vertexIndex].z;
             }
 
-            return IsVertexEqual(triangle.v0, v[0]) && 
-                   IsVertexEqual(triangle.v1, v[1]) &&
-                   IsVertexEqual(triangle.v2, v[2]);
+            return IsVertexEqual(triangle.v0, v[0], epsilon) && 
+                   IsVertexEqual(triangle.v1, v[1], epsilon) &&
+                   IsVertexEqual(triangle.v2, v[2], epsilon);
         }
     };
 
     void DecompressAABB(
         AABB& box,
         const AABBNode& packedBox);
+
+    // How far apart validators let two coordinates of a scene with the given bounds be and still
+    // treat them as equal. Grows with the distance of the scene from the origin.
+    float GetValidationEpsilon(const AABB &sceneBounds);
 }
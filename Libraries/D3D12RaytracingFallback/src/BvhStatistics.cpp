@@ -0,0 +1,522 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace FallbackLayer
+{
+    namespace
+    {
+        const float CostOfRayBoxIntersection = 1.2f;
+        const float CostOfRayPrimitiveIntersection = 1.0f;
+
+        // Layout independent copy of the tree. Leaves of wide layouts are children stored
+        // inside their parent rather than nodes of their own, they get a node here.
+        struct StatisticsNode
+        {
+            AABB Box;
+            UINT Parent;
+            UINT Depth;
+            std::vector<UINT> Children;
+            UINT FirstPrimitive;
+            UINT NumPrimitives;
+        };
+
+        struct StatisticsTree
+        {
+            std::vector<StatisticsNode> Nodes;
+
+            // Top-level primitives are the world space boxes of the instances, stored as procedural primitives
+            std::vector<Primitive> Primitives;
+            std::vector<UINT> PrimitiveLeaf;
+        };
+
+        float GetAxis(const float3 &v, UINT axis)
+        {
+            return (&v.x)[axis];
+        }
+
+        float ComputeSurfaceArea(const AABB &box)
+        {
+            const float3 dim = max(box.max - box.min, float3{ 0.0f, 0.0f, 0.0f });
+            return 2.0f * (dim.x * dim.y + dim.x * dim.z + dim.y * dim.z);
+        }
+
+        float ComputeVolume(const AABB &box)
+        {
+            const float3 dim = max(box.max - box.min, float3{ 0.0f, 0.0f, 0.0f });
+            return dim.x * dim.y * dim.z;
+        }
+
+        AABB IntersectAABB(const AABB &a, const AABB &b)
+        {
+            AABB box;
+            box.min = max(a.min, b.min);
+            box.max = min(a.max, b.max);
+            return box;
+        }
+
+        AABB CombineAABB(const AABB &a, const AABB &b)
+        {
+            AABB box;
+            box.min = min(a.min, b.min);
+            box.max = max(a.max, b.max);
+            return box;
+        }
+
+        bool IsOverlapping(const AABB &a, const AABB &b)
+        {
+            return a.min.x <= b.max.x && a.min.y <= b.max.y && a.min.z <= b.max.z &&
+                b.min.x <= a.max.x && b.min.y <= a.max.y && b.min.z <= a.max.z;
+        }
+
+        AABB GetPrimitiveAABB(const Primitive &primitive)
+        {
+            if (primitive.PrimitiveType == TRIANGLE_TYPE)
+            {
+                const Triangle &tri = primitive.triangle;
+                AABB box;
+                box.min = min(min(tri.v0, tri.v1), tri.v2);
+                box.max = max(max(tri.v0, tri.v1), tri.v2);
+                return box;
+            }
+            return primitive.aabb;
+        }
+
+        // A triangle is one polygon, a box is six
+        void GetPrimitivePolygons(const Primitive &primitive, std::vector<std::vector<float3>> &polygons)
+        {
+            polygons.clear();
+            if (primitive.PrimitiveType == TRIANGLE_TYPE)
+            {
+                const Triangle &tri = primitive.triangle;
+                polygons.push_back({ tri.v0, tri.v1, tri.v2 });
+                return;
+            }
+
+            const AABB &box = primitive.aabb;
+            for (UINT axis = 0; axis < 3; axis++)
+            {
+                const UINT u = (axis + 1) % 3;
+                const UINT v = (axis + 2) % 3;
+                for (UINT side = 0; side < 2; side++)
+                {
+                    float corner[4][3];
+                    const float uValues[4] = { box.minArr[u], box.maxArr[u], box.maxArr[u], box.minArr[u] };
+                    const float vValues[4] = { box.minArr[v], box.minArr[v], box.maxArr[v], box.maxArr[v] };
+                    std::vector<float3> face;
+                    for (UINT i = 0; i < 4; i++)
+                    {
+                        corner[i][axis] = side ? box.maxArr[axis] : box.minArr[axis];
+                        corner[i][u] = uValues[i];
+                        corner[i][v] = vValues[i];
+                        face.push_back(float3{ corner[i][0], corner[i][1], corner[i][2] });
+                    }
+                    polygons.push_back(face);
+                }
+            }
+        }
+
+        float ComputePolygonArea(const std::vector<float3> &polygon)
+        {
+            if (polygon.size() < 3)
+            {
+                return 0.0f;
+            }
+
+            float3 sum = { 0.0f, 0.0f, 0.0f };
+            for (size_t i = 1; i + 1 < polygon.size(); i++)
+            {
+                sum = sum + cross(polygon[i] - polygon[0], polygon[i + 1] - polygon[0]);
+            }
+            return 0.5f * sqrtf(dot(sum, sum));
+        }
+
+        // Sutherland-Hodgman against the six planes of the box
+        float ComputeClippedArea(const std::vector<float3> &polygon, const AABB &box, std::vector<float3> &scratch0, std::vector<float3> &scratch1)
+        {
+            scratch0 = polygon;
+            for (UINT axis = 0; axis < 3 && scratch0.size(); axis++)
+            {
+                for (UINT side = 0; side < 2 && scratch0.size(); side++)
+                {
+                    const float bound = side ? box.maxArr[axis] : box.minArr[axis];
+                    const float direction = side ? -1.0f : 1.0f;
+                    auto distance = [&](const float3 &v) { return (GetAxis(v, axis) - bound) * direction; };
+
+                    scratch1.clear();
+                    for (size_t i = 0; i < scratch0.size(); i++)
+                    {
+                        const float3 &a = scratch0[i];
+                        const float3 &b = scratch0[(i + 1) % scratch0.size()];
+                        const float distanceA = distance(a);
+                        const float distanceB = distance(b);
+                        if (distanceA >= 0.0f)
+                        {
+                            scratch1.push_back(a);
+                        }
+                        if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+                        {
+                            const float t = distanceA / (distanceA - distanceB);
+                            scratch1.push_back(a + (b - a) * t);
+                        }
+                    }
+                    std::swap(scratch0, scratch1);
+                }
+            }
+            return ComputePolygonArea(scratch0);
+        }
+
+        float GetNodeCost(const StatisticsNode &node)
+        {
+            return node.Children.size() ? CostOfRayBoxIntersection : CostOfRayPrimitiveIntersection * node.NumPrimitives;
+        }
+
+#define ThrowError(msg) errorMessage = msg; throw false;
+#define ThrowErrorIfFalse(exp, msg) if(!(exp)) {ThrowError(msg);}
+
+        UINT AddNode(StatisticsTree &tree, const AABB &box, UINT parent)
+        {
+            StatisticsNode node = {};
+            node.Box = box;
+            node.Parent = parent;
+            node.Depth = parent == (UINT)-1 ? 0 : tree.Nodes[parent].Depth + 1;
+            tree.Nodes.push_back(node);
+            if (parent != (UINT)-1)
+            {
+                tree.Nodes[parent].Children.push_back((UINT)tree.Nodes.size() - 1);
+            }
+            return (UINT)tree.Nodes.size() - 1;
+        }
+
+        void AddLeafPrimitives(StatisticsTree &tree, UINT nodeIndex, UINT firstPrimitive, UINT numPrimitives, std::wstring &errorMessage)
+        {
+            ThrowErrorIfFalse(firstPrimitive + numPrimitives <= tree.Primitives.size(), L"Primitive index out of range");
+            for (UINT i = firstPrimitive; i < firstPrimitive + numPrimitives; i++)
+            {
+                ThrowErrorIfFalse(tree.PrimitiveLeaf[i] == (UINT)-1, L"Primitive is referenced more than once");
+                tree.PrimitiveLeaf[i] = nodeIndex;
+            }
+            tree.Nodes[nodeIndex].FirstPrimitive = firstPrimitive;
+            tree.Nodes[nodeIndex].NumPrimitives = numPrimitives;
+        }
+
+        void LoadBvh2(const BYTE *pData, StatisticsTree &tree, std::wstring &errorMessage)
+        {
+            const BVHOffsets &offsets = *(const BVHOffsets *)pData;
+            const AABBNode *pNodes = (const AABBNode *)(pData + offsets.offsetToBoxes);
+            const UINT maxNodes = (offsets.offsetToVertices - offsets.offsetToBoxes) / SizeOfAABBNode;
+
+            // Same test as IsTopLevelBVH in the traversal shaders
+            const bool bTopLevel = offsets.offsetToPrimitiveMetaData == 0;
+            const UINT numPrimitives = bTopLevel ?
+                (offsets.totalSize - offsets.offsetToVertices) / SizeOfBVHMetadata :
+                (offsets.offsetToPrimitiveMetaData - offsets.offsetToVertices) / SizeOfPrimitive;
+            tree.Primitives.resize(numPrimitives);
+            tree.PrimitiveLeaf.assign(numPrimitives, (UINT)-1);
+            if (numPrimitives == 0)
+            {
+                return;
+            }
+            ThrowErrorIfFalse(maxNodes > 0, L"Missing root node");
+
+            if (!bTopLevel)
+            {
+                memcpy(tree.Primitives.data(), pData + offsets.offsetToVertices, numPrimitives * sizeof(Primitive));
+            }
+
+            struct StackEntry
+            {
+                UINT SourceIndex;
+                UINT Parent;
+            };
+            std::vector<bool> nodeVisited(maxNodes, false);
+            std::vector<StackEntry> stack(1, StackEntry{ 0, (UINT)-1 });
+            while (stack.size())
+            {
+                const StackEntry entry = stack.back();
+                stack.pop_back();
+
+                ThrowErrorIfFalse(entry.SourceIndex < maxNodes, L"Child node index out of range");
+                ThrowErrorIfFalse(!nodeVisited[entry.SourceIndex], L"Node is referenced more than once");
+                nodeVisited[entry.SourceIndex] = true;
+
+                const AABBNode &sourceNode = pNodes[entry.SourceIndex];
+                AABB box;
+                DecompressAABB(box, sourceNode);
+                const UINT nodeIndex = AddNode(tree, box, entry.Parent);
+
+                if (sourceNode.leaf)
+                {
+                    // BVH2 leaves always reference a single primitive, see MAX_TRIS_IN_LEAF
+                    const UINT primitiveIndex = sourceNode.leafNode.firstTriangleId;
+                    AddLeafPrimitives(tree, nodeIndex, primitiveIndex, 1, errorMessage);
+                    if (bTopLevel)
+                    {
+                        tree.Primitives[primitiveIndex].PrimitiveType = PROCEDURAL_PRIMITIVE_TYPE;
+                        tree.Primitives[primitiveIndex].aabb = box;
+                    }
+                }
+                else
+                {
+                    ThrowErrorIfFalse(sourceNode.internalNode.leftNodeIndex != 0 && sourceNode.rightNodeIndex != 0, L"Circular reference to root node");
+                    stack.push_back(StackEntry{ sourceNode.rightNodeIndex, nodeIndex });
+                    stack.push_back(StackEntry{ sourceNode.internalNode.leftNodeIndex, nodeIndex });
+                }
+            }
+        }
+
+        template <UINT Width>
+        void LoadCompressedWideBvh(const BYTE *pData, StatisticsTree &tree, std::wstring &errorMessage)
+        {
+            typedef CompressedWideBVHNode<Width> WideNode;
+
+            const BVHOffsets &offsets = *(const BVHOffsets *)pData;
+            const WideNode *pNodes = (const WideNode *)(pData + offsets.offsetToBoxes);
+            const UINT numNodes = (offsets.offsetToVertices - offsets.offsetToBoxes) / sizeof(WideNode);
+            const UINT numPrimitives = (offsets.offsetToPrimitiveMetaData - offsets.offsetToVertices) / SizeOfPrimitive;
+            tree.Primitives.resize(numPrimitives);
+            tree.PrimitiveLeaf.assign(numPrimitives, (UINT)-1);
+            if (numPrimitives == 0)
+            {
+                return;
+            }
+            ThrowErrorIfFalse(numNodes > 0, L"Missing root node");
+            memcpy(tree.Primitives.data(), pData + offsets.offsetToVertices, numPrimitives * sizeof(Primitive));
+
+            // The root box isn't stored, it's the union of the root's children
+            const WideNode &root = pNodes[0];
+            ThrowErrorIfFalse(root.NumChildren > 0 && root.NumChildren <= Width, L"Invalid number of children");
+            AABB rootBox = DecodeChildAABB(root, 0);
+            for (UINT i = 1; i < root.NumChildren; i++)
+            {
+                rootBox = CombineAABB(rootBox, DecodeChildAABB(root, i));
+            }
+
+            struct StackEntry
+            {
+                UINT SourceIndex;
+                UINT NodeIndex;
+            };
+            std::vector<bool> nodeVisited(numNodes, false);
+            std::vector<StackEntry> stack(1, StackEntry{ 0, AddNode(tree, rootBox, (UINT)-1) });
+            while (stack.size())
+            {
+                const StackEntry entry = stack.back();
+                stack.pop_back();
+
+                ThrowErrorIfFalse(!nodeVisited[entry.SourceIndex], L"Node is referenced more than once");
+                nodeVisited[entry.SourceIndex] = true;
+
+                const WideNode &sourceNode = pNodes[entry.SourceIndex];
+                ThrowErrorIfFalse(sourceNode.NumChildren > 0 && sourceNode.NumChildren <= Width, L"Invalid number of children");
+                for (UINT i = 0; i < sourceNode.NumChildren; i++)
+                {
+                    const UINT childIndex = AddNode(tree, DecodeChildAABB(sourceNode, i), entry.NodeIndex);
+                    if (sourceNode.IsLeafChild(i))
+                    {
+                        AddLeafPrimitives(tree, childIndex, sourceNode.GetFirstPrimitiveIndex(i), sourceNode.GetPrimitiveCount(i), errorMessage);
+                    }
+                    else
+                    {
+                        const UINT sourceChildIndex = sourceNode.GetChildNodeIndex(i);
+                        ThrowErrorIfFalse(sourceChildIndex != 0 && sourceChildIndex < numNodes, L"Child node index out of range");
+                        stack.push_back(StackEntry{ sourceChildIndex, childIndex });
+                    }
+                }
+            }
+        }
+
+        float ComputeEpoCost(const StatisticsTree &tree, float totalPrimitiveArea)
+        {
+            if (totalPrimitiveArea <= 0.0f)
+            {
+                return 0.0f;
+            }
+
+            // Ancestors of the primitive being processed are stamped with its index,
+            // everything else that overlaps the primitive contributes to the overlap
+            std::vector<UINT> ancestorStamp(tree.Nodes.size(), (UINT)-1);
+            std::vector<std::vector<float3>> polygons;
+            std::vector<float3> scratch0, scratch1;
+            std::vector<UINT> stack;
+            double epo = 0.0;
+            for (UINT primitiveIndex = 0; primitiveIndex < tree.Primitives.size(); primitiveIndex++)
+            {
+                for (UINT nodeIndex = tree.PrimitiveLeaf[primitiveIndex]; nodeIndex != (UINT)-1; nodeIndex = tree.Nodes[nodeIndex].Parent)
+                {
+                    ancestorStamp[nodeIndex] = primitiveIndex;
+                }
+
+                const Primitive &primitive = tree.Primitives[primitiveIndex];
+                const AABB primitiveBox = GetPrimitiveAABB(primitive);
+                GetPrimitivePolygons(primitive, polygons);
+
+                stack.assign(1, 0);
+                while (stack.size())
+                {
+                    const StatisticsNode &node = tree.Nodes[stack.back()];
+                    const UINT nodeIndex = stack.back();
+                    stack.pop_back();
+                    if (!IsOverlapping(node.Box, primitiveBox))
+                    {
+                        continue;
+                    }
+
+                    if (ancestorStamp[nodeIndex] != primitiveIndex)
+                    {
+                        float area = 0.0f;
+                        for (auto &polygon : polygons)
+                        {
+                            area += ComputeClippedArea(polygon, node.Box, scratch0, scratch1);
+                        }
+                        epo += GetNodeCost(node) * area;
+                    }
+                    stack.insert(stack.end(), node.Children.begin(), node.Children.end());
+                }
+            }
+            return (float)(epo / totalPrimitiveArea);
+        }
+    }
+
+    bool ComputeBvhStatistics(
+        AccelerationStructureLayoutType type,
+        _In_ const BYTE *pAccelerationStructureData,
+        _Out_ BvhStatistics &stats,
+        std::wstring &errorMessage)
+    {
+        stats = {};
+        StatisticsTree tree;
+        try
+        {
+            switch (type)
+            {
+            case BVH2:
+                LoadBvh2(pAccelerationStructureData, tree, errorMessage);
+                break;
+            case CompressedBVH4:
+                LoadCompressedWideBvh<4>(pAccelerationStructureData, tree, errorMessage);
+                break;
+            case CompressedBVH8:
+                LoadCompressedWideBvh<8>(pAccelerationStructureData, tree, errorMessage);
+                break;
+            default:
+                ThrowError(L"Unsupported acceleration structure layout");
+            }
+
+            for (UINT leafIndex : tree.PrimitiveLeaf)
+            {
+                ThrowErrorIfFalse(leafIndex != (UINT)-1, L"Primitive isn't reachable from the root");
+            }
+        }
+        catch (bool)
+        {
+            return false;
+        }
+
+        const BVHOffsets &offsets = *(const BVHOffsets *)pAccelerationStructureData;
+        stats.NumPrimitives = (UINT)tree.Primitives.size();
+        stats.BytesPerPrimitive = stats.NumPrimitives ? (float)offsets.totalSize / stats.NumPrimitives : 0.0f;
+        if (tree.Nodes.empty())
+        {
+            return true;
+        }
+
+        const AABB &rootBox = tree.Nodes[0].Box;
+        const float rootArea = ComputeSurfaceArea(rootBox);
+        const float rootVolume = ComputeVolume(rootBox);
+
+        double sah = 0.0;
+        double siblingOverlap = 0.0;
+        for (const StatisticsNode &node : tree.Nodes)
+        {
+            // A root without area means every box is the same point
+            const float relativeArea = rootArea > 0.0f ? ComputeSurfaceArea(node.Box) / rootArea : 1.0f;
+            sah += GetNodeCost(node) * relativeArea;
+
+            if (node.Children.size())
+            {
+                stats.NumInternalNodes++;
+                for (size_t i = 0; i < node.Children.size(); i++)
+                {
+                    for (size_t j = i + 1; j < node.Children.size(); j++)
+                    {
+                        siblingOverlap += ComputeVolume(IntersectAABB(tree.Nodes[node.Children[i]].Box, tree.Nodes[node.Children[j]].Box));
+                    }
+                }
+            }
+            else
+            {
+                stats.NumLeaves++;
+                stats.MaxDepth = std::max(stats.MaxDepth, node.Depth);
+                if (stats.LeafDepthHistogram.size() <= node.Depth)
+                {
+                    stats.LeafDepthHistogram.resize(node.Depth + 1);
+                }
+                stats.LeafDepthHistogram[node.Depth]++;
+                if (stats.LeafSizeHistogram.size() <= node.NumPrimitives)
+                {
+                    stats.LeafSizeHistogram.resize(node.NumPrimitives + 1);
+                }
+                stats.LeafSizeHistogram[node.NumPrimitives]++;
+            }
+        }
+        stats.SahCost = (float)sah;
+        stats.SiblingOverlap = rootVolume > 0.0f ? (float)(siblingOverlap / rootVolume) : 0.0f;
+
+        double totalPrimitiveArea = 0.0;
+        std::vector<std::vector<float3>> polygons;
+        for (const Primitive &primitive : tree.Primitives)
+        {
+            GetPrimitivePolygons(primitive, polygons);
+            for (auto &polygon : polygons)
+            {
+                totalPrimitiveArea += ComputePolygonArea(polygon);
+            }
+        }
+        stats.EpoCost = ComputeEpoCost(tree, (float)totalPrimitiveArea);
+        return true;
+    }
+
+#undef ThrowErrorIfFalse
+#undef ThrowError
+
+    std::wstring BvhStatisticsToString(const BvhStatistics &stats)
+    {
+        std::wstringstream message;
+        message << stats.NumPrimitives << L" primitives, "
+            << stats.NumInternalNodes << L" internal nodes, "
+            << stats.NumLeaves << L" leaves, max depth " << stats.MaxDepth
+            << L", SAH " << stats.SahCost
+            << L", EPO " << stats.EpoCost
+            << L", sibling overlap " << stats.SiblingOverlap
+            << L", " << stats.BytesPerPrimitive << L" bytes/primitive";
+
+        message << L"\n  leaves per depth:";
+        for (size_t depth = 0; depth < stats.LeafDepthHistogram.size(); depth++)
+        {
+            if (stats.LeafDepthHistogram[depth])
+            {
+                message << L" " << depth << L":" << stats.LeafDepthHistogram[depth];
+            }
+        }
+
+        message << L"\n  leaves per primitive count:";
+        for (size_t count = 0; count < stats.LeafSizeHistogram.size(); count++)
+        {
+            if (stats.LeafSizeHistogram[count])
+            {
+                message << L" " << count << L":" << stats.LeafSizeHistogram[count];
+            }
+        }
+        message << L"\n";
+        return message.str();
+    }
+}
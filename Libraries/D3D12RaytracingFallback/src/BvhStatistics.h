@@ -0,0 +1,59 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace FallbackLayer
+{
+    // Quality metrics of a built acceleration structure, read from the same buffer
+    // the traversal shaders use. Areas are relative to the root box so that numbers
+    // can be compared across scenes of different scale.
+    //
+    // Node and primitive costs follow the SAH builders: 1.2 for each node visited
+    // and 1.0 for each primitive tested.
+    struct BvhStatistics
+    {
+        UINT NumInternalNodes;
+        UINT NumLeaves;
+        UINT NumPrimitives;
+        UINT MaxDepth;
+
+        // Expected cost of tracing a random ray through the tree under the surface area heuristic
+        float SahCost;
+
+        // End-point overlap (Aila et al. 2013): cost-weighted area of the primitives that lie
+        // inside a node's box without belonging to its subtree, relative to the total primitive area.
+        // Unlike SahCost this penalizes trees where rays that hit geometry still visit many nodes.
+        float EpoCost;
+
+        // Pairwise intersection volume of the children of each internal node, summed over
+        // the tree and relative to the root volume. 0 when the root has no volume.
+        float SiblingOverlap;
+
+        float BytesPerPrimitive;
+
+        // LeafDepthHistogram[d] is the number of leaves at depth d, the root is at depth 0
+        std::vector<UINT> LeafDepthHistogram;
+
+        // LeafSizeHistogram[n] is the number of leaves that reference n primitives
+        std::vector<UINT> LeafSizeHistogram;
+    };
+
+    // Computes statistics for a bottom- or top-level acceleration structure. Returns false
+    // with errorMessage set if the tree is malformed, for example if an index is out of range
+    // or a node or primitive is reachable more than once.
+    bool ComputeBvhStatistics(
+        AccelerationStructureLayoutType type,
+        _In_ const BYTE *pAccelerationStructureData,
+        _Out_ BvhStatistics &stats,
+        std::wstring &errorMessage);
+
+    std::wstring BvhStatisticsToString(const BvhStatistics &stats);
+}
@@ -0,0 +1,647 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace FallbackLayer
+{
+    bool IsCompressedWideBvhLayout(AccelerationStructureLayoutType type)
+    {
+        return type == CompressedBVH4 || type == CompressedBVH8;
+    }
+
+    UINT GetCompressedWideBvhWidth(AccelerationStructureLayoutType type)
+    {
+        switch (type)
+        {
+        case CompressedBVH4:
+            return 4;
+        case CompressedBVH8:
+            return 8;
+        default:
+            ThrowInternalFailure(E_INVALIDARG);
+            return 0;
+        }
+    }
+
+    UINT GetCompressedWideBvhNodeSize(AccelerationStructureLayoutType type)
+    {
+        switch (type)
+        {
+        case CompressedBVH4:
+            return sizeof(CompressedWideBVHNode<4>);
+        case CompressedBVH8:
+            return sizeof(CompressedWideBVHNode<8>);
+        default:
+            ThrowInternalFailure(E_INVALIDARG);
+            return 0;
+        }
+    }
+
+    UINT GetMaxCompressedWideBvhNodeCount(UINT numPrimitives, UINT width)
+    {
+        assert(width >= 4);
+        UNREFERENCED_PARAMETER(width);
+        if (numPrimitives <= 1)
+        {
+            return 1;
+        }
+
+        // Every wide node consumes (children - 1) of the N - 1 binary internal nodes. Only
+        // subtrees with more than MaxPrimitivesPerLeaf primitives become wide nodes, and those are
+        // opened until they are full or only have leaves left, so every node except the root
+        // has at least 4 children and consumes at least 3 binary internal nodes.
+        return 1 + (numPrimitives - 2) / 3;
+    }
+
+    void GetCompressedWideBvhPrebuildInfo(
+        AccelerationStructureLayoutType type,
+        _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS *pDesc,
+        _Out_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO *pInfo)
+    {
+        if (pDesc->Type != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL)
+        {
+            ThrowFailure(E_INVALIDARG, L"Compressed wide BVHs are only supported for D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL");
+        }
+
+        const UINT numPrimitives = GetTotalPrimitiveCount(*pDesc);
+        const UINT64 numNodes = GetMaxCompressedWideBvhNodeCount(numPrimitives, GetCompressedWideBvhWidth(type));
+        const UINT64 primitiveDataSize = (UINT64)numPrimitives * (SizeOfPrimitive + SizeOfPrimitiveMetaData);
+
+        pInfo->ResultDataMaxSizeInBytes = SizeOfBVHOffsets + numNodes * GetCompressedWideBvhNodeSize(type) + primitiveDataSize;
+
+        const UINT numBvh2Nodes = numPrimitives + GetNumberOfInternalNodes(numPrimitives);
+        pInfo->ScratchDataSizeInBytes = SizeOfBVHOffsets + (UINT64)numBvh2Nodes * SizeOfAABBNode + primitiveDataSize;
+        if (pDesc->Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE)
+        {
+            pInfo->ScratchDataSizeInBytes += numPrimitives * sizeof(UINT); // Saved sorted index buffer
+            pInfo->ScratchDataSizeInBytes += numBvh2Nodes * sizeof(UINT); // Parent indices for nodes in hierarchy
+        }
+        pInfo->UpdateScratchDataSizeInBytes = 0;
+    }
+
+    static AABB GetPrimitiveAABB(const Primitive &primitive)
+    {
+        if (primitive.PrimitiveType == TRIANGLE_TYPE)
+        {
+            const Triangle &tri = primitive.triangle;
+            AABB aabb;
+            aabb.min = min(min(tri.v0, tri.v1), tri.v2);
+            aabb.max = max(max(tri.v0, tri.v1), tri.v2);
+            return aabb;
+        }
+        else
+        {
+            return primitive.aabb;
+        }
+    }
+
+    static AABB CombineAABB(const AABB &a, const AABB &b)
+    {
+        AABB aabb;
+        aabb.min = min(a.min, b.min);
+        aabb.max = max(a.max, b.max);
+        return aabb;
+    }
+
+    static float ComputeBoxSurfaceArea(const AABB &aabb)
+    {
+        float3 dim = aabb.max - aabb.min;
+        return 2.0f * (dim.x * dim.y + dim.x * dim.z + dim.y * dim.z);
+    }
+
+    // Picks the smallest exponent that lets a quantized value of 255 reach the node's max bound.
+    static INT8 ChooseQuantizationExponent(float origin, float maxBound)
+    {
+        const double extent = (double)maxBound - (double)origin;
+        int exponent = MinQuantizationExponent;
+        if (extent > 0.0)
+        {
+            frexp(extent / 255.0, &exponent);
+            exponent = std::max(MinQuantizationExponent, std::min(MaxQuantizationExponent, exponent));
+        }
+
+        while (exponent < MaxQuantizationExponent &&
+            DecodeQuantizedBound(origin, QuantizationExponentToScale(exponent), 255) < maxBound)
+        {
+            exponent++;
+        }
+        return (INT8)exponent;
+    }
+
+    // Rounds the child bounds outwards. The decoded values are checked with the same
+    // expression traversal uses, so float rounding during decode can't shrink the box.
+    template <UINT Width>
+    static void QuantizeChildAABB(CompressedWideBVHNode<Width> &node, UINT childIndex, const AABB &childAABB)
+    {
+        for (UINT axis = 0; axis < 3; axis++)
+        {
+            const float origin = node.Origin[axis];
+            const float scale = QuantizationExponentToScale(node.Exponent[axis]);
+            const double offsetToMin = ((double)childAABB.minArr[axis] - (double)origin) / (double)scale;
+            const double offsetToMax = ((double)childAABB.maxArr[axis] - (double)origin) / (double)scale;
+
+            int quantizedMin = (int)std::max(0.0, std::min(255.0, floor(offsetToMin)));
+            while (quantizedMin > 0 && DecodeQuantizedBound(origin, scale, (BYTE)quantizedMin) > childAABB.minArr[axis])
+            {
+                quantizedMin--;
+            }
+
+            int quantizedMax = (int)std::max(0.0, std::min(255.0, ceil(offsetToMax)));
+            while (quantizedMax < 255 && DecodeQuantizedBound(origin, scale, (BYTE)quantizedMax) < childAABB.maxArr[axis])
+            {
+                quantizedMax++;
+            }
+
+            node.QuantizedMin[axis][childIndex] = (BYTE)quantizedMin;
+            node.QuantizedMax[axis][childIndex] = (BYTE)quantizedMax;
+        }
+    }
+
+    template <UINT Width>
+    static void CollapseBvh2(const BYTE *pBvh2Data, BYTE *pOutputData)
+    {
+        typedef CompressedWideBVHNode<Width> WideNode;
+
+        const BVHOffsets &bvh2Offsets = *(const BVHOffsets *)pBvh2Data;
+        const AABBNode *pBvh2Nodes = (const AABBNode *)(pBvh2Data + bvh2Offsets.offsetToBoxes);
+        const Primitive *pPrimitives = (const Primitive *)(pBvh2Data + bvh2Offsets.offsetToVertices);
+        const PrimitiveMetaData *pMetaData = (const PrimitiveMetaData *)(pBvh2Data + bvh2Offsets.offsetToPrimitiveMetaData);
+        const UINT numPrimitives = (bvh2Offsets.offsetToPrimitiveMetaData - bvh2Offsets.offsetToVertices) / SizeOfPrimitive;
+
+        BVHOffsets &offsets = *(BVHOffsets *)pOutputData;
+        if (numPrimitives == 0)
+        {
+            offsets.offsetToBoxes = offsets.offsetToVertices = offsets.offsetToPrimitiveMetaData = SizeOfBVHOffsets;
+            offsets.totalSize = SizeOfBVHOffsets;
+            return;
+        }
+
+        // Recompute exact bounds from the primitives, the center/half-dimension encoding
+        // of the BVH2 nodes isn't guaranteed to be conservative after rounding.
+        const UINT numBvh2Nodes = numPrimitives + GetNumberOfInternalNodes(numPrimitives);
+        std::vector<AABB> bvh2AABBs(numBvh2Nodes);
+        std::vector<UINT> bvh2PrimitiveCounts(numBvh2Nodes);
+        {
+            std::vector<UINT> preOrder;
+            preOrder.reserve(numBvh2Nodes);
+            std::vector<UINT> stack(1, 0);
+            while (!stack.empty())
+            {
+                UINT nodeIndex = stack.back();
+                stack.pop_back();
+                preOrder.push_back(nodeIndex);
+                if (!pBvh2Nodes[nodeIndex].leaf)
+                {
+                    stack.push_back(pBvh2Nodes[nodeIndex].internalNode.leftNodeIndex);
+                    stack.push_back(pBvh2Nodes[nodeIndex].rightNodeIndex);
+                }
+            }
+
+            for (auto nodeIndex = preOrder.rbegin(); nodeIndex != preOrder.rend(); nodeIndex++)
+            {
+                const AABBNode &node = pBvh2Nodes[*nodeIndex];
+                if (node.leaf)
+                {
+                    bvh2AABBs[*nodeIndex] = GetPrimitiveAABB(pPrimitives[node.leafNode.firstTriangleId]);
+                    bvh2PrimitiveCounts[*nodeIndex] = 1;
+                }
+                else
+                {
+                    bvh2AABBs[*nodeIndex] = CombineAABB(bvh2AABBs[node.internalNode.leftNodeIndex], bvh2AABBs[node.rightNodeIndex]);
+                    bvh2PrimitiveCounts[*nodeIndex] = bvh2PrimitiveCounts[node.internalNode.leftNodeIndex] + bvh2PrimitiveCounts[node.rightNodeIndex];
+                }
+            }
+        }
+
+        // Wide nodes are allocated breadth-first so that each node's internal children
+        // are contiguous. wideNodeSources[i] is the BVH2 node that wide node i was built from.
+        std::vector<WideNode> wideNodes;
+        std::vector<UINT> wideNodeSources(1, 0);
+        std::vector<Primitive> outputPrimitives;
+        std::vector<PrimitiveMetaData> outputMetaData;
+        wideNodes.reserve(GetMaxCompressedWideBvhNodeCount(numPrimitives, Width));
+        wideNodeSources.reserve(wideNodes.capacity());
+        outputPrimitives.reserve(numPrimitives);
+        outputMetaData.reserve(numPrimitives);
+
+        for (size_t wideNodeIndex = 0; wideNodeIndex < wideNodeSources.size(); wideNodeIndex++)
+        {
+            const UINT sourceNodeIndex = wideNodeSources[wideNodeIndex];
+            const AABBNode &sourceNode = pBvh2Nodes[sourceNodeIndex];
+
+            // Greedily open the child with the largest surface area until the node is full.
+            // Internal children that are left with only a few primitives become leaves.
+            UINT children[Width];
+            UINT numChildren = 0;
+            if (sourceNode.leaf)
+            {
+                children[numChildren++] = sourceNodeIndex;
+            }
+            else
+            {
+                children[numChildren++] = sourceNode.internalNode.leftNodeIndex;
+                children[numChildren++] = sourceNode.rightNodeIndex;
+            }
+
+            while (numChildren < Width)
+            {
+                int childToOpen = -1;
+                float largestSurfaceArea = -1.0f;
+                for (UINT i = 0; i < numChildren; i++)
+                {
+                    const float surfaceArea = ComputeBoxSurfaceArea(bvh2AABBs[children[i]]);
+                    if (!pBvh2Nodes[children[i]].leaf && surfaceArea > largestSurfaceArea)
+                    {
+                        childToOpen = (int)i;
+                        largestSurfaceArea = surfaceArea;
+                    }
+                }
+
+                if (childToOpen == -1)
+                {
+                    break;
+                }
+
+                const AABBNode &openedNode = pBvh2Nodes[children[childToOpen]];
+                children[childToOpen] = openedNode.internalNode.leftNodeIndex;
+                children[numChildren++] = openedNode.rightNodeIndex;
+            }
+
+            WideNode node = {};
+            const AABB &nodeAABB = bvh2AABBs[sourceNodeIndex];
+            for (UINT axis = 0; axis < 3; axis++)
+            {
+                node.Origin[axis] = nodeAABB.minArr[axis];
+                node.Exponent[axis] = ChooseQuantizationExponent(nodeAABB.minArr[axis], nodeAABB.maxArr[axis]);
+            }
+            node.NumChildren = (BYTE)numChildren;
+            node.ChildBaseIndex = (UINT)wideNodeSources.size();
+            node.PrimitiveBaseIndex = (UINT)outputPrimitives.size();
+
+            for (UINT i = 0; i < numChildren; i++)
+            {
+                const UINT primitiveCount = bvh2PrimitiveCounts[children[i]];
+                if (primitiveCount <= WideNode::MaxPrimitivesPerLeaf)
+                {
+                    node.ChildMetaData[i] = WideNode::LeafChildFlag |
+                        (BYTE)((primitiveCount - 1) << WideNode::LeafPrimitiveCountShift) |
+                        (BYTE)(outputPrimitives.size() - node.PrimitiveBaseIndex);
+
+                    UINT subtree[WideNode::MaxPrimitivesPerLeaf * 2];
+                    UINT subtreeSize = 0;
+                    subtree[subtreeSize++] = children[i];
+                    while (subtreeSize > 0)
+                    {
+                        const AABBNode &subtreeNode = pBvh2Nodes[subtree[--subtreeSize]];
+                        if (subtreeNode.leaf)
+                        {
+                            outputPrimitives.push_back(pPrimitives[subtreeNode.leafNode.firstTriangleId]);
+                            outputMetaData.push_back(pMetaData[subtreeNode.leafNode.firstTriangleId]);
+                        }
+                        else
+                        {
+                            subtree[subtreeSize++] = subtreeNode.rightNodeIndex;
+                            subtree[subtreeSize++] = subtreeNode.internalNode.leftNodeIndex;
+                        }
+                    }
+                }
+                else
+                {
+                    node.ChildMetaData[i] = (BYTE)(wideNodeSources.size() - node.ChildBaseIndex);
+                    wideNodeSources.push_back(children[i]);
+                }
+                QuantizeChildAABB(node, i, bvh2AABBs[children[i]]);
+            }
+
+            wideNodes.push_back(node);
+        }
+        assert(outputPrimitives.size() == numPrimitives);
+        assert(wideNodes.size() <= GetMaxCompressedWideBvhNodeCount(numPrimitives, Width));
+
+        offsets.offsetToBoxes = SizeOfBVHOffsets;
+        offsets.offsetToVertices = offsets.offsetToBoxes + (UINT)(wideNodes.size() * sizeof(WideNode));
+        offsets.offsetToPrimitiveMetaData = offsets.offsetToVertices + numPrimitives * SizeOfPrimitive;
+        offsets.totalSize = offsets.offsetToPrimitiveMetaData + numPrimitives * SizeOfPrimitiveMetaData;
+
+        memcpy(pOutputData + offsets.offsetToBoxes, wideNodes.data(), wideNodes.size() * sizeof(WideNode));
+        memcpy(pOutputData + offsets.offsetToVertices, outputPrimitives.data(), numPrimitives * SizeOfPrimitive);
+        memcpy(pOutputData + offsets.offsetToPrimitiveMetaData, outputMetaData.data(), numPrimitives * SizeOfPrimitiveMetaData);
+    }
+
+    void CollapseBvh2ToCompressedWideBvh(
+        AccelerationStructureLayoutType type,
+        _In_ const BYTE *pBvh2Data,
+        _Out_ BYTE *pOutputData)
+    {
+        switch (type)
+        {
+        case CompressedBVH4:
+            CollapseBvh2<4>(pBvh2Data, pOutputData);
+            break;
+        case CompressedBVH8:
+            CollapseBvh2<8>(pBvh2Data, pOutputData);
+            break;
+        default:
+            ThrowFailure(E_INVALIDARG, L"CollapseBvh2ToCompressedWideBvh requires a compressed wide BVH layout type");
+        }
+    }
+
+    void BuildCompressedWideBvhOnCpu(
+        AccelerationStructureLayoutType type,
+        _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
+        _Out_ void *pData)
+    {
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+        GetCompressedWideBvhPrebuildInfo(type, &pDesc->Inputs, &prebuildInfo);
+
+        std::unique_ptr<BYTE[]> pBvh2Data(new BYTE[(size_t)prebuildInfo.ScratchDataSizeInBytes]);
+        BuildRaytracingAccelerationStructureOnCpuLbvh(pDesc, pBvh2Data.get());
+        CollapseBvh2ToCompressedWideBvh(type, pBvh2Data.get(), (BYTE *)pData);
+    }
+
+    // Stack of node indices that only touches the heap for unusually deep trees
+    class TraversalStack
+    {
+    public:
+        void Push(UINT value)
+        {
+            if (m_size < ARRAYSIZE(m_stack))
+            {
+                m_stack[m_size] = value;
+            }
+            else
+            {
+                m_overflow.push_back(value);
+            }
+            m_size++;
+        }
+
+        UINT Pop()
+        {
+            m_size--;
+            if (m_size < ARRAYSIZE(m_stack))
+            {
+                return m_stack[m_size];
+            }
+            UINT value = m_overflow.back();
+            m_overflow.pop_back();
+            return value;
+        }
+
+        bool IsEmpty() const { return m_size == 0; }
+
+    private:
+        UINT m_stack[64];
+        std::vector<UINT> m_overflow;
+        UINT m_size = 0;
+    };
+
+    static bool IntersectRayAABB(const AABB &box, const float3 &origin, const float3 &invDirection, float tMin, float tMax, float &tEntry)
+    {
+        const float3 t0 = (box.min - origin) * invDirection;
+        const float3 t1 = (box.max - origin) * invDirection;
+        const float3 tNear = min(t0, t1);
+        const float3 tFar = max(t0, t1);
+        tEntry = std::max(tMin, std::max(tNear.x, std::max(tNear.y, tNear.z)));
+        const float tExit = std::min(tMax, std::min(tFar.x, std::min(tFar.y, tFar.z)));
+        return tEntry <= tExit;
+    }
+
+    // Moller-Trumbore ray/triangle intersection without backface culling
+    static bool IntersectRayTriangle(const Triangle &tri, const CpuRay &ray, float tMax, float &t)
+    {
+        const float3 edge1 = tri.v1 - tri.v0;
+        const float3 edge2 = tri.v2 - tri.v0;
+        const float3 p = cross(ray.Direction, edge2);
+        const float determinant = dot(edge1, p);
+        if (determinant == 0.0f)
+        {
+            return false;
+        }
+
+        const float invDeterminant = 1.0f / determinant;
+        const float3 s = ray.Origin - tri.v0;
+        const float u = dot(s, p) * invDeterminant;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return false;
+        }
+
+        const float3 q = cross(s, edge1);
+        const float v = dot(ray.Direction, q) * invDeterminant;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return false;
+        }
+
+        t = dot(edge2, q) * invDeterminant;
+        return t >= ray.TMin && t < tMax;
+    }
+
+    static bool IntersectPrimitive(const Primitive &primitive, const CpuRay &ray, const float3 &invDirection, float tMax, float &t)
+    {
+        if (primitive.PrimitiveType == TRIANGLE_TYPE)
+        {
+            return IntersectRayTriangle(primitive.triangle, ray, tMax, t);
+        }
+        return IntersectRayAABB(primitive.aabb, ray.Origin, invDirection, ray.TMin, tMax, t) && t < tMax;
+    }
+
+    static float3 GetInverseDirection(const float3 &direction)
+    {
+        return float3{ 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+    }
+
+    static bool TraceRayBvh2(const BYTE *pData, const CpuRay &ray, CpuRayHit &hit, CpuTraversalStats &stats)
+    {
+        const BVHOffsets &offsets = *(const BVHOffsets *)pData;
+        if (offsets.offsetToVertices == offsets.offsetToPrimitiveMetaData)
+        {
+            return false;
+        }
+
+        const AABBNode *pNodes = (const AABBNode *)(pData + offsets.offsetToBoxes);
+        const Primitive *pPrimitives = (const Primitive *)(pData + offsets.offsetToVertices);
+        const PrimitiveMetaData *pMetaData = (const PrimitiveMetaData *)(pData + offsets.offsetToPrimitiveMetaData);
+        const float3 invDirection = GetInverseDirection(ray.Direction);
+
+        UINT hitPrimitive = (UINT)-1;
+        hit.T = ray.TMax;
+
+        // Every node pushed on the stack has already been fetched and its box tested
+        TraversalStack stack;
+        AABB box;
+        float tEntry;
+        DecompressAABB(box, pNodes[0]);
+        stats.NodesVisited++;
+        if (IntersectRayAABB(box, ray.Origin, invDirection, ray.TMin, hit.T, tEntry))
+        {
+            stack.Push(0);
+        }
+
+        while (!stack.IsEmpty())
+        {
+            const AABBNode &node = pNodes[stack.Pop()];
+            if (node.leaf)
+            {
+                float t;
+                stats.PrimitivesTested++;
+                if (IntersectPrimitive(pPrimitives[node.leafNode.firstTriangleId], ray, invDirection, hit.T, t))
+                {
+                    hit.T = t;
+                    hitPrimitive = node.leafNode.firstTriangleId;
+                }
+                continue;
+            }
+
+            const UINT childIndices[2] = { node.internalNode.leftNodeIndex, node.rightNodeIndex };
+            float childEntry[2];
+            bool childHit[2];
+            for (UINT i = 0; i < 2; i++)
+            {
+                DecompressAABB(box, pNodes[childIndices[i]]);
+                stats.NodesVisited++;
+                childHit[i] = IntersectRayAABB(box, ray.Origin, invDirection, ray.TMin, hit.T, childEntry[i]);
+            }
+
+            // Push the far child first so the near child is traversed next
+            const UINT nearChild = childEntry[0] <= childEntry[1] ? 0 : 1;
+            if (childHit[1 - nearChild])
+            {
+                stack.Push(childIndices[1 - nearChild]);
+            }
+            if (childHit[nearChild])
+            {
+                stack.Push(childIndices[nearChild]);
+            }
+        }
+
+        if (hitPrimitive == (UINT)-1)
+        {
+            return false;
+        }
+        hit.MetaData = pMetaData[hitPrimitive];
+        return true;
+    }
+
+    template <UINT Width>
+    static bool TraceRayCompressedWideBvh(const BYTE *pData, const CpuRay &ray, CpuRayHit &hit, CpuTraversalStats &stats)
+    {
+        typedef CompressedWideBVHNode<Width> WideNode;
+
+        const BVHOffsets &offsets = *(const BVHOffsets *)pData;
+        if (offsets.offsetToVertices == offsets.offsetToPrimitiveMetaData)
+        {
+            return false;
+        }
+
+        const WideNode *pNodes = (const WideNode *)(pData + offsets.offsetToBoxes);
+        const Primitive *pPrimitives = (const Primitive *)(pData + offsets.offsetToVertices);
+        const PrimitiveMetaData *pMetaData = (const PrimitiveMetaData *)(pData + offsets.offsetToPrimitiveMetaData);
+        const float3 invDirection = GetInverseDirection(ray.Direction);
+
+        UINT hitPrimitive = (UINT)-1;
+        hit.T = ray.TMax;
+
+        TraversalStack stack;
+        stack.Push(0);
+        while (!stack.IsEmpty())
+        {
+            const WideNode &node = pNodes[stack.Pop()];
+            stats.NodesVisited++;
+
+            // Leaves are intersected right away, internal children are pushed far to near
+            UINT hitChildren[Width];
+            float hitChildEntry[Width];
+            UINT numHitChildren = 0;
+            for (UINT i = 0; i < node.NumChildren; i++)
+            {
+                float tEntry;
+                if (!IntersectRayAABB(DecodeChildAABB(node, i), ray.Origin, invDirection, ray.TMin, hit.T, tEntry))
+                {
+                    continue;
+                }
+
+                if (node.IsLeafChild(i))
+                {
+                    const UINT firstPrimitive = node.GetFirstPrimitiveIndex(i);
+                    for (UINT primitiveIndex = firstPrimitive; primitiveIndex < firstPrimitive + node.GetPrimitiveCount(i); primitiveIndex++)
+                    {
+                        float t;
+                        stats.PrimitivesTested++;
+                        if (IntersectPrimitive(pPrimitives[primitiveIndex], ray, invDirection, hit.T, t))
+                        {
+                            hit.T = t;
+                            hitPrimitive = primitiveIndex;
+                        }
+                    }
+                }
+                else
+                {
+                    UINT insertIndex = numHitChildren++;
+                    while (insertIndex > 0 && hitChildEntry[insertIndex - 1] < tEntry)
+                    {
+                        hitChildren[insertIndex] = hitChildren[insertIndex - 1];
+                        hitChildEntry[insertIndex] = hitChildEntry[insertIndex - 1];
+                        insertIndex--;
+                    }
+                    hitChildren[insertIndex] = node.GetChildNodeIndex(i);
+                    hitChildEntry[insertIndex] = tEntry;
+                }
+            }
+
+            for (UINT i = 0; i < numHitChildren; i++)
+            {
+                stack.Push(hitChildren[i]);
+            }
+        }
+
+        if (hitPrimitive == (UINT)-1)
+        {
+            return false;
+        }
+        hit.MetaData = pMetaData[hitPrimitive];
+        return true;
+    }
+
+    bool TraceRayOnCpu(
+        AccelerationStructureLayoutType type,
+        _In_ const BYTE *pAccelerationStructureData,
+        const CpuRay &ray,
+        _Out_ CpuRayHit &hit,
+        _Inout_opt_ CpuTraversalStats *pStats)
+    {
+        CpuTraversalStats stats = {};
+        bool bHit;
+        switch (type)
+        {
+        case BVH2:
+            bHit = TraceRayBvh2(pAccelerationStructureData, ray, hit, stats);
+            break;
+        case CompressedBVH4:
+            bHit = TraceRayCompressedWideBvh<4>(pAccelerationStructureData, ray, hit, stats);
+            break;
+        case CompressedBVH8:
+            bHit = TraceRayCompressedWideBvh<8>(pAccelerationStructureData, ray, hit, stats);
+            break;
+        default:
+            ThrowInternalFailure(E_INVALIDARG);
+            return false;
+        }
+
+        if (pStats)
+        {
+            pStats->NodesVisited += stats.NodesVisited;
+            pStats->PrimitivesTested += stats.PrimitivesTested;
+        }
+        return bHit;
+    }
+}
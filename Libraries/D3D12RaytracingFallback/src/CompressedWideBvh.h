@@ -0,0 +1,142 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace FallbackLayer
+{
+    // Bottom-level acceleration structure layout for the CompressedBVH4/CompressedBVH8
+    // layout types. The buffer starts with the same BVHOffsets header as BVH2, followed
+    // by the wide nodes, the primitives, and the primitive metadata.
+    //
+    // Each node stores the bounds of up to Width children as 8-bit offsets from the node's
+    // origin, scaled by a per-axis power of two. Child bounds are rounded outwards, so a
+    // decoded child box always contains everything below that child. The internal children
+    // of a node are stored contiguously starting at ChildBaseIndex, and its leaf children
+    // reference up to MaxPrimitivesPerLeaf contiguous primitives starting at PrimitiveBaseIndex.
+    template <UINT Width>
+    struct CompressedWideBVHNode
+    {
+        static const UINT MaxPrimitivesPerLeaf = 3;
+        static const BYTE LeafChildFlag = 0x80;
+        static const UINT LeafPrimitiveCountShift = 5;
+        static const BYTE ChildOffsetMask = 0x1f;
+        static_assert(Width * MaxPrimitivesPerLeaf <= ChildOffsetMask + 1u, "Leaf offsets don't fit in ChildOffsetMask");
+
+        float Origin[3];
+        INT8 Exponent[3];
+        BYTE NumChildren;
+        UINT ChildBaseIndex;
+        UINT PrimitiveBaseIndex;
+
+        // Leaves: LeafChildFlag | (primitive count - 1) << LeafPrimitiveCountShift | offset from PrimitiveBaseIndex
+        // Internal nodes: offset from ChildBaseIndex
+        BYTE ChildMetaData[Width];
+        BYTE QuantizedMin[3][Width];
+        BYTE QuantizedMax[3][Width];
+
+        bool IsLeafChild(UINT childIndex) const { return (ChildMetaData[childIndex] & LeafChildFlag) != 0; }
+        UINT GetChildNodeIndex(UINT childIndex) const { return ChildBaseIndex + (ChildMetaData[childIndex] & ChildOffsetMask); }
+        UINT GetFirstPrimitiveIndex(UINT childIndex) const { return PrimitiveBaseIndex + (ChildMetaData[childIndex] & ChildOffsetMask); }
+        UINT GetPrimitiveCount(UINT childIndex) const { return ((ChildMetaData[childIndex] & ~LeafChildFlag) >> LeafPrimitiveCountShift) + 1; }
+    };
+    static_assert(sizeof(CompressedWideBVHNode<4>) == 52, "Unexpected size for CompressedWideBVHNode<4>");
+    static_assert(sizeof(CompressedWideBVHNode<8>) == 80, "Unexpected size for CompressedWideBVHNode<8>");
+
+    // Exponents are clamped to the normal float range so that the scale can be built
+    // directly from its bit pattern.
+    static const int MinQuantizationExponent = -126;
+    static const int MaxQuantizationExponent = 127;
+
+    inline float QuantizationExponentToScale(int exponent)
+    {
+        const UINT bits = (UINT)(exponent + 127) << 23;
+        float scale;
+        memcpy(&scale, &bits, sizeof(scale));
+        return scale;
+    }
+
+    // Traversal must decode bounds with exactly this expression for the
+    // conservative rounding done by the collapse stage to hold.
+    inline float DecodeQuantizedBound(float origin, float scale, BYTE quantizedValue)
+    {
+        return origin + (float)quantizedValue * scale;
+    }
+
+    template <UINT Width>
+    AABB DecodeChildAABB(const CompressedWideBVHNode<Width> &node, UINT childIndex)
+    {
+        AABB box;
+        for (UINT axis = 0; axis < 3; axis++)
+        {
+            const float scale = QuantizationExponentToScale(node.Exponent[axis]);
+            box.minArr[axis] = DecodeQuantizedBound(node.Origin[axis], scale, node.QuantizedMin[axis][childIndex]);
+            box.maxArr[axis] = DecodeQuantizedBound(node.Origin[axis], scale, node.QuantizedMax[axis][childIndex]);
+        }
+        return box;
+    }
+
+    bool IsCompressedWideBvhLayout(AccelerationStructureLayoutType type);
+    UINT GetCompressedWideBvhWidth(AccelerationStructureLayoutType type);
+    UINT GetCompressedWideBvhNodeSize(AccelerationStructureLayoutType type);
+
+    // Upper bound on the number of wide nodes produced from a BVH2 with numPrimitives leaves.
+    UINT GetMaxCompressedWideBvhNodeCount(UINT numPrimitives, UINT width);
+
+    // Fills out the sizes for a bottom-level build that is collapsed into a compressed wide BVH.
+    // The scratch size covers the intermediate BVH2 that the collapse reads from.
+    void GetCompressedWideBvhPrebuildInfo(
+        AccelerationStructureLayoutType type,
+        _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS *pDesc,
+        _Out_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO *pInfo);
+
+    // Converts a bottom-level BVH2 into a compressed wide BVH. pOutputData must hold at
+    // least the ResultDataMaxSizeInBytes reported by GetCompressedWideBvhPrebuildInfo.
+    // Update data in the BVH2 is not carried over, compressed wide BVHs can only be rebuilt.
+    void CollapseBvh2ToCompressedWideBvh(
+        AccelerationStructureLayoutType type,
+        _In_ const BYTE *pBvh2Data,
+        _Out_ BYTE *pOutputData);
+
+    // Builds a BVH2 with the CPU LBVH builder and collapses it into a compressed wide BVH.
+    void BuildCompressedWideBvhOnCpu(
+        AccelerationStructureLayoutType type,
+        _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
+        _Out_ void *pData);
+
+    struct CpuRay
+    {
+        float3 Origin;
+        float3 Direction;
+        float TMin;
+        float TMax;
+    };
+
+    struct CpuRayHit
+    {
+        float T;
+        PrimitiveMetaData MetaData;
+    };
+
+    struct CpuTraversalStats
+    {
+        UINT64 NodesVisited;
+        UINT64 PrimitivesTested;
+    };
+
+    // Closest hit traversal of a bottom-level acceleration structure on the CPU. Procedural
+    // primitives are reported as hit where the ray enters their AABB. Returns false on a miss.
+    bool TraceRayOnCpu(
+        AccelerationStructureLayoutType type,
+        _In_ const BYTE *pAccelerationStructureData,
+        const CpuRay &ray,
+        _Out_ CpuRayHit &hit,
+        _Inout_opt_ CpuTraversalStats *pStats = nullptr);
+}
@@ -0,0 +1,237 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace FallbackLayer
+{
+    namespace
+    {
+        float GetTriangleDistance(const Triangle &a, const Triangle &b)
+        {
+            float distance = 0.0f;
+            for (UINT i = 0; i < ARRAYSIZE(a.v); i++)
+            {
+                distance = std::max(distance, std::abs(a.v[i].x - b.v[i].x));
+                distance = std::max(distance, std::abs(a.v[i].y - b.v[i].y));
+                distance = std::max(distance, std::abs(a.v[i].z - b.v[i].z));
+            }
+            return distance;
+        }
+
+        // No epsilon here, quantized bounds are required to be conservative
+        bool IsPointInAABB(const AABB &box, const float3 &point)
+        {
+            return point.x >= box.min.x && point.y >= box.min.y && point.z >= box.min.z &&
+                point.x <= box.max.x && point.y <= box.max.y && point.z <= box.max.z;
+        }
+
+        AABB IntersectAABB(const AABB &a, const AABB &b)
+        {
+            AABB box;
+            box.min = max(a.min, b.min);
+            box.max = min(a.max, b.max);
+            return box;
+        }
+
+        float3 TransformVertex(const float *pVertex, _In_reads_(12) const float *transform)
+        {
+            return float3{
+                pVertex[0] * transform[0] + pVertex[1] * transform[1] + pVertex[2] * transform[2] + transform[3],
+                pVertex[0] * transform[4] + pVertex[1] * transform[5] + pVertex[2] * transform[6] + transform[7],
+                pVertex[0] * transform[8] + pVertex[1] * transform[9] + pVertex[2] * transform[10] + transform[11] };
+        }
+
+        UINT ReadIndex(const void *pIndexBuffer, UINT readIndex, DXGI_FORMAT format)
+        {
+            switch (format)
+            {
+            case DXGI_FORMAT_R32_UINT:
+                return ((const UINT32 *)pIndexBuffer)[readIndex];
+            case DXGI_FORMAT_R16_UINT:
+                return ((const UINT16 *)pIndexBuffer)[readIndex];
+            default:
+                return readIndex;
+            }
+        }
+    }
+
+    template <UINT Width>
+    bool CompressedWideBvhValidator::VerifyWideBvhOutput(
+        std::vector<Triangle> &expectedTriangles,
+        const BYTE *pOutputCpuData,
+        std::wstring &errorMessage)
+    {
+#define ThrowError(msg) errorMessage = msg; throw false;
+#define ThrowErrorIfFalse(exp, msg) if(!(exp)) {ThrowError(msg);}
+
+        typedef CompressedWideBVHNode<Width> WideNode;
+
+        try
+        {
+            // Walk the tree while tracking the intersection of all ancestor boxes, every
+            // primitive has to be reached exactly once and lie inside that intersection.
+            const BVHOffsets &offsets = *(const BVHOffsets *)pOutputCpuData;
+            const WideNode *pNodes = (const WideNode *)(pOutputCpuData + offsets.offsetToBoxes);
+            const Primitive *pPrimitives = (const Primitive *)(pOutputCpuData + offsets.offsetToVertices);
+            const UINT numNodes = (offsets.offsetToVertices - offsets.offsetToBoxes) / sizeof(WideNode);
+            const UINT numPrimitives = (offsets.offsetToPrimitiveMetaData - offsets.offsetToVertices) / SizeOfPrimitive;
+
+            ThrowErrorIfFalse(numPrimitives == expectedTriangles.size(), L"Number of primitives doesn't match the number of expected triangles");
+            if (numPrimitives == 0)
+            {
+                return true;
+            }
+            ThrowErrorIfFalse(numNodes > 0, L"Missing root node");
+
+            AABB sceneBounds = {};
+            for (auto &triangle : expectedTriangles)
+            {
+                for (UINT v = 0; v < ARRAYSIZE(triangle.v); v++)
+                {
+                    sceneBounds.min = min(sceneBounds.min, triangle.v[v]);
+                    sceneBounds.max = max(sceneBounds.max, triangle.v[v]);
+                }
+            }
+            const float vertexEpsilon = GetValidationEpsilon(sceneBounds);
+
+            struct StackEntry
+            {
+                UINT NodeIndex;
+                AABB Bounds;
+            };
+
+            AABB everything;
+            everything.min = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            everything.max = { FLT_MAX, FLT_MAX, FLT_MAX };
+
+            std::vector<bool> nodeVisited(numNodes, false);
+            std::vector<bool> primitiveFound(numPrimitives, false);
+            std::vector<StackEntry> stack(1, StackEntry{ 0, everything });
+            while (stack.size())
+            {
+                StackEntry entry = stack.back();
+                stack.pop_back();
+
+                ThrowErrorIfFalse(!nodeVisited[entry.NodeIndex], L"Node is referenced more than once");
+                nodeVisited[entry.NodeIndex] = true;
+
+                const WideNode &node = pNodes[entry.NodeIndex];
+                ThrowErrorIfFalse(node.NumChildren > 0 && node.NumChildren <= Width, L"Invalid number of children");
+
+                for (UINT i = 0; i < node.NumChildren; i++)
+                {
+                    const AABB childBounds = IntersectAABB(entry.Bounds, DecodeChildAABB(node, i));
+                    if (node.IsLeafChild(i))
+                    {
+                        const UINT firstPrimitive = node.GetFirstPrimitiveIndex(i);
+                        for (UINT primitiveIndex = firstPrimitive; primitiveIndex < firstPrimitive + node.GetPrimitiveCount(i); primitiveIndex++)
+                        {
+                            ThrowErrorIfFalse(primitiveIndex < numPrimitives, L"Primitive index out of range");
+                            ThrowErrorIfFalse(!primitiveFound[primitiveIndex], L"Primitive is referenced more than once");
+                            primitiveFound[primitiveIndex] = true;
+
+                            const Primitive &primitive = pPrimitives[primitiveIndex];
+                            ThrowErrorIfFalse(primitive.PrimitiveType == TRIANGLE_TYPE, L"Unexpected procedural primitive");
+                            for (UINT v = 0; v < ARRAYSIZE(primitive.triangle.v); v++)
+                            {
+                                ThrowErrorIfFalse(IsPointInAABB(childBounds, primitive.triangle.v[v]), L"Quantized AABB doesn't contain its triangle");
+                            }
+                        }
+                    }
+                    else
+                    {
+                        const UINT childIndex = node.GetChildNodeIndex(i);
+                        ThrowErrorIfFalse(childIndex != 0 && childIndex < numNodes, L"Child node index out of range");
+                        stack.push_back(StackEntry{ childIndex, childBounds });
+                    }
+                }
+            }
+
+            for (UINT primitiveIndex = 0; primitiveIndex < numPrimitives; primitiveIndex++)
+            {
+                ThrowErrorIfFalse(primitiveFound[primitiveIndex], L"Primitive isn't reachable from the root");
+
+                // Match against the closest expected triangle so near-duplicates pair up correctly
+                size_t closestTriangle = 0;
+                float closestDistance = FLT_MAX;
+                for (size_t j = 0; j < expectedTriangles.size(); j++)
+                {
+                    const float distance = GetTriangleDistance(expectedTriangles[j], pPrimitives[primitiveIndex].triangle);
+                    if (distance < closestDistance)
+                    {
+                        closestTriangle = j;
+                        closestDistance = distance;
+                    }
+                }
+                ThrowErrorIfFalse(closestDistance < vertexEpsilon, L"Didn't find a leaf node for one or more of the expected leaves");
+                expectedTriangles[closestTriangle] = expectedTriangles.back();
+                expectedTriangles.pop_back();
+            }
+        }
+        catch (bool)
+        {
+            return false;
+        }
+        return true;
+
+#undef ThrowErrorIfFalse
+#undef ThrowError
+    }
+
+    bool CompressedWideBvhValidator::VerifyBottomLevelOutput(
+        CpuGeometryDescriptor *pCpuGeometryDescriptors,
+        UINT geometryCount,
+        const BYTE *pOutputCpuData, std::wstring &errorMessage)
+    {
+        std::vector<Triangle> expectedTriangles;
+        for (UINT geometryIndex = 0; geometryIndex < geometryCount; geometryIndex++)
+        {
+            const CpuGeometryDescriptor &geometryDescriptor = pCpuGeometryDescriptors[geometryIndex];
+            const UINT vertexCount = geometryDescriptor.m_pIndexBuffer ? geometryDescriptor.m_numIndicies : geometryDescriptor.m_numVerticies;
+            for (UINT i = 0; i + 3 <= vertexCount; i += 3)
+            {
+                Triangle triangle;
+                for (UINT v = 0; v < 3; v++)
+                {
+                    const UINT index = ReadIndex(geometryDescriptor.m_pIndexBuffer, i + v, geometryDescriptor.m_indexBufferFormat);
+                    triangle.v[v] = TransformVertex(&geometryDescriptor.m_pVertexData[index * 3], geometryDescriptor.transform.data());
+                }
+                expectedTriangles.push_back(triangle);
+            }
+        }
+
+        switch (m_layoutType)
+        {
+        case CompressedBVH4:
+            return VerifyWideBvhOutput<4>(expectedTriangles, pOutputCpuData, errorMessage);
+        case CompressedBVH8:
+            return VerifyWideBvhOutput<8>(expectedTriangles, pOutputCpuData, errorMessage);
+        default:
+            ThrowInternalFailure(E_INVALIDARG);
+            return false;
+        }
+    }
+
+    bool CompressedWideBvhValidator::VerifyTopLevelOutput(
+        const AABB *pReferenceBoxes,
+        float **ppInstanceTransforms,
+        UINT numBoxes,
+        const BYTE *pOutputCpuData,
+        std::wstring &errorMessage)
+    {
+        UNREFERENCED_PARAMETER(pReferenceBoxes);
+        UNREFERENCED_PARAMETER(ppInstanceTransforms);
+        UNREFERENCED_PARAMETER(numBoxes);
+        UNREFERENCED_PARAMETER(pOutputCpuData);
+        errorMessage = L"Compressed wide BVHs are only supported for bottom-level acceleration structures";
+        return false;
+    }
+}
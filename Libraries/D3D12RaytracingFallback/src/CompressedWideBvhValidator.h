@@ -0,0 +1,41 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+namespace FallbackLayer
+{
+    class CompressedWideBvhValidator : public IAccelerationStructureValidator
+    {
+    public:
+        CompressedWideBvhValidator(AccelerationStructureLayoutType layoutType) : m_layoutType(layoutType) {}
+
+        virtual bool VerifyBottomLevelOutput(
+            CpuGeometryDescriptor *pCpuGeometryDescriptors,
+            UINT geometryCount,
+            const BYTE *pOutputCpuData, std::wstring &errorMessage);
+
+        // Compressed wide BVHs are only built for bottom-level acceleration structures
+        virtual bool VerifyTopLevelOutput(
+            const AABB *pReferenceBoxes,
+            float **ppInstanceTransforms,
+            UINT numBoxes,
+            const BYTE *pOutputCpuData,
+            std::wstring &errorMessage);
+
+    private:
+        template <UINT Width>
+        bool VerifyWideBvhOutput(
+            std::vector<Triangle> &expectedTriangles,
+            const BYTE *pOutputCpuData,
+            std::wstring &errorMessage);
+
+        AccelerationStructureLayoutType m_layoutType;
+    };
+}
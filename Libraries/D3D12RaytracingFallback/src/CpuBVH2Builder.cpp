@@ -9,6 +9,7 @@
 //
 //*********************************************************
 #include "pch.h"
+#include "TreeletReorderBindings.h"
 
 namespace FallbackLayer
 {
@@ -117,15 +118,10 @@ namespace FallbackLayer
     }
 
     static
-        UINT32 BuildBVHAddNode(
-            BVH& bvh,
-            const AABB& box,
-            UINT32 maxDimension)
+        void PackNodeAABB(
+            AABBNode& packedBox,
+            const AABB& box)
     {
-        UNREFERENCED_PARAMETER(maxDimension);
-        assert(maxDimension < 3);
-        const UINT32 nodeIndex = (UINT32)bvh.m_nodes.size();
-
         float cX = (box.max.x + box.min.x) * 0.5f;
         float cY = (box.max.y + box.min.y) * 0.5f;
         float cZ = (box.max.z + box.min.z) * 0.5f;
@@ -137,13 +133,26 @@ namespace FallbackLayer
         float dY = max(box.max.y - cY, cY - box.min.y);
         float dZ = max(box.max.z - cZ, cZ - box.min.z);
 
-        AABBNode packedBox;
         packedBox.center[0] = cX;
         packedBox.center[1] = cY;
         packedBox.center[2] = cZ;
         packedBox.halfDim[0] = dX;
         packedBox.halfDim[1] = dY;
         packedBox.halfDim[2] = dZ;
+    }
+
+    static
+        UINT32 BuildBVHAddNode(
+            BVH& bvh,
+            const AABB& box,
+            UINT32 maxDimension)
+    {
+        UNREFERENCED_PARAMETER(maxDimension);
+        assert(maxDimension < 3);
+        const UINT32 nodeIndex = (UINT32)bvh.m_nodes.size();
+
+        AABBNode packedBox;
+        PackNodeAABB(packedBox, box);
         packedBox.nodeAllBits = 0;
 
         bvh.m_nodes.push_back(packedBox);
@@ -663,6 +672,376 @@ namespace FallbackLayer
             XMStoreFloat3((XMFLOAT3*)pOutputTriangle + 2, V2);
         }
     }
+
+    //
+    // Treelet restructuring post-pass
+    //
+    // Karras and Aila 2013, "Fast Parallel Construction of High-Quality Bounding Volume Hierarchies".
+    // Unlike TreeletReorder.hlsl, a treelet is costed with the full SAH cost of the subtrees below
+    // its leaves and is only rewritten if the new topology is cheaper, so a pass never makes
+    // the tree worse. Leaves always hold MAX_TRIS_IN_LEAF primitives in this layout, so the
+    // dynamic program doesn't consider collapsing a subtree into a leaf.
+    //
+
+    static const float CostOfRayBoxIntersection = 1.2f;
+    static const float CostOfRayTriangleIntersection = 1.0f;
+    static const UINT TreeletMinLeavesPerThread = 4096;
+
+    struct TreeletOptimizationState
+    {
+        TreeletOptimizationState(AABBNode *pNodes, UINT numNodes) :
+            pNodes(pNodes),
+            ParentIndices(numNodes, (UINT)-1),
+            AABBs(numNodes),
+            SubtreeCosts(numNodes),
+            NumPrimitives(numNodes),
+            ChildrenProcessed(new std::atomic<UINT>[numNodes])
+        {}
+
+        AABBNode *pNodes;
+        std::vector<UINT> PreOrder;
+        std::vector<UINT> LeafIndices;
+        std::vector<UINT> ParentIndices;
+        std::vector<AABB> AABBs;
+
+        // Sum of cost * surface area over the subtree, not normalized to the root
+        std::vector<float> SubtreeCosts;
+        std::vector<UINT> NumPrimitives;
+        std::unique_ptr<std::atomic<UINT>[]> ChildrenProcessed;
+    };
+
+    static
+        void RefitTreeletNode(
+            TreeletOptimizationState& state,
+            UINT32 nodeIndex)
+    {
+        const AABBNode& node = state.pNodes[nodeIndex];
+        const UINT32 leftNodeIndex = node.internalNode.leftNodeIndex;
+        const UINT32 rightNodeIndex = node.rightNodeIndex;
+
+        AABB box = state.AABBs[leftNodeIndex];
+        AddExtentToBox(box, state.AABBs[rightNodeIndex]);
+
+        state.AABBs[nodeIndex] = box;
+        state.NumPrimitives[nodeIndex] = state.NumPrimitives[leftNodeIndex] + state.NumPrimitives[rightNodeIndex];
+        state.SubtreeCosts[nodeIndex] = CostOfRayBoxIntersection * ComputeBoxSurfaceArea(box) +
+            state.SubtreeCosts[leftNodeIndex] + state.SubtreeCosts[rightNodeIndex];
+    }
+
+    static
+        void LoadTreeletOptimizationState(
+            TreeletOptimizationState& state,
+            UINT32 numNodes)
+    {
+        std::vector<bool> visited(numNodes);
+        std::vector<UINT32> stack(1, 0);
+        while (!stack.empty())
+        {
+            const UINT32 nodeIndex = stack.back();
+            stack.pop_back();
+            if (visited[nodeIndex])
+            {
+                ThrowFailure(E_INVALIDARG, L"Acceleration structure has an out of range or shared node");
+            }
+            visited[nodeIndex] = true;
+            state.PreOrder.push_back(nodeIndex);
+
+            const AABBNode& node = state.pNodes[nodeIndex];
+            if (node.leaf)
+            {
+                state.LeafIndices.push_back(nodeIndex);
+            }
+            else
+            {
+                const UINT32 leftNodeIndex = node.internalNode.leftNodeIndex;
+                const UINT32 rightNodeIndex = node.rightNodeIndex;
+                if (leftNodeIndex >= numNodes || rightNodeIndex >= numNodes)
+                {
+                    ThrowFailure(E_INVALIDARG, L"Acceleration structure has an out of range or shared node");
+                }
+                state.ParentIndices[leftNodeIndex] = nodeIndex;
+                state.ParentIndices[rightNodeIndex] = nodeIndex;
+                stack.push_back(rightNodeIndex);
+                stack.push_back(leftNodeIndex);
+            }
+        }
+
+        for (auto nodeIndex = state.PreOrder.rbegin(); nodeIndex != state.PreOrder.rend(); nodeIndex++)
+        {
+            if (state.pNodes[*nodeIndex].leaf)
+            {
+                DecompressAABB(state.AABBs[*nodeIndex], state.pNodes[*nodeIndex]);
+                state.NumPrimitives[*nodeIndex] = MAX_TRIS_IN_LEAF;
+                state.SubtreeCosts[*nodeIndex] = CostOfRayTriangleIntersection * MAX_TRIS_IN_LEAF * ComputeBoxSurfaceArea(state.AABBs[*nodeIndex]);
+            }
+            else
+            {
+                RefitTreeletNode(state, *nodeIndex);
+            }
+        }
+    }
+
+    //
+    // Returns true if the treelet below nodeIndex was rewritten
+    //
+
+    static
+        bool RestructureTreelet(
+            TreeletOptimizationState& state,
+            UINT32 nodeIndex)
+    {
+        const UINT NumInternalTreeletNodes = FullTreeletSize - 1;
+        const UINT NumTreeletSubsets = 1 << FullTreeletSize;
+        const UINT FullSubsetMask = NumTreeletSubsets - 1;
+
+        AABBNode* pNodes = state.pNodes;
+
+        // Form the treelet by repeatedly expanding the internal node with the largest surface area
+        UINT32 treeletLeaves[FullTreeletSize];
+        UINT32 internalNodes[NumInternalTreeletNodes];
+        internalNodes[0] = nodeIndex;
+        treeletLeaves[0] = pNodes[nodeIndex].internalNode.leftNodeIndex;
+        treeletLeaves[1] = pNodes[nodeIndex].rightNodeIndex;
+
+        for (UINT treeletSize = 2; treeletSize < FullTreeletSize; ++treeletSize)
+        {
+            float largestSurfaceArea = -1.0f;
+            UINT indexToExpand = FullTreeletSize;
+            for (UINT i = 0; i < treeletSize; ++i)
+            {
+                const float surfaceArea = ComputeBoxSurfaceArea(state.AABBs[treeletLeaves[i]]);
+                if (!pNodes[treeletLeaves[i]].leaf && surfaceArea > largestSurfaceArea)
+                {
+                    largestSurfaceArea = surfaceArea;
+                    indexToExpand = i;
+                }
+            }
+
+            if (indexToExpand == FullTreeletSize)
+            {
+                return false;
+            }
+
+            const UINT32 expandedNodeIndex = treeletLeaves[indexToExpand];
+            internalNodes[treeletSize - 1] = expandedNodeIndex;
+            treeletLeaves[indexToExpand] = pNodes[expandedNodeIndex].internalNode.leftNodeIndex;
+            treeletLeaves[treeletSize] = pNodes[expandedNodeIndex].rightNodeIndex;
+        }
+
+        // Optimal cost and partition of every subset of the treelet leaves, indexed by bitmask.
+        // Every proper subset of a bitmask is numerically smaller than it, so visiting the
+        // bitmasks in increasing order always has the costs of both partitions ready.
+        float surfaceAreas[NumTreeletSubsets];
+        float optimalCost[NumTreeletSubsets];
+        UINT optimalPartition[NumTreeletSubsets];
+        for (UINT subset = 1; subset < NumTreeletSubsets; ++subset)
+        {
+            AABB box;
+            InitBoxToInverseMax(box);
+            for (UINT i = 0; i < FullTreeletSize; ++i)
+            {
+                if (subset & (1 << i))
+                {
+                    AddExtentToBox(box, state.AABBs[treeletLeaves[i]]);
+                }
+            }
+            surfaceAreas[subset] = ComputeBoxSurfaceArea(box);
+        }
+
+        for (UINT i = 0; i < FullTreeletSize; ++i)
+        {
+            optimalCost[1 << i] = state.SubtreeCosts[treeletLeaves[i]];
+        }
+
+        for (UINT subset = 1; subset < NumTreeletSubsets; ++subset)
+        {
+            if (__popcnt(subset) < 2)
+            {
+                continue;
+            }
+
+            float lowestCost = FLT_MAX;
+            UINT bestPartition = 0;
+
+            const UINT delta = (subset - 1) & subset;
+            UINT partition = (0u - delta) & subset;
+            do
+            {
+                const float cost = optimalCost[partition] + optimalCost[subset ^ partition];
+                if (cost < lowestCost)
+                {
+                    lowestCost = cost;
+                    bestPartition = partition;
+                }
+                partition = (partition - delta) & subset;
+            } while (partition != 0);
+
+            optimalCost[subset] = CostOfRayBoxIntersection * surfaceAreas[subset] + lowestCost;
+            optimalPartition[subset] = bestPartition;
+        }
+
+        // The current topology is one of the candidates, ignore gains that are only float noise
+        static const float MinRelativeImprovement = 1e-5f;
+        if (optimalCost[FullSubsetMask] >= state.SubtreeCosts[nodeIndex] * (1.0f - MinRelativeImprovement))
+        {
+            return false;
+        }
+
+        // Reform the treelet from the optimal partitions, reusing its internal nodes
+        struct PartitionEntry
+        {
+            UINT Mask;
+            UINT32 NodeIndex;
+        };
+        UINT nodesAllocated = 1;
+        UINT partitionStackSize = 1;
+        PartitionEntry partitionStack[FullTreeletSize];
+        partitionStack[0].Mask = FullSubsetMask;
+        partitionStack[0].NodeIndex = nodeIndex;
+
+        auto GetPartitionNode = [&](UINT mask) -> UINT32
+        {
+            if (__popcnt(mask) > 1)
+            {
+                const UINT32 internalNodeIndex = internalNodes[nodesAllocated++];
+                partitionStack[partitionStackSize++] = { mask, internalNodeIndex };
+                return internalNodeIndex;
+            }
+
+            unsigned long leafBit;
+            _BitScanForward(&leafBit, mask);
+            return treeletLeaves[leafBit];
+        };
+
+        while (partitionStackSize > 0)
+        {
+            const PartitionEntry partition = partitionStack[--partitionStackSize];
+            const UINT leftMask = optimalPartition[partition.Mask];
+            const UINT32 leftNodeIndex = GetPartitionNode(leftMask);
+            const UINT32 rightNodeIndex = GetPartitionNode(partition.Mask ^ leftMask);
+
+            pNodes[partition.NodeIndex].internalNode.leftNodeIndex = leftNodeIndex;
+            pNodes[partition.NodeIndex].rightNodeIndex = rightNodeIndex;
+            state.ParentIndices[leftNodeIndex] = partition.NodeIndex;
+            state.ParentIndices[rightNodeIndex] = partition.NodeIndex;
+        }
+        assert(nodesAllocated == NumInternalTreeletNodes);
+
+        // Internal nodes were allocated top-down, so walking them backwards refits bottom-up
+        for (int i = NumInternalTreeletNodes - 1; i >= 0; --i)
+        {
+            RefitTreeletNode(state, internalNodes[i]);
+        }
+        return true;
+    }
+
+    //
+    // Visits every internal node after both of its children, restructuring the treelets
+    // rooted at nodes with at least FullTreeletSize primitives. Disjoint subtrees are
+    // processed in parallel unless minLeavesPerThread covers every leaf. Returns the number
+    // of treelets that were rewritten.
+    //
+
+    static
+        UINT OptimizeTreelets(
+            TreeletOptimizationState& state,
+            UINT minLeavesPerThread)
+    {
+        for (UINT32 nodeIndex : state.PreOrder)
+        {
+            state.ChildrenProcessed[nodeIndex] = 0;
+        }
+
+        std::atomic<UINT> numTreeletsRestructured(0);
+        ParallelFor((UINT)state.LeafIndices.size(), minLeavesPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT i = begin; i < end; ++i)
+            {
+                UINT32 nodeIndex = state.LeafIndices[i];
+                while (nodeIndex != 0)
+                {
+                    // The parent is processed by whichever child finishes last
+                    const UINT32 parentNodeIndex = state.ParentIndices[nodeIndex];
+                    if (state.ChildrenProcessed[parentNodeIndex]++ == 0)
+                    {
+                        break;
+                    }
+
+                    nodeIndex = parentNodeIndex;
+                    RefitTreeletNode(state, nodeIndex);
+                    if (state.NumPrimitives[nodeIndex] >= FullTreeletSize && RestructureTreelet(state, nodeIndex))
+                    {
+                        numTreeletsRestructured++;
+                    }
+                }
+            }
+        });
+
+        return numTreeletsRestructured;
+    }
+
+    static
+        float GetNormalizedSahCost(
+            const TreeletOptimizationState& state)
+    {
+        const float rootSurfaceArea = ComputeBoxSurfaceArea(state.AABBs[0]);
+        return rootSurfaceArea > 0.0f ? state.SubtreeCosts[0] / rootSurfaceArea : CostOfRayTriangleIntersection * state.NumPrimitives[0];
+    }
+
+    void OptimizeBVH(
+        BYTE* pData,
+        UINT numOptimizationPasses,
+        std::vector<float>* pSahCostPerPass,
+        bool bSingleThreaded)
+    {
+        const BVHOffsets& offsets = *(const BVHOffsets*)pData;
+        if (offsets.offsetToPrimitiveMetaData == 0)
+        {
+            ThrowFailure(E_INVALIDARG, L"Only bottom-level acceleration structures can be optimized");
+        }
+
+        AABBNode* pNodes = (AABBNode*)(pData + offsets.offsetToBoxes);
+        const UINT32 numNodes = (offsets.offsetToVertices - offsets.offsetToBoxes) / sizeof(AABBNode);
+        if (pSahCostPerPass)
+        {
+            pSahCostPerPass->clear();
+        }
+        if (numNodes == 0)
+        {
+            return;
+        }
+
+        TreeletOptimizationState state(pNodes, numNodes);
+        LoadTreeletOptimizationState(state, numNodes);
+        const UINT minLeavesPerThread = bSingleThreaded ? (UINT)state.LeafIndices.size() : TreeletMinLeavesPerThread;
+        if (pSahCostPerPass)
+        {
+            pSahCostPerPass->push_back(GetNormalizedSahCost(state));
+        }
+
+        for (UINT pass = 0; pass < numOptimizationPasses; ++pass)
+        {
+            const UINT numTreeletsRestructured = OptimizeTreelets(state, minLeavesPerThread);
+            if (pSahCostPerPass)
+            {
+                pSahCostPerPass->push_back(GetNormalizedSahCost(state));
+            }
+
+            // Later passes see the same treelets, nothing more to gain
+            if (numTreeletsRestructured == 0)
+            {
+                break;
+            }
+        }
+
+        for (UINT32 nodeIndex : state.PreOrder)
+        {
+            if (!pNodes[nodeIndex].leaf)
+            {
+                PackNodeAABB(pNodes[nodeIndex], state.AABBs[nodeIndex]);
+            }
+        }
+    }
 }
 
 void BuildRaytracingAccelerationStructureOnCpu(
@@ -697,3 +1076,12 @@ void BuildRaytracingAccelerationStructureOnCpu(
     }
     memcpy(outputData + offsets.offsetToPrimitiveMetaData, bvh.m_metadata.data(), sizeofMetadata);
 }
+
+void OptimizeAccelerationStructureOnCpu(
+    _Inout_ void *pData,
+    UINT NumOptimizationPasses,
+    _Out_opt_ std::vector<float> *pSahCostPerPass,
+    bool bSingleThreaded)
+{
+    FallbackLayer::OptimizeBVH((BYTE*)pData, NumOptimizationPasses, pSahCostPerPass, bSingleThreaded);
+}
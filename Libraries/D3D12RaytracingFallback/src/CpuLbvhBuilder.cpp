@@ -0,0 +1,1425 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+#include "TreeletReorderBindings.h"
+
+// CPU implementation of the LBVH pipeline run by GpuBvh2Builder:
+// load primitives -> scene AABB -> Morton codes -> sort -> rearrange ->
+// Karras hierarchy -> treelet reorder -> bottom-up AABBs.
+// Every stage follows the HLSL pass of the same name, so the output uses the
+// same BVHOffsets layout and can be compared against the GPU builder.
+// Top-level builds run the same stages over the world-space boxes of the instances.
+namespace FallbackLayer
+{
+    // Smallest amount of work worth handing to another thread.
+    static const UINT LbvhMinElementsPerThread = 4096;
+
+    static const float CostOfRayBoxIntersection = 1.2f;
+    static const float CostOfRayTriangleIntersection = 1.0f;
+
+    static const UINT IsLeafFlag = 0x80000000;
+    static const UINT IsProceduralGeometryFlag = 0x40000000;
+    static const float AABB_Min_Padding = 0.001f;
+
+    static int CountLeadingZeroes(UINT32 num)
+    {
+        unsigned long index;
+        return _BitScanReverse(&index, num) ? 31 - (int)index : 32;
+    }
+
+    static int CountLeadingZeroes(UINT64 num)
+    {
+        unsigned long index;
+        return _BitScanReverse64(&index, num) ? 63 - (int)index : 64;
+    }
+
+    static AABB CombineAABB(const AABB &aabb0, const AABB &aabb1)
+    {
+        AABB parentAABB;
+        parentAABB.min = min(aabb0.min, aabb1.min);
+        parentAABB.max = max(aabb0.max, aabb1.max);
+        return parentAABB;
+    }
+
+    static float ComputeBoxSurfaceArea(const AABB &aabb)
+    {
+        float3 dim = aabb.max - aabb.min;
+        return 2.0f * (dim.x * dim.y + dim.x * dim.z + dim.y * dim.z);
+    }
+
+    static AABB GetPrimitiveAABB(const Primitive &primitive)
+    {
+        if (primitive.PrimitiveType == TRIANGLE_TYPE)
+        {
+            const Triangle &tri = primitive.triangle;
+            AABB aabb;
+            aabb.min = min(min(tri.v0, tri.v1), tri.v2);
+            aabb.max = max(max(tri.v0, tri.v1), tri.v2);
+            aabb.min = min(aabb.min, aabb.max - float3{ AABB_Min_Padding, AABB_Min_Padding, AABB_Min_Padding });
+            return aabb;
+        }
+        else
+        {
+            return primitive.aabb;
+        }
+    }
+
+    static float3 GetPrimitiveCentroid(const Primitive &primitive)
+    {
+        if (primitive.PrimitiveType == TRIANGLE_TYPE)
+        {
+            const Triangle &tri = primitive.triangle;
+            return (tri.v0 + tri.v1 + tri.v2) / 3.0f;
+        }
+        else
+        {
+            return (primitive.aabb.min + primitive.aabb.max) / 2.0f;
+        }
+    }
+
+    static void WriteNode(AABBNode &node, const AABB &aabb, UINT flagX, UINT flagY)
+    {
+        for (UINT axis = 0; axis < 3; axis++)
+        {
+            node.center[axis] = (aabb.minArr[axis] + aabb.maxArr[axis]) * 0.5f;
+            node.halfDim[axis] = aabb.maxArr[axis] - node.center[axis];
+        }
+        node.nodeAllBits = flagX;
+        node.rightNodeIndex = flagY;
+    }
+
+    //
+    // LoadPrimitivesPass
+    //
+
+    static float3 LoadVertex(const D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC &triangles, UINT index)
+    {
+        const BYTE *pVertex = (const BYTE *)triangles.VertexBuffer.StartAddress + (UINT64)index * triangles.VertexBuffer.StrideInBytes;
+        float3 v = *(const float3 *)pVertex;
+
+        // Transform3x4 is a row-major 3x4 matrix
+        const float *pTransform = (const float *)triangles.Transform3x4;
+        if (pTransform)
+        {
+            v = float3{
+                v.x * pTransform[0] + v.y * pTransform[1] + v.z * pTransform[2] + pTransform[3],
+                v.x * pTransform[4] + v.y * pTransform[5] + v.z * pTransform[6] + pTransform[7],
+                v.x * pTransform[8] + v.y * pTransform[9] + v.z * pTransform[10] + pTransform[11] };
+        }
+        return v;
+    }
+
+    static void LoadIndices(const D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC &triangles, UINT triangleIndex, UINT indices[3])
+    {
+        const UINT firstIndex = triangleIndex * 3;
+        for (UINT i = 0; i < 3; i++)
+        {
+            switch (triangles.IndexFormat)
+            {
+            case DXGI_FORMAT_R32_UINT:
+                indices[i] = ((const UINT32 *)triangles.IndexBuffer)[firstIndex + i];
+                break;
+            case DXGI_FORMAT_R16_UINT:
+                indices[i] = ((const UINT16 *)triangles.IndexBuffer)[firstIndex + i];
+                break;
+            default:
+                indices[i] = firstIndex + i;
+                break;
+            }
+        }
+    }
+
+    static void LoadPrimitives(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs,
+        std::vector<Primitive> &primitives,
+        std::vector<PrimitiveMetaData> &metadata)
+    {
+        UINT numPrimitivesLoaded = 0;
+        for (UINT elementIndex = 0; elementIndex < inputs.NumDescs; elementIndex++)
+        {
+            const D3D12_RAYTRACING_GEOMETRY_DESC &geometryDesc = GetGeometryDesc(inputs, elementIndex);
+            const UINT numPrimitivesInGeometry = GetPrimitiveCountFromGeometryDesc(geometryDesc);
+            const UINT primitiveOffset = numPrimitivesLoaded;
+
+            if (geometryDesc.Type == D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES)
+            {
+                const D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC &triangles = geometryDesc.Triangles;
+                if (triangles.IndexBuffer == 0 && triangles.IndexFormat != DXGI_FORMAT_UNKNOWN)
+                {
+                    ThrowFailure(E_INVALIDARG, L"If the index buffer is null, the Index format must be DXGI_FORMAT_UNKNOWN");
+                }
+                if (!IsVertexBufferFormatSupported(triangles.VertexFormat))
+                {
+                    ThrowFailure(E_INVALIDARG, L"Invalid vertex format provided. Supported is limited to DXGI_FORMAT_R32G32B32_FLOAT/DXGI_FORMAT_R32G32B32A32_FLOAT");
+                }
+
+                ParallelFor(numPrimitivesInGeometry, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+                {
+                    for (UINT localTriangleIndex = begin; localTriangleIndex < end; localTriangleIndex++)
+                    {
+                        UINT indices[3];
+                        LoadIndices(triangles, localTriangleIndex, indices);
+
+                        Primitive &primitive = primitives[primitiveOffset + localTriangleIndex];
+                        primitive.PrimitiveType = TRIANGLE_TYPE;
+                        primitive.triangle.v0 = LoadVertex(triangles, indices[0]);
+                        primitive.triangle.v1 = LoadVertex(triangles, indices[1]);
+                        primitive.triangle.v2 = LoadVertex(triangles, indices[2]);
+                    }
+                });
+            }
+            else
+            {
+                const D3D12_RAYTRACING_GEOMETRY_AABBS_DESC &aabbs = geometryDesc.AABBs;
+                if (aabbs.AABBs.StartAddress == 0 && aabbs.AABBCount > 0)
+                {
+                    ThrowFailure(E_INVALIDARG, L"Non-zero AABBCount provided with a null AABB buffer");
+                }
+
+                ParallelFor(numPrimitivesInGeometry, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+                {
+                    for (UINT localPrimitiveIndex = begin; localPrimitiveIndex < end; localPrimitiveIndex++)
+                    {
+                        const D3D12_RAYTRACING_AABB &inputAABB = *(const D3D12_RAYTRACING_AABB *)
+                            ((const BYTE *)aabbs.AABBs.StartAddress + (UINT64)localPrimitiveIndex * aabbs.AABBs.StrideInBytes);
+
+                        Primitive &primitive = primitives[primitiveOffset + localPrimitiveIndex];
+                        primitive.PrimitiveType = PROCEDURAL_PRIMITIVE_TYPE;
+                        primitive.aabb.min = float3{ inputAABB.MinX, inputAABB.MinY, inputAABB.MinZ };
+                        primitive.aabb.max = float3{ inputAABB.MaxX, inputAABB.MaxY, inputAABB.MaxZ };
+                    }
+                });
+            }
+
+            for (UINT localPrimitiveIndex = 0; localPrimitiveIndex < numPrimitivesInGeometry; localPrimitiveIndex++)
+            {
+                PrimitiveMetaData &primitiveMetadata = metadata[primitiveOffset + localPrimitiveIndex];
+                primitiveMetadata.GeometryContributionToHitGroupIndex = elementIndex;
+                primitiveMetadata.PrimitiveIndex = localPrimitiveIndex;
+                primitiveMetadata.GeometryFlags = geometryDesc.Flags;
+            }
+            numPrimitivesLoaded += numPrimitivesInGeometry;
+        }
+    }
+
+    //
+    // SceneAABBCalculator
+    //
+
+    static AABB CalculateSceneAABB(const std::vector<Primitive> &primitives)
+    {
+        const UINT numElements = (UINT)primitives.size();
+        const UINT numChunks = DivideAndRoundUp(numElements, LbvhMinElementsPerThread);
+
+        std::vector<AABB> chunkAABBs(numChunks);
+        ParallelFor(numChunks, 1, [&](UINT beginChunk, UINT endChunk)
+        {
+            for (UINT chunk = beginChunk; chunk < endChunk; chunk++)
+            {
+                AABB &sceneAABB = chunkAABBs[chunk];
+                sceneAABB.min = float3{ FLT_MAX, FLT_MAX, FLT_MAX };
+                sceneAABB.max = float3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+                const UINT end = std::min(numElements, (chunk + 1) * LbvhMinElementsPerThread);
+                for (UINT i = chunk * LbvhMinElementsPerThread; i < end; i++)
+                {
+                    const Primitive &primitive = primitives[i];
+                    if (primitive.PrimitiveType == TRIANGLE_TYPE)
+                    {
+                        const Triangle &tri = primitive.triangle;
+                        sceneAABB.min = min(min(min(tri.v0, sceneAABB.min), tri.v1), tri.v2);
+                        sceneAABB.max = max(max(max(tri.v0, sceneAABB.max), tri.v1), tri.v2);
+                    }
+                    else
+                    {
+                        sceneAABB = CombineAABB(sceneAABB, primitive.aabb);
+                    }
+                }
+            }
+        });
+
+        AABB sceneAABB = chunkAABBs[0];
+        for (UINT chunk = 1; chunk < numChunks; chunk++)
+        {
+            sceneAABB = CombineAABB(sceneAABB, chunkAABBs[chunk]);
+        }
+        return sceneAABB;
+    }
+
+    //
+    // MortonCodesCalculator
+    //
+    // Codes interleave the axes in the order y, x, z starting from the least significant bit,
+    // the same as CalculateMortonCodes.hlsli. 30-bit codes match the GPU builder exactly,
+    // 63-bit codes keep 21 bits per axis for scenes with a large spread of primitive sizes.
+    //
+
+    template <typename MortonCode> struct MortonCodeTraits;
+
+    template <> struct MortonCodeTraits<UINT32>
+    {
+        static const UINT BitsPerAxis = 10;
+
+        // Inserts two zero bits above each of the low 10 bits.
+        static UINT32 SpreadBits(UINT32 x)
+        {
+            x &= 0x000003ff;
+            x = (x | (x << 16)) & 0xff0000ff;
+            x = (x | (x << 8)) & 0x0300f00f;
+            x = (x | (x << 4)) & 0x030c30c3;
+            x = (x | (x << 2)) & 0x09249249;
+            return x;
+        }
+    };
+
+    template <> struct MortonCodeTraits<UINT64>
+    {
+        static const UINT BitsPerAxis = 21;
+
+        // Inserts two zero bits above each of the low 21 bits.
+        static UINT64 SpreadBits(UINT64 x)
+        {
+            x &= 0x00000000001fffffull;
+            x = (x | (x << 32)) & 0x001f00000000ffffull;
+            x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+            x = (x | (x << 8)) & 0x100f00f00f00f00full;
+            x = (x | (x << 4)) & 0x10c30c30c30c30c3ull;
+            x = (x | (x << 2)) & 0x1249249249249249ull;
+            return x;
+        }
+    };
+
+    template <typename MortonCode>
+    static MortonCode CalculateMortonCode(const float3 &elementCentroid, const AABB &sceneAABB)
+    {
+        typedef MortonCodeTraits<MortonCode> Traits;
+        const float epsilon = 0.00001f;
+        const float maxCoord = (float)(1u << Traits::BitsPerAxis);
+
+        float3 sceneDimension = max(sceneAABB.max - sceneAABB.min, float3{ epsilon, epsilon, epsilon });
+        float3 unitCoord = (elementCentroid - sceneAABB.min) / sceneDimension;
+
+        auto GetCoord = [&](float unit)
+        {
+            return (MortonCode)std::min(std::max(unit * maxCoord, 0.0f), maxCoord - 1);
+        };
+
+        return Traits::SpreadBits(GetCoord(unitCoord.y)) |
+            (Traits::SpreadBits(GetCoord(unitCoord.x)) << 1) |
+            (Traits::SpreadBits(GetCoord(unitCoord.z)) << 2);
+    }
+
+    template <typename MortonCode>
+    static void CalculateMortonCodes(
+        const std::vector<Primitive> &primitives,
+        const AABB &sceneAABB,
+        std::vector<MortonCode> &mortonCodes,
+        std::vector<UINT> &indices)
+    {
+        ParallelFor((UINT)primitives.size(), LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT elementIndex = begin; elementIndex < end; elementIndex++)
+            {
+                mortonCodes[elementIndex] = CalculateMortonCode<MortonCode>(GetPrimitiveCentroid(primitives[elementIndex]), sceneAABB);
+                indices[elementIndex] = elementIndex;
+            }
+        });
+    }
+
+    //
+    // Sort
+    //
+    // Parallel LSD radix sort of the Morton codes and their element indices, 8 bits per pass.
+    // Each chunk of keys is histogrammed and scattered by one thread. Offsets are assigned
+    // digit-major, chunk-minor so every pass is stable and equal codes stay in element order.
+    //
+
+    template <typename MortonCode>
+    static void RadixSort(std::vector<MortonCode> &keys, std::vector<UINT> &values)
+    {
+        const UINT RadixBits = 8;
+        const UINT RadixSize = 1 << RadixBits;
+        const UINT numElements = (UINT)keys.size();
+        const UINT numChunks = DivideAndRoundUp(numElements, LbvhMinElementsPerThread);
+
+        std::vector<MortonCode> sortedKeys(numElements);
+        std::vector<UINT> sortedValues(numElements);
+        std::vector<UINT> offsets(numChunks * RadixSize);
+
+        for (UINT shift = 0; shift < sizeof(MortonCode) * 8; shift += RadixBits)
+        {
+            auto GetDigit = [shift](MortonCode key) { return (UINT)(key >> shift) & (RadixSize - 1); };
+
+            ParallelFor(numChunks, 1, [&](UINT beginChunk, UINT endChunk)
+            {
+                for (UINT chunk = beginChunk; chunk < endChunk; chunk++)
+                {
+                    UINT *pHistogram = &offsets[chunk * RadixSize];
+                    std::fill(pHistogram, pHistogram + RadixSize, 0);
+
+                    const UINT end = std::min(numElements, (chunk + 1) * LbvhMinElementsPerThread);
+                    for (UINT i = chunk * LbvhMinElementsPerThread; i < end; i++)
+                    {
+                        pHistogram[GetDigit(keys[i])]++;
+                    }
+                }
+            });
+
+            // Every key has the same digit, this pass wouldn't move anything
+            bool bSingleDigit = false;
+            UINT offset = 0;
+            for (UINT digit = 0; digit < RadixSize; digit++)
+            {
+                const UINT digitStart = offset;
+                for (UINT chunk = 0; chunk < numChunks; chunk++)
+                {
+                    UINT count = offsets[chunk * RadixSize + digit];
+                    offsets[chunk * RadixSize + digit] = offset;
+                    offset += count;
+                }
+                bSingleDigit |= (offset - digitStart) == numElements;
+            }
+            if (bSingleDigit)
+            {
+                continue;
+            }
+
+            ParallelFor(numChunks, 1, [&](UINT beginChunk, UINT endChunk)
+            {
+                for (UINT chunk = beginChunk; chunk < endChunk; chunk++)
+                {
+                    UINT *pOffsets = &offsets[chunk * RadixSize];
+                    const UINT end = std::min(numElements, (chunk + 1) * LbvhMinElementsPerThread);
+                    for (UINT i = chunk * LbvhMinElementsPerThread; i < end; i++)
+                    {
+                        const UINT outputIndex = pOffsets[GetDigit(keys[i])]++;
+                        sortedKeys[outputIndex] = keys[i];
+                        sortedValues[outputIndex] = values[i];
+                    }
+                }
+            });
+
+            keys.swap(sortedKeys);
+            values.swap(sortedValues);
+        }
+    }
+
+    //
+    // ConstructHierarchyPass
+    //
+    // Karras 2012, "Maximizing Parallelism in the Construction of BVHs, Octrees, and k-d Trees".
+    // Internal node i is emitted independently of all other nodes, following BuildBVHSplits.hlsli.
+    //
+
+    template <typename MortonCode>
+    static int GetLongestCommonPrefix(const std::vector<MortonCode> &mortonCodes, INT64 indexA, INT64 indexB)
+    {
+        const INT64 numElements = (INT64)mortonCodes.size();
+        if (indexA < 0 || indexA >= numElements || indexB < 0 || indexB >= numElements)
+        {
+            return -1;
+        }
+
+        MortonCode mortonCodeA = mortonCodes[(size_t)indexA];
+        MortonCode mortonCodeB = mortonCodes[(size_t)indexB];
+        if (mortonCodeA != mortonCodeB)
+        {
+            return CountLeadingZeroes((MortonCode)(mortonCodeA ^ mortonCodeB));
+        }
+        else
+        {
+            // Duplicate codes fall back to comparing the element indices
+            return CountLeadingZeroes((MortonCode)(indexA ^ indexB)) + (int)(sizeof(MortonCode) * 8) - 1;
+        }
+    }
+
+    template <typename MortonCode>
+    static void DetermineRange(const std::vector<MortonCode> &mortonCodes, INT64 idx, UINT &first, UINT &last)
+    {
+        int d = GetLongestCommonPrefix(mortonCodes, idx, idx + 1) - GetLongestCommonPrefix(mortonCodes, idx, idx - 1);
+        d = d < 0 ? -1 : 1;
+        int minPrefix = GetLongestCommonPrefix(mortonCodes, idx, idx - d);
+
+        INT64 maxLength = 2;
+        while (GetLongestCommonPrefix(mortonCodes, idx, idx + maxLength * d) > minPrefix)
+        {
+            maxLength *= 4;
+        }
+
+        INT64 length = 0;
+        for (INT64 t = maxLength / 2; t > 0; t /= 2)
+        {
+            if (GetLongestCommonPrefix(mortonCodes, idx, idx + (length + t) * d) > minPrefix)
+            {
+                length = length + t;
+            }
+        }
+
+        INT64 j = idx + length * d;
+        first = (UINT)std::min(idx, j);
+        last = (UINT)std::max(idx, j);
+    }
+
+    template <typename MortonCode>
+    static UINT FindSplit(const std::vector<MortonCode> &mortonCodes, UINT first, UINT last)
+    {
+        int commonPrefix = GetLongestCommonPrefix(mortonCodes, first, last);
+        UINT split = first;
+        UINT step = last - first;
+
+        do
+        {
+            step = (step + 1) >> 1;
+            UINT newSplit = split + step;
+
+            if (newSplit < last)
+            {
+                int splitPrefix = GetLongestCommonPrefix(mortonCodes, first, newSplit);
+                if (splitPrefix > commonPrefix)
+                    split = newSplit;
+            }
+        } while (step > 1);
+
+        return split;
+    }
+
+    template <typename MortonCode>
+    static void ConstructHierarchy(const std::vector<MortonCode> &mortonCodes, std::vector<HierarchyNode> &hierarchy)
+    {
+        const UINT numElements = (UINT)mortonCodes.size();
+        const UINT numInternalNodes = GetNumberOfInternalNodes(numElements);
+        const UINT leafNodeOffset = numInternalNodes;
+
+        ParallelFor(numInternalNodes, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT idx = begin; idx < end; idx++)
+            {
+                UINT first, last;
+                DetermineRange(mortonCodes, idx, first, last);
+                UINT split = FindSplit(mortonCodes, first, last);
+
+                UINT childAIndex = (split == first) ? leafNodeOffset + split : split;
+                UINT childBIndex = (split + 1 == last) ? leafNodeOffset + split + 1 : split + 1;
+
+                hierarchy[idx].LeftChildIndex = childAIndex;
+                hierarchy[idx].RightChildIndex = childBIndex;
+                hierarchy[childAIndex].ParentIndex = idx;
+                hierarchy[childBIndex].ParentIndex = idx;
+            }
+        });
+    }
+
+    //
+    // TreeletReorder
+    //
+    // Karras and Aila 2013, "Fast Parallel Construction of High-Quality Bounding Volume Hierarchies".
+    // Costs and partitions are computed exactly as in TreeletReorder.hlsl so that both
+    // builders restructure the same treelets the same way.
+    //
+
+    struct TreeletReorderState
+    {
+        TreeletReorderState(UINT numElements, const Primitive *pPrimitives, std::vector<HierarchyNode> &hierarchy) :
+            NumElements(numElements),
+            NumInternalNodes(GetNumberOfInternalNodes(numElements)),
+            pPrimitives(pPrimitives),
+            Hierarchy(hierarchy),
+            AABBs(numElements + GetNumberOfInternalNodes(numElements)),
+            NumTriangles(new std::atomic<UINT>[GetNumberOfInternalNodes(numElements)]),
+            BaseTreelets(std::max(numElements / FullTreeletSize, 1u))
+        {}
+
+        bool IsLeafIndex(UINT nodeIndex) const { return nodeIndex >= NumInternalNodes; }
+
+        const UINT NumElements;
+        const UINT NumInternalNodes;
+        const Primitive *pPrimitives;
+        std::vector<HierarchyNode> &Hierarchy;
+        std::vector<AABB> AABBs;
+        std::unique_ptr<std::atomic<UINT>[]> NumTriangles;
+        std::vector<UINT> BaseTreelets;
+        std::atomic<UINT> NumBaseTreelets;
+    };
+
+    static void FindTreelets(TreeletReorderState &state, UINT minTrianglesPerTreelet)
+    {
+        ParallelFor(state.NumInternalNodes, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT i = begin; i < end; i++)
+            {
+                state.NumTriangles[i] = 0;
+            }
+        });
+        state.NumBaseTreelets = 0;
+
+        // Start from the leaf nodes and go bottom-up
+        ParallelFor(state.NumElements, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT leafIndex = begin; leafIndex < end; leafIndex++)
+            {
+                UINT nodeIndex = state.NumInternalNodes + leafIndex;
+                UINT numTriangles = 1;
+                bool isLeaf = true;
+
+                while (true)
+                {
+                    if (isLeaf)
+                    {
+                        state.AABBs[nodeIndex] = GetPrimitiveAABB(state.pPrimitives[leafIndex]);
+                    }
+                    else
+                    {
+                        const HierarchyNode &node = state.Hierarchy[nodeIndex];
+                        state.AABBs[nodeIndex] = CombineAABB(state.AABBs[node.LeftChildIndex], state.AABBs[node.RightChildIndex]);
+                    }
+
+                    if (numTriangles >= minTrianglesPerTreelet)
+                    {
+                        state.BaseTreelets[state.NumBaseTreelets++] = nodeIndex;
+                        break;
+                    }
+
+                    if (nodeIndex == 0)
+                    {
+                        break;
+                    }
+
+                    // The parent is processed by whichever child finishes last
+                    UINT parentNodeIndex = state.Hierarchy[nodeIndex].ParentIndex;
+                    UINT numTrianglesFromOtherNode = state.NumTriangles[parentNodeIndex].fetch_add(numTriangles);
+                    if (numTrianglesFromOtherNode == 0)
+                    {
+                        break;
+                    }
+
+                    nodeIndex = parentNodeIndex;
+                    numTriangles = numTrianglesFromOtherNode + numTriangles;
+                    isLeaf = false;
+                }
+            }
+        });
+    }
+
+    static void ReorderTreelet(TreeletReorderState &state, UINT nodeIndex)
+    {
+        const UINT NumInternalTreeletNodes = FullTreeletSize - 1;
+        const UINT NumTreeletSplitPermutations = 1 << FullTreeletSize;
+        const UINT FullPartitionMask = NumTreeletSplitPermutations - 1;
+        const UINT CollapseChildrenBit = 1 << FullTreeletSize;
+
+        std::vector<HierarchyNode> &hierarchy = state.Hierarchy;
+        std::vector<AABB> &aabbs = state.AABBs;
+
+        // Form the treelet by repeatedly expanding the internal node with the largest surface area
+        UINT treeletToReorder[FullTreeletSize];
+        UINT internalNodes[NumInternalTreeletNodes];
+        internalNodes[0] = nodeIndex;
+        treeletToReorder[0] = hierarchy[nodeIndex].LeftChildIndex;
+        treeletToReorder[1] = hierarchy[nodeIndex].RightChildIndex;
+
+        for (UINT treeletSize = 2; treeletSize < FullTreeletSize; treeletSize++)
+        {
+            float largestSurfaceArea = -1.0f;
+            UINT indexOfNodeIndexToTraverse = FullTreeletSize;
+            for (UINT i = 0; i < treeletSize; i++)
+            {
+                UINT treeletNodeIndex = treeletToReorder[i];
+                // Leaf nodes can't be split so skip these
+                if (!state.IsLeafIndex(treeletNodeIndex))
+                {
+                    float surfaceArea = ComputeBoxSurfaceArea(aabbs[treeletNodeIndex]);
+                    if (surfaceArea > largestSurfaceArea)
+                    {
+                        largestSurfaceArea = surfaceArea;
+                        indexOfNodeIndexToTraverse = i;
+                    }
+                }
+            }
+
+            if (indexOfNodeIndexToTraverse == FullTreeletSize)
+            {
+                // Fewer than FullTreeletSize leaves below this node, leave it as is
+                return;
+            }
+
+            // Replace the original node with its left child and add the right child to the end
+            UINT nodeIndexToTraverse = treeletToReorder[indexOfNodeIndexToTraverse];
+            internalNodes[treeletSize - 1] = nodeIndexToTraverse;
+            treeletToReorder[indexOfNodeIndexToTraverse] = hierarchy[nodeIndexToTraverse].LeftChildIndex;
+            treeletToReorder[treeletSize] = hierarchy[nodeIndexToTraverse].RightChildIndex;
+        }
+
+        // Surface area of every subset of the treelet leaves, indexed by the subset's bitmask
+        float optimalCost[NumTreeletSplitPermutations];
+        UINT optimalPartition[NumTreeletSplitPermutations];
+        for (UINT treeletBitmask = 1; treeletBitmask < NumTreeletSplitPermutations; treeletBitmask++)
+        {
+            AABB aabb;
+            aabb.min = float3{ FLT_MAX, FLT_MAX, FLT_MAX };
+            aabb.max = float3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            for (UINT i = 0; i < FullTreeletSize; i++)
+            {
+                if ((1 << i) & treeletBitmask)
+                {
+                    aabb = CombineAABB(aabb, aabbs[treeletToReorder[i]]);
+                }
+            }
+            optimalCost[treeletBitmask] = ComputeBoxSurfaceArea(aabb);
+        }
+
+        const float rootAABBSurfaceArea = ComputeBoxSurfaceArea(aabbs[nodeIndex]);
+        for (UINT i = 0; i < FullTreeletSize; i++)
+        {
+            optimalCost[1 << i] = CostOfRayBoxIntersection * ComputeBoxSurfaceArea(aabbs[treeletToReorder[i]]) / rootAABBSurfaceArea;
+        }
+
+        // Every proper subset of a bitmask is numerically smaller than it, so visiting the
+        // bitmasks in increasing order always has the costs of both partitions ready
+        for (UINT treeletBitmask = 1; treeletBitmask < NumTreeletSplitPermutations; treeletBitmask++)
+        {
+            const UINT subsetSize = __popcnt(treeletBitmask);
+            if (subsetSize < 2)
+            {
+                continue;
+            }
+
+            float lowestCost = FLT_MAX;
+            UINT bestPartition = 0;
+
+            UINT delta = (treeletBitmask - 1) & treeletBitmask;
+            UINT partitionBitmask = (0u - delta) & treeletBitmask;
+            do
+            {
+                const float cost = optimalCost[partitionBitmask] + optimalCost[treeletBitmask ^ partitionBitmask];
+                if (cost < lowestCost)
+                {
+                    lowestCost = cost;
+                    bestPartition = partitionBitmask;
+                }
+                partitionBitmask = (partitionBitmask - delta) & treeletBitmask;
+            } while (partitionBitmask != 0);
+
+            float costAsLeafNode = CostOfRayTriangleIntersection * optimalCost[treeletBitmask] * subsetSize;
+            float costAsInternalNode = CostOfRayBoxIntersection * optimalCost[treeletBitmask] + lowestCost;
+            optimalCost[treeletBitmask] = std::min(costAsInternalNode, costAsLeafNode);
+            optimalPartition[treeletBitmask] = bestPartition;
+            if (costAsLeafNode < costAsInternalNode)
+            {
+                optimalPartition[treeletBitmask] |= CollapseChildrenBit;
+            }
+        }
+
+        // Reform the treelet from the optimal partitions, reusing its internal nodes
+        struct PartitionEntry
+        {
+            UINT Mask;
+            UINT NodeIndex;
+        };
+        UINT nodesAllocated = 1;
+        UINT partitionStackSize = 1;
+        PartitionEntry partitionStack[FullTreeletSize];
+        partitionStack[0].Mask = FullPartitionMask;
+        partitionStack[0].NodeIndex = internalNodes[0];
+
+        while (partitionStackSize > 0)
+        {
+            PartitionEntry partition = partitionStack[--partitionStackSize];
+
+            PartitionEntry leftEntry;
+            leftEntry.Mask = optimalPartition[partition.Mask];
+            const bool bCollapseChildren = (leftEntry.Mask & CollapseChildrenBit) != 0;
+            leftEntry.Mask &= FullPartitionMask;
+            if (__popcnt(leftEntry.Mask) > 1)
+            {
+                leftEntry.NodeIndex = internalNodes[nodesAllocated++];
+                partitionStack[partitionStackSize++] = leftEntry;
+            }
+            else
+            {
+                unsigned long leafBit;
+                _BitScanForward(&leafBit, leftEntry.Mask);
+                leftEntry.NodeIndex = treeletToReorder[leafBit];
+            }
+
+            PartitionEntry rightEntry;
+            rightEntry.Mask = partition.Mask ^ leftEntry.Mask;
+            if (__popcnt(rightEntry.Mask) > 1)
+            {
+                rightEntry.NodeIndex = internalNodes[nodesAllocated++];
+                partitionStack[partitionStackSize++] = rightEntry;
+            }
+            else
+            {
+                unsigned long leafBit;
+                _BitScanForward(&leafBit, rightEntry.Mask);
+                rightEntry.NodeIndex = treeletToReorder[leafBit];
+            }
+
+            hierarchy[partition.NodeIndex].LeftChildIndex = leftEntry.NodeIndex;
+            hierarchy[partition.NodeIndex].RightChildIndex = rightEntry.NodeIndex;
+            hierarchy[leftEntry.NodeIndex].ParentIndex = partition.NodeIndex;
+            hierarchy[leftEntry.NodeIndex].bCollapseChildren = bCollapseChildren;
+            hierarchy[rightEntry.NodeIndex].ParentIndex = partition.NodeIndex;
+            hierarchy[rightEntry.NodeIndex].bCollapseChildren = bCollapseChildren;
+        }
+
+        // Internal nodes were allocated top-down, so walking them backwards refits bottom-up
+        for (int j = NumInternalTreeletNodes - 1; j >= 0; j--)
+        {
+            const HierarchyNode &internalNode = hierarchy[internalNodes[j]];
+            aabbs[internalNodes[j]] = CombineAABB(aabbs[internalNode.LeftChildIndex], aabbs[internalNode.RightChildIndex]);
+        }
+    }
+
+    static void ReorderTreelets(TreeletReorderState &state)
+    {
+        ParallelForEach(state.NumBaseTreelets, [&](UINT treeletIndex)
+        {
+            UINT nodeIndex = state.BaseTreelets[treeletIndex];
+            while (true)
+            {
+                ReorderTreelet(state, nodeIndex);
+
+                if (nodeIndex == 0)
+                {
+                    break;
+                }
+
+                // Wait for sibling in tree
+                UINT parentNodeIndex = state.Hierarchy[nodeIndex].ParentIndex;
+                UINT ourNumTriangles = state.NumTriangles[nodeIndex];
+                UINT numTrianglesFromOtherNode = state.NumTriangles[parentNodeIndex].fetch_add(ourNumTriangles);
+                if (numTrianglesFromOtherNode == 0)
+                {
+                    break;
+                }
+
+                const HierarchyNode &parentNode = state.Hierarchy[parentNodeIndex];
+                state.AABBs[parentNodeIndex] = CombineAABB(state.AABBs[parentNode.LeftChildIndex], state.AABBs[parentNode.RightChildIndex]);
+                nodeIndex = parentNodeIndex;
+            }
+        });
+    }
+
+    static void OptimizeHierarchy(
+        UINT numElements,
+        const Primitive *pPrimitives,
+        std::vector<HierarchyNode> &hierarchy,
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags)
+    {
+        const bool bPrioritizeTrace = (buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE) != 0;
+        const bool bPrioritizeBuild = (buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD) != 0;
+
+        UINT numOptimizationPasses;
+        if (bPrioritizeBuild)
+        {
+            numOptimizationPasses = 0;
+        }
+        else if (bPrioritizeTrace)
+        {
+            numOptimizationPasses = 3;
+        }
+        else
+        {
+            numOptimizationPasses = 1;
+        }
+
+        if (numOptimizationPasses == 0 || numElements < FullTreeletSize)
+        {
+            return;
+        }
+
+        TreeletReorderState state(numElements, pPrimitives, hierarchy);
+        UINT minTrianglesPerTreelet = FullTreeletSize;
+        for (UINT i = 0; i < numOptimizationPasses; i++)
+        {
+            if (minTrianglesPerTreelet > numElements)
+            {
+                break;
+            }
+
+            FindTreelets(state, minTrianglesPerTreelet);
+            ReorderTreelets(state);
+
+            minTrianglesPerTreelet *= 2;
+        }
+    }
+
+    //
+    // ConstructAABBPass
+    //
+
+    static void ConstructAABBs(
+        UINT numElements,
+        const Primitive *pPrimitives,
+        const std::vector<HierarchyNode> &hierarchy,
+        AABBNode *pNodes,
+        UINT *pAABBParents,
+        bool bTopLevel = false)
+    {
+        const UINT numInternalNodes = GetNumberOfInternalNodes(numElements);
+        std::unique_ptr<std::atomic<UINT>[]> childNodesProcessedCounter(new std::atomic<UINT>[numInternalNodes]);
+        for (UINT i = 0; i < numInternalNodes; i++)
+        {
+            childNodesProcessedCounter[i] = 0;
+        }
+
+        ParallelFor(numElements, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT leafIndex = begin; leafIndex < end; leafIndex++)
+            {
+                UINT nodeIndex = numInternalNodes + leafIndex;
+                UINT numTriangles = 1;
+                bool swapChildIndices = false;
+                while (true)
+                {
+                    const bool isLeaf = nodeIndex >= numInternalNodes;
+                    if (isLeaf)
+                    {
+                        const Primitive &primitive = pPrimitives[leafIndex];
+                        // Top-level leaves are instances, stored as AABBs but not procedural geometry
+                        UINT leafFlags = IsLeafFlag | (primitive.PrimitiveType == TRIANGLE_TYPE || bTopLevel ? 0 : IsProceduralGeometryFlag);
+                        WriteNode(pNodes[nodeIndex], GetPrimitiveAABB(primitive), leafIndex | leafFlags, 1);
+                    }
+                    else
+                    {
+                        UINT leftNodeIndex = hierarchy[nodeIndex].LeftChildIndex;
+                        UINT rightNodeIndex = hierarchy[nodeIndex].RightChildIndex;
+                        if (swapChildIndices)
+                        {
+                            std::swap(leftNodeIndex, rightNodeIndex);
+                        }
+
+                        AABB leftAABB, rightAABB;
+                        DecompressAABB(leftAABB, pNodes[leftNodeIndex]);
+                        DecompressAABB(rightAABB, pNodes[rightNodeIndex]);
+                        WriteNode(pNodes[nodeIndex], CombineAABB(leftAABB, rightAABB), leftNodeIndex & 0x00ffffff, rightNodeIndex);
+                    }
+
+                    if (nodeIndex == 0)
+                    {
+                        break;
+                    }
+
+                    // If this counter was already incremented, that means both children for the parent
+                    // node have computed their AABB, and the parent is ready to be processed
+                    UINT parentNodeIndex = hierarchy[nodeIndex].ParentIndex;
+                    UINT trianglesFromOtherChild = childNodesProcessedCounter[parentNodeIndex].fetch_add(numTriangles);
+                    if (trianglesFromOtherChild == 0)
+                    {
+                        break;
+                    }
+
+                    // Prioritize having the smaller nodes on the left. Unlike the GPU pass, ties keep
+                    // the hierarchy's order so the output doesn't depend on which child finished last.
+                    const bool isLeft = hierarchy[parentNodeIndex].LeftChildIndex == nodeIndex;
+                    swapChildIndices = isLeft ? numTriangles > trianglesFromOtherChild : trianglesFromOtherChild > numTriangles;
+                    nodeIndex = parentNodeIndex;
+                    numTriangles += trianglesFromOtherChild;
+
+                    if (pAABBParents)
+                    {
+                        pAABBParents[hierarchy[nodeIndex].LeftChildIndex] = nodeIndex;
+                        pAABBParents[hierarchy[nodeIndex].RightChildIndex] = nodeIndex;
+                    }
+                }
+            }
+        });
+    }
+
+    //
+    // Top-level
+    //
+    // Leaves are instances, bounded by their bottom-level root box transformed to world space
+    // as in TopLevelLoadAABBs.hlsli. The instance metadata follows the leaf nodes, in leaf order.
+    //
+
+    // Refitting a path costs about log2(numElements) nodes, past this many updated instances
+    // per node in the tree a full bottom-up refit is cheaper.
+    static const UINT PartialRefitMaxPathsPerNode = 1;
+
+    static const D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC &GetInstanceDesc(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs,
+        UINT instanceIndex)
+    {
+        // The CPU builders take CPU pointers in place of GPU virtual addresses
+        if (inputs.DescsLayout == D3D12_ELEMENTS_LAYOUT_ARRAY_OF_POINTERS)
+        {
+            const D3D12_GPU_VIRTUAL_ADDRESS *pInstanceDescs = (const D3D12_GPU_VIRTUAL_ADDRESS *)inputs.InstanceDescs;
+            return *(const D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC *)pInstanceDescs[instanceIndex];
+        }
+        else
+        {
+            return ((const D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC *)inputs.InstanceDescs)[instanceIndex];
+        }
+    }
+
+    static float3 TransformPoint(const float3 &v, _In_reads_(12) const float *pTransform)
+    {
+        return float3{
+            v.x * pTransform[0] + v.y * pTransform[1] + v.z * pTransform[2] + pTransform[3],
+            v.x * pTransform[4] + v.y * pTransform[5] + v.z * pTransform[6] + pTransform[7],
+            v.x * pTransform[8] + v.y * pTransform[9] + v.z * pTransform[10] + pTransform[11] };
+    }
+
+    static AABB TransformAABB(const AABB &box, _In_reads_(12) const float *pTransform)
+    {
+        AABB transformedBox;
+        transformedBox.min = float3{ FLT_MAX, FLT_MAX, FLT_MAX };
+        transformedBox.max = float3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (UINT corner = 0; corner < 8; corner++)
+        {
+            float3 vertex = float3{
+                (corner & 1) ? box.max.x : box.min.x,
+                (corner & 2) ? box.max.y : box.min.y,
+                (corner & 4) ? box.max.z : box.min.z };
+            vertex = TransformPoint(vertex, pTransform);
+            transformedBox.min = min(transformedBox.min, vertex);
+            transformedBox.max = max(transformedBox.max, vertex);
+        }
+        return transformedBox;
+    }
+
+    static void InverseAffineTransform(_In_reads_(12) const float *pTransform, _Out_writes_(12) float *pInverse)
+    {
+        using namespace DirectX;
+        XMMATRIX transform(
+            pTransform[0], pTransform[1], pTransform[2], pTransform[3],
+            pTransform[4], pTransform[5], pTransform[6], pTransform[7],
+            pTransform[8], pTransform[9], pTransform[10], pTransform[11],
+            0.0f, 0.0f, 0.0f, 1.0f);
+        XMFLOAT4X4 inverse;
+        XMStoreFloat4x4(&inverse, XMMatrixInverse(nullptr, transform));
+        memcpy(pInverse, &inverse, sizeof(float) * 12);
+    }
+
+    static AABB GetBottomLevelRootAABB(const D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC &instanceDesc)
+    {
+        AABB box = {};
+        const BYTE *pBottomLevel = (const BYTE *)instanceDesc.AccelerationStructure.GpuVA;
+        const BVHOffsets &offsets = *(const BVHOffsets *)pBottomLevel;
+        if (offsets.totalSize > offsets.offsetToBoxes)
+        {
+            DecompressAABB(box, *(const AABBNode *)(pBottomLevel + offsets.offsetToBoxes));
+        }
+        return box;
+    }
+
+    // Fills in the world-space box and the metadata of an instance, the same as TopLevelLoadAABBs.hlsli.
+    static void LoadInstance(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs,
+        UINT instanceIndex,
+        AABB &worldAABB,
+        BVHMetadata &metadata)
+    {
+        const D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC &instanceDesc = GetInstanceDesc(inputs, instanceIndex);
+        const float *pObjectToWorld = &instanceDesc.Transform[0][0];
+        worldAABB = TransformAABB(GetBottomLevelRootAABB(instanceDesc), pObjectToWorld);
+
+        // Traversal only needs WorldToObject in the instance desc
+        metadata.instanceDesc = instanceDesc;
+        InverseAffineTransform(pObjectToWorld, &metadata.instanceDesc.Transform[0][0]);
+        memcpy(metadata.ObjectToWorld, pObjectToWorld, sizeof(metadata.ObjectToWorld));
+        metadata.InstanceIndex = instanceIndex;
+    }
+
+    static void WriteTopLevelLeaf(AABBNode &node, const AABB &worldAABB, UINT leafIndex)
+    {
+        WriteNode(node, worldAABB, leafIndex | IsLeafFlag, 1);
+    }
+
+    static void RefitInternalNode(AABBNode *pNodes, UINT nodeIndex)
+    {
+        AABBNode &node = pNodes[nodeIndex];
+        const UINT leftNodeIndex = node.internalNode.leftNodeIndex;
+        const UINT rightNodeIndex = node.rightNodeIndex;
+
+        AABB leftAABB, rightAABB;
+        DecompressAABB(leftAABB, pNodes[leftNodeIndex]);
+        DecompressAABB(rightAABB, pNodes[rightNodeIndex]);
+        WriteNode(node, CombineAABB(leftAABB, rightAABB), leftNodeIndex, rightNodeIndex);
+    }
+
+    static bool IsSameBox(const AABBNode &a, const AABBNode &b)
+    {
+        return memcmp(a.center, b.center, sizeof(a.center)) == 0 &&
+            memcmp(a.halfDim, b.halfDim, sizeof(a.halfDim)) == 0;
+    }
+
+    // Refits every internal node bottom-up, keeping the existing hierarchy and child order.
+    static void RefitAllNodes(UINT numElements, AABBNode *pNodes, const UINT *pAABBParents)
+    {
+        const UINT numInternalNodes = GetNumberOfInternalNodes(numElements);
+        std::unique_ptr<std::atomic<UINT>[]> childNodesProcessedCounter(new std::atomic<UINT>[numInternalNodes]);
+        for (UINT i = 0; i < numInternalNodes; i++)
+        {
+            childNodesProcessedCounter[i] = 0;
+        }
+
+        ParallelFor(numElements, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT leafIndex = begin; leafIndex < end; leafIndex++)
+            {
+                UINT nodeIndex = numInternalNodes + leafIndex;
+                while (nodeIndex != 0)
+                {
+                    // The second child to finish refits the parent
+                    nodeIndex = pAABBParents[nodeIndex];
+                    if (childNodesProcessedCounter[nodeIndex].fetch_add(1) == 0)
+                    {
+                        break;
+                    }
+                    RefitInternalNode(pNodes, nodeIndex);
+                }
+            }
+        });
+    }
+
+    // Refits only the paths from the given leaves to the root. A path stops early once a node's
+    // box comes out unchanged, since none of its ancestors can change either.
+    static void RefitPaths(AABBNode *pNodes, const UINT *pAABBParents, const std::vector<UINT> &leafNodeIndices)
+    {
+        for (UINT nodeIndex : leafNodeIndices)
+        {
+            while (nodeIndex != 0)
+            {
+                nodeIndex = pAABBParents[nodeIndex];
+
+                const AABBNode previousNode = pNodes[nodeIndex];
+                RefitInternalNode(pNodes, nodeIndex);
+                if (IsSameBox(previousNode, pNodes[nodeIndex]))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    struct TopLevelBVH
+    {
+        TopLevelBVH(BYTE *pData, UINT numElements, bool updatesAllowed)
+        {
+            pNodes = (AABBNode *)(pData + SizeOfBVHOffsets);
+            pMetadata = (BVHMetadata *)(pData + GetOffsetToLeafNodeAABBs(numElements) + GetOffsetFromLeafNodesToBottomLevelMetadata(numElements));
+            pSortCache = updatesAllowed ? (UINT *)(pData + GetOffsetToBVHSortedIndices(numElements)) : nullptr;
+            pAABBParents = updatesAllowed ? pSortCache + GetOffsetFromSortedIndicesToAABBParents(numElements) / sizeof(UINT) : nullptr;
+        }
+
+        AABBNode *pNodes;
+        BVHMetadata *pMetadata;
+        UINT *pSortCache;
+        UINT *pAABBParents;
+    };
+
+    template <typename MortonCode>
+    static void BuildTopLevelLbvh(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs,
+        BYTE *pOutputData)
+    {
+        const UINT numElements = inputs.NumDescs;
+        const bool updatesAllowed = (inputs.Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE) != 0;
+
+        // Same header as TopLevelPrepareForComputeAABBs.hlsl, a 0 primitive metadata offset marks a top-level BVH
+        BVHOffsets &offsets = *(BVHOffsets *)pOutputData;
+        offsets.offsetToPrimitiveMetaData = 0;
+        if (numElements == 0)
+        {
+            // The prebuild info reserves no nodes for an empty acceleration structure
+            offsets.offsetToBoxes = offsets.offsetToVertices = SizeOfBVHOffsets;
+            offsets.totalSize = SizeOfBVHOffsets;
+            return;
+        }
+
+        const UINT offsetToLeafNodeMetadata = GetOffsetToLeafNodeAABBs(numElements) + GetOffsetFromLeafNodesToBottomLevelMetadata(numElements);
+        offsets.offsetToBoxes = SizeOfBVHOffsets;
+        offsets.offsetToVertices = offsetToLeafNodeMetadata;
+        offsets.totalSize = offsetToLeafNodeMetadata + numElements * SizeOfBVHMetadata;
+
+        TopLevelBVH bvh(pOutputData, numElements, updatesAllowed);
+
+        // Instances are loaded as AABB primitives so that the bottom-level stages apply unchanged
+        std::vector<Primitive> primitives(numElements);
+        std::vector<BVHMetadata> metadata(numElements);
+        ParallelFor(numElements, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT instanceIndex = begin; instanceIndex < end; instanceIndex++)
+            {
+                primitives[instanceIndex].PrimitiveType = PROCEDURAL_PRIMITIVE_TYPE;
+                LoadInstance(inputs, instanceIndex, primitives[instanceIndex].aabb, metadata[instanceIndex]);
+            }
+        });
+
+        AABB sceneAABB = CalculateSceneAABB(primitives);
+
+        std::vector<MortonCode> mortonCodes(numElements);
+        std::vector<UINT> sortedIndices(numElements);
+        CalculateMortonCodes(primitives, sceneAABB, mortonCodes, sortedIndices);
+        RadixSort(mortonCodes, sortedIndices);
+
+        std::vector<Primitive> sortedPrimitives(numElements);
+        ParallelFor(numElements, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT dstIndex = begin; dstIndex < end; dstIndex++)
+            {
+                UINT srcIndex = sortedIndices[dstIndex];
+                sortedPrimitives[dstIndex] = primitives[srcIndex];
+                bvh.pMetadata[dstIndex] = metadata[srcIndex];
+                if (bvh.pSortCache)
+                {
+                    bvh.pSortCache[srcIndex] = dstIndex;
+                }
+            }
+        });
+
+        std::vector<HierarchyNode> hierarchy(numElements + GetNumberOfInternalNodes(numElements));
+        ConstructHierarchy(mortonCodes, hierarchy);
+
+#if ENABLE_TREELET_REORDERING
+        OptimizeHierarchy(numElements, sortedPrimitives.data(), hierarchy, inputs.Flags);
+#endif
+
+        ConstructAABBs(numElements, sortedPrimitives.data(), hierarchy, bvh.pNodes, bvh.pAABBParents, true);
+    }
+
+    // Reloads the given instances, or every instance that changed if pUpdatedInstanceIndices is null,
+    // and refits the hierarchy built by BuildTopLevelLbvh around them.
+    static void UpdateTopLevelLbvh(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC &desc,
+        const UINT *pUpdatedInstanceIndices,
+        UINT numUpdatedInstances,
+        BYTE *pOutputData,
+        bool *pRefitOnlyUpdatedPaths)
+    {
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs = desc.Inputs;
+        const UINT numElements = inputs.NumDescs;
+
+        if (pRefitOnlyUpdatedPaths)
+        {
+            *pRefitOnlyUpdatedPaths = false;
+        }
+
+        if (numElements == 0)
+        {
+            return;
+        }
+
+        const BYTE *pSourceData = (const BYTE *)desc.SourceAccelerationStructureData;
+        if (pSourceData && pSourceData != pOutputData)
+        {
+            const UINT updateDataSize = GetOffsetFromSortedIndicesToAABBParents(numElements) +
+                (numElements + GetNumberOfInternalNodes(numElements)) * SizeOfUINT32;
+            memcpy(pOutputData, pSourceData, GetOffsetToBVHSortedIndices(numElements) + updateDataSize);
+        }
+
+        const BVHOffsets &offsets = *(const BVHOffsets *)pOutputData;
+        if (offsets.offsetToPrimitiveMetaData != 0 || offsets.totalSize != offsets.offsetToVertices + numElements * SizeOfBVHMetadata)
+        {
+            ThrowFailure(E_INVALIDARG, L"The source acceleration structure wasn't built as a top-level acceleration structure with the same number of instances");
+        }
+
+        TopLevelBVH bvh(pOutputData, numElements, true);
+        const UINT numInternalNodes = GetNumberOfInternalNodes(numElements);
+
+        auto ReloadInstance = [&](UINT instanceIndex)
+        {
+            AABB worldAABB;
+            BVHMetadata metadata;
+            LoadInstance(inputs, instanceIndex, worldAABB, metadata);
+
+            const UINT leafIndex = bvh.pSortCache[instanceIndex];
+            AABBNode leafNode;
+            WriteTopLevelLeaf(leafNode, worldAABB, leafIndex);
+
+            const bool bChanged = !IsSameBox(leafNode, bvh.pNodes[numInternalNodes + leafIndex]) ||
+                memcmp(&metadata, &bvh.pMetadata[leafIndex], sizeof(metadata)) != 0;
+            bvh.pNodes[numInternalNodes + leafIndex] = leafNode;
+            bvh.pMetadata[leafIndex] = metadata;
+            return bChanged;
+        };
+
+        std::vector<UINT> updatedLeafNodes;
+        if (pUpdatedInstanceIndices)
+        {
+            for (UINT i = 0; i < numUpdatedInstances; i++)
+            {
+                const UINT instanceIndex = pUpdatedInstanceIndices[i];
+                if (instanceIndex >= numElements)
+                {
+                    ThrowFailure(E_INVALIDARG, L"Updated instance index is out of range");
+                }
+                ReloadInstance(instanceIndex);
+                updatedLeafNodes.push_back(numInternalNodes + bvh.pSortCache[instanceIndex]);
+            }
+        }
+        else
+        {
+            // Bottom-level AS may have been refit in place, so every instance has to be checked
+            std::vector<BYTE> changed(numElements);
+            ParallelFor(numElements, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+            {
+                for (UINT instanceIndex = begin; instanceIndex < end; instanceIndex++)
+                {
+                    changed[instanceIndex] = ReloadInstance(instanceIndex);
+                }
+            });
+
+            for (UINT instanceIndex = 0; instanceIndex < numElements; instanceIndex++)
+            {
+                if (changed[instanceIndex])
+                {
+                    updatedLeafNodes.push_back(numInternalNodes + bvh.pSortCache[instanceIndex]);
+                }
+            }
+        }
+
+        // Each path is about log2(numElements) nodes long
+        UINT treeDepth = 1;
+        while ((1u << treeDepth) < numElements)
+        {
+            treeDepth++;
+        }
+
+        if ((UINT64)updatedLeafNodes.size() * treeDepth > (UINT64)(numElements + numInternalNodes) * PartialRefitMaxPathsPerNode)
+        {
+            RefitAllNodes(numElements, bvh.pNodes, bvh.pAABBParents);
+        }
+        else
+        {
+            RefitPaths(bvh.pNodes, bvh.pAABBParents, updatedLeafNodes);
+            if (pRefitOnlyUpdatedPaths)
+            {
+                *pRefitOnlyUpdatedPaths = true;
+            }
+        }
+    }
+
+    template <typename MortonCode>
+    static void BuildLbvh(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs,
+        BYTE *pOutputData)
+    {
+        const UINT numElements = GetTotalPrimitiveCount(inputs);
+        const bool updatesAllowed = (inputs.Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE) != 0;
+
+        BVHOffsets &offsets = *(BVHOffsets *)pOutputData;
+        if (numElements == 0)
+        {
+            offsets.offsetToBoxes = offsets.offsetToVertices = offsets.offsetToPrimitiveMetaData = SizeOfBVHOffsets;
+            offsets.totalSize = SizeOfBVHOffsets;
+            return;
+        }
+
+        offsets.offsetToBoxes = SizeOfBVHOffsets;
+        offsets.offsetToVertices = GetOffsetToPrimitives(numElements);
+        offsets.offsetToPrimitiveMetaData = offsets.offsetToVertices + GetOffsetFromPrimitivesToPrimitiveMetaData(numElements);
+        offsets.totalSize = offsets.offsetToPrimitiveMetaData + numElements * SizeOfPrimitiveMetaData;
+
+        AABBNode *pNodes = (AABBNode *)(pOutputData + offsets.offsetToBoxes);
+        Primitive *pOutputPrimitives = (Primitive *)(pOutputData + offsets.offsetToVertices);
+        PrimitiveMetaData *pOutputMetadata = (PrimitiveMetaData *)(pOutputData + offsets.offsetToPrimitiveMetaData);
+        UINT *pSortCache = updatesAllowed ? (UINT *)((BYTE *)pOutputMetadata + GetOffsetFromPrimitiveMetaDataToSortedIndices(numElements)) : nullptr;
+        UINT *pAABBParents = updatesAllowed ? pSortCache + numElements : nullptr;
+
+        std::vector<Primitive> primitives(numElements);
+        std::vector<PrimitiveMetaData> metadata(numElements);
+        LoadPrimitives(inputs, primitives, metadata);
+
+        AABB sceneAABB = CalculateSceneAABB(primitives);
+
+        std::vector<MortonCode> mortonCodes(numElements);
+        std::vector<UINT> sortedIndices(numElements);
+        CalculateMortonCodes(primitives, sceneAABB, mortonCodes, sortedIndices);
+        RadixSort(mortonCodes, sortedIndices);
+
+        // Rearrange the primitives into Morton order, the leaf for sorted element i is node numInternalNodes + i
+        ParallelFor(numElements, LbvhMinElementsPerThread, [&](UINT begin, UINT end)
+        {
+            for (UINT dstIndex = begin; dstIndex < end; dstIndex++)
+            {
+                UINT srcIndex = sortedIndices[dstIndex];
+                pOutputPrimitives[dstIndex] = primitives[srcIndex];
+                pOutputMetadata[dstIndex] = metadata[srcIndex];
+                if (pSortCache)
+                {
+                    pSortCache[srcIndex] = dstIndex;
+                }
+            }
+        });
+
+        std::vector<HierarchyNode> hierarchy(numElements + GetNumberOfInternalNodes(numElements));
+        ConstructHierarchy(mortonCodes, hierarchy);
+
+#if ENABLE_TREELET_REORDERING
+        OptimizeHierarchy(numElements, pOutputPrimitives, hierarchy, inputs.Flags);
+#endif
+
+        ConstructAABBs(numElements, pOutputPrimitives, hierarchy, pNodes, pAABBParents);
+    }
+}
+
+void BuildRaytracingAccelerationStructureOnCpuLbvh(
+    _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
+    _Out_ void *pData,
+    bool bUse63BitMortonCodes)
+{
+    const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs = pDesc->Inputs;
+    if (inputs.Type == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL)
+    {
+        if (inputs.Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE)
+        {
+            UpdateTopLevelAccelerationStructureOnCpuLbvh(pDesc, nullptr, 0, pData);
+        }
+        else if (bUse63BitMortonCodes)
+        {
+            FallbackLayer::BuildTopLevelLbvh<UINT64>(inputs, (BYTE *)pData);
+        }
+        else
+        {
+            FallbackLayer::BuildTopLevelLbvh<UINT32>(inputs, (BYTE *)pData);
+        }
+        return;
+    }
+
+    if (inputs.Type != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL)
+    {
+        ThrowFailure(E_INVALIDARG, L"Unrecognized D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE provided");
+    }
+    if (inputs.Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE)
+    {
+        ThrowFailure(E_INVALIDARG, L"The CPU LBVH builder only supports updates of top-level acceleration structures");
+    }
+
+    if (bUse63BitMortonCodes)
+    {
+        FallbackLayer::BuildLbvh<UINT64>(inputs, (BYTE *)pData);
+    }
+    else
+    {
+        FallbackLayer::BuildLbvh<UINT32>(inputs, (BYTE *)pData);
+    }
+}
+
+void UpdateTopLevelAccelerationStructureOnCpuLbvh(
+    _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
+    _In_reads_opt_(NumUpdatedInstances) const UINT *pUpdatedInstanceIndices,
+    UINT NumUpdatedInstances,
+    _Inout_ void *pData,
+    _Out_opt_ bool *pRefitOnlyUpdatedPaths)
+{
+    const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs = pDesc->Inputs;
+    if (inputs.Type != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL ||
+        !(inputs.Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE))
+    {
+        ThrowFailure(E_INVALIDARG, L"Only top-level acceleration structures built with D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE can be updated");
+    }
+
+    FallbackLayer::UpdateTopLevelLbvh(*pDesc, pUpdatedInstanceIndices, NumUpdatedInstances, (BYTE *)pData, pRefitOnlyUpdatedPaths);
+}
@@ -17,7 +17,7 @@ namespace FallbackLayer
 
     RaytracingDevice::RaytracingDevice(ID3D12Device *pDevice, UINT NodeMask, DWORD createRaytracingFallbackDeviceFlags) :
         m_pDevice(pDevice), m_RaytracingProgramFactory(pDevice), m_AccelerationStructureBuilderFactory(pDevice, NodeMask),
-        m_flags(createRaytracingFallbackDeviceFlags)
+        m_StateObjectCache(pDevice), m_flags(createRaytracingFallbackDeviceFlags)
     {
         // Earlier builds of windows may not support checking shader model yet so this cannot 
         // catch non-Dxil drivers on older builds.
@@ -498,12 +498,27 @@ namespace FallbackLayer
                 ThrowFailure(E_OUTOFMEMORY, L"Out of memory");
             }
 
+            // A pipeline with the same contents as one created earlier shares its linked program,
+            // which also means the desc was already validated
+            pRaytracingStateObject->m_cacheKey = m_StateObjectCache.ComputeKey(*pDesc);
+            if (pDesc->Type == D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE && pRaytracingStateObject->m_cacheKey)
+            {
+                pRaytracingStateObject->m_spProgram = m_StateObjectCache.Find(pRaytracingStateObject->m_cacheKey);
+                if (pRaytracingStateObject->m_spProgram)
+                {
+                    return S_OK;
+                }
+            }
+
             ProcessStateObject(*pDesc, *pRaytracingStateObject);
 
             if (pDesc->Type == D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE)
             {
                 pRaytracingStateObject->m_spProgram.reset(
-                    m_RaytracingProgramFactory.GetRaytracingProgram(pRaytracingStateObject->m_collection));
+                    m_RaytracingProgramFactory.GetRaytracingProgram(
+                        pRaytracingStateObject->m_collection,
+                        m_StateObjectCache,
+                        pRaytracingStateObject->m_cacheKey));
 
                 pRaytracingStateObject->m_spProgram->SetPredispatchCallback([=](ID3D12GraphicsCommandList *pCommandList, UINT patchRootSignatureParameterStart)
                 {
@@ -523,6 +538,11 @@ namespace FallbackLayer
                         0);
 #endif
                 });
+
+                if (pRaytracingStateObject->m_cacheKey)
+                {
+                    m_StateObjectCache.Add(pRaytracingStateObject->m_cacheKey, pRaytracingStateObject->m_spProgram);
+                }
             }
         }
         catch (_com_error &e)
@@ -538,12 +558,14 @@ namespace FallbackLayer
         _In_  UINT NumSourceAccelerationStructures,
         _In_reads_(NumSourceAccelerationStructures)  const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData)
     {
-        if (pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE ||
-            pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE)
+        if (pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE &&
+            pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE &&
+            pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION)
         {
             ThrowFailure(E_INVALIDARG,
                 L"Unsupported InfoType passed in, only supported POSTBUILD_INFO flags are "
-                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE and D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE, "
+                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE "
+                L"and D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION"
             );
         }
 #if USE_PIX_MARKERS
@@ -675,4 +697,13 @@ namespace FallbackLayer
             pDesc,
             pInfo);
     }
+
+    D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS STDMETHODCALLTYPE RaytracingDevice::CheckDriverMatchingIdentifier(
+        _In_  D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+        _In_  const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck)
+    {
+        return m_AccelerationStructureBuilderFactory.GetAccelerationStructureBuilder().CheckDriverMatchingIdentifier(
+            SerializedDataType,
+            pIdentifierToCheck);
+    }
 } // namespace FallbackLayer
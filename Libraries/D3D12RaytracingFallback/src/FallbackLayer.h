@@ -114,10 +114,16 @@ namespace FallbackLayer
         {
             return m_collection.m_stateObjectInfo;
         }
+
+        UINT64 GetCacheKey() const
+        {
+            return m_cacheKey;
+        }
     private:
 
         StateObjectCollection m_collection;
-        std::unique_ptr<IRaytracingProgram> m_spProgram;
+        std::shared_ptr<IRaytracingProgram> m_spProgram;
+        UINT64 m_cacheKey = 0;
         friend RaytracingDevice;
         friend D3D12RaytracingCommandList;
         COM_IMPLEMENTATION();
@@ -150,6 +156,21 @@ namespace FallbackLayer
             _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS *pDesc,
             _Out_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO *pInfo);
 
+        virtual D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS STDMETHODCALLTYPE CheckDriverMatchingIdentifier(
+            _In_  D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+            _In_  const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck);
+
+        virtual void SetStateObjectCacheDirectory(_In_opt_ LPCWSTR pDirectory)
+        {
+            m_StateObjectCache.SetDirectory(pDirectory);
+        }
+
+        virtual void GetStateObjectCacheStatistics(
+            _Out_ D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS *pStatistics)
+        {
+            m_StateObjectCache.GetStatistics(*pStatistics);
+        }
+
         virtual void QueryRaytracingCommandList(ID3D12GraphicsCommandList *pCommandList, 
             REFIID riid,
             _COM_Outptr_  void **ppRaytracingCommandList)
@@ -196,6 +217,7 @@ namespace FallbackLayer
         CComPtr<ID3D12Device> m_pDevice;
         AccelerationStructureBuilderFactory m_AccelerationStructureBuilderFactory;
         RaytracingProgramFactory m_RaytracingProgramFactory;
+        StateObjectCache m_StateObjectCache;
         DWORD m_flags;
 
         COM_IMPLEMENTATION_WITH_QUERYINTERFACE(m_pDevice.p)
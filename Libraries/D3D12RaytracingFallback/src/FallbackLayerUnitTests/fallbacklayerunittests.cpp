@@ -10,6 +10,7 @@
 //*********************************************************
 #include "stdafx.h"
 #include "CppUnitTest.h"
+#include <random>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using namespace FallbackLayer;
@@ -775,12 +776,766 @@ namespace FallbackLayerUnitTests
                 testCase);
         }
 
+        TEST_METHOD(R16IndexBufferBottomLevelCpuLbvhBuilder)
+        {
+            CpuGeometryDescriptor testCases[] =
+            {
+                CpuGeometryDescriptor(ReferenceVerticies0, VERTEX_COUNT(ReferenceVerticies0), ReferenceIndices0, ARRAYSIZE(ReferenceIndices0)),
+                CpuGeometryDescriptor(ReferenceVerticies1, VERTEX_COUNT(ReferenceVerticies1), ReferenceIndices1, ARRAYSIZE(ReferenceIndices1))
+            };
+
+            for (UINT testIndex = 0; testIndex < ARRAYSIZE(testCases); testIndex++)
+            {
+                TestCpuLbvhBuilder(&testCases[testIndex], 1);
+            }
+        }
+
+        TEST_METHOD(R32IndexBufferBottomLevelCpuLbvhBuilder)
+        {
+            CpuGeometryDescriptor testCases[] =
+            {
+                CpuGeometryDescriptor(ReferenceVerticies0, VERTEX_COUNT(ReferenceVerticies0), ReferenceR32Indices0, ARRAYSIZE(ReferenceR32Indices0)),
+                CpuGeometryDescriptor(ReferenceVerticies1, VERTEX_COUNT(ReferenceVerticies1), ReferenceR32Indices1, ARRAYSIZE(ReferenceR32Indices1))
+            };
+
+            for (UINT testIndex = 0; testIndex < ARRAYSIZE(testCases); testIndex++)
+            {
+                TestCpuLbvhBuilder(&testCases[testIndex], 1);
+            }
+        }
+
+        TEST_METHOD(NoIndexBufferMultipleGeometryBottomLevelCpuLbvhBuilder)
+        {
+            CpuGeometryDescriptor testCases[] =
+            {
+                CpuGeometryDescriptor(ReferenceVerticies0, VERTEX_COUNT(ReferenceVerticies0)),
+                CpuGeometryDescriptor(ReferenceVerticies1, VERTEX_COUNT(ReferenceVerticies1), ReferenceIndices1, ARRAYSIZE(ReferenceIndices1))
+            };
+
+            TestCpuLbvhBuilder(testCases, ARRAYSIZE(testCases));
+        }
+
+        TEST_METHOD(StressBottomLevelCpuLbvhBuilder)
+        {
+            std::vector<float> AutoGeneratedReferenceVertices;
+            std::vector<UINT16> AutoGeneratedReferenceIndicies;
+            for (UINT i = 0; i < 1000; i++)
+            {
+                for (float f : ReferenceVerticies0)
+                {
+                    AutoGeneratedReferenceVertices.push_back(f + i);
+                }
+
+                for (UINT16 index : ReferenceIndices0)
+                {
+                    AutoGeneratedReferenceIndicies.push_back(index + (UINT16)ARRAYSIZE(ReferenceIndices0) * i);
+                }
+            }
+            CpuGeometryDescriptor testCase(AutoGeneratedReferenceVertices.data(),
+                (UINT)(AutoGeneratedReferenceVertices.size() / 3),
+                AutoGeneratedReferenceIndicies.data(),
+                (UINT)AutoGeneratedReferenceIndicies.size());
+
+            const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags[] =
+            {
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE,
+            };
+            for (auto flags : buildFlags)
+            {
+                TestCpuLbvhBuilder(&testCase, 1, false, flags);
+                TestCpuLbvhBuilder(&testCase, 1, true, flags);
+            }
+        }
+
+        TEST_METHOD(TopLevelCpuLbvhBuilderWithPartialUpdate_ArrayLayout)
+        {
+            TestCpuTopLevelLbvhBuilder(1, D3D12_ELEMENTS_LAYOUT_ARRAY);
+            TestCpuTopLevelLbvhBuilder(3, D3D12_ELEMENTS_LAYOUT_ARRAY);
+            TestCpuTopLevelLbvhBuilder(100, D3D12_ELEMENTS_LAYOUT_ARRAY);
+        }
+
+        TEST_METHOD(TopLevelCpuLbvhBuilderWithPartialUpdate_ArrayOfPointersLayout)
+        {
+            TestCpuTopLevelLbvhBuilder(1, D3D12_ELEMENTS_LAYOUT_ARRAY_OF_POINTERS);
+            TestCpuTopLevelLbvhBuilder(3, D3D12_ELEMENTS_LAYOUT_ARRAY_OF_POINTERS);
+            TestCpuTopLevelLbvhBuilder(1000, D3D12_ELEMENTS_LAYOUT_ARRAY_OF_POINTERS);
+        }
+
+        TEST_METHOD(R16IndexBufferBottomLevelCompressedWideBvh)
+        {
+            CpuGeometryDescriptor testCases[] =
+            {
+                CpuGeometryDescriptor(ReferenceVerticies0, VERTEX_COUNT(ReferenceVerticies0), ReferenceIndices0, ARRAYSIZE(ReferenceIndices0)),
+                CpuGeometryDescriptor(ReferenceVerticies1, VERTEX_COUNT(ReferenceVerticies1), ReferenceIndices1, ARRAYSIZE(ReferenceIndices1))
+            };
+
+            for (UINT testIndex = 0; testIndex < ARRAYSIZE(testCases); testIndex++)
+            {
+                TestCompressedWideBvh(&testCases[testIndex], 1);
+            }
+        }
+
+        TEST_METHOD(R32IndexBufferBottomLevelCompressedWideBvh)
+        {
+            CpuGeometryDescriptor testCases[] =
+            {
+                CpuGeometryDescriptor(ReferenceVerticies0, VERTEX_COUNT(ReferenceVerticies0), ReferenceR32Indices0, ARRAYSIZE(ReferenceR32Indices0)),
+                CpuGeometryDescriptor(ReferenceVerticies1, VERTEX_COUNT(ReferenceVerticies1), ReferenceR32Indices1, ARRAYSIZE(ReferenceR32Indices1))
+            };
+
+            for (UINT testIndex = 0; testIndex < ARRAYSIZE(testCases); testIndex++)
+            {
+                TestCompressedWideBvh(&testCases[testIndex], 1);
+            }
+        }
+
+        TEST_METHOD(NoIndexBufferMultipleGeometryBottomLevelCompressedWideBvh)
+        {
+            CpuGeometryDescriptor testCases[] =
+            {
+                CpuGeometryDescriptor(ReferenceVerticies0, VERTEX_COUNT(ReferenceVerticies0)),
+                CpuGeometryDescriptor(ReferenceVerticies1, VERTEX_COUNT(ReferenceVerticies1), ReferenceIndices1, ARRAYSIZE(ReferenceIndices1))
+            };
+
+            TestCompressedWideBvh(testCases, ARRAYSIZE(testCases));
+        }
+
+        TEST_METHOD(StressBottomLevelCompressedWideBvh)
+        {
+            std::vector<float> AutoGeneratedReferenceVertices;
+            std::vector<UINT16> AutoGeneratedReferenceIndicies;
+            for (UINT i = 0; i < 1000; i++)
+            {
+                for (float f : ReferenceVerticies0)
+                {
+                    AutoGeneratedReferenceVertices.push_back(f + i);
+                }
+
+                for (UINT16 index : ReferenceIndices0)
+                {
+                    AutoGeneratedReferenceIndicies.push_back(index + (UINT16)ARRAYSIZE(ReferenceIndices0) * i);
+                }
+            }
+            CpuGeometryDescriptor testCase(AutoGeneratedReferenceVertices.data(),
+                (UINT)(AutoGeneratedReferenceVertices.size() / 3),
+                AutoGeneratedReferenceIndicies.data(),
+                (UINT)AutoGeneratedReferenceIndicies.size());
+
+            TestCompressedWideBvh(&testCase, 1);
+        }
+
+        // Traces the same rays against BVH2 and both compressed wide layouts. Hits have to
+        // match exactly, and the wide layouts are expected to be smaller and to fetch fewer nodes.
+        TEST_METHOD(CompressedWideBvhTraversalBenchmark)
+        {
+            const UINT numTriangles = 50000;
+            const UINT numRays = 20000;
+
+            srand(42);
+            auto randomFloat = [](float minValue, float maxValue) { return minValue + (rand() / (float)RAND_MAX) * (maxValue - minValue); };
+
+            std::vector<float> vertices;
+            for (UINT i = 0; i < numTriangles; i++)
+            {
+                const float center[3] = { randomFloat(-500.0f, 500.0f), randomFloat(-500.0f, 500.0f), randomFloat(-500.0f, 500.0f) };
+                for (UINT v = 0; v < 3; v++)
+                {
+                    for (UINT axis = 0; axis < 3; axis++)
+                    {
+                        vertices.push_back(center[axis] + randomFloat(-5.0f, 5.0f));
+                    }
+                }
+            }
+            CpuGeometryDescriptor geomDesc(vertices.data(), (UINT)(vertices.size() / 3));
+
+            std::vector<CpuRay> rays(numRays);
+            for (CpuRay &ray : rays)
+            {
+                ray.Origin = { randomFloat(-600.0f, 600.0f), randomFloat(-600.0f, 600.0f), randomFloat(-600.0f, 600.0f) };
+                const float3 target = { randomFloat(-500.0f, 500.0f), randomFloat(-500.0f, 500.0f), randomFloat(-500.0f, 500.0f) };
+                ray.Direction = target - ray.Origin;
+                ray.TMin = 0.0f;
+                ray.TMax = FLT_MAX;
+            }
+
+            // The BVH2 reference comes from the same CPU LBVH build the wide layouts are collapsed from
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
+                std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder>(
+                    new FallbackLayer::GpuBvh2Builder(&device, m_d3d12Context.GetTotalLaneCount(), 0));
+            InternalFallbackBuilder builderWrapper(pBuilder.get());
+
+            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geomDescs = GetCpuTriangleGeometryDescs(&geomDesc, 1);
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+            builderWrapper.GetRaytracingAccelerationStructurePrebuildInfo(&device,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE,
+                1,
+                geomDescs.data(),
+                &prebuildInfo);
+            std::unique_ptr<BYTE[]> pBvh2Data = std::unique_ptr<BYTE[]>(new BYTE[prebuildInfo.ResultDataMaxSizeInBytes]);
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+            desc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            desc.Inputs.NumDescs = 1;
+            desc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            desc.Inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+            desc.Inputs.pGeometryDescs = geomDescs.data();
+            BuildRaytracingAccelerationStructureOnCpuLbvh(&desc, pBvh2Data.get());
+
+            struct LayoutResult
+            {
+                AccelerationStructureLayoutType LayoutType;
+                const BYTE *pData;
+                std::vector<CpuRayHit> Hits;
+                std::vector<bool> HitMask;
+                CpuTraversalStats Stats;
+                double Milliseconds;
+            };
+
+            std::unique_ptr<BYTE[]> pBvh4Data = BuildCompressedWideBvh(CompressedBVH4, &geomDesc, 1);
+            std::unique_ptr<BYTE[]> pBvh8Data = BuildCompressedWideBvh(CompressedBVH8, &geomDesc, 1);
+            LayoutResult results[] =
+            {
+                { BVH2, pBvh2Data.get() },
+                { CompressedBVH4, pBvh4Data.get() },
+                { CompressedBVH8, pBvh8Data.get() },
+            };
+
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            for (LayoutResult &result : results)
+            {
+                result.Hits.resize(numRays);
+                result.HitMask.resize(numRays);
+                result.Stats = {};
+
+                LARGE_INTEGER start, end;
+                QueryPerformanceCounter(&start);
+                for (UINT i = 0; i < numRays; i++)
+                {
+                    result.HitMask[i] = TraceRayOnCpu(result.LayoutType, result.pData, rays[i], result.Hits[i], &result.Stats);
+                }
+                QueryPerformanceCounter(&end);
+                result.Milliseconds = (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart;
+
+                const BVHOffsets &offsets = *(const BVHOffsets *)result.pData;
+                std::wstringstream message;
+                message << L"Layout " << result.LayoutType
+                    << L": " << offsets.totalSize << L" bytes ("
+                    << (offsets.offsetToVertices - offsets.offsetToBoxes) << L" bytes of nodes), "
+                    << (double)result.Stats.NodesVisited / numRays << L" nodes/ray, "
+                    << (double)result.Stats.PrimitivesTested / numRays << L" primitives/ray, "
+                    << result.Milliseconds << L" ms\n";
+                Logger::WriteMessage(message.str().c_str());
+            }
+
+            const LayoutResult &reference = results[0];
+            const BVHOffsets &referenceOffsets = *(const BVHOffsets *)reference.pData;
+            for (UINT layoutIndex = 1; layoutIndex < ARRAYSIZE(results); layoutIndex++)
+            {
+                const LayoutResult &result = results[layoutIndex];
+                for (UINT i = 0; i < numRays; i++)
+                {
+                    Assert::AreEqual((bool)reference.HitMask[i], (bool)result.HitMask[i], L"Hit/miss doesn't match BVH2");
+                    if (reference.HitMask[i])
+                    {
+                        Assert::AreEqual(reference.Hits[i].T, result.Hits[i].T, L"Hit distance doesn't match BVH2");
+                        Assert::AreEqual(reference.Hits[i].MetaData.PrimitiveIndex, result.Hits[i].MetaData.PrimitiveIndex, L"Hit primitive doesn't match BVH2");
+                        Assert::AreEqual(reference.Hits[i].MetaData.GeometryContributionToHitGroupIndex, result.Hits[i].MetaData.GeometryContributionToHitGroupIndex, L"Hit geometry doesn't match BVH2");
+                    }
+                }
+
+                const BVHOffsets &offsets = *(const BVHOffsets *)result.pData;
+                Assert::IsTrue(offsets.totalSize < referenceOffsets.totalSize, L"Compressed wide BVH isn't smaller than BVH2");
+                Assert::IsTrue(result.Stats.NodesVisited < reference.Stats.NodesVisited, L"Compressed wide BVH doesn't fetch fewer nodes than BVH2");
+            }
+        }
+
+        std::unique_ptr<BYTE[]> BuildBottomLevelOnCpu(
+            CpuGeometryDescriptor *pGeomDescs,
+            UINT numGeoms,
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags,
+            bool bUse63BitMortonCodes = false,
+            bool bUseSahBuilder = false)
+        {
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            FallbackLayer::GpuBvh2Builder builder(&device, m_d3d12Context.GetTotalLaneCount(), 0);
+            InternalFallbackBuilder builderWrapper(&builder);
+
+            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geomDescs = GetCpuTriangleGeometryDescs(pGeomDescs, numGeoms);
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+            builderWrapper.GetRaytracingAccelerationStructurePrebuildInfo(&device,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
+                buildFlags,
+                numGeoms,
+                geomDescs.data(),
+                &prebuildInfo);
+            std::unique_ptr<BYTE[]> pData = std::unique_ptr<BYTE[]>(new BYTE[prebuildInfo.ResultDataMaxSizeInBytes]);
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+            desc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            desc.Inputs.NumDescs = numGeoms;
+            desc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            desc.Inputs.Flags = buildFlags;
+            desc.Inputs.pGeometryDescs = geomDescs.data();
+            if (bUseSahBuilder)
+            {
+                BuildRaytracingAccelerationStructureOnCpu(&desc, pData.get());
+            }
+            else
+            {
+                BuildRaytracingAccelerationStructureOnCpuLbvh(&desc, pData.get(), bUse63BitMortonCodes);
+            }
+            return pData;
+        }
+
+        BvhStatistics VerifyAndComputeStatistics(
+            AccelerationStructureLayoutType layoutType,
+            CpuGeometryDescriptor *pGeomDescs,
+            UINT numGeoms,
+            const BYTE *pData)
+        {
+            std::wstring errorMessage;
+            auto &validator = FallbackLayer::GetAccelerationStructureValidator(layoutType);
+            if (!validator.VerifyBottomLevelOutput(pGeomDescs, numGeoms, pData, errorMessage))
+            {
+                Assert::Fail(errorMessage.c_str());
+            }
+
+            BvhStatistics stats;
+            if (!ComputeBvhStatistics(layoutType, pData, stats, errorMessage))
+            {
+                Assert::Fail(errorMessage.c_str());
+            }
+
+            UINT numLeafPrimitives = 0;
+            UINT numLeaves = 0;
+            for (size_t count = 0; count < stats.LeafSizeHistogram.size(); count++)
+            {
+                numLeafPrimitives += (UINT)count * stats.LeafSizeHistogram[count];
+                numLeaves += stats.LeafSizeHistogram[count];
+            }
+            Assert::AreEqual(stats.NumPrimitives, numLeafPrimitives, L"Leaf size histogram doesn't add up to the primitive count");
+            Assert::AreEqual(stats.NumLeaves, numLeaves, L"Leaf size histogram doesn't add up to the leaf count");
+            Assert::AreEqual((size_t)stats.MaxDepth + 1, stats.LeafDepthHistogram.size(), L"Leaf depth histogram doesn't end at the max depth");
+            Assert::IsTrue(std::isfinite(stats.SahCost) && std::isfinite(stats.EpoCost) && std::isfinite(stats.SiblingOverlap), L"Statistics aren't finite");
+            return stats;
+        }
+
+        TEST_METHOD(BvhStatisticsOfKnownTrees)
+        {
+            // Two triangles 10 units apart in x, leaf boxes are padded by AABB_Min_Padding in z
+            std::vector<float> vertices(ReferenceVerticies0, ReferenceVerticies0 + 9);
+            for (UINT i = 0; i < 9; i++)
+            {
+                vertices.push_back(ReferenceVerticies0[i] + (i % 3 == 0 ? 10.0f : 0.0f));
+            }
+            CpuGeometryDescriptor disjoint(vertices.data(), (UINT)(vertices.size() / 3));
+            std::unique_ptr<BYTE[]> pData = BuildBottomLevelOnCpu(&disjoint, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD);
+            BvhStatistics stats = VerifyAndComputeStatistics(BVH2, &disjoint, 1, pData.get());
+
+            const float padding = 0.001f;
+            const float leafArea = 2.0f * (1.0f + 2.0f * padding);
+            const float rootArea = 2.0f * (11.0f + 11.0f * padding + padding);
+            Assert::AreEqual(2u, stats.NumPrimitives);
+            Assert::AreEqual(1u, stats.NumInternalNodes);
+            Assert::AreEqual(2u, stats.NumLeaves);
+            Assert::AreEqual(1u, stats.MaxDepth);
+            Assert::AreEqual(2u, stats.LeafDepthHistogram[1]);
+            Assert::AreEqual(2u, stats.LeafSizeHistogram[1]);
+            Assert::AreEqual(1.2f + 2.0f * leafArea / rootArea, stats.SahCost, 0.001f);
+            Assert::AreEqual(0.0f, stats.EpoCost);
+            Assert::AreEqual(0.0f, stats.SiblingOverlap);
+
+            // The same triangle twice, each leaf box contains all of the other triangle
+            vertices.assign(ReferenceVerticies0, ReferenceVerticies0 + 9);
+            vertices.insert(vertices.end(), ReferenceVerticies0, ReferenceVerticies0 + 9);
+            CpuGeometryDescriptor duplicate(vertices.data(), (UINT)(vertices.size() / 3));
+            pData = BuildBottomLevelOnCpu(&duplicate, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD);
+            stats = VerifyAndComputeStatistics(BVH2, &duplicate, 1, pData.get());
+            Assert::AreEqual(1.0f, stats.EpoCost, 0.001f);
+            Assert::AreEqual(1.0f, stats.SiblingOverlap, 0.001f);
+        }
+
+        enum FuzzGeometryType
+        {
+            FuzzUniform,
+            FuzzDegenerate,
+            FuzzCoplanar,
+            FuzzHugeExtent,
+            NumFuzzGeometryTypes
+        };
+
+        // Random triangle soups that stress builders in different ways. Each call draws from its own
+        // engine, and floats are made from its raw output rather than a std distribution, whose
+        // results differ between standard libraries, so a seed gives the same soup everywhere.
+        static void GenerateFuzzGeometry(FuzzGeometryType type, UINT numTriangles, UINT seed, std::vector<float> &vertices)
+        {
+            std::mt19937 generator(seed);
+            auto randomFloat = [&](float minValue, float maxValue) { return minValue + (generator() / (float)generator.max()) * (maxValue - minValue); };
+            auto randomPoint = [&](float extent) { return float3{ randomFloat(-extent, extent), randomFloat(-extent, extent), randomFloat(-extent, extent) }; };
+
+            vertices.clear();
+            for (UINT i = 0; i < numTriangles; i++)
+            {
+                float3 v[3];
+                const float3 center = randomPoint(100.0f);
+                switch (type)
+                {
+                case FuzzUniform:
+                    for (auto &vertex : v)
+                    {
+                        vertex = center + randomPoint(5.0f);
+                    }
+                    break;
+                case FuzzDegenerate:
+                    // Points, collinear vertices, exact duplicates and slivers
+                    v[0] = center;
+                    v[1] = center + randomPoint(5.0f);
+                    switch (i % 4)
+                    {
+                    case 0:
+                        v[1] = v[2] = v[0];
+                        break;
+                    case 1:
+                        v[2] = (v[0] + v[1]) * 0.5f;
+                        break;
+                    case 2:
+                        if (i >= 3)
+                        {
+                            std::copy(vertices.end() - 9, vertices.end(), &v[0].x);
+                        }
+                        else
+                        {
+                            v[2] = v[1];
+                        }
+                        break;
+                    case 3:
+                        v[2] = v[1] + randomPoint(0.000001f);
+                        break;
+                    }
+                    break;
+                case FuzzCoplanar:
+                    for (auto &vertex : v)
+                    {
+                        vertex = center + randomPoint(5.0f);
+                        vertex.z = 0.0f;
+                    }
+                    break;
+                case FuzzHugeExtent:
+                    // A few triangles span the whole scene, up to a million units out, the rest are a
+                    // unit in size and far apart
+                    for (auto &vertex : v)
+                    {
+                        vertex = (i % 64 == 0) ? randomPoint(1000000.0f) : center * 10000.0f + randomPoint(1.0f);
+                    }
+                    break;
+                }
+
+                for (auto &vertex : v)
+                {
+                    vertices.push_back(vertex.x);
+                    vertices.push_back(vertex.y);
+                    vertices.push_back(vertex.z);
+                }
+            }
+        }
+
+        // Runs every builder over randomized inputs, validates the output and checks tree quality.
+        // PREFER_FAST_TRACE runs treelet reordering which only accepts lower cost treelets, so its
+        // SAH cost must not exceed the PREFER_FAST_BUILD tree built from the same Morton order.
+        TEST_METHOD(FuzzBvhBuildersWithStatistics)
+        {
+            const UINT triangleCounts[] = { 2, 37, 1000 };
+            const UINT numSeeds = 2;
+
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            FallbackLayer::GpuBvh2Builder gpuBuilder(&device, m_d3d12Context.GetTotalLaneCount(), 0);
+            InternalFallbackBuilder gpuBuilderWrapper(&gpuBuilder);
+
+            const wchar_t *builderNames[] = { L"CPU SAH", L"CPU LBVH fast build", L"CPU LBVH fast trace", L"CPU LBVH 63-bit", L"GPU", L"BVH4", L"BVH8" };
+
+            // Mean costs over every case, as measured for the CPU builders plus about 2% headroom,
+            // so a change that makes the trees worse fails here. Update them when a builder gets
+            // better. The GPU builder reorders the treelets of a Morton ordered tree like the CPU
+            // LBVH builder does, so it is only held to the numbers of the LBVH fast build.
+            const float maxMeanSahCost[] = { 11.2f, 13.2f, 10.8f, 10.8f, 13.2f, 6.3f, 4.7f };
+            const float maxMeanEpoCost[] = { 2.08f, 4.1f, 2.24f, 2.24f, 4.1f, 1.17f, 1.0f };
+            static_assert(ARRAYSIZE(maxMeanSahCost) == ARRAYSIZE(builderNames) && ARRAYSIZE(maxMeanEpoCost) == ARRAYSIZE(builderNames), L"Every builder needs a cost threshold");
+
+            double totalSahCost[ARRAYSIZE(builderNames)] = {};
+            double totalEpoCost[ARRAYSIZE(builderNames)] = {};
+            UINT numCases = 0;
+            for (UINT type = 0; type < NumFuzzGeometryTypes; type++)
+            {
+                for (UINT numTriangles : triangleCounts)
+                {
+                    for (UINT seed = 0; seed < numSeeds; seed++)
+                    {
+                        std::vector<float> vertices;
+                        GenerateFuzzGeometry((FuzzGeometryType)type, numTriangles, seed * 7919 + numTriangles, vertices);
+
+                        // The CPU SAH builder only reads 16-bit index buffers
+                        std::vector<UINT16> indices(numTriangles * 3);
+                        for (UINT i = 0; i < indices.size(); i++)
+                        {
+                            indices[i] = (UINT16)i;
+                        }
+                        CpuGeometryDescriptor geomDesc(vertices.data(), (UINT)(vertices.size() / 3), indices.data(), (UINT)indices.size());
+
+                        std::unique_ptr<BYTE[]> pGpuData;
+                        BuildBottomLevelAccelerationStructureAndGetCpuData(gpuBuilderWrapper, &geomDesc, 1, pGpuData,
+                            D3D12_ELEMENTS_LAYOUT_ARRAY, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE);
+
+                        struct BuildResult
+                        {
+                            AccelerationStructureLayoutType LayoutType;
+                            std::unique_ptr<BYTE[]> pData;
+                        };
+                        BuildResult results[] =
+                        {
+                            { BVH2, BuildBottomLevelOnCpu(&geomDesc, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE, false, true) },
+                            { BVH2, BuildBottomLevelOnCpu(&geomDesc, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD) },
+                            { BVH2, BuildBottomLevelOnCpu(&geomDesc, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE) },
+                            { BVH2, BuildBottomLevelOnCpu(&geomDesc, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE, true) },
+                            { BVH2, std::move(pGpuData) },
+                            { CompressedBVH4, BuildCompressedWideBvh(CompressedBVH4, &geomDesc, 1) },
+                            { CompressedBVH8, BuildCompressedWideBvh(CompressedBVH8, &geomDesc, 1) },
+                        };
+
+                        BvhStatistics stats[ARRAYSIZE(results)];
+                        for (UINT i = 0; i < ARRAYSIZE(results); i++)
+                        {
+                            stats[i] = VerifyAndComputeStatistics(results[i].LayoutType, &geomDesc, 1, results[i].pData.get());
+                            Assert::AreEqual(numTriangles, stats[i].NumPrimitives, L"Statistics don't cover every triangle");
+                            totalSahCost[i] += stats[i].SahCost;
+                            totalEpoCost[i] += stats[i].EpoCost;
+
+                            std::wstringstream message;
+                            message << L"Geometry type " << type << L", seed " << seed << L", " << builderNames[i] << L": " << BvhStatisticsToString(stats[i]);
+                            Logger::WriteMessage(message.str().c_str());
+                        }
+                        Assert::IsTrue(stats[2].SahCost <= stats[1].SahCost * 1.001f, L"Treelet reordering made the SAH cost worse");
+                        numCases++;
+                    }
+                }
+            }
+
+            for (UINT i = 0; i < ARRAYSIZE(builderNames); i++)
+            {
+                const double meanSahCost = totalSahCost[i] / numCases;
+                const double meanEpoCost = totalEpoCost[i] / numCases;
+                std::wstringstream message;
+                message << builderNames[i] << L": mean SAH cost " << meanSahCost << L", mean EPO cost " << meanEpoCost << L"\n";
+                Logger::WriteMessage(message.str().c_str());
+
+                Assert::IsTrue(meanSahCost <= maxMeanSahCost[i], (std::wstring(builderNames[i]) + L" has a higher mean SAH cost than checked in").c_str());
+                Assert::IsTrue(meanEpoCost <= maxMeanEpoCost[i], (std::wstring(builderNames[i]) + L" has a higher mean EPO cost than checked in").c_str());
+            }
+        }
+
+        TEST_METHOD(OptimizeCpuBuiltBvhTreelets)
+        {
+            const UINT numTriangles = 1000;
+            const UINT numOptimizationPasses = 4;
+            for (UINT type = 0; type < NumFuzzGeometryTypes; type++)
+            {
+                std::vector<float> vertices;
+                GenerateFuzzGeometry((FuzzGeometryType)type, numTriangles, type, vertices);
+
+                std::vector<UINT16> indices(numTriangles * 3);
+                for (UINT i = 0; i < indices.size(); i++)
+                {
+                    indices[i] = (UINT16)i;
+                }
+                CpuGeometryDescriptor geomDesc(vertices.data(), (UINT)(vertices.size() / 3), indices.data(), (UINT)indices.size());
+
+                // The LBVH tree is the one with the most to gain
+                std::unique_ptr<BYTE[]> builds[] =
+                {
+                    BuildBottomLevelOnCpu(&geomDesc, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE, false, true),
+                    BuildBottomLevelOnCpu(&geomDesc, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD),
+                };
+                for (UINT buildIndex = 0; buildIndex < ARRAYSIZE(builds); buildIndex++)
+                {
+                    std::vector<float> sahCostPerPass;
+                    OptimizeAccelerationStructureOnCpu(builds[buildIndex].get(), numOptimizationPasses, &sahCostPerPass);
+
+                    Assert::IsTrue(sahCostPerPass.size() >= 2 && sahCostPerPass.size() <= numOptimizationPasses + 1, L"Unexpected number of SAH costs reported");
+                    std::wstringstream message;
+                    message << L"Geometry type " << type << (buildIndex == 0 ? L", CPU SAH" : L", CPU LBVH") << L" SAH cost per pass:";
+                    for (UINT pass = 0; pass < sahCostPerPass.size(); pass++)
+                    {
+                        message << L" " << sahCostPerPass[pass];
+                        if (pass > 0)
+                        {
+                            Assert::IsTrue(sahCostPerPass[pass] <= sahCostPerPass[pass - 1] * 1.0001f, L"Treelet optimization made the SAH cost worse");
+                        }
+                    }
+                    message << L"\n";
+                    Logger::WriteMessage(message.str().c_str());
+
+                    BvhStatistics stats = VerifyAndComputeStatistics(BVH2, &geomDesc, 1, builds[buildIndex].get());
+                    Assert::AreEqual(sahCostPerPass.back(), stats.SahCost, sahCostPerPass.back() * 0.01f, L"Reported SAH cost doesn't match the optimized tree");
+                    if (buildIndex == 1 && type == FuzzUniform)
+                    {
+                        Assert::IsTrue(sahCostPerPass.back() < sahCostPerPass.front(), L"Treelet optimization didn't improve an LBVH tree");
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(OptimizeCpuBuiltBvhTreeletsOnSeveralThreads)
+        {
+            // Enough leaves for the treelets to be split across threads
+            const UINT numTriangles = 20000;
+            const UINT numOptimizationPasses = 2;
+            std::vector<float> vertices;
+            GenerateFuzzGeometry(FuzzUniform, numTriangles, 0, vertices);
+
+            std::vector<UINT32> indices(numTriangles * 3);
+            for (UINT i = 0; i < indices.size(); i++)
+            {
+                indices[i] = i;
+            }
+            CpuGeometryDescriptor geomDesc(vertices.data(), (UINT)(vertices.size() / 3), indices.data(), (UINT)indices.size());
+
+            std::unique_ptr<BYTE[]> pParallel = BuildBottomLevelOnCpu(&geomDesc, 1, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD);
+            const UINT totalSize = ((const BVHOffsets *)pParallel.get())->totalSize;
+            std::unique_ptr<BYTE[]> pSerial(new BYTE[totalSize]);
+            memcpy(pSerial.get(), pParallel.get(), totalSize);
+
+            // Subtrees are disjoint, so the threads must produce exactly the tree of a single thread
+            std::vector<float> parallelSahCostPerPass, serialSahCostPerPass;
+            OptimizeAccelerationStructureOnCpu(pParallel.get(), numOptimizationPasses, &parallelSahCostPerPass);
+            OptimizeAccelerationStructureOnCpu(pSerial.get(), numOptimizationPasses, &serialSahCostPerPass, true);
+
+            Assert::IsTrue(parallelSahCostPerPass == serialSahCostPerPass, L"Threads reported different SAH costs than a single thread");
+            Assert::IsTrue(memcmp(pParallel.get(), pSerial.get(), totalSize) == 0, L"Threads built a different tree than a single thread");
+            Assert::IsTrue(parallelSahCostPerPass.back() < parallelSahCostPerPass.front(), L"Treelet optimization didn't improve an LBVH tree");
+            VerifyAndComputeStatistics(BVH2, &geomDesc, 1, pParallel.get());
+        }
+
+        void CreateAccelerationStructureBuffer(UINT64 size, ID3D12Resource **ppResource)
+        {
+            auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+            auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            AssertSucceeded(m_d3d12Context.GetDevice().CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(ppResource)));
+        }
+
+        // Serializes a top-level acceleration structure, replaces the instance pointers in the serialized
+        // data with patchedPointers and deserializes the result into a buffer the size of the source.
+        void SerializeAndDeserializeTopLevel(
+            FallbackLayer::IAccelerationStructureBuilder &builder,
+            ID3D12Resource *pTopLevelResource,
+            UINT numInstances,
+            std::vector<WRAPPED_GPU_POINTER> &patchedPointers,
+            ID3D12Resource **ppDeserializedResource)
+        {
+            const UINT topLevelSize = (UINT)pTopLevelResource->GetDesc().Width;
+            std::unique_ptr<BYTE[]> pTopLevelData(new BYTE[topLevelSize]);
+            m_d3d12Context.ReadbackResource(pTopLevelResource, pTopLevelData.get(), topLevelSize);
+
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION_DESC serializationInfo;
+            {
+                CComPtr<ID3D12Resource> pPostbuildInfoBuffer;
+                CreateAccelerationStructureBuffer(sizeof(serializationInfo), &pPostbuildInfoBuffer);
+
+                CComPtr<ID3D12GraphicsCommandList> pCommandList;
+                m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+
+                D3D12_GPU_VIRTUAL_ADDRESS topLevelGpuVA = pTopLevelResource->GetGPUVirtualAddress();
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildDesc = {};
+                postbuildDesc.DestBuffer = pPostbuildInfoBuffer->GetGPUVirtualAddress();
+                postbuildDesc.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION;
+                builder.EmitRaytracingAccelerationStructurePostbuildInfo(pCommandList, &postbuildDesc, 1, &topLevelGpuVA);
+
+                AssertSucceeded(pCommandList->Close());
+                m_d3d12Context.ExecuteCommandList(pCommandList);
+                m_d3d12Context.ReadbackResource(pPostbuildInfoBuffer, &serializationInfo, sizeof(serializationInfo));
+            }
+            Assert::IsTrue(serializationInfo.NumBottomLevelAccelerationStructurePointers == numInstances, L"Incorrect pointer count returned from EmitRaytracingAccelerationStructurePostBuildInfo");
+
+            const UINT serializedSize = (UINT)serializationInfo.SerializedSizeInBytes;
+            std::unique_ptr<BYTE[]> pSerializedData(new BYTE[serializedSize]);
+            {
+                CComPtr<ID3D12Resource> pSerializedResource;
+                CreateAccelerationStructureBuffer(serializedSize, &pSerializedResource);
+
+                CComPtr<ID3D12GraphicsCommandList> pCommandList;
+                m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+                builder.CopyRaytracingAccelerationStructure(
+                    pCommandList,
+                    pSerializedResource->GetGPUVirtualAddress(),
+                    pTopLevelResource->GetGPUVirtualAddress(),
+                    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE);
+
+                AssertSucceeded(pCommandList->Close());
+                m_d3d12Context.ExecuteCommandList(pCommandList);
+                m_d3d12Context.ReadbackResource(pSerializedResource, pSerializedData.get(), serializedSize);
+            }
+
+            const auto &header = *(const D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER *)pSerializedData.get();
+            Assert::IsTrue(header.SerializedSizeInBytesIncludingHeader == serializedSize, L"Serialized size doesn't match the postbuild info");
+            Assert::IsTrue(header.NumBottomLevelAccelerationStructurePointersAfterHeader == numInstances, L"Serialized pointer count doesn't match the number of instances");
+            Assert::IsTrue(header.DeserializedSizeInBytes <= topLevelSize, L"Deserialized size is larger than the source acceleration structure");
+            Assert::IsTrue(builder.CheckDriverMatchingIdentifier(D3D12_SERIALIZED_DATA_RAYTRACING_ACCELERATION_STRUCTURE, &header.DriverMatchingIdentifier) ==
+                D3D12_DRIVER_MATCHING_IDENTIFIER_COMPATIBLE_WITH_DEVICE, L"Serialized data isn't recognized by the device that wrote it");
+
+            const BYTE *pSerializedBVH = pSerializedData.get() + GetOffsetToSerializedBVH(numInstances);
+            Assert::IsTrue(memcmp(pSerializedBVH, pTopLevelData.get(), (size_t)header.DeserializedSizeInBytes) == 0, L"Serialized BVH doesn't match the source acceleration structure");
+
+            const BVHOffsets &offsets = *(const BVHOffsets *)pTopLevelData.get();
+            const BVHMetadata *pMetadata = (const BVHMetadata *)(pTopLevelData.get() + offsets.offsetToVertices);
+            WRAPPED_GPU_POINTER *pSerializedPointers = (WRAPPED_GPU_POINTER *)(pSerializedData.get() + sizeof(header));
+            patchedPointers.resize(numInstances);
+            for (UINT i = 0; i < numInstances; i++)
+            {
+                Assert::IsTrue(pSerializedPointers[i].GpuVA == pMetadata[i].instanceDesc.AccelerationStructure.GpuVA, L"Serialized pointer doesn't match the instance desc");
+
+                patchedPointers[i].EmulatedGpuPtr.OffsetInBytes = i * 256;
+                patchedPointers[i].EmulatedGpuPtr.DescriptorHeapIndex = numInstances - i;
+                pSerializedPointers[i] = patchedPointers[i];
+            }
+
+            CComPtr<ID3D12Resource> pUploadResource;
+            m_d3d12Context.CreateResourceWithInitialData(pSerializedData.get(), serializedSize, &pUploadResource);
+
+            CComPtr<ID3D12Resource> pPatchedSerializedResource;
+            CreateAccelerationStructureBuffer(serializedSize, &pPatchedSerializedResource);
+            CreateAccelerationStructureBuffer(topLevelSize, ppDeserializedResource);
+
+            CComPtr<ID3D12GraphicsCommandList> pCommandList;
+            m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+            pCommandList->CopyBufferRegion(pPatchedSerializedResource, 0, pUploadResource, 0, serializedSize);
+
+            auto transitionBarrier = CD3DX12_RESOURCE_BARRIER::Transition(pPatchedSerializedResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            pCommandList->ResourceBarrier(1, &transitionBarrier);
+
+            builder.CopyRaytracingAccelerationStructure(
+                pCommandList,
+                (*ppDeserializedResource)->GetGPUVirtualAddress(),
+                pPatchedSerializedResource->GetGPUVirtualAddress(),
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE);
+
+            auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+            pCommandList->ResourceBarrier(1, &uavBarrier);
+
+            AssertSucceeded(pCommandList->Close());
+            m_d3d12Context.ExecuteCommandList(pCommandList);
+            m_d3d12Context.WaitForGpuWork();
+        }
+
         template <UINT numBottomLevels>
         void SimpleTopLevelGpuBVHBuilder(
             D3D12_ELEMENTS_LAYOUT layoutToTest,
             bool applyRandomInstanceTransforms,
             bool testCopyAccelerationStructure = false,
-            bool testWithUpdate = false) {
+            bool testWithUpdate = false,
+            bool testSerialization = false) {
             const UINT referenceVertexArraySize = ARRAYSIZE(ReferenceVerticies0);
             const UINT referenceIndexArraySize = ARRAYSIZE(ReferenceIndices0);
 
@@ -869,6 +1624,13 @@ namespace FallbackLayerUnitTests
                 pResourceToReadback = pTopLevelCopy;
             }
 
+            std::vector<WRAPPED_GPU_POINTER> patchedPointers;
+            CComPtr<ID3D12Resource> pDeserializedTopLevel;
+            if (testSerialization)
+            {
+                SerializeAndDeserializeTopLevel(*pBuilder, pTopLevelResource, numBottomLevels, patchedPointers, &pDeserializedTopLevel);
+                pResourceToReadback = pDeserializedTopLevel;
+            }
 
             std::unique_ptr<BYTE[]> pData = std::unique_ptr<BYTE[]>(new BYTE[dataSize]);
             Assert::AreNotEqual(pData.get(), (BYTE *)nullptr, L"Failed to allocate output data");
@@ -879,6 +1641,16 @@ namespace FallbackLayerUnitTests
             if (!validator.VerifyTopLevelOutput(containingBoxes, applyRandomInstanceTransforms ? pTransformations : nullptr, numBottomLevels, pData.get(), errorMessage)) {
                 Assert::Fail(errorMessage.c_str());
             }
+
+            if (testSerialization)
+            {
+                const BVHOffsets &offsets = *(const BVHOffsets *)pData.get();
+                const BVHMetadata *pMetadata = (const BVHMetadata *)(pData.get() + offsets.offsetToVertices);
+                for (UINT i = 0; i < numBottomLevels; i++)
+                {
+                    Assert::IsTrue(pMetadata[i].instanceDesc.AccelerationStructure.GpuVA == patchedPointers[i].GpuVA, L"Deserialized instance desc doesn't point to the patched bottom level");
+                }
+            }
         }
 
         TEST_METHOD(SimpleTopLevelGpuBVHBuilderSingleBottomLevel)
@@ -891,6 +1663,16 @@ namespace FallbackLayerUnitTests
             SimpleTopLevelGpuBVHBuilder<50>(D3D12_ELEMENTS_LAYOUT_ARRAY, false, true);
         }
 
+        TEST_METHOD(SimpleTopLevelGpuBVHBuilderSingleBottomLevelWithSerialization)
+        {
+            SimpleTopLevelGpuBVHBuilder<1>(D3D12_ELEMENTS_LAYOUT_ARRAY, false, false, false, true);
+        }
+
+        TEST_METHOD(TopLevelGpuBVHBuilderWithInstanceTransformsWithSerialization)
+        {
+            SimpleTopLevelGpuBVHBuilder<50>(D3D12_ELEMENTS_LAYOUT_ARRAY, true, false, false, true);
+        }
+
         TEST_METHOD(SimpleTopLevelGpuBVHBuilder_ArrayLayout) {
             SimpleTopLevelGpuBVHBuilder<50>(D3D12_ELEMENTS_LAYOUT_ARRAY, false);
         }
@@ -1341,14 +2123,60 @@ namespace FallbackLayerUnitTests
             }
         }
 
-        void TestCpuBvh2Builder(CpuGeometryDescriptor *pGeomDescs, UINT numGeoms, D3D12_ELEMENTS_LAYOUT layoutToTest = D3D12_ELEMENTS_LAYOUT_ARRAY)
+        void TestCpuBvh2Builder(CpuGeometryDescriptor *pGeomDescs, UINT numGeoms, D3D12_ELEMENTS_LAYOUT layoutToTest = D3D12_ELEMENTS_LAYOUT_ARRAY)
+        {
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
+                std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder>(
+                    new FallbackLayer::GpuBvh2Builder(&device, m_d3d12Context.GetTotalLaneCount(), 0));
+            InternalFallbackBuilder builderWrapper(pBuilder.get());
+
+            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geomDescs(numGeoms);
+            for (UINT i = 0; i < numGeoms; i++)
+            {
+                geomDescs[i].Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+                auto &triangleDesc = geomDescs[i].Triangles;
+                triangleDesc.IndexBuffer = (D3D12_GPU_VIRTUAL_ADDRESS)pGeomDescs[i].m_pIndexBuffer;
+                triangleDesc.VertexBuffer.StartAddress = (D3D12_GPU_VIRTUAL_ADDRESS)pGeomDescs[i].m_pVertexData;
+                triangleDesc.IndexFormat = pGeomDescs[i].m_indexBufferFormat;
+                triangleDesc.IndexCount = pGeomDescs[i].m_numIndicies;
+                triangleDesc.VertexCount = pGeomDescs[i].m_numVerticies;
+                triangleDesc.VertexBuffer.StrideInBytes = sizeof(float) * 3;
+            }
+
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+            builderWrapper.GetRaytracingAccelerationStructurePrebuildInfo(&device,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD,
+                numGeoms,
+                geomDescs.data(),
+                &prebuildInfo);
+            std::unique_ptr<BYTE[]> pData = std::unique_ptr<BYTE[]>(new BYTE[prebuildInfo.ResultDataMaxSizeInBytes]);
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs = desc.Inputs;
+            inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            inputs.NumDescs = numGeoms;
+            inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            inputs.pGeometryDescs = geomDescs.data();
+
+            BuildRaytracingAccelerationStructureOnCpu(&desc, pData.get());
+            std::wstring errorMessage;
+            auto &validator = FallbackLayer::GetAccelerationStructureValidator(pBuilder->GetAccelerationStructureType());
+            if (!validator.VerifyBottomLevelOutput(pGeomDescs, numGeoms, pData.get(), errorMessage))
+            {
+                Assert::Fail(errorMessage.c_str());
+            }
+        }
+
+        void TestCpuBvh2Builder(CpuGeometryDescriptor &geomDesc)
         {
-            ID3D12Device &device = m_d3d12Context.GetDevice();
-            std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
-                std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder>(
-                    new FallbackLayer::GpuBvh2Builder(&device, m_d3d12Context.GetTotalLaneCount(), 0));
-            InternalFallbackBuilder builderWrapper(pBuilder.get());
+            TestCpuBvh2Builder(&geomDesc, 1);
+        }
 
+        // Geometry descs that point directly at CPU memory, for use with the CPU builders
+        std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> GetCpuTriangleGeometryDescs(CpuGeometryDescriptor *pGeomDescs, UINT numGeoms)
+        {
             std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geomDescs(numGeoms);
             for (UINT i = 0; i < numGeoms; i++)
             {
@@ -1360,12 +2188,31 @@ namespace FallbackLayerUnitTests
                 triangleDesc.IndexCount = pGeomDescs[i].m_numIndicies;
                 triangleDesc.VertexCount = pGeomDescs[i].m_numVerticies;
                 triangleDesc.VertexBuffer.StrideInBytes = sizeof(float) * 3;
+                triangleDesc.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT;
             }
+            return geomDescs;
+        }
+
+        void TestCpuLbvhBuilder(
+            CpuGeometryDescriptor *pGeomDescs,
+            UINT numGeoms,
+            bool bUse63BitMortonCodes = false,
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD)
+        {
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
+                std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder>(
+                    new FallbackLayer::GpuBvh2Builder(&device, m_d3d12Context.GetTotalLaneCount(), 0));
+            InternalFallbackBuilder builderWrapper(pBuilder.get());
 
+            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geomDescs = GetCpuTriangleGeometryDescs(pGeomDescs, numGeoms);
+
+            // The CPU LBVH builder writes the same layout as the GPU builder, so the GPU
+            // builder's prebuild info and validator apply as-is.
             D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
             builderWrapper.GetRaytracingAccelerationStructurePrebuildInfo(&device,
                 D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
-                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD,
+                buildFlags,
                 numGeoms,
                 geomDescs.data(),
                 &prebuildInfo);
@@ -1376,9 +2223,10 @@ namespace FallbackLayerUnitTests
             inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
             inputs.NumDescs = numGeoms;
             inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            inputs.Flags = buildFlags;
             inputs.pGeometryDescs = geomDescs.data();
 
-            BuildRaytracingAccelerationStructureOnCpu(&desc, pData.get());
+            BuildRaytracingAccelerationStructureOnCpuLbvh(&desc, pData.get(), bUse63BitMortonCodes);
             std::wstring errorMessage;
             auto &validator = FallbackLayer::GetAccelerationStructureValidator(pBuilder->GetAccelerationStructureType());
             if (!validator.VerifyBottomLevelOutput(pGeomDescs, numGeoms, pData.get(), errorMessage))
@@ -1387,9 +2235,211 @@ namespace FallbackLayerUnitTests
             }
         }
 
-        void TestCpuBvh2Builder(CpuGeometryDescriptor &geomDesc)
+        void VerifyCpuTopLevelLbvh(
+            const AABB *pReferenceBoxes,
+            const std::vector<D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC> &instanceDescs,
+            const BYTE *pData)
         {
-            TestCpuBvh2Builder(&geomDesc, 1);
+            const UINT numInstances = (UINT)instanceDescs.size();
+            std::vector<float *> ppTransformations(numInstances);
+            for (UINT i = 0; i < numInstances; i++)
+            {
+                ppTransformations[i] = (float *)&instanceDescs[i].Transform[0][0];
+            }
+
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            FallbackLayer::GpuBvh2Builder builder(&device, m_d3d12Context.GetTotalLaneCount(), 0);
+            std::wstring errorMessage;
+            auto &validator = FallbackLayer::GetAccelerationStructureValidator(builder.GetAccelerationStructureType());
+            if (!validator.VerifyTopLevelOutput(pReferenceBoxes, ppTransformations.data(), numInstances, pData, errorMessage))
+            {
+                Assert::Fail(errorMessage.c_str());
+            }
+
+            // Each leaf must carry the current ObjectToWorld of the instance it points at
+            const BVHOffsets &offsets = *(const BVHOffsets *)pData;
+            const BVHMetadata *pMetadata = (const BVHMetadata *)(pData + offsets.offsetToVertices);
+            std::vector<bool> instanceFound(numInstances, false);
+            for (UINT i = 0; i < numInstances; i++)
+            {
+                const UINT instanceIndex = pMetadata[i].InstanceIndex;
+                Assert::IsTrue(instanceIndex < numInstances && !instanceFound[instanceIndex], L"Leaf metadata doesn't reference each instance exactly once");
+                instanceFound[instanceIndex] = true;
+                Assert::IsTrue(memcmp(pMetadata[i].ObjectToWorld, instanceDescs[instanceIndex].Transform, sizeof(pMetadata[i].ObjectToWorld)) == 0, L"Leaf metadata has a stale instance transform");
+            }
+        }
+
+        void TestCpuTopLevelLbvhBuilder(UINT numInstances, D3D12_ELEMENTS_LAYOUT layout)
+        {
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
+                std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder>(
+                    new FallbackLayer::GpuBvh2Builder(&device, m_d3d12Context.GetTotalLaneCount(), 0));
+            InternalFallbackBuilder builderWrapper(pBuilder.get());
+
+            // Build one CPU bottom level per instance, the CPU builders take CPU pointers in place of GPU VAs
+            const UINT referenceVertexArraySize = ARRAYSIZE(ReferenceVerticies0);
+            std::vector<std::vector<float>> vertices(numInstances);
+            std::vector<std::unique_ptr<BYTE[]>> bottomLevels(numInstances);
+            std::vector<AABB> containingBoxes(numInstances);
+            for (UINT level = 0; level < numInstances; level++)
+            {
+                AABB &box = containingBoxes[level];
+                for (UINT axis = 0; axis < 3; axis++)
+                {
+                    box.minArr[axis] = FLT_MAX;
+                    box.maxArr[axis] = -FLT_MAX;
+                }
+
+                for (UINT i = 0; i < referenceVertexArraySize; i++)
+                {
+                    float newInput = ReferenceVerticies0[i] + level;
+                    UINT axis = i % 3;
+                    box.minArr[axis] = std::min(newInput, box.minArr[axis]);
+                    box.maxArr[axis] = std::max(newInput, box.maxArr[axis]);
+                    vertices[level].push_back(newInput);
+                }
+
+                CpuGeometryDescriptor geomDesc(vertices[level].data(), referenceVertexArraySize / 3, ReferenceIndices0, ARRAYSIZE(ReferenceIndices0));
+                std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geomDescs = GetCpuTriangleGeometryDescs(&geomDesc, 1);
+
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+                builderWrapper.GetRaytracingAccelerationStructurePrebuildInfo(&device,
+                    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL,
+                    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE,
+                    1,
+                    geomDescs.data(),
+                    &prebuildInfo);
+                bottomLevels[level] = std::unique_ptr<BYTE[]>(new BYTE[prebuildInfo.ResultDataMaxSizeInBytes]);
+
+                D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+                desc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+                desc.Inputs.NumDescs = 1;
+                desc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+                desc.Inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+                desc.Inputs.pGeometryDescs = geomDescs.data();
+                BuildRaytracingAccelerationStructureOnCpuLbvh(&desc, bottomLevels[level].get());
+            }
+
+            srand(10);
+            std::vector<D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC> instanceDescs(numInstances);
+            std::vector<D3D12_GPU_VIRTUAL_ADDRESS> instanceDescPointers(numInstances);
+            for (UINT i = 0; i < numInstances; i++)
+            {
+                D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC &instanceDesc = instanceDescs[i];
+                ZeroMemory(&instanceDesc, sizeof(instanceDesc));
+                GenerateRandomTranformation(&instanceDesc.Transform[0][0]);
+                instanceDesc.InstanceMask = 0xff;
+                instanceDesc.AccelerationStructure.GpuVA = (D3D12_GPU_VIRTUAL_ADDRESS)bottomLevels[i].get();
+                instanceDescPointers[i] = (D3D12_GPU_VIRTUAL_ADDRESS)&instanceDesc;
+            }
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs = desc.Inputs;
+            inputs.DescsLayout = layout;
+            inputs.NumDescs = numInstances;
+            inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+            inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
+            inputs.InstanceDescs = layout == D3D12_ELEMENTS_LAYOUT_ARRAY ?
+                (D3D12_GPU_VIRTUAL_ADDRESS)instanceDescs.data() :
+                (D3D12_GPU_VIRTUAL_ADDRESS)instanceDescPointers.data();
+
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+            builderWrapper.GetRaytracingAccelerationStructurePrebuildInfo(&device, inputs.Type, inputs.Flags, numInstances, nullptr, &prebuildInfo);
+            std::unique_ptr<BYTE[]> pData = std::unique_ptr<BYTE[]>(new BYTE[prebuildInfo.ResultDataMaxSizeInBytes]);
+
+            BuildRaytracingAccelerationStructureOnCpuLbvh(&desc, pData.get());
+            VerifyCpuTopLevelLbvh(containingBoxes.data(), instanceDescs, pData.get());
+
+            // The builder only refits the updated paths while paths * depth stays within the node count
+            UINT treeDepth = 1;
+            while ((1u << treeDepth) < numInstances)
+            {
+                treeDepth++;
+            }
+            const UINT maxPartialRefitInstances = (2 * numInstances - 1) / treeDepth;
+
+            // Move half as many instances as a partial refit allows, then one more than it allows
+            const UINT numMovedInstances[] = { std::max(maxPartialRefitInstances / 2, 1u), maxPartialRefitInstances + 1 };
+            for (UINT numMoved : numMovedInstances)
+            {
+                if (numMoved > numInstances)
+                {
+                    continue;
+                }
+
+                std::vector<UINT> updatedInstances;
+                for (UINT i = 0; i < numMoved; i++)
+                {
+                    const UINT instanceIndex = (UINT)((UINT64)i * numInstances / numMoved);
+                    GenerateRandomTranformation(&instanceDescs[instanceIndex].Transform[0][0]);
+                    updatedInstances.push_back(instanceIndex);
+                }
+                bool bRefitOnlyUpdatedPaths = false;
+                UpdateTopLevelAccelerationStructureOnCpuLbvh(&desc, updatedInstances.data(), (UINT)updatedInstances.size(), pData.get(), &bRefitOnlyUpdatedPaths);
+                if (numMoved <= maxPartialRefitInstances)
+                {
+                    Assert::IsTrue(bRefitOnlyUpdatedPaths, L"Moving a few instances refit the whole tree");
+                }
+                else
+                {
+                    Assert::IsFalse(bRefitOnlyUpdatedPaths, L"Moving many instances only refit their paths");
+                }
+                VerifyCpuTopLevelLbvh(containingBoxes.data(), instanceDescs, pData.get());
+            }
+
+            // Move every instance and let PERFORM_UPDATE find the changes on its own
+            for (UINT i = 0; i < numInstances; i++)
+            {
+                GenerateRandomTranformation(&instanceDescs[i].Transform[0][0]);
+            }
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC updateDesc = desc;
+            updateDesc.Inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+            updateDesc.SourceAccelerationStructureData = (D3D12_GPU_VIRTUAL_ADDRESS)pData.get();
+            BuildRaytracingAccelerationStructureOnCpuLbvh(&updateDesc, pData.get());
+            VerifyCpuTopLevelLbvh(containingBoxes.data(), instanceDescs, pData.get());
+        }
+
+        std::unique_ptr<BYTE[]> BuildCompressedWideBvh(
+            AccelerationStructureLayoutType layoutType,
+            CpuGeometryDescriptor *pGeomDescs,
+            UINT numGeoms)
+        {
+            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geomDescs = GetCpuTriangleGeometryDescs(pGeomDescs, numGeoms);
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs = desc.Inputs;
+            inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            inputs.NumDescs = numGeoms;
+            inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+            inputs.pGeometryDescs = geomDescs.data();
+
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+            GetCompressedWideBvhPrebuildInfo(layoutType, &inputs, &prebuildInfo);
+            std::unique_ptr<BYTE[]> pData = std::unique_ptr<BYTE[]>(new BYTE[prebuildInfo.ResultDataMaxSizeInBytes]);
+
+            BuildCompressedWideBvhOnCpu(layoutType, &desc, pData.get());
+
+            const BVHOffsets &offsets = *(const BVHOffsets *)pData.get();
+            Assert::IsTrue(offsets.totalSize <= prebuildInfo.ResultDataMaxSizeInBytes, L"Compressed wide BVH is larger than the prebuild info reported");
+            return pData;
+        }
+
+        void TestCompressedWideBvh(CpuGeometryDescriptor *pGeomDescs, UINT numGeoms)
+        {
+            const AccelerationStructureLayoutType layoutTypes[] = { CompressedBVH4, CompressedBVH8 };
+            for (auto layoutType : layoutTypes)
+            {
+                std::unique_ptr<BYTE[]> pData = BuildCompressedWideBvh(layoutType, pGeomDescs, numGeoms);
+
+                std::wstring errorMessage;
+                auto &validator = FallbackLayer::GetAccelerationStructureValidator(layoutType);
+                if (!validator.VerifyBottomLevelOutput(pGeomDescs, numGeoms, pData.get(), errorMessage))
+                {
+                    Assert::Fail(errorMessage.c_str());
+                }
+            }
         }
 
         void TestGpuBvh2Builder(CpuGeometryDescriptor *pGeomDescs, UINT numGeoms, D3D12_ELEMENTS_LAYOUT layoutToTest = D3D12_ELEMENTS_LAYOUT_ARRAY)
@@ -2538,10 +3588,395 @@ namespace FallbackLayerUnitTests
             Assert::IsNotNull(pStateObject->GetShaderIdentifier(stringCopy.c_str()));
         }
 
+        void CreateSimplePipelineStateObject(
+            ID3D12RaytracingFallbackDevice *pRaytracingDevice,
+            const std::wstring &hitGroupExportName,
+            ID3D12RaytracingFallbackStateObject **ppStateObject)
+        {
+            // Every piece of the desc is recreated on each call so that the cache
+            // can only match on contents, never on pointers
+            std::wstring closestHitExportName = L"Hit";
+            std::wstring missExportName = L"Miss";
+            std::wstring rayGenExportName = L"RayGen";
+
+            CD3DX12_DESCRIPTOR_RANGE UAVDescriptor;
+            UAVDescriptor.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+            CD3DX12_ROOT_PARAMETER rootParameters[2];
+            rootParameters[0].InitAsShaderResourceView(0);
+            rootParameters[1].InitAsDescriptorTable(1, &UAVDescriptor);
+            CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(ARRAYSIZE(rootParameters), rootParameters);
+
+            CComPtr<ID3DBlob> pRootSignatureBlob;
+            CComPtr<ID3D12RootSignature> pRootSignature;
+            AssertSucceeded(pRaytracingDevice->D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &pRootSignatureBlob, nullptr));
+            AssertSucceeded(pRaytracingDevice->CreateRootSignature(
+                1,
+                pRootSignatureBlob->GetBufferPointer(),
+                pRootSignatureBlob->GetBufferSize(),
+                IID_PPV_ARGS(&pRootSignature)));
+
+            std::vector<BYTE> library(g_pSimpleRayTracing, g_pSimpleRayTracing + ARRAYSIZE(g_pSimpleRayTracing));
+
+            std::vector<D3D12_STATE_SUBOBJECT> subObjects;
+
+            D3D12_STATE_SUBOBJECT rootSignatureSubObject;
+            rootSignatureSubObject.pDesc = &pRootSignature.p;
+            rootSignatureSubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE;
+            subObjects.push_back(rootSignatureSubObject);
+
+            D3D12_STATE_SUBOBJECT shaderConfigSubObject;
+            D3D12_RAYTRACING_SHADER_CONFIG shaderConfig;
+            shaderConfig.MaxAttributeSizeInBytes = shaderConfig.MaxPayloadSizeInBytes = 8;
+            shaderConfigSubObject.pDesc = &shaderConfig;
+            shaderConfigSubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG;
+            subObjects.push_back(shaderConfigSubObject);
+
+            D3D12_STATE_SUBOBJECT pipelineConfigSubObject;
+            D3D12_RAYTRACING_PIPELINE_CONFIG pipelineConfig;
+            pipelineConfig.MaxTraceRecursionDepth = 2;
+            pipelineConfigSubObject.pDesc = &pipelineConfig;
+            pipelineConfigSubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG;
+            subObjects.push_back(pipelineConfigSubObject);
+
+            D3D12_STATE_SUBOBJECT hitGroupSubObject;
+            D3D12_HIT_GROUP_DESC hitGroupDesc = {};
+            hitGroupDesc.ClosestHitShaderImport = closestHitExportName.c_str();
+            hitGroupDesc.HitGroupExport = hitGroupExportName.c_str();
+            hitGroupSubObject.pDesc = &hitGroupDesc;
+            hitGroupSubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_HIT_GROUP;
+            subObjects.push_back(hitGroupSubObject);
+
+            D3D12_EXPORT_DESC exports[] = {
+                { closestHitExportName.c_str(), nullptr, D3D12_EXPORT_FLAG_NONE },
+                { rayGenExportName.c_str(), nullptr, D3D12_EXPORT_FLAG_NONE },
+                { missExportName.c_str(), nullptr, D3D12_EXPORT_FLAG_NONE },
+            };
+            D3D12_DXIL_LIBRARY_DESC libraryDesc = {};
+            libraryDesc.DXILLibrary = CD3DX12_SHADER_BYTECODE(library.data(), library.size());
+            libraryDesc.NumExports = ARRAYSIZE(exports);
+            libraryDesc.pExports = exports;
+            D3D12_STATE_SUBOBJECT DxilLibrarySubObject = {};
+            DxilLibrarySubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY;
+            DxilLibrarySubObject.pDesc = &libraryDesc;
+            subObjects.push_back(DxilLibrarySubObject);
+
+            D3D12_STATE_OBJECT_DESC stateObject;
+            stateObject.NumSubobjects = (UINT)subObjects.size();
+            stateObject.pSubobjects = subObjects.data();
+            stateObject.Type = D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE;
+
+            AssertSucceeded(pRaytracingDevice->CreateStateObject(&stateObject, IID_PPV_ARGS(ppStateObject)));
+        }
+
+        void AssertSameShaderIdentifiers(ID3D12RaytracingFallbackStateObject *pStateObject1, ID3D12RaytracingFallbackStateObject *pStateObject2)
+        {
+            LPCWSTR exportNames[] = { L"HitGroup", L"RayGen", L"Miss" };
+            for (LPCWSTR exportName : exportNames)
+            {
+                void *pIdentifier1 = pStateObject1->GetShaderIdentifier(exportName);
+                void *pIdentifier2 = pStateObject2->GetShaderIdentifier(exportName);
+                Assert::IsNotNull(pIdentifier1);
+                Assert::IsNotNull(pIdentifier2);
+                Assert::IsTrue(memcmp(pIdentifier1, pIdentifier2, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES) == 0, L"Cached state object has different shader identifiers");
+            }
+        }
+
+        TEST_METHOD(StateObjectCacheTesting)
+        {
+            WCHAR tempPath[MAX_PATH];
+            Assert::IsTrue(GetTempPathW(ARRAYSIZE(tempPath), tempPath) != 0);
+            std::wstring cacheDirectory = std::wstring(tempPath) + L"FallbackLayerStateObjectCacheTest";
+            CreateDirectoryW(cacheDirectory.c_str(), nullptr);
+            WCHAR cacheFilePattern[MAX_PATH];
+            swprintf_s(cacheFilePattern, L"%s\\*.fbso", cacheDirectory.c_str());
+            WIN32_FIND_DATAW findData;
+            HANDLE hFind = FindFirstFileW(cacheFilePattern, &findData);
+            if (hFind != INVALID_HANDLE_VALUE)
+            {
+                do
+                {
+                    DeleteFileW((cacheDirectory + L"\\" + findData.cFileName).c_str());
+                } while (FindNextFileW(hFind, &findData));
+                FindClose(hFind);
+            }
+
+            CComPtr<ID3D12RaytracingFallbackStateObject> pFirstStateObject;
+            {
+                CComPtr<ID3D12RaytracingFallbackDevice> rayTracingDevice;
+                AssertSucceeded(D3D12CreateRaytracingFallbackDevice(
+                    &m_d3d12Context.GetDevice(),
+                    CreateRaytracingFallbackDeviceFlags::ForceComputeFallback,
+                    0,
+                    IID_PPV_ARGS(&rayTracingDevice)));
+                rayTracingDevice->SetStateObjectCacheDirectory(cacheDirectory.c_str());
+
+                CComPtr<ID3D12RaytracingFallbackStateObject> pSecondStateObject, pRenamedStateObject;
+                CreateSimplePipelineStateObject(rayTracingDevice, L"HitGroup", &pFirstStateObject);
+                CreateSimplePipelineStateObject(rayTracingDevice, L"HitGroup", &pSecondStateObject);
+                CreateSimplePipelineStateObject(rayTracingDevice, L"RenamedHitGroup", &pRenamedStateObject);
+
+                D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS statistics;
+                rayTracingDevice->GetStateObjectCacheStatistics(&statistics);
+                Assert::AreEqual(3ull, statistics.NumLookups);
+                Assert::AreEqual(1ull, statistics.NumMemoryHits, L"Identical state objects should share a linked program");
+                Assert::AreEqual(2ull, statistics.NumLinks, L"Changing an export name should produce a new cache entry");
+                Assert::IsTrue(statistics.TotalLinkTimeInMilliseconds > 0.0);
+
+                AssertSameShaderIdentifiers(pFirstStateObject, pSecondStateObject);
+                Assert::IsNotNull(pRenamedStateObject->GetShaderIdentifier(L"RenamedHitGroup"));
+                Assert::IsNull(pRenamedStateObject->GetShaderIdentifier(L"HitGroup"));
+            }
+
+            // A new device starts with an empty memory cache but finds the linked program on disk
+            {
+                CComPtr<ID3D12RaytracingFallbackDevice> rayTracingDevice;
+                AssertSucceeded(D3D12CreateRaytracingFallbackDevice(
+                    &m_d3d12Context.GetDevice(),
+                    CreateRaytracingFallbackDeviceFlags::ForceComputeFallback,
+                    0,
+                    IID_PPV_ARGS(&rayTracingDevice)));
+                rayTracingDevice->SetStateObjectCacheDirectory(cacheDirectory.c_str());
+
+                CComPtr<ID3D12RaytracingFallbackStateObject> pStateObject;
+                CreateSimplePipelineStateObject(rayTracingDevice, L"HitGroup", &pStateObject);
+
+                D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS statistics;
+                rayTracingDevice->GetStateObjectCacheStatistics(&statistics);
+                Assert::AreEqual(1ull, statistics.NumDiskHits);
+                Assert::AreEqual(0ull, statistics.NumLinks);
+
+                AssertSameShaderIdentifiers(pFirstStateObject, pStateObject);
+            }
+        }
+
 
         D3D12Context m_d3d12Context;
     };
 
+    // Parses state objects on the CPU only, no device is created. DXIL libraries are
+    // stood in for by synthetic runtime data (RDAT) blobs, so arbitrarily large
+    // libraries can be generated without invoking the compiler.
+    TEST_CLASS(StateObjectParsingTests)
+    {
+    public:
+        // Layout of the synthetic "bytecode": the RDAT size followed by the RDAT blob itself
+        static HRESULT GetSyntheticRuntimeData(const void *pShaderByteCode, const UINT **ppRuntimeData, UINT *pRuntimeDataSizeInBytes)
+        {
+            const UINT *pHeader = (const UINT *)pShaderByteCode;
+            *pRuntimeDataSizeInBytes = pHeader[0];
+            *ppRuntimeData = pHeader + 1;
+            return S_OK;
+        }
+
+        static std::wstring MangledName(const std::wstring &unmangledName)
+        {
+            return L"\x01?" + unmangledName + L"@@YAXXZ";
+        }
+
+        // Every 4th function is a shader entry point, alternating between closest hit and miss,
+        // the rest are library functions. Each function calls the next two library functions after it,
+        // so the call graph is a deep DAG with shared subtrees.
+        static std::vector<UINT> CreateSyntheticLibrary(UINT numFunctions, std::vector<std::wstring> &closestHitNames)
+        {
+            auto isLibraryFunction = [](UINT i) { return (i % 4) != 0; };
+            auto functionName = [&](UINT i) { return (isLibraryFunction(i) ? L"Helper" : ((i / 4) % 2 ? L"Miss" : L"ClosestHit")) + std::to_wstring(i); };
+
+            std::string strings(1, '\0');
+            auto addString = [&strings](const std::wstring &string)
+            {
+                UINT offset = (UINT)strings.size();
+                strings.append(string.begin(), string.end());
+                strings.push_back('\0');
+                return offset;
+            };
+
+            std::vector<UINT> indices;
+            std::vector<RuntimeDataFunctionInfo> functions(numFunctions);
+            for (UINT i = 0; i < numFunctions; i++)
+            {
+                RuntimeDataFunctionInfo &function = functions[i];
+                function = {};
+                const std::wstring unmangledName = functionName(i);
+                function.UnmangledName = addString(unmangledName);
+                function.Name = isLibraryFunction(i) ? addString(MangledName(unmangledName)) : function.UnmangledName;
+                function.Resources = UINT_MAX;
+                function.ShaderKind = (UINT)(isLibraryFunction(i) ? ShaderKind::Library : ((i / 4) % 2 ? ShaderKind::Miss : ShaderKind::ClosestHit));
+                if (function.ShaderKind == (UINT)ShaderKind::ClosestHit)
+                {
+                    closestHitNames.push_back(unmangledName);
+                }
+
+                std::vector<UINT> dependencies;
+                for (UINT callee = i + 1; callee < numFunctions && dependencies.size() < 2; callee++)
+                {
+                    if (isLibraryFunction(callee))
+                    {
+                        dependencies.push_back(addString(MangledName(functionName(callee))));
+                    }
+                }
+                function.FunctionDependencies = UINT_MAX;
+                if (dependencies.size())
+                {
+                    function.FunctionDependencies = (UINT)indices.size();
+                    indices.push_back((UINT)dependencies.size());
+                    indices.insert(indices.end(), dependencies.begin(), dependencies.end());
+                }
+            }
+            strings.resize((strings.size() + 3) & ~3);
+
+            const UINT numParts = 3;
+            const UINT stringPartSize = (UINT)strings.size();
+            const UINT indexPartSize = (UINT)(indices.size() * sizeof(UINT));
+            const UINT functionPartSize = (UINT)(functions.size() * sizeof(RuntimeDataFunctionInfo));
+
+            // Leading UINT is the RDAT size, see GetSyntheticRuntimeData
+            std::vector<UINT> blob(1 + (sizeof(RuntimeDataHeader) + numParts * sizeof(UINT)) / sizeof(UINT));
+            blob[1] = RDAT_Version_0;
+            blob[2] = numParts;
+            auto addPart = [&blob](UINT partIndex, RuntimeDataPartType type, const void *pData, UINT size, const void *pTableHeader = nullptr)
+            {
+                blob[3 + partIndex] = (UINT)((blob.size() - 1) * sizeof(UINT));
+                blob.push_back((UINT)type);
+                blob.push_back(size + (pTableHeader ? sizeof(RuntimeDataTableHeader) : 0));
+                if (pTableHeader)
+                {
+                    const UINT *pTableHeaderData = (const UINT *)pTableHeader;
+                    blob.insert(blob.end(), pTableHeaderData, pTableHeaderData + sizeof(RuntimeDataTableHeader) / sizeof(UINT));
+                }
+                const UINT *pPartData = (const UINT *)pData;
+                blob.insert(blob.end(), pPartData, pPartData + size / sizeof(UINT));
+            };
+            const RuntimeDataTableHeader functionTable = { (UINT)functions.size(), sizeof(RuntimeDataFunctionInfo) };
+            addPart(0, RuntimeDataPartType::StringBuffer, strings.data(), stringPartSize);
+            addPart(1, RuntimeDataPartType::IndexArrays, indices.data(), indexPartSize);
+            addPart(2, RuntimeDataPartType::FunctionTable, functions.data(), functionPartSize, &functionTable);
+            blob[0] = (UINT)((blob.size() - 1) * sizeof(UINT));
+            return blob;
+        }
+
+        TEST_METHOD(LargeLibraryParsingBenchmark)
+        {
+            const UINT numFunctions = 10000;
+            const UINT numIterations = 5;
+
+            std::vector<std::wstring> closestHitNames;
+            std::vector<UINT> library = CreateSyntheticLibrary(numFunctions, closestHitNames);
+
+            std::vector<std::wstring> hitGroupNames;
+            std::vector<D3D12_HIT_GROUP_DESC> hitGroups(closestHitNames.size());
+            hitGroupNames.reserve(closestHitNames.size());
+            for (size_t i = 0; i < closestHitNames.size(); i++)
+            {
+                hitGroupNames.push_back(L"HitGroup" + std::to_wstring(i));
+                hitGroups[i] = {};
+                hitGroups[i].HitGroupExport = hitGroupNames.back().c_str();
+                hitGroups[i].Type = D3D12_HIT_GROUP_TYPE_TRIANGLES;
+                hitGroups[i].ClosestHitShaderImport = closestHitNames[i].c_str();
+            }
+
+            D3D12_DXIL_LIBRARY_DESC libraryDesc = {};
+            libraryDesc.DXILLibrary = CD3DX12_SHADER_BYTECODE(library.data(), library.size() * sizeof(UINT));
+            D3D12_RAYTRACING_SHADER_CONFIG shaderConfig = { 16, 8 };
+            D3D12_RAYTRACING_PIPELINE_CONFIG pipelineConfig = { 1 };
+
+            std::vector<D3D12_STATE_SUBOBJECT> subobjects;
+            subobjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY, &libraryDesc });
+            subobjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG, &shaderConfig });
+            subobjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG, &pipelineConfig });
+            for (auto &hitGroup : hitGroups)
+            {
+                subobjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_HIT_GROUP, &hitGroup });
+            }
+            D3D12_STATE_OBJECT_DESC stateObjectDesc = { D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE, (UINT)subobjects.size(), subobjects.data() };
+
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            double totalMilliseconds = 0.0;
+            for (UINT iteration = 0; iteration < numIterations; iteration++)
+            {
+                LARGE_INTEGER start, end;
+                QueryPerformanceCounter(&start);
+                std::unique_ptr<CStateObjectInfo> pStateObjectInfo(new CStateObjectInfo());
+                HRESULT hr = pStateObjectInfo->ParseStateObject(&stateObjectDesc, nullptr, GetSyntheticRuntimeData, nullptr);
+                QueryPerformanceCounter(&end);
+                totalMilliseconds += (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart;
+
+                for (auto &message : pStateObjectInfo->GetLog())
+                {
+                    Logger::WriteMessage(message.c_str());
+                }
+                AssertSucceeded(hr);
+
+                CStateObjectInfo::CExportedFunctionIterator exportIterator(pStateObjectInfo.get());
+                Assert::AreEqual((size_t)numFunctions, exportIterator.GetCount());
+                for (UINT i = 0; i < numFunctions; i++)
+                {
+                    EXPORTED_FUNCTION exportedFunction;
+                    exportIterator.Next(&exportedFunction);
+                    Assert::IsFalse(exportedFunction.bUnresolvedFunctions, L"Call graph edge wasn't resolved");
+                    Assert::IsFalse(exportedFunction.bUnresolvedAssociations, L"Default association wasn't applied");
+                }
+
+                CStateObjectInfo::CExportedHitGroupIterator hitGroupIterator(pStateObjectInfo.get());
+                Assert::AreEqual(hitGroups.size(), hitGroupIterator.GetCount());
+
+                // Mangled and unmangled lookups have to land on the same export
+                CStateObjectInfo::CExportedFunctionLookup lookup(pStateObjectInfo.get());
+                lookup.ResetAndSelectExport(L"Helper1");
+                Assert::AreEqual((size_t)1, lookup.GetCount());
+                EXPORTED_FUNCTION unmangledMatch;
+                lookup.Next(&unmangledMatch);
+                lookup.ResetAndSelectExport(MangledName(L"Helper1").c_str());
+                Assert::AreEqual((size_t)1, lookup.GetCount());
+                EXPORTED_FUNCTION mangledMatch;
+                lookup.Next(&mangledMatch);
+                Assert::IsTrue(unmangledMatch.pDXILFunction == mangledMatch.pDXILFunction);
+
+                // Lookups of names the state object never saw don't match anything
+                lookup.ResetAndSelectExport(L"NotAnExport");
+                Assert::AreEqual((size_t)0, lookup.GetCount());
+            }
+
+            std::wstringstream message;
+            message << numFunctions << L" exports, " << hitGroups.size() << L" hit groups: "
+                << totalMilliseconds / numIterations << L" ms per parse\n";
+            Logger::WriteMessage(message.str().c_str());
+        }
+
+        TEST_METHOD(LargeLibraryUnresolvedDependency)
+        {
+            // Only Helper1 is exported, so its call to Helper2 is left with nothing to resolve to
+            std::vector<std::wstring> closestHitNames;
+            std::vector<UINT> library = CreateSyntheticLibrary(10000, closestHitNames);
+
+            std::wstring exportedName = L"Helper1";
+            D3D12_EXPORT_DESC exportDesc = { exportedName.c_str(), nullptr, D3D12_EXPORT_FLAG_NONE };
+            D3D12_DXIL_LIBRARY_DESC libraryDesc = {};
+            libraryDesc.DXILLibrary = CD3DX12_SHADER_BYTECODE(library.data(), library.size() * sizeof(UINT));
+            libraryDesc.NumExports = 1;
+            libraryDesc.pExports = &exportDesc;
+            D3D12_RAYTRACING_SHADER_CONFIG shaderConfig = { 16, 8 };
+            D3D12_RAYTRACING_PIPELINE_CONFIG pipelineConfig = { 1 };
+            D3D12_STATE_SUBOBJECT subobjects[] =
+            {
+                { D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY, &libraryDesc },
+                { D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG, &shaderConfig },
+                { D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG, &pipelineConfig },
+            };
+            D3D12_STATE_OBJECT_DESC stateObjectDesc = { D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE, ARRAYSIZE(subobjects), subobjects };
+
+            CStateObjectInfo stateObjectInfo;
+            Assert::AreEqual(E_INVALIDARG, stateObjectInfo.ParseStateObject(&stateObjectDesc, nullptr, GetSyntheticRuntimeData, nullptr));
+
+            bool bFoundUnresolvedReference = false;
+            for (auto &message : stateObjectInfo.GetLog())
+            {
+                bFoundUnresolvedReference |= (message.find(L"Unresolved reference to function \"Helper2\"") != std::wstring::npos);
+            }
+            Assert::IsTrue(bFoundUnresolvedReference);
+        }
+    };
+
     TEST_CLASS(LBVHBuilderTests)
     {
     public:
@@ -12,20 +12,33 @@
 #include "RayTracingHelper.hlsli"
 #include "GetBVHCompactedSizeBindings.h"
 
-uint GetBVHSize(RWByteAddressBuffer bvh)
+struct PostbuildInfo
 {
-    return bvh.Load(OffsetToTotalSize);
+    uint size;
+    uint numPointers;
+};
+
+PostbuildInfo GetPostbuildInfo(RWByteAddressBuffer bvh)
+{
+    PostbuildInfo info;
+    info.size = bvh.Load(OffsetToTotalSize);
+    info.numPointers = 0;
+    if (Constants.InfoType == PostbuildInfoTypeSerialization)
+    {
+        info.numPointers = GetNumberOfInstances(bvh);
+        info.size += GetOffsetToSerializedBVH(info.numPointers);
+    }
+    return info;
 }
 
-#define GetBVHSize(ID) case ID: size =  GetBVHSize(BVH##ID);  break
+#define GetBVHSize(ID) case ID: info =  GetPostbuildInfo(BVH##ID);  break
 
 [numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
 void main( uint3 DTid : SV_DispatchThreadID )
 {
     if (DTid.x >= Constants.NumberOfBoundBVHs) return;
 
-    uint outputOffset = DTid.x * 4;
-    uint size = 0;
+    PostbuildInfo info = (PostbuildInfo)0;
     switch (DTid.x + 1)
     {
         GetBVHSize(1);
@@ -59,5 +72,12 @@ void main( uint3 DTid : SV_DispatchThreadID )
         GetBVHSize(29);
         GetBVHSize(30);
     }
-    OutputCount.Store(outputOffset, size);
+    if (Constants.InfoType == PostbuildInfoTypeSerialization)
+    {
+        OutputCount.Store4(DTid.x * SizeOfSerializationPostbuildInfo, uint4(info.size, 0, info.numPointers, 0));
+    }
+    else
+    {
+        OutputCount.Store(DTid.x * SizeOfSizePostbuildInfo, info.size);
+    }
 }
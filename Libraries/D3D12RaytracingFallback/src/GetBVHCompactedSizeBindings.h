@@ -16,9 +16,18 @@
 #endif
 
 #define NumberOfReadableBVHsPerDispatch 30
+
+// Compacted and current sizes are written as a uint per BVH, serialization info as
+// D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION_DESC
+#define PostbuildInfoTypeSize 0
+#define PostbuildInfoTypeSerialization 1
+#define SizeOfSizePostbuildInfo 4
+#define SizeOfSerializationPostbuildInfo 16
+
 struct GetBVHCompactedSizeConstants
 {
     uint NumberOfBoundBVHs;
+    uint InfoType;
 };
 
 // UAVs
@@ -333,16 +333,19 @@ namespace FallbackLayer
         _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData,
         _In_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode)
     {
-        if (Mode == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE ||
-            Mode == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT)
-        {
-            m_copyPass.CopyRaytracingAccelerationStructure(pCommandList, DestAccelerationStructureData, SourceAccelerationStructureData);
-        }
-        else
+        switch (Mode)
         {
+        case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE:
+        case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT:
+        case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE:
+        case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE:
+            m_copyPass.CopyRaytracingAccelerationStructure(pCommandList, DestAccelerationStructureData, SourceAccelerationStructureData, Mode);
+            break;
+        default:
             ThrowFailure(E_INVALIDARG,
                 L"The only flags supported for CopyRaytracingAccelerationStructure are: "
-                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE/D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT");
+                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE/D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT/"
+                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE/D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE");
         }
     }
 
@@ -460,8 +463,9 @@ namespace FallbackLayer
         _In_  UINT NumSourceAccelerationStructures,
         _In_reads_(NumSourceAccelerationStructures)  const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData)
     {
-        m_postBuildInfoQuery.GetCompactedBVHSizes(
+        m_postBuildInfoQuery.GetPostbuildInfo(
             pCommandList,
+            pDesc->InfoType,
             pDesc->DestBuffer,
             NumSourceAccelerationStructures,
             pSourceAccelerationStructureData);
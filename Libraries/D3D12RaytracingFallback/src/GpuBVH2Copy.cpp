@@ -22,7 +22,7 @@ GpuBvh2Copy::GpuBvh2Copy(ID3D12Device *pDevice, UINT totalLaneCount, UINT nodeMa
     CD3DX12_ROOT_PARAMETER1 rootParameters[NumParameters];
     rootParameters[DestBvh].InitAsUnorderedAccessView(DestBvhRegister);
     rootParameters[SourceBvh].InitAsUnorderedAccessView(SourceBvhRegister);
-    rootParameters[Constants].InitAsConstants(SizeOfInUint32(DispatchWidthConstant), DispatchWidthConstantsRegister);
+    rootParameters[Constants].InitAsConstants(SizeOfInUint32(GpuBvh2CopyConstants), GpuBvh2CopyConstantsRegister);
     
     auto rootSignatureDesc = CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(ARRAYSIZE(rootParameters), rootParameters);
     CreateRootSignatureHelper(pDevice, rootSignatureDesc, &m_pRootSignature);
@@ -33,12 +33,55 @@ GpuBvh2Copy::GpuBvh2Copy(ID3D12Device *pDevice, UINT totalLaneCount, UINT nodeMa
 void GpuBvh2Copy::CopyRaytracingAccelerationStructure(
     _In_  ID3D12GraphicsCommandList *pCommandList,
     _In_  D3D12_GPU_VIRTUAL_ADDRESS DestAccelerationStructureData,
-    _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData)
+    _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData,
+    _In_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode)
 {
+    GpuBvh2CopyConstants constants = {};
+    constants.DispatchWidth = m_OptimalDispatchWidth;
+    switch (Mode)
+    {
+    case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE:
+    case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT:
+        // BVHs are always built compacted so both are a straight copy
+        constants.CopyMode = GPU_BVH2_COPY_MODE_CLONE;
+        break;
+    case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE:
+        constants.CopyMode = GPU_BVH2_COPY_MODE_SERIALIZE;
+        break;
+    case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE:
+        constants.CopyMode = GPU_BVH2_COPY_MODE_DESERIALIZE;
+        break;
+    default:
+        ThrowFailure(E_INVALIDARG, L"Unrecognized D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE provided");
+    }
+
     pCommandList->SetComputeRootSignature(m_pRootSignature);
     pCommandList->SetPipelineState(m_pPSO);
     pCommandList->SetComputeRootUnorderedAccessView(DestBvh, DestAccelerationStructureData);
     pCommandList->SetComputeRootUnorderedAccessView(SourceBvh, SourceAccelerationStructureData);
-    pCommandList->SetComputeRoot32BitConstant(Constants, m_OptimalDispatchWidth, 0);
+    pCommandList->SetComputeRoot32BitConstants(Constants, SizeOfInUint32(GpuBvh2CopyConstants), &constants, 0);
     pCommandList->Dispatch(m_OptimalDispatchWidth, 1, 1);
 }
+
+D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS GpuBvh2Copy::CheckDriverMatchingIdentifier(
+    _In_  D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+    _In_  const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck)
+{
+    if (SerializedDataType != D3D12_SERIALIZED_DATA_RAYTRACING_ACCELERATION_STRUCTURE)
+    {
+        return D3D12_DRIVER_MATCHING_IDENTIFIER_UNSUPPORTED_TYPE;
+    }
+
+    const UINT expectedGuid[] = { SerializedDriverGUID0, SerializedDriverGUID1, SerializedDriverGUID2, SerializedDriverGUID3 };
+    static_assert(sizeof(expectedGuid) == sizeof(pIdentifierToCheck->DriverOpaqueGUID), "Unexpected size for DriverOpaqueGUID");
+    if (memcmp(&pIdentifierToCheck->DriverOpaqueGUID, expectedGuid, sizeof(expectedGuid)) != 0)
+    {
+        return D3D12_DRIVER_MATCHING_IDENTIFIER_UNRECOGNIZED;
+    }
+
+    UINT version;
+    memcpy(&version, pIdentifierToCheck->DriverOpaqueVersioningData, sizeof(version));
+    return version == SerializedBVHVersion ?
+        D3D12_DRIVER_MATCHING_IDENTIFIER_COMPATIBLE_WITH_DEVICE :
+        D3D12_DRIVER_MATCHING_IDENTIFIER_INCOMPATIBLE_VERSION;
+}
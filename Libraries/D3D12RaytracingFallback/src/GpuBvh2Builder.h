@@ -40,6 +40,13 @@ namespace FallbackLayer
             _In_  UINT NumSourceAccelerationStructures,
             _In_reads_(NumSourceAccelerationStructures)  const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData);
 
+        virtual D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS CheckDriverMatchingIdentifier(
+            _In_  D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+            _In_  const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck)
+        {
+            return GpuBvh2Copy::CheckDriverMatchingIdentifier(SerializedDataType, pIdentifierToCheck);
+        }
+
         virtual AccelerationStructureLayoutType GetAccelerationStructureType() { return BVH2; }
         
     private: 
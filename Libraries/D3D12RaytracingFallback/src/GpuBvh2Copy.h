@@ -18,7 +18,13 @@ public:
     void CopyRaytracingAccelerationStructure(
         _In_  ID3D12GraphicsCommandList *pCommandList,
         _In_  D3D12_GPU_VIRTUAL_ADDRESS DestAccelerationStructureData,
-        _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData);
+        _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData,
+        _In_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode);
+
+    // Checks whether serialized data was written by this version of the copy pass
+    static D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS CheckDriverMatchingIdentifier(
+        _In_  D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+        _In_  const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck);
 
 private:
     enum RootParameterSlot
@@ -14,14 +14,72 @@
 
 static const uint BytesPerLoad = 4;
 
+// Reads a dword of the BVH stored in a serialized acceleration structure. Instance
+// pointers are taken from the list after the serialized header instead of the BVH.
+uint LoadDeserializedBVH(uint offset, uint offsetToSerializedBVH, uint numPointers, uint offsetToInstanceDescs)
+{
+    if (numPointers > 0 && offset >= offsetToInstanceDescs)
+    {
+        const uint instanceIndex = (offset - offsetToInstanceDescs) / SizeOfBVHMetadata;
+        const uint offsetInInstance = (offset - offsetToInstanceDescs) % SizeOfBVHMetadata;
+        if (offsetInInstance >= RaytracingInstanceDescOffsetToPointer &&
+            offsetInInstance < RaytracingInstanceDescOffsetToPointer + SizeOfSerializedPointer)
+        {
+            return SourceBVH.Load(SizeOfSerializedHeader + instanceIndex * SizeOfSerializedPointer + offsetInInstance - RaytracingInstanceDescOffsetToPointer);
+        }
+    }
+    return SourceBVH.Load(offsetToSerializedBVH + offset);
+}
+
 [numthreads(GPU_BVH2_COPY_THREAD_GROUP_WIDTH, 1, 1)]
 void main( uint3 DTid : SV_DispatchThreadID )
 {
-    uint copySizeInBytes = SourceBVH.Load(OffsetToTotalSize);
-    uint offsetToCopy = DTid.x * BytesPerLoad;
-    while (offsetToCopy < copySizeInBytes)
+    const uint threadCount = GPU_BVH2_COPY_THREAD_GROUP_WIDTH * Constants.DispatchWidth;
+    const uint strideInBytes = BytesPerLoad * threadCount;
+
+    if (Constants.CopyMode == GPU_BVH2_COPY_MODE_SERIALIZE)
+    {
+        const uint bvhSize = SourceBVH.Load(OffsetToTotalSize);
+        const uint numInstances = GetNumberOfInstances(SourceBVH);
+        const uint offsetToSerializedBVH = GetOffsetToSerializedBVH(numInstances);
+        if (DTid.x == 0)
+        {
+            DestBVH.Store4(0, uint4(SerializedDriverGUID0, SerializedDriverGUID1, SerializedDriverGUID2, SerializedDriverGUID3));
+            DestBVH.Store4(16, uint4(SerializedBVHVersion, 0, 0, 0));
+            DestBVH.Store2(SerializedHeaderOffsetToSerializedSize, uint2(offsetToSerializedBVH + bvhSize, 0));
+            DestBVH.Store2(SerializedHeaderOffsetToDeserializedSize, uint2(bvhSize, 0));
+            DestBVH.Store2(SerializedHeaderOffsetToNumPointers, uint2(numInstances, 0));
+        }
+
+        const uint offsetToInstanceDescs = SourceBVH.Load(OffsetToLeafNodeMetaDataOffset);
+        for (uint instanceIndex = DTid.x; instanceIndex < numInstances; instanceIndex += threadCount)
+        {
+            DestBVH.Store2(SizeOfSerializedHeader + instanceIndex * SizeOfSerializedPointer,
+                SourceBVH.Load2(offsetToInstanceDescs + instanceIndex * SizeOfBVHMetadata + RaytracingInstanceDescOffsetToPointer));
+        }
+
+        for (uint offsetToCopy = DTid.x * BytesPerLoad; offsetToCopy < bvhSize; offsetToCopy += strideInBytes)
+        {
+            DestBVH.Store(offsetToSerializedBVH + offsetToCopy, SourceBVH.Load(offsetToCopy));
+        }
+    }
+    else if (Constants.CopyMode == GPU_BVH2_COPY_MODE_DESERIALIZE)
+    {
+        const uint bvhSize = SourceBVH.Load(SerializedHeaderOffsetToDeserializedSize);
+        const uint numPointers = SourceBVH.Load(SerializedHeaderOffsetToNumPointers);
+        const uint offsetToSerializedBVH = GetOffsetToSerializedBVH(numPointers);
+        const uint offsetToInstanceDescs = SourceBVH.Load(offsetToSerializedBVH + OffsetToLeafNodeMetaDataOffset);
+        for (uint offsetToCopy = DTid.x * BytesPerLoad; offsetToCopy < bvhSize; offsetToCopy += strideInBytes)
+        {
+            DestBVH.Store(offsetToCopy, LoadDeserializedBVH(offsetToCopy, offsetToSerializedBVH, numPointers, offsetToInstanceDescs));
+        }
+    }
+    else
     {
-        DestBVH.Store(offsetToCopy, SourceBVH.Load(offsetToCopy));
-        offsetToCopy += BytesPerLoad * GPU_BVH2_COPY_THREAD_GROUP_WIDTH * Constants.DispatchWidth;
+        const uint copySizeInBytes = SourceBVH.Load(OffsetToTotalSize);
+        for (uint offsetToCopy = DTid.x * BytesPerLoad; offsetToCopy < copySizeInBytes; offsetToCopy += strideInBytes)
+        {
+            DestBVH.Store(offsetToCopy, SourceBVH.Load(offsetToCopy));
+        }
     }
 }
@@ -22,19 +22,24 @@
 #define SourceBvhRegister 1
 
 // CBVs
-#define DispatchWidthConstantsRegister 0
+#define GpuBvh2CopyConstantsRegister 0
 
-struct DispatchWidthConstant
+#define GPU_BVH2_COPY_MODE_CLONE 0
+#define GPU_BVH2_COPY_MODE_SERIALIZE 1
+#define GPU_BVH2_COPY_MODE_DESERIALIZE 2
+
+struct GpuBvh2CopyConstants
 {
     uint DispatchWidth;
+    uint CopyMode;
 };
 
 #ifdef HLSL
 RWByteAddressBuffer DestBVH : UAV_REGISTER(DestBvhRegister);
 RWByteAddressBuffer SourceBVH : UAV_REGISTER(SourceBvhRegister);
 
-cbuffer DispatchWidthConstant : CONSTANT_REGISTER(DispatchWidthConstantsRegister)
+cbuffer GpuBvh2CopyConstants : CONSTANT_REGISTER(GpuBvh2CopyConstantsRegister)
 {
-    DispatchWidthConstant Constants;
+    GpuBvh2CopyConstants Constants;
 }
 #endif
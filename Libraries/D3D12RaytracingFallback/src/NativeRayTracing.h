@@ -203,6 +203,22 @@ public:
             pInfo);
     }
 
+    virtual D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS STDMETHODCALLTYPE CheckDriverMatchingIdentifier(
+        _In_  D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+        _In_  const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck)
+    {
+        return m_pDevice->CheckDriverMatchingIdentifier(SerializedDataType, pIdentifierToCheck);
+    }
+
+    // State object caching is left to the driver
+    virtual void SetStateObjectCacheDirectory(_In_opt_ LPCWSTR) {}
+
+    virtual void GetStateObjectCacheStatistics(
+        _Out_ D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS *pStatistics)
+    {
+        ZeroMemory(pStatistics, sizeof(*pStatistics));
+    }
+
     virtual void QueryRaytracingCommandList(ID3D12GraphicsCommandList *pCommandList, 
         REFIID riid,
         _COM_Outptr_  void **ppRaytracingCommandList)
@@ -11,6 +11,10 @@
 #include "pch.h"
 
 #include "CompiledShaders/GetBVHCompactedSize.h"
+
+static_assert(sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION_DESC) == SizeOfSerializationPostbuildInfo,
+    "Serialization postbuild info written by GetBVHCompactedSize.hlsl doesn't match the D3D12 desc");
+
 PostBuildInfoQuery::PostBuildInfoQuery(ID3D12Device *pDevice, UINT nodeMask)
 {
     CD3DX12_ROOT_PARAMETER1 parameters[NumParameters];
@@ -27,8 +31,9 @@ PostBuildInfoQuery::PostBuildInfoQuery(ID3D12Device *pDevice, UINT nodeMask)
     CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pGetBVHCompactedSize), &m_pPSO);
 }
 
-void PostBuildInfoQuery::GetCompactedBVHSizes(
+void PostBuildInfoQuery::GetPostbuildInfo(
     _In_  ID3D12GraphicsCommandList *pCommandList,
+    _In_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_TYPE InfoType,
     _In_  D3D12_GPU_VIRTUAL_ADDRESS DestBuffer,
     _In_  UINT NumSourceAccelerationStructures,
     _In_reads_(NumSourceAccelerationStructures) const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData)
@@ -39,6 +44,10 @@ void PostBuildInfoQuery::GetCompactedBVHSizes(
     UINT NumAccelerationStructuresProcessed = 0;
     D3D12_GPU_VIRTUAL_ADDRESS outputCountAddress = DestBuffer;
     GetBVHCompactedSizeConstants constant;
+    constant.InfoType = InfoType == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION ?
+        PostbuildInfoTypeSerialization : PostbuildInfoTypeSize;
+    const UINT outputStride = constant.InfoType == PostbuildInfoTypeSerialization ?
+        SizeOfSerializationPostbuildInfo : SizeOfSizePostbuildInfo;
     while (NumAccelerationStructuresProcessed != NumSourceAccelerationStructures)
     {
         UINT numBVHsProcessedThisDispatch = std::min(NumSourceAccelerationStructures - NumAccelerationStructuresProcessed, (UINT)NumberOfReadableBVHsPerDispatch);
@@ -55,6 +64,6 @@ void PostBuildInfoQuery::GetCompactedBVHSizes(
         pCommandList->Dispatch(dispatchWidth, 1, 1);
 
         NumAccelerationStructuresProcessed += numBVHsProcessedThisDispatch;
-        outputCountAddress += numBVHsProcessedThisDispatch * sizeof(UINT32);
+        outputCountAddress += numBVHsProcessedThisDispatch * outputStride;
     }
 }
@@ -15,8 +15,9 @@ class PostBuildInfoQuery
 public:
     PostBuildInfoQuery(ID3D12Device *pDevice, UINT nodeMask);
 
-    void GetCompactedBVHSizes(
+    void GetPostbuildInfo(
         _In_  ID3D12GraphicsCommandList *pCommandList,
+        _In_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_TYPE InfoType,
         _In_  D3D12_GPU_VIRTUAL_ADDRESS DestBuffer,
         _In_  UINT NumSourceAccelerationStructures,
         _In_reads_(NumSourceAccelerationStructures) const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData);
@@ -49,6 +49,23 @@ static const int OffsetToLeafNodeMetaDataOffset = 4;
 
 static const int OffsetToTotalSize = 12;
 
+// Top-level BVHs store 0 where bottom-level BVHs store the offset to
+// their primitive metadata, which always comes after the header
+bool IsTopLevelBVH(RWByteAddressBuffer bvh)
+{
+    return bvh.Load(OffsetToPrimitiveMetaDataOffset) == 0;
+}
+
+uint GetNumberOfInstances(RWByteAddressBuffer bvh)
+{
+    if (!IsTopLevelBVH(bvh))
+    {
+        return 0;
+    }
+    uint offsetToInstanceDescs = bvh.Load(OffsetToLeafNodeMetaDataOffset);
+    return (bvh.Load(OffsetToTotalSize) - offsetToInstanceDescs) / SizeOfBVHMetadata;
+}
+
 
 int GetLeafIndexFromFlag(uint2 flag)
 {
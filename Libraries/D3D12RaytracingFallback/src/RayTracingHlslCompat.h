@@ -473,6 +473,38 @@ uint GetOffsetFromLeafNodesToBottomLevelMetadata(uint numElements)
     return SizeOfAABBNode * numElements;
 }
 
+// Serialized acceleration structures start with a D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER,
+// followed by the pointer of every instance of a top-level acceleration structure and then
+// the BVH itself. Deserialization writes the pointers back into the instance descs so that
+// an application can relocate the bottom-level acceleration structures in between.
+#define SizeOfSerializedHeader 56
+#define SerializedHeaderOffsetToSerializedSize 32
+#define SerializedHeaderOffsetToDeserializedSize 40
+#define SerializedHeaderOffsetToNumPointers 48
+#define SizeOfSerializedPointer 8
+#ifndef HLSL
+static_assert(sizeof(D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER) == SizeOfSerializedHeader, L"Incorrect sizeof for serialized header");
+static_assert(offsetof(D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER, SerializedSizeInBytesIncludingHeader) == SerializedHeaderOffsetToSerializedSize, L"Incorrect offset to serialized size");
+static_assert(offsetof(D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER, DeserializedSizeInBytes) == SerializedHeaderOffsetToDeserializedSize, L"Incorrect offset to deserialized size");
+static_assert(offsetof(D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER, NumBottomLevelAccelerationStructurePointersAfterHeader) == SerializedHeaderOffsetToNumPointers, L"Incorrect offset to number of pointers");
+static_assert(sizeof(WRAPPED_GPU_POINTER) == SizeOfSerializedPointer, L"Incorrect sizeof for serialized pointer");
+#endif
+
+// DriverOpaqueGUID {6B1E25C1-93D7-4A0E-9A4C-2F5D8E7B3C10} as laid out in memory
+#define SerializedDriverGUID0 0x6b1e25c1
+#define SerializedDriverGUID1 0x4a0e93d7
+#define SerializedDriverGUID2 0x5d2f4c9a
+#define SerializedDriverGUID3 0x103c7b8e
+
+// Stored in the first dword of DriverOpaqueVersioningData, increment whenever the BVH layout changes
+#define SerializedBVHVersion 1
+
+inline
+uint GetOffsetToSerializedBVH(uint numPointers)
+{
+    return SizeOfSerializedHeader + numPointers * SizeOfSerializedPointer;
+}
+
 #ifndef HLSL
 #pragma pack(pop)
 #endif
@@ -25,30 +25,53 @@ namespace FallbackLayer
         }
     }
 
-    IRaytracingProgram *RaytracingProgramFactory::NewRaytracingProgram(ProgramTypes programType, const StateObjectCollection &stateObjectCollection)
+    IRaytracingProgram *RaytracingProgramFactory::NewRaytracingProgram(ProgramTypes programType, const StateObjectCollection &stateObjectCollection, StateObjectCache &stateObjectCache, UINT64 cacheKey)
     {
         switch (programType)
         {
         case RaytracingProgramFactory::UberShader:
-                return new UberShaderRaytracingProgram(m_pDevice, m_DxilShaderPatcher, stateObjectCollection);
+            {
+                UberShaderRaytracingProgram::LinkedProgram linkedProgram;
+                if (!cacheKey || !stateObjectCache.Load(cacheKey, linkedProgram))
+                {
+                    LARGE_INTEGER frequency, start, end;
+                    QueryPerformanceFrequency(&frequency);
+                    QueryPerformanceCounter(&start);
+
+                    CompileTraversalShader(stateObjectCollection);
+                    UberShaderRaytracingProgram::Link(m_pDevice, m_DxilShaderPatcher, stateObjectCollection, linkedProgram);
+
+                    QueryPerformanceCounter(&end);
+                    stateObjectCache.RecordLinkTime((end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart);
+
+                    if (cacheKey)
+                    {
+                        stateObjectCache.Save(cacheKey, linkedProgram);
+                    }
+                }
+                return new UberShaderRaytracingProgram(m_pDevice, stateObjectCollection, std::move(linkedProgram));
+            }
             default:
                 ThrowInternalFailure(E_INVALIDARG);
                 return nullptr;
         }
     }
 
-    IRaytracingProgram *RaytracingProgramFactory::GetRaytracingProgram(
-        const StateObjectCollection &stateObjectCollection)
+    void RaytracingProgramFactory::CompileTraversalShader(const StateObjectCollection &stateObjectCollection)
     {
-        ProgramTypes programType = DetermineBestProgram(stateObjectCollection);
-        
         TraversalShader traversalShader;
         m_spTraversalShaderBuilder->Compile(stateObjectCollection.IsUsingAnyHit || stateObjectCollection.IsUsingIntersection, traversalShader);
 
         memcpy((void *)&stateObjectCollection.m_traversalShader, &traversalShader.m_TraversalShaderDxilLib, sizeof(stateObjectCollection.m_traversalShader));
+    }
 
-
-        return NewRaytracingProgram(programType, stateObjectCollection);
+    IRaytracingProgram *RaytracingProgramFactory::GetRaytracingProgram(
+        const StateObjectCollection &stateObjectCollection,
+        StateObjectCache &stateObjectCache,
+        UINT64 cacheKey)
+    {
+        ProgramTypes programType = DetermineBestProgram(stateObjectCollection);
+        return NewRaytracingProgram(programType, stateObjectCollection, stateObjectCache, cacheKey);
     }
 
     RaytracingProgramFactory::RaytracingProgramFactory(ID3D12Device *pDevice) : m_pDevice(pDevice)
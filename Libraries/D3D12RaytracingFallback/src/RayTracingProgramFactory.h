@@ -45,12 +45,18 @@ namespace FallbackLayer
         bool IsUsingIntersection = false;
     };
 
+    class StateObjectCache;
+
     class RaytracingProgramFactory
     {
     public:
         RaytracingProgramFactory(ID3D12Device *pDevice);
+
+        // Linked programs are loaded from and saved to the cache under cacheKey, 0 skips the cache
         IRaytracingProgram *GetRaytracingProgram(
-            const StateObjectCollection &stateObjectCollection);
+            const StateObjectCollection &stateObjectCollection,
+            StateObjectCache &stateObjectCache,
+            UINT64 cacheKey);
 
     private:
         ID3D12Device *m_pDevice;
@@ -63,7 +69,8 @@ namespace FallbackLayer
         DxilShaderPatcher m_DxilShaderPatcher;
 
         ProgramTypes DetermineBestProgram(const StateObjectCollection &stateObjectCollection);
-        IRaytracingProgram *NewRaytracingProgram(ProgramTypes programTypes, const StateObjectCollection &stateObjectCollection);
+        IRaytracingProgram *NewRaytracingProgram(ProgramTypes programTypes, const StateObjectCollection &stateObjectCollection, StateObjectCache &stateObjectCache, UINT64 cacheKey);
+        void CompileTraversalShader(const StateObjectCollection &stateObjectCollection);
         ITraversalShaderBuilder *NewTraversalShaderBuilder(AccelerationStructureLayoutType type);
 
         const AccelerationStructureLayoutType m_DefaultAccelerationStructureLayoutType = BVH2;
@@ -22,3 +22,39 @@ void VisualizeAccelerationStructureLevel(ID3D12RaytracingFallbackDevice *pDevice
 void BuildRaytracingAccelerationStructureOnCpu(
     _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
     _Out_ void *pData);
+
+// Optional post-build pass for bottom-level acceleration structures built on the CPU.
+// Each pass restructures every treelet of FullTreeletSize leaves in parallel and keeps
+// the new topology only where it lowers the SAH cost, so more passes trade build time
+// for trace performance. Stops early once a pass finds nothing to improve.
+// pSahCostPerPass receives the SAH cost of the input tree followed by the cost after
+// each pass that ran. Update data following the tree isn't rewritten, rebuild rather
+// than update an optimized acceleration structure. bSingleThreaded restructures every
+// treelet on the calling thread, which gives the same tree.
+void OptimizeAccelerationStructureOnCpu(
+    _Inout_ void *pData,
+    UINT NumOptimizationPasses,
+    _Out_opt_ std::vector<float> *pSahCostPerPass = nullptr,
+    bool bSingleThreaded = false);
+
+// Builds an acceleration structure on the CPU using the same Morton code
+// and treelet reordering pipeline as the GPU builder. The 63-bit Morton codes give
+// better trees for large or clustered geometry at the cost of a slightly longer sort.
+// Top-level builds read D3D12_RAYTRACING_FALLBACK_INSTANCE_DESCs whose AccelerationStructure
+// holds a CPU pointer to a bottom-level BVH, and support PERFORM_UPDATE.
+void BuildRaytracingAccelerationStructureOnCpuLbvh(
+    _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
+    _Out_ void *pData,
+    bool bUse63BitMortonCodes = false);
+
+// Updates a top-level acceleration structure built with ALLOW_UPDATE by refitting only the
+// paths from the listed instances to the root, so the cost scales with the number of moved
+// instances rather than the size of the scene. Falls back to a full refit when most of the
+// tree is touched. A null pUpdatedInstanceIndices checks every instance for changes.
+// pRefitOnlyUpdatedPaths reports whether the partial refit was used.
+void UpdateTopLevelAccelerationStructureOnCpuLbvh(
+    _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
+    _In_reads_opt_(NumUpdatedInstances) const UINT *pUpdatedInstanceIndices,
+    UINT NumUpdatedInstances,
+    _Inout_ void *pData,
+    _Out_opt_ bool *pRefitOnlyUpdatedPaths = nullptr);
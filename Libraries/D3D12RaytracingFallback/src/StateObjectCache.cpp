@@ -0,0 +1,382 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+#include <fstream>
+
+namespace FallbackLayer
+{
+    namespace
+    {
+        const char c_Magic[8] = { 'F', 'L', 'S', 'O', 'L', 'I', 'N', 'K' };
+
+        struct EntryHeader
+        {
+            char magic[sizeof(c_Magic)];
+            UINT version;
+            UINT numExports;
+            UINT64 key;
+            UINT64 bytecodeSizeInBytes;
+        };
+
+        // 64-bit FNV-1a
+        class Hasher
+        {
+        public:
+            Hasher(UINT64 seed = 14695981039346656037ull) : m_hash(seed) {}
+
+            void Add(const void *pData, SIZE_T sizeInBytes)
+            {
+                const BYTE *pBytes = (const BYTE *)pData;
+                for (SIZE_T i = 0; i < sizeInBytes; i++)
+                {
+                    m_hash = (m_hash ^ pBytes[i]) * 1099511628211ull;
+                }
+            }
+
+            template<typename T>
+            void Add(const T &value)
+            {
+                static_assert(std::is_pod<T>::value, "Only plain data can be hashed by value");
+                Add(&value, sizeof(value));
+            }
+
+            // Null strings hash differently from empty strings
+            void AddString(LPCWSTR pString)
+            {
+                Add(pString != nullptr);
+                if (pString)
+                {
+                    Add(pString, (wcslen(pString) + 1) * sizeof(WCHAR));
+                }
+            }
+
+            void AddExports(UINT numExports, const D3D12_EXPORT_DESC *pExports)
+            {
+                Add(numExports);
+                for (UINT i = 0; i < numExports; i++)
+                {
+                    AddString(pExports[i].Name);
+                    AddString(pExports[i].ExportToRename);
+                    Add(pExports[i].Flags);
+                }
+            }
+
+            void AddExportNames(UINT numExports, const LPCWSTR *pExports)
+            {
+                Add(numExports);
+                for (UINT i = 0; i < numExports; i++)
+                {
+                    AddString(pExports[i]);
+                }
+            }
+
+            // Root signatures are hashed by their serialized blob rather than by object
+            bool AddRootSignature(ID3D12RootSignature *pRootSignature)
+            {
+                Add(pRootSignature != nullptr);
+                if (pRootSignature)
+                {
+                    UINT blobSize = 0;
+                    if (FAILED(pRootSignature->GetPrivateData(FallbackLayerBlobPrivateDataGUID, &blobSize, nullptr)))
+                    {
+                        return false;
+                    }
+                    std::unique_ptr<BYTE[]> pBlobData(new BYTE[blobSize]);
+                    if (FAILED(pRootSignature->GetPrivateData(FallbackLayerBlobPrivateDataGUID, &blobSize, pBlobData.get())))
+                    {
+                        return false;
+                    }
+                    Add(blobSize);
+                    Add(pBlobData.get(), blobSize);
+                }
+                return true;
+            }
+
+            UINT64 GetHash() const { return m_hash; }
+
+        private:
+            UINT64 m_hash;
+        };
+    }
+
+    StateObjectCache::StateObjectCache(ID3D12Device *pDevice)
+    {
+        Hasher hasher;
+        hasher.Add(Version);
+        hasher.Add(pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
+        hasher.Add(pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER));
+        m_deviceSeed = hasher.GetHash();
+    }
+
+    UINT64 StateObjectCache::ComputeKey(const D3D12_STATE_OBJECT_DESC &desc)
+    {
+        if (desc.NumSubobjects && !desc.pSubobjects)
+        {
+            return 0;
+        }
+
+        Hasher hasher(m_deviceSeed);
+        hasher.Add(desc.Type);
+        hasher.Add(desc.NumSubobjects);
+        for (UINT i = 0; i < desc.NumSubobjects; i++)
+        {
+            const D3D12_STATE_SUBOBJECT &subobject = desc.pSubobjects[i];
+            hasher.Add(subobject.Type);
+            if (!subobject.pDesc)
+            {
+                return 0;
+            }
+
+            switch (subobject.Type)
+            {
+            case D3D12_STATE_SUBOBJECT_TYPE_STATE_OBJECT_CONFIG:
+                hasher.Add(*(const D3D12_STATE_OBJECT_CONFIG *)subobject.pDesc);
+                break;
+            case D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE:
+                if (!hasher.AddRootSignature(((const D3D12_GLOBAL_ROOT_SIGNATURE *)subobject.pDesc)->pGlobalRootSignature))
+                {
+                    return 0;
+                }
+                break;
+            case D3D12_STATE_SUBOBJECT_TYPE_LOCAL_ROOT_SIGNATURE:
+                if (!hasher.AddRootSignature(((const D3D12_LOCAL_ROOT_SIGNATURE *)subobject.pDesc)->pLocalRootSignature))
+                {
+                    return 0;
+                }
+                break;
+            case D3D12_STATE_SUBOBJECT_TYPE_NODE_MASK:
+                hasher.Add(*(const D3D12_NODE_MASK *)subobject.pDesc);
+                break;
+            case D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY:
+            {
+                auto &library = *(const D3D12_DXIL_LIBRARY_DESC *)subobject.pDesc;
+                hasher.Add(library.DXILLibrary.BytecodeLength);
+                hasher.Add(library.DXILLibrary.pShaderBytecode, library.DXILLibrary.BytecodeLength);
+                hasher.AddExports(library.NumExports, library.pExports);
+                break;
+            }
+            case D3D12_STATE_SUBOBJECT_TYPE_EXISTING_COLLECTION:
+            {
+                auto &collection = *(const D3D12_EXISTING_COLLECTION_DESC *)subobject.pDesc;
+                const UINT64 collectionKey = collection.pExistingCollection ?
+                    reinterpret_cast<RaytracingStateObject *>(collection.pExistingCollection)->GetCacheKey() : 0;
+                if (!collectionKey)
+                {
+                    return 0;
+                }
+                hasher.Add(collectionKey);
+                hasher.AddExports(collection.NumExports, collection.pExports);
+                break;
+            }
+            case D3D12_STATE_SUBOBJECT_TYPE_SUBOBJECT_TO_EXPORTS_ASSOCIATION:
+            {
+                // The associated subobject is identified by its position in the desc
+                auto &association = *(const D3D12_SUBOBJECT_TO_EXPORTS_ASSOCIATION *)subobject.pDesc;
+                if (association.pSubobjectToAssociate < desc.pSubobjects ||
+                    association.pSubobjectToAssociate >= desc.pSubobjects + desc.NumSubobjects)
+                {
+                    return 0;
+                }
+                hasher.Add((UINT)(association.pSubobjectToAssociate - desc.pSubobjects));
+                hasher.AddExportNames(association.NumExports, association.pExports);
+                break;
+            }
+            case D3D12_STATE_SUBOBJECT_TYPE_DXIL_SUBOBJECT_TO_EXPORTS_ASSOCIATION:
+            {
+                auto &association = *(const D3D12_DXIL_SUBOBJECT_TO_EXPORTS_ASSOCIATION *)subobject.pDesc;
+                hasher.AddString(association.SubobjectToAssociate);
+                hasher.AddExportNames(association.NumExports, association.pExports);
+                break;
+            }
+            case D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG:
+                hasher.Add(*(const D3D12_RAYTRACING_SHADER_CONFIG *)subobject.pDesc);
+                break;
+            case D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG:
+                hasher.Add(*(const D3D12_RAYTRACING_PIPELINE_CONFIG *)subobject.pDesc);
+                break;
+            case D3D12_STATE_SUBOBJECT_TYPE_HIT_GROUP:
+            {
+                auto &hitGroup = *(const D3D12_HIT_GROUP_DESC *)subobject.pDesc;
+                hasher.AddString(hitGroup.HitGroupExport);
+                hasher.Add(hitGroup.Type);
+                hasher.AddString(hitGroup.AnyHitShaderImport);
+                hasher.AddString(hitGroup.ClosestHitShaderImport);
+                hasher.AddString(hitGroup.IntersectionShaderImport);
+                break;
+            }
+            default:
+                // Unknown subobjects can't be hashed safely
+                return 0;
+            }
+        }
+
+        // 0 is reserved for "not cacheable"
+        return std::max(hasher.GetHash(), 1ull);
+    }
+
+    std::shared_ptr<IRaytracingProgram> StateObjectCache::Find(UINT64 key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.NumLookups++;
+
+        auto entry = m_programs.find(key);
+        if (entry == m_programs.end())
+        {
+            return nullptr;
+        }
+        m_statistics.NumMemoryHits++;
+        return entry->second;
+    }
+
+    void StateObjectCache::Add(UINT64 key, const std::shared_ptr<IRaytracingProgram> &spProgram)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_programs[key] = spProgram;
+    }
+
+    void StateObjectCache::SetDirectory(LPCWSTR pDirectory)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_directory = pDirectory ? pDirectory : L"";
+    }
+
+    std::wstring StateObjectCache::GetFilename(UINT64 key)
+    {
+        WCHAR filename[32];
+        swprintf_s(filename, L"%016llx.fbso", key);
+        return m_directory + L"\\" + filename;
+    }
+
+    bool StateObjectCache::Load(UINT64 key, UberShaderRaytracingProgram::LinkedProgram &linkedProgram)
+    {
+        std::wstring filename;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_directory.empty())
+            {
+                return false;
+            }
+            filename = GetFilename(key);
+        }
+
+        std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        std::vector<BYTE> data((size_t)file.tellg());
+        file.seekg(0);
+        file.read((char *)data.data(), data.size());
+        if (!file.good() || data.size() < sizeof(EntryHeader))
+        {
+            return false;
+        }
+
+        EntryHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+        if (memcmp(header.magic, c_Magic, sizeof(c_Magic)) ||
+            header.version != Version ||
+            header.key != key ||
+            header.bytecodeSizeInBytes > data.size() - sizeof(EntryHeader))
+        {
+            return false;
+        }
+
+        const BYTE *pRead = data.data() + sizeof(EntryHeader);
+        const BYTE *pEnd = data.data() + data.size();
+        linkedProgram.m_shaderBytecode.assign(pRead, pRead + header.bytecodeSizeInBytes);
+        pRead += header.bytecodeSizeInBytes;
+
+        linkedProgram.m_exportNameToShaderData.clear();
+        for (UINT i = 0; i < header.numExports; i++)
+        {
+            UINT nameLength;
+            if ((SIZE_T)(pEnd - pRead) < sizeof(nameLength))
+            {
+                return false;
+            }
+            memcpy(&nameLength, pRead, sizeof(nameLength));
+            pRead += sizeof(nameLength);
+
+            const SIZE_T nameSizeInBytes = (SIZE_T)nameLength * sizeof(WCHAR);
+            if ((SIZE_T)(pEnd - pRead) < nameSizeInBytes + sizeof(UberShaderRaytracingProgram::ShaderData))
+            {
+                return false;
+            }
+            std::wstring name((const WCHAR *)pRead, nameLength);
+            pRead += nameSizeInBytes;
+
+            UberShaderRaytracingProgram::ShaderData shaderData;
+            memcpy(&shaderData, pRead, sizeof(shaderData));
+            pRead += sizeof(shaderData);
+
+            linkedProgram.m_exportNameToShaderData[name] = shaderData;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.NumDiskHits++;
+        return true;
+    }
+
+    void StateObjectCache::Save(UINT64 key, const UberShaderRaytracingProgram::LinkedProgram &linkedProgram)
+    {
+        std::wstring filename;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_directory.empty())
+            {
+                return;
+            }
+            filename = GetFilename(key);
+        }
+
+        EntryHeader header = {};
+        memcpy(header.magic, c_Magic, sizeof(c_Magic));
+        header.version = Version;
+        header.numExports = (UINT)linkedProgram.m_exportNameToShaderData.size();
+        header.key = key;
+        header.bytecodeSizeInBytes = linkedProgram.m_shaderBytecode.size();
+
+        // Failing to write an entry only costs a relink next time, so errors are ignored.
+        // Writing to a temporary file first keeps a crash from leaving a partial entry behind.
+        std::wstring tempFilename = filename + L".tmp";
+        {
+            std::ofstream file(tempFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+            file.write((const char *)&header, sizeof(header));
+            file.write((const char *)linkedProgram.m_shaderBytecode.data(), linkedProgram.m_shaderBytecode.size());
+            for (auto &entry : linkedProgram.m_exportNameToShaderData)
+            {
+                UINT nameLength = (UINT)entry.first.size();
+                file.write((const char *)&nameLength, sizeof(nameLength));
+                file.write((const char *)entry.first.data(), nameLength * sizeof(WCHAR));
+                file.write((const char *)&entry.second, sizeof(entry.second));
+            }
+            if (!file.good())
+            {
+                return;
+            }
+        }
+        MoveFileExW(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+
+    void StateObjectCache::RecordLinkTime(double milliseconds)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.NumLinks++;
+        m_statistics.TotalLinkTimeInMilliseconds += milliseconds;
+    }
+
+    void StateObjectCache::GetStatistics(D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS &statistics)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        statistics = m_statistics;
+    }
+}
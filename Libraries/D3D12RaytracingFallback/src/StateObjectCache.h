@@ -0,0 +1,59 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace FallbackLayer
+{
+    // Content-addressed cache of linked raytracing pipelines.
+    //
+    // Keys are a hash of everything that feeds into linking: the DXIL library
+    // blobs and their exports, hit groups, association subobjects, configs and
+    // the serialized root signatures. Two state object descs with the same
+    // contents map to the same key regardless of where their memory lives.
+    //
+    // Programs are kept in memory for the lifetime of the device so that a hit
+    // skips state object validation, DXIL linking and PSO creation entirely.
+    // If a directory is set, linked programs are also written to disk so that
+    // a new process only pays for PSO creation.
+    class StateObjectCache
+    {
+    public:
+        // Bump whenever the on-disk layout or the linking steps change
+        static const UINT Version = 1;
+
+        StateObjectCache(ID3D12Device *pDevice);
+
+        // Returns 0 if the desc can't be cached, e.g. it references a collection
+        // that wasn't itself given a key.
+        UINT64 ComputeKey(const D3D12_STATE_OBJECT_DESC &desc);
+
+        std::shared_ptr<IRaytracingProgram> Find(UINT64 key);
+        void Add(UINT64 key, const std::shared_ptr<IRaytracingProgram> &spProgram);
+
+        void SetDirectory(LPCWSTR pDirectory);
+        bool Load(UINT64 key, UberShaderRaytracingProgram::LinkedProgram &linkedProgram);
+        void Save(UINT64 key, const UberShaderRaytracingProgram::LinkedProgram &linkedProgram);
+
+        void RecordLinkTime(double milliseconds);
+        void GetStatistics(D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS &statistics);
+
+    private:
+        std::wstring GetFilename(UINT64 key);
+
+        // Seeds every key with the device properties that get baked into linked shaders
+        UINT64 m_deviceSeed;
+
+        std::mutex m_mutex;
+        std::unordered_map<UINT64, std::shared_ptr<IRaytracingProgram>> m_programs;
+        std::wstring m_directory;
+        D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_CACHE_STATISTICS m_statistics = {};
+    };
+}
@@ -1,5 +1,86 @@
 #include "pch.h"
 #include "dxc/HLSL/DxilRuntimeReflection.inl"
+//==================================================================================================================================
+// CNameTable
+//==================================================================================================================================
+const UINT CNameTable::InvalidID;
+const size_t CNameTable::MinBlockSize;
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// CNameTable::CStringHash
+//----------------------------------------------------------------------------------------------------------------------------------
+size_t CNameTable::CStringHash::operator()(LPCWSTR string) const noexcept
+{
+    // FNV-1a
+    size_t hash = (sizeof(size_t) == 8) ? (size_t)14695981039346656037ull : (size_t)2166136261u;
+    const size_t prime = (sizeof(size_t) == 8) ? (size_t)1099511628211ull : (size_t)16777619u;
+    for(; *string; string++)
+    {
+        hash ^= (size_t)*string;
+        hash *= prime;
+    }
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// CNameTable::Intern
+//----------------------------------------------------------------------------------------------------------------------------------
+LPCWSTR CNameTable::Intern(LPCWSTR string, UINT* pID)
+{
+    if(string == nullptr)
+    {
+        if(pID)
+        {
+            *pID = InvalidID;
+        }
+        return nullptr;
+    }
+    auto match = m_IDs.find(string);
+    if(match != m_IDs.end())
+    {
+        if(pID)
+        {
+            *pID = match->second;
+        }
+        return match->first;
+    }
+
+    // Copy into the current block, starting a new one if it doesn't fit.  Blocks are never reallocated,
+    // so copies already handed out stay put.
+    size_t length = wcslen(string) + 1;
+    if(m_BlockUsed + length > m_BlockSize)
+    {
+        m_BlockSize = std::max(MinBlockSize, length);
+        m_Blocks.emplace_back(new WCHAR[m_BlockSize]);
+        m_BlockUsed = 0;
+    }
+    WCHAR* pCopy = m_Blocks.back().get() + m_BlockUsed;
+    memcpy(pCopy, string, length * sizeof(WCHAR));
+    m_BlockUsed += length;
+
+    UINT ID = (UINT)m_Names.size();
+    m_Names.push_back(pCopy);
+    m_IDs.insert({pCopy,ID});
+    if(pID)
+    {
+        *pID = ID;
+    }
+    return pCopy;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// CNameTable::Find
+//----------------------------------------------------------------------------------------------------------------------------------
+LPCWSTR CNameTable::Find(LPCWSTR string) const
+{
+    if(string == nullptr)
+    {
+        return nullptr;
+    }
+    auto match = m_IDs.find(string);
+    return (match == m_IDs.end()) ? nullptr : match->first;
+}
+
 //==================================================================================================================================
 // CStateObjectInfo
 //==================================================================================================================================
@@ -333,20 +414,22 @@ void CStateObjectInfo::AddExport(
     CStateObjectInfo* pOwningStateObject,
     bool bExternalDependenciesOnThisExportAllowed)
 {
-    auto ret = m_ExportInfoMap.find(LocalUniqueCopy(pExternalNameMangled));
+    UINT NameID = CNameTable::InvalidID;
+    LPCWSTR pUniqueExternalNameMangled = m_Names.Intern(pExternalNameMangled,&NameID);
+    auto ret = m_ExportInfoMap.find(pUniqueExternalNameMangled);
     if (ret != m_ExportInfoMap.end())
     {
         LOG_ERROR(L"Export " << PrettyPrintPossiblyMangledName(pExternalNameMangled) << L" already defined.");
         return; // continue, to be able to find other errors
     }
     CExportInfo* pExportInfo = nullptr;
-    m_ExportInfoList.emplace_back();
-    pExportInfo = &m_ExportInfoList.back();
+    m_ExportInfos.emplace_back();
+    pExportInfo = &m_ExportInfos.back();
     pExportInfo->m_pFunctionInfo = pInfo;
     pExportInfo->m_pOwningStateObject = pOwningStateObject;
     pExportInfo->m_bExternalDependenciesOnThisExportAllowed = bExternalDependenciesOnThisExportAllowed;
+    pExportInfo->m_NameID = NameID;
 
-    LPCWSTR pUniqueExternalNameMangled = LocalUniqueCopy(pExternalNameMangled);
     LPCWSTR pUniqueExternalNameUnmangled = LocalUniqueCopy(pExternalNameUnmangled);
     pExportInfo->m_MangledName = pUniqueExternalNameMangled;
     pExportInfo->m_UnmangledName = pUniqueExternalNameUnmangled;
@@ -354,11 +437,16 @@ void CStateObjectInfo::AddExport(
     m_ExportNameUnmangledToMangled.insert({ pUniqueExternalNameUnmangled,pUniqueExternalNameMangled });
     m_ExportNameMangledToUnmangled.insert({ pUniqueExternalNameMangled,pUniqueExternalNameUnmangled });
 
+    // Intern each callee once here, the call graph is walked by ID from then on
     UINT NumFunctionDependencies = pExportInfo->m_pFunctionInfo->NumFunctionDependencies;
+    pExportInfo->m_FirstDependency = (UINT)m_DependencyIDs.size();
+    pExportInfo->m_NumDependencies = NumFunctionDependencies;
     for (UINT i = 0; i < NumFunctionDependencies; i++)
     {
         // pExportInfo calls FunctionDependencies[i]
-        m_Dependencies.insert({ LocalUniqueCopy(pExportInfo->m_pFunctionInfo->FunctionDependencies[i]), pExportInfo });
+        UINT DependencyID = CNameTable::InvalidID;
+        m_Names.Intern(pExportInfo->m_pFunctionInfo->FunctionDependencies[i],&DependencyID);
+        m_DependencyIDs.push_back(DependencyID);
     }
 
     m_UsedUnmangledFunctionNames.insert(pUniqueExternalNameUnmangled); //unmangled name could already be in set (overload), that's ok  
@@ -387,13 +475,14 @@ void CStateObjectInfo::AddLibrary(const D3D12_DXIL_LIBRARY_DESC* pLibrary)
     DxilLibraryDesc libDesc = pWrappedLibrary->GetLibraryReflection();
     D3D12_DXIL_LIBRARY_DESC& LocalLibrary = pWrappedLibrary->m_LocalLibraryDesc;
 
-    // Multimap of internal export names to external export(s) the library desc manually listed (if any)
-    std::unordered_multimap<std::wstring, const D3D12_EXPORT_DESC*> ExportsToUse;
+    // Multimap of internal export names to external export(s) the library desc manually listed (if any),
+    // keyed on local unique copies so matching below doesn't hash string contents
+    std::unordered_multimap<LPCWSTR, const D3D12_EXPORT_DESC*> ExportsToUse;
     std::unordered_set<const D3D12_EXPORT_DESC*> ExportMissing;
     for (UINT i = 0; i < LocalLibrary.NumExports; i++)
     {
         LPCWSTR InternalName = LocalLibrary.pExports[i].ExportToRename ? LocalLibrary.pExports[i].ExportToRename : LocalLibrary.pExports[i].Name;
-        ExportsToUse.insert({ InternalName,&LocalLibrary.pExports[i] });
+        ExportsToUse.insert({ LocalUniqueCopy(InternalName),&LocalLibrary.pExports[i] });
         ExportMissing.insert(&LocalLibrary.pExports[i]);
     }
     // If there's a manual export list, only add matching exports
@@ -404,7 +493,7 @@ void CStateObjectInfo::AddLibrary(const D3D12_DXIL_LIBRARY_DESC* pLibrary)
             const DxilFunctionDesc* pFunc = &libDesc.pFunction[i];
             for (UINT j = 0; j < 2; j++) // 0 == unmangled name, 1 == mangled name
             {
-                LPCWSTR nameToMatch = LocalUniqueCopy(j == 0 ? pFunc->UnmangledName : pFunc->Name);
+                LPCWSTR nameToMatch = LocalUniqueLookup(j == 0 ? pFunc->UnmangledName : pFunc->Name); // null if not listed
                 auto matches = ExportsToUse.equal_range(nameToMatch);
                 if (matches.first != ExportsToUse.end())
                 {
@@ -463,24 +552,31 @@ void CStateObjectInfo::AddLibrary(const D3D12_DXIL_LIBRARY_DESC* pLibrary)
     }
 }
 
+//----------------------------------------------------------------------------------------------------------------------------------
+// CStateObjectInfo::GetDependency
+//----------------------------------------------------------------------------------------------------------------------------------
+CStateObjectInfo::CExportInfo* CStateObjectInfo::GetDependency(const CExportInfo* pExportInfo, UINT i)
+{
+    assert(i < pExportInfo->m_NumDependencies);
+    UINT ExportIndex = m_DependencyIDs[pExportInfo->m_FirstDependency + i];
+    return (ExportIndex == CNameTable::InvalidID) ? nullptr : &m_ExportInfos[ExportIndex];
+}
+
 //----------------------------------------------------------------------------------------------------------------------------------
 // CStateObjectInfo::TraverseFunctionsInitialValidation
 //----------------------------------------------------------------------------------------------------------------------------------
-void CStateObjectInfo::TraverseFunctionsInitialValidation(LPCWSTR function)
+void CStateObjectInfo::TraverseFunctionsInitialValidation(CExportInfo* pExportInfo)
 {
-    auto ex = m_ExportInfoMap.find(LocalUniqueCopy(function));
-    if(ex == m_ExportInfoMap.end())
+    if(!pExportInfo)
     {
         return; // ignore unresolved exports
     }
-    auto pFuncInfo = ex->second->m_pFunctionInfo;
-    auto& flags = ex->second->m_GraphTraversalFlags;      
-    if(!(flags & CExportInfo::GTF_CycleFound) && (m_TraversalGlobals.GraphTraversalIndex == ex->second->m_VisitedOnGraphTraversalIndex))
+    auto& flags = pExportInfo->m_GraphTraversalFlags;      
+    if(!(flags & CExportInfo::GTF_CycleFound) && (m_TraversalGlobals.GraphTraversalIndex == pExportInfo->m_VisitedOnGraphTraversalIndex))
     {
 #ifdef INCLUDE_MESSAGE_LOG            
-        auto unmangledName = m_ExportNameMangledToUnmangled.find(LocalUniqueCopy(function));
         LOG_ERROR(L"Cycle in function call graph involving export " <<
-            PrettyPrintPossiblyMangledName(function) << L".");
+            PrettyPrintPossiblyMangledName(pExportInfo->m_MangledName) << L".");
 #else
         LOG_ERROR_NOMESSAGE;
 #endif   
@@ -492,10 +588,10 @@ void CStateObjectInfo::TraverseFunctionsInitialValidation(LPCWSTR function)
         return;
     }
     flags |= CExportInfo::GTF_SubtreeAlreadyCheckedForCycles;
-    ex->second->m_VisitedOnGraphTraversalIndex = m_TraversalGlobals.GraphTraversalIndex;
-    for(UINT i = 0; i < pFuncInfo->NumFunctionDependencies; i++)
+    pExportInfo->m_VisitedOnGraphTraversalIndex = m_TraversalGlobals.GraphTraversalIndex;
+    for(UINT i = 0; i < pExportInfo->m_NumDependencies; i++)
     {
-        TraverseFunctionsInitialValidation(pFuncInfo->FunctionDependencies[i]);
+        TraverseFunctionsInitialValidation(GetDependency(pExportInfo,i));
     }
 }
 
@@ -504,42 +600,54 @@ void CStateObjectInfo::TraverseFunctionsInitialValidation(LPCWSTR function)
 //----------------------------------------------------------------------------------------------------------------------------------
 void CStateObjectInfo::ResolveFunctionDependencies()
 {
-    // Function dependencies
-    for (auto dep : m_Dependencies)
+    // Function dependencies: translate the name IDs recorded by AddExport into export indices with a dense lookup table,
+    // so no graph traversal needs to touch names again
+    std::vector<UINT> ExportIndexFromNameID(m_Names.GetCount(), CNameTable::InvalidID);
+    for (size_t i = 0; i < m_ExportInfos.size(); i++)
     {
-        auto match = m_ExportInfoMap.find(dep.first); // entries in dep are already unique strings, so map lookup is safe
-        if (match == m_ExportInfoMap.end())
+        ExportIndexFromNameID[m_ExportInfos[i].m_NameID] = (UINT)i;
+    }
+    for (auto& caller : m_ExportInfos)
+    {
+        for (UINT i = 0; i < caller.m_NumDependencies; i++)
         {
-            if (!AllowLocalDependenciesOnExternalDefinitions())
-            {          
-                LOG_ERROR(L"Unresolved reference to function " << PrettyPrintPossiblyMangledName(dep.first) <<
-                    L" by export " << PrettyPrintPossiblyMangledName(dep.second->m_MangledName) << L"." <<
-                    ((D3D12_STATE_OBJECT_TYPE_COLLECTION == m_SOType) ? 
-                    L" If the intent is this will be resolved later, when this state object is combined with other state object(s), "
-                    L"use a D3D12_STATE_OBJECT_CONFIG subobject with D3D12_STATE_OBJECT_FLAG_ALLOW_LOCAL_DEPENDENCIES_ON_EXTERNAL_DEFINITIONS set in Flags." : L""));
+            UINT& dep = m_DependencyIDs[caller.m_FirstDependency + i];
+            LPCWSTR pDependencyName = m_Names.GetName(dep);
+            dep = ExportIndexFromNameID[dep];
+            CExportInfo* pMatch = GetDependency(&caller, i);
+            if (!pMatch)
+            {
+                if (!AllowLocalDependenciesOnExternalDefinitions())
+                {          
+                    LOG_ERROR(L"Unresolved reference to function " << PrettyPrintPossiblyMangledName(pDependencyName) <<
+                        L" by export " << PrettyPrintPossiblyMangledName(caller.m_MangledName) << L"." <<
+                        ((D3D12_STATE_OBJECT_TYPE_COLLECTION == m_SOType) ? 
+                        L" If the intent is this will be resolved later, when this state object is combined with other state object(s), "
+                        L"use a D3D12_STATE_OBJECT_CONFIG subobject with D3D12_STATE_OBJECT_FLAG_ALLOW_LOCAL_DEPENDENCIES_ON_EXTERNAL_DEFINITIONS set in Flags." : L""));
+                }
+                caller.m_bUnresolvedFunctions = true;
+                m_bUnresolvedFunctions = true;
+            }
+            else if(!pMatch->m_bExternalDependenciesOnThisExportAllowed && (caller.m_pOwningStateObject != pMatch->m_pOwningStateObject))
+            {
+                LOG_ERROR(L"Function " << PrettyPrintPossiblyMangledName(pMatch->m_MangledName) <<
+                    L" comes from a state object that did not opt in to allowing external dependencies on local definitions. Thus, export " << 
+                    PrettyPrintPossiblyMangledName(caller.m_MangledName) << L", which resides in a different state object, can't depend on \"" 
+                    << pMatch->m_UnmangledName <<
+                    L"\". To allow this linkage across state objects, the state object exporting \"" << pMatch->m_UnmangledName << L"\" must specify a D3D12_STATE_OBJECT_CONFIG subobject with the flag " <<
+                    L"D3D12_STATE_OBJECT_FLAG_ALLOW_EXTERNAL_DEPENDENCIES_ON_LOCAL_DEFINITIONS." );
             }
-            dep.second->m_bUnresolvedFunctions = true;
-            m_bUnresolvedFunctions = true;
-        }
-        else if(!match->second->m_bExternalDependenciesOnThisExportAllowed && (dep.second->m_pOwningStateObject != match->second->m_pOwningStateObject))
-        {
-            LOG_ERROR(L"Function " << PrettyPrintPossiblyMangledName(match->second->m_MangledName) <<
-                L" comes from a state object that did not opt in to allowing external dependencies on local definitions. Thus, export " << 
-                PrettyPrintPossiblyMangledName(dep.second->m_MangledName) << L", which resides in a different state object, can't depend on \"" 
-                << match->second->m_UnmangledName <<
-                L"\". To allow this linkage across state objects, the state object exporting \"" << match->second->m_UnmangledName << L"\" must specify a D3D12_STATE_OBJECT_CONFIG subobject with the flag " <<
-                L"D3D12_STATE_OBJECT_FLAG_ALLOW_EXTERNAL_DEPENDENCIES_ON_LOCAL_DEFINITIONS." );
         }
     }
     // Check for cycles or library functions calling entrypoints
-    for(auto& function : m_ExportInfoList)
+    for(auto& function : m_ExportInfos)
     {
         function.m_GraphTraversalFlags = 0;
         function.m_VisitedOnGraphTraversalIndex = (UINT64)-1;
     }
-    for(auto& ex : m_ExportInfoList)
+    for(auto& ex : m_ExportInfos)
     {
-        TraverseFunctionsInitialValidation(ex.m_MangledName);
+        TraverseFunctionsInitialValidation(&ex);
         m_TraversalGlobals.GraphTraversalIndex++;
     }
 
@@ -665,19 +773,16 @@ void CStateObjectInfo::TranslateSubobjectAssociations()
 // CStateObjectInfo::TraverseFunctionsFindFirstSubobjectInLibraryFunctionSubtrees
 //----------------------------------------------------------------------------------------------------------------------------------
 CStateObjectInfo::CAssociateableSubobjectInfo* CStateObjectInfo::TraverseFunctionsFindFirstSubobjectInLibraryFunctionSubtrees(
-    LPCWSTR function)
+    CExportInfo* pExportInfo)
 {
-    auto ex = m_ExportInfoMap.find(LocalUniqueCopy(function));
-    if(ex == m_ExportInfoMap.end())
+    if(!pExportInfo)
     {
         return nullptr; // ignore unresolved exports
     }    
-    auto pFuncInfo = ex->second->m_pFunctionInfo;
-    if(ex->second->m_GraphTraversalFlags & CExportInfo::GTF_CycleFound)
+    if(pExportInfo->m_GraphTraversalFlags & CExportInfo::GTF_CycleFound)
     {
         return nullptr; // skip graph cycles 
     }
-    CExportInfo* pExportInfo = ex->second;
     if(pExportInfo->m_VisitedOnGraphTraversalIndex == m_TraversalGlobals.GraphTraversalIndex)
     {
         return pExportInfo->m_pFirstSubobjectInLibraryFunctionSubtree;
@@ -690,9 +795,9 @@ CStateObjectInfo::CAssociateableSubobjectInfo* CStateObjectInfo::TraverseFunctio
     {
         pExportInfo->m_pFirstSubobjectInLibraryFunctionSubtree = pCurrSubobject;
     }
-    for(UINT i = 0; i < pFuncInfo->NumFunctionDependencies; i++)
+    for(UINT i = 0; i < pExportInfo->m_NumDependencies; i++)
     {
-        auto pMatch = TraverseFunctionsFindFirstSubobjectInLibraryFunctionSubtrees(pFuncInfo->FunctionDependencies[i]);
+        auto pMatch = TraverseFunctionsFindFirstSubobjectInLibraryFunctionSubtrees(GetDependency(pExportInfo,i));
         if(!pExportInfo->m_pFirstSubobjectInLibraryFunctionSubtree)
         {
             pExportInfo->m_pFirstSubobjectInLibraryFunctionSubtree = pMatch;
@@ -704,25 +809,24 @@ CStateObjectInfo::CAssociateableSubobjectInfo* CStateObjectInfo::TraverseFunctio
 //----------------------------------------------------------------------------------------------------------------------------------
 // CStateObjectInfo::TraverseFunctionsSubobjectConsistency
 //----------------------------------------------------------------------------------------------------------------------------------
-void CStateObjectInfo::TraverseFunctionsSubobjectConsistency(LPCWSTR function)
+void CStateObjectInfo::TraverseFunctionsSubobjectConsistency(CExportInfo* pExportInfo)
 {
-    auto ex = m_ExportInfoMap.find(LocalUniqueCopy(function));
-    if(ex == m_ExportInfoMap.end())
+    if(!pExportInfo)
     {
         return; // ignore unresolved exports
     }    
-    auto pFuncInfo = ex->second->m_pFunctionInfo;
-    auto& flags = ex->second->m_GraphTraversalFlags;
+    LPCWSTR function = pExportInfo->m_MangledName;
+    auto& flags = pExportInfo->m_GraphTraversalFlags;
     if(flags & CExportInfo::GTF_CycleFound)
     {
         return; // skip graph cycles 
     }
-    if(ex->second->m_VisitedOnGraphTraversalIndex == m_TraversalGlobals.GraphTraversalIndex)
+    if(pExportInfo->m_VisitedOnGraphTraversalIndex == m_TraversalGlobals.GraphTraversalIndex)
     {
         return;
     }
     assert(m_sAssociateableSubobjectData[m_TraversalGlobals.AssociateableSubobjectIndex].bAtMostOneAssociationPerExport);
-    auto& currAssociation = ex->second->m_Associations[m_TraversalGlobals.AssociateableSubobjectIndex];
+    auto& currAssociation = pExportInfo->m_Associations[m_TraversalGlobals.AssociateableSubobjectIndex];
     auto pCurrSubobject = currAssociation.size() ? currAssociation.front()->m_pSubobject : nullptr; // just take first  
     auto& pRefSubobject = m_TraversalGlobals.pReferenceSubobject;
     const auto& MatchRule = m_sAssociateableSubobjectData[m_TraversalGlobals.AssociateableSubobjectIndex].MatchRule;
@@ -782,13 +886,13 @@ void CStateObjectInfo::TraverseFunctionsSubobjectConsistency(LPCWSTR function)
     if(pRefSubobject)
     {
         // if we've found a reference subobject we will have checked the subgraph against this reference
-        ex->second->m_VisitedOnGraphTraversalIndex = m_TraversalGlobals.GraphTraversalIndex;        
+        pExportInfo->m_VisitedOnGraphTraversalIndex = m_TraversalGlobals.GraphTraversalIndex;        
         // otherwise don't count this function as visited yet (don't optimize out future visits to it)
     }
 
-    for(UINT i = 0; i < pFuncInfo->NumFunctionDependencies; i++)
+    for(UINT i = 0; i < pExportInfo->m_NumDependencies; i++)
     {
-        TraverseFunctionsSubobjectConsistency(pFuncInfo->FunctionDependencies[i]);
+        TraverseFunctionsSubobjectConsistency(GetDependency(pExportInfo,i));
     }
 }
 
@@ -984,10 +1088,10 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
     };
    
     // Apply default associations while looking to see if there are too many...
-    for(auto ex : m_ExportInfoMap)
+    for(auto& ex : m_ExportInfos)
     {
-        CExportInfo* pExportInfo = ex.second;
-        if(SupportedShaderType((ShaderKind)ex.second->m_pFunctionInfo->ShaderKind))
+        CExportInfo* pExportInfo = &ex;
+        if(SupportedShaderType((ShaderKind)pExportInfo->m_pFunctionInfo->ShaderKind))
         {            
             for(ASSOCIATEABLE_SUBOBJECT_NAME i = (ASSOCIATEABLE_SUBOBJECT_NAME)0; i < NUM_ASSOCIATEABLE_SUBOBJECT_TYPES; ((UINT&)i)++)
             {
@@ -998,7 +1102,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                     if(m_AssociateableSubobjectData[i].pLocalDefaultSubobject) 
                     {
                         pExportInfo->m_Associations[i].push_back(m_AssociateableSubobjectData[i].pLocalDefaultSubobject);
-                        m_AssociateableSubobjectData[i].pLocalDefaultSubobject->m_Exports.insert(ex.first);
+                        m_AssociateableSubobjectData[i].pLocalDefaultSubobject->m_Exports.insert(pExportInfo->m_MangledName);
                         m_AssociateableSubobjectData[i].pLocalDefaultSubobject->m_pSubobject->m_bReferenced = true;
                     }
                     else
@@ -1008,7 +1112,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                         {
                             if(!AllowLocalDependenciesOnExternalDefinitions())
                             {
-                                auto unMangled = m_ExportNameMangledToUnmangled.find(ex.first);
+                                auto unMangled = m_ExportNameMangledToUnmangled.find(pExportInfo->m_MangledName);
                                 assert(unMangled != m_ExportNameMangledToUnmangled.end());
     #ifdef INCLUDE_MESSAGE_LOG
                                 if(m_AssociateableSubobjectData[i].bContinuePrintingMissingSubobjectMessages)
@@ -1018,7 +1122,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                                     {
                                         LOG_ERROR(L"Subobject association of type " << m_sAssociateableSubobjectData[i].StringAPIName 
                                                     << L" must be defined for all relevant exports, yet no such subobject exists at all.  And example of an export needing this association is " <<
-                                                    PrettyPrintPossiblyMangledName(ex.first) << L"." <<
+                                                    PrettyPrintPossiblyMangledName(pExportInfo->m_MangledName) << L"." <<
                                                     ((D3D12_STATE_OBJECT_TYPE_COLLECTION == m_SOType) ? 
                                                     L" If the intent is this will be resolved later, when this state object is combined with other state object(s), "
                                                     L"use a D3D12_STATE_OBJECT_CONFIG subobject with D3D12_STATE_OBJECT_FLAG_ALLOW_LOCAL_DEPENDENCIES_ON_EXTERNAL_DEFINITIONS set in Flags." : L""));                            
@@ -1028,7 +1132,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                                     else
     #endif
                                     {
-                                        LOG_ERROR(L"Export " << PrettyPrintPossiblyMangledName(ex.first) << L" is missing a required subobject association of type " 
+                                        LOG_ERROR(L"Export " << PrettyPrintPossiblyMangledName(pExportInfo->m_MangledName) << L" is missing a required subobject association of type " 
                                         << m_sAssociateableSubobjectData[i].StringAPIName << L"." <<
                                         ((D3D12_STATE_OBJECT_TYPE_COLLECTION == m_SOType) ? 
                                             L" If the intent is this will be resolved later, when this state object is combined with other state object(s), "
@@ -1039,7 +1143,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                                 }
     #endif                            
                             }
-                            ex.second->m_bUnresolvedAssociations = true;
+                            pExportInfo->m_bUnresolvedAssociations = true;
                             m_bFunctionsWithUnresolvedAssociations = true;
                         }
                     }
@@ -1056,9 +1160,9 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                             {
                                 if(!pRefSubobject->Compare(a->m_pSubobject))
                                 {
-                                    auto unMangled = m_ExportNameMangledToUnmangled.find(ex.first);
+                                    auto unMangled = m_ExportNameMangledToUnmangled.find(pExportInfo->m_MangledName);
                                     assert(unMangled != m_ExportNameMangledToUnmangled.end());
-                                    LOG_ERROR( L"Export " << PrettyPrintPossiblyMangledName(ex.first) << L" has multiple subobject associations of type " 
+                                    LOG_ERROR( L"Export " << PrettyPrintPossiblyMangledName(pExportInfo->m_MangledName) << L" has multiple subobject associations of type " 
                                     << m_sAssociateableSubobjectData[i].StringAPIName << L" when only one is expected, or if there are multiple subobjects associated they must have matching definitions.");
                                     break;                                    
                                 }
@@ -1111,13 +1215,13 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
             auto& pRefSubobject = m_TraversalGlobals.pReferenceSubobject;
             pRefSubobject = nullptr;
             bool bAssignedRef = false;
-            for(auto function : m_ExportInfoMap)
+            for(auto& function : m_ExportInfos)
             {
-                if(bMatchScopeLocal && (function.second->m_pOwningStateObject != this))
+                if(bMatchScopeLocal && (function.m_pOwningStateObject != this))
                 {
                     continue;
                 }
-                auto& currAssociation = function.second->m_Associations[i];
+                auto& currAssociation = function.m_Associations[i];
                 auto pCurrSubobject = currAssociation.size() ? currAssociation.front()->m_pSubobject : nullptr; // just take first
                 if(bAssignedRef)
                 {
@@ -1133,7 +1237,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                             ((MatchRule_RequiredAndMatchingForAllExports == MatchRule)? 
                                 L", every function in a state object must be associated to either the same sububject definition, or if there are different subobjects their respective definitions must match. "
                             : L" it is optional to associate them to any given function, but for any function in a state object that has this type of subobject associated, it must either match the subobject (if any) associated with other functions in the state object, or if there are different subobjects their respective definitions must match. ")
-                            << L"In this case function " << PrettyPrintPossiblyMangledName(function.first) << L" has a different definition for this subobject type than another function in the same state object: " <<
+                            << L"In this case function " << PrettyPrintPossiblyMangledName(function.m_MangledName) << L" has a different definition for this subobject type than another function in the same state object: " <<
                             PrettyPrintPossiblyMangledName(m_TraversalGlobals.pNameOfExportWithReferenceSubobject) << L".");            
                         }
                         break;
@@ -1148,7 +1252,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                             : (bMatchScopeLocal ? L"(not including definition in any contained collections)" : L"(including definition in any contained collections) ")) <<
                             L"has this type of subobject associated, all functions either have the same subobject associated, or if there are different subobjects their respective definitions must match. "
                             << L"In this case function " <<
-                            PrettyPrintPossiblyMangledName(function.first) << L" has a different definition for (or presence of) this subobject type than another function in the same state object: " <<
+                            PrettyPrintPossiblyMangledName(function.m_MangledName) << L" has a different definition for (or presence of) this subobject type than another function in the same state object: " <<
                             PrettyPrintPossiblyMangledName(m_TraversalGlobals.pNameOfExportWithReferenceSubobject) << L".");   
                         }
                         break;
@@ -1177,7 +1281,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                     }
                     pRefSubobject = pCurrSubobject;
 #ifdef INCLUDE_MESSAGE_LOG
-                    m_TraversalGlobals.pNameOfExportWithReferenceSubobject = function.first;
+                    m_TraversalGlobals.pNameOfExportWithReferenceSubobject = function.m_MangledName;
 #endif                    
                 }
             }            
@@ -1190,11 +1294,11 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
             case MatchRule_IfExistsMustMatchOthersThatExistPlusShaderEntry:
             case MatchRule_IfExistsMustExistAndMatchForAllExports:
             {
-                for(auto& ex : m_ExportInfoList)
+                for(auto& ex : m_ExportInfos)
                 {
                     if(ShaderKind::Library == (ShaderKind)ex.m_pFunctionInfo->ShaderKind)
                     {
-                        TraverseFunctionsFindFirstSubobjectInLibraryFunctionSubtrees(ex.m_MangledName);
+                        TraverseFunctionsFindFirstSubobjectInLibraryFunctionSubtrees(&ex);
                     }
                 }
                 m_TraversalGlobals.GraphTraversalIndex++; // considering traversals for all exports as one merge graph traversal for efficiency 
@@ -1207,7 +1311,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                 break;
             }
             }
-            for(auto& ex : m_ExportInfoList)
+            for(auto& ex : m_ExportInfos)
             {            
                 m_TraversalGlobals.bRootIsEntryFunction = (ShaderKind::Library != (ShaderKind)ex.m_pFunctionInfo->ShaderKind);
                 if(  ((MatchRule_IfExistsMustMatchOthersThatExistPlusShaderEntry == MatchRule) && m_TraversalGlobals.bRootIsEntryFunction)
@@ -1221,7 +1325,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
                     m_TraversalGlobals.bAssignedRef = true;
                     m_TraversalGlobals.pReferenceSubobject = ex.m_pFirstSubobjectInLibraryFunctionSubtree;
                 }
-                TraverseFunctionsSubobjectConsistency(ex.m_MangledName);
+                TraverseFunctionsSubobjectConsistency(&ex);
             }
             m_TraversalGlobals.GraphTraversalIndex++; // considering traversals for all exports as one merge graph traversal for efficiency            
             break;
@@ -1399,7 +1503,7 @@ void CStateObjectInfo::ResolveSubobjectAssociations()
 #ifndef SKIP_BINDING_VALIDATION
 void CStateObjectInfo::ResolveResourceBindings()
 {
-    for(auto& ex : m_ExportInfoList)
+    for(auto& ex : m_ExportInfos)
     {
         CRootSigPair& RSP = m_TraversalGlobals.RootSigs;
         RSP.m_pGlobal = ex.m_Associations[ASN_GLOBAL_ROOT_SIGNATURE].size() 
@@ -1425,11 +1529,11 @@ void CStateObjectInfo::ResolveResourceBindings()
         }
         if(bPairValidationSucceeded)
         {
-            TraverseFunctionsResourceBindingValidation(ex.m_MangledName);
+            TraverseFunctionsResourceBindingValidation(&ex);
             // Don't need to increment graph traversal index since this traversal doesn't touch the index: m_TraversalGlobals.GraphTraversalIndex++;
         }
     }
-    for(auto& ex : m_ExportInfoList)
+    for(auto& ex : m_ExportInfos)
     {
         ex.m_RootSigsValidatedOnSubtree.clear();
     }
@@ -1438,36 +1542,35 @@ void CStateObjectInfo::ResolveResourceBindings()
 //----------------------------------------------------------------------------------------------------------------------------------
 // CStateObjectInfo::TraverseFunctionsResourceBindingValidation
 //----------------------------------------------------------------------------------------------------------------------------------
-void CStateObjectInfo::TraverseFunctionsResourceBindingValidation(LPCWSTR function)
+void CStateObjectInfo::TraverseFunctionsResourceBindingValidation(CExportInfo* pExportInfo)
 {
-    auto ex = m_ExportInfoMap.find(LocalUniqueCopy(function));
-    if(ex == m_ExportInfoMap.end())
+    if(!pExportInfo)
     {
         return; // ignore unresolved exports
     }    
-    auto pFuncInfo = ex->second->m_pFunctionInfo;
-    auto& flags = ex->second->m_GraphTraversalFlags;
+    auto pFuncInfo = pExportInfo->m_pFunctionInfo;
+    auto& flags = pExportInfo->m_GraphTraversalFlags;
     if(flags & CExportInfo::GTF_CycleFound)
     {
         return; // skip graph cycles 
     }        
-    if(ex->second->m_RootSigsValidatedOnSubtree.find(m_TraversalGlobals.RootSigs) != ex->second->m_RootSigsValidatedOnSubtree.end())
+    if(pExportInfo->m_RootSigsValidatedOnSubtree.find(m_TraversalGlobals.RootSigs) != pExportInfo->m_RootSigsValidatedOnSubtree.end())
     {
         return; // already validated this subtree against these root signatures
     }
     // Validate this function against root signatures    
     RLFECallbackContext cc;
-    cc.pLibraryFunction = function;
-    cc.pExportInfo = ex->second;
+    cc.pLibraryFunction = pExportInfo->m_MangledName;
+    cc.pExportInfo = pExportInfo;
     cc.pThis = this;
     m_TraversalGlobals.pRootSigVerifier->m_RSV.VerifyLibraryFunction(pFuncInfo,&cc,ReportLibraryFunctionErrorCallback);
 
     // Validate subtree against root signatures
-    for(UINT i = 0; i < pFuncInfo->NumFunctionDependencies; i++)
+    for(UINT i = 0; i < pExportInfo->m_NumDependencies; i++)
     {
-        TraverseFunctionsResourceBindingValidation(pFuncInfo->FunctionDependencies[i]);
+        TraverseFunctionsResourceBindingValidation(GetDependency(pExportInfo,i));
     }
-    ex->second->m_RootSigsValidatedOnSubtree.insert(m_TraversalGlobals.RootSigs);
+    pExportInfo->m_RootSigsValidatedOnSubtree.insert(m_TraversalGlobals.RootSigs);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -1571,7 +1674,7 @@ void CStateObjectInfo::ValidateRootSignaturePair(const CRootSigPair& RootSigs, C
 //----------------------------------------------------------------------------------------------------------------------------------
 void CStateObjectInfo::ValidateMiscAssociations()
 {
-    for(auto& ex : m_ExportInfoList)
+    for(auto& ex : m_ExportInfos)
     {
         auto pSOInfo = ex.m_Associations[ASN_RAYTRACING_SHADER_CONFIG].size() ? ex.m_Associations[ASN_RAYTRACING_SHADER_CONFIG].front()->m_pSubobject : nullptr;
         auto pConfig = pSOInfo ? (const D3D12_RAYTRACING_SHADER_CONFIG*)pSOInfo->m_LocalSubobjectDefinition.pDesc : nullptr;
@@ -1612,7 +1715,7 @@ void CStateObjectInfo::ValidateMiscAssociations()
 //----------------------------------------------------------------------------------------------------------------------------------
 void CStateObjectInfo::ValidateShaderFeatures()
 {
-    for(auto& ex : m_ExportInfoList)
+    for(auto& ex : m_ExportInfos)
     {
         //static const UINT MAJOR_VERSION_MASK  0x000000f0
         //static const UINT MAJOR_VERSION_SHIFT 4
@@ -1639,7 +1742,7 @@ void CStateObjectInfo::ValidateShaderFeatures()
         LOG_ERROR_NOMESSAGE;
 #endif               
         }
-        TraverseFunctionsShaderStageValidation(ex.m_MangledName);
+        TraverseFunctionsShaderStageValidation(&ex);
     }
     m_TraversalGlobals.GraphTraversalIndex++;
 }
@@ -1647,47 +1750,45 @@ void CStateObjectInfo::ValidateShaderFeatures()
 //----------------------------------------------------------------------------------------------------------------------------------
 // CStateObjectInfo::TraverseFunctionsShaderStageValidation
 //----------------------------------------------------------------------------------------------------------------------------------
-UINT CStateObjectInfo::TraverseFunctionsShaderStageValidation(LPCWSTR function)
+UINT CStateObjectInfo::TraverseFunctionsShaderStageValidation(CExportInfo* pExportInfo)
 {
-    auto ex = m_ExportInfoMap.find(LocalUniqueCopy(function));
-    if(ex == m_ExportInfoMap.end())
+    if(!pExportInfo)
     {
         return 0; // ignore unresolved exports
     }    
-    auto pFuncInfo = ex->second->m_pFunctionInfo;
-    auto& flags = ex->second->m_GraphTraversalFlags;
-    if(ex->second->m_VisitedOnGraphTraversalIndex == m_TraversalGlobals.GraphTraversalIndex)
+    auto pFuncInfo = pExportInfo->m_pFunctionInfo;
+    auto& flags = pExportInfo->m_GraphTraversalFlags;
+    if(pExportInfo->m_VisitedOnGraphTraversalIndex == m_TraversalGlobals.GraphTraversalIndex)
     {
-        return ex->second->m_SubtreeValidShaderStageFlag;
+        return pExportInfo->m_SubtreeValidShaderStageFlag;
     }
-    ex->second->m_VisitedOnGraphTraversalIndex = m_TraversalGlobals.GraphTraversalIndex;  
-    ex->second->m_SubtreeValidShaderStageFlag |= pFuncInfo->ShaderStageFlag | 0xffffffff; // TODO: remove 0xfffffff when DXC supports this
+    pExportInfo->m_VisitedOnGraphTraversalIndex = m_TraversalGlobals.GraphTraversalIndex;  
+    pExportInfo->m_SubtreeValidShaderStageFlag |= pFuncInfo->ShaderStageFlag | 0xffffffff; // TODO: remove 0xfffffff when DXC supports this
     if(flags & CExportInfo::GTF_CycleFound)
     {
-        return ex->second->m_SubtreeValidShaderStageFlag; // skip graph cycles 
+        return pExportInfo->m_SubtreeValidShaderStageFlag; // skip graph cycles 
     }
-    for(UINT i = 0; i < pFuncInfo->NumFunctionDependencies; i++)
+    for(UINT i = 0; i < pExportInfo->m_NumDependencies; i++)
     {
-        ex->second->m_SubtreeValidShaderStageFlag |= TraverseFunctionsShaderStageValidation(pFuncInfo->FunctionDependencies[i]);
+        pExportInfo->m_SubtreeValidShaderStageFlag |= TraverseFunctionsShaderStageValidation(GetDependency(pExportInfo,i));
     }
     switch((ShaderKind)pFuncInfo->ShaderKind)
     {
     case ShaderKind::Library:
         break;
     default:
-        if(!((1<<pFuncInfo->ShaderKind) & ex->second->m_SubtreeValidShaderStageFlag))
+        if(!((1<<pFuncInfo->ShaderKind) & pExportInfo->m_SubtreeValidShaderStageFlag))
         {
 #ifdef INCLUDE_MESSAGE_LOG            
-            auto unmangledName = m_ExportNameMangledToUnmangled.find(LocalUniqueCopy(function));
             LOG_ERROR(ShaderStageName((ShaderKind)pFuncInfo->ShaderKind) << " shader named " <<
-                PrettyPrintPossiblyMangledName(function) << 
+                PrettyPrintPossiblyMangledName(pExportInfo->m_MangledName) << 
                 L" calls library function(s) where somewhere in the call graph features are used which are not compatible with this shader stage." );
 #else
             LOG_ERROR_NOMESSAGE;
 #endif   
         }
     }
-    return ex->second->m_SubtreeValidShaderStageFlag;    
+    return pExportInfo->m_SubtreeValidShaderStageFlag;    
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -1832,7 +1933,7 @@ void CStateObjectInfo::AddCollection(const D3D12_EXISTING_COLLECTION_DESC* pColl
             for (UINT i = 0; i < pCollection->NumExports; i++)
             {
                 LPCWSTR InternalName = pCollection->pExports[i].ExportToRename ? pCollection->pExports[i].ExportToRename : pCollection->pExports[i].Name;
-                auto matchesUnmangled = pColInfo->m_ExportNameUnmangledToMangled.equal_range(pColInfo->LocalUniqueCopy(InternalName));
+                auto matchesUnmangled = pColInfo->m_ExportNameUnmangledToMangled.equal_range(pColInfo->LocalUniqueLookup(InternalName));
                 // cases: (1) ExportToRename is an unmangled name, Name is unmangled
                 //        (2) ExportToRename is a mangled name, Name is unmangled
                 //        (3) ExportToRename is null, Name is unmangled
@@ -1862,13 +1963,13 @@ void CStateObjectInfo::AddCollection(const D3D12_EXISTING_COLLECTION_DESC* pColl
                 }
                 else
                 {
-                    auto matchMangledExportInfo = pColInfo->m_ExportInfoMap.find(pColInfo->LocalUniqueCopy(InternalName));
+                    auto matchMangledExportInfo = pColInfo->m_ExportInfoMap.find(pColInfo->LocalUniqueLookup(InternalName));
                     if (matchMangledExportInfo != pColInfo->m_ExportInfoMap.end())
                     {
                         if (pCollection->pExports[i].ExportToRename)
                         {
                             // (2) - do a rename
-                            auto mangledOriginalName = pColInfo->LocalUniqueCopy(pCollection->pExports[i].ExportToRename);
+                            auto mangledOriginalName = pColInfo->LocalUniqueLookup(pCollection->pExports[i].ExportToRename);
                             auto unmangledOriginalExportName = pColInfo->m_ExportNameMangledToUnmangled.find(mangledOriginalName);
                             assert(unmangledOriginalExportName != pColInfo->m_ExportNameMangledToUnmangled.end());
                             AddExportWrapper(RenameMangledName(pCollection->pExports[i].ExportToRename, unmangledOriginalExportName->second, pCollection->pExports[i].Name),
@@ -1878,7 +1979,7 @@ void CStateObjectInfo::AddCollection(const D3D12_EXISTING_COLLECTION_DESC* pColl
                         else
                         {
                             // (4) - no rename
-                            auto mangledOriginalName = pColInfo->LocalUniqueCopy(pCollection->pExports[i].Name);
+                            auto mangledOriginalName = pColInfo->LocalUniqueLookup(pCollection->pExports[i].Name);
                             auto unmangledOriginalExportName = pColInfo->m_ExportNameMangledToUnmangled.find(mangledOriginalName);
                             assert(unmangledOriginalExportName != pColInfo->m_ExportNameMangledToUnmangled.end());
                             AddExportWrapper(pCollection->pExports[i].Name, unmangledOriginalExportName->second, mangledOriginalName, matchMangledExportInfo->second);
@@ -1895,7 +1996,7 @@ void CStateObjectInfo::AddCollection(const D3D12_EXISTING_COLLECTION_DESC* pColl
             for(auto& ex : ExportMissing)
             {
                 LPCWSTR InternalName = ex->ExportToRename ? ex->ExportToRename : ex->Name;
-                auto match = pColInfo->m_HitGroups.find(pColInfo->LocalUniqueCopy(InternalName));
+                auto match = pColInfo->m_HitGroups.find(pColInfo->LocalUniqueLookup(InternalName));
                 if(match != pColInfo->m_HitGroups.end())
                 {
                     D3D12_HIT_GROUP_DESC newHgDesc = *match->second;
@@ -2406,7 +2507,7 @@ void CStateObjectInfo::AddSubobjectToExportsAssociation(
 // CStateObjectInfo::GetLog
 //----------------------------------------------------------------------------------------------------------------------------------
 #ifdef INCLUDE_MESSAGE_LOG
-const std::list<std::wstring>& CStateObjectInfo::GetLog()
+const std::vector<std::wstring>& CStateObjectInfo::GetLog()
 {
     return m_Log;
 }
@@ -2427,20 +2528,23 @@ void CStateObjectInfo::Log(std::wostringstream& message)
 //----------------------------------------------------------------------------------------------------------------------------------
 LPCWSTR CStateObjectInfo::LocalUniqueCopy(LPCWSTR string)
 {
-    return LocalUniqueCopy(string,m_StringContainer);
+    return LocalUniqueCopy(string,m_Names);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
 // CStateObjectInfo::LocalUniqueCopy (with external container)
 //----------------------------------------------------------------------------------------------------------------------------------
-LPCWSTR CStateObjectInfo::LocalUniqueCopy(LPCWSTR string, std::unordered_set<std::wstring>& stringContainer)
+LPCWSTR CStateObjectInfo::LocalUniqueCopy(LPCWSTR string, CNameTable& stringContainer)
 {
-    if (string == nullptr)
-    {
-        return nullptr;
-    }
-    auto result = stringContainer.insert(string);
-    return result.first->c_str();
+    return stringContainer.Intern(string);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// CStateObjectInfo::LocalUniqueLookup
+//----------------------------------------------------------------------------------------------------------------------------------
+LPCWSTR CStateObjectInfo::LocalUniqueLookup(LPCWSTR string) const
+{
+    return m_Names.Find(string);
 }
 
 //----------------------------------------------------------------------------------------------------------------------------------
@@ -2557,9 +2661,9 @@ void CStateObjectInfo::PrepareForInformationReflection()
     {
         return;
     }
-    m_ExportArrayForReflection.resize(m_ExportInfoList.size());
+    m_ExportArrayForReflection.resize(m_ExportInfos.size());
     size_t index = 0;
-    for(auto& ex : m_ExportInfoList)
+    for(auto& ex : m_ExportInfos)
     {
         m_ExportArrayForReflection[index++] = &ex;
     }
@@ -2863,7 +2967,7 @@ void CStateObjectInfo::CExportedHitGroupIterator::Next(EXPORTED_HIT_GROUP const*
 void CStateObjectInfo::LookupExportedHitGroup(LPCWSTR NameToLookup, EXPORTED_HIT_GROUP const* pOutExportedHitGroup)
 {
     auto pOut = const_cast<EXPORTED_HIT_GROUP*>(pOutExportedHitGroup);
-    auto Match = m_HitGroups.find(LocalUniqueCopy(NameToLookup));
+    auto Match = m_HitGroups.find(LocalUniqueLookup(NameToLookup));
     if(Match == m_HitGroups.end())
     {
         *pOut = {};
@@ -3034,7 +3138,7 @@ void CStateObjectInfo::CExportedFunctionLookup::ResetAndSelectExport(LPCWSTR Nam
         return;
     }
     // Try unmangled search
-    LPCWSTR LocalName = m_pSOI->LocalUniqueCopy(NameToLookup);
+    LPCWSTR LocalName = m_pSOI->LocalUniqueLookup(NameToLookup);
     m_Count = m_pSOI->m_ExportNameUnmangledToMangled.count(LocalName);
     if(m_Count)
     {
@@ -3128,14 +3232,14 @@ void CStateObjectInfo::CAssociatedSubobjectIterator::ResetAndSelectExport(
     {
         goto Clear;
     }
-    ex = m_pSOI->m_ExportInfoMap.find(m_pSOI->LocalUniqueCopy(MangledExportNameOrHitGroupName));
+    ex = m_pSOI->m_ExportInfoMap.find(m_pSOI->LocalUniqueLookup(MangledExportNameOrHitGroupName));
     if( ex != m_pSOI->m_ExportInfoMap.end() )
     {
         m_pAssociationLists = ex->second->m_Associations;
     }
     else
     {
-        auto hg = m_pSOI->m_HitGroups.find(m_pSOI->LocalUniqueCopy(MangledExportNameOrHitGroupName));
+        auto hg = m_pSOI->m_HitGroups.find(m_pSOI->LocalUniqueLookup(MangledExportNameOrHitGroupName));
         if(hg != m_pSOI->m_HitGroups.end())
         {
             m_pAssociationLists = hg->second->m_Associations;
@@ -68,6 +68,40 @@ typedef struct EXPORTED_HIT_GROUP
     bool bUnresolvedAssociations;
 } EXPORTED_HIT_GROUP;
 
+//----------------------------------------------------------------------------------------------------------------------------------
+// CNameTable: Interns the strings a state object refers to.
+//             Each unique string is copied once into chunked arena storage and given a dense ID in order of first use,
+//             so parsing can hash on the returned pointer, or index arrays by ID, instead of hashing string contents.
+//             Returned pointers stay valid for the lifetime of the table.
+//----------------------------------------------------------------------------------------------------------------------------------
+class CNameTable
+{
+public:
+    static const UINT InvalidID = (UINT)-1;
+
+    // Returns the local copy of string (nullptr for nullptr), adding it if it hasn't been seen before.
+    LPCWSTR Intern(LPCWSTR string, UINT* pID = nullptr);
+
+    // Returns the local copy of string, or nullptr if it was never interned.  Doesn't modify the table.
+    LPCWSTR Find(LPCWSTR string) const;
+
+    LPCWSTR GetName(UINT ID) const {return m_Names[ID];}
+    UINT GetCount() const {return (UINT)m_Names.size();}
+
+private:
+    struct CStringHash
+    {
+        size_t operator()(LPCWSTR string) const noexcept;
+        bool operator()(LPCWSTR lhs, LPCWSTR rhs) const {return 0 == wcscmp(lhs,rhs);}
+    };
+    std::unordered_map<LPCWSTR,UINT,CStringHash,CStringHash> m_IDs; // keyed by local copy, hashed on contents
+    std::vector<LPCWSTR> m_Names; // ID -> local copy
+    std::vector<std::unique_ptr<WCHAR[]>> m_Blocks;
+    size_t m_BlockSize = 0; // in characters
+    size_t m_BlockUsed = 0;
+    static const size_t MinBlockSize = 4096;
+};
+
 //=================================================================================================================================
 // CStateObjectInfo
 //
@@ -239,10 +273,10 @@ public:
         const D3D12_STATE_SUBOBJECT* Next();
     private:
         CStateObjectInfo* m_pSOI;
-        std::list<CWrappedAssociation*>* m_pAssociationLists;
+        std::vector<CWrappedAssociation*>* m_pAssociationLists;
         bool m_bIteratingAllTypes;
         size_t m_CurrAssociateableSubobjectType;
-        std::list<CWrappedAssociation*>::iterator m_Iterator;
+        std::vector<CWrappedAssociation*>::iterator m_Iterator;
         size_t m_TotalCount;
     };    
     friend class CAssociatedSubobjectIterator;
@@ -269,7 +303,7 @@ public:
     //           useful when ParseStateObject returns failure.
     //------------------------------------------------------------------------------------------------------------------------------
 #ifdef INCLUDE_MESSAGE_LOG
-    const std::list<std::wstring>& GetLog();
+    const std::vector<std::wstring>& GetLog();
 #endif
 
 private:
@@ -326,13 +360,16 @@ private:
     // LocalUniqueCopy():  allocates a copy of a string stored locally.  
     // Data structures like unordered_maps can hash on the pointer to the string,
     // and references to strings passed in from outside don't need to be held.
+    // LocalUniqueLookup():  same, but returns nullptr instead of making a copy for strings never seen before,
+    // for lookups that must not modify the state object (e.g. reflection, or reading an existing collection).
     //------------------------------------------------------------------------------------------------------------------------------
 public: // TODO: Make these private once experimental code stops needing to point to this class, using reflection iterators instead.
     LPCWSTR LocalUniqueCopy(LPCWSTR string);
-    static LPCWSTR LocalUniqueCopy(LPCWSTR string,std::unordered_set<std::wstring>&stringContainer);
+    static LPCWSTR LocalUniqueCopy(LPCWSTR string,CNameTable& stringContainer);
+    LPCWSTR LocalUniqueLookup(LPCWSTR string) const;
 private:
     // Strings stored by LocalUniqueCopy()
-    std::unordered_set<std::wstring> m_StringContainer;
+    CNameTable m_Names;
 
     //------------------------------------------------------------------------------------------------------------------------------
     // State variables
@@ -366,7 +403,7 @@ private:
     #define LOG_ERROR(x) {LOG(x); m_bFoundError = true;}
     #define LOG_ERROR_IN_CALLBACK(x) {LOG_IN_CALLBACK(x); pThis->m_bFoundError = true;}
     void Log(std::wostringstream& message);
-    std::list<std::wstring> m_Log;
+    std::vector<std::wstring> m_Log;
     LPCWSTR PrettyPrintPossiblyMangledName(LPCWSTR name);
 #else
     #define LOG(x) 
@@ -391,7 +428,7 @@ private:
         D3D12_DXIL_LIBRARY_DESC m_LocalLibraryDesc = {};
     private:
         std::vector<D3D12_EXPORT_DESC> m_Exports;
-        std::unordered_set<std::wstring> m_StringContainer; // local string container so this can be inherited by collections cleanly
+        CNameTable m_StringContainer; // local string container so this can be inherited by collections cleanly
         std::unique_ptr<DxilRuntimeReflection> m_pReflection;
         CDXILLibraryCache* m_pDXILLibraryCache = nullptr;
     };
@@ -428,7 +465,7 @@ private:
     private:
         D3D12_EXISTING_COLLECTION_DESC m_LocalCollectionDesc = {};
         std::vector<D3D12_EXPORT_DESC> m_Exports;
-        std::unordered_set<std::wstring> m_StringContainer;
+        CNameTable m_StringContainer;
     };
     std::list<CWrappedExistingCollection> m_ExistingCollectionList;
 
@@ -634,9 +671,16 @@ private:
         LPCWSTR m_MangledName = nullptr;
         LPCWSTR m_UnmangledName = nullptr;
         const DxilFunctionDesc* m_pFunctionInfo = nullptr;
-        std::list<CWrappedAssociation*> m_Associations[NUM_ASSOCIATEABLE_SUBOBJECT_TYPES];
+        std::vector<CWrappedAssociation*> m_Associations[NUM_ASSOCIATEABLE_SUBOBJECT_TYPES];
         CStateObjectInfo* m_pOwningStateObject = nullptr;
 
+        // Call graph edges, m_NumDependencies entries in m_DependencyIDs starting at m_FirstDependency.
+        // They hold name IDs (in m_Names) as exports are added, and are replaced by indices into m_ExportInfos
+        // (or CNameTable::InvalidID if unresolved) in ResolveFunctionDependencies.
+        UINT m_FirstDependency = 0;
+        UINT m_NumDependencies = 0;
+        UINT m_NameID = CNameTable::InvalidID; // ID of m_MangledName in m_Names
+
         // The following are used during various graph traversals
         UINT64 m_VisitedOnGraphTraversalIndex = (UINT64)-1;
         CAssociateableSubobjectInfo* m_pFirstSubobjectInLibraryFunctionSubtree = nullptr;
@@ -668,25 +712,26 @@ private:
                    const DxilFunctionDesc* pInfo, 
                    CStateObjectInfo* pOwningStateObject,
                    bool bExternalDependenciesOnThisExportAllowed);
-    void TraverseFunctionsInitialValidation(LPCWSTR function);
+    CExportInfo* GetDependency(const CExportInfo* pExportInfo, UINT i); // nullptr if unresolved
+    void TraverseFunctionsInitialValidation(CExportInfo* pExportInfo);
     class CAssociateableSubobjectInfo;
-    CAssociateableSubobjectInfo* TraverseFunctionsFindFirstSubobjectInLibraryFunctionSubtrees(LPCWSTR function);
-    void TraverseFunctionsSubobjectConsistency(LPCWSTR function);
+    CAssociateableSubobjectInfo* TraverseFunctionsFindFirstSubobjectInLibraryFunctionSubtrees(CExportInfo* pExportInfo);
+    void TraverseFunctionsSubobjectConsistency(CExportInfo* pExportInfo);
 #ifndef SKIP_BINDING_VALIDATION
-    void TraverseFunctionsResourceBindingValidation(LPCWSTR function);
+    void TraverseFunctionsResourceBindingValidation(CExportInfo* pExportInfo);
     void ValidateRootSignaturePair(const CRootSigPair& RootSigs, CRootSigVerifier* pVerifier);
 #endif
-    UINT TraverseFunctionsShaderStageValidation(LPCWSTR function);
+    UINT TraverseFunctionsShaderStageValidation(CExportInfo* pExportInfo);
     static void FillExportedFunction(EXPORTED_FUNCTION* pEF, const CExportInfo* pEI);
     //------------------------------------------------------------------------------------------------------------------------------
     // Export related data
     //------------------------------------------------------------------------------------------------------------------------------
-    std::list<CExportInfo> m_ExportInfoList; // Instances of CExportInfo that structures like m_ExportInfoMap below can point to
+    std::deque<CExportInfo> m_ExportInfos; // Instances of CExportInfo that structures like m_ExportInfoMap below can point to,
+                                           // in the order exports were added
     std::unordered_map<LPCWSTR, CExportInfo*> m_ExportInfoMap; // mangled name -> CExportInfo*
     std::unordered_multimap<LPCWSTR, LPCWSTR> m_ExportNameUnmangledToMangled; // unmangled name -> mangled name exported
     std::unordered_map<LPCWSTR, LPCWSTR> m_ExportNameMangledToUnmangled; // exported mangled name -> unmangled name
-    std::unordered_multimap<LPCWSTR,CExportInfo*> m_Dependencies; // multiple callers (CExportInfo* for each) can depend 
-                                                                  // on any given function
+    std::vector<UINT> m_DependencyIDs; // call graph edges for all exports, see CExportInfo::m_FirstDependency
     std::unordered_set<LPCWSTR> m_UsedUnmangledFunctionNames; // unmangled function names and non-function (e.g. hitgroup) names 
                                                               // can't collide, for simplicity
     std::unordered_set<LPCWSTR> m_UsedNonFunctionNames;                                                                  
@@ -722,7 +767,7 @@ private:
         bool m_bUnresolvedFunctions = false;
         CStateObjectInfo* m_pOwningStateObject = nullptr;
         D3D12_STATE_SUBOBJECT m_LocalSubobjectDefinition = {};
-        std::list<CWrappedAssociation*> m_Associations[NUM_ASSOCIATEABLE_SUBOBJECT_TYPES];
+        std::vector<CWrappedAssociation*> m_Associations[NUM_ASSOCIATEABLE_SUBOBJECT_TYPES];
     };
 
     //------------------------------------------------------------------------------------------------------------------------------
@@ -35,6 +35,7 @@ void main(uint3 DTid : SV_DispatchThreadID)
     {
         outputBVH.Store(OffsetToBoxesOffset, offsetToBoxes);
         outputBVH.Store(OffsetToLeafNodeMetaDataOffset, offsetToLeafNodeMetadata);
+        outputBVH.Store(OffsetToPrimitiveMetaDataOffset, 0); // Marks this as a top-level BVH, see IsTopLevelBVH
         outputBVH.Store(OffsetToTotalSize, totalSize);
 
         if (IsEmptyAccelerationStructure)
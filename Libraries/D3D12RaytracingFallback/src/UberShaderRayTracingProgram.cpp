@@ -42,15 +42,22 @@ namespace FallbackLayer
       return nullptr;
     }
 
-    StateIdentifier UberShaderRaytracingProgram::GetStateIdentfier(LPCWSTR pExportName)
+    static const UberShaderRaytracingProgram::ShaderData *FindShaderData(
+        const std::unordered_map<std::wstring, UberShaderRaytracingProgram::ShaderData> &exportNameToShaderData,
+        LPCWSTR pExportName)
     {
-        auto shaderData = GetShaderData(pExportName);
-        return shaderData ? shaderData->stateIdentifier.StateId : (StateIdentifier)0u;
+        if (pExportName)
+        {
+            auto shaderData = exportNameToShaderData.find(pExportName);
+            if (shaderData != exportNameToShaderData.end())
+            {
+                return &shaderData->second;
+            }
+        }
+        return nullptr;
     }
 
-
-    UberShaderRaytracingProgram::UberShaderRaytracingProgram(ID3D12Device *pDevice, DxilShaderPatcher &dxilShaderPatcher, const StateObjectCollection &stateObjectCollection) :
-        m_DxilShaderPatcher(dxilShaderPatcher)
+    void UberShaderRaytracingProgram::Link(ID3D12Device *pDevice, DxilShaderPatcher &dxilShaderPatcher, const StateObjectCollection &stateObjectCollection, LinkedProgram &linkedProgram)
     {
         UINT numLibraries = (UINT)stateObjectCollection.m_dxilLibraries.size();
 
@@ -78,7 +85,7 @@ namespace FallbackLayer
                 auto &inputLib = stateObjectCollection.m_dxilLibraries[i];
                 libraryInfo.emplace_back((void *)inputLib.DXILLibrary.pShaderBytecode, inputLib.DXILLibrary.BytecodeLength);
             }
-            m_DxilShaderPatcher.RenameAndLink(libraryInfo, stateObjectCollection.m_exportDescs, &pAppLibrariesBlob);
+            dxilShaderPatcher.RenameAndLink(libraryInfo, stateObjectCollection.m_exportDescs, &pAppLibrariesBlob);
         }
 
         
@@ -111,7 +118,7 @@ namespace FallbackLayer
                     shaderInfo.ExportName = exportName.c_str();
 
                     CComPtr<IDxcBlob> pPatchedBlob;
-                    m_DxilShaderPatcher.PatchShaderBindingTables(
+                    dxilShaderPatcher.PatchShaderBindingTables(
                         (const BYTE *)outputLibInfo.pByteCode,
                         (UINT)outputLibInfo.BytecodeLength,
                         &shaderInfo,
@@ -136,7 +143,11 @@ namespace FallbackLayer
 
         CComPtr<IDxcBlob> pCollectionBlob;
         std::vector<DxcShaderInfo> shaderInfo;
-        m_DxilShaderPatcher.LinkCollection(stateObjectCollection.m_maxAttributeSizeInBytes, librariesInfo, exportNames, shaderInfo, &pCollectionBlob);
+        dxilShaderPatcher.LinkCollection(stateObjectCollection.m_maxAttributeSizeInBytes, librariesInfo, exportNames, shaderInfo, &pCollectionBlob);
+
+        auto &exportNameToShaderData = linkedProgram.m_exportNameToShaderData;
+        UINT largestNonRayGenStackSize = 0;
+        UINT largestRayGenStackSize = 0;
 
         UINT traceRayStackSize = shaderInfo[exportNames.size() - 1].StackSize;
         for (size_t i = 0; i < exportNames.size() - 1; ++i)
@@ -146,15 +157,15 @@ namespace FallbackLayer
             UINT shaderStackSize = shader.StackSize;
             if (isRaygen)
             {
-                m_largestRayGenStackSize = std::max(shaderStackSize, m_largestRayGenStackSize);
+                largestRayGenStackSize = std::max(shaderStackSize, largestRayGenStackSize);
             }
             else if (shader.Type == ShaderType::Miss)
             {
                 shaderStackSize += traceRayStackSize;
-                m_largestNonRayGenStackSize = std::max(shaderStackSize, m_largestNonRayGenStackSize);
+                largestNonRayGenStackSize = std::max(shaderStackSize, largestNonRayGenStackSize);
             }
 
-            m_ExportNameToShaderData[exportNames[i]] = { {shader.Identifier, 0}, shaderStackSize };
+            exportNameToShaderData[exportNames[i]] = { {shader.Identifier, 0}, shaderStackSize };
         }
 
         for (auto &hitGroupMapEntry : stateObjectCollection.m_hitGroups)
@@ -163,25 +174,36 @@ namespace FallbackLayer
             auto anyHitName = hitGroupMapEntry.second.AnyHitShaderImport;
             auto intersectionName = hitGroupMapEntry.second.IntersectionShaderImport;
 
+            auto pClosestHit = FindShaderData(exportNameToShaderData, closestHitName);
+            auto pAnyHit = FindShaderData(exportNameToShaderData, anyHitName);
+            auto pIntersection = FindShaderData(exportNameToShaderData, intersectionName);
+
             ShaderIdentifier shaderId = {};
-            shaderId.StateId = GetStateIdentfier(closestHitName);
-            shaderId.AnyHitId = GetStateIdentfier(anyHitName);
-            shaderId.IntersectionShaderId = GetStateIdentfier(intersectionName);
-            UINT shaderStackSize = (UINT)std::max(std::max(
-                GetShaderStackSize(closestHitName), GetShaderStackSize(anyHitName)), GetShaderStackSize(intersectionName));
+            shaderId.StateId = pClosestHit ? pClosestHit->stateIdentifier.StateId : 0;
+            shaderId.AnyHitId = pAnyHit ? pAnyHit->stateIdentifier.StateId : 0;
+            shaderId.IntersectionShaderId = pIntersection ? pIntersection->stateIdentifier.StateId : 0;
+            UINT shaderStackSize = std::max(std::max(
+                pClosestHit ? pClosestHit->stackSize : 0u, pAnyHit ? pAnyHit->stackSize : 0u), pIntersection ? pIntersection->stackSize : 0u);
 
-            m_largestNonRayGenStackSize = std::max(shaderStackSize + traceRayStackSize, m_largestNonRayGenStackSize);
+            largestNonRayGenStackSize = std::max(shaderStackSize + traceRayStackSize, largestNonRayGenStackSize);
             auto hitGroupName = hitGroupMapEntry.first;
-            m_ExportNameToShaderData[hitGroupName] = { shaderId, shaderStackSize };
+            exportNameToShaderData[hitGroupName] = { shaderId, shaderStackSize };
         }
 
-        UINT stackSize = stateObjectCollection.m_config.MaxTraceRecursionDepth * m_largestNonRayGenStackSize + m_largestRayGenStackSize;
+        UINT stackSize = stateObjectCollection.m_config.MaxTraceRecursionDepth * largestNonRayGenStackSize + largestRayGenStackSize;
         CComPtr<IDxcBlob> pLinkedBlob;
-        m_DxilShaderPatcher.LinkStateObject(stateObjectCollection.m_maxAttributeSizeInBytes, stackSize, pCollectionBlob, exportNames, shaderInfo, &pLinkedBlob);
+        dxilShaderPatcher.LinkStateObject(stateObjectCollection.m_maxAttributeSizeInBytes, stackSize, pCollectionBlob, exportNames, shaderInfo, &pLinkedBlob);
 
+        const BYTE *pLinkedBytecode = (const BYTE *)pLinkedBlob->GetBufferPointer();
+        linkedProgram.m_shaderBytecode.assign(pLinkedBytecode, pLinkedBytecode + pLinkedBlob->GetBufferSize());
+    }
+
+    UberShaderRaytracingProgram::UberShaderRaytracingProgram(ID3D12Device *pDevice, const StateObjectCollection &stateObjectCollection, LinkedProgram &&linkedProgram) :
+        m_ExportNameToShaderData(std::move(linkedProgram.m_exportNameToShaderData))
+    {
         CompilePSO(
             pDevice, 
-            CD3DX12_SHADER_BYTECODE(pLinkedBlob->GetBufferPointer(), pLinkedBlob->GetBufferSize()), 
+            CD3DX12_SHADER_BYTECODE(linkedProgram.m_shaderBytecode.data(), linkedProgram.m_shaderBytecode.size()), 
             stateObjectCollection, 
             &m_pRayTracePSO);
         
@@ -15,7 +15,23 @@ namespace FallbackLayer
     class UberShaderRaytracingProgram : public IRaytracingProgram
     {
     public:
-        UberShaderRaytracingProgram(ID3D12Device *m_pDevice, DxilShaderPatcher &dxilShaderPatcher, const StateObjectCollection &stateObjectCollection);
+        struct ShaderData
+        {
+          ShaderIdentifier stateIdentifier;
+          UINT stackSize;
+        };
+
+        // Output of the DXIL patching and linking steps. It only depends on the contents
+        // of the state object, so it can be cached and used to recreate the program.
+        struct LinkedProgram
+        {
+            std::vector<BYTE> m_shaderBytecode;
+            std::unordered_map<std::wstring, ShaderData> m_exportNameToShaderData;
+        };
+
+        static void Link(ID3D12Device *pDevice, DxilShaderPatcher &dxilShaderPatcher, const StateObjectCollection &stateObjectCollection, LinkedProgram &linkedProgram);
+
+        UberShaderRaytracingProgram(ID3D12Device *pDevice, const StateObjectCollection &stateObjectCollection, LinkedProgram &&linkedProgram);
         virtual ~UberShaderRaytracingProgram() {}
         virtual void DispatchRays(
             ID3D12GraphicsCommandList *pCommandList, 
@@ -33,22 +49,10 @@ namespace FallbackLayer
         }
         std::function<void(ID3D12GraphicsCommandList *, UINT)> m_pPredispatchCallback;
     private:
-        StateIdentifier GetStateIdentfier(LPCWSTR pExportName);
-
-        DxilShaderPatcher &m_DxilShaderPatcher;
-        struct ShaderData
-        {
-          ShaderIdentifier stateIdentifier;
-          UINT stackSize;
-        };
-
         ShaderData *GetShaderData(LPCWSTR pExportName);
 
         std::unordered_map<std::wstring, ShaderData> m_ExportNameToShaderData;
         CComPtr<ID3D12PipelineState> m_pRayTracePSO;
         UINT m_patchRootSignatureParameterStart;
-
-        UINT m_largestNonRayGenStackSize = 0;
-        UINT m_largestRayGenStackSize = 0;
     };
 }
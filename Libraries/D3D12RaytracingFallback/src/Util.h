@@ -180,3 +180,67 @@ static UINT GetNumParameters(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC &desc)
     }
     return numParameters;
 }
+
+// Splits [0, count) into contiguous ranges and calls func(begin, end) for each range on
+// its own thread, including the calling thread. Ranges hold at least minItemsPerThread items.
+// The first exception thrown by any range is rethrown on the calling thread.
+template <typename Func>
+void ParallelFor(UINT count, UINT minItemsPerThread, Func func)
+{
+    const UINT hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const UINT numThreads = std::max(1u, std::min(hardwareThreads, count / std::max(1u, minItemsPerThread)));
+    const UINT itemsPerThread = DivideAndRoundUp(std::max(1u, count), numThreads);
+
+    std::vector<std::exception_ptr> exceptions(numThreads);
+    auto RunRange = [&](UINT threadIndex)
+    {
+        try
+        {
+            const UINT begin = threadIndex * itemsPerThread;
+            const UINT end = std::min(count, begin + itemsPerThread);
+            if (begin < end)
+            {
+                func(begin, end);
+            }
+        }
+        catch (...)
+        {
+            exceptions[threadIndex] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (UINT i = 1; i < numThreads; i++)
+    {
+        threads.emplace_back(RunRange, i);
+    }
+    RunRange(0);
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto &exception : exceptions)
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+}
+
+// Calls func(index) for every index in [0, count), handing out one index at a time
+// to the worker threads. Use instead of ParallelFor when items vary a lot in cost.
+template <typename Func>
+void ParallelForEach(UINT count, Func func)
+{
+    std::atomic<UINT> nextIndex(0);
+    ParallelFor(count, 1, [&](UINT, UINT)
+    {
+        for (UINT index = nextIndex++; index < count; index = nextIndex++)
+        {
+            func(index);
+        }
+    });
+}
@@ -25,6 +25,10 @@
 #include <unordered_set>
 #include <map>
 #include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
 #include <string>
 #include <strsafe.h>
 #include "d3d12_1.h"
@@ -63,10 +67,14 @@
 #include "TraversalShaderBuilder.h"
 #include "RaytracingProgram.h"
 #include "RaytracingProgramFactory.h"
+#include "UberShaderRaytracingProgram.h"
+#include "StateObjectCache.h"
 #include "FallbackLayer.h"
 
 // Validators
 #include "BVHValidator.h"
+#include "CompressedWideBvhValidator.h"
+#include "BvhStatistics.h"
 
 // Traversal Builders
 #include "BVHTraversalShaderBuilder.h"
@@ -86,10 +94,10 @@
 #include "GpuBvh2Copy.h"
 #include "TreeletReorder.h"
 #include "GpuBvh2Builder.h"
+#include "CompressedWideBvh.h"
 
 // Dispatchers
 #include "UberShaderBindings.h"
-#include "UberShaderRaytracingProgram.h"
 
 #define USE_PIX_MARKERS 1
 #if USE_PIX_MARKERS
@@ -0,0 +1,1257 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "d3dx12affinity.h"
+#include "Utils.h"
+
+namespace
+{
+    enum CommandOpcode : UINT32
+    {
+        OpSetAffinityMask,
+        OpClearState,
+        OpDrawInstanced,
+        OpDrawIndexedInstanced,
+        OpDispatch,
+        OpCopyBufferRegion,
+        OpCopyTextureRegion,
+        OpCopyResource,
+        OpCopyTiles,
+        OpResolveSubresource,
+        OpIASetPrimitiveTopology,
+        OpRSSetViewports,
+        OpRSSetScissorRects,
+        OpOMSetBlendFactor,
+        OpOMSetStencilRef,
+        OpSetPipelineState,
+        OpResourceBarrier,
+        OpExecuteBundle,
+        OpSetDescriptorHeaps,
+        OpSetComputeRootSignature,
+        OpSetGraphicsRootSignature,
+        OpSetComputeRootDescriptorTable,
+        OpSetGraphicsRootDescriptorTable,
+        OpSetComputeRoot32BitConstants,
+        OpSetGraphicsRoot32BitConstants,
+        OpSetComputeRootConstantBufferView,
+        OpSetGraphicsRootConstantBufferView,
+        OpSetComputeRootShaderResourceView,
+        OpSetGraphicsRootShaderResourceView,
+        OpSetComputeRootUnorderedAccessView,
+        OpSetGraphicsRootUnorderedAccessView,
+        OpIASetIndexBuffer,
+        OpIASetVertexBuffers,
+        OpSOSetTargets,
+        OpOMSetRenderTargets,
+        OpClearDepthStencilView,
+        OpClearRenderTargetView,
+        OpClearUnorderedAccessViewUint,
+        OpClearUnorderedAccessViewFloat,
+        OpDiscardResource,
+        OpBeginQuery,
+        OpEndQuery,
+        OpResolveQueryData,
+        OpSetPredication,
+        OpSetMarker,
+        OpBeginEvent,
+        OpEndEvent,
+        OpExecuteIndirect,
+        OpBroadcastResource,
+    };
+
+
+    // Command arguments as they were passed to the affinity command list. Arrays and structs
+    // the arguments point at are copied into the stream, either into the command itself or
+    // into a payload that directly follows it.
+
+    struct SetAffinityMaskCommand
+    {
+        UINT AffinityMask;
+    };
+
+    struct PipelineStateCommand
+    {
+        CD3DX12AffinityPipelineState* pPipelineState;
+    };
+
+    struct DrawInstancedCommand
+    {
+        UINT VertexCountPerInstance;
+        UINT InstanceCount;
+        UINT StartVertexLocation;
+        UINT StartInstanceLocation;
+    };
+
+    struct DrawIndexedInstancedCommand
+    {
+        UINT IndexCountPerInstance;
+        UINT InstanceCount;
+        UINT StartIndexLocation;
+        INT BaseVertexLocation;
+        UINT StartInstanceLocation;
+    };
+
+    struct DispatchCommand
+    {
+        UINT ThreadGroupCountX;
+        UINT ThreadGroupCountY;
+        UINT ThreadGroupCountZ;
+    };
+
+    struct CopyBufferRegionCommand
+    {
+        CD3DX12AffinityResource* pDstBuffer;
+        UINT64 DstOffset;
+        CD3DX12AffinityResource* pSrcBuffer;
+        UINT64 SrcOffset;
+        UINT64 NumBytes;
+    };
+
+    struct CopyTextureRegionCommand
+    {
+        D3DX12_AFFINITY_TEXTURE_COPY_LOCATION Dst;
+        D3DX12_AFFINITY_TEXTURE_COPY_LOCATION Src;
+        UINT DstX;
+        UINT DstY;
+        UINT DstZ;
+        BOOL HasSrcBox;
+        D3D12_BOX SrcBox;
+    };
+
+    struct CopyResourceCommand
+    {
+        CD3DX12AffinityResource* pDstResource;
+        CD3DX12AffinityResource* pSrcResource;
+    };
+
+    struct CopyTilesCommand
+    {
+        CD3DX12AffinityResource* pTiledResource;
+        D3D12_TILED_RESOURCE_COORDINATE TileRegionStartCoordinate;
+        D3D12_TILE_REGION_SIZE TileRegionSize;
+        CD3DX12AffinityResource* pBuffer;
+        UINT64 BufferStartOffsetInBytes;
+        D3D12_TILE_COPY_FLAGS Flags;
+    };
+
+    struct ResolveSubresourceCommand
+    {
+        CD3DX12AffinityResource* pDstResource;
+        CD3DX12AffinityResource* pSrcResource;
+        UINT DstSubresource;
+        UINT SrcSubresource;
+        DXGI_FORMAT Format;
+    };
+
+    struct IASetPrimitiveTopologyCommand
+    {
+        D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology;
+    };
+
+    // Followed by Count viewports, rects, barriers or descriptor heaps.
+    struct ArrayCommand
+    {
+        UINT Count;
+    };
+
+    struct OMSetBlendFactorCommand
+    {
+        BOOL HasBlendFactor;
+        FLOAT BlendFactor[4];
+    };
+
+    struct OMSetStencilRefCommand
+    {
+        UINT StencilRef;
+    };
+
+    struct ExecuteBundleCommand
+    {
+        CD3DX12AffinityGraphicsCommandList* pCommandList;
+    };
+
+    struct RootSignatureCommand
+    {
+        CD3DX12AffinityRootSignature* pRootSignature;
+    };
+
+    struct RootDescriptorTableCommand
+    {
+        UINT RootParameterIndex;
+        D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor;
+    };
+
+    // Followed by Num32BitValuesToSet values.
+    struct Root32BitConstantsCommand
+    {
+        UINT RootParameterIndex;
+        UINT Num32BitValuesToSet;
+        UINT DestOffsetIn32BitValues;
+    };
+
+    struct RootViewCommand
+    {
+        UINT RootParameterIndex;
+        D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+    };
+
+    struct IASetIndexBufferCommand
+    {
+        BOOL HasView;
+        D3D12_INDEX_BUFFER_VIEW View;
+    };
+
+    // Followed by NumViews vertex buffer or stream output views, unless they were unbound.
+    struct BufferViewsCommand
+    {
+        UINT StartSlot;
+        UINT NumViews;
+        BOOL HasViews;
+    };
+
+    // Followed by NumHandles render target descriptors.
+    struct OMSetRenderTargetsCommand
+    {
+        UINT NumRenderTargetDescriptors;
+        UINT NumHandles;
+        BOOL RTsSingleHandleToDescriptorRange;
+        BOOL HasDepthStencil;
+        D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilDescriptor;
+    };
+
+    // Followed by NumRects rects.
+    struct ClearDepthStencilViewCommand
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView;
+        D3D12_CLEAR_FLAGS ClearFlags;
+        FLOAT Depth;
+        UINT8 Stencil;
+        UINT NumRects;
+    };
+
+    // Followed by NumRects rects.
+    struct ClearRenderTargetViewCommand
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView;
+        FLOAT ColorRGBA[4];
+        UINT NumRects;
+    };
+
+    // Followed by NumRects rects. Values holds either UINTs or FLOATs.
+    struct ClearUnorderedAccessViewCommand
+    {
+        D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap;
+        D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle;
+        CD3DX12AffinityResource* pResource;
+        UINT Values[4];
+        UINT NumRects;
+    };
+
+    // Followed by Region.NumRects rects.
+    struct DiscardResourceCommand
+    {
+        CD3DX12AffinityResource* pResource;
+        BOOL HasRegion;
+        D3D12_DISCARD_REGION Region;
+    };
+
+    struct QueryCommand
+    {
+        CD3DX12AffinityQueryHeap* pQueryHeap;
+        D3D12_QUERY_TYPE Type;
+        UINT Index;
+    };
+
+    struct ResolveQueryDataCommand
+    {
+        CD3DX12AffinityQueryHeap* pQueryHeap;
+        D3D12_QUERY_TYPE Type;
+        UINT StartIndex;
+        UINT NumQueries;
+        CD3DX12AffinityResource* pDestinationBuffer;
+        UINT64 AlignedDestinationBufferOffset;
+    };
+
+    struct SetPredicationCommand
+    {
+        CD3DX12AffinityResource* pBuffer;
+        UINT64 AlignedBufferOffset;
+        D3D12_PREDICATION_OP Operation;
+    };
+
+    // Followed by Size bytes of data, unless there was none.
+    struct MarkerCommand
+    {
+        UINT Metadata;
+        UINT Size;
+        BOOL HasData;
+    };
+
+    struct ExecuteIndirectCommand
+    {
+        CD3DX12AffinityCommandSignature* pCommandSignature;
+        UINT MaxCommandCount;
+        CD3DX12AffinityResource* pArgumentBuffer;
+        UINT64 ArgumentBufferOffset;
+        CD3DX12AffinityResource* pCountBuffer;
+        UINT64 CountBufferOffset;
+    };
+
+    struct BroadcastResourceCommand
+    {
+        CD3DX12AffinityResource* pResource;
+        UINT NodeIndex;
+        UINT TargetNodeMask;
+    };
+
+    inline UINT32 AlignToWord(size_t Size)
+    {
+        return static_cast<UINT32>((Size + sizeof(UINT64) - 1) & ~(sizeof(UINT64) - 1));
+    }
+
+    template <typename P, typename T>
+    inline P* GetPayload(T* pCommand)
+    {
+        return reinterpret_cast<P*>(reinterpret_cast<BYTE*>(pCommand) + AlignToWord(sizeof(T)));
+    }
+
+    template <typename P, typename T>
+    inline void CopyPayload(T* pCommand, const P* pSource, UINT Count)
+    {
+        if (Count > 0)
+        {
+            memcpy(GetPayload<P>(pCommand), pSource, Count * sizeof(P));
+        }
+    }
+
+    inline ID3D12Resource* GetNodeResource(CD3DX12AffinityResource* pResource, UINT NodeIndex)
+    {
+        return pResource ? pResource->mResources[NodeIndex] : nullptr;
+    }
+}
+
+void* CD3DX12AffinityCommandStream::Allocate(UINT32 Opcode, UINT32 CommandSize, UINT32 PayloadSize)
+{
+    UINT32 const Size = sizeof(CommandHeader) + AlignToWord(CommandSize) + AlignToWord(PayloadSize);
+    size_t const Offset = mStream.size();
+    mStream.resize(Offset + Size / sizeof(UINT64));
+
+    CommandHeader* Header = reinterpret_cast<CommandHeader*>(&mStream[Offset]);
+    Header->Opcode = Opcode;
+    Header->Size = Size;
+
+    return Header + 1;
+}
+
+void CD3DX12AffinityCommandStream::Reset(UINT AffinityMask)
+{
+    mStream.clear();
+    mRecordedNodeMask = 0;
+    SetAffinityMask(AffinityMask);
+}
+
+void CD3DX12AffinityCommandStream::SetAffinityMask(UINT AffinityMask)
+{
+    Allocate<SetAffinityMaskCommand>(OpSetAffinityMask)->AffinityMask = AffinityMask;
+    mRecordedNodeMask |= AffinityMask;
+}
+
+UINT CD3DX12AffinityCommandStream::GetRecordedNodeMask() const
+{
+    return mRecordedNodeMask;
+}
+
+bool CD3DX12AffinityCommandStream::IsEmpty() const
+{
+    return mStream.empty();
+}
+
+void CD3DX12AffinityCommandStream::ClearState(CD3DX12AffinityPipelineState* pPipelineState)
+{
+    Allocate<PipelineStateCommand>(OpClearState)->pPipelineState = pPipelineState;
+}
+
+void CD3DX12AffinityCommandStream::DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation)
+{
+    DrawInstancedCommand* Command = Allocate<DrawInstancedCommand>(OpDrawInstanced);
+    Command->VertexCountPerInstance = VertexCountPerInstance;
+    Command->InstanceCount = InstanceCount;
+    Command->StartVertexLocation = StartVertexLocation;
+    Command->StartInstanceLocation = StartInstanceLocation;
+}
+
+void CD3DX12AffinityCommandStream::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation)
+{
+    DrawIndexedInstancedCommand* Command = Allocate<DrawIndexedInstancedCommand>(OpDrawIndexedInstanced);
+    Command->IndexCountPerInstance = IndexCountPerInstance;
+    Command->InstanceCount = InstanceCount;
+    Command->StartIndexLocation = StartIndexLocation;
+    Command->BaseVertexLocation = BaseVertexLocation;
+    Command->StartInstanceLocation = StartInstanceLocation;
+}
+
+void CD3DX12AffinityCommandStream::Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ)
+{
+    DispatchCommand* Command = Allocate<DispatchCommand>(OpDispatch);
+    Command->ThreadGroupCountX = ThreadGroupCountX;
+    Command->ThreadGroupCountY = ThreadGroupCountY;
+    Command->ThreadGroupCountZ = ThreadGroupCountZ;
+}
+
+void CD3DX12AffinityCommandStream::CopyBufferRegion(CD3DX12AffinityResource* pDstBuffer, UINT64 DstOffset, CD3DX12AffinityResource* pSrcBuffer, UINT64 SrcOffset, UINT64 NumBytes)
+{
+    CopyBufferRegionCommand* Command = Allocate<CopyBufferRegionCommand>(OpCopyBufferRegion);
+    Command->pDstBuffer = pDstBuffer;
+    Command->DstOffset = DstOffset;
+    Command->pSrcBuffer = pSrcBuffer;
+    Command->SrcOffset = SrcOffset;
+    Command->NumBytes = NumBytes;
+}
+
+void CD3DX12AffinityCommandStream::CopyTextureRegion(const D3DX12_AFFINITY_TEXTURE_COPY_LOCATION* pDst, UINT DstX, UINT DstY, UINT DstZ, const D3DX12_AFFINITY_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX* pSrcBox)
+{
+    CopyTextureRegionCommand* Command = Allocate<CopyTextureRegionCommand>(OpCopyTextureRegion);
+    Command->Dst = *pDst;
+    Command->Src = *pSrc;
+    Command->DstX = DstX;
+    Command->DstY = DstY;
+    Command->DstZ = DstZ;
+    Command->HasSrcBox = pSrcBox != nullptr;
+    if (pSrcBox)
+    {
+        Command->SrcBox = *pSrcBox;
+    }
+}
+
+void CD3DX12AffinityCommandStream::CopyResource(CD3DX12AffinityResource* pDstResource, CD3DX12AffinityResource* pSrcResource)
+{
+    CopyResourceCommand* Command = Allocate<CopyResourceCommand>(OpCopyResource);
+    Command->pDstResource = pDstResource;
+    Command->pSrcResource = pSrcResource;
+}
+
+void CD3DX12AffinityCommandStream::CopyTiles(CD3DX12AffinityResource* pTiledResource, const D3D12_TILED_RESOURCE_COORDINATE* pTileRegionStartCoordinate, const D3D12_TILE_REGION_SIZE* pTileRegionSize, CD3DX12AffinityResource* pBuffer, UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags)
+{
+    CopyTilesCommand* Command = Allocate<CopyTilesCommand>(OpCopyTiles);
+    Command->pTiledResource = pTiledResource;
+    Command->TileRegionStartCoordinate = *pTileRegionStartCoordinate;
+    Command->TileRegionSize = *pTileRegionSize;
+    Command->pBuffer = pBuffer;
+    Command->BufferStartOffsetInBytes = BufferStartOffsetInBytes;
+    Command->Flags = Flags;
+}
+
+void CD3DX12AffinityCommandStream::ResolveSubresource(CD3DX12AffinityResource* pDstResource, UINT DstSubresource, CD3DX12AffinityResource* pSrcResource, UINT SrcSubresource, DXGI_FORMAT Format)
+{
+    ResolveSubresourceCommand* Command = Allocate<ResolveSubresourceCommand>(OpResolveSubresource);
+    Command->pDstResource = pDstResource;
+    Command->pSrcResource = pSrcResource;
+    Command->DstSubresource = DstSubresource;
+    Command->SrcSubresource = SrcSubresource;
+    Command->Format = Format;
+}
+
+void CD3DX12AffinityCommandStream::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology)
+{
+    Allocate<IASetPrimitiveTopologyCommand>(OpIASetPrimitiveTopology)->PrimitiveTopology = PrimitiveTopology;
+}
+
+void CD3DX12AffinityCommandStream::RSSetViewports(UINT NumViewports, const D3D12_VIEWPORT* pViewports)
+{
+    ArrayCommand* Command = Allocate<ArrayCommand>(OpRSSetViewports, NumViewports * sizeof(D3D12_VIEWPORT));
+    Command->Count = NumViewports;
+    CopyPayload(Command, pViewports, NumViewports);
+}
+
+void CD3DX12AffinityCommandStream::RSSetScissorRects(UINT NumRects, const D3D12_RECT* pRects)
+{
+    ArrayCommand* Command = Allocate<ArrayCommand>(OpRSSetScissorRects, NumRects * sizeof(D3D12_RECT));
+    Command->Count = NumRects;
+    CopyPayload(Command, pRects, NumRects);
+}
+
+void CD3DX12AffinityCommandStream::OMSetBlendFactor(const FLOAT BlendFactor[4])
+{
+    OMSetBlendFactorCommand* Command = Allocate<OMSetBlendFactorCommand>(OpOMSetBlendFactor);
+    Command->HasBlendFactor = BlendFactor != nullptr;
+    if (BlendFactor)
+    {
+        memcpy(Command->BlendFactor, BlendFactor, sizeof(Command->BlendFactor));
+    }
+}
+
+void CD3DX12AffinityCommandStream::OMSetStencilRef(UINT StencilRef)
+{
+    Allocate<OMSetStencilRefCommand>(OpOMSetStencilRef)->StencilRef = StencilRef;
+}
+
+void CD3DX12AffinityCommandStream::SetPipelineState(CD3DX12AffinityPipelineState* pPipelineState)
+{
+    Allocate<PipelineStateCommand>(OpSetPipelineState)->pPipelineState = pPipelineState;
+}
+
+void CD3DX12AffinityCommandStream::ResourceBarrier(UINT NumBarriers, const D3DX12_AFFINITY_RESOURCE_BARRIER* pBarriers)
+{
+    ArrayCommand* Command = Allocate<ArrayCommand>(OpResourceBarrier, NumBarriers * sizeof(D3DX12_AFFINITY_RESOURCE_BARRIER));
+    Command->Count = NumBarriers;
+    CopyPayload(Command, pBarriers, NumBarriers);
+}
+
+void CD3DX12AffinityCommandStream::ExecuteBundle(CD3DX12AffinityGraphicsCommandList* pCommandList)
+{
+    Allocate<ExecuteBundleCommand>(OpExecuteBundle)->pCommandList = pCommandList;
+}
+
+void CD3DX12AffinityCommandStream::SetDescriptorHeaps(UINT NumDescriptorHeaps, CD3DX12AffinityDescriptorHeap** ppDescriptorHeaps)
+{
+    ArrayCommand* Command = Allocate<ArrayCommand>(OpSetDescriptorHeaps, NumDescriptorHeaps * sizeof(CD3DX12AffinityDescriptorHeap*));
+    Command->Count = NumDescriptorHeaps;
+    CopyPayload(Command, ppDescriptorHeaps, NumDescriptorHeaps);
+}
+
+void CD3DX12AffinityCommandStream::SetComputeRootSignature(CD3DX12AffinityRootSignature* pRootSignature)
+{
+    Allocate<RootSignatureCommand>(OpSetComputeRootSignature)->pRootSignature = pRootSignature;
+}
+
+void CD3DX12AffinityCommandStream::SetGraphicsRootSignature(CD3DX12AffinityRootSignature* pRootSignature)
+{
+    Allocate<RootSignatureCommand>(OpSetGraphicsRootSignature)->pRootSignature = pRootSignature;
+}
+
+void CD3DX12AffinityCommandStream::SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
+{
+    RootDescriptorTableCommand* Command = Allocate<RootDescriptorTableCommand>(OpSetComputeRootDescriptorTable);
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->BaseDescriptor = BaseDescriptor;
+}
+
+void CD3DX12AffinityCommandStream::SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
+{
+    RootDescriptorTableCommand* Command = Allocate<RootDescriptorTableCommand>(OpSetGraphicsRootDescriptorTable);
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->BaseDescriptor = BaseDescriptor;
+}
+
+void CD3DX12AffinityCommandStream::SetComputeRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues)
+{
+    Root32BitConstantsCommand* Command = Allocate<Root32BitConstantsCommand>(OpSetComputeRoot32BitConstants, Num32BitValuesToSet * sizeof(UINT));
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->Num32BitValuesToSet = Num32BitValuesToSet;
+    Command->DestOffsetIn32BitValues = DestOffsetIn32BitValues;
+    CopyPayload(Command, static_cast<const UINT*>(pSrcData), Num32BitValuesToSet);
+}
+
+void CD3DX12AffinityCommandStream::SetGraphicsRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues)
+{
+    Root32BitConstantsCommand* Command = Allocate<Root32BitConstantsCommand>(OpSetGraphicsRoot32BitConstants, Num32BitValuesToSet * sizeof(UINT));
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->Num32BitValuesToSet = Num32BitValuesToSet;
+    Command->DestOffsetIn32BitValues = DestOffsetIn32BitValues;
+    CopyPayload(Command, static_cast<const UINT*>(pSrcData), Num32BitValuesToSet);
+}
+
+void CD3DX12AffinityCommandStream::SetComputeRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+{
+    RootViewCommand* Command = Allocate<RootViewCommand>(OpSetComputeRootConstantBufferView);
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->BufferLocation = BufferLocation;
+}
+
+void CD3DX12AffinityCommandStream::SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+{
+    RootViewCommand* Command = Allocate<RootViewCommand>(OpSetGraphicsRootConstantBufferView);
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->BufferLocation = BufferLocation;
+}
+
+void CD3DX12AffinityCommandStream::SetComputeRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+{
+    RootViewCommand* Command = Allocate<RootViewCommand>(OpSetComputeRootShaderResourceView);
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->BufferLocation = BufferLocation;
+}
+
+void CD3DX12AffinityCommandStream::SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+{
+    RootViewCommand* Command = Allocate<RootViewCommand>(OpSetGraphicsRootShaderResourceView);
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->BufferLocation = BufferLocation;
+}
+
+void CD3DX12AffinityCommandStream::SetComputeRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+{
+    RootViewCommand* Command = Allocate<RootViewCommand>(OpSetComputeRootUnorderedAccessView);
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->BufferLocation = BufferLocation;
+}
+
+void CD3DX12AffinityCommandStream::SetGraphicsRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+{
+    RootViewCommand* Command = Allocate<RootViewCommand>(OpSetGraphicsRootUnorderedAccessView);
+    Command->RootParameterIndex = RootParameterIndex;
+    Command->BufferLocation = BufferLocation;
+}
+
+void CD3DX12AffinityCommandStream::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView)
+{
+    IASetIndexBufferCommand* Command = Allocate<IASetIndexBufferCommand>(OpIASetIndexBuffer);
+    Command->HasView = pView != nullptr;
+    if (pView)
+    {
+        Command->View = *pView;
+    }
+}
+
+void CD3DX12AffinityCommandStream::IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews)
+{
+    UINT const NumCopied = pViews ? NumViews : 0;
+    BufferViewsCommand* Command = Allocate<BufferViewsCommand>(OpIASetVertexBuffers, NumCopied * sizeof(D3D12_VERTEX_BUFFER_VIEW));
+    Command->StartSlot = StartSlot;
+    Command->NumViews = NumViews;
+    Command->HasViews = pViews != nullptr;
+    CopyPayload(Command, pViews, NumCopied);
+}
+
+void CD3DX12AffinityCommandStream::SOSetTargets(UINT StartSlot, UINT NumViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews)
+{
+    UINT const NumCopied = pViews ? NumViews : 0;
+    BufferViewsCommand* Command = Allocate<BufferViewsCommand>(OpSOSetTargets, NumCopied * sizeof(D3D12_STREAM_OUTPUT_BUFFER_VIEW));
+    Command->StartSlot = StartSlot;
+    Command->NumViews = NumViews;
+    Command->HasViews = pViews != nullptr;
+    CopyPayload(Command, pViews, NumCopied);
+}
+
+void CD3DX12AffinityCommandStream::OMSetRenderTargets(UINT NumRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors, BOOL RTsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor)
+{
+    // A descriptor range is given by its first handle only.
+    UINT const NumHandles = (RTsSingleHandleToDescriptorRange && NumRenderTargetDescriptors > 0) ? 1 : NumRenderTargetDescriptors;
+
+    OMSetRenderTargetsCommand* Command = Allocate<OMSetRenderTargetsCommand>(OpOMSetRenderTargets, NumHandles * sizeof(D3D12_CPU_DESCRIPTOR_HANDLE));
+    Command->NumRenderTargetDescriptors = NumRenderTargetDescriptors;
+    Command->NumHandles = NumHandles;
+    Command->RTsSingleHandleToDescriptorRange = RTsSingleHandleToDescriptorRange;
+    Command->HasDepthStencil = pDepthStencilDescriptor != nullptr;
+    if (pDepthStencilDescriptor)
+    {
+        Command->DepthStencilDescriptor = *pDepthStencilDescriptor;
+    }
+    CopyPayload(Command, pRenderTargetDescriptors, NumHandles);
+}
+
+void CD3DX12AffinityCommandStream::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView, D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth, UINT8 Stencil, UINT NumRects, const D3D12_RECT* pRects)
+{
+    ClearDepthStencilViewCommand* Command = Allocate<ClearDepthStencilViewCommand>(OpClearDepthStencilView, NumRects * sizeof(D3D12_RECT));
+    Command->DepthStencilView = DepthStencilView;
+    Command->ClearFlags = ClearFlags;
+    Command->Depth = Depth;
+    Command->Stencil = Stencil;
+    Command->NumRects = NumRects;
+    CopyPayload(Command, pRects, NumRects);
+}
+
+void CD3DX12AffinityCommandStream::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4], UINT NumRects, const D3D12_RECT* pRects)
+{
+    ClearRenderTargetViewCommand* Command = Allocate<ClearRenderTargetViewCommand>(OpClearRenderTargetView, NumRects * sizeof(D3D12_RECT));
+    Command->RenderTargetView = RenderTargetView;
+    memcpy(Command->ColorRGBA, ColorRGBA, sizeof(Command->ColorRGBA));
+    Command->NumRects = NumRects;
+    CopyPayload(Command, pRects, NumRects);
+}
+
+void CD3DX12AffinityCommandStream::ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle, CD3DX12AffinityResource* pResource, const UINT Values[4], UINT NumRects, const D3D12_RECT* pRects)
+{
+    ClearUnorderedAccessViewCommand* Command = Allocate<ClearUnorderedAccessViewCommand>(OpClearUnorderedAccessViewUint, NumRects * sizeof(D3D12_RECT));
+    Command->ViewGPUHandleInCurrentHeap = ViewGPUHandleInCurrentHeap;
+    Command->ViewCPUHandle = ViewCPUHandle;
+    Command->pResource = pResource;
+    memcpy(Command->Values, Values, sizeof(Command->Values));
+    Command->NumRects = NumRects;
+    CopyPayload(Command, pRects, NumRects);
+}
+
+void CD3DX12AffinityCommandStream::ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle, CD3DX12AffinityResource* pResource, const FLOAT Values[4], UINT NumRects, const D3D12_RECT* pRects)
+{
+    ClearUnorderedAccessViewCommand* Command = Allocate<ClearUnorderedAccessViewCommand>(OpClearUnorderedAccessViewFloat, NumRects * sizeof(D3D12_RECT));
+    Command->ViewGPUHandleInCurrentHeap = ViewGPUHandleInCurrentHeap;
+    Command->ViewCPUHandle = ViewCPUHandle;
+    Command->pResource = pResource;
+    memcpy(Command->Values, Values, sizeof(Command->Values));
+    Command->NumRects = NumRects;
+    CopyPayload(Command, pRects, NumRects);
+}
+
+void CD3DX12AffinityCommandStream::DiscardResource(CD3DX12AffinityResource* pResource, const D3D12_DISCARD_REGION* pRegion)
+{
+    UINT const NumRects = (pRegion && pRegion->pRects) ? pRegion->NumRects : 0;
+
+    DiscardResourceCommand* Command = Allocate<DiscardResourceCommand>(OpDiscardResource, NumRects * sizeof(D3D12_RECT));
+    Command->pResource = pResource;
+    Command->HasRegion = pRegion != nullptr;
+    if (pRegion)
+    {
+        Command->Region = *pRegion;
+        Command->Region.pRects = nullptr;
+    }
+    CopyPayload(Command, pRegion ? pRegion->pRects : nullptr, NumRects);
+}
+
+void CD3DX12AffinityCommandStream::BeginQuery(CD3DX12AffinityQueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index)
+{
+    QueryCommand* Command = Allocate<QueryCommand>(OpBeginQuery);
+    Command->pQueryHeap = pQueryHeap;
+    Command->Type = Type;
+    Command->Index = Index;
+}
+
+void CD3DX12AffinityCommandStream::EndQuery(CD3DX12AffinityQueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index)
+{
+    QueryCommand* Command = Allocate<QueryCommand>(OpEndQuery);
+    Command->pQueryHeap = pQueryHeap;
+    Command->Type = Type;
+    Command->Index = Index;
+}
+
+void CD3DX12AffinityCommandStream::ResolveQueryData(CD3DX12AffinityQueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries, CD3DX12AffinityResource* pDestinationBuffer, UINT64 AlignedDestinationBufferOffset)
+{
+    ResolveQueryDataCommand* Command = Allocate<ResolveQueryDataCommand>(OpResolveQueryData);
+    Command->pQueryHeap = pQueryHeap;
+    Command->Type = Type;
+    Command->StartIndex = StartIndex;
+    Command->NumQueries = NumQueries;
+    Command->pDestinationBuffer = pDestinationBuffer;
+    Command->AlignedDestinationBufferOffset = AlignedDestinationBufferOffset;
+}
+
+void CD3DX12AffinityCommandStream::SetPredication(CD3DX12AffinityResource* pBuffer, UINT64 AlignedBufferOffset, D3D12_PREDICATION_OP Operation)
+{
+    SetPredicationCommand* Command = Allocate<SetPredicationCommand>(OpSetPredication);
+    Command->pBuffer = pBuffer;
+    Command->AlignedBufferOffset = AlignedBufferOffset;
+    Command->Operation = Operation;
+}
+
+void CD3DX12AffinityCommandStream::SetMarker(UINT Metadata, const void* pData, UINT Size)
+{
+    UINT const NumCopied = pData ? Size : 0;
+    MarkerCommand* Command = Allocate<MarkerCommand>(OpSetMarker, NumCopied);
+    Command->Metadata = Metadata;
+    Command->Size = Size;
+    Command->HasData = pData != nullptr;
+    CopyPayload(Command, static_cast<const BYTE*>(pData), NumCopied);
+}
+
+void CD3DX12AffinityCommandStream::BeginEvent(UINT Metadata, const void* pData, UINT Size)
+{
+    UINT const NumCopied = pData ? Size : 0;
+    MarkerCommand* Command = Allocate<MarkerCommand>(OpBeginEvent, NumCopied);
+    Command->Metadata = Metadata;
+    Command->Size = Size;
+    Command->HasData = pData != nullptr;
+    CopyPayload(Command, static_cast<const BYTE*>(pData), NumCopied);
+}
+
+void CD3DX12AffinityCommandStream::EndEvent()
+{
+    Allocate(OpEndEvent, 0, 0);
+}
+
+void CD3DX12AffinityCommandStream::ExecuteIndirect(CD3DX12AffinityCommandSignature* pCommandSignature, UINT MaxCommandCount, CD3DX12AffinityResource* pArgumentBuffer, UINT64 ArgumentBufferOffset, CD3DX12AffinityResource* pCountBuffer, UINT64 CountBufferOffset)
+{
+    ExecuteIndirectCommand* Command = Allocate<ExecuteIndirectCommand>(OpExecuteIndirect);
+    Command->pCommandSignature = pCommandSignature;
+    Command->MaxCommandCount = MaxCommandCount;
+    Command->pArgumentBuffer = pArgumentBuffer;
+    Command->ArgumentBufferOffset = ArgumentBufferOffset;
+    Command->pCountBuffer = pCountBuffer;
+    Command->CountBufferOffset = CountBufferOffset;
+}
+
+void CD3DX12AffinityCommandStream::BroadcastResource(CD3DX12AffinityResource* pResource, UINT NodeIndex, UINT TargetNodeMask)
+{
+    BroadcastResourceCommand* Command = Allocate<BroadcastResourceCommand>(OpBroadcastResource);
+    Command->pResource = pResource;
+    Command->NodeIndex = NodeIndex;
+    Command->TargetNodeMask = TargetNodeMask;
+}
+
+void CD3DX12AffinityCommandStream::Replay(ID3D12GraphicsCommandList* pList, UINT NodeIndex, CD3DX12AffinityDevice* pDevice)
+{
+    ReplayScratch& Scratch = mScratch[NodeIndex];
+    UINT const NodeMask = 1 << NodeIndex;
+    bool IsNodeActive = false;
+
+    BYTE* Current = reinterpret_cast<BYTE*>(mStream.data());
+    BYTE* const End = Current + mStream.size() * sizeof(UINT64);
+
+    while (Current < End)
+    {
+        CommandHeader* Header = reinterpret_cast<CommandHeader*>(Current);
+        void* Arguments = Header + 1;
+        Current += Header->Size;
+
+        if (Header->Opcode == OpSetAffinityMask)
+        {
+            IsNodeActive = (static_cast<SetAffinityMaskCommand*>(Arguments)->AffinityMask & NodeMask) != 0;
+            continue;
+        }
+
+        if (!IsNodeActive)
+        {
+            continue;
+        }
+
+        switch (Header->Opcode)
+        {
+        case OpClearState:
+        {
+            PipelineStateCommand* Command = static_cast<PipelineStateCommand*>(Arguments);
+            pList->ClearState(Command->pPipelineState ? Command->pPipelineState->mPipelineStates[NodeIndex] : nullptr);
+            break;
+        }
+        case OpDrawInstanced:
+        {
+            DrawInstancedCommand* Command = static_cast<DrawInstancedCommand*>(Arguments);
+            pList->DrawInstanced(Command->VertexCountPerInstance, Command->InstanceCount, Command->StartVertexLocation, Command->StartInstanceLocation);
+            break;
+        }
+        case OpDrawIndexedInstanced:
+        {
+            DrawIndexedInstancedCommand* Command = static_cast<DrawIndexedInstancedCommand*>(Arguments);
+            pList->DrawIndexedInstanced(Command->IndexCountPerInstance, Command->InstanceCount, Command->StartIndexLocation, Command->BaseVertexLocation, Command->StartInstanceLocation);
+            break;
+        }
+        case OpDispatch:
+        {
+            DispatchCommand* Command = static_cast<DispatchCommand*>(Arguments);
+            pList->Dispatch(Command->ThreadGroupCountX, Command->ThreadGroupCountY, Command->ThreadGroupCountZ);
+            break;
+        }
+        case OpCopyBufferRegion:
+        {
+            CopyBufferRegionCommand* Command = static_cast<CopyBufferRegionCommand*>(Arguments);
+            pList->CopyBufferRegion(
+                Command->pDstBuffer->mResources[NodeIndex], Command->DstOffset,
+                Command->pSrcBuffer->mResources[NodeIndex], Command->SrcOffset,
+                Command->NumBytes);
+            break;
+        }
+        case OpCopyTextureRegion:
+        {
+            CopyTextureRegionCommand* Command = static_cast<CopyTextureRegionCommand*>(Arguments);
+            D3D12_TEXTURE_COPY_LOCATION Dst = Command->Dst.ToD3D12();
+            D3D12_TEXTURE_COPY_LOCATION Src = Command->Src.ToD3D12();
+            Dst.pResource = Command->Dst.pResource->mResources[NodeIndex];
+            Src.pResource = Command->Src.pResource->mResources[NodeIndex];
+            pList->CopyTextureRegion(&Dst, Command->DstX, Command->DstY, Command->DstZ, &Src, Command->HasSrcBox ? &Command->SrcBox : nullptr);
+            break;
+        }
+        case OpCopyResource:
+        {
+            CopyResourceCommand* Command = static_cast<CopyResourceCommand*>(Arguments);
+            pList->CopyResource(Command->pDstResource->mResources[NodeIndex], Command->pSrcResource->mResources[NodeIndex]);
+            break;
+        }
+        case OpCopyTiles:
+        {
+            CopyTilesCommand* Command = static_cast<CopyTilesCommand*>(Arguments);
+            pList->CopyTiles(
+                Command->pTiledResource->mResources[NodeIndex],
+                &Command->TileRegionStartCoordinate,
+                &Command->TileRegionSize,
+                Command->pBuffer->mResources[NodeIndex],
+                Command->BufferStartOffsetInBytes,
+                Command->Flags);
+            break;
+        }
+        case OpResolveSubresource:
+        {
+            ResolveSubresourceCommand* Command = static_cast<ResolveSubresourceCommand*>(Arguments);
+            pList->ResolveSubresource(
+                Command->pDstResource->mResources[NodeIndex], Command->DstSubresource,
+                Command->pSrcResource->mResources[NodeIndex], Command->SrcSubresource,
+                Command->Format);
+            break;
+        }
+        case OpIASetPrimitiveTopology:
+        {
+            pList->IASetPrimitiveTopology(static_cast<IASetPrimitiveTopologyCommand*>(Arguments)->PrimitiveTopology);
+            break;
+        }
+        case OpRSSetViewports:
+        {
+            ArrayCommand* Command = static_cast<ArrayCommand*>(Arguments);
+            pList->RSSetViewports(Command->Count, GetPayload<D3D12_VIEWPORT>(Command));
+            break;
+        }
+        case OpRSSetScissorRects:
+        {
+            ArrayCommand* Command = static_cast<ArrayCommand*>(Arguments);
+            pList->RSSetScissorRects(Command->Count, GetPayload<D3D12_RECT>(Command));
+            break;
+        }
+        case OpOMSetBlendFactor:
+        {
+            OMSetBlendFactorCommand* Command = static_cast<OMSetBlendFactorCommand*>(Arguments);
+            pList->OMSetBlendFactor(Command->HasBlendFactor ? Command->BlendFactor : nullptr);
+            break;
+        }
+        case OpOMSetStencilRef:
+        {
+            pList->OMSetStencilRef(static_cast<OMSetStencilRefCommand*>(Arguments)->StencilRef);
+            break;
+        }
+        case OpSetPipelineState:
+        {
+            PipelineStateCommand* Command = static_cast<PipelineStateCommand*>(Arguments);
+            pList->SetPipelineState(Command->pPipelineState->mPipelineStates[NodeIndex]);
+            break;
+        }
+        case OpResourceBarrier:
+        {
+            ArrayCommand* Command = static_cast<ArrayCommand*>(Arguments);
+            D3DX12_AFFINITY_RESOURCE_BARRIER* pBarriers = GetPayload<D3DX12_AFFINITY_RESOURCE_BARRIER>(Command);
+
+            Scratch.ResourceBarriers.resize(Command->Count);
+            for (UINT b = 0; b < Command->Count; ++b)
+            {
+                D3D12_RESOURCE_BARRIER Use = pBarriers[b].ToD3D12();
+
+                switch (pBarriers[b].Type)
+                {
+                case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+                    Use.Transition.pResource = GetNodeResource(pBarriers[b].Transition.pResource, NodeIndex);
+                    break;
+                case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+                    Use.Aliasing.pResourceBefore = GetNodeResource(pBarriers[b].Aliasing.pResourceBefore, NodeIndex);
+                    Use.Aliasing.pResourceAfter = GetNodeResource(pBarriers[b].Aliasing.pResourceAfter, NodeIndex);
+                    break;
+                case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+                    Use.UAV.pResource = GetNodeResource(pBarriers[b].UAV.pResource, NodeIndex);
+                    break;
+                }
+
+                Scratch.ResourceBarriers[b] = Use;
+            }
+
+            pList->ResourceBarrier(Command->Count, Scratch.ResourceBarriers.data());
+            break;
+        }
+        case OpExecuteBundle:
+        {
+            pList->ExecuteBundle(static_cast<ExecuteBundleCommand*>(Arguments)->pCommandList->GetChildObject(NodeIndex));
+            break;
+        }
+        case OpSetDescriptorHeaps:
+        {
+            ArrayCommand* Command = static_cast<ArrayCommand*>(Arguments);
+            CD3DX12AffinityDescriptorHeap** ppDescriptorHeaps = GetPayload<CD3DX12AffinityDescriptorHeap*>(Command);
+
+            Scratch.DescriptorHeaps.resize(Command->Count);
+            for (UINT h = 0; h < Command->Count; ++h)
+            {
+                Scratch.DescriptorHeaps[h] = ppDescriptorHeaps[h]->GetChildObject(NodeIndex);
+            }
+
+            pList->SetDescriptorHeaps(Command->Count, Scratch.DescriptorHeaps.data());
+            break;
+        }
+        case OpSetComputeRootSignature:
+        {
+            pList->SetComputeRootSignature(static_cast<RootSignatureCommand*>(Arguments)->pRootSignature->mRootSignatures[NodeIndex]);
+            break;
+        }
+        case OpSetGraphicsRootSignature:
+        {
+            pList->SetGraphicsRootSignature(static_cast<RootSignatureCommand*>(Arguments)->pRootSignature->mRootSignatures[NodeIndex]);
+            break;
+        }
+        case OpSetComputeRootDescriptorTable:
+        {
+            RootDescriptorTableCommand* Command = static_cast<RootDescriptorTableCommand*>(Arguments);
+            pList->SetComputeRootDescriptorTable(Command->RootParameterIndex, pDevice->GetGPUHeapPointer(Command->BaseDescriptor, NodeIndex));
+            break;
+        }
+        case OpSetGraphicsRootDescriptorTable:
+        {
+            RootDescriptorTableCommand* Command = static_cast<RootDescriptorTableCommand*>(Arguments);
+            pList->SetGraphicsRootDescriptorTable(Command->RootParameterIndex, pDevice->GetGPUHeapPointer(Command->BaseDescriptor, NodeIndex));
+            break;
+        }
+        case OpSetComputeRoot32BitConstants:
+        {
+            Root32BitConstantsCommand* Command = static_cast<Root32BitConstantsCommand*>(Arguments);
+            pList->SetComputeRoot32BitConstants(Command->RootParameterIndex, Command->Num32BitValuesToSet, GetPayload<UINT>(Command), Command->DestOffsetIn32BitValues);
+            break;
+        }
+        case OpSetGraphicsRoot32BitConstants:
+        {
+            Root32BitConstantsCommand* Command = static_cast<Root32BitConstantsCommand*>(Arguments);
+            pList->SetGraphicsRoot32BitConstants(Command->RootParameterIndex, Command->Num32BitValuesToSet, GetPayload<UINT>(Command), Command->DestOffsetIn32BitValues);
+            break;
+        }
+        case OpSetComputeRootConstantBufferView:
+        {
+            RootViewCommand* Command = static_cast<RootViewCommand*>(Arguments);
+            pList->SetComputeRootConstantBufferView(Command->RootParameterIndex, pDevice->GetGPUVirtualAddress(Command->BufferLocation, NodeIndex));
+            break;
+        }
+        case OpSetGraphicsRootConstantBufferView:
+        {
+            RootViewCommand* Command = static_cast<RootViewCommand*>(Arguments);
+            pList->SetGraphicsRootConstantBufferView(Command->RootParameterIndex, pDevice->GetGPUVirtualAddress(Command->BufferLocation, NodeIndex));
+            break;
+        }
+        case OpSetComputeRootShaderResourceView:
+        {
+            RootViewCommand* Command = static_cast<RootViewCommand*>(Arguments);
+            pList->SetComputeRootShaderResourceView(Command->RootParameterIndex, pDevice->GetGPUVirtualAddress(Command->BufferLocation, NodeIndex));
+            break;
+        }
+        case OpSetGraphicsRootShaderResourceView:
+        {
+            RootViewCommand* Command = static_cast<RootViewCommand*>(Arguments);
+            pList->SetGraphicsRootShaderResourceView(Command->RootParameterIndex, pDevice->GetGPUVirtualAddress(Command->BufferLocation, NodeIndex));
+            break;
+        }
+        case OpSetComputeRootUnorderedAccessView:
+        {
+            RootViewCommand* Command = static_cast<RootViewCommand*>(Arguments);
+            pList->SetComputeRootUnorderedAccessView(Command->RootParameterIndex, pDevice->GetGPUVirtualAddress(Command->BufferLocation, NodeIndex));
+            break;
+        }
+        case OpSetGraphicsRootUnorderedAccessView:
+        {
+            RootViewCommand* Command = static_cast<RootViewCommand*>(Arguments);
+            pList->SetGraphicsRootUnorderedAccessView(Command->RootParameterIndex, pDevice->GetGPUVirtualAddress(Command->BufferLocation, NodeIndex));
+            break;
+        }
+        case OpIASetIndexBuffer:
+        {
+            IASetIndexBufferCommand* Command = static_cast<IASetIndexBufferCommand*>(Arguments);
+            if (Command->HasView)
+            {
+                D3D12_INDEX_BUFFER_VIEW View = Command->View;
+                View.BufferLocation = pDevice->GetGPUVirtualAddress(View.BufferLocation, NodeIndex);
+                pList->IASetIndexBuffer(&View);
+            }
+            else
+            {
+                pList->IASetIndexBuffer(nullptr);
+            }
+            break;
+        }
+        case OpIASetVertexBuffers:
+        {
+            BufferViewsCommand* Command = static_cast<BufferViewsCommand*>(Arguments);
+            if (Command->HasViews)
+            {
+                D3D12_VERTEX_BUFFER_VIEW* pViews = GetPayload<D3D12_VERTEX_BUFFER_VIEW>(Command);
+
+                Scratch.BufferViews.resize(Command->NumViews);
+                for (UINT v = 0; v < Command->NumViews; ++v)
+                {
+                    Scratch.BufferViews[v] = pViews[v];
+                    Scratch.BufferViews[v].BufferLocation = pDevice->GetGPUVirtualAddress(pViews[v].BufferLocation, NodeIndex);
+                }
+
+                pList->IASetVertexBuffers(Command->StartSlot, Command->NumViews, Scratch.BufferViews.data());
+            }
+            else
+            {
+                pList->IASetVertexBuffers(Command->StartSlot, Command->NumViews, nullptr);
+            }
+            break;
+        }
+        case OpSOSetTargets:
+        {
+            BufferViewsCommand* Command = static_cast<BufferViewsCommand*>(Arguments);
+            if (Command->HasViews)
+            {
+                D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews = GetPayload<D3D12_STREAM_OUTPUT_BUFFER_VIEW>(Command);
+
+                Scratch.StreamOutBufferViews.resize(Command->NumViews);
+                for (UINT v = 0; v < Command->NumViews; ++v)
+                {
+                    Scratch.StreamOutBufferViews[v] = pViews[v];
+                    Scratch.StreamOutBufferViews[v].BufferLocation = pDevice->GetGPUVirtualAddress(pViews[v].BufferLocation, NodeIndex);
+                    Scratch.StreamOutBufferViews[v].BufferFilledSizeLocation = pDevice->GetGPUVirtualAddress(pViews[v].BufferFilledSizeLocation, NodeIndex);
+                }
+
+                pList->SOSetTargets(Command->StartSlot, Command->NumViews, Scratch.StreamOutBufferViews.data());
+            }
+            else
+            {
+                pList->SOSetTargets(Command->StartSlot, Command->NumViews, nullptr);
+            }
+            break;
+        }
+        case OpOMSetRenderTargets:
+        {
+            OMSetRenderTargetsCommand* Command = static_cast<OMSetRenderTargetsCommand*>(Arguments);
+            D3D12_CPU_DESCRIPTOR_HANDLE* pHandles = GetPayload<D3D12_CPU_DESCRIPTOR_HANDLE>(Command);
+
+            Scratch.RenderTargetViews.resize(Command->NumHandles);
+            for (UINT r = 0; r < Command->NumHandles; ++r)
+            {
+                Scratch.RenderTargetViews[r] = pDevice->GetCPUHeapPointer(pHandles[r], NodeIndex);
+            }
+
+            D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilDescriptor = {};
+            if (Command->HasDepthStencil)
+            {
+                DepthStencilDescriptor = pDevice->GetCPUHeapPointer(Command->DepthStencilDescriptor, NodeIndex);
+            }
+
+            pList->OMSetRenderTargets(
+                Command->NumRenderTargetDescriptors,
+                Command->NumHandles > 0 ? Scratch.RenderTargetViews.data() : nullptr,
+                Command->RTsSingleHandleToDescriptorRange,
+                Command->HasDepthStencil ? &DepthStencilDescriptor : nullptr);
+            break;
+        }
+        case OpClearDepthStencilView:
+        {
+            ClearDepthStencilViewCommand* Command = static_cast<ClearDepthStencilViewCommand*>(Arguments);
+            pList->ClearDepthStencilView(
+                pDevice->GetCPUHeapPointer(Command->DepthStencilView, NodeIndex),
+                Command->ClearFlags, Command->Depth, Command->Stencil,
+                Command->NumRects, GetPayload<D3D12_RECT>(Command));
+            break;
+        }
+        case OpClearRenderTargetView:
+        {
+            ClearRenderTargetViewCommand* Command = static_cast<ClearRenderTargetViewCommand*>(Arguments);
+#ifdef D3DX12_DEBUG_CLEAR_WHITE
+            FLOAT White[4] = { 1, 1, 1, 1 };
+            pList->ClearRenderTargetView(pDevice->GetCPUHeapPointer(Command->RenderTargetView, NodeIndex), White, Command->NumRects, GetPayload<D3D12_RECT>(Command));
+#else
+            pList->ClearRenderTargetView(pDevice->GetCPUHeapPointer(Command->RenderTargetView, NodeIndex), Command->ColorRGBA, Command->NumRects, GetPayload<D3D12_RECT>(Command));
+#endif
+            break;
+        }
+        case OpClearUnorderedAccessViewUint:
+        {
+            ClearUnorderedAccessViewCommand* Command = static_cast<ClearUnorderedAccessViewCommand*>(Arguments);
+            pList->ClearUnorderedAccessViewUint(
+                pDevice->GetGPUHeapPointer(Command->ViewGPUHandleInCurrentHeap, NodeIndex),
+                pDevice->GetCPUHeapPointer(Command->ViewCPUHandle, NodeIndex),
+                Command->pResource->mResources[NodeIndex], Command->Values,
+                Command->NumRects, GetPayload<D3D12_RECT>(Command));
+            break;
+        }
+        case OpClearUnorderedAccessViewFloat:
+        {
+            ClearUnorderedAccessViewCommand* Command = static_cast<ClearUnorderedAccessViewCommand*>(Arguments);
+            pList->ClearUnorderedAccessViewFloat(
+                pDevice->GetGPUHeapPointer(Command->ViewGPUHandleInCurrentHeap, NodeIndex),
+                pDevice->GetCPUHeapPointer(Command->ViewCPUHandle, NodeIndex),
+                Command->pResource->mResources[NodeIndex], reinterpret_cast<const FLOAT*>(Command->Values),
+                Command->NumRects, GetPayload<D3D12_RECT>(Command));
+            break;
+        }
+        case OpDiscardResource:
+        {
+            DiscardResourceCommand* Command = static_cast<DiscardResourceCommand*>(Arguments);
+            if (Command->HasRegion)
+            {
+                D3D12_DISCARD_REGION Region = Command->Region;
+                Region.pRects = Region.NumRects > 0 ? GetPayload<D3D12_RECT>(Command) : nullptr;
+                pList->DiscardResource(Command->pResource->mResources[NodeIndex], &Region);
+            }
+            else
+            {
+                pList->DiscardResource(Command->pResource->mResources[NodeIndex], nullptr);
+            }
+            break;
+        }
+        case OpBeginQuery:
+        {
+            QueryCommand* Command = static_cast<QueryCommand*>(Arguments);
+            pList->BeginQuery(Command->pQueryHeap->mQueryHeaps[NodeIndex], Command->Type, Command->Index);
+            break;
+        }
+        case OpEndQuery:
+        {
+            QueryCommand* Command = static_cast<QueryCommand*>(Arguments);
+            pList->EndQuery(Command->pQueryHeap->mQueryHeaps[NodeIndex], Command->Type, Command->Index);
+            break;
+        }
+        case OpResolveQueryData:
+        {
+            ResolveQueryDataCommand* Command = static_cast<ResolveQueryDataCommand*>(Arguments);
+            pList->ResolveQueryData(
+                Command->pQueryHeap->mQueryHeaps[NodeIndex],
+                Command->Type,
+                Command->StartIndex,
+                Command->NumQueries,
+                Command->pDestinationBuffer->mResources[NodeIndex],
+                Command->AlignedDestinationBufferOffset);
+            break;
+        }
+        case OpSetPredication:
+        {
+            SetPredicationCommand* Command = static_cast<SetPredicationCommand*>(Arguments);
+            pList->SetPredication(GetNodeResource(Command->pBuffer, NodeIndex), Command->AlignedBufferOffset, Command->Operation);
+            break;
+        }
+        case OpSetMarker:
+        {
+            MarkerCommand* Command = static_cast<MarkerCommand*>(Arguments);
+            pList->SetMarker(Command->Metadata, Command->HasData ? GetPayload<BYTE>(Command) : nullptr, Command->Size);
+            break;
+        }
+        case OpBeginEvent:
+        {
+            MarkerCommand* Command = static_cast<MarkerCommand*>(Arguments);
+            pList->BeginEvent(Command->Metadata, Command->HasData ? GetPayload<BYTE>(Command) : nullptr, Command->Size);
+            break;
+        }
+        case OpEndEvent:
+        {
+            pList->EndEvent();
+            break;
+        }
+        case OpExecuteIndirect:
+        {
+            ExecuteIndirectCommand* Command = static_cast<ExecuteIndirectCommand*>(Arguments);
+            pList->ExecuteIndirect(
+                Command->pCommandSignature->GetChildObject(NodeIndex),
+                Command->MaxCommandCount,
+                Command->pArgumentBuffer->mResources[NodeIndex], Command->ArgumentBufferOffset,
+                GetNodeResource(Command->pCountBuffer, NodeIndex), Command->CountBufferOffset);
+            break;
+        }
+        case OpBroadcastResource:
+        {
+            // Copy is a push operation on the source node commandlist to a target resource
+            BroadcastResourceCommand* Command = static_cast<BroadcastResourceCommand*>(Arguments);
+            if (Command->NodeIndex != NodeIndex)
+            {
+                break;
+            }
+
+            for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
+            {
+                if (((1 << i) & Command->TargetNodeMask) != 0 && i != NodeIndex)
+                {
+                    pList->CopyResource(Command->pResource->GetChildObject(i), Command->pResource->GetChildObject(NodeIndex));
+                }
+            }
+            break;
+        }
+        default:
+            DEBUG_ASSERT(false);
+            break;
+        }
+    }
+}
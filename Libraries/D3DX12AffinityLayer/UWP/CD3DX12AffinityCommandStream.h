@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "Utils.h"
+#include "CD3DX12AffinityDevice.h"
+
+// Records the commands of an affinity command list once, as a compact binary stream of
+// affinity objects, descriptor handles and GPU virtual addresses, so that nothing is
+// translated while recording. Each node's native command list is then built by replaying
+// the stream, remapping every object, descriptor and address to that node. Replays onto
+// different nodes share nothing but the stream, so they can run on separate threads.
+class CD3DX12AffinityCommandStream
+{
+public:
+    // Clears the recorded commands, keeping the memory for the next recording.
+    void Reset(UINT AffinityMask);
+
+    // Commands recorded after this are only replayed onto the nodes in AffinityMask.
+    void SetAffinityMask(UINT AffinityMask);
+
+    // Union of the affinity masks commands were recorded with since the last Reset.
+    UINT GetRecordedNodeMask() const;
+
+    bool IsEmpty() const;
+
+    void Replay(ID3D12GraphicsCommandList* pList, UINT NodeIndex, CD3DX12AffinityDevice* pDevice);
+
+    void ClearState(CD3DX12AffinityPipelineState* pPipelineState);
+    void DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation);
+    void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation);
+    void Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ);
+    void CopyBufferRegion(CD3DX12AffinityResource* pDstBuffer, UINT64 DstOffset, CD3DX12AffinityResource* pSrcBuffer, UINT64 SrcOffset, UINT64 NumBytes);
+    void CopyTextureRegion(const D3DX12_AFFINITY_TEXTURE_COPY_LOCATION* pDst, UINT DstX, UINT DstY, UINT DstZ, const D3DX12_AFFINITY_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX* pSrcBox);
+    void CopyResource(CD3DX12AffinityResource* pDstResource, CD3DX12AffinityResource* pSrcResource);
+    void CopyTiles(CD3DX12AffinityResource* pTiledResource, const D3D12_TILED_RESOURCE_COORDINATE* pTileRegionStartCoordinate, const D3D12_TILE_REGION_SIZE* pTileRegionSize, CD3DX12AffinityResource* pBuffer, UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags);
+    void ResolveSubresource(CD3DX12AffinityResource* pDstResource, UINT DstSubresource, CD3DX12AffinityResource* pSrcResource, UINT SrcSubresource, DXGI_FORMAT Format);
+    void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology);
+    void RSSetViewports(UINT NumViewports, const D3D12_VIEWPORT* pViewports);
+    void RSSetScissorRects(UINT NumRects, const D3D12_RECT* pRects);
+    void OMSetBlendFactor(const FLOAT BlendFactor[4]);
+    void OMSetStencilRef(UINT StencilRef);
+    void SetPipelineState(CD3DX12AffinityPipelineState* pPipelineState);
+    void ResourceBarrier(UINT NumBarriers, const D3DX12_AFFINITY_RESOURCE_BARRIER* pBarriers);
+    void ExecuteBundle(CD3DX12AffinityGraphicsCommandList* pCommandList);
+    void SetDescriptorHeaps(UINT NumDescriptorHeaps, CD3DX12AffinityDescriptorHeap** ppDescriptorHeaps);
+    void SetComputeRootSignature(CD3DX12AffinityRootSignature* pRootSignature);
+    void SetGraphicsRootSignature(CD3DX12AffinityRootSignature* pRootSignature);
+    void SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor);
+    void SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor);
+    void SetComputeRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues);
+    void SetGraphicsRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues);
+    void SetComputeRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation);
+    void SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation);
+    void SetComputeRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation);
+    void SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation);
+    void SetComputeRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation);
+    void SetGraphicsRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation);
+    void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView);
+    void IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews);
+    void SOSetTargets(UINT StartSlot, UINT NumViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews);
+    void OMSetRenderTargets(UINT NumRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors, BOOL RTsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor);
+    void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView, D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth, UINT8 Stencil, UINT NumRects, const D3D12_RECT* pRects);
+    void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4], UINT NumRects, const D3D12_RECT* pRects);
+    void ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle, CD3DX12AffinityResource* pResource, const UINT Values[4], UINT NumRects, const D3D12_RECT* pRects);
+    void ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle, CD3DX12AffinityResource* pResource, const FLOAT Values[4], UINT NumRects, const D3D12_RECT* pRects);
+    void DiscardResource(CD3DX12AffinityResource* pResource, const D3D12_DISCARD_REGION* pRegion);
+    void BeginQuery(CD3DX12AffinityQueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index);
+    void EndQuery(CD3DX12AffinityQueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index);
+    void ResolveQueryData(CD3DX12AffinityQueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries, CD3DX12AffinityResource* pDestinationBuffer, UINT64 AlignedDestinationBufferOffset);
+    void SetPredication(CD3DX12AffinityResource* pBuffer, UINT64 AlignedBufferOffset, D3D12_PREDICATION_OP Operation);
+    void SetMarker(UINT Metadata, const void* pData, UINT Size);
+    void BeginEvent(UINT Metadata, const void* pData, UINT Size);
+    void EndEvent();
+    void ExecuteIndirect(CD3DX12AffinityCommandSignature* pCommandSignature, UINT MaxCommandCount, CD3DX12AffinityResource* pArgumentBuffer, UINT64 ArgumentBufferOffset, CD3DX12AffinityResource* pCountBuffer, UINT64 CountBufferOffset);
+    void BroadcastResource(CD3DX12AffinityResource* pResource, UINT NodeIndex, UINT TargetNodeMask);
+
+private:
+    struct CommandHeader
+    {
+        UINT32 Opcode;
+        UINT32 Size;
+    };
+
+    // Translation buffers for a single node, so that nodes can be replayed concurrently.
+    struct ReplayScratch
+    {
+        std::vector<D3D12_RESOURCE_BARRIER> ResourceBarriers;
+        std::vector<ID3D12DescriptorHeap*> DescriptorHeaps;
+        std::vector<D3D12_VERTEX_BUFFER_VIEW> BufferViews;
+        std::vector<D3D12_STREAM_OUTPUT_BUFFER_VIEW> StreamOutBufferViews;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> RenderTargetViews;
+    };
+
+    void* Allocate(UINT32 Opcode, UINT32 CommandSize, UINT32 PayloadSize);
+
+    template <typename T>
+    T* Allocate(UINT32 Opcode, UINT32 PayloadSize = 0)
+    {
+        return static_cast<T*>(Allocate(Opcode, sizeof(T), PayloadSize));
+    }
+
+    // Commands are stored as 64-bit words, so that every command and its payload stays
+    // naturally aligned.
+    std::vector<UINT64> mStream;
+    UINT mRecordedNodeMask = 0;
+    ReplayScratch mScratch[D3DX12_MAX_ACTIVE_NODES];
+};
@@ -55,6 +55,11 @@
 
 //#define ALWAYS_RESET_ALL_COMMAND_LISTS 1
 
+// Records each command once into a compact stream instead of translating it for every node
+// as it is recorded, then replays the stream onto each node's command list in parallel on
+// Close. Only used when there is more than one node.
+#define RECORD_COMMAND_STREAMS 1
+
 ////////////////////////////
 // DEBUG CONFIG ////////////
 ////////////////////////////
@@ -76,6 +81,9 @@
 #include <map>
 #include <set>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <memory>
 #include <cstdio>
 
 struct EAffinityMask
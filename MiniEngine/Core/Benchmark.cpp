@@ -0,0 +1,286 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "Benchmark.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "SystemTime.h"
+#include "BufferManager.h"
+#include "FrameGraph.h"
+#include "FramePacer.h"
+#include "NullDevice.h"
+#include <unordered_map>
+
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    #include <shellapi.h>
+    #pragma comment(lib, "shell32.lib")
+#endif
+
+using namespace std;
+
+namespace
+{
+    struct ScopeTime
+    {
+        wstring Name;
+        wstring Path;
+        uint32_t Depth;
+        double TotalCpuTime;
+    };
+
+    bool s_IsEnabled = false;
+    bool s_UseNullDevice = false;
+    uint32_t s_NumWarmupFrames = 60;
+    uint32_t s_NumFrames = 0;
+    wstring s_ReportPath;
+
+    uint32_t s_NumUpdates = 0;
+    uint32_t s_NumMeasuredFrames = 0;
+    int64_t s_FrameStartTick = 0;
+    double s_TotalFrameTime = 0.0;
+    double s_MaxFrameTime = 0.0;
+
+    // Scopes in the order they were first seen, looked up by their path from the root
+    vector<ScopeTime> s_ScopeTimes;
+    unordered_map<wstring, size_t> s_ScopeIndices;
+
+    uint64_t s_TotalStats[9] = {};
+    const wchar_t* s_StatNames[_countof(s_TotalStats)] =
+    {
+        L"Command Lists", L"Draws", L"Dispatches", L"Barriers",
+        L"Pipeline States", L"Root Signatures", L"Dynamic Descriptors",
+        L"Descriptor Copies", L"Reused Descriptor Tables"
+    };
+
+    void AddStats( const CommandContextStats& Stats )
+    {
+        const uint32_t Counts[] =
+        {
+            Stats.NumCommandLists, Stats.NumDraws, Stats.NumDispatches, Stats.NumBarriers,
+            Stats.NumPipelineStates, Stats.NumRootSignatures, Stats.NumDynamicDescriptors,
+            Stats.NumDescriptorCopies, Stats.NumReusedDescriptorTables
+        };
+        static_assert(_countof(Counts) == _countof(s_TotalStats), "Every statistic needs a total");
+
+        for (uint32_t i = 0; i < _countof(Counts); ++i)
+            s_TotalStats[i] += Counts[i];
+    }
+
+    // Only the null device knows what was executed, so these are left out of runs on WARP.
+    uint64_t s_TotalDeviceStats[3] = {};
+    const wchar_t* s_DeviceStatNames[_countof(s_TotalDeviceStats)] =
+    {
+        L"Executed Command Lists", L"Executed Commands", L"Executed Command Bytes"
+    };
+
+    void AddDeviceStats( const NullDeviceStats& Stats )
+    {
+        const uint64_t Counts[] = { Stats.NumExecutedCommandLists, Stats.NumExecutedCommands, Stats.NumExecutedBytes };
+        static_assert(_countof(Counts) == _countof(s_TotalDeviceStats), "Every statistic needs a total");
+
+        for (uint32_t i = 0; i < _countof(Counts); ++i)
+            s_TotalDeviceStats[i] += Counts[i];
+    }
+
+    void AddScopeTimes( void )
+    {
+        vector<wstring> Paths;
+        EngineProfiling::VisitScopes([&Paths](const wstring& Name, uint32_t Depth, float CpuTime)
+        {
+            Paths.resize(Depth);
+            Paths.push_back(Depth == 0 ? Name : Paths.back() + L"/" + Name);
+
+            auto Iter = s_ScopeIndices.find(Paths.back());
+            if (Iter == s_ScopeIndices.end())
+            {
+                Iter = s_ScopeIndices.emplace(Paths.back(), s_ScopeTimes.size()).first;
+                ScopeTime NewScope = { Name, Paths.back(), Depth, 0.0 };
+                s_ScopeTimes.push_back(NewScope);
+            }
+            s_ScopeTimes[Iter->second].TotalCpuTime += CpuTime;
+        });
+    }
+
+    // The transient memory of the rendering passes is measured at 4K, where aliasing saves the most, so
+    // that the numbers don't depend on the resolution of the run.
+    const uint32_t kFrameGraphWidth = 3840;
+    const uint32_t kFrameGraphHeight = 2160;
+}
+
+void Benchmark::Initialize( void )
+{
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    int ArgCount = 0;
+    wchar_t** Args = CommandLineToArgvW(GetCommandLineW(), &ArgCount);
+    if (Args == nullptr)
+        return;
+
+    for (int i = 1; i < ArgCount; ++i)
+    {
+        const bool HasValue = i + 1 < ArgCount;
+
+        if (_wcsicmp(Args[i], L"-benchmark") == 0 && HasValue)
+            s_NumFrames = (uint32_t)_wtoi(Args[++i]);
+        else if (_wcsicmp(Args[i], L"-warmup") == 0 && HasValue)
+            s_NumWarmupFrames = (uint32_t)_wtoi(Args[++i]);
+        else if (_wcsicmp(Args[i], L"-report") == 0 && HasValue)
+            s_ReportPath = Args[++i];
+        else if (_wcsicmp(Args[i], L"-nulldevice") == 0)
+            s_UseNullDevice = true;
+    }
+
+    LocalFree(Args);
+#endif
+
+    s_IsEnabled = s_NumFrames > 0;
+    if (s_IsEnabled)
+    {
+        Graphics::g_bHeadless = true;
+        Graphics::g_bNullDevice = s_UseNullDevice;
+    }
+}
+
+bool Benchmark::IsEnabled( void )
+{
+    return s_IsEnabled;
+}
+
+bool Benchmark::Update( void )
+{
+    ASSERT(s_IsEnabled);
+
+    int64_t CurrentTick = SystemTime::GetCurrentTick();
+    CommandContextStats Stats = Graphics::g_ContextManager.ResetStats();
+    NullDeviceStats DeviceStats = NullDevice::ResetStats();
+
+    // The first update has no previous frame to gather, and warm-up frames are left out, so that
+    // pools, heaps and PSOs have reached their steady state.
+    uint32_t UpdateIndex = s_NumUpdates++;
+    if (UpdateIndex > s_NumWarmupFrames)
+    {
+        double FrameTime = SystemTime::TimeBetweenTicks(s_FrameStartTick, CurrentTick) * 1000.0;
+        s_TotalFrameTime += FrameTime;
+        s_MaxFrameTime = max(s_MaxFrameTime, FrameTime);
+
+        AddStats(Stats);
+        AddDeviceStats(DeviceStats);
+        AddScopeTimes();
+        ++s_NumMeasuredFrames;
+    }
+    else if (UpdateIndex == s_NumWarmupFrames)
+    {
+        Graphics::g_FramePacer.ResetStatistics();
+    }
+
+    s_FrameStartTick = CurrentTick;
+
+    return s_NumMeasuredFrames < s_NumFrames;
+}
+
+void Benchmark::Report( void )
+{
+    ASSERT(s_IsEnabled);
+
+    if (s_NumMeasuredFrames == 0)
+    {
+        Utility::Print("Benchmark ended before any frame was measured\n");
+        return;
+    }
+
+    const double FrameScale = 1.0 / s_NumMeasuredFrames;
+
+    Utility::Printf("Benchmark:  %u frames at %ux%u after %u warm-up frames on %s\n",
+        s_NumMeasuredFrames, Graphics::g_DisplayWidth, Graphics::g_DisplayHeight, s_NumWarmupFrames,
+        s_UseNullDevice ? "the null device" : "WARP");
+    Utility::Printf("Frame time:  %.3f ms average, %.3f ms max\n", s_TotalFrameTime * FrameScale, s_MaxFrameTime);
+
+    Utility::Print("CPU time per frame (ms):\n");
+    for (auto& Scope : s_ScopeTimes)
+    {
+        int Indent = (int)Scope.Depth * 2;
+        Utility::Printf(L"  %*s%-*s %8.3f\n", Indent, L"", 40 - Indent, Scope.Name.c_str(), Scope.TotalCpuTime * FrameScale);
+    }
+
+    Utility::Print("API calls per frame:\n");
+    for (uint32_t i = 0; i < _countof(s_TotalStats); ++i)
+        Utility::Printf(L"  %-40s %8.1f\n", s_StatNames[i], s_TotalStats[i] * FrameScale);
+
+    if (s_UseNullDevice)
+    {
+        for (uint32_t i = 0; i < _countof(s_TotalDeviceStats); ++i)
+            Utility::Printf(L"  %-40s %8.1f\n", s_DeviceStatNames[i], s_TotalDeviceStats[i] * FrameScale);
+    }
+
+    // Frames still on the GPU when the benchmark ended are left out of the latency
+    const FramePacer::Statistics& PacingStats = Graphics::g_FramePacer.GetStatistics();
+    const double PacingScale = PacingStats.NumFrames == 0 ? 0.0 : 1.0 / PacingStats.NumFrames;
+    const double AverageLatency = SystemTime::TicksToMillisecs(PacingStats.TotalLatency) * PacingScale;
+    const double MaxLatency = SystemTime::TicksToMillisecs(PacingStats.MaxLatency);
+    const double AverageWait = SystemTime::TicksToMillisecs(PacingStats.TotalWait) * PacingScale;
+    const double AverageQueueDepth = PacingStats.TotalQueueDepth * PacingScale;
+
+    Utility::Printf("Frame latency:  %.3f ms average, %.3f ms max, %.3f ms pacing wait, %.2f frames queued\n",
+        AverageLatency, MaxLatency, AverageWait, AverageQueueDepth);
+
+    FrameGraph Graph;
+    Graphics::DescribeRenderingPasses(Graph, kFrameGraphWidth, kFrameGraphHeight);
+    Graph.Compile();
+    const FrameGraph::Statistics& GraphStats = Graph.GetStatistics();
+    const double kMB = 1.0 / (1024.0 * 1024.0);
+
+    Utility::Printf("Frame graph at %ux%u:  %u passes, %u transient resources\n",
+        kFrameGraphWidth, kFrameGraphHeight, Graph.GetNumPasses(), GraphStats.NumTransientResources);
+    Utility::Printf("  %-40s %8.1f\n", "Separate Memory (MB)", GraphStats.SeparateBytes * kMB);
+    Utility::Printf("  %-40s %8.1f\n", "Aliased Memory (MB)", GraphStats.AliasedBytes * kMB);
+    Utility::Printf("  %-40s %8u\n", "Barriers", GraphStats.NumBarriers);
+    Utility::Printf("  %-40s %8u\n", "Split Barriers", GraphStats.NumSplitBarriers);
+    Utility::Printf("  %-40s %8u\n", "Aliasing Barriers", GraphStats.NumAliasingBarriers);
+
+    if (s_ReportPath.empty())
+        return;
+
+    // One metric per line, named by its scope path, so results are easy to compare between runs.
+    FILE* File = nullptr;
+    if (_wfopen_s(&File, s_ReportPath.c_str(), L"w") != 0 || File == nullptr)
+    {
+        Utility::Printf(L"Unable to write the benchmark report to %s\n", s_ReportPath.c_str());
+        return;
+    }
+
+    fwprintf(File, L"Metric,Value\n");
+    fwprintf(File, L"Frame Time (ms),%.4f\n", s_TotalFrameTime * FrameScale);
+    fwprintf(File, L"Max Frame Time (ms),%.4f\n", s_MaxFrameTime);
+    fwprintf(File, L"Frame Latency (ms),%.4f\n", AverageLatency);
+    fwprintf(File, L"Max Frame Latency (ms),%.4f\n", MaxLatency);
+    fwprintf(File, L"Pacing Wait (ms),%.4f\n", AverageWait);
+    fwprintf(File, L"Queued Frames,%.2f\n", AverageQueueDepth);
+
+    for (auto& Scope : s_ScopeTimes)
+        fwprintf(File, L"CPU/%s (ms),%.4f\n", Scope.Path.c_str(), Scope.TotalCpuTime * FrameScale);
+
+    for (uint32_t i = 0; i < _countof(s_TotalStats); ++i)
+        fwprintf(File, L"API/%s,%.2f\n", s_StatNames[i], s_TotalStats[i] * FrameScale);
+
+    if (s_UseNullDevice)
+    {
+        for (uint32_t i = 0; i < _countof(s_TotalDeviceStats); ++i)
+            fwprintf(File, L"Device/%s,%.2f\n", s_DeviceStatNames[i], s_TotalDeviceStats[i] * FrameScale);
+    }
+
+    fwprintf(File, L"FrameGraph/Separate Memory (MB),%.2f\n", GraphStats.SeparateBytes * kMB);
+    fwprintf(File, L"FrameGraph/Aliased Memory (MB),%.2f\n", GraphStats.AliasedBytes * kMB);
+    fwprintf(File, L"FrameGraph/Barriers,%u\n", GraphStats.NumBarriers);
+    fwprintf(File, L"FrameGraph/Split Barriers,%u\n", GraphStats.NumSplitBarriers);
+    fwprintf(File, L"FrameGraph/Aliasing Barriers,%u\n", GraphStats.NumAliasingBarriers);
+
+    fclose(File);
+}
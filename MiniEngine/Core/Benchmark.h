@@ -0,0 +1,43 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+// Runs an application headless for a fixed number of frames and reports what they cost the CPU, so
+// that regressions in command recording can be caught on build machines.  It is enabled from the
+// command line:
+//
+//     ModelViewer.exe -benchmark 600 [-warmup 60] [-report Results.csv] [-nulldevice]
+//
+// Frames render with Graphics::g_bHeadless, so they never wait on a display and simulate at a fixed
+// rate.  The report averages the CPU time of every profiling scope and the API calls recorded by
+// command contexts over the measured frames.  Profiling scopes are compiled out of Release builds,
+// so benchmark the Profile configuration.
+//
+// By default frames render on WARP, whose rasterizer runs on the CPU threads being measured.  With
+// -nulldevice they are recorded into the null device instead, so no GPU work runs anywhere and the
+// report adds what its queues executed.  Either way the engine still needs Windows for its window,
+// DXGI and the D3D12 runtime that serializes root signatures.
+namespace Benchmark
+{
+    // Reads the options from the command line, and turns on headless rendering when a benchmark was
+    // requested.  Must be called before Graphics::Initialize.
+    void Initialize(void);
+
+    bool IsEnabled(void);
+
+    // Gathers the previous frame, so it must be called after EngineProfiling::Update.  Returns false
+    // once every measured frame has been gathered.
+    bool Update(void);
+
+    // Prints the results, and writes them to the report file if one was given.
+    void Report(void);
+}
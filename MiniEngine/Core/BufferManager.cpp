@@ -17,6 +17,8 @@
 #include "CommandContext.h"
 #include "EsramAllocator.h"
 #include "TemporalEffects.h"
+#include "FrameGraph.h"
+#include <map>
 
 namespace Graphics
 {
@@ -87,38 +89,177 @@ namespace Graphics
 #define HDR_MOTION_FORMAT DXGI_FORMAT_R16G16B16A16_FLOAT
 #define DSV_FORMAT DXGI_FORMAT_D32_FLOAT
 
+namespace
+{
+    using namespace Graphics;
+
+    // The buffers that only hold intermediate results within a frame.  InitializeRenderingBuffers() creates them,
+    // and DescribeRenderingPasses() describes the same buffers to a frame graph as transient resources.  They are
+    // grouped by the ESRAM stack they are created in, except for the bloom buffers, which the post effects place
+    // in the heap of their own frame graph.
+    enum TransientBufferGroup
+    {
+        kMotionVectorBuffers,
+        kMinMaxDepthBuffers,
+        kSSAOResultBuffers,
+        kSSAOBuffers,
+        kDepthOfFieldBuffers,
+        kMotionBlurBuffers,
+        kLuminanceBuffers,
+        kBloomLuminanceBuffers,
+        kBloomBuffers,
+        kAntialiasingBuffers
+    };
+
+    struct TransientBufferDesc
+    {
+        TransientBufferGroup Group;
+        const wchar_t* Name;
+        ColorBuffer* Texture;
+        GpuBuffer* Buffer;
+        uint32_t Width;         // Number of elements of buffers
+        uint32_t Height;        // Element size of buffers
+        uint32_t ArrayCount;
+        DXGI_FORMAT Format;
+    };
+
+    void AddTexture( std::vector<TransientBufferDesc>& Descs, TransientBufferGroup Group, const wchar_t* Name,
+        ColorBuffer& Texture, uint32_t Width, uint32_t Height, DXGI_FORMAT Format, uint32_t ArrayCount = 1 )
+    {
+        TransientBufferDesc Desc = { Group, Name, &Texture, nullptr, Width, Height, ArrayCount, Format };
+        Descs.push_back(Desc);
+    }
+
+    void AddBuffer( std::vector<TransientBufferDesc>& Descs, TransientBufferGroup Group, const wchar_t* Name,
+        GpuBuffer& Buffer, uint32_t NumElements, uint32_t ElementSize )
+    {
+        TransientBufferDesc Desc = { Group, Name, nullptr, &Buffer, NumElements, ElementSize, 1, DXGI_FORMAT_UNKNOWN };
+        Descs.push_back(Desc);
+    }
+
+    void DescribeTransientBuffers( uint32_t bufferWidth, uint32_t bufferHeight, std::vector<TransientBufferDesc>& Descs )
+    {
+        const uint32_t bufferWidth1 = (bufferWidth + 1) / 2;
+        const uint32_t bufferWidth2 = (bufferWidth + 3) / 4;
+        const uint32_t bufferWidth3 = (bufferWidth + 7) / 8;
+        const uint32_t bufferWidth4 = (bufferWidth + 15) / 16;
+        const uint32_t bufferWidth5 = (bufferWidth + 31) / 32;
+        const uint32_t bufferWidth6 = (bufferWidth + 63) / 64;
+        const uint32_t bufferHeight1 = (bufferHeight + 1) / 2;
+        const uint32_t bufferHeight2 = (bufferHeight + 3) / 4;
+        const uint32_t bufferHeight3 = (bufferHeight + 7) / 8;
+        const uint32_t bufferHeight4 = (bufferHeight + 15) / 16;
+        const uint32_t bufferHeight5 = (bufferHeight + 31) / 32;
+        const uint32_t bufferHeight6 = (bufferHeight + 63) / 64;
+
+        Descs.clear();
+
+        AddTexture(Descs, kMotionVectorBuffers, L"Motion Vectors", g_VelocityBuffer, bufferWidth, bufferHeight, DXGI_FORMAT_R32_UINT);
+
+        AddTexture(Descs, kMinMaxDepthBuffers, L"MinMaxDepth 8x8", g_MinMaxDepth8, bufferWidth3, bufferHeight3, DXGI_FORMAT_R32_UINT);
+        AddTexture(Descs, kMinMaxDepthBuffers, L"MinMaxDepth 16x16", g_MinMaxDepth16, bufferWidth4, bufferHeight4, DXGI_FORMAT_R32_UINT);
+        AddTexture(Descs, kMinMaxDepthBuffers, L"MinMaxDepth 32x32", g_MinMaxDepth32, bufferWidth5, bufferHeight5, DXGI_FORMAT_R32_UINT);
+
+        AddTexture(Descs, kSSAOResultBuffers, L"SSAO Full Res", g_SSAOFullScreen, bufferWidth, bufferHeight, DXGI_FORMAT_R8_UNORM);
+
+        AddTexture(Descs, kSSAOBuffers, L"Depth Down-Sized 1", g_DepthDownsize1, bufferWidth1, bufferHeight1, DXGI_FORMAT_R32_FLOAT);
+        AddTexture(Descs, kSSAOBuffers, L"Depth Down-Sized 2", g_DepthDownsize2, bufferWidth2, bufferHeight2, DXGI_FORMAT_R32_FLOAT);
+        AddTexture(Descs, kSSAOBuffers, L"Depth Down-Sized 3", g_DepthDownsize3, bufferWidth3, bufferHeight3, DXGI_FORMAT_R32_FLOAT);
+        AddTexture(Descs, kSSAOBuffers, L"Depth Down-Sized 4", g_DepthDownsize4, bufferWidth4, bufferHeight4, DXGI_FORMAT_R32_FLOAT);
+        AddTexture(Descs, kSSAOBuffers, L"Depth De-Interleaved 1", g_DepthTiled1, bufferWidth3, bufferHeight3, DXGI_FORMAT_R16_FLOAT, 16);
+        AddTexture(Descs, kSSAOBuffers, L"Depth De-Interleaved 2", g_DepthTiled2, bufferWidth4, bufferHeight4, DXGI_FORMAT_R16_FLOAT, 16);
+        AddTexture(Descs, kSSAOBuffers, L"Depth De-Interleaved 3", g_DepthTiled3, bufferWidth5, bufferHeight5, DXGI_FORMAT_R16_FLOAT, 16);
+        AddTexture(Descs, kSSAOBuffers, L"Depth De-Interleaved 4", g_DepthTiled4, bufferWidth6, bufferHeight6, DXGI_FORMAT_R16_FLOAT, 16);
+        AddTexture(Descs, kSSAOBuffers, L"AO Re-Interleaved 1", g_AOMerged1, bufferWidth1, bufferHeight1, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO Re-Interleaved 2", g_AOMerged2, bufferWidth2, bufferHeight2, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO Re-Interleaved 3", g_AOMerged3, bufferWidth3, bufferHeight3, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO Re-Interleaved 4", g_AOMerged4, bufferWidth4, bufferHeight4, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO Smoothed 1", g_AOSmooth1, bufferWidth1, bufferHeight1, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO Smoothed 2", g_AOSmooth2, bufferWidth2, bufferHeight2, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO Smoothed 3", g_AOSmooth3, bufferWidth3, bufferHeight3, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO High Quality 1", g_AOHighQuality1, bufferWidth1, bufferHeight1, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO High Quality 2", g_AOHighQuality2, bufferWidth2, bufferHeight2, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO High Quality 3", g_AOHighQuality3, bufferWidth3, bufferHeight3, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kSSAOBuffers, L"AO High Quality 4", g_AOHighQuality4, bufferWidth4, bufferHeight4, DXGI_FORMAT_R8_UNORM);
+
+        AddTexture(Descs, kDepthOfFieldBuffers, L"DoF Tile Classification Buffer 0", g_DoFTileClass[0], bufferWidth4, bufferHeight4, DXGI_FORMAT_R11G11B10_FLOAT);
+        AddTexture(Descs, kDepthOfFieldBuffers, L"DoF Tile Classification Buffer 1", g_DoFTileClass[1], bufferWidth4, bufferHeight4, DXGI_FORMAT_R11G11B10_FLOAT);
+        AddTexture(Descs, kDepthOfFieldBuffers, L"DoF Presort Buffer", g_DoFPresortBuffer, bufferWidth1, bufferHeight1, DXGI_FORMAT_R11G11B10_FLOAT);
+        AddTexture(Descs, kDepthOfFieldBuffers, L"DoF PreFilter Buffer", g_DoFPrefilter, bufferWidth1, bufferHeight1, DXGI_FORMAT_R11G11B10_FLOAT);
+        AddTexture(Descs, kDepthOfFieldBuffers, L"DoF Blur Color", g_DoFBlurColor[0], bufferWidth1, bufferHeight1, DXGI_FORMAT_R11G11B10_FLOAT);
+        AddTexture(Descs, kDepthOfFieldBuffers, L"DoF Blur Color", g_DoFBlurColor[1], bufferWidth1, bufferHeight1, DXGI_FORMAT_R11G11B10_FLOAT);
+        AddTexture(Descs, kDepthOfFieldBuffers, L"DoF FG Alpha", g_DoFBlurAlpha[0], bufferWidth1, bufferHeight1, DXGI_FORMAT_R8_UNORM);
+        AddTexture(Descs, kDepthOfFieldBuffers, L"DoF FG Alpha", g_DoFBlurAlpha[1], bufferWidth1, bufferHeight1, DXGI_FORMAT_R8_UNORM);
+        AddBuffer(Descs, kDepthOfFieldBuffers, L"DoF Work Queue", g_DoFWorkQueue, bufferWidth4 * bufferHeight4, 4);
+        AddBuffer(Descs, kDepthOfFieldBuffers, L"DoF Fast Queue", g_DoFFastQueue, bufferWidth4 * bufferHeight4, 4);
+        AddBuffer(Descs, kDepthOfFieldBuffers, L"DoF Fixup Queue", g_DoFFixupQueue, bufferWidth4 * bufferHeight4, 4);
+
+        AddTexture(Descs, kMotionBlurBuffers, L"Motion Blur Prep", g_MotionPrepBuffer, bufferWidth1, bufferHeight1, HDR_MOTION_FORMAT);
+
+        // This is useful for storing per-pixel weights such as motion strength or pixel luminance
+        AddTexture(Descs, kLuminanceBuffers, L"Luminance", g_LumaBuffer, bufferWidth, bufferHeight, DXGI_FORMAT_R8_UNORM);
+
+        // Divisible by 128 so that after dividing by 16, we still have multiples of 8x8 tiles.  The bloom
+        // dimensions must be at least 1/4 native resolution to avoid undersampling.
+        //uint32_t kBloomWidth = bufferWidth > 2560 ? Math::AlignUp(bufferWidth / 4, 128) : 640;
+        //uint32_t kBloomHeight = bufferHeight > 1440 ? Math::AlignUp(bufferHeight / 4, 128) : 384;
+        uint32_t kBloomWidth = bufferWidth > 2560 ? 1280 : 640;
+        uint32_t kBloomHeight = bufferHeight > 1440 ? 768 : 384;
+
+        AddTexture(Descs, kBloomLuminanceBuffers, L"Luma Buffer", g_LumaLR, kBloomWidth, kBloomHeight, DXGI_FORMAT_R8_UINT);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 1a", g_aBloomUAV1[0], kBloomWidth,    kBloomHeight,    DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 1b", g_aBloomUAV1[1], kBloomWidth,    kBloomHeight,    DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 2a", g_aBloomUAV2[0], kBloomWidth/2,  kBloomHeight/2,  DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 2b", g_aBloomUAV2[1], kBloomWidth/2,  kBloomHeight/2,  DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 3a", g_aBloomUAV3[0], kBloomWidth/4,  kBloomHeight/4,  DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 3b", g_aBloomUAV3[1], kBloomWidth/4,  kBloomHeight/4,  DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 4a", g_aBloomUAV4[0], kBloomWidth/8,  kBloomHeight/8,  DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 4b", g_aBloomUAV4[1], kBloomWidth/8,  kBloomHeight/8,  DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 5a", g_aBloomUAV5[0], kBloomWidth/16, kBloomHeight/16, DefaultHdrColorFormat);
+        AddTexture(Descs, kBloomBuffers, L"Bloom Buffer 5b", g_aBloomUAV5[1], kBloomWidth/16, kBloomHeight/16, DefaultHdrColorFormat);
+
+        const uint32_t kFXAAWorkSize = bufferWidth * bufferHeight / 4 + 128;
+        AddBuffer(Descs, kAntialiasingBuffers, L"FXAA Work Queue", g_FXAAWorkQueue, kFXAAWorkSize, sizeof(uint32_t));
+        AddBuffer(Descs, kAntialiasingBuffers, L"FXAA Color Queue", g_FXAAColorQueue, kFXAAWorkSize, sizeof(uint32_t));
+    }
+
+    void CreateTransientBuffers( const std::vector<TransientBufferDesc>& Descs, TransientBufferGroup Group, EsramAllocator& esram )
+    {
+        for (auto& Desc : Descs)
+        {
+            if (Desc.Group != Group)
+                continue;
+
+            if (Desc.Buffer != nullptr)
+                Desc.Buffer->Create(Desc.Name, Desc.Width, Desc.Height, esram);
+            else if (Desc.ArrayCount > 1)
+                Desc.Texture->CreateArray(Desc.Name, Desc.Width, Desc.Height, Desc.ArrayCount, Desc.Format, esram);
+            else
+                Desc.Texture->Create(Desc.Name, Desc.Width, Desc.Height, 1, Desc.Format, esram);
+        }
+    }
+}
+
 void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t bufferHeight )
 {
     GraphicsContext& InitContext = GraphicsContext::Begin();
 
-    const uint32_t bufferWidth1 = (bufferWidth + 1) / 2;
-    const uint32_t bufferWidth2 = (bufferWidth + 3) / 4;
-    const uint32_t bufferWidth3 = (bufferWidth + 7) / 8;
-    const uint32_t bufferWidth4 = (bufferWidth + 15) / 16;
-    const uint32_t bufferWidth5 = (bufferWidth + 31) / 32;
-    const uint32_t bufferWidth6 = (bufferWidth + 63) / 64;
-    const uint32_t bufferHeight1 = (bufferHeight + 1) / 2;
-    const uint32_t bufferHeight2 = (bufferHeight + 3) / 4;
-    const uint32_t bufferHeight3 = (bufferHeight + 7) / 8;
-    const uint32_t bufferHeight4 = (bufferHeight + 15) / 16;
-    const uint32_t bufferHeight5 = (bufferHeight + 31) / 32;
-    const uint32_t bufferHeight6 = (bufferHeight + 63) / 64;
+    std::vector<TransientBufferDesc> TransientBuffers;
+    DescribeTransientBuffers(bufferWidth, bufferHeight, TransientBuffers);
 
     EsramAllocator esram;
 
     esram.PushStack();
 
         g_SceneColorBuffer.Create( L"Main Color Buffer", bufferWidth, bufferHeight, 1, DefaultHdrColorFormat, esram );
-        g_VelocityBuffer.Create( L"Motion Vectors", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R32_UINT );
+        CreateTransientBuffers(TransientBuffers, kMotionVectorBuffers, esram);
         g_PostEffectsBuffer.Create( L"Post Effects Buffer", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R32_UINT );
 
         esram.PushStack();    // Render HDR image
 
             g_LinearDepth[0].Create( L"Linear Depth 0", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R16_UNORM );
             g_LinearDepth[1].Create( L"Linear Depth 1", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R16_UNORM );
-            g_MinMaxDepth8.Create(L"MinMaxDepth 8x8", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R32_UINT, esram );
-            g_MinMaxDepth16.Create(L"MinMaxDepth 16x16", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R32_UINT, esram );
-            g_MinMaxDepth32.Create(L"MinMaxDepth 32x32", bufferWidth5, bufferHeight5, 1, DXGI_FORMAT_R32_UINT, esram );
+            CreateTransientBuffers(TransientBuffers, kMinMaxDepthBuffers, esram);
 
             g_SceneDepthBuffer.Create( L"Scene Depth Buffer", bufferWidth, bufferHeight, DSV_FORMAT, esram );
 
@@ -126,28 +267,10 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 
                 esram.PushStack();    // Begin Shading
 
-                    g_SSAOFullScreen.Create( L"SSAO Full Res", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R8_UNORM );
+                    CreateTransientBuffers(TransientBuffers, kSSAOResultBuffers, esram);
 
                     esram.PushStack();    // Begin generating SSAO
-                        g_DepthDownsize1.Create( L"Depth Down-Sized 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R32_FLOAT, esram );
-                        g_DepthDownsize2.Create( L"Depth Down-Sized 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R32_FLOAT, esram );
-                        g_DepthDownsize3.Create( L"Depth Down-Sized 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R32_FLOAT, esram );
-                        g_DepthDownsize4.Create( L"Depth Down-Sized 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R32_FLOAT, esram );
-                        g_DepthTiled1.CreateArray( L"Depth De-Interleaved 1", bufferWidth3, bufferHeight3, 16, DXGI_FORMAT_R16_FLOAT, esram );
-                        g_DepthTiled2.CreateArray( L"Depth De-Interleaved 2", bufferWidth4, bufferHeight4, 16, DXGI_FORMAT_R16_FLOAT, esram );
-                        g_DepthTiled3.CreateArray( L"Depth De-Interleaved 3", bufferWidth5, bufferHeight5, 16, DXGI_FORMAT_R16_FLOAT, esram );
-                        g_DepthTiled4.CreateArray( L"Depth De-Interleaved 4", bufferWidth6, bufferHeight6, 16, DXGI_FORMAT_R16_FLOAT, esram );
-                        g_AOMerged1.Create( L"AO Re-Interleaved 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOMerged2.Create( L"AO Re-Interleaved 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOMerged3.Create( L"AO Re-Interleaved 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOMerged4.Create( L"AO Re-Interleaved 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOSmooth1.Create( L"AO Smoothed 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOSmooth2.Create( L"AO Smoothed 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOSmooth3.Create( L"AO Smoothed 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOHighQuality1.Create( L"AO High Quality 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOHighQuality2.Create( L"AO High Quality 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOHighQuality3.Create( L"AO High Quality 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOHighQuality4.Create( L"AO High Quality 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R8_UNORM, esram );
+                        CreateTransientBuffers(TransientBuffers, kSSAOBuffers, esram);
                     esram.PopStack();    // End generating SSAO
 
                     g_ShadowBuffer.Create( L"Shadow Map", 2048, 2048, esram );
@@ -155,18 +278,7 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
                 esram.PopStack();    // End Shading
 
                 esram.PushStack();    // Begin depth of field
-                    g_DoFTileClass[0].Create(L"DoF Tile Classification Buffer 0", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R11G11B10_FLOAT);
-                    g_DoFTileClass[1].Create(L"DoF Tile Classification Buffer 1", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R11G11B10_FLOAT);
-
-                    g_DoFPresortBuffer.Create(L"DoF Presort Buffer", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-                    g_DoFPrefilter.Create(L"DoF PreFilter Buffer", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-                    g_DoFBlurColor[0].Create(L"DoF Blur Color", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-                    g_DoFBlurColor[1].Create(L"DoF Blur Color", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-                    g_DoFBlurAlpha[0].Create(L"DoF FG Alpha", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                    g_DoFBlurAlpha[1].Create(L"DoF FG Alpha", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                    g_DoFWorkQueue.Create(L"DoF Work Queue", bufferWidth4 * bufferHeight4, 4, esram );
-                    g_DoFFastQueue.Create(L"DoF Fast Queue", bufferWidth4 * bufferHeight4, 4, esram );
-                    g_DoFFixupQueue.Create(L"DoF Fixup Queue", bufferWidth4 * bufferHeight4, 4, esram );
+                    CreateTransientBuffers(TransientBuffers, kDepthOfFieldBuffers, esram);
                 esram.PopStack();    // End depth of field
 
                 g_TemporalColor[0].Create( L"Temporal Color 0", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R16G16B16A16_FLOAT);
@@ -174,7 +286,7 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
                 TemporalEffects::ClearHistory(InitContext);
 
                 esram.PushStack();    // Begin motion blur
-                    g_MotionPrepBuffer.Create( L"Motion Blur Prep", bufferWidth1, bufferHeight1, 1, HDR_MOTION_FORMAT, esram );
+                    CreateTransientBuffers(TransientBuffers, kMotionBlurBuffers, esram);
                 esram.PopStack();    // End motion blur
 
             esram.PopStack();    // End opaque geometry
@@ -183,35 +295,15 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 
         esram.PushStack();    // Begin post processing
 
-            // This is useful for storing per-pixel weights such as motion strength or pixel luminance
-            g_LumaBuffer.Create( L"Luminance", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R8_UNORM, esram );
+            CreateTransientBuffers(TransientBuffers, kLuminanceBuffers, esram);
             g_Histogram.Create( L"Histogram", 256, 4, esram );
 
-            // Divisible by 128 so that after dividing by 16, we still have multiples of 8x8 tiles.  The bloom
-            // dimensions must be at least 1/4 native resolution to avoid undersampling.
-            //uint32_t kBloomWidth = bufferWidth > 2560 ? Math::AlignUp(bufferWidth / 4, 128) : 640;
-            //uint32_t kBloomHeight = bufferHeight > 1440 ? Math::AlignUp(bufferHeight / 4, 128) : 384;
-            uint32_t kBloomWidth = bufferWidth > 2560 ? 1280 : 640;
-            uint32_t kBloomHeight = bufferHeight > 1440 ? 768 : 384;
-
             esram.PushStack();    // Begin bloom and tone mapping
-                g_LumaLR.Create( L"Luma Buffer", kBloomWidth, kBloomHeight, 1, DXGI_FORMAT_R8_UINT, esram );
-                g_aBloomUAV1[0].Create( L"Bloom Buffer 1a", kBloomWidth,    kBloomHeight,    1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV1[1].Create( L"Bloom Buffer 1b", kBloomWidth,    kBloomHeight,    1, DefaultHdrColorFormat, esram);
-                g_aBloomUAV2[0].Create( L"Bloom Buffer 2a", kBloomWidth/2,  kBloomHeight/2,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV2[1].Create( L"Bloom Buffer 2b", kBloomWidth/2,  kBloomHeight/2,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV3[0].Create( L"Bloom Buffer 3a", kBloomWidth/4,  kBloomHeight/4,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV3[1].Create( L"Bloom Buffer 3b", kBloomWidth/4,  kBloomHeight/4,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV4[0].Create( L"Bloom Buffer 4a", kBloomWidth/8,  kBloomHeight/8,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV4[1].Create( L"Bloom Buffer 4b", kBloomWidth/8,  kBloomHeight/8,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV5[0].Create( L"Bloom Buffer 5a", kBloomWidth/16, kBloomHeight/16, 1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV5[1].Create( L"Bloom Buffer 5b", kBloomWidth/16, kBloomHeight/16, 1, DefaultHdrColorFormat, esram );
+                CreateTransientBuffers(TransientBuffers, kBloomLuminanceBuffers, esram);
             esram.PopStack();    // End tone mapping
 
             esram.PushStack();    // Begin antialiasing
-                const uint32_t kFXAAWorkSize = bufferWidth * bufferHeight / 4 + 128;
-                g_FXAAWorkQueue.Create( L"FXAA Work Queue", kFXAAWorkSize, sizeof(uint32_t), esram );
-                g_FXAAColorQueue.Create( L"FXAA Color Queue", kFXAAWorkSize, sizeof(uint32_t), esram );
+                CreateTransientBuffers(TransientBuffers, kAntialiasingBuffers, esram);
                 g_FXAAWorkCounters.Create(L"FXAA Work Counters", 2, sizeof(uint32_t));
                 InitContext.ClearUAV(g_FXAAWorkCounters);
             esram.PopStack();    // End antialiasing
@@ -289,16 +381,6 @@ void Graphics::DestroyRenderingBuffers()
     g_LumaBuffer.Destroy();
     g_TemporalColor[0].Destroy();
     g_TemporalColor[1].Destroy();
-    g_aBloomUAV1[0].Destroy();
-    g_aBloomUAV1[1].Destroy();
-    g_aBloomUAV2[0].Destroy();
-    g_aBloomUAV2[1].Destroy();
-    g_aBloomUAV3[0].Destroy();
-    g_aBloomUAV3[1].Destroy();
-    g_aBloomUAV4[0].Destroy();
-    g_aBloomUAV4[1].Destroy();
-    g_aBloomUAV5[0].Destroy();
-    g_aBloomUAV5[1].Destroy();
     g_LumaLR.Destroy();
     g_Histogram.Destroy();
     g_FXAAWorkCounters.Destroy();
@@ -307,3 +389,259 @@ void Graphics::DestroyRenderingBuffers()
 
     g_GenMipsBuffer.Destroy();
 }
+
+FrameGraph::ResourceHandle Graphics::AddTransientRenderingBuffer( FrameGraph& Graph, GpuResource& Buffer,
+    uint32_t bufferWidth, uint32_t bufferHeight )
+{
+    std::vector<TransientBufferDesc> TransientBuffers;
+    DescribeTransientBuffers(bufferWidth, bufferHeight, TransientBuffers);
+
+    for (auto& Desc : TransientBuffers)
+    {
+        if (Desc.Texture != &Buffer && Desc.Buffer != &Buffer)
+            continue;
+
+        ASSERT(Desc.Group == kBloomBuffers, "The buffer is created by InitializeRenderingBuffers()");
+
+        if (Desc.Texture != nullptr)
+            return Graph.CreateTransientTexture(Desc.Name, Desc.Texture, Desc.Width, Desc.Height, Desc.Format, Desc.ArrayCount);
+        else
+            return Graph.CreateTransientBuffer(Desc.Name, Desc.Buffer, Desc.Width, Desc.Height);
+    }
+
+    ASSERT(false, "Not a transient rendering buffer");
+    return FrameGraph::kInvalidHandle;
+}
+
+void Graphics::DescribeRenderingPasses( FrameGraph& Graph, uint32_t bufferWidth, uint32_t bufferHeight )
+{
+    const D3D12_RESOURCE_STATES RT = D3D12_RESOURCE_STATE_RENDER_TARGET;
+    const D3D12_RESOURCE_STATES UAV = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    const D3D12_RESOURCE_STATES SRV = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    const D3D12_RESOURCE_STATES PSRV = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+
+    // Buffers that are presented, or carry history from one frame to the next, keep their own memory
+    FrameGraph::ResourceHandle SceneColor = Graph.ImportResource(L"Main Color Buffer", &g_SceneColorBuffer);
+    FrameGraph::ResourceHandle SceneDepth = Graph.ImportResource(L"Scene Depth Buffer", &g_SceneDepthBuffer);
+    FrameGraph::ResourceHandle ShadowMap = Graph.ImportResource(L"Shadow Map", &g_ShadowBuffer);
+    FrameGraph::ResourceHandle LinearDepth = Graph.ImportResource(L"Linear Depth", &g_LinearDepth[0]);
+    FrameGraph::ResourceHandle PrevLinearDepth = Graph.ImportResource(L"Previous Linear Depth", &g_LinearDepth[1]);
+    FrameGraph::ResourceHandle TemporalColor = Graph.ImportResource(L"Temporal Color", &g_TemporalColor[0]);
+    FrameGraph::ResourceHandle PrevTemporalColor = Graph.ImportResource(L"Previous Temporal Color", &g_TemporalColor[1]);
+    FrameGraph::ResourceHandle Histogram = Graph.ImportResource(L"Histogram", &g_Histogram);
+    FrameGraph::ResourceHandle Overlay = Graph.ImportResource(L"UI Overlay", &g_OverlayBuffer);
+
+    // The graph is only compiled, so the transient buffers are described without handing them to the graph
+    std::vector<TransientBufferDesc> TransientBuffers;
+    DescribeTransientBuffers(bufferWidth, bufferHeight, TransientBuffers);
+
+    std::map<const GpuResource*, FrameGraph::ResourceHandle> Handles;
+    for (auto& Desc : TransientBuffers)
+    {
+        if (Desc.Texture != nullptr)
+            Handles[Desc.Texture] = Graph.CreateTransientTexture(Desc.Name, nullptr, Desc.Width, Desc.Height, Desc.Format, Desc.ArrayCount);
+        else
+            Handles[Desc.Buffer] = Graph.CreateTransientBuffer(Desc.Name, nullptr, Desc.Width, Desc.Height);
+    }
+    auto Transient = [&Handles]( const GpuResource& Buffer ) { return Handles.at(&Buffer); };
+
+    FrameGraph::ResourceHandle Velocity = Transient(g_VelocityBuffer);
+    FrameGraph::ResourceHandle SSAOFullScreen = Transient(g_SSAOFullScreen);
+    FrameGraph::ResourceHandle MinMaxDepth[3] = { Transient(g_MinMaxDepth8), Transient(g_MinMaxDepth16), Transient(g_MinMaxDepth32) };
+
+    FrameGraph::ResourceHandle DepthDownsize[4] = { Transient(g_DepthDownsize1), Transient(g_DepthDownsize2), Transient(g_DepthDownsize3), Transient(g_DepthDownsize4) };
+    FrameGraph::ResourceHandle DepthTiled[4] = { Transient(g_DepthTiled1), Transient(g_DepthTiled2), Transient(g_DepthTiled3), Transient(g_DepthTiled4) };
+    FrameGraph::ResourceHandle AOMerged[4] = { Transient(g_AOMerged1), Transient(g_AOMerged2), Transient(g_AOMerged3), Transient(g_AOMerged4) };
+    FrameGraph::ResourceHandle AOHighQuality[4] = { Transient(g_AOHighQuality1), Transient(g_AOHighQuality2), Transient(g_AOHighQuality3), Transient(g_AOHighQuality4) };
+    FrameGraph::ResourceHandle AOSmooth[3] = { Transient(g_AOSmooth1), Transient(g_AOSmooth2), Transient(g_AOSmooth3) };
+
+    FrameGraph::ResourceHandle DoFTileClass[2] = { Transient(g_DoFTileClass[0]), Transient(g_DoFTileClass[1]) };
+    FrameGraph::ResourceHandle DoFBlurColor[2] = { Transient(g_DoFBlurColor[0]), Transient(g_DoFBlurColor[1]) };
+    FrameGraph::ResourceHandle DoFBlurAlpha[2] = { Transient(g_DoFBlurAlpha[0]), Transient(g_DoFBlurAlpha[1]) };
+    FrameGraph::ResourceHandle DoFPresort = Transient(g_DoFPresortBuffer);
+    FrameGraph::ResourceHandle DoFPrefilter = Transient(g_DoFPrefilter);
+    FrameGraph::ResourceHandle DoFWorkQueue = Transient(g_DoFWorkQueue);
+    FrameGraph::ResourceHandle DoFFastQueue = Transient(g_DoFFastQueue);
+    FrameGraph::ResourceHandle DoFFixupQueue = Transient(g_DoFFixupQueue);
+
+    FrameGraph::ResourceHandle MotionPrep = Transient(g_MotionPrepBuffer);
+    FrameGraph::ResourceHandle Luma = Transient(g_LumaBuffer);
+
+    FrameGraph::ResourceHandle LumaLR = Transient(g_LumaLR);
+    FrameGraph::ResourceHandle Bloom[5][2] =
+    {
+        { Transient(g_aBloomUAV1[0]), Transient(g_aBloomUAV1[1]) },
+        { Transient(g_aBloomUAV2[0]), Transient(g_aBloomUAV2[1]) },
+        { Transient(g_aBloomUAV3[0]), Transient(g_aBloomUAV3[1]) },
+        { Transient(g_aBloomUAV4[0]), Transient(g_aBloomUAV4[1]) },
+        { Transient(g_aBloomUAV5[0]), Transient(g_aBloomUAV5[1]) }
+    };
+
+    FrameGraph::ResourceHandle FXAAWorkQueue = Transient(g_FXAAWorkQueue);
+    FrameGraph::ResourceHandle FXAAColorQueue = Transient(g_FXAAColorQueue);
+
+    FrameGraph::PassHandle Pass;
+
+    Pass = Graph.AddPass(L"Z PrePass");
+    Graph.Write(Pass, SceneDepth, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+    Pass = Graph.AddPass(L"Linearize Depth");
+    Graph.Read(Pass, SceneDepth, SRV);
+    Graph.Write(Pass, LinearDepth, UAV);
+
+    Pass = Graph.AddPass(L"Decompress and downsample");
+    Graph.Read(Pass, LinearDepth, SRV);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        Graph.Write(Pass, DepthDownsize[i], UAV);
+        Graph.Write(Pass, DepthTiled[i], UAV);
+    }
+
+    Pass = Graph.AddPass(L"Analyze depth volumes");
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        Graph.Read(Pass, DepthTiled[i], SRV);
+        Graph.Read(Pass, DepthDownsize[i], SRV);
+        Graph.Write(Pass, AOMerged[i], UAV);
+        Graph.Write(Pass, AOHighQuality[i], UAV);
+    }
+
+    Pass = Graph.AddPass(L"Blur and upsample");
+    Graph.Read(Pass, LinearDepth, SRV);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        Graph.Read(Pass, AOMerged[i], SRV);
+        Graph.Read(Pass, AOHighQuality[i], SRV);
+        if (i < 3)
+            Graph.Write(Pass, AOSmooth[i], UAV);
+    }
+    Graph.Write(Pass, SSAOFullScreen, UAV);
+
+    Pass = Graph.AddPass(L"Render Shadow Map");
+    Graph.Write(Pass, ShadowMap, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+    Pass = Graph.AddPass(L"Render Color");
+    Graph.Read(Pass, SSAOFullScreen, PSRV);
+    Graph.Read(Pass, ShadowMap, PSRV);
+    Graph.Read(Pass, SceneDepth, D3D12_RESOURCE_STATE_DEPTH_READ);
+    Graph.Write(Pass, SceneColor, RT);
+
+    Pass = Graph.AddPass(L"Particles");
+    Graph.Read(Pass, LinearDepth, SRV);
+    for (uint32_t i = 0; i < 3; ++i)
+        Graph.Write(Pass, MinMaxDepth[i], UAV);
+
+    Pass = Graph.AddPass(L"Render Particles");
+    for (uint32_t i = 0; i < 3; ++i)
+        Graph.Read(Pass, MinMaxDepth[i], SRV);
+    Graph.Write(Pass, SceneColor, UAV);
+
+    Pass = Graph.AddPass(L"Generate Camera Velocity");
+    Graph.Read(Pass, SceneDepth, SRV);
+    Graph.Write(Pass, Velocity, UAV);
+
+    Pass = Graph.AddPass(L"DoF Tiling");
+    Graph.Read(Pass, LinearDepth, SRV);
+    Graph.Write(Pass, DoFTileClass[0], UAV);
+
+    Pass = Graph.AddPass(L"DoF Tile Queues");
+    Graph.Read(Pass, DoFTileClass[0], SRV);
+    Graph.Write(Pass, DoFTileClass[1], UAV);
+    Graph.Write(Pass, DoFWorkQueue, UAV);
+    Graph.Write(Pass, DoFFastQueue, UAV);
+    Graph.Write(Pass, DoFFixupQueue, UAV);
+
+    Pass = Graph.AddPass(L"DoF PreFilter");
+    Graph.Read(Pass, SceneColor, SRV);
+    Graph.Read(Pass, LinearDepth, SRV);
+    Graph.Read(Pass, DoFTileClass[1], SRV);
+    Graph.Read(Pass, DoFWorkQueue, SRV);
+    Graph.Read(Pass, DoFFastQueue, SRV);
+    Graph.Write(Pass, DoFPresort, UAV);
+    Graph.Write(Pass, DoFPrefilter, UAV);
+
+    Pass = Graph.AddPass(L"DoF Main Pass");
+    Graph.Read(Pass, DoFPresort, SRV);
+    Graph.Read(Pass, DoFPrefilter, SRV);
+    Graph.Write(Pass, DoFBlurColor[0], UAV);
+    Graph.Write(Pass, DoFBlurAlpha[0], UAV);
+
+    Pass = Graph.AddPass(L"DoF Median Pass");
+    Graph.Read(Pass, DoFBlurColor[0], SRV);
+    Graph.Read(Pass, DoFBlurAlpha[0], SRV);
+    Graph.Write(Pass, DoFBlurColor[1], UAV);
+    Graph.Write(Pass, DoFBlurAlpha[1], UAV);
+
+    Pass = Graph.AddPass(L"DoF Final Combine");
+    Graph.Read(Pass, DoFBlurColor[1], SRV);
+    Graph.Read(Pass, DoFBlurAlpha[1], SRV);
+    Graph.Read(Pass, DoFTileClass[1], SRV);
+    Graph.Read(Pass, DoFFixupQueue, SRV);
+    Graph.Write(Pass, SceneColor, UAV);
+
+    Pass = Graph.AddPass(L"Motion Blur Prep");
+    Graph.Read(Pass, SceneColor, SRV);
+    Graph.Read(Pass, Velocity, SRV);
+    Graph.Write(Pass, MotionPrep, UAV);
+
+    Pass = Graph.AddPass(L"Motion Blur");
+    Graph.Read(Pass, MotionPrep, SRV);
+    Graph.Read(Pass, Velocity, SRV);
+    Graph.Write(Pass, SceneColor, UAV);
+
+    Pass = Graph.AddPass(L"Resolve Image");
+    Graph.Read(Pass, Velocity, SRV);
+    Graph.Read(Pass, SceneColor, SRV);
+    Graph.Read(Pass, PrevTemporalColor, SRV);
+    Graph.Read(Pass, LinearDepth, SRV);
+    Graph.Read(Pass, PrevLinearDepth, SRV);
+    Graph.Write(Pass, TemporalColor, UAV);
+
+    Pass = Graph.AddPass(L"Sharpen or Copy Image");
+    Graph.Read(Pass, TemporalColor, SRV);
+    Graph.Write(Pass, SceneColor, UAV);
+
+    Pass = Graph.AddPass(L"Generate Bloom");
+    Graph.Read(Pass, SceneColor, SRV);
+    Graph.Write(Pass, Bloom[0][0], UAV);
+    Graph.Write(Pass, LumaLR, UAV);
+
+    Pass = Graph.AddPass(L"Downsample Bloom");
+    Graph.Read(Pass, Bloom[0][0], SRV);
+    for (uint32_t i = 1; i < 5; ++i)
+        Graph.Write(Pass, Bloom[i][0], UAV);
+
+    // Each level is blurred and blended with the level below it
+    for (int i = 4; i >= 0; --i)
+    {
+        Pass = Graph.AddPass(L"Upsample and Blur Bloom");
+        Graph.Read(Pass, Bloom[i][0], SRV);
+        if (i < 4)
+            Graph.Read(Pass, Bloom[i + 1][1], SRV);
+        Graph.Write(Pass, Bloom[i][1], UAV);
+    }
+
+    Pass = Graph.AddPass(L"Update Exposure");
+    Graph.Read(Pass, LumaLR, SRV);
+    Graph.Write(Pass, Histogram, UAV);
+
+    Pass = Graph.AddPass(L"HDR Tone Mapping");
+    Graph.Read(Pass, Bloom[0][1], SRV);
+    Graph.Write(Pass, SceneColor, UAV);
+    Graph.Write(Pass, Luma, UAV);
+
+    Pass = Graph.AddPass(L"FXAA Pass 1");
+    Graph.Read(Pass, SceneColor, SRV);
+    Graph.Read(Pass, Luma, SRV);
+    Graph.Write(Pass, FXAAWorkQueue, UAV);
+    Graph.Write(Pass, FXAAColorQueue, UAV);
+
+    Pass = Graph.AddPass(L"FXAA Pass 2");
+    Graph.Read(Pass, FXAAWorkQueue, SRV);
+    Graph.Read(Pass, FXAAColorQueue, SRV);
+    Graph.Write(Pass, SceneColor, UAV);
+
+    Pass = Graph.AddPass(L"Present");
+    Graph.Read(Pass, SceneColor, PSRV);
+    Graph.Read(Pass, Overlay, PSRV);
+}
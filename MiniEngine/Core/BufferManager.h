@@ -18,6 +18,7 @@
 #include "ShadowBuffer.h"
 #include "GpuBuffer.h"
 #include "GraphicsCore.h"
+#include "FrameGraph.h"
 
 namespace Graphics
 {
@@ -68,6 +69,7 @@ namespace Graphics
     extern ColorBuffer g_LumaBuffer;
     extern ColorBuffer g_TemporalColor[2];
 
+    // The bloom buffers are placed in the heap of the frame graph that generates bloom
     extern ColorBuffer g_aBloomUAV1[2];        // 640x384 (1/3)
     extern ColorBuffer g_aBloomUAV2[2];        // 320x192 (1/6)  
     extern ColorBuffer g_aBloomUAV3[2];        // 160x96  (1/12)
@@ -83,4 +85,13 @@ namespace Graphics
     void ResizeDisplayDependentBuffers(uint32_t NativeWidth, uint32_t NativeHeight);
     void DestroyRenderingBuffers();
 
+    // Adds one of the buffers that InitializeRenderingBuffers() leaves to a frame graph as a transient resource of
+    // the graph, which creates the buffer in its heap when it is allocated.
+    FrameGraph::ResourceHandle AddTransientRenderingBuffer(FrameGraph& Graph, GpuResource& Buffer, uint32_t NativeWidth, uint32_t NativeHeight);
+
+    // Describes the rendering buffers as resources of a frame graph, and the passes that use them in the
+    // order they run, so that the memory they would need as transient resources can be measured.  The
+    // buffers are only described, not created.
+    void DescribeRenderingPasses(FrameGraph& Graph, uint32_t NativeWidth, uint32_t NativeHeight);
+
 } // namespace Graphics
@@ -185,6 +185,38 @@ void ColorBuffer::CreateArray( const std::wstring& Name, uint32_t Width, uint32_
     CreateArray(Name, Width, Height, ArrayCount, Format);
 }
 
+void ColorBuffer::CreatePlaced( const std::wstring& Name, ID3D12Heap* pBackingHeap, uint64_t HeapOffset,
+    uint32_t Width, uint32_t Height, uint32_t ArrayCount, DXGI_FORMAT Format )
+{
+    D3D12_RESOURCE_FLAGS Flags = CombineResourceFlags();
+    D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, ArrayCount, 1, Format, Flags);
+
+    ResourceDesc.SampleDesc.Count = m_FragmentCount;
+    ResourceDesc.SampleDesc.Quality = 0;
+
+    D3D12_CLEAR_VALUE ClearValue = {};
+    ClearValue.Format = Format;
+    ClearValue.Color[0] = m_ClearColor.R();
+    ClearValue.Color[1] = m_ClearColor.G();
+    ClearValue.Color[2] = m_ClearColor.B();
+    ClearValue.Color[3] = m_ClearColor.A();
+
+    CreateTextureResource(Graphics::g_Device, Name, ResourceDesc, ClearValue, pBackingHeap, HeapOffset);
+    CreateDerivedViews(Graphics::g_Device, Format, ArrayCount, 1);
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO ColorBuffer::GetPlacedAllocationInfo( uint32_t Width, uint32_t Height, uint32_t ArrayCount,
+    DXGI_FORMAT Format )
+{
+    D3D12_RESOURCE_FLAGS Flags = CombineResourceFlags();
+    D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, ArrayCount, 1, Format, Flags);
+
+    ResourceDesc.SampleDesc.Count = m_FragmentCount;
+    ResourceDesc.SampleDesc.Quality = 0;
+
+    return Graphics::g_Device->GetResourceAllocationInfo(1, 1, &ResourceDesc);
+}
+
 void ColorBuffer::Create3D(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t Depth, uint32_t NumMips,
     DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMem)
 {
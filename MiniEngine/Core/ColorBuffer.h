@@ -65,6 +65,17 @@ public:
     void Create3D(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t Depth, uint32_t NumMips,
         DXGI_FORMAT Format, EsramAllocator& Allocator);
 
+    // Create a color buffer or color buffer array at an offset of a heap, so that its memory can be shared
+    // with other resources that are not used at the same time.  The contents are undefined after another
+    // resource has used the memory, so they must be discarded or fully rewritten before being read.
+    void CreatePlaced(const std::wstring& Name, ID3D12Heap* pBackingHeap, uint64_t HeapOffset,
+        uint32_t Width, uint32_t Height, uint32_t ArrayCount, DXGI_FORMAT Format);
+
+    // Get the size and alignment of the memory CreatePlaced() needs for the same dimensions.  Like the
+    // Create functions, this sets the dimensions of the buffer, so call it before creating the buffer.
+    D3D12_RESOURCE_ALLOCATION_INFO GetPlacedAllocationInfo(uint32_t Width, uint32_t Height, uint32_t ArrayCount,
+        DXGI_FORMAT Format);
+
     // Get pre-created CPU-visible descriptor handles
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetSRV(void) const { return m_SRVHandle; }
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetRTV(void) const { return m_RTVHandle; }
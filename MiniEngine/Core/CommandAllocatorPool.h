@@ -27,8 +27,10 @@ public:
     void Create(ID3D12Device* pDevice);
     void Shutdown();
 
-    ID3D12CommandAllocator* RequestAllocator(uint64_t CompletedFenceValue);
-    void DiscardAllocator(uint64_t FenceValue, ID3D12CommandAllocator* Allocator);
+    ID3D12CommandAllocator* RequestAllocator(void);
+
+    // Only once the GPU has finished with the allocator's command lists
+    void DiscardAllocator(ID3D12CommandAllocator* Allocator);
 
     inline size_t Size() { return m_AllocatorPool.size(); }
 
@@ -37,6 +39,6 @@ private:
 
     ID3D12Device* m_Device;
     std::vector<ID3D12CommandAllocator*> m_AllocatorPool;
-    std::queue<std::pair<uint64_t, ID3D12CommandAllocator*>> m_ReadyAllocators;
+    std::queue<ID3D12CommandAllocator*> m_ReadyAllocators;
     std::mutex m_AllocatorMutex;
 };
@@ -64,6 +64,15 @@ void ContextManager::FreeContext(CommandContext* UsedContext)
     ASSERT(UsedContext != nullptr);
     std::lock_guard<std::mutex> LockGuard(sm_ContextAllocationMutex);
     sm_AvailableContexts[UsedContext->m_Type].push(UsedContext);
+    sm_FinishedContextStats.Add(UsedContext->m_Stats);
+}
+
+CommandContextStats ContextManager::ResetStats(void)
+{
+    std::lock_guard<std::mutex> LockGuard(sm_ContextAllocationMutex);
+    CommandContextStats Stats = sm_FinishedContextStats;
+    sm_FinishedContextStats = CommandContextStats();
+    return Stats;
 }
 
 void CommandContext::DestroyAllContexts(void)
@@ -99,6 +108,7 @@ uint64_t CommandContext::Flush(bool WaitForCompletion)
     ASSERT(m_CurrentAllocator != nullptr);
 
     uint64_t FenceValue = g_CommandManager.GetQueue(m_Type).ExecuteCommandList(m_CommandList);
+    ++m_Stats.NumCommandLists;
 
     if (WaitForCompletion)
         g_CommandManager.WaitForFence(FenceValue);
@@ -144,6 +154,14 @@ uint64_t CommandContext::Finish( bool WaitForCompletion )
     Queue.DiscardAllocator(FenceValue, m_CurrentAllocator);
     m_CurrentAllocator = nullptr;
 
+    ++m_Stats.NumCommandLists;
+    m_Stats.NumDynamicDescriptors += m_DynamicViewDescriptorHeap.GetNumDescriptorsWritten();
+    m_Stats.NumDynamicDescriptors += m_DynamicSamplerDescriptorHeap.GetNumDescriptorsWritten();
+    m_Stats.NumDescriptorCopies += m_DynamicViewDescriptorHeap.GetNumDescriptorCopies();
+    m_Stats.NumDescriptorCopies += m_DynamicSamplerDescriptorHeap.GetNumDescriptorCopies();
+    m_Stats.NumReusedDescriptorTables += m_DynamicViewDescriptorHeap.GetNumTablesReused();
+    m_Stats.NumReusedDescriptorTables += m_DynamicSamplerDescriptorHeap.GetNumTablesReused();
+
     m_CpuLinearAllocator.CleanupUsedPages(FenceValue);
     m_GpuLinearAllocator.CleanupUsedPages(FenceValue);
     m_DynamicViewDescriptorHeap.CleanupUsedHeaps(FenceValue);
@@ -173,6 +191,7 @@ CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
     m_CurPipelineState = nullptr;
     m_CurComputeRootSignature = nullptr;
     m_NumBarriersToFlush = 0;
+    m_Stats = CommandContextStats();
 }
 
 CommandContext::~CommandContext( void )
@@ -198,6 +217,7 @@ void CommandContext::Reset( void )
     m_CurPipelineState = nullptr;
     m_CurComputeRootSignature = nullptr;
     m_NumBarriersToFlush = 0;
+    m_Stats = CommandContextStats();
 
     BindDescriptorHeaps();
 }
@@ -415,7 +435,7 @@ void CommandContext::InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate
     BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
     BarrierDesc.UAV.pResource = Resource.GetResource();
 
-    if (FlushImmediate)
+    if (FlushImmediate || m_NumBarriersToFlush == 16)
         FlushResourceBarriers();
 }
 
@@ -429,7 +449,21 @@ void CommandContext::InsertAliasBarrier(GpuResource& Before, GpuResource& After,
     BarrierDesc.Aliasing.pResourceBefore = Before.GetResource();
     BarrierDesc.Aliasing.pResourceAfter = After.GetResource();
 
-    if (FlushImmediate)
+    if (FlushImmediate || m_NumBarriersToFlush == 16)
+        FlushResourceBarriers();
+}
+
+void CommandContext::InsertAliasBarrier(GpuResource& After, bool FlushImmediate)
+{
+    ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
+    D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+
+    BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+    BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    BarrierDesc.Aliasing.pResourceBefore = nullptr;
+    BarrierDesc.Aliasing.pResourceAfter = After.GetResource();
+
+    if (FlushImmediate || m_NumBarriersToFlush == 16)
         FlushResourceBarriers();
 }
 
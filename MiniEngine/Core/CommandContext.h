@@ -57,19 +57,51 @@ struct DWParam
     | D3D12_RESOURCE_STATE_COPY_DEST \
     | D3D12_RESOURCE_STATE_COPY_SOURCE )
 
+// API calls recorded by a context.  Each context counts its own, and they are summed when the
+// context is freed, so recording on several threads costs no synchronization.
+struct CommandContextStats
+{
+    uint32_t NumCommandLists;
+    uint32_t NumDraws;
+    uint32_t NumDispatches;
+    uint32_t NumBarriers;
+    uint32_t NumPipelineStates;
+    uint32_t NumRootSignatures;
+    uint32_t NumDynamicDescriptors;        // Written to shader-visible heaps by the dynamic descriptor heaps
+    uint32_t NumDescriptorCopies;          // CopyDescriptors calls made by the dynamic descriptor heaps
+    uint32_t NumReusedDescriptorTables;    // Bound by the dynamic descriptor heaps without copying
+
+    void Add( const CommandContextStats& Other )
+    {
+        NumCommandLists += Other.NumCommandLists;
+        NumDraws += Other.NumDraws;
+        NumDispatches += Other.NumDispatches;
+        NumBarriers += Other.NumBarriers;
+        NumPipelineStates += Other.NumPipelineStates;
+        NumRootSignatures += Other.NumRootSignatures;
+        NumDynamicDescriptors += Other.NumDynamicDescriptors;
+        NumDescriptorCopies += Other.NumDescriptorCopies;
+        NumReusedDescriptorTables += Other.NumReusedDescriptorTables;
+    }
+};
+
 class ContextManager
 {
 public:
-    ContextManager(void) {}
+    ContextManager(void) : sm_FinishedContextStats() {}
 
     CommandContext* AllocateContext(D3D12_COMMAND_LIST_TYPE Type);
     void FreeContext(CommandContext*);
     void DestroyAllContexts();
 
+    // Returns the API calls of the contexts finished since the last call
+    CommandContextStats ResetStats(void);
+
 private:
     std::vector<std::unique_ptr<CommandContext> > sm_ContextPool[4];
     std::queue<CommandContext*> sm_AvailableContexts[4];
     std::mutex sm_ContextAllocationMutex;
+    CommandContextStats sm_FinishedContextStats;
 };
 
 struct NonCopyable
@@ -141,10 +173,11 @@ public:
     void BeginResourceTransition(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate = false);
     void InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate = false);
     void InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate = false);
+    void InsertAliasBarrier(GpuResource& After, bool FlushImmediate = false);    // Any resource may have used the memory
     inline void FlushResourceBarriers(void);
 
     void InsertTimeStamp( ID3D12QueryHeap* pQueryHeap, uint32_t QueryIdx );
-    void ResolveTimeStamps( ID3D12Resource* pReadbackHeap, ID3D12QueryHeap* pQueryHeap, uint32_t NumQueries );
+    void ResolveTimeStamps( ID3D12Resource* pReadbackHeap, ID3D12QueryHeap* pQueryHeap, uint32_t NumQueries, uint32_t StartIdx = 0 );
     void PIXBeginEvent(const wchar_t* label);
     void PIXEndEvent(void);
     void PIXSetMarker(const wchar_t* label);
@@ -182,6 +215,8 @@ protected:
     void SetID(const std::wstring& ID) { m_ID = ID; }
 
     D3D12_COMMAND_LIST_TYPE m_Type;
+
+    CommandContextStats m_Stats;
 };
 
 class GraphicsContext : public CommandContext
@@ -239,6 +274,7 @@ public:
     void SetDynamicDescriptors( UINT RootIndex, UINT Offset, UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] );
     void SetDynamicSampler( UINT RootIndex, UINT Offset, D3D12_CPU_DESCRIPTOR_HANDLE Handle );
     void SetDynamicSamplers( UINT RootIndex, UINT Offset, UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] );
+    void SetPersistentDescriptorTable( UINT RootIndex, uint32_t TableOffset );
 
     void SetIndexBuffer( const D3D12_INDEX_BUFFER_VIEW& IBView );
     void SetVertexBuffer( UINT Slot, const D3D12_VERTEX_BUFFER_VIEW& VBView );
@@ -288,6 +324,7 @@ public:
     void SetDynamicDescriptors( UINT RootIndex, UINT Offset, UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] );
     void SetDynamicSampler( UINT RootIndex, UINT Offset, D3D12_CPU_DESCRIPTOR_HANDLE Handle );
     void SetDynamicSamplers( UINT RootIndex, UINT Offset, UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] );
+    void SetPersistentDescriptorTable( UINT RootIndex, uint32_t TableOffset );
 
     void Dispatch( size_t GroupCountX = 1, size_t GroupCountY = 1, size_t GroupCountZ = 1 );
     void Dispatch1D( size_t ThreadCountX, size_t GroupSizeX = 64);
@@ -305,6 +342,7 @@ inline void CommandContext::FlushResourceBarriers( void )
     if (m_NumBarriersToFlush > 0)
     {
         m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
+        m_Stats.NumBarriers += m_NumBarriersToFlush;
         m_NumBarriersToFlush = 0;
     }
 }
@@ -315,6 +353,7 @@ inline void GraphicsContext::SetRootSignature( const RootSignature& RootSig )
         return;
 
     m_CommandList->SetGraphicsRootSignature(m_CurGraphicsRootSignature = RootSig.GetSignature());
+    ++m_Stats.NumRootSignatures;
 
     m_DynamicViewDescriptorHeap.ParseGraphicsRootSignature(RootSig);
     m_DynamicSamplerDescriptorHeap.ParseGraphicsRootSignature(RootSig);
@@ -326,6 +365,7 @@ inline void ComputeContext::SetRootSignature( const RootSignature& RootSig )
         return;
 
     m_CommandList->SetComputeRootSignature(m_CurComputeRootSignature = RootSig.GetSignature());
+    ++m_Stats.NumRootSignatures;
 
     m_DynamicViewDescriptorHeap.ParseComputeRootSignature(RootSig);
     m_DynamicSamplerDescriptorHeap.ParseComputeRootSignature(RootSig);
@@ -339,6 +379,7 @@ inline void CommandContext::SetPipelineState( const PSO& PSO )
 
     m_CommandList->SetPipelineState(PipelineState);
     m_CurPipelineState = PipelineState;
+    ++m_Stats.NumPipelineStates;
 }
 
 inline void GraphicsContext::SetViewportAndScissor( UINT x, UINT y, UINT w, UINT h )
@@ -547,6 +588,7 @@ inline void ComputeContext::Dispatch( size_t GroupCountX, size_t GroupCountY, si
     m_DynamicViewDescriptorHeap.CommitComputeRootDescriptorTables(m_CommandList);
     m_DynamicSamplerDescriptorHeap.CommitComputeRootDescriptorTables(m_CommandList);
     m_CommandList->Dispatch((UINT)GroupCountX, (UINT)GroupCountY, (UINT)GroupCountZ);
+    ++m_Stats.NumDispatches;
 }
 
 inline void ComputeContext::Dispatch1D( size_t ThreadCountX, size_t GroupSizeX )
@@ -620,6 +662,16 @@ inline void ComputeContext::SetDynamicDescriptors( UINT RootIndex, UINT Offset,
     m_DynamicViewDescriptorHeap.SetComputeDescriptorHandles(RootIndex, Offset, Count, Handles);
 }
 
+inline void GraphicsContext::SetPersistentDescriptorTable( UINT RootIndex, uint32_t TableOffset )
+{
+    m_DynamicViewDescriptorHeap.SetGraphicsPersistentTable(RootIndex, TableOffset);
+}
+
+inline void ComputeContext::SetPersistentDescriptorTable( UINT RootIndex, uint32_t TableOffset )
+{
+    m_DynamicViewDescriptorHeap.SetComputePersistentTable(RootIndex, TableOffset);
+}
+
 inline void GraphicsContext::SetDynamicSampler( UINT RootIndex, UINT Offset, D3D12_CPU_DESCRIPTOR_HANDLE Handle )
 {
     SetDynamicSamplers(RootIndex, Offset, 1, &Handle);
@@ -682,6 +734,7 @@ inline void GraphicsContext::DrawInstanced(UINT VertexCountPerInstance, UINT Ins
     m_DynamicViewDescriptorHeap.CommitGraphicsRootDescriptorTables(m_CommandList);
     m_DynamicSamplerDescriptorHeap.CommitGraphicsRootDescriptorTables(m_CommandList);
     m_CommandList->DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
+    ++m_Stats.NumDraws;
 }
 
 inline void GraphicsContext::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation,
@@ -691,6 +744,7 @@ inline void GraphicsContext::DrawIndexedInstanced(UINT IndexCountPerInstance, UI
     m_DynamicViewDescriptorHeap.CommitGraphicsRootDescriptorTables(m_CommandList);
     m_DynamicSamplerDescriptorHeap.CommitGraphicsRootDescriptorTables(m_CommandList);
     m_CommandList->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+    ++m_Stats.NumDraws;
 }
 
 inline void GraphicsContext::ExecuteIndirect(CommandSignature& CommandSig,
@@ -703,6 +757,7 @@ inline void GraphicsContext::ExecuteIndirect(CommandSignature& CommandSig,
     m_CommandList->ExecuteIndirect(CommandSig.GetSignature(), MaxCommands,
         ArgumentBuffer.GetResource(), ArgumentStartOffset,
         CommandCounterBuffer == nullptr ? nullptr : CommandCounterBuffer->GetResource(), CounterOffset);
+    ++m_Stats.NumDraws;
 }
 
 inline void GraphicsContext::DrawIndirect(GpuBuffer& ArgumentBuffer, uint64_t ArgumentBufferOffset)
@@ -720,6 +775,7 @@ inline void ComputeContext::ExecuteIndirect(CommandSignature& CommandSig,
     m_CommandList->ExecuteIndirect(CommandSig.GetSignature(), MaxCommands,
         ArgumentBuffer.GetResource(), ArgumentStartOffset,
         CommandCounterBuffer == nullptr ? nullptr : CommandCounterBuffer->GetResource(), CounterOffset);
+    ++m_Stats.NumDispatches;
 }
 
 inline void ComputeContext::DispatchIndirect( GpuBuffer& ArgumentBuffer, uint64_t ArgumentBufferOffset )
@@ -762,7 +818,7 @@ inline void CommandContext::InsertTimeStamp(ID3D12QueryHeap* pQueryHeap, uint32_
     m_CommandList->EndQuery(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, QueryIdx);
 }
 
-inline void CommandContext::ResolveTimeStamps(ID3D12Resource* pReadbackHeap, ID3D12QueryHeap* pQueryHeap, uint32_t NumQueries)
+inline void CommandContext::ResolveTimeStamps(ID3D12Resource* pReadbackHeap, ID3D12QueryHeap* pQueryHeap, uint32_t NumQueries, uint32_t StartIdx)
 {
-    m_CommandList->ResolveQueryData(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0, NumQueries, pReadbackHeap, 0);
+    m_CommandList->ResolveQueryData(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, StartIdx, NumQueries, pReadbackHeap, StartIdx * sizeof(uint64_t));
 }
@@ -34,10 +34,10 @@ void CommandQueue::Shutdown()
     if (m_CommandQueue == nullptr)
         return;
 
+    // Stop the watcher first, its callbacks return allocators to the pool
+    m_FenceService.Stop();
     m_AllocatorPool.Shutdown();
 
-    CloseHandle(m_FenceEventHandle);
-
     m_pFence->Release();
     m_pFence = nullptr;
 
@@ -81,8 +81,7 @@ void CommandQueue::Create(ID3D12Device* pDevice)
     m_pFence->SetName(L"CommandListManager::m_pFence");
     m_pFence->Signal((uint64_t)m_Type << 56);
 
-    m_FenceEventHandle = CreateEvent(nullptr, false, false, nullptr);
-    ASSERT(m_FenceEventHandle != NULL);
+    m_FenceService.Start(m_pFence);
 
     m_AllocatorPool.Create(pDevice);
 
@@ -171,17 +170,10 @@ void CommandQueue::WaitForFence(uint64_t FenceValue)
     if (IsFenceComplete(FenceValue))
         return;
 
-    // TODO:  Think about how this might affect a multi-threaded situation.  Suppose thread A
-    // wants to wait for fence 100, then thread B comes along and wants to wait for 99.  If
-    // the fence can only have one event set on completion, then thread B has to wait for 
-    // 100 before it knows 99 is ready.  Maybe insert sequential events?
-    {
-        std::lock_guard<std::mutex> LockGuard(m_EventMutex);
-
-        m_pFence->SetEventOnCompletion(FenceValue, m_FenceEventHandle);
-        WaitForSingleObject(m_FenceEventHandle, INFINITE);
-        m_LastCompletedFenceValue = FenceValue;
-    }
+    // The fence service wakes each waiter when its own value completes, so a thread waiting
+    // for fence 99 no longer has to wait for another thread's 100.
+    m_FenceService.Wait(FenceValue);
+    m_LastCompletedFenceValue = std::max(m_LastCompletedFenceValue, FenceValue);
 }
 
 void CommandListManager::WaitForFence(uint64_t FenceValue)
@@ -192,12 +184,11 @@ void CommandListManager::WaitForFence(uint64_t FenceValue)
 
 ID3D12CommandAllocator* CommandQueue::RequestAllocator()
 {
-    uint64_t CompletedFence = m_pFence->GetCompletedValue();
-
-    return m_AllocatorPool.RequestAllocator(CompletedFence);
+    return m_AllocatorPool.RequestAllocator();
 }
 
 void CommandQueue::DiscardAllocator(uint64_t FenceValue, ID3D12CommandAllocator* Allocator)
 {
-    m_AllocatorPool.DiscardAllocator(FenceValue, Allocator);
+    CommandAllocatorPool& AllocatorPool = m_AllocatorPool;
+    m_FenceService.OnCompletion(FenceValue, [&AllocatorPool, Allocator] { AllocatorPool.DiscardAllocator(Allocator); });
 }
@@ -18,6 +18,7 @@
 #include <mutex>
 #include <stdint.h>
 #include "CommandAllocatorPool.h"
+#include "FenceService.h"
 
 class CommandQueue
 {
@@ -43,6 +44,12 @@ public:
     void WaitForFence(uint64_t FenceValue);
     void WaitForIdle(void) { WaitForFence(IncrementFence()); }
 
+    // Runs Callback on the fence watcher thread once the fence reaches FenceValue
+    void OnFenceComplete(uint64_t FenceValue, std::function<void()> Callback)
+    {
+        m_FenceService.OnCompletion(FenceValue, std::move(Callback));
+    }
+
     ID3D12CommandQueue* GetCommandQueue() { return m_CommandQueue; }
 
     uint64_t GetNextFenceValue() { return m_NextFenceValue; }
@@ -59,13 +66,12 @@ private:
 
     CommandAllocatorPool m_AllocatorPool;
     std::mutex m_FenceMutex;
-    std::mutex m_EventMutex;
 
     // Lifetime of these objects is managed by the descriptor cache
     ID3D12Fence* m_pFence;
     uint64_t m_NextFenceValue;
     uint64_t m_LastCompletedFenceValue;
-    HANDLE m_FenceEventHandle;
+    FenceService m_FenceService;
 
 };
 
@@ -113,6 +119,13 @@ public:
     // The CPU will wait for a fence to reach a specified value
     void WaitForFence(uint64_t FenceValue);
 
+    // Runs Callback on a watcher thread once the fence reaches a specified value.  This is how
+    // pools find out that the GPU is done with what they handed out.
+    void OnFenceComplete(uint64_t FenceValue, std::function<void()> Callback)
+    {
+        GetQueue(D3D12_COMMAND_LIST_TYPE(FenceValue >> 56)).OnFenceComplete(FenceValue, std::move(Callback));
+    }
+
     // The CPU will wait for all command queues to empty (so that the GPU is idle)
     void IdleGPU(void)
     {
@@ -17,6 +17,7 @@
 #include "GraphicsCore.h"
 #include "CommandListManager.h"
 #include "RootSignature.h"
+#include "Hash.h"
 
 using namespace Graphics;
 
@@ -26,8 +27,11 @@ using namespace Graphics;
 
 std::mutex DynamicDescriptorHeap::sm_Mutex;
 std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> DynamicDescriptorHeap::sm_DescriptorHeapPool[2];
-std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> DynamicDescriptorHeap::sm_RetiredDescriptorHeaps[2];
 std::queue<ID3D12DescriptorHeap*> DynamicDescriptorHeap::sm_AvailableDescriptorHeaps[2];
+Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> DynamicDescriptorHeap::sm_PersistentDescriptors;
+std::unordered_map<ID3D12DescriptorHeap*, uint32_t> DynamicDescriptorHeap::sm_PersistentDescriptorsInHeap;
+uint32_t DynamicDescriptorHeap::sm_NumPersistentDescriptors = 0;
+uint32_t DynamicDescriptorHeap::sm_MaxPersistentDescriptors = 0;
 
 ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType)
 {
@@ -35,12 +39,6 @@ ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(D3D12_DESCRIP
 
     uint32_t idx = HeapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER ? 1 : 0;
 
-    while (!sm_RetiredDescriptorHeaps[idx].empty() && g_CommandManager.IsFenceComplete(sm_RetiredDescriptorHeaps[idx].front().first))
-    {
-        sm_AvailableDescriptorHeaps[idx].push(sm_RetiredDescriptorHeaps[idx].front().second);
-        sm_RetiredDescriptorHeaps[idx].pop();
-    }
-
     if (!sm_AvailableDescriptorHeaps[idx].empty())
     {
         ID3D12DescriptorHeap* HeapPtr = sm_AvailableDescriptorHeaps[idx].front();
@@ -64,24 +62,98 @@ ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(D3D12_DESCRIP
 void DynamicDescriptorHeap::DiscardDescriptorHeaps( D3D12_DESCRIPTOR_HEAP_TYPE HeapType, uint64_t FenceValue, const std::vector<ID3D12DescriptorHeap*>& UsedHeaps )
 {
     uint32_t idx = HeapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER ? 1 : 0;
+    g_CommandManager.OnFenceComplete(FenceValue, [idx, UsedHeaps]
+    {
+        std::lock_guard<std::mutex> LockGuard(sm_Mutex);
+        for (auto iter = UsedHeaps.begin(); iter != UsedHeaps.end(); ++iter)
+            sm_AvailableDescriptorHeaps[idx].push(*iter);
+    });
+}
+
+void DynamicDescriptorHeap::ReservePersistentDescriptors( uint32_t Count )
+{
     std::lock_guard<std::mutex> LockGuard(sm_Mutex);
-    for (auto iter = UsedHeaps.begin(); iter != UsedHeaps.end(); ++iter)
-        sm_RetiredDescriptorHeaps[idx].push(std::make_pair(FenceValue, *iter));
+
+    ASSERT(sm_PersistentDescriptors == nullptr, "The persistent region can only be reserved once");
+    ASSERT(Count > 0);
+    ASSERT(Count < kNumDescriptorsPerHeap, "The persistent region must leave room for dynamic tables");
+
+    D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = {};
+    HeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    HeapDesc.NumDescriptors = Count;
+    HeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    HeapDesc.NodeMask = 1;
+    ASSERT_SUCCEEDED(g_Device->CreateDescriptorHeap(&HeapDesc, MY_IID_PPV_ARGS(&sm_PersistentDescriptors)));
+
+    sm_NumPersistentDescriptors = 0;
+    sm_MaxPersistentDescriptors = Count;
+}
+
+uint32_t DynamicDescriptorHeap::CreatePersistentTable( UINT NumHandles, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] )
+{
+    std::lock_guard<std::mutex> LockGuard(sm_Mutex);
+
+    if (sm_NumPersistentDescriptors + NumHandles > sm_MaxPersistentDescriptors)
+        return kInvalidPersistentTable;
+
+    uint32_t DescriptorSize = g_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    D3D12_CPU_DESCRIPTOR_HANDLE DestHandle = sm_PersistentDescriptors->GetCPUDescriptorHandleForHeapStart();
+    DestHandle.ptr += sm_NumPersistentDescriptors * DescriptorSize;
+
+    for (UINT i = 0; i < NumHandles; ++i)
+    {
+        g_Device->CopyDescriptorsSimple(1, DestHandle, Handles[i], D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        DestHandle.ptr += DescriptorSize;
+    }
+
+    uint32_t TableOffset = sm_NumPersistentDescriptors;
+    sm_NumPersistentDescriptors += NumHandles;
+    return TableOffset;
+}
+
+void DynamicDescriptorHeap::CopyPersistentDescriptors( void )
+{
+    if (m_DescriptorType != D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
+        return;
+
+    std::lock_guard<std::mutex> LockGuard(sm_Mutex);
+
+    // Tables are only ever appended, so only those created since the last copy are missing.  Nothing recorded
+    // so far refers to them, so they can be written while the heap is in use.
+    uint32_t NumNewDescriptors = sm_NumPersistentDescriptors - m_NumPersistentDescriptors;
+    if (NumNewDescriptors == 0)
+        return;
+
+    ASSERT(sm_NumPersistentDescriptors <= m_NumReservedDescriptors, "Persistent region was reserved while recording");
+
+    D3D12_CPU_DESCRIPTOR_HANDLE SrcHandle = sm_PersistentDescriptors->GetCPUDescriptorHandleForHeapStart();
+    SrcHandle.ptr += m_NumPersistentDescriptors * m_DescriptorSize;
+    DescriptorHandle DestHandle = m_HeapStart + m_NumPersistentDescriptors * m_DescriptorSize;
+
+    g_Device->CopyDescriptorsSimple(NumNewDescriptors, DestHandle.GetCpuHandle(), SrcHandle, m_DescriptorType);
+    ++m_NumDescriptorCopies;
+    m_NumDescriptorsWritten += NumNewDescriptors;
+
+    m_NumPersistentDescriptors = sm_NumPersistentDescriptors;
+    sm_PersistentDescriptorsInHeap[m_CurrentHeapPtr] = m_NumPersistentDescriptors;
 }
 
 void DynamicDescriptorHeap::RetireCurrentHeap( void )
 {
     // Don't retire unused heaps.
-    if (m_CurrentOffset == 0)
+    if (m_CurrentHeapPtr == nullptr)
     {
-        ASSERT(m_CurrentHeapPtr == nullptr);
+        ASSERT(m_CurrentOffset == 0);
         return;
     }
 
-    ASSERT(m_CurrentHeapPtr != nullptr);
     m_RetiredHeaps.push_back(m_CurrentHeapPtr);
     m_CurrentHeapPtr = nullptr;
     m_CurrentOffset = 0;
+
+    // Tables copied to the retired heap can't be bound with the next one
+    m_CachedTables.clear();
+    m_CachedTableHandles.clear();
 }
 
 void DynamicDescriptorHeap::RetireUsedHeaps( uint64_t fenceValue )
@@ -95,6 +167,11 @@ DynamicDescriptorHeap::DynamicDescriptorHeap(CommandContext& OwningContext, D3D1
 {
     m_CurrentHeapPtr = nullptr;
     m_CurrentOffset = 0;
+    m_NumDescriptorsWritten = 0;
+    m_NumDescriptorCopies = 0;
+    m_NumTablesReused = 0;
+    m_NumReservedDescriptors = 0;
+    m_NumPersistentDescriptors = 0;
     m_DescriptorSize = Graphics::g_Device->GetDescriptorHandleIncrementSize(HeapType);
 }
 
@@ -108,6 +185,9 @@ void DynamicDescriptorHeap::CleanupUsedHeaps( uint64_t fenceValue )
     RetireUsedHeaps(fenceValue);
     m_GraphicsHandleCache.ClearCache();
     m_ComputeHandleCache.ClearCache();
+    m_NumDescriptorsWritten = 0;
+    m_NumDescriptorCopies = 0;
+    m_NumTablesReused = 0;
 }
 
 inline ID3D12DescriptorHeap* DynamicDescriptorHeap::GetHeapPointer()
@@ -116,65 +196,148 @@ inline ID3D12DescriptorHeap* DynamicDescriptorHeap::GetHeapPointer()
     {
         ASSERT(m_CurrentOffset == 0);
         m_CurrentHeapPtr = RequestDescriptorHeap(m_DescriptorType);
-        m_FirstDescriptor = DescriptorHandle(
+        m_HeapStart = DescriptorHandle(
             m_CurrentHeapPtr->GetCPUDescriptorHandleForHeapStart(),
             m_CurrentHeapPtr->GetGPUDescriptorHandleForHeapStart());
+
+        // Dynamic tables never overwrite the persistent region, so a pooled heap still holds the persistent tables
+        // it was given before.  Only the tables created since then are copied.
+        m_NumReservedDescriptors = 0;
+        m_NumPersistentDescriptors = 0;
+        if (m_DescriptorType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
+        {
+            {
+                std::lock_guard<std::mutex> LockGuard(sm_Mutex);
+                m_NumReservedDescriptors = sm_MaxPersistentDescriptors;
+                auto Copied = sm_PersistentDescriptorsInHeap.find(m_CurrentHeapPtr);
+                if (Copied != sm_PersistentDescriptorsInHeap.end())
+                    m_NumPersistentDescriptors = Copied->second;
+            }
+            CopyPersistentDescriptors();
+        }
+
+        m_FirstDescriptor = m_HeapStart + m_NumReservedDescriptors * m_DescriptorSize;
     }
 
     return m_CurrentHeapPtr;
 }
 
-uint32_t DynamicDescriptorHeap::DescriptorHandleCache::ComputeStagedSize()
+uint32_t DynamicDescriptorHeap::GatherStaleTables( const DescriptorHandleCache& HandleCache, StaleTable Tables[], uint32_t& NumTables )
 {
-    // Sum the maximum assigned offsets of stale descriptor tables to determine total needed space.
     uint32_t NeededSpace = 0;
     uint32_t RootIndex;
-    uint32_t StaleParams = m_StaleRootParamsBitMap;
+
+    NumTables = 0;
+
+    uint32_t StaleParams = HandleCache.m_StaleRootParamsBitMap;
     while (_BitScanForward((unsigned long*)&RootIndex, StaleParams))
     {
         StaleParams ^= (1 << RootIndex);
 
+        StaleTable& Table = Tables[NumTables++];
+        Table.RootIndex = RootIndex;
+
+        // Persistent tables are already in the heap
+        if (HandleCache.m_PersistentTablesBitMap & (1 << RootIndex))
+        {
+            Table.TableSize = 0;
+            Table.Hash = 0;
+            Table.HeapOffset = HandleCache.m_PersistentTableOffset[RootIndex];
+            continue;
+        }
+
+        const DescriptorTableCache& RootDescTable = HandleCache.m_RootDescriptorTable[RootIndex];
+
         uint32_t MaxSetHandle;
-        ASSERT(TRUE == _BitScanReverse((unsigned long*)&MaxSetHandle, m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap),
+        ASSERT(TRUE == _BitScanReverse((unsigned long*)&MaxSetHandle, RootDescTable.AssignedHandlesBitMap),
             "Root entry marked as stale but has no stale descriptors");
 
-        NeededSpace += MaxSetHandle + 1;
+        Table.TableSize = MaxSetHandle + 1;
+
+        // Hash the runs of assigned handles, along with which handles are assigned
+        size_t Hash = Utility::HashState(&RootDescTable.AssignedHandlesBitMap);
+        const D3D12_CPU_DESCRIPTOR_HANDLE* SrcHandles = RootDescTable.TableStart;
+        uint64_t SetHandles = (uint64_t)RootDescTable.AssignedHandlesBitMap;
+
+        unsigned long SkipCount;
+        while (_BitScanForward64(&SkipCount, SetHandles))
+        {
+            SetHandles >>= SkipCount;
+            SrcHandles += SkipCount;
+
+            unsigned long DescriptorCount;
+            _BitScanForward64(&DescriptorCount, ~SetHandles);
+            SetHandles >>= DescriptorCount;
+
+            Hash = Utility::HashState(SrcHandles, DescriptorCount, Hash);
+            SrcHandles += DescriptorCount;
+        }
+
+        Table.Hash = Hash;
+
+        if (!FindCachedTable(RootDescTable, Table.TableSize, Hash, Table.HeapOffset))
+        {
+            Table.HeapOffset = kInvalidHeapOffset;
+            NeededSpace += Table.TableSize;
+        }
     }
+
+    ASSERT(NumTables <= DescriptorHandleCache::kMaxNumDescriptorTables,
+        "We're only equipped to handle so many descriptor tables");
+
     return NeededSpace;
 }
 
-void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
-    D3D12_DESCRIPTOR_HEAP_TYPE Type, uint32_t DescriptorSize,
-    DescriptorHandle DestHandleStart, ID3D12GraphicsCommandList* CmdList,
-    void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE))
+bool DynamicDescriptorHeap::FindCachedTable( const DescriptorTableCache& Table, uint32_t TableSize, size_t Hash, uint32_t& HeapOffset ) const
 {
-    uint32_t StaleParamCount = 0;
-    uint32_t TableSize[DescriptorHandleCache::kMaxNumDescriptorTables];
-    uint32_t RootIndices[DescriptorHandleCache::kMaxNumDescriptorTables];
-    uint32_t NeededSpace = 0;
-    uint32_t RootIndex;
-
-    // Sum the maximum assigned offsets of stale descriptor tables to determine total needed space.
-    uint32_t StaleParams = m_StaleRootParamsBitMap;
-    while (_BitScanForward((unsigned long*)&RootIndex, StaleParams))
+    auto Iter = m_CachedTables.find(Hash);
+    if (Iter == m_CachedTables.end())
+        return false;
+
+    const CachedTable& Cached = Iter->second;
+    if (Cached.TableSize != TableSize || Cached.AssignedHandlesBitMap != Table.AssignedHandlesBitMap)
+        return false;
+
+    // Only the assigned handles have to match
+    const D3D12_CPU_DESCRIPTOR_HANDLE* CachedHandles = &m_CachedTableHandles[Cached.HandleStart];
+    uint32_t SetHandles = Table.AssignedHandlesBitMap;
+    unsigned long HandleIndex;
+    while (_BitScanForward(&HandleIndex, SetHandles))
     {
-        RootIndices[StaleParamCount] = RootIndex;
-        StaleParams ^= (1 << RootIndex);
+        SetHandles ^= (1 << HandleIndex);
+        if (CachedHandles[HandleIndex].ptr != Table.TableStart[HandleIndex].ptr)
+            return false;
+    }
 
-        uint32_t MaxSetHandle;
-        ASSERT(TRUE == _BitScanReverse((unsigned long*)&MaxSetHandle, m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap),
-            "Root entry marked as stale but has no stale descriptors");
+    HeapOffset = Cached.HeapOffset;
+    return true;
+}
 
-        NeededSpace += MaxSetHandle + 1;
-        TableSize[StaleParamCount] = MaxSetHandle + 1;
+void DynamicDescriptorHeap::CopyAndBindStagedTables( DescriptorHandleCache& HandleCache, ID3D12GraphicsCommandList* CmdList,
+    void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE))
+{
+    StaleTable Tables[DescriptorHandleCache::kMaxNumDescriptorTables];
+    uint32_t NumTables;
 
-        ++StaleParamCount;
+    uint32_t NeededSize = GatherStaleTables(HandleCache, Tables, NumTables);
+    if (!HasSpace(NeededSize))
+    {
+        RetireCurrentHeap();
+        UnbindAllValid();
+        NeededSize = GatherStaleTables(HandleCache, Tables, NumTables);
     }
 
-    ASSERT(StaleParamCount <= DescriptorHandleCache::kMaxNumDescriptorTables,
-        "We're only equipped to handle so many descriptor tables");
+    // This can trigger the creation of a new heap
+    m_OwningContext.SetDescriptorHeap(m_DescriptorType, GetHeapPointer());
+    ASSERT(HasSpace(NeededSize), "Descriptor tables don't fit in an empty heap");
 
-    m_StaleRootParamsBitMap = 0;
+    if (HandleCache.m_PersistentTablesBitMap != 0)
+        CopyPersistentDescriptors();
+
+    HandleCache.m_StaleRootParamsBitMap = 0;
+
+    uint32_t DestOffset = m_NumReservedDescriptors + m_CurrentOffset;
+    DescriptorHandle DestHandleStart = Allocate(NeededSize);
 
     static const uint32_t kMaxDescriptorsPerCopy = 16;
     UINT NumDestDescriptorRanges = 0;
@@ -185,17 +348,35 @@ void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
     D3D12_CPU_DESCRIPTOR_HANDLE pSrcDescriptorRangeStarts[kMaxDescriptorsPerCopy];
     UINT pSrcDescriptorRangeSizes[kMaxDescriptorsPerCopy];
 
-    for (uint32_t i = 0; i < StaleParamCount; ++i)
+    for (uint32_t i = 0; i < NumTables; ++i)
     {
-        RootIndex = RootIndices[i];
-        (CmdList->*SetFunc)(RootIndex, DestHandleStart.GetGpuHandle());
+        const StaleTable& Table = Tables[i];
 
-        DescriptorTableCache& RootDescTable = m_RootDescriptorTable[RootIndex];
+        // Persistent tables and tables already copied to this heap are bound where they are
+        if (Table.HeapOffset != kInvalidHeapOffset)
+        {
+            (CmdList->*SetFunc)(Table.RootIndex, (m_HeapStart + Table.HeapOffset * m_DescriptorSize).GetGpuHandle());
+            ++m_NumTablesReused;
+            continue;
+        }
+
+        (CmdList->*SetFunc)(Table.RootIndex, DestHandleStart.GetGpuHandle());
+
+        DescriptorTableCache& RootDescTable = HandleCache.m_RootDescriptorTable[Table.RootIndex];
+
+        // Remember the copy, so the same handles can be bound again without copying them
+        CachedTable& Cached = m_CachedTables[Table.Hash];
+        Cached.HeapOffset = DestOffset;
+        Cached.HandleStart = (uint32_t)m_CachedTableHandles.size();
+        Cached.TableSize = Table.TableSize;
+        Cached.AssignedHandlesBitMap = RootDescTable.AssignedHandlesBitMap;
+        m_CachedTableHandles.insert(m_CachedTableHandles.end(), RootDescTable.TableStart, RootDescTable.TableStart + Table.TableSize);
 
         D3D12_CPU_DESCRIPTOR_HANDLE* SrcHandles = RootDescTable.TableStart;
         uint64_t SetHandles = (uint64_t)RootDescTable.AssignedHandlesBitMap;
         D3D12_CPU_DESCRIPTOR_HANDLE CurDest = DestHandleStart.GetCpuHandle();
-        DestHandleStart += TableSize[i] * DescriptorSize;
+        DestHandleStart += Table.TableSize * m_DescriptorSize;
+        DestOffset += Table.TableSize;
 
         unsigned long SkipCount;
         while (_BitScanForward64(&SkipCount, SetHandles))
@@ -203,19 +384,20 @@ void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
             // Skip over unset descriptor handles
             SetHandles >>= SkipCount;
             SrcHandles += SkipCount;
-            CurDest.ptr += SkipCount * DescriptorSize;
+            CurDest.ptr += SkipCount * m_DescriptorSize;
 
             unsigned long DescriptorCount;
             _BitScanForward64(&DescriptorCount, ~SetHandles);
             SetHandles >>= DescriptorCount;
 
             // If we run out of temp room, copy what we've got so far
-            if (NumSrcDescriptorRanges + DescriptorCount > kMaxDescriptorsPerCopy)
+            if (NumSrcDescriptorRanges + DescriptorCount > kMaxDescriptorsPerCopy || NumDestDescriptorRanges == kMaxDescriptorsPerCopy)
             {
                 g_Device->CopyDescriptors(
                     NumDestDescriptorRanges, pDestDescriptorRangeStarts, pDestDescriptorRangeSizes,
                     NumSrcDescriptorRanges, pSrcDescriptorRangeStarts, pSrcDescriptorRangeSizes,
-                    Type);
+                    m_DescriptorType);
+                ++m_NumDescriptorCopies;
 
                 NumSrcDescriptorRanges = 0;
                 NumDestDescriptorRanges = 0;
@@ -226,9 +408,19 @@ void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
             pDestDescriptorRangeSizes[NumDestDescriptorRanges] = DescriptorCount;
             ++NumDestDescriptorRanges;
 
-            // Setup source ranges (one descriptor each because we don't assume they are contiguous)
+            // Setup source ranges.  We don't assume the handles are contiguous, but merge the ones that are.
             for (uint32_t j = 0; j < DescriptorCount; ++j)
             {
+                if (NumSrcDescriptorRanges > 0)
+                {
+                    UINT Last = NumSrcDescriptorRanges - 1;
+                    if (SrcHandles[j].ptr == pSrcDescriptorRangeStarts[Last].ptr + pSrcDescriptorRangeSizes[Last] * m_DescriptorSize)
+                    {
+                        ++pSrcDescriptorRangeSizes[Last];
+                        continue;
+                    }
+                }
+
                 pSrcDescriptorRangeStarts[NumSrcDescriptorRanges] = SrcHandles[j];
                 pSrcDescriptorRangeSizes[NumSrcDescriptorRanges] = 1;
                 ++NumSrcDescriptorRanges;
@@ -236,30 +428,20 @@ void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
 
             // Move the destination pointer forward by the number of descriptors we will copy
             SrcHandles += DescriptorCount;
-            CurDest.ptr += DescriptorCount * DescriptorSize;
+            CurDest.ptr += DescriptorCount * m_DescriptorSize;
         }
     }
 
-    g_Device->CopyDescriptors(
-        NumDestDescriptorRanges, pDestDescriptorRangeStarts, pDestDescriptorRangeSizes,
-        NumSrcDescriptorRanges, pSrcDescriptorRangeStarts, pSrcDescriptorRangeSizes,
-        Type);
-}
-    
-void DynamicDescriptorHeap::CopyAndBindStagedTables( DescriptorHandleCache& HandleCache, ID3D12GraphicsCommandList* CmdList,
-    void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE))
-{
-    uint32_t NeededSize = HandleCache.ComputeStagedSize();
-    if (!HasSpace(NeededSize))
+    if (NumDestDescriptorRanges > 0)
     {
-        RetireCurrentHeap();
-        UnbindAllValid();
-        NeededSize = HandleCache.ComputeStagedSize();
+        g_Device->CopyDescriptors(
+            NumDestDescriptorRanges, pDestDescriptorRangeStarts, pDestDescriptorRangeSizes,
+            NumSrcDescriptorRanges, pSrcDescriptorRangeStarts, pSrcDescriptorRangeSizes,
+            m_DescriptorType);
+        ++m_NumDescriptorCopies;
     }
 
-    // This can trigger the creation of a new heap
-    m_OwningContext.SetDescriptorHeap(m_DescriptorType, GetHeapPointer());
-    HandleCache.CopyAndBindStaleTables(m_DescriptorType, m_DescriptorSize, Allocate(NeededSize), CmdList, SetFunc);
+    m_NumDescriptorsWritten += NeededSize;
 }
 
 void DynamicDescriptorHeap::UnbindAllValid( void )
@@ -282,6 +464,8 @@ D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::UploadDirect( D3D12_CPU_DESCR
     m_CurrentOffset += 1;
 
     g_Device->CopyDescriptorsSimple(1, DestHandle.GetCpuHandle(), Handle, m_DescriptorType);
+    m_NumDescriptorsWritten += 1;
+    ++m_NumDescriptorCopies;
 
     return DestHandle.GetGpuHandle();
 }
@@ -295,7 +479,7 @@ void DynamicDescriptorHeap::DescriptorHandleCache::UnbindAllValid()
     while (_BitScanForward(&RootIndex, TableParams))
     {
         TableParams ^= (1 << RootIndex);
-        if (m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap != 0)
+        if (m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap != 0 || (m_PersistentTablesBitMap & (1 << RootIndex)) != 0)
             m_StaleRootParamsBitMap |= (1 << RootIndex);
     }
 }
@@ -310,6 +494,19 @@ void DynamicDescriptorHeap::DescriptorHandleCache::StageDescriptorHandles( UINT
     for (UINT i = 0; i < NumHandles; ++i)
         CopyDest[i] = Handles[i];
     TableCache.AssignedHandlesBitMap |= ((1 << NumHandles) - 1) << Offset;
+    m_PersistentTablesBitMap &= ~(1 << RootIndex);
+    m_StaleRootParamsBitMap |= (1 << RootIndex);
+}
+
+void DynamicDescriptorHeap::DescriptorHandleCache::StagePersistentTable( UINT RootIndex, uint32_t TableOffset )
+{
+    ASSERT(((1 << RootIndex) & m_RootDescriptorTablesBitMap) != 0, "Root parameter is not a CBV_SRV_UAV descriptor table");
+    ASSERT(TableOffset != kInvalidPersistentTable);
+
+    // The persistent table replaces any handles staged for this root parameter
+    m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap = 0;
+    m_PersistentTableOffset[RootIndex] = TableOffset;
+    m_PersistentTablesBitMap |= (1 << RootIndex);
     m_StaleRootParamsBitMap |= (1 << RootIndex);
 }
 
@@ -320,6 +517,7 @@ void DynamicDescriptorHeap::DescriptorHandleCache::ParseRootSignature( D3D12_DES
     ASSERT(RootSig.m_NumParameters <= 16, "Maybe we need to support something greater");
 
     m_StaleRootParamsBitMap = 0;
+    m_PersistentTablesBitMap = 0;
     m_RootDescriptorTablesBitMap = (Type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER ?
         RootSig.m_SamplerTableBitMap : RootSig.m_DescriptorTableBitMap);
 
@@ -17,6 +17,7 @@
 #include "RootSignature.h"
 #include <vector>
 #include <queue>
+#include <unordered_map>
 
 namespace Graphics
 {
@@ -26,6 +27,11 @@ namespace Graphics
 // This class is a linear allocation system for dynamically generated descriptor tables.  It internally caches
 // CPU descriptor handles so that when not enough space is available in the current heap, necessary descriptors
 // can be re-copied to the new heap.
+//
+// Tables already copied to the current heap are remembered by the handles they were staged with, so staging the
+// same handles again binds the earlier copy.  This assumes that staged descriptors are not rewritten while a
+// context is recording.  Tables which never change can instead be copied once to a persistent region at the start
+// of every CBV_SRV_UAV heap.
 class DynamicDescriptorHeap
 {
 public:
@@ -36,10 +42,30 @@ public:
     {
         sm_DescriptorHeapPool[0].clear();
         sm_DescriptorHeapPool[1].clear();
+        sm_PersistentDescriptors = nullptr;
+        sm_PersistentDescriptorsInHeap.clear();
+        sm_NumPersistentDescriptors = 0;
+        sm_MaxPersistentDescriptors = 0;
     }
 
+    // Reserves space for persistent tables at the start of every CBV_SRV_UAV dynamic heap.  The region is off
+    // unless this is called, which must happen while no context is recording, e.g. during application startup.
+    static void ReservePersistentDescriptors( uint32_t Count );
+
+    // Copies a table of descriptors that will never change to the persistent region, and returns its offset
+    // in the region, or kInvalidPersistentTable if the region is full.
+    static const uint32_t kInvalidPersistentTable = 0xFFFFFFFF;
+    static uint32_t CreatePersistentTable( UINT NumHandles, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] );
+
     void CleanupUsedHeaps( uint64_t fenceValue );
 
+    // The number of descriptors written to shader-visible heaps since the last cleanup
+    uint32_t GetNumDescriptorsWritten(void) const { return m_NumDescriptorsWritten; }
+
+    // The number of CopyDescriptors calls, and of tables bound without copying, since the last cleanup
+    uint32_t GetNumDescriptorCopies(void) const { return m_NumDescriptorCopies; }
+    uint32_t GetNumTablesReused(void) const { return m_NumTablesReused; }
+
     // Copy multiple handles into the cache area reserved for the specified root parameter.
     void SetGraphicsDescriptorHandles( UINT RootIndex, UINT Offset, UINT NumHandles, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] )
     {
@@ -51,6 +77,17 @@ public:
         m_ComputeHandleCache.StageDescriptorHandles(RootIndex, Offset, NumHandles, Handles);
     }
 
+    // Bind a table created by CreatePersistentTable to the specified root parameter.
+    void SetGraphicsPersistentTable( UINT RootIndex, uint32_t TableOffset )
+    {
+        m_GraphicsHandleCache.StagePersistentTable(RootIndex, TableOffset);
+    }
+
+    void SetComputePersistentTable( UINT RootIndex, uint32_t TableOffset )
+    {
+        m_ComputeHandleCache.StagePersistentTable(RootIndex, TableOffset);
+    }
+
     // Bypass the cache and upload directly to the shader-visible heap
     D3D12_GPU_DESCRIPTOR_HANDLE UploadDirect( D3D12_CPU_DESCRIPTOR_HANDLE Handles );
 
@@ -84,21 +121,46 @@ private:
     static const uint32_t kNumDescriptorsPerHeap = 1024;
     static std::mutex sm_Mutex;
     static std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> sm_DescriptorHeapPool[2];
-    static std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> sm_RetiredDescriptorHeaps[2];
     static std::queue<ID3D12DescriptorHeap*> sm_AvailableDescriptorHeaps[2];
 
     // Static methods
     static ID3D12DescriptorHeap* RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType);
     static void DiscardDescriptorHeaps( D3D12_DESCRIPTOR_HEAP_TYPE HeapType, uint64_t FenceValueForReset, const std::vector<ID3D12DescriptorHeap*>& UsedHeaps );
 
+    // The persistent tables, in a CPU-only heap that is copied to the start of each dynamic heap.  Guarded by sm_Mutex.
+    static Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> sm_PersistentDescriptors;
+    static std::unordered_map<ID3D12DescriptorHeap*, uint32_t> sm_PersistentDescriptorsInHeap;   // How much of the region each pooled heap holds
+    static uint32_t sm_NumPersistentDescriptors;
+    static uint32_t sm_MaxPersistentDescriptors;
+
     // Non-static members
     CommandContext& m_OwningContext;
     ID3D12DescriptorHeap* m_CurrentHeapPtr;
     const D3D12_DESCRIPTOR_HEAP_TYPE m_DescriptorType;
     uint32_t m_DescriptorSize;
     uint32_t m_CurrentOffset;
+    DescriptorHandle m_HeapStart;
     DescriptorHandle m_FirstDescriptor;
     std::vector<ID3D12DescriptorHeap*> m_RetiredHeaps;
+    uint32_t m_NumDescriptorsWritten;
+    uint32_t m_NumDescriptorCopies;
+    uint32_t m_NumTablesReused;
+
+    // The size of the persistent region in the current heap, and how much of it has been copied
+    uint32_t m_NumReservedDescriptors;
+    uint32_t m_NumPersistentDescriptors;
+
+    // Tables copied to the current heap, by the hash of their staged handles.  The handles of each table are kept
+    // in m_CachedTableHandles to tell apart tables with the same hash.
+    struct CachedTable
+    {
+        uint32_t HeapOffset;
+        uint32_t HandleStart;
+        uint32_t TableSize;
+        uint32_t AssignedHandlesBitMap;
+    };
+    std::unordered_map<size_t, CachedTable> m_CachedTables;
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_CachedTableHandles;
 
     // Describes a descriptor table entry:  a region of the handle cache and which handles have been set
     struct DescriptorTableCache
@@ -119,34 +181,44 @@ private:
         void ClearCache()
         {
             m_RootDescriptorTablesBitMap = 0;
+            m_PersistentTablesBitMap = 0;
             m_MaxCachedDescriptors = 0;
         }
 
         uint32_t m_RootDescriptorTablesBitMap;
+        uint32_t m_PersistentTablesBitMap;
         uint32_t m_StaleRootParamsBitMap;
         uint32_t m_MaxCachedDescriptors;
 
         static const uint32_t kMaxNumDescriptors = 256;
         static const uint32_t kMaxNumDescriptorTables = 16;
 
-        uint32_t ComputeStagedSize();
-        void CopyAndBindStaleTables( D3D12_DESCRIPTOR_HEAP_TYPE Type, uint32_t DescriptorSize, DescriptorHandle DestHandleStart, ID3D12GraphicsCommandList* CmdList,
-            void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE));
-
         DescriptorTableCache m_RootDescriptorTable[kMaxNumDescriptorTables];
+        uint32_t m_PersistentTableOffset[kMaxNumDescriptorTables];
         D3D12_CPU_DESCRIPTOR_HANDLE m_HandleCache[kMaxNumDescriptors];
 
         void UnbindAllValid();
         void StageDescriptorHandles( UINT RootIndex, UINT Offset, UINT NumHandles, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] );
+        void StagePersistentTable( UINT RootIndex, uint32_t TableOffset );
         void ParseRootSignature( D3D12_DESCRIPTOR_HEAP_TYPE Type, const RootSignature& RootSig );
     };
 
+    // A stale table, and where it will be bound from
+    static const uint32_t kInvalidHeapOffset = 0xFFFFFFFF;
+    struct StaleTable
+    {
+        uint32_t RootIndex;
+        uint32_t TableSize;
+        size_t Hash;
+        uint32_t HeapOffset;    // From the start of the current heap, or kInvalidHeapOffset when it must be copied
+    };
+
     DescriptorHandleCache m_GraphicsHandleCache;
     DescriptorHandleCache m_ComputeHandleCache;
 
     bool HasSpace( uint32_t Count )
     {
-        return (m_CurrentHeapPtr != nullptr && m_CurrentOffset + Count <= kNumDescriptorsPerHeap);
+        return (m_CurrentHeapPtr != nullptr && m_CurrentOffset + Count <= kNumDescriptorsPerHeap - m_NumReservedDescriptors);
     }
 
     void RetireCurrentHeap(void);
@@ -160,6 +232,11 @@ private:
         return ret;
     }
 
+    // Finds where each stale table can be bound from, and returns the space needed for the ones to copy.
+    uint32_t GatherStaleTables( const DescriptorHandleCache& HandleCache, StaleTable Tables[], uint32_t& NumTables );
+    bool FindCachedTable( const DescriptorTableCache& Table, uint32_t TableSize, size_t Hash, uint32_t& HeapOffset ) const;
+    void CopyPersistentDescriptors( void );
+
     void CopyAndBindStagedTables( DescriptorHandleCache& HandleCache, ID3D12GraphicsCommandList* CmdList,
         void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) );
 
@@ -43,6 +43,7 @@ public:
             m_RecentHistory[i] = 0.0f;
         for (uint32_t i = 0; i < kExtendedHistorySize; ++i)
             m_ExtendedHistory[i] = 0.0f;
+        m_Recent = 0.0f;
         m_Average = 0.0f;
         m_Minimum = 0.0f;
         m_Maximum = 0.0f;
@@ -303,7 +304,9 @@ public:
         Context->PIXEndEvent();
     }
 
-    void GatherTimes(uint32_t FrameIndex)
+    // GPU times lag the CPU times by a few frames.  They're recorded under the frame they were
+    // measured in, and only when a new frame's times have been read back.
+    void GatherTimes(uint32_t FrameIndex, uint32_t GpuFrameIndex, bool HasGpuTimes)
     {
         if (sm_SelectedScope == this)
         {
@@ -312,14 +315,15 @@ public:
         if (EngineProfiling::Paused)
         {
             for (auto node : m_Children)
-                node->GatherTimes(FrameIndex);
+                node->GatherTimes(FrameIndex, GpuFrameIndex, HasGpuTimes);
             return;
         }
         m_CpuTime.RecordStat(FrameIndex, 1000.0f * (float)SystemTime::TimeBetweenTicks(m_StartTick, m_EndTick));
-        m_GpuTime.RecordStat(FrameIndex, 1000.0f * m_GpuTimer.GetTime());
+        if (HasGpuTimes)
+            m_GpuTime.RecordStat(GpuFrameIndex, 1000.0f * m_GpuTimer.GetTime());
 
         for (auto node : m_Children)
-            node->GatherTimes(FrameIndex);
+            node->GatherTimes(FrameIndex, GpuFrameIndex, HasGpuTimes);
 
         m_StartTick = 0;
         m_EndTick = 0;
@@ -343,19 +347,28 @@ public:
     {
         uint32_t FrameIndex = (uint32_t)Graphics::GetFrameCount();
 
-        GpuTimeManager::BeginReadBack();
-        sm_RootScope.GatherTimes(FrameIndex);
-        s_FrameDelta.RecordStat(FrameIndex, GpuTimeManager::GetTime(0));
+        bool HasGpuTimes = GpuTimeManager::BeginReadBack();
+        uint32_t GpuFrameIndex = (uint32_t)GpuTimeManager::GetReadBackFrameId();
+        sm_RootScope.GatherTimes(FrameIndex, GpuFrameIndex, HasGpuTimes);
+        if (HasGpuTimes)
+            s_FrameDelta.RecordStat(GpuFrameIndex, GpuTimeManager::GetTime(0));
         GpuTimeManager::EndReadBack();
 
         float TotalCpuTime, TotalGpuTime;
         sm_RootScope.SumInclusiveTimes(TotalCpuTime, TotalGpuTime);
         s_TotalCpuTime.RecordStat(FrameIndex, TotalCpuTime);
-        s_TotalGpuTime.RecordStat(FrameIndex, TotalGpuTime);
+        if (HasGpuTimes)
+            s_TotalGpuTime.RecordStat(GpuFrameIndex, TotalGpuTime);
 
         GraphRenderer::Update(XMFLOAT2(TotalCpuTime, TotalGpuTime), 0, GraphType::Global);
     }
 
+    template <typename Visitor>
+    static void VisitScopes( const Visitor& Visit )
+    {
+        sm_RootScope.VisitChildren(Visit, 0);
+    }
+
     static float GetTotalCpuTime(void) { return s_TotalCpuTime.GetAvg(); }
     static float GetTotalGpuTime(void) { return s_TotalGpuTime.GetAvg(); }
     static float GetFrameDelta(void) { return s_FrameDelta.GetAvg(); }
@@ -381,6 +394,16 @@ public:
 private:
 
     void DisplayNode( TextContext& Text, float x, float indent );
+
+    template <typename Visitor>
+    void VisitChildren( const Visitor& Visit, uint32_t Depth )
+    {
+        for (auto node : m_Children)
+        {
+            Visit(node->m_Name, Depth, node->m_CpuTime.GetLast());
+            node->VisitChildren(Visit, Depth + 1);
+        }
+    }
     void StoreToGraph(void);
     void DeleteChildren( void )
     {
@@ -451,6 +474,11 @@ namespace EngineProfiling
         return Paused;
     }
 
+    void VisitScopes( const function<void(const wstring& Name, uint32_t Depth, float CpuTime)>& Visitor )
+    {
+        NestedTimingTree::VisitScopes(Visitor);
+    }
+
     void DisplayFrameRate( TextContext& Text )
     {
         if (!DrawFrameRate)
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include "TextRenderer.h"
 
@@ -29,6 +30,10 @@ namespace EngineProfiling
     void DisplayPerfGraph(GraphicsContext& Text);
     void Display(TextContext& Text, float x, float y, float w, float h);
     bool IsPaused();
+
+    // Visits every timed scope, parents before children, with the CPU time in milliseconds that it
+    // took in the most recently gathered frame
+    void VisitScopes( const std::function<void(const std::wstring& Name, uint32_t Depth, float CpuTime)>& Visitor );
 }
 
 #ifdef RELEASE
@@ -0,0 +1,205 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "FenceService.h"
+#include <condition_variable>
+
+namespace
+{
+    class D3D12Fence : public FenceService::Fence
+    {
+    public:
+        D3D12Fence(ID3D12Fence* pFence) : m_pFence(pFence) {}
+
+        uint64_t GetCompletedValue(void) override
+        {
+            return m_pFence->GetCompletedValue();
+        }
+
+        void SetEventOnCompletion(uint64_t Value, HANDLE Event) override
+        {
+            ASSERT_SUCCEEDED(m_pFence->SetEventOnCompletion(Value, Event));
+        }
+
+    private:
+        ID3D12Fence* m_pFence;
+    };
+}
+
+FenceService::FenceService() :
+    m_pFence(nullptr),
+    m_FenceEvent(nullptr),
+    m_WakeEvent(nullptr),
+    m_NextSequence(0),
+    m_WatchedValue(UINT64_MAX),
+    m_IsStopping(false)
+{
+}
+
+FenceService::~FenceService()
+{
+    Stop();
+}
+
+void FenceService::Start(Fence* pFence)
+{
+    ASSERT(pFence != nullptr);
+    ASSERT(!IsRunning());
+
+    m_pFence = pFence;
+    m_IsStopping = false;
+    m_WatchedValue = UINT64_MAX;
+
+    m_FenceEvent = CreateEvent(nullptr, false, false, nullptr);
+    ASSERT(m_FenceEvent != NULL);
+    m_WakeEvent = CreateEvent(nullptr, false, false, nullptr);
+    ASSERT(m_WakeEvent != NULL);
+
+    m_Watcher = std::thread(&FenceService::WatchFence, this);
+}
+
+void FenceService::Start(ID3D12Fence* pFence)
+{
+    m_OwnedFence.reset(new D3D12Fence(pFence));
+    Start(m_OwnedFence.get());
+}
+
+void FenceService::Stop(void)
+{
+    if (!IsRunning())
+        return;
+
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        m_IsStopping = true;
+    }
+    SetEvent(m_WakeEvent);
+    m_Watcher.join();
+
+    // Let the fence catch up with what is still pending rather than dropping it, so a thread blocked
+    // in Wait() returns and pooled resources are recycled.  Callbacks run here may register more.
+    for (;;)
+    {
+        RunCompletedCallbacks();
+
+        uint64_t NextValue;
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            if (m_PendingValues.empty())
+            {
+                m_pFence = nullptr;
+                break;
+            }
+            NextValue = m_PendingValues.top().Value;
+        }
+
+        m_pFence->SetEventOnCompletion(NextValue, m_FenceEvent);
+        WaitForSingleObject(m_FenceEvent, INFINITE);
+    }
+
+    CloseHandle(m_FenceEvent);
+    CloseHandle(m_WakeEvent);
+    m_FenceEvent = nullptr;
+    m_WakeEvent = nullptr;
+
+    m_OwnedFence.reset();
+}
+
+void FenceService::Wait(uint64_t FenceValue)
+{
+    ASSERT(IsRunning());
+    ASSERT(std::this_thread::get_id() != m_Watcher.get_id(), "Waiting on the watcher thread would never return");
+
+    if (FenceValue <= m_pFence->GetCompletedValue())
+        return;
+
+    std::mutex WaitMutex;
+    std::condition_variable Completed;
+    bool IsComplete = false;
+
+    // Notify under the lock, so the condition variable is still alive when the callback uses it.
+    OnCompletion(FenceValue, [&]
+    {
+        std::lock_guard<std::mutex> LockGuard(WaitMutex);
+        IsComplete = true;
+        Completed.notify_one();
+    });
+
+    std::unique_lock<std::mutex> Lock(WaitMutex);
+    Completed.wait(Lock, [&] { return IsComplete; });
+}
+
+void FenceService::OnCompletion(uint64_t FenceValue, std::function<void()> Callback)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    // Checked under the lock, because Stop() only stops draining once it holds it with nothing pending.
+    ASSERT(IsRunning(), "Callbacks registered after Stop() would never run");
+
+    PendingValue Pending = { FenceValue, m_NextSequence++, std::move(Callback) };
+    m_PendingValues.push(std::move(Pending));
+
+    // The watcher is armed for a later value, or for none at all, so get it to re-arm.
+    if (FenceValue < m_WatchedValue)
+        SetEvent(m_WakeEvent);
+}
+
+void FenceService::WatchFence(void)
+{
+    for (;;)
+    {
+        uint64_t WatchedValue;
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            if (m_IsStopping)
+                return;
+
+            WatchedValue = m_PendingValues.empty() ? UINT64_MAX : m_PendingValues.top().Value;
+            m_WatchedValue = WatchedValue;
+        }
+
+        // A value registered after this point signals the wake event, which stays set until waited on.
+        if (WatchedValue == UINT64_MAX)
+        {
+            WaitForSingleObject(m_WakeEvent, INFINITE);
+        }
+        else
+        {
+            // Arming the event for a value that already completed sets it immediately.  An event armed
+            // earlier for a later value may still fire, which only costs a spurious pass.
+            m_pFence->SetEventOnCompletion(WatchedValue, m_FenceEvent);
+            HANDLE Events[] = { m_FenceEvent, m_WakeEvent };
+            WaitForMultipleObjects(_countof(Events), Events, FALSE, INFINITE);
+        }
+
+        RunCompletedCallbacks();
+    }
+}
+
+void FenceService::RunCompletedCallbacks(void)
+{
+    uint64_t CompletedValue = m_pFence->GetCompletedValue();
+
+    std::vector<std::function<void()>> Callbacks;
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        while (!m_PendingValues.empty() && m_PendingValues.top().Value <= CompletedValue)
+        {
+            Callbacks.push_back(m_PendingValues.top().Callback);
+            m_PendingValues.pop();
+        }
+    }
+
+    // Run without the lock, so callbacks can register further callbacks.
+    for (auto& Callback : Callbacks)
+        Callback();
+}
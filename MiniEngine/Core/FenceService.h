@@ -0,0 +1,88 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+// Watches one fence from a thread of its own.  Pending fence values are kept in a min-heap and the
+// fence event is always armed for the smallest one, so each waiter is woken as soon as its own value
+// completes rather than when some other thread's value does, and completion callbacks run in fence
+// order.  Pools use the callbacks to recycle their resources the moment the GPU is done with them.
+class FenceService
+{
+public:
+    // What the service needs from a fence.  Anything that can signal an event when it reaches a
+    // value will do, so a simulated fence can stand in for an ID3D12Fence.
+    class Fence
+    {
+    public:
+        virtual ~Fence() {}
+        virtual uint64_t GetCompletedValue(void) = 0;
+        virtual void SetEventOnCompletion(uint64_t Value, HANDLE Event) = 0;
+    };
+
+    FenceService();
+    ~FenceService();
+
+    // The service does not take ownership of the fence.
+    void Start(Fence* pFence);
+    void Start(ID3D12Fence* pFence);
+
+    // Waits for the fence to reach every pending value and runs its callbacks, so no waiter is left
+    // blocked.  Nothing may be registered once it returns.
+    void Stop(void);
+
+    bool IsRunning(void) const { return m_pFence != nullptr; }
+
+    // Blocks the calling thread until the fence reaches FenceValue.  Must not be called from a callback.
+    void Wait(uint64_t FenceValue);
+
+    // Runs Callback on the watcher thread once the fence reaches FenceValue, even if it already has.
+    // Callbacks for the same value run in the order they were registered, and may register new ones.
+    void OnCompletion(uint64_t FenceValue, std::function<void()> Callback);
+
+private:
+    struct PendingValue
+    {
+        uint64_t Value;
+        uint64_t Sequence;
+        std::function<void()> Callback;
+    };
+
+    struct IsLater
+    {
+        bool operator()(const PendingValue& a, const PendingValue& b) const
+        {
+            return a.Value > b.Value || (a.Value == b.Value && a.Sequence > b.Sequence);
+        }
+    };
+
+    void WatchFence(void);
+    void RunCompletedCallbacks(void);
+
+    Fence* m_pFence;
+    std::unique_ptr<Fence> m_OwnedFence;
+    std::thread m_Watcher;
+    HANDLE m_FenceEvent;
+    HANDLE m_WakeEvent;
+
+    std::mutex m_Mutex;
+    std::priority_queue<PendingValue, std::vector<PendingValue>, IsLater> m_PendingValues;
+    uint64_t m_NextSequence;
+    uint64_t m_WatchedValue;
+    bool m_IsStopping;
+};
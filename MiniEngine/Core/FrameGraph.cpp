@@ -0,0 +1,483 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "FrameGraph.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "ColorBuffer.h"
+#include "GpuBuffer.h"
+#include <algorithm>
+
+using namespace Graphics;
+
+namespace
+{
+    const D3D12_RESOURCE_STATES kWriteStates =
+        D3D12_RESOURCE_STATE_RENDER_TARGET | D3D12_RESOURCE_STATE_UNORDERED_ACCESS | D3D12_RESOURCE_STATE_DEPTH_WRITE |
+        D3D12_RESOURCE_STATE_STREAM_OUT | D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_RESOLVE_DEST;
+}
+
+FrameGraph::FrameGraph() : m_IsCompiled(false)
+{
+    ZeroMemory(&m_Statistics, sizeof(m_Statistics));
+    ZeroMemory(m_HeapSizes, sizeof(m_HeapSizes));
+}
+
+void FrameGraph::Destroy( void )
+{
+    for (auto& Res : m_Resources)
+    {
+        if (Res.Texture != nullptr)
+            Res.Texture->Destroy();
+        if (Res.Buffer != nullptr)
+            Res.Buffer->Destroy();
+    }
+
+    m_Passes.clear();
+    m_Resources.clear();
+    ZeroMemory(&m_Statistics, sizeof(m_Statistics));
+    m_IsCompiled = false;
+
+    for (uint32_t i = 0; i < kNumHeapClasses; ++i)
+    {
+        m_Heaps[i] = nullptr;
+        m_HeapSizes[i] = 0;
+    }
+}
+
+FrameGraph::ResourceHandle FrameGraph::AddResource( const std::wstring& Name, GpuResource* Object, bool IsTransient,
+    HeapClass Class, uint64_t SizeInBytes, uint64_t Alignment )
+{
+    ASSERT(!IsTransient || (SizeInBytes > 0 && Math::IsPowerOfTwo(Alignment)));
+
+    Resource Res = {};
+    Res.Name = Name;
+    Res.Object = Object;
+    Res.IsTransient = IsTransient;
+    Res.Class = Class;
+    Res.SizeInBytes = SizeInBytes;
+    Res.Alignment = Alignment;
+    Res.FirstPass = kInvalidHandle;
+    Res.LastPass = kInvalidHandle;
+
+    m_Resources.push_back(Res);
+    m_IsCompiled = false;
+    return (ResourceHandle)m_Resources.size() - 1;
+}
+
+FrameGraph::ResourceHandle FrameGraph::ImportResource( const std::wstring& Name, GpuResource* Object )
+{
+    return AddResource(Name, Object, false, kTextureHeap, 0, 1);
+}
+
+FrameGraph::ResourceHandle FrameGraph::CreateTransient( const std::wstring& Name, HeapClass Class, uint64_t SizeInBytes, uint64_t Alignment )
+{
+    return AddResource(Name, nullptr, true, Class, SizeInBytes, Alignment);
+}
+
+FrameGraph::ResourceHandle FrameGraph::CreateTransientTexture( const std::wstring& Name, ColorBuffer* Buffer,
+    uint32_t Width, uint32_t Height, DXGI_FORMAT Format, uint32_t ArrayCount )
+{
+    ColorBuffer Temp;
+    D3D12_RESOURCE_ALLOCATION_INFO Info = (Buffer != nullptr ? Buffer : &Temp)->GetPlacedAllocationInfo(Width, Height, ArrayCount, Format);
+
+    ResourceHandle Handle = AddResource(Name, Buffer, true, kTextureHeap, Info.SizeInBytes, Info.Alignment);
+    Resource& Res = m_Resources[Handle];
+    Res.Texture = Buffer;
+    Res.Width = Width;
+    Res.Height = Height;
+    Res.ArrayCount = ArrayCount;
+    Res.Format = Format;
+    return Handle;
+}
+
+FrameGraph::ResourceHandle FrameGraph::CreateTransientBuffer( const std::wstring& Name, GpuBuffer* Buffer,
+    uint32_t NumElements, uint32_t ElementSize )
+{
+    // Buffers are always placed at 64KB boundaries
+    const uint64_t Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+    ResourceHandle Handle = AddResource(Name, Buffer, true, kBufferHeap,
+        Math::AlignUp((uint64_t)NumElements * ElementSize, Alignment), Alignment);
+    Resource& Res = m_Resources[Handle];
+    Res.Buffer = Buffer;
+    Res.NumElements = NumElements;
+    Res.ElementSize = ElementSize;
+    return Handle;
+}
+
+FrameGraph::PassHandle FrameGraph::AddPass( const std::wstring& Name, PassFunc Execute )
+{
+    Pass NewPass;
+    NewPass.Name = Name;
+    NewPass.Execute = Execute;
+    m_Passes.push_back(NewPass);
+    m_IsCompiled = false;
+    return (PassHandle)m_Passes.size() - 1;
+}
+
+void FrameGraph::AddAccess( PassHandle PassIndex, ResourceHandle Res, D3D12_RESOURCE_STATES State, bool IsWrite )
+{
+    ASSERT(PassIndex < m_Passes.size() && Res < m_Resources.size());
+
+    Pass& P = m_Passes[PassIndex];
+    for (auto& Acc : P.Accesses)
+        ASSERT(Acc.Resource != Res, "A pass can only use a resource in one state");
+
+    Access NewAccess = { Res, State, IsWrite };
+    P.Accesses.push_back(NewAccess);
+    m_IsCompiled = false;
+}
+
+void FrameGraph::Read( PassHandle Pass, ResourceHandle Resource, D3D12_RESOURCE_STATES State )
+{
+    ASSERT((State & kWriteStates) == 0, "Resources are read in read-only states");
+    AddAccess(Pass, Resource, State, false);
+}
+
+void FrameGraph::Write( PassHandle Pass, ResourceHandle Resource, D3D12_RESOURCE_STATES State )
+{
+    AddAccess(Pass, Resource, State, true);
+}
+
+void FrameGraph::PlaceTransientResources( void )
+{
+    // Place the largest resources first, each at the lowest offset that doesn't overlap the memory of a placed
+    // resource that is alive at the same time.
+    std::vector<ResourceHandle> Order;
+    for (ResourceHandle i = 0; i < m_Resources.size(); ++i)
+    {
+        if (m_Resources[i].IsTransient && m_Resources[i].FirstPass != kInvalidHandle)
+            Order.push_back(i);
+    }
+
+    std::stable_sort(Order.begin(), Order.end(), [this](ResourceHandle A, ResourceHandle B)
+    {
+        return m_Resources[A].SizeInBytes > m_Resources[B].SizeInBytes;
+    });
+
+    std::vector<ResourceHandle> Placed;
+    std::vector<ResourceHandle> Overlapping;
+
+    for (ResourceHandle Handle : Order)
+    {
+        Resource& Res = m_Resources[Handle];
+
+        Overlapping.clear();
+        for (ResourceHandle Other : Placed)
+        {
+            const Resource& O = m_Resources[Other];
+            if (O.Class == Res.Class && O.FirstPass <= Res.LastPass && Res.FirstPass <= O.LastPass)
+                Overlapping.push_back(Other);
+        }
+
+        std::sort(Overlapping.begin(), Overlapping.end(), [this](ResourceHandle A, ResourceHandle B)
+        {
+            return m_Resources[A].HeapOffset < m_Resources[B].HeapOffset;
+        });
+
+        uint64_t Offset = 0;
+        for (ResourceHandle Other : Overlapping)
+        {
+            const Resource& O = m_Resources[Other];
+            if (Offset + Res.SizeInBytes <= O.HeapOffset)
+                break;
+            Offset = std::max(Offset, Math::AlignUp(O.HeapOffset + O.SizeInBytes, (size_t)Res.Alignment));
+        }
+
+        Res.HeapOffset = Offset;
+        Placed.push_back(Handle);
+
+        m_Statistics.SeparateBytes += Res.SizeInBytes;
+        m_Statistics.HeapBytes[Res.Class] = std::max(m_Statistics.HeapBytes[Res.Class], Offset + Res.SizeInBytes);
+        ++m_Statistics.NumTransientResources;
+    }
+
+    for (uint32_t i = 0; i < kNumHeapClasses; ++i)
+        m_Statistics.AliasedBytes += m_Statistics.HeapBytes[i];
+}
+
+bool FrameGraph::FindAliasedResource( ResourceHandle Handle, ResourceHandle& Aliased ) const
+{
+    // Lifetimes of resources that share memory never overlap, so the memory was last used by the resources that
+    // end before this one starts.  The first resource in the memory takes it over from the resources used after it
+    // in the previous frame.  When several resources used parts of the memory, any of them may be the last, so none
+    // is named.
+    const Resource& Res = m_Resources[Handle];
+    ResourceHandle Previous = kInvalidHandle;
+    ResourceHandle Next = kInvalidHandle;
+    uint32_t NumPrevious = 0;
+    uint32_t NumNext = 0;
+
+    for (ResourceHandle i = 0; i < m_Resources.size(); ++i)
+    {
+        const Resource& O = m_Resources[i];
+        if (i == Handle || !O.IsTransient || O.FirstPass == kInvalidHandle || O.Class != Res.Class)
+            continue;
+
+        if (O.HeapOffset >= Res.HeapOffset + Res.SizeInBytes || Res.HeapOffset >= O.HeapOffset + O.SizeInBytes)
+            continue;
+
+        if (O.LastPass < Res.FirstPass)
+        {
+            Previous = i;
+            ++NumPrevious;
+        }
+        else
+        {
+            Next = i;
+            ++NumNext;
+        }
+    }
+
+    if (NumPrevious > 0)
+        Aliased = NumPrevious == 1 ? Previous : kInvalidHandle;
+    else
+        Aliased = NumNext == 1 ? Next : kInvalidHandle;
+
+    return NumPrevious + NumNext > 0;
+}
+
+void FrameGraph::AddBarrier( std::vector<Barrier>& Barriers, Barrier::BarrierType Type, ResourceHandle Resource,
+    D3D12_RESOURCE_STATES StateBefore, D3D12_RESOURCE_STATES StateAfter, ResourceHandle AliasedResource )
+{
+    Barrier NewBarrier = { Type, Resource, AliasedResource, StateBefore, StateAfter };
+    Barriers.push_back(NewBarrier);
+
+    if (Type == Barrier::kDiscard)
+        return;
+
+    ++m_Statistics.NumBarriers;
+    if (Type == Barrier::kBeginTransition)
+        ++m_Statistics.NumSplitBarriers;
+    else if (Type == Barrier::kAliasing)
+        ++m_Statistics.NumAliasingBarriers;
+}
+
+void FrameGraph::Compile( void )
+{
+    ZeroMemory(&m_Statistics, sizeof(m_Statistics));
+
+    // Uses of each resource, in pass order
+    struct Use
+    {
+        PassHandle Pass;
+        D3D12_RESOURCE_STATES State;
+        bool IsWrite;
+    };
+    std::vector<std::vector<Use>> Uses(m_Resources.size());
+
+    for (auto& Res : m_Resources)
+    {
+        Res.FirstPass = kInvalidHandle;
+        Res.LastPass = kInvalidHandle;
+        Res.HeapOffset = 0;
+    }
+
+    for (PassHandle PassIndex = 0; PassIndex < m_Passes.size(); ++PassIndex)
+    {
+        m_Passes[PassIndex].Barriers.clear();
+
+        for (auto& Acc : m_Passes[PassIndex].Accesses)
+        {
+            Resource& Res = m_Resources[Acc.Resource];
+            ASSERT(Res.FirstPass != kInvalidHandle || !Res.IsTransient || Acc.IsWrite,
+                "Transient resources must be written before they are read");
+
+            if (Res.FirstPass == kInvalidHandle)
+                Res.FirstPass = PassIndex;
+            Res.LastPass = PassIndex;
+
+            Use NewUse = { PassIndex, Acc.State, Acc.IsWrite };
+            Uses[Acc.Resource].push_back(NewUse);
+        }
+    }
+
+    PlaceTransientResources();
+
+    // Barriers that initialize transient resources go first, so that the discards they need don't split the
+    // batch of the other barriers of the pass.
+    std::vector<std::vector<Barrier>> InitBarriers(m_Passes.size());
+
+    for (ResourceHandle Handle = 0; Handle < m_Resources.size(); ++Handle)
+    {
+        const Resource& Res = m_Resources[Handle];
+        const std::vector<Use>& ResUses = Uses[Handle];
+
+        D3D12_RESOURCE_STATES State = kUnknownState;
+        bool LastUseWrites = false;
+
+        size_t i = 0;
+        while (i < ResUses.size())
+        {
+            PassHandle PassIndex = ResUses[i].Pass;
+            D3D12_RESOURCE_STATES NewState = ResUses[i].State;
+
+            // Passes reading one after another share a combined read state, so there are no barriers between them
+            size_t RunEnd = i + 1;
+            if (!ResUses[i].IsWrite)
+            {
+                while (RunEnd < ResUses.size() && !ResUses[RunEnd].IsWrite)
+                    NewState |= ResUses[RunEnd++].State;
+            }
+
+            std::vector<Barrier>& Barriers = m_Passes[PassIndex].Barriers;
+
+            if (i == 0 && Res.IsTransient)
+            {
+                // The memory was used by another resource, so the transient resource takes it over and its
+                // contents start out undefined.  Render targets must be discarded before anything else.
+                ResourceHandle Aliased;
+                if (FindAliasedResource(Handle, Aliased))
+                    AddBarrier(InitBarriers[PassIndex], Barrier::kAliasing, Handle, kUnknownState, kUnknownState, Aliased);
+
+                if (Res.Class == kTextureHeap)
+                {
+                    AddBarrier(InitBarriers[PassIndex], Barrier::kTransition, Handle, kUnknownState, D3D12_RESOURCE_STATE_RENDER_TARGET);
+                    AddBarrier(InitBarriers[PassIndex], Barrier::kDiscard, Handle, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET);
+                    State = D3D12_RESOURCE_STATE_RENDER_TARGET;
+                }
+            }
+
+            if (State != NewState)
+            {
+                // Split the transition when the resource is idle for at least one pass
+                PassHandle PreviousPass = i > 0 ? ResUses[i - 1].Pass : kInvalidHandle;
+                if (PreviousPass != kInvalidHandle && PassIndex > PreviousPass + 1)
+                {
+                    AddBarrier(m_Passes[PreviousPass + 1].Barriers, Barrier::kBeginTransition, Handle, State, NewState);
+                    AddBarrier(Barriers, Barrier::kEndTransition, Handle, State, NewState);
+                }
+                else
+                {
+                    AddBarrier(Barriers, Barrier::kTransition, Handle, State, NewState);
+                }
+            }
+            else if (NewState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS && LastUseWrites)
+            {
+                AddBarrier(Barriers, Barrier::kUAV, Handle, NewState, NewState);
+            }
+
+            State = NewState;
+            LastUseWrites = ResUses[RunEnd - 1].IsWrite;
+            i = RunEnd;
+        }
+    }
+
+    for (PassHandle PassIndex = 0; PassIndex < m_Passes.size(); ++PassIndex)
+    {
+        std::vector<Barrier>& Barriers = m_Passes[PassIndex].Barriers;
+        Barriers.insert(Barriers.begin(), InitBarriers[PassIndex].begin(), InitBarriers[PassIndex].end());
+    }
+
+    m_IsCompiled = true;
+}
+
+void FrameGraph::Allocate( void )
+{
+    ASSERT(m_IsCompiled, "The frame graph must be compiled before it is allocated");
+
+    static const D3D12_HEAP_FLAGS kHeapFlags[kNumHeapClasses] =
+    {
+        D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS
+    };
+
+    for (uint32_t i = 0; i < kNumHeapClasses; ++i)
+    {
+        uint64_t HeapSize = m_Statistics.HeapBytes[i];
+        if (HeapSize == 0 || HeapSize <= m_HeapSizes[i])
+            continue;
+
+        // Resources placed in the old heap are recreated below
+        for (auto& Res : m_Resources)
+        {
+            if (Res.IsTransient && Res.Class == i && Res.Object != nullptr)
+                Res.Object->Destroy();
+        }
+
+        D3D12_HEAP_DESC HeapDesc = {};
+        HeapDesc.SizeInBytes = HeapSize;
+        HeapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+        HeapDesc.Properties.CreationNodeMask = 1;
+        HeapDesc.Properties.VisibleNodeMask = 1;
+        HeapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        HeapDesc.Flags = kHeapFlags[i];
+
+        m_Heaps[i] = nullptr;
+        ASSERT_SUCCEEDED(g_Device->CreateHeap(&HeapDesc, MY_IID_PPV_ARGS(&m_Heaps[i])));
+        m_HeapSizes[i] = HeapSize;
+
+#ifndef RELEASE
+        m_Heaps[i]->SetName(i == kTextureHeap ? L"Frame Graph Texture Heap" : L"Frame Graph Buffer Heap");
+#endif
+    }
+
+    for (auto& Res : m_Resources)
+    {
+        if (!Res.IsTransient || Res.FirstPass == kInvalidHandle)
+            continue;
+
+        ASSERT(Res.Texture != nullptr || Res.Buffer != nullptr, "Transient resource has nothing to create");
+
+        if (Res.Texture != nullptr)
+            Res.Texture->CreatePlaced(Res.Name, m_Heaps[kTextureHeap].Get(), Res.HeapOffset, Res.Width, Res.Height, Res.ArrayCount, Res.Format);
+        else
+            Res.Buffer->CreatePlaced(Res.Name, m_Heaps[kBufferHeap].Get(), (uint32_t)Res.HeapOffset, Res.NumElements, Res.ElementSize);
+    }
+}
+
+void FrameGraph::Execute( CommandContext& Context )
+{
+    ASSERT(m_IsCompiled, "The frame graph must be compiled before it is executed");
+
+    for (auto& P : m_Passes)
+    {
+        ScopedTimer _prof(P.Name, Context);
+
+        for (auto& B : P.Barriers)
+        {
+            GpuResource* Object = m_Resources[B.Resource].Object;
+            ASSERT(Object != nullptr, "Resource has not been created");
+
+            switch (B.Type)
+            {
+            case Barrier::kTransition:
+            case Barrier::kEndTransition:
+                // Completes a transition begun by an earlier pass
+                Context.TransitionResource(*Object, B.StateAfter);
+                break;
+            case Barrier::kBeginTransition:
+                Context.BeginResourceTransition(*Object, B.StateAfter);
+                break;
+            case Barrier::kUAV:
+                Context.InsertUAVBarrier(*Object);
+                break;
+            case Barrier::kAliasing:
+                if (B.AliasedResource != kInvalidHandle)
+                    Context.InsertAliasBarrier(*m_Resources[B.AliasedResource].Object, *Object);
+                else
+                    Context.InsertAliasBarrier(*Object);
+                break;
+            case Barrier::kDiscard:
+                Context.FlushResourceBarriers();
+                Context.GetCommandList()->DiscardResource(Object->GetResource(), nullptr);
+                break;
+            }
+        }
+
+        Context.FlushResourceBarriers();
+
+        if (P.Execute)
+            P.Execute(Context);
+    }
+}
@@ -0,0 +1,179 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+
+class GpuResource;
+class GpuBuffer;
+class ColorBuffer;
+class CommandContext;
+
+// A frame graph records the passes of a frame along with the resources each pass reads and writes, and works
+// out everything the passes would otherwise place by hand:
+//
+//   - Transient resources only live from the first to the last pass that uses them, so resources whose
+//     lifetimes don't overlap are placed at the same offsets of shared heaps.
+//   - Each pass gets one batch of barriers.  Consecutive passes that read a resource in different states
+//     share one combined read state, and a transition is split across the passes in between when a resource
+//     is idle for a while.  Aliasing barriers and discards are inserted where a transient resource takes over
+//     memory used by another.
+//
+// Compile() only runs on the CPU.  Graphs whose transient resources are described by CreateTransient() or
+// CreateTransientBuffer() can be built and compiled without a device, but CreateTransientTexture() asks the device
+// for the size and alignment of the texture.  Allocate() creates the heaps and places the transient resources in
+// them, and Execute() records the passes with their barriers.  A graph is meant to be built and allocated once,
+// then executed every frame.  Rebuild it when the resolution changes.
+//
+// Passes run on one context of a direct command list in the order they were added.  A transient resource must be
+// written before it is read, and a pass can only use a resource in one state.
+class FrameGraph
+{
+public:
+    typedef uint32_t ResourceHandle;
+    typedef uint32_t PassHandle;
+    typedef std::function<void(CommandContext&)> PassFunc;
+
+    static const uint32_t kInvalidHandle = 0xFFFFFFFF;
+
+    // The state of an imported resource before its first use is only known when the graph is executed
+    static const D3D12_RESOURCE_STATES kUnknownState = (D3D12_RESOURCE_STATES)-1;
+
+    // Textures and buffers are placed in separate heaps, so that heap tier 1 devices are supported
+    enum HeapClass { kTextureHeap, kBufferHeap, kNumHeapClasses };
+
+    struct Barrier
+    {
+        enum BarrierType { kTransition, kBeginTransition, kEndTransition, kUAV, kAliasing, kDiscard };
+
+        BarrierType Type;
+        ResourceHandle Resource;
+        ResourceHandle AliasedResource;     // The last resource to use the memory, for aliasing barriers.  Invalid
+                                            // when several resources used parts of it.
+        D3D12_RESOURCE_STATES StateBefore;
+        D3D12_RESOURCE_STATES StateAfter;
+    };
+
+    struct Statistics
+    {
+        uint64_t SeparateBytes;     // Memory of the transient resources when each has its own allocation
+        uint64_t AliasedBytes;      // Memory of the heaps the transient resources share
+        uint64_t HeapBytes[kNumHeapClasses];
+        uint32_t NumTransientResources;
+        uint32_t NumBarriers;
+        uint32_t NumSplitBarriers;
+        uint32_t NumAliasingBarriers;
+    };
+
+    FrameGraph();
+    ~FrameGraph() { Destroy(); }
+
+    // Removes every pass and resource, and releases the heaps and the placed resources.  The GPU must be
+    // done with the previous frames.
+    void Destroy( void );
+
+    // Resources that outlive the frame, or are used outside of the graph, are imported.  They keep their own
+    // memory.  Resource may be null for graphs that are only compiled.
+    ResourceHandle ImportResource( const std::wstring& Name, GpuResource* Resource );
+
+    // Describes a transient resource by the memory it needs, without anything to create.  Graphs with such
+    // resources can be compiled but not allocated.
+    ResourceHandle CreateTransient( const std::wstring& Name, HeapClass Class, uint64_t SizeInBytes, uint64_t Alignment );
+
+    // Transient resources that are created in the heaps by Allocate().  Buffer may be null, in which case the
+    // memory is described with a temporary buffer, and the graph can only be compiled.  Textures are sized by the
+    // device, so it must have been created.
+    ResourceHandle CreateTransientTexture( const std::wstring& Name, ColorBuffer* Buffer, uint32_t Width, uint32_t Height,
+        DXGI_FORMAT Format, uint32_t ArrayCount = 1 );
+    ResourceHandle CreateTransientBuffer( const std::wstring& Name, GpuBuffer* Buffer, uint32_t NumElements, uint32_t ElementSize );
+
+    PassHandle AddPass( const std::wstring& Name, PassFunc Execute = nullptr );
+    void Read( PassHandle Pass, ResourceHandle Resource, D3D12_RESOURCE_STATES State );
+    void Write( PassHandle Pass, ResourceHandle Resource, D3D12_RESOURCE_STATES State );
+
+    // Computes lifetimes, heap offsets and barriers.  Doesn't touch the device.
+    void Compile( void );
+
+    // Creates the heaps and the placed transient resources.  Heaps are kept when they are already large enough.
+    void Allocate( void );
+
+    void Execute( CommandContext& Context );
+
+    const Statistics& GetStatistics( void ) const { return m_Statistics; }
+    uint32_t GetNumPasses( void ) const { return (uint32_t)m_Passes.size(); }
+    const std::vector<Barrier>& GetBarriers( PassHandle Pass ) const { return m_Passes[Pass].Barriers; }
+
+    // Offset of a transient resource in the heap of its class
+    uint64_t GetHeapOffset( ResourceHandle Resource ) const { return m_Resources[Resource].HeapOffset; }
+
+    // The first and last passes that use a resource, or kInvalidHandle when no pass does
+    PassHandle GetFirstPass( ResourceHandle Resource ) const { return m_Resources[Resource].FirstPass; }
+    PassHandle GetLastPass( ResourceHandle Resource ) const { return m_Resources[Resource].LastPass; }
+
+private:
+
+    struct Access
+    {
+        ResourceHandle Resource;
+        D3D12_RESOURCE_STATES State;
+        bool IsWrite;
+    };
+
+    struct Pass
+    {
+        std::wstring Name;
+        PassFunc Execute;
+        std::vector<Access> Accesses;
+        std::vector<Barrier> Barriers;
+    };
+
+    struct Resource
+    {
+        std::wstring Name;
+        GpuResource* Object;
+        bool IsTransient;
+        HeapClass Class;
+        uint64_t SizeInBytes;
+        uint64_t Alignment;
+        uint64_t HeapOffset;
+        PassHandle FirstPass;
+        PassHandle LastPass;
+
+        // What Allocate() creates
+        ColorBuffer* Texture;
+        GpuBuffer* Buffer;
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t ArrayCount;
+        DXGI_FORMAT Format;
+        uint32_t NumElements;
+        uint32_t ElementSize;
+    };
+
+    ResourceHandle AddResource( const std::wstring& Name, GpuResource* Object, bool IsTransient, HeapClass Class,
+        uint64_t SizeInBytes, uint64_t Alignment );
+    void AddAccess( PassHandle Pass, ResourceHandle Resource, D3D12_RESOURCE_STATES State, bool IsWrite );
+    void PlaceTransientResources( void );
+    bool FindAliasedResource( ResourceHandle Resource, ResourceHandle& Aliased ) const;
+    void AddBarrier( std::vector<Barrier>& Barriers, Barrier::BarrierType Type, ResourceHandle Resource,
+        D3D12_RESOURCE_STATES StateBefore, D3D12_RESOURCE_STATES StateAfter, ResourceHandle AliasedResource = kInvalidHandle );
+
+    std::vector<Pass> m_Passes;
+    std::vector<Resource> m_Resources;
+    Statistics m_Statistics;
+    bool m_IsCompiled;
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> m_Heaps[kNumHeapClasses];
+    uint64_t m_HeapSizes[kNumHeapClasses];
+};
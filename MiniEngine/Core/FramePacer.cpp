@@ -0,0 +1,104 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "FramePacer.h"
+#include <algorithm>
+
+FramePacer::FramePacer()
+    : m_Policy(kMaxThroughput)
+    , m_MaxQueuedFrames(2)
+    , m_NextFrameIndex(0)
+    , m_IsFrameOpen(false)
+{
+    ZeroMemory(&m_CurrentFrame, sizeof(m_CurrentFrame));
+    ZeroMemory(&m_LastCompletedFrame, sizeof(m_LastCompletedFrame));
+    m_LastCompletedFrame.FrameIndex = ~0ull;
+    ResetStatistics();
+}
+
+void FramePacer::SetPolicy( Policy NewPolicy, uint32_t MaxQueuedFrames )
+{
+    ASSERT(NewPolicy < kNumPolicies);
+    ASSERT(MaxQueuedFrames > 0, "At least the frame being recorded must be allowed");
+
+    m_Policy = NewPolicy;
+    m_MaxQueuedFrames = MaxQueuedFrames;
+}
+
+void FramePacer::BeginFrame( int64_t Tick, int64_t WaitTicks )
+{
+    ASSERT(!m_IsFrameOpen, "The previous frame has not ended");
+
+    m_CurrentFrame.FrameIndex = m_NextFrameIndex++;
+    m_CurrentFrame.FenceValue = 0;
+    m_CurrentFrame.StartTick = Tick;
+    m_CurrentFrame.SubmitTick = 0;
+    m_CurrentFrame.CompleteTick = 0;
+    m_CurrentFrame.WaitTicks = WaitTicks;
+    m_CurrentFrame.QueueDepth = 0;
+    m_IsFrameOpen = true;
+}
+
+void FramePacer::EndFrame( int64_t Tick, uint64_t FenceValue )
+{
+    // The first frame starts before anyone could tell the pacer
+    if (!m_IsFrameOpen)
+        BeginFrame(Tick, 0);
+
+    ASSERT(m_PendingFrames.empty() || FenceValue > m_PendingFrames.back().FenceValue,
+        "Frames must complete in order");
+
+    m_CurrentFrame.FenceValue = FenceValue;
+    m_CurrentFrame.SubmitTick = Tick;
+    m_PendingFrames.push_back(m_CurrentFrame);
+    m_PendingFrames.back().QueueDepth = (uint32_t)m_PendingFrames.size();
+    m_IsFrameOpen = false;
+}
+
+uint64_t FramePacer::GetFenceToWaitFor( void ) const
+{
+    // Starting the next frame adds one to the queue, so only TargetDepth - 1 frames may remain
+    uint32_t TargetDepth = GetTargetQueueDepth();
+    if (m_PendingFrames.size() < TargetDepth)
+        return 0;
+
+    return m_PendingFrames[m_PendingFrames.size() - TargetDepth].FenceValue;
+}
+
+uint64_t FramePacer::GetOldestPendingFence( void ) const
+{
+    return m_PendingFrames.empty() ? 0 : m_PendingFrames.front().FenceValue;
+}
+
+void FramePacer::CompleteFrames( uint64_t CompletedFenceValue, int64_t Tick )
+{
+    while (!m_PendingFrames.empty() && m_PendingFrames.front().FenceValue <= CompletedFenceValue)
+    {
+        FrameTiming& Frame = m_PendingFrames.front();
+        Frame.CompleteTick = Tick;
+
+        int64_t Latency = Frame.CompleteTick - Frame.StartTick;
+        ++m_Statistics.NumFrames;
+        m_Statistics.TotalLatency += Latency;
+        m_Statistics.MaxLatency = std::max(m_Statistics.MaxLatency, Latency);
+        m_Statistics.TotalWait += Frame.WaitTicks;
+        m_Statistics.TotalQueueDepth += Frame.QueueDepth;
+
+        m_LastCompletedFrame = Frame;
+        m_PendingFrames.pop_front();
+    }
+}
+
+void FramePacer::ResetStatistics( void )
+{
+    ZeroMemory(&m_Statistics, sizeof(m_Statistics));
+}
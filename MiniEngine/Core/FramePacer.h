@@ -0,0 +1,106 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <deque>
+#include <stdint.h>
+
+// Decides how far the CPU may run ahead of the GPU, and measures how long each frame takes from the
+// moment the CPU starts it, which is when input is sampled, until the GPU has finished it.  Frames are
+// identified by the fence that completes them.  The pacer never reads a clock or a fence itself, so the
+// policy can be driven by a simulated clock as well as by the graphics queue.
+//
+// GPU completion is only observed when the caller reports it, so the completion time of a frame that
+// finished while the CPU was busy is the time it was next checked.  Frames the CPU had to wait for are
+// timed exactly.
+class FramePacer
+{
+public:
+    enum Policy
+    {
+        // Don't start a frame until the previous one has completed.  Input is sampled as late as
+        // possible, at the cost of the GPU idling while the CPU records.
+        kLowLatency,
+
+        // Keep up to the maximum number of frames queued, so the GPU always has work.
+        kMaxThroughput,
+
+        kNumPolicies
+    };
+
+    struct FrameTiming
+    {
+        uint64_t FrameIndex;
+        uint64_t FenceValue;
+        int64_t StartTick;      // When the CPU began the frame
+        int64_t SubmitTick;     // When the CPU was done with the frame
+        int64_t CompleteTick;   // When the GPU was seen to have finished the frame
+        int64_t WaitTicks;      // How long the CPU was throttled before starting the frame
+        uint32_t QueueDepth;    // Frames on the GPU when this one was submitted, including itself
+    };
+
+    // Totals over the frames completed since the last reset.  Times are in ticks of the caller's clock.
+    struct Statistics
+    {
+        uint32_t NumFrames;
+        int64_t TotalLatency;
+        int64_t MaxLatency;
+        int64_t TotalWait;
+        uint64_t TotalQueueDepth;
+    };
+
+    FramePacer();
+
+    // MaxQueuedFrames only applies to the max-throughput policy.
+    void SetPolicy( Policy NewPolicy, uint32_t MaxQueuedFrames );
+    Policy GetPolicy( void ) const { return m_Policy; }
+
+    // How many frames may be queued on the GPU while the CPU records the next one, including it
+    uint32_t GetTargetQueueDepth( void ) const { return m_Policy == kLowLatency ? 1 : m_MaxQueuedFrames; }
+
+    // Marks the start of a frame, after the CPU has waited for GetFenceToWaitFor().
+    void BeginFrame( int64_t Tick, int64_t WaitTicks );
+
+    // Marks the end of the frame that began last.  FenceValue must complete after all of its GPU work.
+    void EndFrame( int64_t Tick, uint64_t FenceValue );
+
+    // The fence to wait for before the next frame begins, or 0 when it can begin right away
+    uint64_t GetFenceToWaitFor( void ) const;
+
+    // The fence of the oldest frame that hasn't been seen to complete, or 0 when none are queued
+    uint64_t GetOldestPendingFence( void ) const;
+
+    // Retires the queued frames whose fences are no greater than CompletedFenceValue.
+    void CompleteFrames( uint64_t CompletedFenceValue, int64_t Tick );
+
+    uint32_t GetQueueDepth( void ) const { return (uint32_t)m_PendingFrames.size(); }
+
+    // The most recently completed frame.  Its frame index is ~0ull before any frame has completed.
+    const FrameTiming& GetLastCompletedFrame( void ) const { return m_LastCompletedFrame; }
+
+    const Statistics& GetStatistics( void ) const { return m_Statistics; }
+    void ResetStatistics( void );
+
+private:
+    Policy m_Policy;
+    uint32_t m_MaxQueuedFrames;
+
+    uint64_t m_NextFrameIndex;
+    bool m_IsFrameOpen;
+    FrameTiming m_CurrentFrame;
+
+    // Submitted frames in fence order
+    std::deque<FrameTiming> m_PendingFrames;
+
+    FrameTiming m_LastCompletedFrame;
+    Statistics m_Statistics;
+};
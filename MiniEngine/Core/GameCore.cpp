@@ -19,6 +19,7 @@
 #include "BufferManager.h"
 #include "CommandContext.h"
 #include "PostEffects.h"
+#include "Benchmark.h"
 
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
     #pragma comment(lib, "runtimeobject.lib")
@@ -64,6 +65,9 @@ namespace GameCore
     {
         EngineProfiling::Update();
 
+        if (Benchmark::IsEnabled() && !Benchmark::Update())
+            return false;
+
         float DeltaTime = Graphics::GetFrameTime();
     
         GameInput::Update(DeltaTime);
@@ -311,6 +315,8 @@ namespace GameCore
         Microsoft::WRL::Wrappers::RoInitializeWrapper InitializeWinRT(RO_INIT_MULTITHREADED);
         ASSERT_SUCCEEDED(InitializeWinRT);
 
+        Benchmark::Initialize();
+
         HINSTANCE hInst = GetModuleHandle(0);
 
         // Register class
@@ -340,7 +346,9 @@ namespace GameCore
 
         InitializeApplication(app);
 
-        ShowWindow( g_hWnd, SW_SHOWDEFAULT );
+        // Headless benchmarks keep the window hidden.  It still exists for the sake of input.
+        if (!Graphics::g_bHeadless)
+            ShowWindow( g_hWnd, SW_SHOWDEFAULT );
 
         do
         {
@@ -355,6 +363,9 @@ namespace GameCore
         }
         while (UpdateApplication(app));    // Returns false to quit loop
 
+        if (Benchmark::IsEnabled())
+            Benchmark::Report();
+
         Graphics::Terminate();
         TerminateApplication(app);
         Graphics::Shutdown();
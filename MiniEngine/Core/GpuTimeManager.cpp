@@ -19,15 +19,36 @@
 
 namespace
 {
+    // Each frame's time stamps go to their own region of the query heap and readback buffer.
+    // With more slots than frames in flight, the slot being written is never one the GPU has yet
+    // to finish resolving, unless the GPU falls that far behind, in which case that frame is dropped.
+    const uint32_t kNumReadBackSlots = 4;    // One more than the swap chain buffers
+
+    struct ReadBackSlot
+    {
+        uint64_t Fence = 0;
+        uint64_t FrameId = 0;
+        bool IsPending = false;     // Resolved but not read back yet
+    };
+
     ID3D12QueryHeap* sm_QueryHeap = nullptr;
     ID3D12Resource* sm_ReadBackBuffer = nullptr;
     uint64_t* sm_TimeStampBuffer = nullptr;
-    uint64_t sm_Fence = 0;
+    ReadBackSlot sm_Slots[kNumReadBackSlots];
+    uint32_t sm_WriteSlot = 0;
+    uint32_t sm_ReadSlot = 0;
+    uint64_t sm_ReadFrameId = 0;
+    bool sm_HasReadBack = false;
     uint32_t sm_MaxNumTimers = 0;
     uint32_t sm_NumTimers = 1;
     uint64_t sm_ValidTimeStart = 0;
     uint64_t sm_ValidTimeEnd = 0;
     double sm_GpuTickDelta = 0.0;
+
+    uint32_t GetSlotQueryOffset(uint32_t Slot)
+    {
+        return Slot * sm_MaxNumTimers * 2;
+    }
 }
 
 void GpuTimeManager::Initialize(uint32_t MaxNumTimers)
@@ -46,7 +67,7 @@ void GpuTimeManager::Initialize(uint32_t MaxNumTimers)
     D3D12_RESOURCE_DESC BufferDesc;
     BufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
     BufferDesc.Alignment = 0;
-    BufferDesc.Width = sizeof(uint64_t) * MaxNumTimers * 2;
+    BufferDesc.Width = sizeof(uint64_t) * MaxNumTimers * 2 * kNumReadBackSlots;
     BufferDesc.Height = 1;
     BufferDesc.DepthOrArraySize = 1;
     BufferDesc.MipLevels = 1;
@@ -61,13 +82,20 @@ void GpuTimeManager::Initialize(uint32_t MaxNumTimers)
     sm_ReadBackBuffer->SetName(L"GpuTimeStamp Buffer");
 
     D3D12_QUERY_HEAP_DESC QueryHeapDesc;
-    QueryHeapDesc.Count = MaxNumTimers * 2;
+    QueryHeapDesc.Count = MaxNumTimers * 2 * kNumReadBackSlots;
     QueryHeapDesc.NodeMask = 1;
     QueryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
     ASSERT_SUCCEEDED(Graphics::g_Device->CreateQueryHeap(&QueryHeapDesc, MY_IID_PPV_ARGS(&sm_QueryHeap)));
     sm_QueryHeap->SetName(L"GpuTimeStamp QueryHeap");
 
     sm_MaxNumTimers = (uint32_t)MaxNumTimers;
+
+    for (ReadBackSlot& Slot : sm_Slots)
+        Slot = ReadBackSlot();
+    sm_WriteSlot = 0;
+    sm_ReadSlot = 0;
+    sm_ReadFrameId = 0;
+    sm_HasReadBack = false;
 }
 
 void GpuTimeManager::Shutdown()
@@ -86,32 +114,54 @@ uint32_t GpuTimeManager::NewTimer(void)
 
 void GpuTimeManager::StartTimer(CommandContext& Context, uint32_t TimerIdx)
 {
-    Context.InsertTimeStamp(sm_QueryHeap, TimerIdx * 2);
+    Context.InsertTimeStamp(sm_QueryHeap, GetSlotQueryOffset(sm_WriteSlot) + TimerIdx * 2);
 }
 
 void GpuTimeManager::StopTimer(CommandContext& Context, uint32_t TimerIdx)
 {
-    Context.InsertTimeStamp(sm_QueryHeap, TimerIdx * 2 + 1);
+    Context.InsertTimeStamp(sm_QueryHeap, GetSlotQueryOffset(sm_WriteSlot) + TimerIdx * 2 + 1);
 }
 
-void GpuTimeManager::BeginReadBack(void)
+bool GpuTimeManager::BeginReadBack(void)
 {
-    Graphics::g_CommandManager.WaitForFence(sm_Fence);
+    // Find the most recently resolved slot that the GPU has finished with.  Older completed
+    // slots are superseded by it.
+    bool HasNewFrame = false;
+    for (uint32_t i = 1; i <= kNumReadBackSlots; ++i)
+    {
+        uint32_t Slot = (sm_WriteSlot + kNumReadBackSlots - i) % kNumReadBackSlots;
+        if (sm_Slots[Slot].IsPending && Graphics::g_CommandManager.IsFenceComplete(sm_Slots[Slot].Fence))
+        {
+            if (!HasNewFrame)
+            {
+                sm_ReadSlot = Slot;
+                sm_ReadFrameId = sm_Slots[Slot].FrameId;
+                HasNewFrame = true;
+                sm_HasReadBack = true;
+            }
+            sm_Slots[Slot].IsPending = false;
+        }
+    }
 
+    uint64_t SlotOffset = GetSlotQueryOffset(sm_ReadSlot) * sizeof(uint64_t);
     D3D12_RANGE Range;
-    Range.Begin = 0;
-    Range.End = (sm_NumTimers * 2) * sizeof(uint64_t);
-    ASSERT_SUCCEEDED(sm_ReadBackBuffer->Map(0, &Range, reinterpret_cast<void**>(&sm_TimeStampBuffer)));
+    Range.Begin = SlotOffset;
+    Range.End = SlotOffset + (sm_NumTimers * 2) * sizeof(uint64_t);
+    uint64_t* MappedBuffer;
+    ASSERT_SUCCEEDED(sm_ReadBackBuffer->Map(0, &Range, reinterpret_cast<void**>(&MappedBuffer)));
+    sm_TimeStampBuffer = MappedBuffer + GetSlotQueryOffset(sm_ReadSlot);
 
     sm_ValidTimeStart = sm_TimeStampBuffer[0];
     sm_ValidTimeEnd = sm_TimeStampBuffer[1];
 
-    // On the first frame, with random values in the timestamp query heap, we can avoid a misstart.
-    if (sm_ValidTimeEnd < sm_ValidTimeStart)
+    // Until a slot has been resolved, and on its first frame, the values are random, so we can avoid a misstart.
+    if (!sm_HasReadBack || sm_ValidTimeEnd < sm_ValidTimeStart)
     {
         sm_ValidTimeStart = 0ull;
         sm_ValidTimeEnd = 0ull;
     }
+
+    return HasNewFrame;
 }
 
 void GpuTimeManager::EndReadBack(void)
@@ -121,11 +171,22 @@ void GpuTimeManager::EndReadBack(void)
     sm_ReadBackBuffer->Unmap(0, &EmptyRange);
     sm_TimeStampBuffer = nullptr;
 
+    // Resolve this frame's slot without waiting on it, and start timing the next frame in the next slot.
+    // The resolve of the same slot kNumReadBackSlots frames ago is ordered before this one on the queue.
+    uint32_t SlotQueryOffset = GetSlotQueryOffset(sm_WriteSlot);
+    uint32_t NextSlot = (sm_WriteSlot + 1) % kNumReadBackSlots;
+
     CommandContext& Context = CommandContext::Begin();
-    Context.InsertTimeStamp(sm_QueryHeap, 1);
-    Context.ResolveTimeStamps(sm_ReadBackBuffer, sm_QueryHeap, sm_NumTimers * 2);
-    Context.InsertTimeStamp(sm_QueryHeap, 0);
-    sm_Fence = Context.Finish();
+    Context.InsertTimeStamp(sm_QueryHeap, SlotQueryOffset + 1);
+    Context.ResolveTimeStamps(sm_ReadBackBuffer, sm_QueryHeap, sm_NumTimers * 2, SlotQueryOffset);
+    Context.InsertTimeStamp(sm_QueryHeap, GetSlotQueryOffset(NextSlot));
+
+    ReadBackSlot& Slot = sm_Slots[sm_WriteSlot];
+    Slot.FrameId = Graphics::GetFrameCount();
+    Slot.IsPending = true;
+    Slot.Fence = Context.Finish();
+
+    sm_WriteSlot = NextSlot;
 }
 
 float GpuTimeManager::GetTime(uint32_t TimerIdx)
@@ -141,3 +202,8 @@ float GpuTimeManager::GetTime(uint32_t TimerIdx)
 
     return static_cast<float>(sm_GpuTickDelta * (TimeStamp2 - TimeStamp1));
 }
+
+uint64_t GpuTimeManager::GetReadBackFrameId(void)
+{
+    return sm_ReadFrameId;
+}
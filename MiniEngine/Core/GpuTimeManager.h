@@ -30,10 +30,18 @@ namespace GpuTimeManager
     void StopTimer(CommandContext& Context, uint32_t TimerIdx);
 
     // Bookend all calls to GetTime() with Begin/End which correspond to Map/Unmap.  This
-    // needs to happen either at the very start or very end of a frame.
-    void BeginReadBack(void);
+    // needs to happen either at the very start or very end of a frame.  Time stamps are
+    // resolved into a ring of readback slots, and BeginReadBack() maps the newest slot the
+    // GPU has finished with, so it never waits on the GPU.  It returns false when no frame
+    // has completed since the last read back, in which case GetTime() returns the times of
+    // that same frame again.
+    bool BeginReadBack(void);
     void EndReadBack(void);
 
     // Returns the time in milliseconds between start and stop queries
     float GetTime(uint32_t TimerIdx);
+
+    // The frame whose times are mapped, as counted by Graphics::GetFrameCount() when its
+    // time stamps were resolved.
+    uint64_t GetReadBackFrameId(void);
 }
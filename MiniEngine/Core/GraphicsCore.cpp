@@ -30,6 +30,8 @@
 #include "ParticleEffectManager.h"
 #include "GraphRenderer.h"
 #include "TemporalEffects.h"
+#include "FramePacer.h"
+#include "NullDevice.h"
 
 // This macro determines whether to detect if there is an HDR display and enable HDR10 output.
 // Currently, with HDR display enabled, the pixel magnfication functionality is broken.
@@ -94,6 +96,10 @@ namespace
 
     BoolVar s_LimitTo30Hz("Timing/Limit To 30Hz", false);
     BoolVar s_DropRandomFrames("Timing/Drop Random Frames", false);
+
+    const char* s_PacingPolicyLabels[] = { "Low Latency", "Max Throughput" };
+    EnumVar s_PacingPolicy("Timing/Frame Pacing", FramePacer::kMaxThroughput, FramePacer::kNumPolicies, s_PacingPolicyLabels);
+    IntVar s_MaxQueuedFrames("Timing/Max Queued Frames", 2, 1, SWAP_CHAIN_BUFFER_COUNT);
 }
 
 namespace Graphics
@@ -187,6 +193,10 @@ namespace Graphics
 
     IDXGISwapChain1* s_SwapChain1 = nullptr;
 
+    bool g_bHeadless = false;
+    bool g_bNullDevice = false;
+    FramePacer g_FramePacer;
+
     DescriptorAllocator g_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] =
     {
         D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
@@ -224,7 +234,7 @@ namespace Graphics
 
 void Graphics::Resize(uint32_t width, uint32_t height)
 {
-    ASSERT(s_SwapChain1 != nullptr);
+    ASSERT(s_SwapChain1 != nullptr || g_bHeadless);
 
     // Check for invalid window dimensions
     if (width == 0 || height == 0)
@@ -246,13 +256,21 @@ void Graphics::Resize(uint32_t width, uint32_t height)
     for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
         g_DisplayPlane[i].Destroy();
 
-    ASSERT_SUCCEEDED(s_SwapChain1->ResizeBuffers(SWAP_CHAIN_BUFFER_COUNT, width, height, SwapChainFormat, 0));
-
-    for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+    if (g_bHeadless)
     {
-        ComPtr<ID3D12Resource> DisplayPlane;
-        ASSERT_SUCCEEDED(s_SwapChain1->GetBuffer(i, MY_IID_PPV_ARGS(&DisplayPlane)));
-        g_DisplayPlane[i].CreateFromSwapChain(L"Primary SwapChain Buffer", DisplayPlane.Detach());
+        for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+            g_DisplayPlane[i].Create(L"Primary SwapChain Buffer", width, height, 1, SwapChainFormat);
+    }
+    else
+    {
+        ASSERT_SUCCEEDED(s_SwapChain1->ResizeBuffers(SWAP_CHAIN_BUFFER_COUNT, width, height, SwapChainFormat, 0));
+
+        for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+        {
+            ComPtr<ID3D12Resource> DisplayPlane;
+            ASSERT_SUCCEEDED(s_SwapChain1->GetBuffer(i, MY_IID_PPV_ARGS(&DisplayPlane)));
+            g_DisplayPlane[i].CreateFromSwapChain(L"Primary SwapChain Buffer", DisplayPlane.Detach());
+        }
     }
 
     g_CurrentBuffer = 0;
@@ -301,7 +319,8 @@ static HRESULT EnableExperimentalShaderModels() { return S_OK; }
 // Initialize the DirectX resources required to run.
 void Graphics::Initialize(void)
 {
-    ASSERT(s_SwapChain1 == nullptr, "Graphics has already been initialized");
+    ASSERT(g_Device == nullptr, "Graphics has already been initialized");
+    ASSERT(g_bHeadless || !g_bNullDevice, "The null device has nothing to present with");
 
     Microsoft::WRL::ComPtr<ID3D12Device> pDevice;
 
@@ -322,9 +341,16 @@ void Graphics::Initialize(void)
     // Create the D3D graphics device
     Microsoft::WRL::ComPtr<IDXGIAdapter1> pAdapter;
 
-    static const bool bUseWarpDriver = false;
+    // Headless runs use WARP, so they behave the same on any machine, with or without a GPU, unless
+    // they asked for the null device.
+    const bool bUseWarpDriver = g_bHeadless && !g_bNullDevice;
 
-    if (!bUseWarpDriver)
+    if (g_bNullDevice)
+    {
+        Utility::Print("Null device requested.  Commands will be recorded but never executed.\n");
+        g_Device = NullDevice::Create();
+    }
+    else if (!bUseWarpDriver)
     {
         SIZE_T MaxSize = 0;
 
@@ -358,7 +384,7 @@ void Graphics::Initialize(void)
         g_Device = pDevice.Detach();
     }
 #ifndef RELEASE
-    else
+    else if (!g_bNullDevice)
     {
         bool DeveloperModeEnabled = false;
 
@@ -461,51 +487,60 @@ void Graphics::Initialize(void)
 
     g_CommandManager.Create(g_Device);
 
-    DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-    swapChainDesc.Width = g_DisplayWidth;
-    swapChainDesc.Height = g_DisplayHeight;
-    swapChainDesc.Format = SwapChainFormat;
-    swapChainDesc.Scaling = DXGI_SCALING_NONE;
-    swapChainDesc.SampleDesc.Quality = 0;
-    swapChainDesc.SampleDesc.Count = 1;
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.BufferCount = SWAP_CHAIN_BUFFER_COUNT;
-    swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    if (g_bHeadless)
+    {
+        // Without a window there's nothing to present to, so the display planes are plain render targets.
+        for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+            g_DisplayPlane[i].Create(L"Primary SwapChain Buffer", g_DisplayWidth, g_DisplayHeight, 1, SwapChainFormat);
+    }
+    else
+    {
+        DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+        swapChainDesc.Width = g_DisplayWidth;
+        swapChainDesc.Height = g_DisplayHeight;
+        swapChainDesc.Format = SwapChainFormat;
+        swapChainDesc.Scaling = DXGI_SCALING_NONE;
+        swapChainDesc.SampleDesc.Quality = 0;
+        swapChainDesc.SampleDesc.Count = 1;
+        swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+        swapChainDesc.BufferCount = SWAP_CHAIN_BUFFER_COUNT;
+        swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
 
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP) // Win32
-    ASSERT_SUCCEEDED(dxgiFactory->CreateSwapChainForHwnd(g_CommandManager.GetCommandQueue(), GameCore::g_hWnd, &swapChainDesc, nullptr, nullptr, &s_SwapChain1));
+        ASSERT_SUCCEEDED(dxgiFactory->CreateSwapChainForHwnd(g_CommandManager.GetCommandQueue(), GameCore::g_hWnd, &swapChainDesc, nullptr, nullptr, &s_SwapChain1));
 #else // UWP
-    ASSERT_SUCCEEDED(dxgiFactory->CreateSwapChainForCoreWindow(g_CommandManager.GetCommandQueue(), (IUnknown*)GameCore::g_window.Get(), &swapChainDesc, nullptr, &s_SwapChain1));
+        ASSERT_SUCCEEDED(dxgiFactory->CreateSwapChainForCoreWindow(g_CommandManager.GetCommandQueue(), (IUnknown*)GameCore::g_window.Get(), &swapChainDesc, nullptr, &s_SwapChain1));
 #endif
 
 #if CONDITIONALLY_ENABLE_HDR_OUTPUT && defined(NTDDI_WIN10_RS2) && (NTDDI_VERSION >= NTDDI_WIN10_RS2)
-    {
-        IDXGISwapChain4* swapChain = (IDXGISwapChain4*)s_SwapChain1;
-        ComPtr<IDXGIOutput> output;
-        ComPtr<IDXGIOutput6> output6;
-        DXGI_OUTPUT_DESC1 outputDesc;
-        UINT colorSpaceSupport;
-
-        // Query support for ST.2084 on the display and set the color space accordingly
-        if (SUCCEEDED(swapChain->GetContainingOutput(&output)) &&
-            SUCCEEDED(output.As(&output6)) &&
-            SUCCEEDED(output6->GetDesc1(&outputDesc)) &&
-            outputDesc.ColorSpace == DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020 &&
-            SUCCEEDED(swapChain->CheckColorSpaceSupport(DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020, &colorSpaceSupport)) &&
-            (colorSpaceSupport & DXGI_SWAP_CHAIN_COLOR_SPACE_SUPPORT_FLAG_PRESENT) &&
-            SUCCEEDED(swapChain->SetColorSpace1(DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020)))
         {
-            g_bEnableHDROutput = true;
+            IDXGISwapChain4* swapChain = (IDXGISwapChain4*)s_SwapChain1;
+            ComPtr<IDXGIOutput> output;
+            ComPtr<IDXGIOutput6> output6;
+            DXGI_OUTPUT_DESC1 outputDesc;
+            UINT colorSpaceSupport;
+
+            // Query support for ST.2084 on the display and set the color space accordingly
+            if (SUCCEEDED(swapChain->GetContainingOutput(&output)) &&
+                SUCCEEDED(output.As(&output6)) &&
+                SUCCEEDED(output6->GetDesc1(&outputDesc)) &&
+                outputDesc.ColorSpace == DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020 &&
+                SUCCEEDED(swapChain->CheckColorSpaceSupport(DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020, &colorSpaceSupport)) &&
+                (colorSpaceSupport & DXGI_SWAP_CHAIN_COLOR_SPACE_SUPPORT_FLAG_PRESENT) &&
+                SUCCEEDED(swapChain->SetColorSpace1(DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020)))
+            {
+                g_bEnableHDROutput = true;
+            }
         }
-    }
 #endif
 
-    for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
-    {
-        ComPtr<ID3D12Resource> DisplayPlane;
-        ASSERT_SUCCEEDED(s_SwapChain1->GetBuffer(i, MY_IID_PPV_ARGS(&DisplayPlane)));
-        g_DisplayPlane[i].CreateFromSwapChain(L"Primary SwapChain Buffer", DisplayPlane.Detach());
+        for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
+        {
+            ComPtr<ID3D12Resource> DisplayPlane;
+            ASSERT_SUCCEEDED(s_SwapChain1->GetBuffer(i, MY_IID_PPV_ARGS(&DisplayPlane)));
+            g_DisplayPlane[i].CreateFromSwapChain(L"Primary SwapChain Buffer", DisplayPlane.Detach());
+        }
     }
 
     // Common state was moved to GraphicsCommon.*
@@ -597,7 +632,8 @@ void Graphics::Terminate( void )
 {
     g_CommandManager.IdleGPU();
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
-    s_SwapChain1->SetFullscreenState(FALSE, nullptr);
+    if (s_SwapChain1 != nullptr)
+        s_SwapChain1->SetFullscreenState(FALSE, nullptr);
 #endif
 }
 
@@ -606,7 +642,7 @@ void Graphics::Shutdown( void )
     CommandContext::DestroyAllContexts();
     g_CommandManager.Shutdown();
     GpuTimeManager::Shutdown();
-    s_SwapChain1->Release();
+    SAFE_RELEASE(s_SwapChain1);
     PSO::DestroyAll();
     RootSignature::DestroyAll();
     DescriptorAllocator::DestroyAll();
@@ -784,11 +820,24 @@ void Graphics::Present(void)
     else
         PreparePresentLDR();
 
-    g_CurrentBuffer = (g_CurrentBuffer + 1) % SWAP_CHAIN_BUFFER_COUNT;
+    CommandQueue& GraphicsQueue = g_CommandManager.GetGraphicsQueue();
+    uint64_t FrameFence;
+
+    if (g_bHeadless)
+    {
+        // Without a swap chain, the frame pacer below is all that keeps the CPU from running ahead
+        g_CurrentBuffer = (g_CurrentBuffer + 1) % SWAP_CHAIN_BUFFER_COUNT;
+        FrameFence = GraphicsQueue.IncrementFence();
+    }
+    else
+    {
+        g_CurrentBuffer = (g_CurrentBuffer + 1) % SWAP_CHAIN_BUFFER_COUNT;
 
-    UINT PresentInterval = s_EnableVSync ? std::min(4, (int)Round(s_FrameTime * 60.0f)) : 0;
+        UINT PresentInterval = s_EnableVSync ? std::min(4, (int)Round(s_FrameTime * 60.0f)) : 0;
 
-    s_SwapChain1->Present(PresentInterval, 0);
+        s_SwapChain1->Present(PresentInterval, 0);
+        FrameFence = GraphicsQueue.IncrementFence();
+    }
 
     // Test robustness to handle spikes in CPU time
     //if (s_DropRandomFrames)
@@ -797,9 +846,29 @@ void Graphics::Present(void)
     //        BusyLoopSleep(0.010);
     //}
 
+    // Hold the next frame back until the GPU queue is down to the target depth
+    g_FramePacer.SetPolicy((FramePacer::Policy)(int32_t)s_PacingPolicy, (uint32_t)(int32_t)s_MaxQueuedFrames);
+    g_FramePacer.EndFrame(SystemTime::GetCurrentTick(), FrameFence);
+
+    int64_t WaitStartTick = SystemTime::GetCurrentTick();
+    uint64_t WaitFence = g_FramePacer.GetFenceToWaitFor();
+    if (WaitFence != 0)
+        GraphicsQueue.WaitForFence(WaitFence);
+
     int64_t CurrentTick = SystemTime::GetCurrentTick();
 
-    if (s_EnableVSync)
+    uint64_t PendingFence;
+    while ((PendingFence = g_FramePacer.GetOldestPendingFence()) != 0 && GraphicsQueue.IsFenceComplete(PendingFence))
+        g_FramePacer.CompleteFrames(PendingFence, CurrentTick);
+
+    g_FramePacer.BeginFrame(CurrentTick, CurrentTick - WaitStartTick);
+
+    if (g_bHeadless)
+    {
+        // Step at a fixed rate, so headless runs simulate the same frames however fast they record them.
+        s_FrameTime = 1.0f / 60.0f;
+    }
+    else if (s_EnableVSync)
     {
         // With VSync enabled, the time step between frames becomes a multiple of 16.666 ms.  We need
         // to add logic to vary between 1 and 2 (or 3 fields).  This delta time also determines how
@@ -841,3 +910,12 @@ float Graphics::GetFrameRate(void)
 {
     return s_FrameTime == 0.0f ? 0.0f : 1.0f / s_FrameTime;
 }
+
+float Graphics::GetFrameLatency(void)
+{
+    const FramePacer::FrameTiming& Frame = g_FramePacer.GetLastCompletedFrame();
+    if (Frame.FrameIndex == ~0ull)
+        return 0.0f;
+
+    return (float)SystemTime::TimeBetweenTicks(Frame.StartTick, Frame.CompleteTick);
+}
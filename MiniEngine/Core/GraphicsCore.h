@@ -26,6 +26,7 @@ class CommandContext;
 class CommandListManager;
 class CommandSignature;
 class ContextManager;
+class FramePacer;
 
 namespace Graphics
 {
@@ -44,6 +45,14 @@ namespace Graphics
     extern uint32_t g_DisplayWidth;
     extern uint32_t g_DisplayHeight;
 
+    // Renders on the WARP adapter into display planes that are never presented, and steps frames at
+    // a fixed rate.  Must be set before Initialize.
+    extern bool g_bHeadless;
+
+    // Renders headless on the null device instead of WARP, so that no GPU work runs anywhere.  Must
+    // be set before Initialize, along with g_bHeadless.
+    extern bool g_bNullDevice;
+
     // Returns the number of elapsed frames since application start
     uint64_t GetFrameCount(void);
 
@@ -55,6 +64,14 @@ namespace Graphics
     // The total number of frames per second
     float GetFrameRate(void);
 
+    // The time from the start of the last completed frame, when input was sampled, until the GPU
+    // finished it.  Presentation to the display is not included.
+    float GetFrameLatency(void);
+
+    // Throttles the CPU to the queue depth of the "Timing/Frame Pacing" policy, and keeps the
+    // latency statistics of every frame.  Times are in SystemTime ticks.
+    extern FramePacer g_FramePacer;
+
     extern ID3D12Device* g_Device;
     extern CommandListManager g_CommandManager;
     extern ContextManager g_ContextManager;
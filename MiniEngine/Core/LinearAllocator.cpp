@@ -36,12 +36,6 @@ LinearAllocationPage* LinearAllocatorPageManager::RequestPage()
 {
     lock_guard<mutex> LockGuard(m_Mutex);
 
-    while (!m_RetiredPages.empty() && g_CommandManager.IsFenceComplete(m_RetiredPages.front().first))
-    {
-        m_AvailablePages.push(m_RetiredPages.front().second);
-        m_RetiredPages.pop();
-    }
-
     LinearAllocationPage* PagePtr = nullptr;
 
     if (!m_AvailablePages.empty())
@@ -60,26 +54,24 @@ LinearAllocationPage* LinearAllocatorPageManager::RequestPage()
 
 void LinearAllocatorPageManager::DiscardPages( uint64_t FenceValue, const vector<LinearAllocationPage*>& UsedPages )
 {
-    lock_guard<mutex> LockGuard(m_Mutex);
-    for (auto iter = UsedPages.begin(); iter != UsedPages.end(); ++iter)
-        m_RetiredPages.push(make_pair(FenceValue, *iter));
+    g_CommandManager.OnFenceComplete(FenceValue, [this, UsedPages]
+    {
+        lock_guard<mutex> LockGuard(m_Mutex);
+        for (auto iter = UsedPages.begin(); iter != UsedPages.end(); ++iter)
+            m_AvailablePages.push(*iter);
+    });
 }
 
 void LinearAllocatorPageManager::FreeLargePages( uint64_t FenceValue, const vector<LinearAllocationPage*>& LargePages )
 {
-    lock_guard<mutex> LockGuard(m_Mutex);
-
-    while (!m_DeletionQueue.empty() && g_CommandManager.IsFenceComplete(m_DeletionQueue.front().first))
-    {
-        delete m_DeletionQueue.front().second;
-        m_DeletionQueue.pop();
-    }
-
     for (auto iter = LargePages.begin(); iter != LargePages.end(); ++iter)
-    {
         (*iter)->Unmap();
-        m_DeletionQueue.push(make_pair(FenceValue, *iter));
-    }
+
+    g_CommandManager.OnFenceComplete(FenceValue, [LargePages]
+    {
+        for (auto iter = LargePages.begin(); iter != LargePages.end(); ++iter)
+            delete *iter;
+    });
 }
 
 LinearAllocationPage* LinearAllocatorPageManager::CreateNewPage( size_t PageSize  )
@@ -104,7 +104,7 @@ public:
     LinearAllocationPage* RequestPage( void );
     LinearAllocationPage* CreateNewPage( size_t PageSize = 0 );
 
-    // Discarded pages will get recycled.  This is for fixed size pages.
+    // Discarded pages will get recycled as soon as their fence has passed.  This is for fixed size pages.
     void DiscardPages( uint64_t FenceID, const std::vector<LinearAllocationPage*>& Pages );
 
     // Freed pages will be destroyed once their fence has passed.  This is for single-use,
@@ -119,8 +119,6 @@ private:
 
     LinearAllocatorType m_AllocationType;
     std::vector<std::unique_ptr<LinearAllocationPage> > m_PagePool;
-    std::queue<std::pair<uint64_t, LinearAllocationPage*> > m_RetiredPages;
-    std::queue<std::pair<uint64_t, LinearAllocationPage*> > m_DeletionQueue;
     std::queue<LinearAllocationPage*> m_AvailablePages;
     std::mutex m_Mutex;
 };
@@ -13,8 +13,313 @@
 
 #include "pch.h"
 #include "Random.h"
+#include "SystemTime.h"
+#include <emmintrin.h>
 
 namespace Math
 {
     RandomNumberGenerator g_RNG;
 }
+
+using namespace Math;
+
+namespace
+{
+    const uint32_t kPhiloxM0 = 0xD2511F53;
+    const uint32_t kPhiloxM1 = 0xCD9E8D57;
+    const uint32_t kPhiloxW0 = 0x9E3779B9;
+    const uint32_t kPhiloxW1 = 0xBB67AE85;
+
+    // Four independent Philox blocks in structure-of-arrays form:  C[i] holds word i of each block.
+    struct PhiloxLanes
+    {
+        __m128i C[4];
+    };
+
+    // Full 32x32->64 multiply of each lane by a constant, split into low and high halves
+    __forceinline void MulHiLo( __m128i A, __m128i M, __m128i& Lo, __m128i& Hi )
+    {
+        const __m128i EvenMask = _mm_set_epi32(0, -1, 0, -1);
+        __m128i Even = _mm_mul_epu32(A, M);
+        __m128i Odd = _mm_mul_epu32(_mm_srli_epi64(A, 32), M);
+        Lo = _mm_or_si128(_mm_and_si128(Even, EvenMask), _mm_slli_epi64(Odd, 32));
+        Hi = _mm_or_si128(_mm_srli_epi64(Even, 32), _mm_andnot_si128(EvenMask, Odd));
+    }
+
+    void Philox4x32_SSE( PhiloxLanes& L, const uint32_t Key[2] )
+    {
+        const __m128i M0 = _mm_set1_epi32((int)kPhiloxM0);
+        const __m128i M1 = _mm_set1_epi32((int)kPhiloxM1);
+        uint32_t K0 = Key[0], K1 = Key[1];
+
+        for (uint32_t Round = 0; Round < 10; ++Round)
+        {
+            __m128i Lo0, Hi0, Lo1, Hi1;
+            MulHiLo(L.C[0], M0, Lo0, Hi0);
+            MulHiLo(L.C[2], M1, Lo1, Hi1);
+
+            __m128i C1 = L.C[1], C3 = L.C[3];
+            L.C[0] = _mm_xor_si128(_mm_xor_si128(Hi1, C1), _mm_set1_epi32((int)K0));
+            L.C[1] = Lo1;
+            L.C[2] = _mm_xor_si128(_mm_xor_si128(Hi0, C3), _mm_set1_epi32((int)K1));
+            L.C[3] = Lo0;
+
+            K0 += kPhiloxW0;
+            K1 += kPhiloxW1;
+        }
+    }
+
+    // Generates blocks [Counter, Counter + 4) of a stream, returned in sequence order (block-major)
+    __forceinline void GenerateFourBlocks( uint64_t Counter, const uint32_t Stream[2], const uint32_t Key[2], __m128i Out[4] )
+    {
+        const uint64_t C0 = Counter, C1 = Counter + 1, C2 = Counter + 2, C3 = Counter + 3;
+
+        PhiloxLanes L;
+        L.C[0] = _mm_set_epi32((int)C3, (int)C2, (int)C1, (int)C0);
+        L.C[1] = _mm_set_epi32((int)(C3 >> 32), (int)(C2 >> 32), (int)(C1 >> 32), (int)(C0 >> 32));
+        L.C[2] = _mm_set1_epi32((int)Stream[0]);
+        L.C[3] = _mm_set1_epi32((int)Stream[1]);
+
+        Philox4x32_SSE(L, Key);
+
+        // Transpose so that each register holds the four words of one block
+        __m128i T0 = _mm_unpacklo_epi32(L.C[0], L.C[1]);
+        __m128i T1 = _mm_unpacklo_epi32(L.C[2], L.C[3]);
+        __m128i T2 = _mm_unpackhi_epi32(L.C[0], L.C[1]);
+        __m128i T3 = _mm_unpackhi_epi32(L.C[2], L.C[3]);
+        Out[0] = _mm_unpacklo_epi64(T0, T1);
+        Out[1] = _mm_unpackhi_epi64(T0, T1);
+        Out[2] = _mm_unpacklo_epi64(T2, T3);
+        Out[3] = _mm_unpackhi_epi64(T2, T3);
+    }
+}
+
+void RandomNumberGenerator::Philox4x32( const uint32_t Counter[4], const uint32_t Key[2], uint32_t Result[4] )
+{
+    uint32_t C0 = Counter[0], C1 = Counter[1], C2 = Counter[2], C3 = Counter[3];
+    uint32_t K0 = Key[0], K1 = Key[1];
+
+    for (uint32_t Round = 0; Round < 10; ++Round)
+    {
+        uint64_t P0 = (uint64_t)kPhiloxM0 * C0;
+        uint64_t P1 = (uint64_t)kPhiloxM1 * C2;
+        C0 = (uint32_t)(P1 >> 32) ^ C1 ^ K0;
+        C1 = (uint32_t)P1;
+        C2 = (uint32_t)(P0 >> 32) ^ C3 ^ K1;
+        C3 = (uint32_t)P0;
+        K0 += kPhiloxW0;
+        K1 += kPhiloxW1;
+    }
+
+    Result[0] = C0;
+    Result[1] = C1;
+    Result[2] = C2;
+    Result[3] = C3;
+}
+
+void RandomNumberGenerator::Fill( uint32_t* Dest, size_t Count )
+{
+    // Drain the partially consumed block so that the bulk path starts on a block boundary
+    while (Count > 0 && m_BlockPos < 4)
+    {
+        *Dest++ = m_Block[m_BlockPos++];
+        --Count;
+    }
+
+    for (; Count >= 16; Count -= 16, Dest += 16, m_Counter += 4)
+    {
+        __m128i Blocks[4];
+        GenerateFourBlocks(m_Counter, m_Stream, m_Key, Blocks);
+        for (uint32_t i = 0; i < 4; ++i)
+            _mm_storeu_si128((__m128i*)Dest + i, Blocks[i]);
+    }
+
+    while (Count-- > 0)
+        *Dest++ = NextUint();
+}
+
+void RandomNumberGenerator::Fill( float* Dest, size_t Count, float MinVal, float MaxVal )
+{
+    while (Count > 0 && m_BlockPos < 4)
+    {
+        *Dest++ = NextFloat(MinVal, MaxVal);
+        --Count;
+    }
+
+    // Matches ToUnitFloat() followed by MinVal + f * (MaxVal - MinVal)
+    const __m128 Scale = _mm_set1_ps(1.0f / 16777216.0f);
+    const __m128 Range = _mm_set1_ps(MaxVal - MinVal);
+    const __m128 Bias = _mm_set1_ps(MinVal);
+
+    for (; Count >= 16; Count -= 16, Dest += 16, m_Counter += 4)
+    {
+        __m128i Blocks[4];
+        GenerateFourBlocks(m_Counter, m_Stream, m_Key, Blocks);
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            __m128 Unit = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(Blocks[i], 8)), Scale);
+            _mm_storeu_ps(Dest + i * 4, _mm_add_ps(Bias, _mm_mul_ps(Unit, Range)));
+        }
+    }
+
+    while (Count-- > 0)
+        *Dest++ = NextFloat(MinVal, MaxVal);
+}
+
+#define RNG_TEST( cond, msg ) \
+    if (!(cond)) { Utility::Printf("RandomNumberGenerator test failed: %s\n", msg); return false; }
+
+bool Math::TestRandomNumberGenerator( void )
+{
+    // Known answers from the Random123 test vectors
+    {
+        const uint32_t ZeroCtr[4] = { 0, 0, 0, 0 };
+        const uint32_t ZeroKey[2] = { 0, 0 };
+        const uint32_t ZeroExpected[4] = { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 };
+
+        const uint32_t OnesCtr[4] = { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff };
+        const uint32_t OnesKey[2] = { 0xffffffff, 0xffffffff };
+        const uint32_t OnesExpected[4] = { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd };
+
+        uint32_t Result[4];
+        RandomNumberGenerator::Philox4x32(ZeroCtr, ZeroKey, Result);
+        RNG_TEST(memcmp(Result, ZeroExpected, sizeof(Result)) == 0, "Philox known answer (zero)");
+        RandomNumberGenerator::Philox4x32(OnesCtr, OnesKey, Result);
+        RNG_TEST(memcmp(Result, OnesExpected, sizeof(Result)) == 0, "Philox known answer (ones)");
+    }
+
+    // Bulk fills must match the scalar sequence from any starting offset, and Seek() must agree with both
+    {
+        const size_t Count = 1000;
+        std::vector<uint32_t> Scalar(Count + 7), Bulk(Count);
+        RandomNumberGenerator A(1234, 5);
+        for (size_t i = 0; i < Scalar.size(); ++i)
+            Scalar[i] = A.NextUint();
+
+        for (uint32_t Offset = 0; Offset < 8; ++Offset)
+        {
+            RandomNumberGenerator B(1234, 5);
+            B.Seek(Offset);
+            B.Fill(Bulk.data(), Count - Offset);
+            RNG_TEST(memcmp(Bulk.data(), Scalar.data() + Offset, (Count - Offset) * sizeof(uint32_t)) == 0, "Fill(uint32_t*) differs from NextUint()");
+            RNG_TEST(B.NextUint() == Scalar[Count], "Fill(uint32_t*) advanced the generator incorrectly");
+        }
+
+        std::vector<float> ScalarF(Count), BulkF(Count);
+        RandomNumberGenerator C(99), D(99);
+        for (size_t i = 0; i < Count; ++i)
+            ScalarF[i] = C.NextFloat(-2.0f, 3.0f);
+        D.NextFloat();
+        D.Seek(0);
+        D.Fill(BulkF.data(), Count, -2.0f, 3.0f);
+        RNG_TEST(memcmp(ScalarF.data(), BulkF.data(), Count * sizeof(float)) == 0, "Fill(float*) differs from NextFloat()");
+    }
+
+    // Streams are reproducible and distinct
+    {
+        RandomNumberGenerator A(42, 0), B(42, 0), C(42, 1), D(43, 0);
+        uint32_t Same = 0, CrossStream = 0, CrossSeed = 0;
+        for (uint32_t i = 0; i < 1024; ++i)
+        {
+            uint32_t a = A.NextUint();
+            Same += a == B.NextUint();
+            CrossStream += a == C.NextUint();
+            CrossSeed += a == D.NextUint();
+        }
+        RNG_TEST(Same == 1024, "Same seed and stream produced different sequences");
+        RNG_TEST(CrossStream < 2 && CrossSeed < 2, "Different streams or seeds produced correlated sequences");
+    }
+
+    // Statistical checks:  chi-square over 256 bins (99.9% critical value for 255 dof is ~330.5),
+    // mean, and lag-1 serial correlation of unit floats.
+    {
+        const uint32_t NumSamples = 1 << 22;
+        const uint32_t NumBins = 256;
+        std::vector<float> Samples(NumSamples);
+        RandomNumberGenerator R(0x5EED);
+        R.Fill(Samples.data(), NumSamples);
+
+        uint32_t Bins[NumBins] = {};
+        double Sum = 0.0, SumLag = 0.0, SumSq = 0.0;
+        for (uint32_t i = 0; i < NumSamples; ++i)
+        {
+            float x = Samples[i];
+            RNG_TEST(x >= 0.0f && x < 1.0f, "Unit float out of range");
+            ++Bins[(uint32_t)(x * NumBins)];
+            Sum += x;
+            SumSq += x * x;
+            if (i > 0)
+                SumLag += (double)x * Samples[i - 1];
+        }
+
+        const double Expected = (double)NumSamples / NumBins;
+        double ChiSq = 0.0;
+        for (uint32_t i = 0; i < NumBins; ++i)
+            ChiSq += (Bins[i] - Expected) * (Bins[i] - Expected) / Expected;
+
+        const double Mean = Sum / NumSamples;
+        const double Variance = SumSq / NumSamples - Mean * Mean;
+        const double Correlation = (SumLag / (NumSamples - 1) - Mean * Mean) / Variance;
+
+        Utility::Printf("RandomNumberGenerator: chi-square %.1f, mean %.5f, serial correlation %.5f\n", ChiSq, Mean, Correlation);
+        RNG_TEST(ChiSq < 330.5, "Chi-square test failed");
+        RNG_TEST(fabs(Mean - 0.5) < 0.001, "Mean test failed");
+        RNG_TEST(fabs(Correlation) < 0.003, "Serial correlation test failed");
+
+        // Integer ranges must cover both ends and nothing outside
+        RandomNumberGenerator I(7);
+        uint32_t Hits[7] = {};
+        for (uint32_t i = 0; i < 70000; ++i)
+        {
+            int32_t v = I.NextInt(-3, 3);
+            RNG_TEST(v >= -3 && v <= 3, "NextInt out of range");
+            ++Hits[v + 3];
+        }
+        for (uint32_t i = 0; i < 7; ++i)
+            RNG_TEST(Hits[i] > 9000 && Hits[i] < 11000, "NextInt distribution is biased");
+    }
+
+    return true;
+}
+
+void Math::BenchmarkRandomNumberGenerator( void )
+{
+    const uint32_t Count = 1 << 24;
+    std::vector<float> Buffer(Count);
+    float Sink = 0.0f;
+
+    auto Report = [&]( const char* Name, int64_t Start )
+    {
+        double Seconds = SystemTime::TimeBetweenTicks(Start, SystemTime::GetCurrentTick());
+        Utility::Printf("  %-28s %7.2f ns/value  %8.1f M values/s\n", Name, Seconds * 1e9 / Count, Count / Seconds * 1e-6);
+    };
+
+    Utility::Printf("RandomNumberGenerator throughput (%u floats):\n", Count);
+
+    {
+        std::minstd_rand Gen(1);
+        int64_t Start = SystemTime::GetCurrentTick();
+        for (uint32_t i = 0; i < Count; ++i)
+            Buffer[i] = std::uniform_real_distribution<float>(0.0f, 1.0f)(Gen);
+        Report("std::minstd_rand", Start);
+    }
+
+    {
+        RandomNumberGenerator Gen(1);
+        int64_t Start = SystemTime::GetCurrentTick();
+        for (uint32_t i = 0; i < Count; ++i)
+            Buffer[i] = Gen.NextFloat();
+        Report("NextFloat()", Start);
+        Sink += Buffer[Count - 1];
+    }
+
+    {
+        RandomNumberGenerator Gen(1);
+        int64_t Start = SystemTime::GetCurrentTick();
+        Gen.Fill(Buffer.data(), Count);
+        Report("Fill(float*) SSE2", Start);
+        Sink += Buffer[Count - 1];
+    }
+
+    Utility::Printf("  (checksum %f)\n", Sink);
+}
@@ -18,50 +18,139 @@
 
 namespace Math
 {
+    // A counter-based generator (Philox4x32-10).  Each value is a pure function of (seed, stream, index), so
+    // a sequence can be reproduced exactly from its seed and stream, independent streams can be handed to
+    // different threads or tasks without synchronization, and bulk fills can generate many blocks in
+    // parallel with SIMD.  A generator instance is not thread-safe; give each thread (or better, each task,
+    // to be independent of thread count) its own stream.
     class RandomNumberGenerator
     {
     public:
-        RandomNumberGenerator() : m_gen(m_rd())
+        // Seeded from std::random_device.  The sequence is not reproducible.
+        RandomNumberGenerator()
         {
+            std::random_device rd;
+            SetSeed(((uint64_t)rd() << 32) | rd(), 0);
+        }
+
+        explicit RandomNumberGenerator( uint64_t Seed, uint64_t Stream = 0 )
+        {
+            SetSeed(Seed, Stream);
+        }
+
+        // Uniformly distributed 32-bit value
+        uint32_t NextUint( void )
+        {
+            if (m_BlockPos == 4)
+                RefillBlock();
+            return m_Block[m_BlockPos++];
         }
 
         // Default int range is [MIN_INT, MAX_INT].  Max value is included.
         int32_t NextInt( void )
         {
-            return std::uniform_int_distribution<int32_t>(0x80000000, 0x7FFFFFFF)(m_gen);
+            return (int32_t)NextUint();
         }
 
         int32_t NextInt( int32_t MaxVal )
         {
-            return std::uniform_int_distribution<int32_t>(0, MaxVal)(m_gen);
+            return NextInt(0, MaxVal);
         }
 
         int32_t NextInt( int32_t MinVal, int32_t MaxVal )
         {
-            return std::uniform_int_distribution<int32_t>(MinVal, MaxVal)(m_gen);
+            // Lemire's multiply-and-reject method for an unbiased value in [0, Range)
+            const uint32_t Range = (uint32_t)MaxVal - (uint32_t)MinVal + 1;
+            if (Range == 0)
+                return (int32_t)NextUint();
+
+            uint64_t Product = (uint64_t)NextUint() * Range;
+            if ((uint32_t)Product < Range)
+            {
+                const uint32_t Threshold = (0u - Range) % Range;
+                while ((uint32_t)Product < Threshold)
+                    Product = (uint64_t)NextUint() * Range;
+            }
+            return (int32_t)((uint32_t)MinVal + (uint32_t)(Product >> 32));
         }
 
         // Default float range is [0.0f, 1.0f).  Max value is excluded.
         float NextFloat( float MaxVal = 1.0f )
         {
-            return std::uniform_real_distribution<float>(0.0f, MaxVal)(m_gen);
+            return ToUnitFloat(NextUint()) * MaxVal;
         }
 
         float NextFloat( float MinVal, float MaxVal )
         {
-            return std::uniform_real_distribution<float>(MinVal, MaxVal)(m_gen);
+            return MinVal + ToUnitFloat(NextUint()) * (MaxVal - MinVal);
+        }
+
+        // Bulk generation.  These produce exactly the values that the same number of NextUint() or
+        // NextFloat() calls would have produced, and advance the generator by the same amount.
+        void Fill( uint32_t* Dest, size_t Count );
+        void Fill( float* Dest, size_t Count, float MinVal = 0.0f, float MaxVal = 1.0f );
+
+        // Restarts the sequence of the current stream
+        void SetSeed( uint64_t Seed )
+        {
+            SetSeed(Seed, ((uint64_t)m_Stream[1] << 32) | m_Stream[0]);
         }
 
-        void SetSeed( UINT s )
+        void SetSeed( uint64_t Seed, uint64_t Stream )
         {
-            m_gen.seed(s);
+            m_Key[0] = (uint32_t)Seed;
+            m_Key[1] = (uint32_t)(Seed >> 32);
+            m_Stream[0] = (uint32_t)Stream;
+            m_Stream[1] = (uint32_t)(Stream >> 32);
+            Seek(0);
         }
 
+        // Jumps to the Nth value of the current stream in constant time
+        void Seek( uint64_t Index )
+        {
+            m_Counter = Index / 4;
+            m_BlockPos = 4;
+            if (Index % 4 != 0)
+            {
+                RefillBlock();
+                m_BlockPos = (uint32_t)(Index % 4);
+            }
+        }
+
+        // Computes one Philox4x32-10 block.  Exposed for testing against known answers.
+        static void Philox4x32( const uint32_t Counter[4], const uint32_t Key[2], uint32_t Result[4] );
+
     private:
 
-        std::random_device m_rd;
-        std::minstd_rand m_gen;
+        static float ToUnitFloat( uint32_t Bits )
+        {
+            // Use the top 24 bits so that every value is exactly representable and 1.0f is never returned
+            return (float)(Bits >> 8) * (1.0f / 16777216.0f);
+        }
+
+        void RefillBlock( void )
+        {
+            const uint32_t Counter[4] = { (uint32_t)m_Counter, (uint32_t)(m_Counter >> 32), m_Stream[0], m_Stream[1] };
+            Philox4x32(Counter, m_Key, m_Block);
+            ++m_Counter;
+            m_BlockPos = 0;
+        }
+
+        uint32_t m_Key[2];
+        uint32_t m_Stream[2];
+        uint64_t m_Counter;     // Index of the next block to generate
+        uint32_t m_Block[4];    // Most recently generated block
+        uint32_t m_BlockPos;    // Next unconsumed value in m_Block (4 when empty)
     };
 
+    // A shared generator for main-thread convenience.  Worker threads must not use it; construct a
+    // RandomNumberGenerator with a per-task stream instead.
     extern RandomNumberGenerator g_RNG;
+
+    // Verifies known-answer vectors, SIMD/scalar agreement, stream reproducibility and basic statistical
+    // properties.  Returns false (and prints the failure) if any check fails.
+    bool TestRandomNumberGenerator( void );
+
+    // Prints throughput of scalar and bulk generation compared to std::minstd_rand.
+    void BenchmarkRandomNumberGenerator( void );
 };
@@ -0,0 +1,1211 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "NullDevice.h"
+#include "DDSTextureLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+using Math::AlignUp;
+
+namespace
+{
+    std::atomic<uint64_t> s_NumExecutedCommandLists(0);
+    std::atomic<uint64_t> s_NumExecutedCommands(0);
+    std::atomic<uint64_t> s_NumExecutedBytes(0);
+
+    // Every descriptor is this big, whatever the heap type.  A view writes what it was created from into
+    // its descriptor, so that copying descriptors moves real data.
+    const UINT kDescriptorSize = 32;
+
+    struct NullDescriptor
+    {
+        enum ViewType : uint32_t { kCBV = 1, kSRV, kUAV, kRTV, kDSV, kSampler };
+
+        uint32_t Type;
+        uint32_t Format;
+        ID3D12Resource* pResource;
+        D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+    };
+    static_assert(sizeof(NullDescriptor) <= kDescriptorSize, "A view must fit in its descriptor");
+
+    void WriteDescriptor( D3D12_CPU_DESCRIPTOR_HANDLE Handle, uint32_t Type, DXGI_FORMAT Format,
+        ID3D12Resource* pResource, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation = 0 )
+    {
+        NullDescriptor* pDescriptor = reinterpret_cast<NullDescriptor*>(Handle.ptr);
+        pDescriptor->Type = Type;
+        pDescriptor->Format = (uint32_t)Format;
+        pDescriptor->pResource = pResource;
+        pDescriptor->BufferLocation = BufferLocation;
+    }
+
+    bool IsBlockCompressed( DXGI_FORMAT Format )
+    {
+        return (Format >= DXGI_FORMAT_BC1_TYPELESS && Format <= DXGI_FORMAT_BC5_SNORM) ||
+            (Format >= DXGI_FORMAT_BC6H_TYPELESS && Format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+    }
+
+    UINT GetMipLevels( const D3D12_RESOURCE_DESC& Desc )
+    {
+        if (Desc.MipLevels != 0)
+            return Desc.MipLevels;
+
+        UINT64 LargestSize = std::max<UINT64>(Desc.Width, Desc.Height);
+        if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+            LargestSize = std::max<UINT64>(LargestSize, Desc.DepthOrArraySize);
+
+        UINT MipLevels = 1;
+        while (LargestSize >>= 1)
+            ++MipLevels;
+        return MipLevels;
+    }
+
+    UINT GetNumSubresources( const D3D12_RESOURCE_DESC& Desc )
+    {
+        if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            return 1;
+        if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+            return GetMipLevels(Desc);
+        return GetMipLevels(Desc) * Desc.DepthOrArraySize;
+    }
+
+    // Lays subresources out in a buffer the way devices do:  rows are pitched to 256 bytes, and every
+    // subresource starts on a 512 byte boundary.  Returns the number of bytes from the first subresource
+    // to the end of the last one.  Planar formats are laid out as their first plane.
+    UINT64 GetFootprints( const D3D12_RESOURCE_DESC& Desc, UINT FirstSubresource, UINT NumSubresources,
+        UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes )
+    {
+        if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            ASSERT(FirstSubresource == 0 && NumSubresources <= 1);
+            if (NumSubresources == 0)
+                return 0;
+
+            if (pLayouts != nullptr)
+            {
+                pLayouts->Offset = BaseOffset;
+                pLayouts->Footprint.Format = DXGI_FORMAT_UNKNOWN;
+                pLayouts->Footprint.Width = (UINT)Desc.Width;
+                pLayouts->Footprint.Height = 1;
+                pLayouts->Footprint.Depth = 1;
+                pLayouts->Footprint.RowPitch = (UINT)AlignUp(Desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+            }
+            if (pNumRows != nullptr)
+                *pNumRows = 1;
+            if (pRowSizeInBytes != nullptr)
+                *pRowSizeInBytes = Desc.Width;
+            return Desc.Width;
+        }
+
+        // Formats the loader doesn't know are taken to be 32 bits per pixel
+        const bool BlockCompressed = IsBlockCompressed(Desc.Format);
+        const UINT BlockSize = BlockCompressed ? 4 : 1;
+        const size_t Bits = BitsPerPixel(Desc.Format);
+        const UINT64 BitsPerElement = Bits == 0 ? 32 : Bits;
+        const UINT64 BytesPerBlock = BlockCompressed ? BitsPerElement * 2 : (BitsPerElement + 7) / 8;
+        const UINT MipLevels = GetMipLevels(Desc);
+
+        UINT64 Offset = 0;
+        UINT64 TotalBytes = 0;
+
+        for (UINT i = 0; i < NumSubresources; ++i)
+        {
+            const UINT Mip = (FirstSubresource + i) % MipLevels;
+            const UINT Width = std::max(1u, (UINT)(Desc.Width >> Mip));
+            const UINT Height = std::max(1u, Desc.Height >> Mip);
+            const UINT Depth = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ?
+                std::max(1u, (UINT)Desc.DepthOrArraySize >> Mip) : 1;
+
+            const UINT NumRows = (Height + BlockSize - 1) / BlockSize;
+            const UINT64 RowSize = (Width + BlockSize - 1) / BlockSize * BytesPerBlock;
+            const UINT64 RowPitch = AlignUp(RowSize, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+
+            Offset = AlignUp(Offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+            if (pLayouts != nullptr)
+            {
+                pLayouts[i].Offset = BaseOffset + Offset;
+                pLayouts[i].Footprint.Format = Desc.Format;
+                pLayouts[i].Footprint.Width = AlignUp(Width, BlockSize);
+                pLayouts[i].Footprint.Height = AlignUp(Height, BlockSize);
+                pLayouts[i].Footprint.Depth = Depth;
+                pLayouts[i].Footprint.RowPitch = (UINT)RowPitch;
+            }
+            if (pNumRows != nullptr)
+                pNumRows[i] = NumRows;
+            if (pRowSizeInBytes != nullptr)
+                pRowSizeInBytes[i] = RowSize;
+
+            TotalBytes = Offset + RowPitch * (NumRows * Depth - 1) + RowSize;
+            Offset += RowPitch * NumRows * Depth;
+        }
+
+        return TotalBytes;
+    }
+
+    UINT64 GetAllocationSize( const D3D12_RESOURCE_DESC& Desc )
+    {
+        UINT64 Size = GetFootprints(Desc, 0, GetNumSubresources(Desc), 0, nullptr, nullptr, nullptr);
+        Size *= std::max(1u, Desc.SampleDesc.Count);
+        return AlignUp(Size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+    }
+
+    UINT64 GetAllocationAlignment( const D3D12_RESOURCE_DESC& Desc )
+    {
+        if (Desc.Alignment != 0)
+            return Desc.Alignment;
+        return Desc.SampleDesc.Count > 1 ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    }
+
+    bool IsCpuVisible( const D3D12_HEAP_PROPERTIES& Properties )
+    {
+        if (Properties.Type == D3D12_HEAP_TYPE_CUSTOM)
+            return Properties.CPUPageProperty != D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE;
+        return Properties.Type == D3D12_HEAP_TYPE_UPLOAD || Properties.Type == D3D12_HEAP_TYPE_READBACK;
+    }
+
+    // Zeroed system memory aligned like a placed resource, so that buffers read back as zeros and GPU
+    // virtual addresses have the alignment views expect.
+    uint8_t* AllocateMemory( UINT64 Size )
+    {
+        void* pMemory = _aligned_malloc((size_t)Size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+        ASSERT(pMemory != nullptr, "Out of memory backing a null device object");
+        ZeroMemory(pMemory, (size_t)Size);
+        return (uint8_t*)pMemory;
+    }
+
+    template <typename Interface>
+    class NullObject : public Interface
+    {
+    public:
+        NullObject() : m_RefCount(1) {}
+        virtual ~NullObject() {}
+
+        HRESULT STDMETHODCALLTYPE QueryInterface( REFIID riid, void** ppvObject ) override
+        {
+            if (ppvObject == nullptr)
+                return E_POINTER;
+
+            if (riid == __uuidof(Interface) || riid == __uuidof(ID3D12Object) || riid == __uuidof(IUnknown) || IsBaseInterface(riid))
+            {
+                *ppvObject = static_cast<Interface*>(this);
+                AddRef();
+                return S_OK;
+            }
+
+            *ppvObject = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef( void ) override
+        {
+            return ++m_RefCount;
+        }
+
+        ULONG STDMETHODCALLTYPE Release( void ) override
+        {
+            ULONG RefCount = --m_RefCount;
+            if (RefCount == 0)
+                delete this;
+            return RefCount;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetPrivateData( REFGUID, UINT*, void* ) override { return DXGI_ERROR_NOT_FOUND; }
+        HRESULT STDMETHODCALLTYPE SetPrivateData( REFGUID, UINT, const void* ) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE SetPrivateDataInterface( REFGUID, const IUnknown* ) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE SetName( LPCWSTR ) override { return S_OK; }
+
+    protected:
+        // The interfaces between Interface and ID3D12Object, which all share its vtable
+        virtual bool IsBaseInterface( REFIID ) const { return false; }
+
+    private:
+        std::atomic<ULONG> m_RefCount;
+    };
+
+    // Children point back at their device without holding a reference, since the engine releases the
+    // device last.
+    template <typename Interface>
+    class NullDeviceChild : public NullObject<Interface>
+    {
+    public:
+        NullDeviceChild( ID3D12Device* pDevice ) : m_pDevice(pDevice) {}
+
+        HRESULT STDMETHODCALLTYPE GetDevice( REFIID riid, void** ppvDevice ) override
+        {
+            return m_pDevice->QueryInterface(riid, ppvDevice);
+        }
+
+    protected:
+        bool IsBaseInterface( REFIID riid ) const override
+        {
+            return riid == __uuidof(ID3D12DeviceChild) || riid == __uuidof(ID3D12Pageable);
+        }
+
+        ID3D12Device* m_pDevice;
+    };
+
+    class NullHeap : public NullDeviceChild<ID3D12Heap>
+    {
+    public:
+        // Heaps that can't hold buffers and aren't CPU visible only ever hold textures, so they get no memory.
+        NullHeap( ID3D12Device* pDevice, const D3D12_HEAP_DESC& Desc ) : NullDeviceChild(pDevice), m_Desc(Desc),
+            m_pMemory((Desc.Flags & D3D12_HEAP_FLAG_DENY_BUFFERS) == 0 || IsCpuVisible(Desc.Properties) ?
+                AllocateMemory(Desc.SizeInBytes) : nullptr)
+        {
+        }
+
+        ~NullHeap()
+        {
+            _aligned_free(m_pMemory);
+        }
+
+        D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc( void ) override { return m_Desc; }
+
+        uint8_t* GetMemory( void ) const { return m_pMemory; }
+
+    private:
+        D3D12_HEAP_DESC m_Desc;
+        uint8_t* m_pMemory;
+    };
+
+    class NullResource : public NullDeviceChild<ID3D12Resource>
+    {
+    public:
+        // A committed resource when pHeap is null.  Its memory is its own if it's a buffer or CPU visible.
+        NullResource( ID3D12Device* pDevice, const D3D12_RESOURCE_DESC& Desc, const D3D12_HEAP_PROPERTIES& HeapProperties,
+            D3D12_HEAP_FLAGS HeapFlags, NullHeap* pHeap, UINT64 HeapOffset )
+            : NullDeviceChild(pDevice), m_Desc(Desc), m_HeapProperties(HeapProperties), m_HeapFlags(HeapFlags),
+            m_pHeap(pHeap), m_pMemory(nullptr), m_OwnsMemory(false)
+        {
+            m_Desc.MipLevels = (UINT16)GetMipLevels(Desc);
+
+            if (m_pHeap != nullptr)
+            {
+                m_pHeap->AddRef();
+                if (m_pHeap->GetMemory() != nullptr)
+                {
+                    ASSERT(m_Desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER || HeapOffset + m_Desc.Width <= m_pHeap->GetDesc().SizeInBytes);
+                    m_pMemory = m_pHeap->GetMemory() + HeapOffset;
+                }
+            }
+            else if (m_Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER || IsCpuVisible(m_HeapProperties))
+            {
+                m_pMemory = AllocateMemory(GetAllocationSize(m_Desc));
+                m_OwnsMemory = true;
+            }
+        }
+
+        ~NullResource()
+        {
+            if (m_OwnsMemory)
+                _aligned_free(m_pMemory);
+            if (m_pHeap != nullptr)
+                m_pHeap->Release();
+        }
+
+        // Every subresource maps to the start of the resource, which is all buffers need.
+        HRESULT STDMETHODCALLTYPE Map( UINT, const D3D12_RANGE*, void** ppData ) override
+        {
+            if (m_pMemory == nullptr)
+                return E_INVALIDARG;
+            if (ppData != nullptr)
+                *ppData = m_pMemory;
+            return S_OK;
+        }
+
+        void STDMETHODCALLTYPE Unmap( UINT, const D3D12_RANGE* ) override {}
+
+        D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc( void ) override { return m_Desc; }
+
+        D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress( void ) override
+        {
+            if (m_Desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+                return D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+            return (D3D12_GPU_VIRTUAL_ADDRESS)m_pMemory;
+        }
+
+        HRESULT STDMETHODCALLTYPE WriteToSubresource( UINT, const D3D12_BOX*, const void*, UINT, UINT ) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE ReadFromSubresource( void*, UINT, UINT, UINT, const D3D12_BOX* ) override { return E_NOTIMPL; }
+
+        HRESULT STDMETHODCALLTYPE GetHeapProperties( D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags ) override
+        {
+            if (pHeapProperties != nullptr)
+                *pHeapProperties = m_HeapProperties;
+            if (pHeapFlags != nullptr)
+                *pHeapFlags = m_HeapFlags;
+            return S_OK;
+        }
+
+    private:
+        D3D12_RESOURCE_DESC m_Desc;
+        D3D12_HEAP_PROPERTIES m_HeapProperties;
+        D3D12_HEAP_FLAGS m_HeapFlags;
+        NullHeap* m_pHeap;
+        uint8_t* m_pMemory;
+        bool m_OwnsMemory;
+    };
+
+    class NullDescriptorHeap : public NullDeviceChild<ID3D12DescriptorHeap>
+    {
+    public:
+        NullDescriptorHeap( ID3D12Device* pDevice, const D3D12_DESCRIPTOR_HEAP_DESC& Desc )
+            : NullDeviceChild(pDevice), m_Desc(Desc), m_pMemory(AllocateMemory((UINT64)Desc.NumDescriptors * kDescriptorSize))
+        {
+        }
+
+        ~NullDescriptorHeap()
+        {
+            _aligned_free(m_pMemory);
+        }
+
+        D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc( void ) override { return m_Desc; }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart( void ) override
+        {
+            D3D12_CPU_DESCRIPTOR_HANDLE Handle = { (SIZE_T)m_pMemory };
+            return Handle;
+        }
+
+        // Shader visible heaps share their memory between both kinds of handle.
+        D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart( void ) override
+        {
+            D3D12_GPU_DESCRIPTOR_HANDLE Handle = { 0 };
+            if (m_Desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+                Handle.ptr = (UINT64)m_pMemory;
+            return Handle;
+        }
+
+    private:
+        D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+        uint8_t* m_pMemory;
+    };
+
+    class NullFence : public NullDeviceChild<ID3D12Fence>
+    {
+    public:
+        NullFence( ID3D12Device* pDevice, UINT64 InitialValue ) : NullDeviceChild(pDevice), m_Value(InitialValue) {}
+
+        UINT64 STDMETHODCALLTYPE GetCompletedValue( void ) override
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            return m_Value;
+        }
+
+        // Like a real fence, a null event blocks until the value is reached.
+        HRESULT STDMETHODCALLTYPE SetEventOnCompletion( UINT64 Value, HANDLE hEvent ) override
+        {
+            std::unique_lock<std::mutex> Lock(m_Mutex);
+
+            if (hEvent == nullptr)
+                m_Signaled.wait(Lock, [this, Value] { return m_Value >= Value; });
+            else if (m_Value >= Value)
+                SetEvent(hEvent);
+            else
+                m_Waits.push_back(std::make_pair(Value, hEvent));
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Signal( UINT64 Value ) override
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            m_Value = Value;
+
+            auto Reached = std::partition(m_Waits.begin(), m_Waits.end(),
+                [Value]( const std::pair<UINT64, HANDLE>& Wait ) { return Wait.first > Value; });
+            for (auto It = Reached; It != m_Waits.end(); ++It)
+                SetEvent(It->second);
+            m_Waits.erase(Reached, m_Waits.end());
+
+            m_Signaled.notify_all();
+            return S_OK;
+        }
+
+    private:
+        std::mutex m_Mutex;
+        std::condition_variable m_Signaled;
+        UINT64 m_Value;
+        std::vector<std::pair<UINT64, HANDLE>> m_Waits;
+    };
+
+    class NullCommandAllocator : public NullDeviceChild<ID3D12CommandAllocator>
+    {
+    public:
+        NullCommandAllocator( ID3D12Device* pDevice ) : NullDeviceChild(pDevice) {}
+
+        HRESULT STDMETHODCALLTYPE Reset( void ) override { return S_OK; }
+    };
+
+    class NullPipelineState : public NullDeviceChild<ID3D12PipelineState>
+    {
+    public:
+        NullPipelineState( ID3D12Device* pDevice ) : NullDeviceChild(pDevice) {}
+
+        HRESULT STDMETHODCALLTYPE GetCachedBlob( ID3DBlob** ppBlob ) override
+        {
+            *ppBlob = nullptr;
+            return E_NOTIMPL;
+        }
+    };
+
+    class NullRootSignature : public NullDeviceChild<ID3D12RootSignature>
+    {
+    public:
+        NullRootSignature( ID3D12Device* pDevice ) : NullDeviceChild(pDevice) {}
+    };
+
+    class NullQueryHeap : public NullDeviceChild<ID3D12QueryHeap>
+    {
+    public:
+        NullQueryHeap( ID3D12Device* pDevice ) : NullDeviceChild(pDevice) {}
+    };
+
+    class NullCommandSignature : public NullDeviceChild<ID3D12CommandSignature>
+    {
+    public:
+        NullCommandSignature( ID3D12Device* pDevice ) : NullDeviceChild(pDevice) {}
+    };
+
+    enum class NullCommand : uint32_t
+    {
+        ClearState, DrawInstanced, DrawIndexedInstanced, Dispatch, CopyBufferRegion, CopyTextureRegion,
+        CopyResource, CopyTiles, ResolveSubresource, IASetPrimitiveTopology, RSSetViewports, RSSetScissorRects,
+        OMSetBlendFactor, OMSetStencilRef, SetPipelineState, ResourceBarrier, ExecuteBundle, SetDescriptorHeaps,
+        SetComputeRootSignature, SetGraphicsRootSignature, SetComputeRootDescriptorTable,
+        SetGraphicsRootDescriptorTable, SetComputeRoot32BitConstants, SetGraphicsRoot32BitConstants,
+        SetComputeRootConstantBufferView, SetGraphicsRootConstantBufferView, SetComputeRootShaderResourceView,
+        SetGraphicsRootShaderResourceView, SetComputeRootUnorderedAccessView, SetGraphicsRootUnorderedAccessView,
+        IASetIndexBuffer, IASetVertexBuffers, SOSetTargets, OMSetRenderTargets, ClearDepthStencilView,
+        ClearRenderTargetView, ClearUnorderedAccessViewUint, ClearUnorderedAccessViewFloat, DiscardResource,
+        BeginQuery, EndQuery, ResolveQueryData, SetPredication, SetMarker, BeginEvent, EndEvent, ExecuteIndirect
+    };
+
+    // Records each command into a byte stream as its opcode and size, followed by its arguments and the
+    // arrays they point to.  The stream keeps its memory across resets, as an allocator would.
+    class NullGraphicsCommandList : public NullDeviceChild<ID3D12GraphicsCommandList>
+    {
+    public:
+        NullGraphicsCommandList( ID3D12Device* pDevice, D3D12_COMMAND_LIST_TYPE Type, ID3D12PipelineState* pInitialState )
+            : NullDeviceChild(pDevice), m_Type(Type), m_NumCommands(0), m_IsClosed(false)
+        {
+            Reset(nullptr, pInitialState);
+        }
+
+        uint32_t GetNumCommands( void ) const { return m_NumCommands; }
+        const std::vector<uint8_t>& GetStream( void ) const { return m_Stream; }
+
+        void Execute( void ) const
+        {
+            ASSERT(m_IsClosed, "Executing a command list that is still recording");
+            ++s_NumExecutedCommandLists;
+            s_NumExecutedCommands += m_NumCommands;
+            s_NumExecutedBytes += m_Stream.size();
+        }
+
+        D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType( void ) override { return m_Type; }
+
+        HRESULT STDMETHODCALLTYPE Close( void ) override
+        {
+            if (m_IsClosed)
+                return E_FAIL;
+            m_IsClosed = true;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Reset( ID3D12CommandAllocator*, ID3D12PipelineState* pInitialState ) override
+        {
+            m_Stream.clear();
+            m_NumCommands = 0;
+            m_IsClosed = false;
+            if (pInitialState != nullptr)
+                Record(NullCommand::SetPipelineState, pInitialState);
+            return S_OK;
+        }
+
+        void STDMETHODCALLTYPE ClearState( ID3D12PipelineState* pPipelineState ) override
+        {
+            Record(NullCommand::ClearState, pPipelineState);
+        }
+
+        void STDMETHODCALLTYPE DrawInstanced( UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation ) override
+        {
+            Record(NullCommand::DrawInstanced, VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
+        }
+
+        void STDMETHODCALLTYPE DrawIndexedInstanced( UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation,
+            INT BaseVertexLocation, UINT StartInstanceLocation ) override
+        {
+            Record(NullCommand::DrawIndexedInstanced, IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+        }
+
+        void STDMETHODCALLTYPE Dispatch( UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ ) override
+        {
+            Record(NullCommand::Dispatch, ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
+        }
+
+        void STDMETHODCALLTYPE CopyBufferRegion( ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer, UINT64 SrcOffset, UINT64 NumBytes ) override
+        {
+            Record(NullCommand::CopyBufferRegion, pDstBuffer, DstOffset, pSrcBuffer, SrcOffset, NumBytes);
+        }
+
+        void STDMETHODCALLTYPE CopyTextureRegion( const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT DstX, UINT DstY, UINT DstZ,
+            const D3D12_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX* pSrcBox ) override
+        {
+            Record(NullCommand::CopyTextureRegion, *pDst, DstX, DstY, DstZ, *pSrc, Optional(pSrcBox));
+        }
+
+        void STDMETHODCALLTYPE CopyResource( ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource ) override
+        {
+            Record(NullCommand::CopyResource, pDstResource, pSrcResource);
+        }
+
+        void STDMETHODCALLTYPE CopyTiles( ID3D12Resource* pTiledResource, const D3D12_TILED_RESOURCE_COORDINATE* pTileRegionStartCoordinate,
+            const D3D12_TILE_REGION_SIZE* pTileRegionSize, ID3D12Resource* pBuffer, UINT64 BufferStartOffsetInBytes, D3D12_TILE_COPY_FLAGS Flags ) override
+        {
+            Record(NullCommand::CopyTiles, pTiledResource, *pTileRegionStartCoordinate, *pTileRegionSize, pBuffer, BufferStartOffsetInBytes, Flags);
+        }
+
+        void STDMETHODCALLTYPE ResolveSubresource( ID3D12Resource* pDstResource, UINT DstSubresource, ID3D12Resource* pSrcResource,
+            UINT SrcSubresource, DXGI_FORMAT Format ) override
+        {
+            Record(NullCommand::ResolveSubresource, pDstResource, DstSubresource, pSrcResource, SrcSubresource, Format);
+        }
+
+        void STDMETHODCALLTYPE IASetPrimitiveTopology( D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology ) override
+        {
+            Record(NullCommand::IASetPrimitiveTopology, PrimitiveTopology);
+        }
+
+        void STDMETHODCALLTYPE RSSetViewports( UINT NumViewports, const D3D12_VIEWPORT* pViewports ) override
+        {
+            Record(NullCommand::RSSetViewports, MakeArray(pViewports, NumViewports));
+        }
+
+        void STDMETHODCALLTYPE RSSetScissorRects( UINT NumRects, const D3D12_RECT* pRects ) override
+        {
+            Record(NullCommand::RSSetScissorRects, MakeArray(pRects, NumRects));
+        }
+
+        void STDMETHODCALLTYPE OMSetBlendFactor( const FLOAT BlendFactor[4] ) override
+        {
+            Record(NullCommand::OMSetBlendFactor, MakeArray(BlendFactor, BlendFactor == nullptr ? 0 : 4));
+        }
+
+        void STDMETHODCALLTYPE OMSetStencilRef( UINT StencilRef ) override
+        {
+            Record(NullCommand::OMSetStencilRef, StencilRef);
+        }
+
+        void STDMETHODCALLTYPE SetPipelineState( ID3D12PipelineState* pPipelineState ) override
+        {
+            Record(NullCommand::SetPipelineState, pPipelineState);
+        }
+
+        void STDMETHODCALLTYPE ResourceBarrier( UINT NumBarriers, const D3D12_RESOURCE_BARRIER* pBarriers ) override
+        {
+            Record(NullCommand::ResourceBarrier, MakeArray(pBarriers, NumBarriers));
+        }
+
+        void STDMETHODCALLTYPE ExecuteBundle( ID3D12GraphicsCommandList* pCommandList ) override
+        {
+            Record(NullCommand::ExecuteBundle, pCommandList);
+        }
+
+        void STDMETHODCALLTYPE SetDescriptorHeaps( UINT NumDescriptorHeaps, ID3D12DescriptorHeap* const* ppDescriptorHeaps ) override
+        {
+            Record(NullCommand::SetDescriptorHeaps, MakeArray(ppDescriptorHeaps, NumDescriptorHeaps));
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootSignature( ID3D12RootSignature* pRootSignature ) override
+        {
+            Record(NullCommand::SetComputeRootSignature, pRootSignature);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootSignature( ID3D12RootSignature* pRootSignature ) override
+        {
+            Record(NullCommand::SetGraphicsRootSignature, pRootSignature);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootDescriptorTable( UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor ) override
+        {
+            Record(NullCommand::SetComputeRootDescriptorTable, RootParameterIndex, BaseDescriptor);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable( UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor ) override
+        {
+            Record(NullCommand::SetGraphicsRootDescriptorTable, RootParameterIndex, BaseDescriptor);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRoot32BitConstant( UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues ) override
+        {
+            Record(NullCommand::SetComputeRoot32BitConstants, RootParameterIndex, DestOffsetIn32BitValues, MakeArray(&SrcData, 1));
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant( UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues ) override
+        {
+            Record(NullCommand::SetGraphicsRoot32BitConstants, RootParameterIndex, DestOffsetIn32BitValues, MakeArray(&SrcData, 1));
+        }
+
+        void STDMETHODCALLTYPE SetComputeRoot32BitConstants( UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData,
+            UINT DestOffsetIn32BitValues ) override
+        {
+            Record(NullCommand::SetComputeRoot32BitConstants, RootParameterIndex, DestOffsetIn32BitValues,
+                MakeArray((const UINT*)pSrcData, Num32BitValuesToSet));
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants( UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData,
+            UINT DestOffsetIn32BitValues ) override
+        {
+            Record(NullCommand::SetGraphicsRoot32BitConstants, RootParameterIndex, DestOffsetIn32BitValues,
+                MakeArray((const UINT*)pSrcData, Num32BitValuesToSet));
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootConstantBufferView( UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+        {
+            Record(NullCommand::SetComputeRootConstantBufferView, RootParameterIndex, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView( UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+        {
+            Record(NullCommand::SetGraphicsRootConstantBufferView, RootParameterIndex, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootShaderResourceView( UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+        {
+            Record(NullCommand::SetComputeRootShaderResourceView, RootParameterIndex, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView( UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+        {
+            Record(NullCommand::SetGraphicsRootShaderResourceView, RootParameterIndex, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView( UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+        {
+            Record(NullCommand::SetComputeRootUnorderedAccessView, RootParameterIndex, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView( UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation ) override
+        {
+            Record(NullCommand::SetGraphicsRootUnorderedAccessView, RootParameterIndex, BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE IASetIndexBuffer( const D3D12_INDEX_BUFFER_VIEW* pView ) override
+        {
+            Record(NullCommand::IASetIndexBuffer, Optional(pView));
+        }
+
+        void STDMETHODCALLTYPE IASetVertexBuffers( UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews ) override
+        {
+            Record(NullCommand::IASetVertexBuffers, StartSlot, MakeArray(pViews, pViews == nullptr ? 0 : NumViews));
+        }
+
+        void STDMETHODCALLTYPE SOSetTargets( UINT StartSlot, UINT NumViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews ) override
+        {
+            Record(NullCommand::SOSetTargets, StartSlot, MakeArray(pViews, pViews == nullptr ? 0 : NumViews));
+        }
+
+        void STDMETHODCALLTYPE OMSetRenderTargets( UINT NumRenderTargetDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors,
+            BOOL RTsSingleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor ) override
+        {
+            UINT NumHandles = RTsSingleHandleToDescriptorRange ? std::min(NumRenderTargetDescriptors, 1u) : NumRenderTargetDescriptors;
+            Record(NullCommand::OMSetRenderTargets, NumRenderTargetDescriptors, RTsSingleHandleToDescriptorRange,
+                MakeArray(pRenderTargetDescriptors, pRenderTargetDescriptors == nullptr ? 0 : NumHandles), Optional(pDepthStencilDescriptor));
+        }
+
+        void STDMETHODCALLTYPE ClearDepthStencilView( D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView, D3D12_CLEAR_FLAGS ClearFlags, FLOAT Depth,
+            UINT8 Stencil, UINT NumRects, const D3D12_RECT* pRects ) override
+        {
+            Record(NullCommand::ClearDepthStencilView, DepthStencilView, ClearFlags, Depth, Stencil, MakeArray(pRects, NumRects));
+        }
+
+        void STDMETHODCALLTYPE ClearRenderTargetView( D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView, const FLOAT ColorRGBA[4], UINT NumRects,
+            const D3D12_RECT* pRects ) override
+        {
+            Record(NullCommand::ClearRenderTargetView, RenderTargetView, MakeArray(ColorRGBA, 4), MakeArray(pRects, NumRects));
+        }
+
+        void STDMETHODCALLTYPE ClearUnorderedAccessViewUint( D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+            ID3D12Resource* pResource, const UINT Values[4], UINT NumRects, const D3D12_RECT* pRects ) override
+        {
+            Record(NullCommand::ClearUnorderedAccessViewUint, ViewGPUHandleInCurrentHeap, ViewCPUHandle, pResource,
+                MakeArray(Values, 4), MakeArray(pRects, NumRects));
+        }
+
+        void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat( D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap, D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+            ID3D12Resource* pResource, const FLOAT Values[4], UINT NumRects, const D3D12_RECT* pRects ) override
+        {
+            Record(NullCommand::ClearUnorderedAccessViewFloat, ViewGPUHandleInCurrentHeap, ViewCPUHandle, pResource,
+                MakeArray(Values, 4), MakeArray(pRects, NumRects));
+        }
+
+        void STDMETHODCALLTYPE DiscardResource( ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion ) override
+        {
+            Record(NullCommand::DiscardResource, pResource, Optional(pRegion));
+        }
+
+        void STDMETHODCALLTYPE BeginQuery( ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index ) override
+        {
+            Record(NullCommand::BeginQuery, pQueryHeap, Type, Index);
+        }
+
+        void STDMETHODCALLTYPE EndQuery( ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index ) override
+        {
+            Record(NullCommand::EndQuery, pQueryHeap, Type, Index);
+        }
+
+        void STDMETHODCALLTYPE ResolveQueryData( ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT StartIndex, UINT NumQueries,
+            ID3D12Resource* pDestinationBuffer, UINT64 AlignedDestinationBufferOffset ) override
+        {
+            Record(NullCommand::ResolveQueryData, pQueryHeap, Type, StartIndex, NumQueries, pDestinationBuffer, AlignedDestinationBufferOffset);
+        }
+
+        void STDMETHODCALLTYPE SetPredication( ID3D12Resource* pBuffer, UINT64 AlignedBufferOffset, D3D12_PREDICATION_OP Operation ) override
+        {
+            Record(NullCommand::SetPredication, pBuffer, AlignedBufferOffset, Operation);
+        }
+
+        void STDMETHODCALLTYPE SetMarker( UINT Metadata, const void* pData, UINT Size ) override
+        {
+            Record(NullCommand::SetMarker, Metadata, MakeArray((const uint8_t*)pData, pData == nullptr ? 0 : Size));
+        }
+
+        void STDMETHODCALLTYPE BeginEvent( UINT Metadata, const void* pData, UINT Size ) override
+        {
+            Record(NullCommand::BeginEvent, Metadata, MakeArray((const uint8_t*)pData, pData == nullptr ? 0 : Size));
+        }
+
+        void STDMETHODCALLTYPE EndEvent( void ) override
+        {
+            Record(NullCommand::EndEvent);
+        }
+
+        void STDMETHODCALLTYPE ExecuteIndirect( ID3D12CommandSignature* pCommandSignature, UINT MaxCommandCount, ID3D12Resource* pArgumentBuffer,
+            UINT64 ArgumentBufferOffset, ID3D12Resource* pCountBuffer, UINT64 CountBufferOffset ) override
+        {
+            Record(NullCommand::ExecuteIndirect, pCommandSignature, MaxCommandCount, pArgumentBuffer, ArgumentBufferOffset, pCountBuffer, CountBufferOffset);
+        }
+
+    protected:
+        bool IsBaseInterface( REFIID riid ) const override
+        {
+            return riid == __uuidof(ID3D12CommandList) || riid == __uuidof(ID3D12DeviceChild);
+        }
+
+    private:
+        struct CommandHeader
+        {
+            NullCommand Command;
+            uint32_t Size;
+        };
+
+        template <typename T>
+        struct Array
+        {
+            const T* pData;
+            UINT Count;
+        };
+
+        template <typename T>
+        static Array<T> MakeArray( const T* pData, UINT Count ) { Array<T> Values = { pData, Count }; return Values; }
+
+        template <typename T>
+        static Array<T> Optional( const T* pData ) { return MakeArray(pData, pData == nullptr ? 0 : 1); }
+
+        void Append( const void* pData, size_t Size )
+        {
+            const uint8_t* pBytes = (const uint8_t*)pData;
+            m_Stream.insert(m_Stream.end(), pBytes, pBytes + Size);
+        }
+
+        template <typename T>
+        void AppendArgument( const T& Value )
+        {
+            Append(&Value, sizeof(Value));
+        }
+
+        template <typename T>
+        void AppendArgument( const Array<T>& Values )
+        {
+            Append(&Values.Count, sizeof(Values.Count));
+            if (Values.Count > 0)
+                Append(Values.pData, sizeof(T) * Values.Count);
+        }
+
+        template <typename... Arguments>
+        void Record( NullCommand Command, const Arguments&... Args )
+        {
+            ASSERT(!m_IsClosed, "Recording into a closed command list");
+
+            const size_t Start = m_Stream.size();
+            CommandHeader Header = { Command, 0 };
+            Append(&Header, sizeof(Header));
+
+            int Expand[] = { 0, (AppendArgument(Args), 0)... };
+            (void)Expand;
+
+            reinterpret_cast<CommandHeader*>(&m_Stream[Start])->Size = (uint32_t)(m_Stream.size() - Start);
+            ++m_NumCommands;
+        }
+
+        D3D12_COMMAND_LIST_TYPE m_Type;
+        std::vector<uint8_t> m_Stream;
+        uint32_t m_NumCommands;
+        bool m_IsClosed;
+    };
+
+    // The GPU is infinitely fast:  lists are done as soon as they are executed, and fences are signaled as
+    // soon as they are queued.
+    class NullCommandQueue : public NullDeviceChild<ID3D12CommandQueue>
+    {
+    public:
+        NullCommandQueue( ID3D12Device* pDevice, const D3D12_COMMAND_QUEUE_DESC& Desc ) : NullDeviceChild(pDevice), m_Desc(Desc) {}
+
+        void STDMETHODCALLTYPE UpdateTileMappings( ID3D12Resource*, UINT, const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*,
+            ID3D12Heap*, UINT, const D3D12_TILE_RANGE_FLAGS*, const UINT*, const UINT*, D3D12_TILE_MAPPING_FLAGS ) override {}
+
+        void STDMETHODCALLTYPE CopyTileMappings( ID3D12Resource*, const D3D12_TILED_RESOURCE_COORDINATE*, ID3D12Resource*,
+            const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*, D3D12_TILE_MAPPING_FLAGS ) override {}
+
+        void STDMETHODCALLTYPE ExecuteCommandLists( UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists ) override
+        {
+            for (UINT i = 0; i < NumCommandLists; ++i)
+                static_cast<NullGraphicsCommandList*>(static_cast<ID3D12GraphicsCommandList*>(ppCommandLists[i]))->Execute();
+        }
+
+        void STDMETHODCALLTYPE SetMarker( UINT, const void*, UINT ) override {}
+        void STDMETHODCALLTYPE BeginEvent( UINT, const void*, UINT ) override {}
+        void STDMETHODCALLTYPE EndEvent( void ) override {}
+
+        HRESULT STDMETHODCALLTYPE Signal( ID3D12Fence* pFence, UINT64 Value ) override
+        {
+            return pFence->Signal(Value);
+        }
+
+        HRESULT STDMETHODCALLTYPE Wait( ID3D12Fence*, UINT64 ) override
+        {
+            return S_OK;
+        }
+
+        // Timestamps all read back as zero, but they are converted with a sensible frequency.
+        HRESULT STDMETHODCALLTYPE GetTimestampFrequency( UINT64* pFrequency ) override
+        {
+            LARGE_INTEGER Frequency;
+            QueryPerformanceFrequency(&Frequency);
+            *pFrequency = (UINT64)Frequency.QuadPart;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetClockCalibration( UINT64* pGpuTimestamp, UINT64* pCpuTimestamp ) override
+        {
+            LARGE_INTEGER Counter;
+            QueryPerformanceCounter(&Counter);
+            *pGpuTimestamp = 0;
+            *pCpuTimestamp = (UINT64)Counter.QuadPart;
+            return S_OK;
+        }
+
+        D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc( void ) override { return m_Desc; }
+
+    private:
+        D3D12_COMMAND_QUEUE_DESC m_Desc;
+    };
+
+    // Returns pObject as riid, giving up the reference it was created with.
+    template <typename Interface>
+    HRESULT ReturnObject( Interface* pObject, REFIID riid, void** ppvObject )
+    {
+        if (ppvObject == nullptr)
+        {
+            pObject->Release();
+            return S_FALSE;
+        }
+
+        HRESULT hr = pObject->QueryInterface(riid, ppvObject);
+        pObject->Release();
+        return hr;
+    }
+
+    class NullD3D12Device : public NullObject<ID3D12Device>
+    {
+    public:
+        UINT STDMETHODCALLTYPE GetNodeCount( void ) override { return 1; }
+
+        HRESULT STDMETHODCALLTYPE CreateCommandQueue( const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue ) override
+        {
+            return ReturnObject(new NullCommandQueue(this, *pDesc), riid, ppCommandQueue);
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateCommandAllocator( D3D12_COMMAND_LIST_TYPE, REFIID riid, void** ppCommandAllocator ) override
+        {
+            return ReturnObject(new NullCommandAllocator(this), riid, ppCommandAllocator);
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState( const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID riid, void** ppPipelineState ) override
+        {
+            return ReturnObject(new NullPipelineState(this), riid, ppPipelineState);
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateComputePipelineState( const D3D12_COMPUTE_PIPELINE_STATE_DESC*, REFIID riid, void** ppPipelineState ) override
+        {
+            return ReturnObject(new NullPipelineState(this), riid, ppPipelineState);
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateCommandList( UINT, D3D12_COMMAND_LIST_TYPE Type, ID3D12CommandAllocator*, ID3D12PipelineState* pInitialState,
+            REFIID riid, void** ppCommandList ) override
+        {
+            return ReturnObject(new NullGraphicsCommandList(this, Type, pInitialState), riid, ppCommandList);
+        }
+
+        // Reports a resource binding tier 3, heap tier 2 device without any optional features, tiled
+        // resources included.
+        HRESULT STDMETHODCALLTYPE CheckFeatureSupport( D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize ) override
+        {
+            switch (Feature)
+            {
+            case D3D12_FEATURE_D3D12_OPTIONS:
+            {
+                if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))
+                    return E_INVALIDARG;
+                D3D12_FEATURE_DATA_D3D12_OPTIONS* pOptions = (D3D12_FEATURE_DATA_D3D12_OPTIONS*)pFeatureSupportData;
+                ZeroMemory(pOptions, sizeof(*pOptions));
+                pOptions->ResourceBindingTier = D3D12_RESOURCE_BINDING_TIER_3;
+                pOptions->ResourceHeapTier = D3D12_RESOURCE_HEAP_TIER_2;
+                return S_OK;
+            }
+
+            case D3D12_FEATURE_FORMAT_SUPPORT:
+            {
+                if (FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_FORMAT_SUPPORT))
+                    return E_INVALIDARG;
+                D3D12_FEATURE_DATA_FORMAT_SUPPORT* pSupport = (D3D12_FEATURE_DATA_FORMAT_SUPPORT*)pFeatureSupportData;
+                pSupport->Support1 = D3D12_FORMAT_SUPPORT1_NONE;
+                pSupport->Support2 = D3D12_FORMAT_SUPPORT2_NONE;
+                return S_OK;
+            }
+
+            default:
+                return E_INVALIDARG;
+            }
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateDescriptorHeap( const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap ) override
+        {
+            return ReturnObject(new NullDescriptorHeap(this, *pDescriptorHeapDesc), riid, ppvHeap);
+        }
+
+        UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize( D3D12_DESCRIPTOR_HEAP_TYPE ) override
+        {
+            return kDescriptorSize;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateRootSignature( UINT, const void*, SIZE_T, REFIID riid, void** ppvRootSignature ) override
+        {
+            return ReturnObject(new NullRootSignature(this), riid, ppvRootSignature);
+        }
+
+        void STDMETHODCALLTYPE CreateConstantBufferView( const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+        {
+            WriteDescriptor(DestDescriptor, NullDescriptor::kCBV, DXGI_FORMAT_UNKNOWN, nullptr, pDesc == nullptr ? 0 : pDesc->BufferLocation);
+        }
+
+        void STDMETHODCALLTYPE CreateShaderResourceView( ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+        {
+            WriteDescriptor(DestDescriptor, NullDescriptor::kSRV, pDesc == nullptr ? DXGI_FORMAT_UNKNOWN : pDesc->Format, pResource);
+        }
+
+        void STDMETHODCALLTYPE CreateUnorderedAccessView( ID3D12Resource* pResource, ID3D12Resource*, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+        {
+            WriteDescriptor(DestDescriptor, NullDescriptor::kUAV, pDesc == nullptr ? DXGI_FORMAT_UNKNOWN : pDesc->Format, pResource);
+        }
+
+        void STDMETHODCALLTYPE CreateRenderTargetView( ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+        {
+            WriteDescriptor(DestDescriptor, NullDescriptor::kRTV, pDesc == nullptr ? DXGI_FORMAT_UNKNOWN : pDesc->Format, pResource);
+        }
+
+        void STDMETHODCALLTYPE CreateDepthStencilView( ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+        {
+            WriteDescriptor(DestDescriptor, NullDescriptor::kDSV, pDesc == nullptr ? DXGI_FORMAT_UNKNOWN : pDesc->Format, pResource);
+        }
+
+        void STDMETHODCALLTYPE CreateSampler( const D3D12_SAMPLER_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor ) override
+        {
+            WriteDescriptor(DestDescriptor, NullDescriptor::kSampler, DXGI_FORMAT_UNKNOWN, nullptr);
+        }
+
+        void STDMETHODCALLTYPE CopyDescriptors( UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+            const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts,
+            const UINT* pSrcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE ) override
+        {
+            // Ranges without sizes hold one descriptor each.
+            UINT DestRange = 0, DestOffset = 0;
+            UINT SrcRange = 0, SrcOffset = 0;
+
+            while (DestRange < NumDestDescriptorRanges && SrcRange < NumSrcDescriptorRanges)
+            {
+                const UINT DestSize = pDestDescriptorRangeSizes == nullptr ? 1 : pDestDescriptorRangeSizes[DestRange];
+                const UINT SrcSize = pSrcDescriptorRangeSizes == nullptr ? 1 : pSrcDescriptorRangeSizes[SrcRange];
+                const UINT Count = std::min(DestSize - DestOffset, SrcSize - SrcOffset);
+
+                if (Count > 0)
+                {
+                    memcpy((uint8_t*)pDestDescriptorRangeStarts[DestRange].ptr + DestOffset * kDescriptorSize,
+                        (const uint8_t*)pSrcDescriptorRangeStarts[SrcRange].ptr + SrcOffset * kDescriptorSize,
+                        Count * kDescriptorSize);
+                }
+
+                DestOffset += Count;
+                SrcOffset += Count;
+
+                if (DestOffset == DestSize)
+                {
+                    ++DestRange;
+                    DestOffset = 0;
+                }
+                if (SrcOffset == SrcSize)
+                {
+                    ++SrcRange;
+                    SrcOffset = 0;
+                }
+            }
+        }
+
+        void STDMETHODCALLTYPE CopyDescriptorsSimple( UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart,
+            D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE ) override
+        {
+            memcpy((void*)DestDescriptorRangeStart.ptr, (const void*)SrcDescriptorRangeStart.ptr, NumDescriptors * kDescriptorSize);
+        }
+
+        D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo( UINT, UINT NumResourceDescs, const D3D12_RESOURCE_DESC* pResourceDescs ) override
+        {
+            D3D12_RESOURCE_ALLOCATION_INFO Info = { 0, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+
+            for (UINT i = 0; i < NumResourceDescs; ++i)
+            {
+                Info.Alignment = std::max(Info.Alignment, GetAllocationAlignment(pResourceDescs[i]));
+                Info.SizeInBytes = AlignUp(Info.SizeInBytes, GetAllocationAlignment(pResourceDescs[i])) + GetAllocationSize(pResourceDescs[i]);
+            }
+
+            return Info;
+        }
+
+        D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties( UINT, D3D12_HEAP_TYPE HeapType ) override
+        {
+            D3D12_HEAP_PROPERTIES Properties = CD3DX12_HEAP_PROPERTIES(D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE, D3D12_MEMORY_POOL_L0);
+            if (HeapType == D3D12_HEAP_TYPE_UPLOAD)
+                Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE;
+            else if (HeapType == D3D12_HEAP_TYPE_READBACK)
+                Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
+            return Properties;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateCommittedResource( const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS HeapFlags,
+            const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID riidResource, void** ppvResource ) override
+        {
+            return ReturnObject(new NullResource(this, *pDesc, *pHeapProperties, HeapFlags, nullptr, 0), riidResource, ppvResource);
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateHeap( const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap ) override
+        {
+            return ReturnObject(new NullHeap(this, *pDesc), riid, ppvHeap);
+        }
+
+        HRESULT STDMETHODCALLTYPE CreatePlacedResource( ID3D12Heap* pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC* pDesc,
+            D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID riid, void** ppvResource ) override
+        {
+            NullHeap* pNullHeap = static_cast<NullHeap*>(pHeap);
+            D3D12_HEAP_DESC HeapDesc = pNullHeap->GetDesc();
+            return ReturnObject(new NullResource(this, *pDesc, HeapDesc.Properties, HeapDesc.Flags, pNullHeap, HeapOffset), riid, ppvResource);
+        }
+
+        // CheckFeatureSupport reports no tiled resource tier.
+        HRESULT STDMETHODCALLTYPE CreateReservedResource( const D3D12_RESOURCE_DESC*, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*,
+            REFIID, void** ) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateSharedHandle( ID3D12DeviceChild*, const SECURITY_ATTRIBUTES*, DWORD, LPCWSTR, HANDLE* ) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE OpenSharedHandle( HANDLE, REFIID, void** ) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE OpenSharedHandleByName( LPCWSTR, DWORD, HANDLE* ) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE MakeResident( UINT, ID3D12Pageable* const* ) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE Evict( UINT, ID3D12Pageable* const* ) override { return S_OK; }
+
+        HRESULT STDMETHODCALLTYPE CreateFence( UINT64 InitialValue, D3D12_FENCE_FLAGS, REFIID riid, void** ppFence ) override
+        {
+            return ReturnObject(new NullFence(this, InitialValue), riid, ppFence);
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason( void ) override { return S_OK; }
+
+        void STDMETHODCALLTYPE GetCopyableFootprints( const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource, UINT NumSubresources,
+            UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows, UINT64* pRowSizeInBytes, UINT64* pTotalBytes ) override
+        {
+            UINT64 TotalBytes = GetFootprints(*pResourceDesc, FirstSubresource, NumSubresources, BaseOffset, pLayouts, pNumRows, pRowSizeInBytes);
+            if (pTotalBytes != nullptr)
+                *pTotalBytes = TotalBytes;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateQueryHeap( const D3D12_QUERY_HEAP_DESC*, REFIID riid, void** ppvHeap ) override
+        {
+            return ReturnObject(new NullQueryHeap(this), riid, ppvHeap);
+        }
+
+        HRESULT STDMETHODCALLTYPE SetStablePowerState( BOOL ) override { return S_OK; }
+
+        HRESULT STDMETHODCALLTYPE CreateCommandSignature( const D3D12_COMMAND_SIGNATURE_DESC*, ID3D12RootSignature*, REFIID riid, void** ppvCommandSignature ) override
+        {
+            return ReturnObject(new NullCommandSignature(this), riid, ppvCommandSignature);
+        }
+
+        void STDMETHODCALLTYPE GetResourceTiling( ID3D12Resource*, UINT* pNumTilesForEntireResource, D3D12_PACKED_MIP_INFO* pPackedMipDesc,
+            D3D12_TILE_SHAPE* pStandardTileShapeForNonPackedMips, UINT* pNumSubresourceTilings, UINT, D3D12_SUBRESOURCE_TILING* ) override
+        {
+            if (pNumTilesForEntireResource != nullptr)
+                *pNumTilesForEntireResource = 0;
+            if (pPackedMipDesc != nullptr)
+                ZeroMemory(pPackedMipDesc, sizeof(*pPackedMipDesc));
+            if (pStandardTileShapeForNonPackedMips != nullptr)
+                ZeroMemory(pStandardTileShapeForNonPackedMips, sizeof(*pStandardTileShapeForNonPackedMips));
+            if (pNumSubresourceTilings != nullptr)
+                *pNumSubresourceTilings = 0;
+        }
+
+        LUID STDMETHODCALLTYPE GetAdapterLuid( void ) override
+        {
+            LUID Luid = {};
+            return Luid;
+        }
+    };
+}
+
+ID3D12Device* NullDevice::Create( void )
+{
+    return new NullD3D12Device();
+}
+
+NullDeviceStats NullDevice::ResetStats( void )
+{
+    NullDeviceStats Stats;
+    Stats.NumExecutedCommandLists = s_NumExecutedCommandLists.exchange(0);
+    Stats.NumExecutedCommands = s_NumExecutedCommands.exchange(0);
+    Stats.NumExecutedBytes = s_NumExecutedBytes.exchange(0);
+    return Stats;
+}
@@ -0,0 +1,42 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <stdint.h>
+
+// An ID3D12Device that never touches a GPU, so the engine's CPU cost can be measured on its own.
+//
+// - Command lists record every command into a byte stream, as a driver would, and queues drop the
+//   streams when they execute them.
+// - Work completes as soon as it is submitted:  a queue signals its fence on the spot, and fence
+//   events are set as soon as the fence reaches the value they wait for.
+// - Buffers, upload and readback memory, and heaps that can hold buffers are backed by system
+//   memory, so Map() and GPU virtual addresses work.  Textures in default heaps have no storage,
+//   as nothing ever reads or writes their texels.
+// - Descriptor heaps are system memory too.  Views are written to and copied between them.
+//
+// Pipeline states and root signatures are empty objects, and query results read back as zeros.
+
+struct NullDeviceStats
+{
+    uint64_t NumExecutedCommandLists;
+    uint64_t NumExecutedCommands;
+    uint64_t NumExecutedBytes;
+};
+
+namespace NullDevice
+{
+    ID3D12Device* Create( void );
+
+    // Returns what the device's queues have executed since the last call.
+    NullDeviceStats ResetStats( void );
+}
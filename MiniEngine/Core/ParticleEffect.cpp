@@ -30,33 +30,36 @@ namespace ParticleEffects
     extern ComputePSO s_ParticleUpdateCS;
     extern ComputePSO s_ParticleDispatchIndirectArgsCS;
     extern StructuredBuffer SpriteVertexBuffer;
-    extern RandomNumberGenerator s_RNG;
 }
 
-ParticleEffect::ParticleEffect(ParticleEffectProperties& effectProperties)
+// Fixed so that runs are reproducible
+static const uint64_t kParticleRandomSeed = 0x5EEDu;
+
+ParticleEffect::ParticleEffect(ParticleEffectProperties& effectProperties, uint64_t RandomStream)
+    : m_RNG(kParticleRandomSeed, RandomStream)
 {
     m_ElapsedTime = 0.0;
     m_EffectProperties = effectProperties;
 }
 
-inline static Color RandColor( Color c0, Color c1 )
+inline static Color RandColor( RandomNumberGenerator& RNG, Color c0, Color c1 )
 {
     // We might want to find min and max of each channel rather than assuming c0 <= c1
     return Color(
-        s_RNG.NextFloat( c0.R(), c1.R()),
-        s_RNG.NextFloat( c0.G(), c1.G()),
-        s_RNG.NextFloat( c0.B(), c1.B()),
-        s_RNG.NextFloat( c0.A(), c1.A())
+        RNG.NextFloat( c0.R(), c1.R()),
+        RNG.NextFloat( c0.G(), c1.G()),
+        RNG.NextFloat( c0.B(), c1.B()),
+        RNG.NextFloat( c0.A(), c1.A())
         );
 }
 
-inline static XMFLOAT3 RandSpread( const XMFLOAT3& s )
+inline static XMFLOAT3 RandSpread( RandomNumberGenerator& RNG, const XMFLOAT3& s )
 {
     // We might want to find min and max of each channel rather than assuming c0 <= c1
     return XMFLOAT3(
-        s_RNG.NextFloat(-s.x, s.x),
-        s_RNG.NextFloat(-s.y, s.y), 
-        s_RNG.NextFloat(-s.z, s.z)
+        RNG.NextFloat(-s.x, s.x),
+        RNG.NextFloat(-s.y, s.y), 
+        RNG.NextFloat(-s.z, s.z)
         );
 }
 
@@ -72,22 +75,22 @@ void ParticleEffect::LoadDeviceResources(ID3D12Device* device)
     for (UINT i = 0; i < m_EffectProperties.EmitProperties.MaxParticles; i++)
     {
         ParticleSpawnData& SpawnData = pSpawnData[i];
-        SpawnData.AgeRate = 1.0f / s_RNG.NextFloat( m_EffectProperties.LifeMinMax.x, m_EffectProperties.LifeMinMax.y );
-        float horizontalAngle = s_RNG.NextFloat(XM_2PI);
-        float horizontalVelocity = s_RNG.NextFloat( m_EffectProperties.Velocity.GetX(), m_EffectProperties.Velocity.GetY() );
+        SpawnData.AgeRate = 1.0f / m_RNG.NextFloat( m_EffectProperties.LifeMinMax.x, m_EffectProperties.LifeMinMax.y );
+        float horizontalAngle = m_RNG.NextFloat(XM_2PI);
+        float horizontalVelocity = m_RNG.NextFloat( m_EffectProperties.Velocity.GetX(), m_EffectProperties.Velocity.GetY() );
         SpawnData.Velocity.x = horizontalVelocity * cos(horizontalAngle);
-        SpawnData.Velocity.y = s_RNG.NextFloat( m_EffectProperties.Velocity.GetZ(), m_EffectProperties.Velocity.GetW() );
+        SpawnData.Velocity.y = m_RNG.NextFloat( m_EffectProperties.Velocity.GetZ(), m_EffectProperties.Velocity.GetW() );
         SpawnData.Velocity.z = horizontalVelocity * sin(horizontalAngle);
 
-        SpawnData.SpreadOffset = RandSpread(m_EffectProperties.Spread ) ;
+        SpawnData.SpreadOffset = RandSpread(m_RNG, m_EffectProperties.Spread) ;
 
-        SpawnData.StartSize = s_RNG.NextFloat( m_EffectProperties.Size.GetX(), m_EffectProperties.Size.GetY() );
-        SpawnData.EndSize = s_RNG.NextFloat( m_EffectProperties.Size.GetZ(), m_EffectProperties.Size.GetW() );
-        SpawnData.StartColor = RandColor( m_EffectProperties.MinStartColor, m_EffectProperties.MaxStartColor );
-        SpawnData.EndColor = RandColor( m_EffectProperties.MinEndColor, m_EffectProperties.MaxEndColor );
-        SpawnData.Mass = s_RNG.NextFloat( m_EffectProperties.MassMinMax.x, m_EffectProperties.MassMinMax.y );
-        SpawnData.RotationSpeed = s_RNG.NextFloat(); //todo
-        SpawnData.Random = s_RNG.NextFloat();
+        SpawnData.StartSize = m_RNG.NextFloat( m_EffectProperties.Size.GetX(), m_EffectProperties.Size.GetY() );
+        SpawnData.EndSize = m_RNG.NextFloat( m_EffectProperties.Size.GetZ(), m_EffectProperties.Size.GetW() );
+        SpawnData.StartColor = RandColor( m_RNG, m_EffectProperties.MinStartColor, m_EffectProperties.MaxStartColor );
+        SpawnData.EndColor = RandColor( m_RNG, m_EffectProperties.MinEndColor, m_EffectProperties.MaxEndColor );
+        SpawnData.Mass = m_RNG.NextFloat( m_EffectProperties.MassMinMax.x, m_EffectProperties.MassMinMax.y );
+        SpawnData.RotationSpeed = m_RNG.NextFloat(); //todo
+        SpawnData.Random = m_RNG.NextFloat();
     }
     
     m_RandomStateBuffer.Create(L"ParticleSystem::SpawnDataBuffer", m_EffectProperties.EmitProperties.MaxParticles, sizeof(ParticleSpawnData), pSpawnData);
@@ -118,7 +121,7 @@ void ParticleEffect::Update(ComputeContext& CompContext,  float timeDelta)
     //CPU side random num gen
     for (uint32_t i = 0; i < 64; i++)
     {
-        UINT random = (UINT)s_RNG.NextInt(m_EffectProperties.EmitProperties.MaxParticles - 1);
+        UINT random = (UINT)m_RNG.NextInt(m_EffectProperties.EmitProperties.MaxParticles - 1);
         m_EffectProperties.EmitProperties.RandIndex[i].x = random;
     }
     CompContext.SetDynamicConstantBufferView(2, sizeof(EmissionProperties), &m_EffectProperties.EmitProperties);    
@@ -16,11 +16,14 @@
 #include "GpuBuffer.h"
 #include "ParticleEffectProperties.h"
 #include "ParticleShaderStructs.h"
+#include "Math/Random.h"
 
 class ParticleEffect 
 {
 public:
-    ParticleEffect(ParticleEffectProperties& effectProperties);
+    // Each effect draws its random numbers from its own stream, so its particles only depend on the
+    // order in which effects were created, not on what other effects do.
+    ParticleEffect(ParticleEffectProperties& effectProperties, uint64_t RandomStream);
     void LoadDeviceResources(ID3D12Device* device);
     void Update(ComputeContext& CompContext, float timeDelta);
     float GetLifetime(){ return m_EffectProperties.TotalActiveLifetime; }
@@ -39,6 +42,7 @@ private:
     ParticleEffectProperties m_OriginalEffectProperties;
     float m_ElapsedTime;
     UINT m_effectID;
+    Math::RandomNumberGenerator m_RNG;
     
 
 };
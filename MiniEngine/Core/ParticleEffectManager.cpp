@@ -20,7 +20,6 @@
 #include "CommandContext.h"
 #include "GameCore.h"
 #include "GraphicsCore.h"
-#include "Math/Random.h"
 #include "ParticleEffectManager.h"
 #include "ParticleEffect.h"
 #include "ParticleEffectProperties.h"
@@ -92,7 +91,6 @@ namespace ParticleEffects
     StructuredBuffer SpriteVertexBuffer;
     
     UINT s_ReproFrame = 0;//201;
-    RandomNumberGenerator s_RNG;
 }
 
 struct CBChangesPerView
@@ -545,9 +543,6 @@ void ParticleEffects::Initialize( uint32_t MaxDisplayWidth, uint32_t MaxDisplayH
     TextureArraySRV = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
     g_Device->CreateShaderResourceView(TextureArray.GetResource(), &SRVDesc, TextureArraySRV);
 
-    if (s_ReproFrame > 0)
-        s_RNG.SetSeed(1);
-    
     TotalElapsedFrames = 0;
     s_InitComplete = true;
 }
@@ -585,7 +580,7 @@ EffectHandle ParticleEffects::PreLoadEffectResources( ParticleEffectProperties&
     static std::mutex s_TextureMutex;
     s_TextureMutex.lock();
     MaintainTextureList(effectProperties);
-    ParticleEffectsPool.emplace_back(new ParticleEffect(effectProperties));
+    ParticleEffectsPool.emplace_back(new ParticleEffect(effectProperties, ParticleEffectsPool.size()));
     s_TextureMutex.unlock();
 
     EffectHandle index = (EffectHandle)ParticleEffectsPool.size() - 1;
@@ -624,7 +619,7 @@ EffectHandle ParticleEffects::InstantiateEffect( ParticleEffectProperties& effec
     static std::mutex s_InstantiateNewEffectMutex;
     s_InstantiateNewEffectMutex.lock();
     MaintainTextureList(effectProperties);
-    ParticleEffect* newEffect = new ParticleEffect(effectProperties);
+    ParticleEffect* newEffect = new ParticleEffect(effectProperties, ParticleEffectsPool.size());
     ParticleEffectsPool.emplace_back(newEffect);
     ParticleEffectsActive.push_back(newEffect);
     s_InstantiateNewEffectMutex.unlock();
@@ -406,6 +406,24 @@ void PixelBuffer::CreateTextureResource( ID3D12Device* Device, const std::wstrin
     CreateTextureResource(Device, Name, ResourceDesc, ClearValue);
 }
 
+void PixelBuffer::CreateTextureResource( ID3D12Device* Device, const std::wstring& Name,
+    const D3D12_RESOURCE_DESC& ResourceDesc, D3D12_CLEAR_VALUE ClearValue, ID3D12Heap* pBackingHeap, uint64_t HeapOffset )
+{
+    Destroy();
+
+    ASSERT_SUCCEEDED( Device->CreatePlacedResource( pBackingHeap, HeapOffset,
+        &ResourceDesc, D3D12_RESOURCE_STATE_COMMON, &ClearValue, MY_IID_PPV_ARGS(&m_pResource) ));
+
+    m_UsageState = D3D12_RESOURCE_STATE_COMMON;
+    m_GpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+
+#ifndef RELEASE
+    m_pResource->SetName(Name.c_str());
+#else
+    (Name);
+#endif
+}
+
 void PixelBuffer::ExportToFile( const std::wstring& FilePath )
 {
     // Create the buffer.  We will release it after all is done.
@@ -48,6 +48,9 @@ protected:
     void CreateTextureResource( ID3D12Device* Device, const std::wstring& Name, const D3D12_RESOURCE_DESC& ResourceDesc,
         D3D12_CLEAR_VALUE ClearValue, EsramAllocator& Allocator );
 
+    void CreateTextureResource( ID3D12Device* Device, const std::wstring& Name, const D3D12_RESOURCE_DESC& ResourceDesc,
+        D3D12_CLEAR_VALUE ClearValue, ID3D12Heap* pBackingHeap, uint64_t HeapOffset );
+
     static DXGI_FORMAT GetBaseFormat( DXGI_FORMAT Format );
     static DXGI_FORMAT GetUAVFormat( DXGI_FORMAT Format );
     static DXGI_FORMAT GetDSVFormat( DXGI_FORMAT Format );
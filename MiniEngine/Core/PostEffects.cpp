@@ -23,6 +23,7 @@
 #include "MotionBlur.h"
 #include "DepthOfField.h"
 #include "FXAA.h"
+#include "FrameGraph.h"
 
 #include "CompiledShaders/ToneMapCS.h"
 #include "CompiledShaders/ToneMap2CS.h"
@@ -106,8 +107,18 @@ namespace PostEffects
 
     StructuredBuffer g_Exposure;
 
+    // The bloom passes run on a frame graph, which places the bloom buffers in one heap, so that levels that have
+    // been blurred share memory with the ones still to come.  The graph is rebuilt when the bloom buffers change.
+    FrameGraph BloomGraph;
+    uint32_t BloomGraphWidth = 0;
+    uint32_t BloomGraphHeight = 0;
+    bool BloomGraphHighQuality = false;
+
     void UpdateExposure(ComputeContext&);
     void BlurBuffer(ComputeContext&, ColorBuffer buffer[2], const ColorBuffer& lowerResBuf, float upsampleBlendFactor );
+    void BuildBloomGraph(uint32_t NativeWidth, uint32_t NativeHeight, bool HighQuality);
+    void ExtractBloom(ComputeContext&);
+    void DownsampleBloom(ComputeContext&, bool HighQuality);
     void GenerateBloom(ComputeContext&);
     void ExtractLuma(ComputeContext&);
     void ProcessHDR(ComputeContext&);
@@ -176,6 +187,7 @@ void PostEffects::Initialize( void )
 
 void PostEffects::Shutdown( void )
 {
+    BloomGraph.Destroy();
     g_Exposure.Destroy();
 
     FXAA::Shutdown();
@@ -191,7 +203,6 @@ void PostEffects::BlurBuffer( ComputeContext& Context, ColorBuffer buffer[2], co
     Context.SetConstants(0, 1.0f / bufferWidth, 1.0f / bufferHeight, upsampleBlendFactor);
 
     // Set the input textures and output UAV
-    Context.TransitionResource( buffer[1], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
     Context.SetDynamicDescriptor(1, 0, buffer[1].GetUAV());
     D3D12_CPU_DESCRIPTOR_HANDLE SRVs[2] = { buffer[0].GetSRV(), lowerResBuf.GetSRV() };
     Context.SetDynamicDescriptors(2, 0, 2, SRVs);
@@ -201,17 +212,85 @@ void PostEffects::BlurBuffer( ComputeContext& Context, ColorBuffer buffer[2], co
 
     // Dispatch the compute shader with default 8x8 thread groups
     Context.Dispatch2D(bufferWidth, bufferHeight);
-
-    Context.TransitionResource( buffer[1], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 }
 
 //--------------------------------------------------------------------------------------
 // Bloom effect in CS path
 //--------------------------------------------------------------------------------------
-void PostEffects::GenerateBloom( ComputeContext& Context )
+void PostEffects::BuildBloomGraph( uint32_t NativeWidth, uint32_t NativeHeight, bool HighQuality )
 {
-    ScopedTimer _prof(L"Generate Bloom", Context);
+    const D3D12_RESOURCE_STATES UAV = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    const D3D12_RESOURCE_STATES SRV = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+
+    BloomGraph.Destroy();
+
+    FrameGraph::ResourceHandle SceneColor = BloomGraph.ImportResource(L"Main Color Buffer", &g_SceneColorBuffer);
+    FrameGraph::ResourceHandle Exposure = BloomGraph.ImportResource(L"Exposure", &g_Exposure);
+    FrameGraph::ResourceHandle LumaLR = BloomGraph.ImportResource(L"Luma Buffer", &g_LumaLR);
+
+    // The difference between high and low quality bloom is that high quality sums 5 octaves with a 2x frequency scale, and the low quality
+    // sums 3 octaves with a 4x frequency scale.
+    ColorBuffer* AllLevels[5] = { g_aBloomUAV1, g_aBloomUAV2, g_aBloomUAV3, g_aBloomUAV4, g_aBloomUAV5 };
+    const uint32_t NumLevels = HighQuality ? 5 : 3;
+    const uint32_t LevelStep = HighQuality ? 1 : 2;
+
+    ColorBuffer* Levels[5];
+    FrameGraph::ResourceHandle Bloom[5][2];
+    for (uint32_t i = 0; i < NumLevels; ++i)
+    {
+        Levels[i] = AllLevels[i * LevelStep];
+        Bloom[i][0] = AddTransientRenderingBuffer(BloomGraph, Levels[i][0], NativeWidth, NativeHeight);
+        Bloom[i][1] = AddTransientRenderingBuffer(BloomGraph, Levels[i][1], NativeWidth, NativeHeight);
+    }
+
+    FrameGraph::PassHandle Pass;
 
+    Pass = BloomGraph.AddPass(L"Extract Bloom", []( CommandContext& Context ) { ExtractBloom(Context.GetComputeContext()); });
+    BloomGraph.Read(Pass, SceneColor, SRV);
+    BloomGraph.Read(Pass, Exposure, SRV);
+    BloomGraph.Write(Pass, Bloom[0][0], UAV);
+    BloomGraph.Write(Pass, LumaLR, UAV);
+
+    Pass = BloomGraph.AddPass(L"Downsample Bloom", [HighQuality]( CommandContext& Context )
+    {
+        DownsampleBloom(Context.GetComputeContext(), HighQuality);
+    });
+    BloomGraph.Read(Pass, Bloom[0][0], SRV);
+    for (uint32_t i = 1; i < NumLevels; ++i)
+        BloomGraph.Write(Pass, Bloom[i][0], UAV);
+
+    // Blur the smallest level, then upsample each level into the next larger one and blur that
+    for (int i = NumLevels - 1; i >= 0; --i)
+    {
+        ColorBuffer* Buffer = Levels[i];
+        const ColorBuffer* LowerResBuffer = i + 1 < (int)NumLevels ? &Levels[i + 1][1] : &Levels[i][0];
+
+        Pass = BloomGraph.AddPass(L"Blur Bloom " + std::to_wstring(i * LevelStep + 1), [=]( CommandContext& Context )
+        {
+            float upsampleBlendFactor = BloomUpsampleFactor;
+            if (LowerResBuffer == &Buffer[0])
+                upsampleBlendFactor = 1.0f;
+            else if (!HighQuality)
+                upsampleBlendFactor *= 2.0f / 3.0f;
+
+            BlurBuffer(Context.GetComputeContext(), Buffer, *LowerResBuffer, upsampleBlendFactor);
+        });
+        BloomGraph.Read(Pass, Bloom[i][0], SRV);
+        if (i + 1 < (int)NumLevels)
+            BloomGraph.Read(Pass, Bloom[i + 1][1], SRV);
+        BloomGraph.Write(Pass, Bloom[i][1], UAV);
+    }
+
+    BloomGraph.Compile();
+    BloomGraph.Allocate();
+
+    BloomGraphWidth = NativeWidth;
+    BloomGraphHeight = NativeHeight;
+    BloomGraphHighQuality = HighQuality;
+}
+
+void PostEffects::ExtractBloom( ComputeContext& Context )
+{
     // We can generate a bloom buffer up to 1/4 smaller in each dimension without undersampling.  If only downsizing by 1/2 or less, a faster
     // shader can be used which only does one bilinear sample.
 
@@ -224,36 +303,25 @@ void PostEffects::GenerateBloom( ComputeContext& Context )
     // 1080p.  This is a common size for a bloom buffer on consoles.
     ASSERT(kBloomWidth % 16 == 0 && kBloomHeight % 16 == 0, "Bloom buffer dimensions must be multiples of 16");
 
-
     Context.SetConstants(0, 1.0f / kBloomWidth, 1.0f / kBloomHeight, (float)BloomThreshold );
-    Context.TransitionResource(g_aBloomUAV1[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-    Context.TransitionResource(g_LumaLR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-    Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-    Context.TransitionResource(g_Exposure, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-
-    {
+    Context.SetDynamicDescriptor(1, 0, g_aBloomUAV1[0].GetUAV());
+    Context.SetDynamicDescriptor(1, 1, g_LumaLR.GetUAV());
+    Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetSRV());
+    Context.SetDynamicDescriptor(2, 1, g_Exposure.GetSRV());
 
-        Context.SetDynamicDescriptor(1, 0, g_aBloomUAV1[0].GetUAV());
-        Context.SetDynamicDescriptor(1, 1, g_LumaLR.GetUAV());
-        Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetSRV());
-        Context.SetDynamicDescriptor(2, 1, g_Exposure.GetSRV());
+    Context.SetPipelineState(EnableHDR ? BloomExtractAndDownsampleHdrCS : BloomExtractAndDownsampleLdrCS);
+    Context.Dispatch2D(kBloomWidth, kBloomHeight);
+}
 
-        Context.SetPipelineState(EnableHDR ? BloomExtractAndDownsampleHdrCS : BloomExtractAndDownsampleLdrCS);
-        Context.Dispatch2D(kBloomWidth, kBloomHeight);
-    }
+void PostEffects::DownsampleBloom( ComputeContext& Context, bool HighQuality )
+{
+    uint32_t kBloomWidth = g_LumaLR.GetWidth();
+    uint32_t kBloomHeight = g_LumaLR.GetHeight();
 
-    Context.TransitionResource(g_aBloomUAV1[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
     Context.SetDynamicDescriptor(2, 0, g_aBloomUAV1[0].GetSRV());
 
-    // The difference between high and low quality bloom is that high quality sums 5 octaves with a 2x frequency scale, and the low quality
-    // sums 3 octaves with a 4x frequency scale.
-    if (HighQualityBloom)
+    if (HighQuality)
     {
-        Context.TransitionResource(g_aBloomUAV2[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        Context.TransitionResource(g_aBloomUAV3[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        Context.TransitionResource(g_aBloomUAV4[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        Context.TransitionResource(g_aBloomUAV5[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
         // Set the UAVs
         D3D12_CPU_DESCRIPTOR_HANDLE UAVs[4] = {
             g_aBloomUAV2[0].GetUAV(), g_aBloomUAV3[0].GetUAV(), g_aBloomUAV4[0].GetUAV(), g_aBloomUAV5[0].GetUAV() };
@@ -261,21 +329,6 @@ void PostEffects::GenerateBloom( ComputeContext& Context )
 
         // Each dispatch group is 8x8 threads, but each thread reads in 2x2 source texels (bilinear filter).
         Context.SetPipelineState(DownsampleBloom4CS);
-        Context.Dispatch2D(kBloomWidth / 2, kBloomHeight / 2);
-
-        Context.TransitionResource(g_aBloomUAV2[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        Context.TransitionResource(g_aBloomUAV3[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        Context.TransitionResource(g_aBloomUAV4[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        Context.TransitionResource(g_aBloomUAV5[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-
-        float upsampleBlendFactor = BloomUpsampleFactor;
-
-        // Blur then upsample and blur four times
-        BlurBuffer( Context, g_aBloomUAV5, g_aBloomUAV5[0], 1.0f );
-        BlurBuffer( Context, g_aBloomUAV4, g_aBloomUAV5[1], upsampleBlendFactor  );
-        BlurBuffer( Context, g_aBloomUAV3, g_aBloomUAV4[1], upsampleBlendFactor  );
-        BlurBuffer( Context, g_aBloomUAV2, g_aBloomUAV3[1], upsampleBlendFactor  );
-        BlurBuffer( Context, g_aBloomUAV1, g_aBloomUAV2[1], upsampleBlendFactor  );
     }
     else
     {
@@ -283,23 +336,31 @@ void PostEffects::GenerateBloom( ComputeContext& Context )
         D3D12_CPU_DESCRIPTOR_HANDLE UAVs[2] = { g_aBloomUAV3[0].GetUAV(), g_aBloomUAV5[0].GetUAV() };
         Context.SetDynamicDescriptors(1, 0, 2, UAVs);
 
-        Context.TransitionResource(g_aBloomUAV3[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        Context.TransitionResource(g_aBloomUAV5[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-
         // Each dispatch group is 8x8 threads, but each thread reads in 2x2 source texels (bilinear filter).
         Context.SetPipelineState(DownsampleBloom2CS);
-        Context.Dispatch2D(kBloomWidth / 2, kBloomHeight / 2);
+    }
 
-        Context.TransitionResource(g_aBloomUAV3[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        Context.TransitionResource(g_aBloomUAV5[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.Dispatch2D(kBloomWidth / 2, kBloomHeight / 2);
+}
 
-        float upsampleBlendFactor = BloomUpsampleFactor * 2.0f / 3.0f;
+void PostEffects::GenerateBloom( ComputeContext& Context )
+{
+    ScopedTimer _prof(L"Generate Bloom", Context);
+
+    // The bloom buffers are sized by the native resolution, and low quality bloom only uses some of them
+    uint32_t NativeWidth = g_SceneColorBuffer.GetWidth();
+    uint32_t NativeHeight = g_SceneColorBuffer.GetHeight();
+    bool HighQuality = HighQualityBloom;
 
-        // Blur then upsample and blur two times
-        BlurBuffer( Context, g_aBloomUAV5, g_aBloomUAV5[0], 1.0f );
-        BlurBuffer( Context, g_aBloomUAV3, g_aBloomUAV5[1], upsampleBlendFactor );
-        BlurBuffer( Context, g_aBloomUAV1, g_aBloomUAV3[1], upsampleBlendFactor );
+    if (BloomGraph.GetNumPasses() == 0 || NativeWidth != BloomGraphWidth || NativeHeight != BloomGraphHeight ||
+        HighQuality != BloomGraphHighQuality)
+    {
+        // Earlier frames may still be using the buffers placed in the old heap
+        g_CommandManager.IdleGPU();
+        BuildBloomGraph(NativeWidth, NativeHeight, HighQuality);
     }
+
+    BloomGraph.Execute(Context);
 }
 
 void PostEffects::ExtractLuma( ComputeContext& Context )
@@ -427,7 +488,8 @@ void PostEffects::ProcessLDR(CommandContext& BaseContext)
         else
             Context.TransitionResource(g_PostEffectsBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
-        Context.TransitionResource(g_aBloomUAV1[1], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        if (bGenerateBloom)
+            Context.TransitionResource(g_aBloomUAV1[1], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         Context.TransitionResource(g_LumaBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
         // Set constants
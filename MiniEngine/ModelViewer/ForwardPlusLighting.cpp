@@ -18,6 +18,7 @@
 #include "CommandContext.h"
 #include "Camera.h"
 #include "BufferManager.h"
+#include "Math/Random.h"
 
 #include "CompiledShaders/FillLightGridCS_8.h"
 #include "CompiledShaders/FillLightGridCS_16.h"
@@ -102,15 +103,11 @@ void Lighting::CreateRandomLights( const Vector3 minBound, const Vector3 maxBoun
     Vector3 posScale = maxBound - minBound;
     Vector3 posBias = minBound;
 
-    // todo: replace this with MT
-    srand(12645);
-    auto randUint = []() -> uint32_t
+    // A fixed seed keeps light placement identical from run to run
+    Math::RandomNumberGenerator rng(12645);
+    auto randFloat = [&rng]() -> float
     {
-        return rand(); // [0, RAND_MAX]
-    };
-    auto randFloat = [randUint]() -> float
-    {
-        return randUint() * (1.0f / RAND_MAX); // convert [0, RAND_MAX] to [0, 1]
+        return rng.NextFloat(); // [0, 1)
     };
     auto randVecUniform = [randFloat]() -> Vector3
     {
@@ -126,6 +126,7 @@ private:
 
     Model m_Model;
     std::vector<bool> m_pMaterialIsCutout;
+    std::vector<uint32_t> m_MaterialTables;
 
     Vector3 m_SunDirection;
     ShadowCamera m_SunShadow;
@@ -295,6 +296,22 @@ void ModelViewer::Startup( void )
     ASSERT(m_Model.Load("Models/sponza.h3d"), "Failed to load model");
     ASSERT(m_Model.m_Header.meshCount > 0, "Model contains no meshes");
 
+    // Material textures never change after loading, so their descriptor tables are copied
+    // once to the persistent region of the dynamic descriptor heaps rather than every draw.
+    // The scene passes are then left with one CopyDescriptors call per frame, for the extra
+    // textures and the voxel UAV.
+    // The region is taken out of every shader-visible heap, compute ones included, so it is
+    // sized to exactly the material tables.  Models with too many materials to leave room for
+    // dynamic tables keep using dynamic descriptors.
+    const uint32_t kMaxMaterialDescriptors = 256;
+    uint32_t NumMaterialDescriptors = m_Model.m_Header.materialCount * 6;
+    bool UsePersistentTables = NumMaterialDescriptors > 0 && NumMaterialDescriptors <= kMaxMaterialDescriptors;
+    if (UsePersistentTables)
+        DynamicDescriptorHeap::ReservePersistentDescriptors(NumMaterialDescriptors);
+    m_MaterialTables.resize(m_Model.m_Header.materialCount, DynamicDescriptorHeap::kInvalidPersistentTable);
+    for (uint32_t i = 0; UsePersistentTables && i < m_Model.m_Header.materialCount; ++i)
+        m_MaterialTables[i] = DynamicDescriptorHeap::CreatePersistentTable(6, m_Model.GetSRVs(i));
+
     // The caller of this function can override which materials are considered cutouts
     m_pMaterialIsCutout.resize(m_Model.m_Header.materialCount);
     for (uint32_t i = 0; i < m_Model.m_Header.materialCount; ++i)
@@ -546,7 +563,10 @@ void ModelViewer::RenderObjects( GraphicsContext& gfxContext, const Matrix4& Vie
                 continue;
 
             materialIdx = mesh.materialIndex;
-            gfxContext.SetDynamicDescriptors(2, 0, 6, m_Model.GetSRVs(materialIdx) );
+            if (m_MaterialTables[materialIdx] != DynamicDescriptorHeap::kInvalidPersistentTable)
+                gfxContext.SetPersistentDescriptorTable(2, m_MaterialTables[materialIdx]);
+            else
+                gfxContext.SetDynamicDescriptors(2, 0, 6, m_Model.GetSRVs(materialIdx) );
         }
 
         gfxContext.SetConstants(4, baseVertex, materialIdx);
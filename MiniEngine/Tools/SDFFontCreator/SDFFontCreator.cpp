@@ -7,6 +7,11 @@
 #include <vector>
 #include <algorithm>
 #include <intrin.h>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cfloat>
 
 #include FT_FREETYPE_H
 
@@ -39,12 +44,11 @@ bool g_fixNumberWidths = false; // Prints all numbers with fixed spacing
 uint16_t g_maxGlyphHeight = 0;  // Max height of glyph = ascender - descender
 int16_t g_fontOffset = 0;       // Baseline offset to center the text vertically
 uint16_t g_fontAdvanceY = 0;    // Distance from baseline to baseline (line height)
+bool g_antialias = false;       // Renders antialiased glyphs and places edges with sub-pixel precision
 
 float* g_DistanceMap = 0;
 uint32_t g_MapWidth = 0;
 uint32_t g_MapHeight = 0;
-volatile int32_t g_nextGlyphIdx = 0;
-volatile bool g_ReadyToPaint = false;
 
 void PrintAssertMessage( const char* file, uint32_t line, const char* cond, const char* msg, ...)
 {
@@ -126,6 +130,7 @@ struct Canvas
     uint32_t rows;        // Number of rows in the canvas
     uint32_t xOff;        // Amount to offset the x coordinate when reading
     uint32_t yOff;        // Amount to offset the y coordinate when reading
+    bool grayscale;        // Whether the canvas holds 8-bit coverage rather than 1-bit pixels
 };
 
 // Access the high res glyph canvas
@@ -142,6 +147,20 @@ inline bool ReadCanvasBit( const Canvas& canvas, uint32_t x, uint32_t y )
     return (canvas.bitmap[p] & (0x80 >> k)) ? true : false;
 }
 
+// Access the high res glyph canvas as coverage in [0, 255].  Monochrome canvases return 0 or 255.
+inline uint8_t ReadCanvasCoverage( const Canvas& canvas, uint32_t x, uint32_t y )
+{
+    if (!canvas.grayscale)
+        return ReadCanvasBit(canvas, x, y) ? 255 : 0;
+
+    x -= canvas.xOff;
+    y -= canvas.yOff;
+    if (x >= canvas.width || y >= canvas.rows)
+        return 0;
+
+    return canvas.bitmap[y * canvas.pitch + x];
+}
+
 // Setup pixel reads from the glyph canvas
 inline Canvas LoadCanvas(FT_GlyphSlot glyph)
 {
@@ -152,87 +171,159 @@ inline Canvas LoadCanvas(FT_GlyphSlot glyph)
     ret.rows = glyph->bitmap.rows;
     ret.xOff = g_borderSize * 16;
     ret.yOff = g_borderSize * 16 + g_maxGlyphHeight + g_fontOffset - (glyph->metrics.horiBearingY >> 6);
+    ret.grayscale = glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY;
     return ret;
 }
 
-float DistanceFromInside(const Canvas& canvas, uint32_t xCoord, uint32_t yCoord)
+// The distance transform works in half-pixel units of the high res canvas.  This puts the sample point at
+// the center of each distance map texel (x * 32 + 15) on an integer coordinate.  In monochrome mode, distance
+// is measured to the upper left corner of a canvas pixel (2 * x), and with antialiasing it is measured to the
+// pixel center (2 * x + 1) and then adjusted by the coverage of that pixel.
+struct DistanceScratch
 {
-    const uint32_t radius = g_maxDistance * 32;
-    const uint32_t x0 =    xCoord * 32 + 15;
-    const uint32_t y0 =    yCoord * 32 + 15;
+    vector<uint8_t> coverage;       // Canvas coverage (0..255) over the padded glyph cell
+    vector<int32_t> nearestLeft;    // Per canvas row, nearest feature at or left of each pixel
+    vector<int32_t> nearestRight;   // Per canvas row, nearest feature at or right of each pixel
+    vector<float> columnDistSq;     // Per texel column, squared horizontal distance to a feature in each canvas row
+    vector<int32_t> columnSite;     // Per texel column, the canvas x coordinate of that feature in each canvas row
+    vector<int32_t> hullSites;      // Lower envelope of parabolas (canvas rows)
+    vector<float> hullBounds;       // Boundaries between envelope parabolas
+};
+
+inline bool IsFeature( uint8_t coverage, bool featureIsInside )
+{
+    return (coverage >= 128) == featureIsInside;
+}
 
-    uint32_t left =        (uint32_t)max(0, (int32_t)(x0 - radius + 1));
-    uint32_t right =    x0 + radius - 1;
-    uint32_t top =        (uint32_t)max(0, (int32_t)(y0 - radius + 1));
-    uint32_t bottom =    y0 + radius - 1;
+// Computes the exact (capped) Euclidean distance from each texel center to the nearest canvas pixel whose
+// coverage state matches 'featureIsInside'.  This is a separable transform:  the first pass finds the nearest
+// feature along each canvas row for every texel column; the second pass takes the lower envelope of the
+// resulting parabolas down each texel column (Felzenszwalb & Huttenlocher).  Both passes are linear in the
+// number of canvas pixels, independent of the search radius.
+void ComputeDistanceField( DistanceScratch& scratch, uint32_t canvasWidth, uint32_t canvasHeight,
+    uint32_t texWidth, uint32_t texHeight, bool featureIsInside, bool antialias, float* distances )
+{
+    const int32_t kNoFeature = INT32_MIN / 4;
+    const float radius = (float)(g_maxDistance * 32);
+    const float maxDistSq = radius * radius;
+    const int32_t siteBias = antialias ? 1 : 0;
 
-    uint32_t bestDistSq = radius * radius;
+    scratch.columnDistSq.resize(texWidth * canvasHeight);
+    scratch.columnSite.resize(texWidth * canvasHeight);
 
-    for (uint32_t y1 = top; y1 <= bottom; y1 += 2)
+    // Pass 1:  Horizontal distance to the nearest feature in each row
+    for (uint32_t cy = 0; cy < canvasHeight; ++cy)
     {
-        int32_t distY = (int32_t)(y1 - y0);
-        uint32_t distYSq = (uint32_t)(distY * distY);
+        const uint8_t* row = &scratch.coverage[cy * canvasWidth];
 
-        if (distYSq >= bestDistSq)
+        int32_t last = kNoFeature;
+        for (uint32_t cx = 0; cx < canvasWidth; ++cx)
         {
-            if (y1 > y0)
-                continue;
-            else
-                break;
+            if (IsFeature(row[cx], featureIsInside))
+                last = (int32_t)cx;
+            scratch.nearestLeft[cx] = last;
         }
 
-        for (uint32_t x1 = left; x1 <= right; x1 += 2)
+        last = -kNoFeature;
+        for (uint32_t cx = canvasWidth; cx > 0; --cx)
         {
-            int32_t distX = (int32_t)(x1 - x0);
-            uint32_t distXSq = (uint32_t)(distX * distX);
-
-            uint32_t distSq = (uint32_t)(distXSq + distYSq);
-            if (distSq < bestDistSq && !ReadCanvasBit(canvas, x1 >> 1, y1 >> 1))
-                bestDistSq = distSq;
+            if (IsFeature(row[cx - 1], featureIsInside))
+                last = (int32_t)cx - 1;
+            scratch.nearestRight[cx - 1] = last;
         }
-    }
 
-    return sqrt((float)bestDistSq) / (float)radius;
-}
+        for (uint32_t x = 0; x < texWidth; ++x)
+        {
+            const int32_t q = (int32_t)x * 32 + 15;
 
-float DistanceFromOutside(const Canvas& canvas, uint32_t xCoord, uint32_t yCoord)
-{
-    const uint32_t radius = g_maxDistance * 32;
-    const uint32_t x0 =    xCoord * 32 + 15;
-    const uint32_t y0 =    yCoord * 32 + 15;
+            // Features at or left of canvas pixel 16x+7 lie before the sample point, the others after it
+            const int32_t left = scratch.nearestLeft[x * 16 + 7];
+            const int32_t right = scratch.nearestRight[x * 16 + 8];
+            const float distL = (float)(q - (left * 2 + siteBias));
+            const float distR = (float)((right * 2 + siteBias) - q);
 
-    uint32_t left =        (uint32_t)max(0, (int32_t)(x0 - radius + 1));
-    uint32_t right =    x0 + radius - 1;
-    uint32_t top =        (uint32_t)max(0, (int32_t)(y0 - radius + 1));
-    uint32_t bottom =    y0 + radius - 1;
+            float distSq = maxDistSq;
+            int32_t site = kNoFeature;
+            if (left != kNoFeature && distL * distL < distSq)
+            {
+                distSq = distL * distL;
+                site = left;
+            }
+            if (right != -kNoFeature && distR * distR < distSq)
+            {
+                distSq = distR * distR;
+                site = right;
+            }
 
-    uint32_t bestDistSq = radius * radius;
+            scratch.columnDistSq[x * canvasHeight + cy] = distSq;
+            scratch.columnSite[x * canvasHeight + cy] = site;
+        }
+    }
 
-    for (uint32_t y1 = top; y1 <= bottom; y1 += 2)
+    // Pass 2:  Lower envelope of parabolas down each texel column, evaluated at texel centers
+    for (uint32_t x = 0; x < texWidth; ++x)
     {
-        int32_t distY = (int32_t)(y1 - y0);
-        uint32_t distYSq = (uint32_t)(distY * distY);
+        const float* f = &scratch.columnDistSq[x * canvasHeight];
+        int32_t* hull = scratch.hullSites.data();
+        float* bounds = scratch.hullBounds.data();
+        int32_t k = -1;
 
-        if (distYSq >= bestDistSq)
+        for (uint32_t cy = 0; cy < canvasHeight; ++cy)
         {
-            if (y1 > y0)
+            // Rows without a feature in range can never produce a distance below the cap
+            if (f[cy] >= maxDistSq)
                 continue;
-            else
-                break;
+
+            const float p = (float)(cy * 2 + siteBias);
+            float s = -FLT_MAX;
+            while (k >= 0)
+            {
+                const float pk = (float)(hull[k] * 2 + siteBias);
+                s = ((f[cy] + p * p) - (f[hull[k]] + pk * pk)) / (2.0f * (p - pk));
+                if (s > bounds[k])
+                    break;
+                --k;
+            }
+
+            ++k;
+            hull[k] = (int32_t)cy;
+            bounds[k] = k == 0 ? -FLT_MAX : s;
         }
 
-        for (uint32_t x1 = left; x1 <= right; x1 += 2)
+        for (uint32_t y = 0, j = 0; y < texHeight; ++y)
         {
-            int32_t distX = (int32_t)(x1 - x0);
-            uint32_t distXSq = (uint32_t)(distX * distX);
+            float distSq = maxDistSq;
+            int32_t siteX = kNoFeature, siteY = kNoFeature;
 
-            uint32_t distSq = (uint32_t)(distXSq + distYSq);
-            if (distSq < bestDistSq && ReadCanvasBit(canvas, x1 >> 1, y1 >> 1))
-                bestDistSq = distSq;
+            if (k >= 0)
+            {
+                const float q = (float)(y * 32 + 15);
+                while ((int32_t)j < k && bounds[j + 1] < q)
+                    ++j;
+
+                const float dy = q - (float)(hull[j] * 2 + siteBias);
+                const float d = dy * dy + f[hull[j]];
+                if (d < distSq)
+                {
+                    distSq = d;
+                    siteY = hull[j];
+                    siteX = scratch.columnSite[x * canvasHeight + siteY];
+                }
+            }
+
+            float dist = sqrt(distSq);
+
+            // Sub-pixel edge placement:  a feature pixel with coverage at the threshold has the edge running
+            // through its center, while one with full (or no) coverage has the edge on its near boundary.
+            if (antialias && siteY != kNoFeature)
+            {
+                float a = scratch.coverage[siteY * canvasWidth + siteX] / 255.0f;
+                dist = max(0.0f, dist - 2.0f * fabs(a - 0.5f));
+            }
+
+            distances[y * texWidth + x] = min(dist / radius, 1.0f);
         }
     }
-
-    return sqrt((float)bestDistSq) / (float)radius;
 }
 
 // Get width and spacing of a given glyph to compute necessary space and layout in final texture.
@@ -283,15 +374,67 @@ uint32_t UnwrapUVs(uint32_t textureWidth)
     return (y + rowSize + glyphBorder) / 16;
 }
 
-void PaintCharacters( float* distanceMap, uint32_t width, uint32_t /*height*/ )
+// A queue of glyph indices shared by the painting threads.  Workers block until glyphs are pushed and
+// return once the queue has been closed and drained.
+class GlyphTaskQueue
 {
-    int32_t i = -1;
-    while ((i = _InterlockedExchangeAdd((volatile long*)&g_nextGlyphIdx, 1)) < g_numGlyphs)
+public:
+    void Push( uint16_t glyphIdx )
+    {
+        lock_guard<mutex> lock(m_Mutex);
+        m_Tasks.push_back(glyphIdx);
+        m_Available.notify_one();
+    }
+
+    void Close( void )
+    {
+        lock_guard<mutex> lock(m_Mutex);
+        m_Closed = true;
+        m_Available.notify_all();
+    }
+
+    bool Pop( uint16_t& glyphIdx )
     {
+        unique_lock<mutex> lock(m_Mutex);
+        m_Available.wait(lock, [this] { return m_Closed || !m_Tasks.empty(); });
+
+        if (m_Tasks.empty())
+            return false;
+
+        glyphIdx = m_Tasks.front();
+        m_Tasks.pop_front();
+        return true;
+    }
+
+private:
+    mutex m_Mutex;
+    condition_variable m_Available;
+    deque<uint16_t> m_Tasks;
+    bool m_Closed = false;
+};
+
+GlyphTaskQueue g_GlyphQueue;
+
+void PaintCharacters( void )
+{
+    // Scratch memory is reused for every glyph painted by this thread
+    DistanceScratch scratch;
+    vector<float> insideDist, outsideDist;
+
+    const uint32_t loadFlags = g_antialias ? FT_LOAD_RENDER :
+        FT_LOAD_RENDER | FT_LOAD_MONOCHROME | FT_LOAD_TARGET_MONO;
+
+    uint16_t i;
+    while (g_GlyphQueue.Pop(i))
+    {
+        // The layout and distance map are published before the first glyph is queued
+        float* distanceMap = g_DistanceMap;
+        const uint32_t width = g_MapWidth;
+
         // Get the character info
         const GlyphInfo& ch = g_glyphs[i];
 
-        if (FT_Load_Char( g_FreeTypeFace, ch.c, FT_LOAD_RENDER | FT_LOAD_MONOCHROME | FT_LOAD_TARGET_MONO ))
+        if (FT_Load_Char( g_FreeTypeFace, ch.c, loadFlags ))
             throw exception("Character bitmap rendering failed internally");
 
         Canvas canvas = LoadCanvas(g_FreeTypeFace->glyph);
@@ -300,22 +443,42 @@ void PaintCharacters( float* distanceMap, uint32_t width, uint32_t /*height*/ )
         uint32_t charHeight = align16(g_maxGlyphHeight) / 16;
         uint32_t startX = ch.u / 16 - g_borderSize;
         uint32_t startY = ch.v / 16 - g_borderSize;
+        uint32_t texWidth = charWidth + g_borderSize * 2;
+        uint32_t texHeight = charHeight + g_borderSize * 2;
+
+        // The canvas must extend one search radius beyond the last texel center
+        uint32_t canvasWidth = texWidth * 16 + g_maxDistance * 16;
+        uint32_t canvasHeight = texHeight * 16 + g_maxDistance * 16;
+
+        scratch.coverage.resize(canvasWidth * canvasHeight);
+        scratch.nearestLeft.resize(canvasWidth);
+        scratch.nearestRight.resize(canvasWidth);
+        scratch.hullSites.resize(canvasHeight);
+        scratch.hullBounds.resize(canvasHeight);
+
+        for (uint32_t cy = 0; cy < canvasHeight; ++cy)
+            for (uint32_t cx = 0; cx < canvasWidth; ++cx)
+                scratch.coverage[cy * canvasWidth + cx] = ReadCanvasCoverage(canvas, cx, cy);
+
+        insideDist.resize(texWidth * texHeight);
+        outsideDist.resize(texWidth * texHeight);
+        ComputeDistanceField(scratch, canvasWidth, canvasHeight, texWidth, texHeight, false, g_antialias, insideDist.data());
+        ComputeDistanceField(scratch, canvasWidth, canvasHeight, texWidth, texHeight, true, g_antialias, outsideDist.data());
 
         // Convert high-res bitmap to low-res distance map
-        for (uint32_t x = 0; x < charWidth + g_borderSize * 2; ++x)
+        for (uint32_t y = 0; y < texHeight; ++y)
         {
-            for (uint32_t y = 0; y < charHeight + g_borderSize * 2; ++y)
+            for (uint32_t x = 0; x < texWidth; ++x)
             {
-                uint32_t left = x * 16 + 7;
-                uint32_t top = y * 16 + 7;
+                const uint8_t* center = &scratch.coverage[(y * 16 + 7) * canvasWidth + x * 16 + 7];
 
-                bool inside = ReadCanvasBit(canvas, left, top) & ReadCanvasBit(canvas, left + 1, top) &
-                    ReadCanvasBit(canvas, left, top + 1) & ReadCanvasBit(canvas, left + 1, top + 1);
+                bool inside = center[0] >= 128 && center[1] >= 128 &&
+                    center[canvasWidth] >= 128 && center[canvasWidth + 1] >= 128;
 
                 if (inside)
-                    distanceMap[startX + x + (startY + y) * width] = +DistanceFromInside(canvas, x, y);
+                    distanceMap[startX + x + (startY + y) * width] = +insideDist[y * texWidth + x];
                 else
-                    distanceMap[startX + x + (startY + y) * width] = -DistanceFromOutside(canvas, x, y);
+                    distanceMap[startX + x + (startY + y) * width] = -outsideDist[y * texWidth + x];
             }
         }
     }
@@ -326,11 +489,7 @@ void WorkerFunc( void )
     // We can initialize FreeType while we wait to paint the alphabet
     InitializeFont();
 
-    // Sleep for 2 milliseconds per iteration until we're ready to paint
-    while (!g_ReadyToPaint)
-        std::this_thread::sleep_for(std::chrono::milliseconds(2));
-
-    PaintCharacters(g_DistanceMap, g_MapWidth, g_MapHeight);
+    PaintCharacters();
 
     ShutdownFont();
 }
@@ -471,13 +630,20 @@ void CompileFont(const string& outputName)
     for (size_t x = g_MapWidth * g_MapHeight; x > 0; --x)
         g_DistanceMap[x - 1] = -1.0f;
 
-    // Make sure all of the parameters are flushed to memory before we trigger the threads to paint.
-    __faststorefence();
+    // Queue the widest glyphs first so that the threads finish at about the same time.  Queueing through
+    // the mutex also publishes the layout parameters to the painting threads.
+    vector<uint16_t> glyphOrder(g_numGlyphs);
+    for (uint16_t i = 0; i < g_numGlyphs; ++i)
+        glyphOrder[i] = i;
+    stable_sort(glyphOrder.begin(), glyphOrder.end(),
+        []( uint16_t a, uint16_t b ) { return g_glyphs[a].width > g_glyphs[b].width; });
 
-    g_ReadyToPaint = true;
+    for (uint16_t i : glyphOrder)
+        g_GlyphQueue.Push(i);
+    g_GlyphQueue.Close();
 
     // Also paint on the main thread
-    PaintCharacters(g_DistanceMap, g_MapWidth, g_MapHeight);
+    PaintCharacters();
 
     // Wait for all of the other threads
     if (numThreads > 0)
@@ -563,7 +729,9 @@ void main( int argc, const char** argv )
             if (argv[arg][0] != '-')
                 throw exception("Malformed option");
 
-            if (arg + 1 == argc)
+            if (strcmp("-antialias", argv[arg]) == 0)
+                g_antialias = true;
+            else if (arg + 1 == argc)
                 throw exception("Missing operand");
             else if (strcmp("-size", argv[arg]) == 0)
                 size = atoi(argv[++arg]);
@@ -591,6 +759,7 @@ void main( int argc, const char** argv )
             "-size <integer>\n\tThe font pixel resolution.\n"
             "-radius <integer>\n\tThe search radius.\n\tDefaults to font size / 8.\n"
             "-border_size <integer>\n\tExtra spacing around glyphs for various effects.\n\tDefaults to the search radius.\n"
+            "-antialias\n\tPlace glyph edges with sub-pixel precision using antialiased rendering.\n"
             "\n\nExample:  %s myfont.ttf -character_set Japanese.txt -output japanese\n\n", e.what(), argv[0], argv[0]);
         return;
     }
@@ -625,8 +794,11 @@ void main( int argc, const char** argv )
     else
         printf("Character Set: %s\n", characterSet.c_str());
     printf("Output Name: %s\n", outputName.c_str());
+    printf("Antialiasing: %s\n", g_antialias ? "On" : "Off");
     printf("Threads: %u\n\n", std::thread::hardware_concurrency());
 
+    auto startTime = std::chrono::high_resolution_clock::now();
+
     try 
     {
         InitializeFont( inputFile.c_str(), size * 16 );
@@ -683,7 +855,8 @@ void main( int argc, const char** argv )
         CompileFont(outputName);
 
         printf("\nComplete!\n");
-        //printf("Elapsed Time: %g sec\n", t.getElapsed());
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+        printf("Elapsed Time: %g sec\n", elapsed.count());
     }
     catch (wofstream::failure& e)
     {
@@ -0,0 +1,185 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "stdafx.h"
+#include "FenceService.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FenceServiceTests
+{
+    // A fence the test signals by hand.  Like an ID3D12Fence it sets an event as soon as it is armed for a
+    // value that has already completed, and it remembers the value it was last armed for.
+    class SimulatedFence : public FenceService::Fence
+    {
+    public:
+        SimulatedFence() : m_CompletedValue(0), m_ArmedValue(0) {}
+
+        uint64_t GetCompletedValue( void ) override
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            return m_CompletedValue;
+        }
+
+        void SetEventOnCompletion( uint64_t Value, HANDLE Event ) override
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            m_ArmedValue = Value;
+            if (Value <= m_CompletedValue)
+                SetEvent(Event);
+            else
+                m_Waits.push_back(std::make_pair(Value, Event));
+        }
+
+        void Signal( uint64_t Value )
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            m_CompletedValue = Value;
+
+            auto Reached = std::partition(m_Waits.begin(), m_Waits.end(),
+                [Value]( const std::pair<uint64_t, HANDLE>& Wait ) { return Wait.first > Value; });
+            for (auto It = Reached; It != m_Waits.end(); ++It)
+                SetEvent(It->second);
+            m_Waits.erase(Reached, m_Waits.end());
+        }
+
+        uint64_t GetArmedValue( void )
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            return m_ArmedValue;
+        }
+
+    private:
+        std::mutex m_Mutex;
+        uint64_t m_CompletedValue;
+        uint64_t m_ArmedValue;
+        std::vector<std::pair<uint64_t, HANDLE>> m_Waits;
+    };
+
+    // The service runs its callbacks on a thread of its own, so the tests poll for what they expect, giving
+    // up after long enough that a pass can't depend on timing.
+    template <typename Predicate>
+    bool WaitUntil( Predicate IsDone )
+    {
+        auto Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!IsDone())
+        {
+            if (std::chrono::steady_clock::now() > Deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    TEST_CLASS(FenceServiceTests)
+    {
+    public:
+
+        TEST_METHOD(WaiterOnEarlierValueWakesFirst)
+        {
+            SimulatedFence Fence;
+            FenceService Service;
+            Service.Start(&Fence);
+
+            std::atomic<bool> Woke99(false), Woke100(false);
+            std::thread Waiter100([&] { Service.Wait(100); Woke100 = true; });
+            std::thread Waiter99([&] { Service.Wait(99); Woke99 = true; });
+
+            Fence.Signal(99);
+            Assert::IsTrue(WaitUntil([&] { return Woke99.load(); }), L"The waiter on 99 did not wake when 99 completed");
+            Assert::IsFalse(Woke100.load(), L"The waiter on 100 woke before 100 completed");
+
+            Fence.Signal(100);
+            Waiter99.join();
+            Waiter100.join();
+            Assert::IsTrue(Woke100.load());
+
+            Service.Stop();
+        }
+
+        TEST_METHOD(CallbacksRunInFenceOrder)
+        {
+            SimulatedFence Fence;
+            FenceService Service;
+            Service.Start(&Fence);
+
+            std::mutex OrderMutex;
+            std::vector<int> Order;
+            auto Record = [&]( int Id ) { return [&, Id] { std::lock_guard<std::mutex> LockGuard(OrderMutex); Order.push_back(Id); }; };
+
+            // Ids are the expected order: by fence value, then by registration for the same value.
+            Service.OnCompletion(3, Record(3));
+            Service.OnCompletion(1, Record(0));
+            Service.OnCompletion(2, Record(1));
+            Service.OnCompletion(2, Record(2));
+
+            Fence.Signal(3);
+            Assert::IsTrue(WaitUntil([&] { std::lock_guard<std::mutex> LockGuard(OrderMutex); return Order.size() == 4; }));
+
+            for (int i = 0; i < 4; ++i)
+                Assert::AreEqual(i, Order[i]);
+
+            Service.Stop();
+        }
+
+        TEST_METHOD(RearmsForEarlierValueRegisteredLater)
+        {
+            SimulatedFence Fence;
+            FenceService Service;
+            Service.Start(&Fence);
+
+            std::atomic<bool> Completed50(false), Completed100(false);
+            Service.OnCompletion(100, [&] { Completed100 = true; });
+            Assert::IsTrue(WaitUntil([&] { return Fence.GetArmedValue() == 100; }), L"The watcher did not arm for 100");
+
+            Service.OnCompletion(50, [&] { Completed50 = true; });
+            Assert::IsTrue(WaitUntil([&] { return Fence.GetArmedValue() == 50; }), L"The watcher did not re-arm for 50");
+
+            Fence.Signal(50);
+            Assert::IsTrue(WaitUntil([&] { return Completed50.load(); }));
+            Assert::IsFalse(Completed100.load());
+            Assert::IsTrue(WaitUntil([&] { return Fence.GetArmedValue() == 100; }), L"The watcher did not re-arm for 100");
+
+            Fence.Signal(100);
+            Assert::IsTrue(WaitUntil([&] { return Completed100.load(); }));
+
+            Service.Stop();
+        }
+
+        TEST_METHOD(StopCompletesOutstandingWaiters)
+        {
+            SimulatedFence Fence;
+            FenceService Service;
+            Service.Start(&Fence);
+
+            std::atomic<bool> Woke(false);
+            std::thread Waiter([&] { Service.Wait(10); Woke = true; });
+            Assert::IsTrue(WaitUntil([&] { return Fence.GetArmedValue() == 10; }), L"The waiter never registered");
+
+            std::atomic<bool> Stopped(false);
+            std::thread Stopper([&] { Service.Stop(); Stopped = true; });
+
+            // Stop() has to wait for the fence, as the GPU may still be using what the waiter is after.
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::IsFalse(Stopped.load());
+            Assert::IsFalse(Woke.load());
+
+            Fence.Signal(10);
+            Stopper.join();
+            Waiter.join();
+            Assert::IsTrue(Woke.load());
+            Assert::IsFalse(Service.IsRunning());
+        }
+    };
+}
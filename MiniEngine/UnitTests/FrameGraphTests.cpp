@@ -0,0 +1,323 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "stdafx.h"
+#include "FrameGraph.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+// The graphs are only compiled, with transient resources described by their memory, so no device is needed.
+namespace FrameGraphTests
+{
+    const uint64_t KB = 1024;
+    const D3D12_RESOURCE_STATES UAV = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    const D3D12_RESOURCE_STATES SRV = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    const D3D12_RESOURCE_STATES PSRV = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+
+    typedef FrameGraph::Barrier Barrier;
+
+    FrameGraph::ResourceHandle CreateBuffer( FrameGraph& Graph, const wchar_t* Name, uint64_t SizeInBytes )
+    {
+        return Graph.CreateTransient(Name, FrameGraph::kBufferHeap, SizeInBytes, 64 * KB);
+    }
+
+    uint32_t CountBarriers( const FrameGraph& Graph, FrameGraph::PassHandle Pass, Barrier::BarrierType Type )
+    {
+        uint32_t Count = 0;
+        for (auto& B : Graph.GetBarriers(Pass))
+        {
+            if (B.Type == Type)
+                ++Count;
+        }
+        return Count;
+    }
+
+    const Barrier* FindBarrier( const FrameGraph& Graph, FrameGraph::PassHandle Pass, Barrier::BarrierType Type,
+        FrameGraph::ResourceHandle Resource )
+    {
+        for (auto& B : Graph.GetBarriers(Pass))
+        {
+            if (B.Type == Type && B.Resource == Resource)
+                return &B;
+        }
+        return nullptr;
+    }
+
+    TEST_CLASS(CompileTests)
+    {
+    public:
+
+        TEST_METHOD(LifetimesSpanFirstToLastUse)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle A = CreateBuffer(Graph, L"A", 64 * KB);
+            FrameGraph::ResourceHandle B = CreateBuffer(Graph, L"B", 64 * KB);
+            FrameGraph::ResourceHandle Unused = CreateBuffer(Graph, L"Unused", 64 * KB);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, A, UAV);
+            FrameGraph::PassHandle P1 = Graph.AddPass(L"P1");
+            Graph.Read(P1, A, SRV);
+            Graph.Write(P1, B, UAV);
+            Graph.AddPass(L"P2");
+            FrameGraph::PassHandle P3 = Graph.AddPass(L"P3");
+            Graph.Read(P3, A, SRV);
+            Graph.Read(P3, B, SRV);
+            Graph.Compile();
+
+            Assert::AreEqual(P0, Graph.GetFirstPass(A));
+            Assert::AreEqual(P3, Graph.GetLastPass(A));
+            Assert::AreEqual(P1, Graph.GetFirstPass(B));
+            Assert::AreEqual(P3, Graph.GetLastPass(B));
+            Assert::AreEqual((uint32_t)FrameGraph::kInvalidHandle, Graph.GetFirstPass(Unused));
+
+            // Resources no pass uses take no memory
+            Assert::AreEqual(2u, Graph.GetStatistics().NumTransientResources);
+        }
+
+        TEST_METHOD(ResourcesWithDisjointLifetimesShareMemory)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle A = CreateBuffer(Graph, L"A", 64 * KB);
+            FrameGraph::ResourceHandle B = CreateBuffer(Graph, L"B", 64 * KB);
+            FrameGraph::ResourceHandle C = CreateBuffer(Graph, L"C", 64 * KB);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, A, UAV);
+            FrameGraph::PassHandle P1 = Graph.AddPass(L"P1");
+            Graph.Read(P1, A, SRV);
+            Graph.Write(P1, B, UAV);
+            FrameGraph::PassHandle P2 = Graph.AddPass(L"P2");
+            Graph.Read(P2, B, SRV);
+            Graph.Write(P2, C, UAV);
+            FrameGraph::PassHandle P3 = Graph.AddPass(L"P3");
+            Graph.Read(P3, C, SRV);
+            Graph.Compile();
+
+            // B is alive with A and with C, but C only starts after A is done
+            Assert::AreEqual(0ull, Graph.GetHeapOffset(A));
+            Assert::AreEqual(64 * KB, Graph.GetHeapOffset(B));
+            Assert::AreEqual(0ull, Graph.GetHeapOffset(C));
+
+            const FrameGraph::Statistics& Stats = Graph.GetStatistics();
+            Assert::AreEqual(192 * KB, Stats.SeparateBytes);
+            Assert::AreEqual(128 * KB, Stats.AliasedBytes);
+            Assert::AreEqual(128 * KB, Stats.HeapBytes[FrameGraph::kBufferHeap]);
+            Assert::AreEqual(0ull, Stats.HeapBytes[FrameGraph::kTextureHeap]);
+
+            // C takes the memory over from A, and A takes it back from C in the next frame
+            const Barrier* Aliasing = FindBarrier(Graph, P2, Barrier::kAliasing, C);
+            Assert::IsTrue(Aliasing != nullptr);
+            Assert::AreEqual(A, Aliasing->AliasedResource);
+
+            Aliasing = FindBarrier(Graph, P0, Barrier::kAliasing, A);
+            Assert::IsTrue(Aliasing != nullptr);
+            Assert::AreEqual(C, Aliasing->AliasedResource);
+
+            Assert::IsTrue(FindBarrier(Graph, P1, Barrier::kAliasing, B) == nullptr);
+            Assert::AreEqual(0u, CountBarriers(Graph, P3, Barrier::kAliasing));
+            Assert::AreEqual(2u, Stats.NumAliasingBarriers);
+        }
+
+        TEST_METHOD(AlignsHeapOffsets)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle Small = Graph.CreateTransient(L"Small", FrameGraph::kTextureHeap, 4 * KB, 4 * KB);
+            FrameGraph::ResourceHandle Large = Graph.CreateTransient(L"Large", FrameGraph::kTextureHeap, 96 * KB, 64 * KB);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, Small, UAV);
+            Graph.Write(P0, Large, UAV);
+            Graph.Compile();
+
+            // The largest resource is placed first, and the small one right after it at its own alignment
+            Assert::AreEqual(0ull, Graph.GetHeapOffset(Large));
+            Assert::AreEqual(96 * KB, Graph.GetHeapOffset(Small));
+            Assert::AreEqual(100 * KB, Graph.GetStatistics().HeapBytes[FrameGraph::kTextureHeap]);
+        }
+
+        TEST_METHOD(HeapClassesDontShareMemory)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle Texture = Graph.CreateTransient(L"Texture", FrameGraph::kTextureHeap, 64 * KB, 64 * KB);
+            FrameGraph::ResourceHandle Buffer = CreateBuffer(Graph, L"Buffer", 64 * KB);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, Texture, UAV);
+            FrameGraph::PassHandle P1 = Graph.AddPass(L"P1");
+            Graph.Write(P1, Buffer, UAV);
+            Graph.Compile();
+
+            Assert::AreEqual(0ull, Graph.GetHeapOffset(Texture));
+            Assert::AreEqual(0ull, Graph.GetHeapOffset(Buffer));
+            Assert::AreEqual(0u, Graph.GetStatistics().NumAliasingBarriers);
+        }
+
+        TEST_METHOD(ConsecutiveReadsShareOneTransition)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle Imported = Graph.ImportResource(L"Imported", nullptr);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, Imported, UAV);
+            FrameGraph::PassHandle P1 = Graph.AddPass(L"P1");
+            Graph.Read(P1, Imported, SRV);
+            FrameGraph::PassHandle P2 = Graph.AddPass(L"P2");
+            Graph.Read(P2, Imported, PSRV);
+            FrameGraph::PassHandle P3 = Graph.AddPass(L"P3");
+            Graph.Write(P3, Imported, UAV);
+            Graph.Compile();
+
+            // The state of an imported resource is only known when the graph is executed
+            const Barrier* First = FindBarrier(Graph, P0, Barrier::kTransition, Imported);
+            Assert::IsTrue(First != nullptr);
+            Assert::IsTrue(First->StateBefore == FrameGraph::kUnknownState && First->StateAfter == UAV);
+
+            const Barrier* Read = FindBarrier(Graph, P1, Barrier::kTransition, Imported);
+            Assert::IsTrue(Read != nullptr);
+            Assert::IsTrue(Read->StateBefore == UAV && Read->StateAfter == (SRV | PSRV));
+            Assert::AreEqual(0u, (uint32_t)Graph.GetBarriers(P2).size());
+
+            const Barrier* Write = FindBarrier(Graph, P3, Barrier::kTransition, Imported);
+            Assert::IsTrue(Write != nullptr);
+            Assert::IsTrue(Write->StateBefore == (SRV | PSRV) && Write->StateAfter == UAV);
+
+            Assert::AreEqual(3u, Graph.GetStatistics().NumBarriers);
+            Assert::AreEqual(0u, Graph.GetStatistics().NumTransientResources);
+        }
+
+        TEST_METHOD(TransitionsAreSplitAcrossIdlePasses)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle Idle = Graph.ImportResource(L"Idle", nullptr);
+            FrameGraph::ResourceHandle Busy = Graph.ImportResource(L"Busy", nullptr);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, Idle, UAV);
+            Graph.Write(P0, Busy, UAV);
+            FrameGraph::PassHandle P1 = Graph.AddPass(L"P1");
+            Graph.Read(P1, Busy, SRV);
+            FrameGraph::PassHandle P2 = Graph.AddPass(L"P2");
+            FrameGraph::PassHandle P3 = Graph.AddPass(L"P3");
+            Graph.Read(P3, Idle, SRV);
+            Graph.Compile();
+
+            // Idle isn't used by P1 or P2, so its transition begins right after P0 and ends before P3
+            const Barrier* Begin = FindBarrier(Graph, P1, Barrier::kBeginTransition, Idle);
+            Assert::IsTrue(Begin != nullptr);
+            Assert::IsTrue(Begin->StateBefore == UAV && Begin->StateAfter == SRV);
+
+            const Barrier* End = FindBarrier(Graph, P3, Barrier::kEndTransition, Idle);
+            Assert::IsTrue(End != nullptr);
+            Assert::IsTrue(End->StateBefore == UAV && End->StateAfter == SRV);
+
+            Assert::AreEqual(0u, (uint32_t)Graph.GetBarriers(P2).size());
+            Assert::IsTrue(FindBarrier(Graph, P3, Barrier::kTransition, Idle) == nullptr);
+
+            // Busy is read by the very next pass, so there is nothing to split
+            Assert::IsTrue(FindBarrier(Graph, P1, Barrier::kTransition, Busy) != nullptr);
+            Assert::IsTrue(FindBarrier(Graph, P1, Barrier::kBeginTransition, Busy) == nullptr);
+
+            Assert::AreEqual(1u, Graph.GetStatistics().NumSplitBarriers);
+        }
+
+        TEST_METHOD(ConsecutiveWritesAreSeparatedByUAVBarriers)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle Buffer = CreateBuffer(Graph, L"Buffer", 64 * KB);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, Buffer, UAV);
+            FrameGraph::PassHandle P1 = Graph.AddPass(L"P1");
+            Graph.Write(P1, Buffer, UAV);
+            Graph.Compile();
+
+            Assert::IsTrue(FindBarrier(Graph, P1, Barrier::kUAV, Buffer) != nullptr);
+            Assert::AreEqual(0u, CountBarriers(Graph, P1, Barrier::kTransition));
+        }
+
+        TEST_METHOD(TransientTexturesAreDiscardedFirst)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle Texture = Graph.CreateTransient(L"Texture", FrameGraph::kTextureHeap, 64 * KB, 64 * KB);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, Texture, UAV);
+            Graph.Compile();
+
+            // Render targets must be discarded before they are used, and the discard isn't a barrier
+            const std::vector<Barrier>& Barriers = Graph.GetBarriers(P0);
+            Assert::AreEqual(3u, (uint32_t)Barriers.size());
+            Assert::IsTrue(Barriers[0].Type == Barrier::kTransition && Barriers[0].StateAfter == D3D12_RESOURCE_STATE_RENDER_TARGET);
+            Assert::IsTrue(Barriers[1].Type == Barrier::kDiscard);
+            Assert::IsTrue(Barriers[2].Type == Barrier::kTransition && Barriers[2].StateBefore == D3D12_RESOURCE_STATE_RENDER_TARGET &&
+                Barriers[2].StateAfter == UAV);
+            Assert::AreEqual(2u, Graph.GetStatistics().NumBarriers);
+        }
+
+        TEST_METHOD(AliasingBarrierNamesNoResourceWhenSeveralUsedTheMemory)
+        {
+            FrameGraph Graph;
+            FrameGraph::ResourceHandle Low = CreateBuffer(Graph, L"Low", 64 * KB);
+            FrameGraph::ResourceHandle High = CreateBuffer(Graph, L"High", 64 * KB);
+            FrameGraph::ResourceHandle Large = CreateBuffer(Graph, L"Large", 128 * KB);
+
+            FrameGraph::PassHandle P0 = Graph.AddPass(L"P0");
+            Graph.Write(P0, Low, UAV);
+            Graph.Write(P0, High, UAV);
+            FrameGraph::PassHandle P1 = Graph.AddPass(L"P1");
+            Graph.Read(P1, Low, SRV);
+            Graph.Read(P1, High, SRV);
+            Graph.Write(P1, Large, UAV);
+            FrameGraph::PassHandle P2 = Graph.AddPass(L"P2");
+            Graph.Read(P2, Large, SRV);
+            Graph.Compile();
+
+            // Large overlaps the lifetimes of Low and High, so it gets memory of its own
+            Assert::AreEqual(0ull, Graph.GetHeapOffset(Large));
+            Assert::IsTrue(Graph.GetHeapOffset(Low) >= 128 * KB && Graph.GetHeapOffset(High) >= 128 * KB);
+            Assert::AreEqual(0u, Graph.GetStatistics().NumAliasingBarriers);
+
+            // Once the read moves a pass later, Large takes over the memory of both
+            FrameGraph Later;
+            Low = CreateBuffer(Later, L"Low", 64 * KB);
+            High = CreateBuffer(Later, L"High", 64 * KB);
+            Large = CreateBuffer(Later, L"Large", 128 * KB);
+
+            P0 = Later.AddPass(L"P0");
+            Later.Write(P0, Low, UAV);
+            Later.Write(P0, High, UAV);
+            P1 = Later.AddPass(L"P1");
+            Later.Read(P1, Low, SRV);
+            Later.Read(P1, High, SRV);
+            P2 = Later.AddPass(L"P2");
+            Later.Write(P2, Large, UAV);
+            Later.Compile();
+
+            Assert::AreEqual(0ull, Later.GetHeapOffset(Large));
+            Assert::AreEqual(0ull, Later.GetHeapOffset(Low));
+            Assert::AreEqual(64 * KB, Later.GetHeapOffset(High));
+
+            const Barrier* Aliasing = FindBarrier(Later, P2, Barrier::kAliasing, Large);
+            Assert::IsTrue(Aliasing != nullptr);
+            Assert::AreEqual((uint32_t)FrameGraph::kInvalidHandle, Aliasing->AliasedResource);
+
+            // Low and High each take their part back from Large alone
+            Aliasing = FindBarrier(Later, P0, Barrier::kAliasing, Low);
+            Assert::IsTrue(Aliasing != nullptr);
+            Assert::AreEqual(Large, Aliasing->AliasedResource);
+
+            Aliasing = FindBarrier(Later, P0, Barrier::kAliasing, High);
+            Assert::IsTrue(Aliasing != nullptr);
+            Assert::AreEqual(Large, Aliasing->AliasedResource);
+        }
+    };
+}
@@ -0,0 +1,196 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "stdafx.h"
+#include "FramePacer.h"
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FramePacerTests
+{
+    // A graphics queue on a simulated clock.  It runs the frames it is given one after another, and each frame
+    // takes the same number of ticks.
+    class SimulatedQueue
+    {
+    public:
+        SimulatedQueue( int64_t FrameTicks ) : m_FrameTicks(FrameTicks), m_BusyUntil(0) {}
+
+        uint64_t Submit( int64_t Tick )
+        {
+            m_BusyUntil = std::max(m_BusyUntil, Tick) + m_FrameTicks;
+            m_CompleteTicks.push_back(m_BusyUntil);
+            return m_CompleteTicks.size();
+        }
+
+        int64_t GetCompleteTick( uint64_t Fence ) const { return m_CompleteTicks[Fence - 1]; }
+        bool IsFenceComplete( uint64_t Fence, int64_t Tick ) const { return GetCompleteTick(Fence) <= Tick; }
+
+    private:
+        int64_t m_FrameTicks;
+        int64_t m_BusyUntil;
+        std::vector<int64_t> m_CompleteTicks;
+    };
+
+    // Drives the pacer the way Graphics::Present() does: each frame is recorded, submitted and ended, then the
+    // CPU waits for the fence the pacer asks for, retires what has completed, and begins the next frame.
+    class Simulation
+    {
+    public:
+        Simulation( FramePacer::Policy Policy, uint32_t MaxQueuedFrames, int64_t CpuTicks, int64_t GpuTicks )
+            : m_Queue(GpuTicks), m_CpuTicks(CpuTicks), m_Tick(0), m_MaxQueueDepth(0)
+        {
+            m_Pacer.SetPolicy(Policy, MaxQueuedFrames);
+            m_Pacer.BeginFrame(m_Tick, 0);
+        }
+
+        void RunFrames( uint32_t NumFrames )
+        {
+            for (uint32_t i = 0; i < NumFrames; ++i)
+            {
+                m_Tick += m_CpuTicks;
+                m_Pacer.EndFrame(m_Tick, m_Queue.Submit(m_Tick));
+                m_MaxQueueDepth = std::max(m_MaxQueueDepth, m_Pacer.GetQueueDepth());
+
+                int64_t WaitStartTick = m_Tick;
+                uint64_t WaitFence = m_Pacer.GetFenceToWaitFor();
+                if (WaitFence != 0)
+                    m_Tick = std::max(m_Tick, m_Queue.GetCompleteTick(WaitFence));
+
+                uint64_t PendingFence;
+                while ((PendingFence = m_Pacer.GetOldestPendingFence()) != 0 && m_Queue.IsFenceComplete(PendingFence, m_Tick))
+                    m_Pacer.CompleteFrames(PendingFence, m_Tick);
+
+                m_Pacer.BeginFrame(m_Tick, m_Tick - WaitStartTick);
+            }
+        }
+
+        FramePacer& GetPacer( void ) { return m_Pacer; }
+        int64_t GetTick( void ) const { return m_Tick; }
+        uint32_t GetMaxQueueDepth( void ) const { return m_MaxQueueDepth; }
+
+    private:
+        FramePacer m_Pacer;
+        SimulatedQueue m_Queue;
+        int64_t m_CpuTicks;
+        int64_t m_Tick;
+        uint32_t m_MaxQueueDepth;
+    };
+
+    const uint32_t kWarmUpFrames = 10;
+    const uint32_t kMeasuredFrames = 100;
+
+    TEST_CLASS(FramePacerTests)
+    {
+    public:
+
+        TEST_METHOD(LowLatencyKeepsOneFrameQueued)
+        {
+            // GPU bound: the CPU records in 4 ticks, and the GPU takes 10
+            Simulation Sim(FramePacer::kLowLatency, 3, 4, 10);
+            Sim.RunFrames(kWarmUpFrames);
+            Sim.GetPacer().ResetStatistics();
+
+            int64_t StartTick = Sim.GetTick();
+            Sim.RunFrames(kMeasuredFrames);
+
+            // Each frame waits for the one before it, so the GPU idles while the CPU records
+            const FramePacer::Statistics& Stats = Sim.GetPacer().GetStatistics();
+            Assert::AreEqual(kMeasuredFrames, Stats.NumFrames);
+            Assert::AreEqual(1u, Sim.GetMaxQueueDepth());
+            Assert::AreEqual((uint64_t)kMeasuredFrames, Stats.TotalQueueDepth);
+            Assert::AreEqual(14ll * kMeasuredFrames, Stats.TotalLatency);
+            Assert::AreEqual(14ll, Stats.MaxLatency);
+            Assert::AreEqual(10ll * kMeasuredFrames, Stats.TotalWait);
+            Assert::AreEqual(14ll * kMeasuredFrames, Sim.GetTick() - StartTick);
+        }
+
+        TEST_METHOD(MaxThroughputFillsTheQueue)
+        {
+            Simulation Sim(FramePacer::kMaxThroughput, 3, 4, 10);
+            Sim.RunFrames(kWarmUpFrames);
+            Sim.GetPacer().ResetStatistics();
+
+            int64_t StartTick = Sim.GetTick();
+            Sim.RunFrames(kMeasuredFrames);
+
+            // The GPU never idles, so a frame completes every 10 ticks, but each frame waits behind the two
+            // queued ahead of it
+            const FramePacer::Statistics& Stats = Sim.GetPacer().GetStatistics();
+            Assert::AreEqual(kMeasuredFrames, Stats.NumFrames);
+            Assert::AreEqual(3u, Sim.GetMaxQueueDepth());
+            Assert::AreEqual(3ull * kMeasuredFrames, Stats.TotalQueueDepth);
+            Assert::AreEqual(30ll * kMeasuredFrames, Stats.TotalLatency);
+            Assert::AreEqual(30ll, Stats.MaxLatency);
+            Assert::AreEqual(10ll * kMeasuredFrames, Sim.GetTick() - StartTick);
+        }
+
+        TEST_METHOD(LowLatencyWaitsForTheGpuWhenCpuBound)
+        {
+            Simulation Sim(FramePacer::kLowLatency, 3, 10, 4);
+            Sim.RunFrames(kWarmUpFrames);
+            Sim.GetPacer().ResetStatistics();
+            Sim.RunFrames(kMeasuredFrames);
+
+            const FramePacer::Statistics& Stats = Sim.GetPacer().GetStatistics();
+            Assert::AreEqual(kMeasuredFrames, Stats.NumFrames);
+            Assert::AreEqual(14ll, Stats.MaxLatency);
+            Assert::AreEqual(4ll * kMeasuredFrames, Stats.TotalWait);
+
+            const FramePacer::FrameTiming& Last = Sim.GetPacer().GetLastCompletedFrame();
+            Assert::AreEqual(10ll, Last.SubmitTick - Last.StartTick);
+            Assert::AreEqual(4ll, Last.CompleteTick - Last.SubmitTick);
+            Assert::AreEqual(1u, Last.QueueDepth);
+        }
+
+        TEST_METHOD(MaxThroughputDoesntWaitWhenCpuBound)
+        {
+            Simulation Sim(FramePacer::kMaxThroughput, 3, 10, 4);
+            Sim.RunFrames(kWarmUpFrames);
+            Sim.GetPacer().ResetStatistics();
+            Sim.RunFrames(kMeasuredFrames);
+
+            // Frames finish while the CPU records the next one, so completion is only seen a frame later
+            const FramePacer::Statistics& Stats = Sim.GetPacer().GetStatistics();
+            Assert::AreEqual(0ll, Stats.TotalWait);
+            Assert::AreEqual(2u, Sim.GetMaxQueueDepth());
+            Assert::AreEqual(20ll, Stats.MaxLatency);
+        }
+
+        TEST_METHOD(FramesBeginRightAwayUntilTheQueueIsFull)
+        {
+            FramePacer Pacer;
+            Pacer.SetPolicy(FramePacer::kMaxThroughput, 3);
+
+            Pacer.BeginFrame(0, 0);
+            Pacer.EndFrame(1, 1);
+            Assert::AreEqual(0ull, Pacer.GetFenceToWaitFor());
+            Pacer.BeginFrame(1, 0);
+            Pacer.EndFrame(2, 2);
+            Assert::AreEqual(0ull, Pacer.GetFenceToWaitFor());
+            Pacer.BeginFrame(2, 0);
+            Pacer.EndFrame(3, 3);
+            Assert::AreEqual(1ull, Pacer.GetFenceToWaitFor());
+            Assert::AreEqual(3u, Pacer.GetQueueDepth());
+
+            // Switching to low latency waits for everything that is queued
+            Pacer.SetPolicy(FramePacer::kLowLatency, 3);
+            Assert::AreEqual(3ull, Pacer.GetFenceToWaitFor());
+
+            Pacer.CompleteFrames(2, 10);
+            Assert::AreEqual(1u, Pacer.GetQueueDepth());
+            Assert::AreEqual(3ull, Pacer.GetOldestPendingFence());
+            Assert::AreEqual(1ull, Pacer.GetLastCompletedFrame().FrameIndex);
+            Assert::AreEqual(2u, Pacer.GetStatistics().NumFrames);
+            Assert::AreEqual(10ll + 9ll, Pacer.GetStatistics().TotalLatency);
+        }
+    };
+}
@@ -0,0 +1,196 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "stdafx.h"
+#include "NullDevice.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using Microsoft::WRL::ComPtr;
+
+namespace NullDeviceTests
+{
+    TEST_CLASS(NullDeviceTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(CreateDevice)
+        {
+            m_Device.Attach(NullDevice::Create());
+            NullDevice::ResetStats();
+
+            D3D12_COMMAND_QUEUE_DESC QueueDesc = {};
+            QueueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+            Assert::IsTrue(SUCCEEDED(m_Device->CreateCommandQueue(&QueueDesc, IID_PPV_ARGS(&m_Queue))));
+            Assert::IsTrue(SUCCEEDED(m_Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_Fence))));
+        }
+
+        TEST_METHOD(QueueSignalsFenceAsSoonAsItIsQueued)
+        {
+            HANDLE Event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+            Assert::IsTrue(SUCCEEDED(m_Queue->Signal(m_Fence.Get(), 5)));
+            Assert::IsTrue(m_Fence->GetCompletedValue() == 5);
+
+            m_Fence->SetEventOnCompletion(5, Event);
+            Assert::IsTrue(WaitForSingleObject(Event, 0) == WAIT_OBJECT_0, L"The event for a completed value was not set");
+
+            // A value that hasn't been queued yet still has to wait for it.
+            m_Fence->SetEventOnCompletion(6, Event);
+            Assert::IsTrue(WaitForSingleObject(Event, 0) == WAIT_TIMEOUT, L"The event was set before its value was signaled");
+
+            m_Queue->Signal(m_Fence.Get(), 6);
+            Assert::IsTrue(WaitForSingleObject(Event, 0) == WAIT_OBJECT_0, L"Signaling the value did not set its event");
+
+            CloseHandle(Event);
+        }
+
+        TEST_METHOD(ExecutingCountsRecordedCommands)
+        {
+            ComPtr<ID3D12CommandAllocator> Allocator;
+            ComPtr<ID3D12GraphicsCommandList> CommandList;
+            Assert::IsTrue(SUCCEEDED(m_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&Allocator))));
+            Assert::IsTrue(SUCCEEDED(m_Device->CreateCommandList(1, D3D12_COMMAND_LIST_TYPE_DIRECT, Allocator.Get(), nullptr, IID_PPV_ARGS(&CommandList))));
+
+            // Commands from before a reset are dropped.
+            CommandList->DrawInstanced(3, 1, 0, 0);
+            CommandList->Close();
+            CommandList->Reset(Allocator.Get(), nullptr);
+
+            D3D12_VIEWPORT Viewports[2] = {};
+            const UINT Constants[4] = { 1, 2, 3, 4 };
+            CommandList->RSSetViewports(2, Viewports);
+            CommandList->SetGraphicsRoot32BitConstants(0, 4, Constants, 0);
+            CommandList->DrawIndexedInstanced(36, 1, 0, 0, 0);
+            CommandList->Close();
+
+            ID3D12CommandList* Lists[] = { CommandList.Get(), CommandList.Get() };
+            m_Queue->ExecuteCommandLists(_countof(Lists), Lists);
+
+            NullDeviceStats Stats = NullDevice::ResetStats();
+            Assert::AreEqual(2u, (uint32_t)Stats.NumExecutedCommandLists);
+            Assert::AreEqual(6u, (uint32_t)Stats.NumExecutedCommands);
+
+            // Each command holds at least its arguments, arrays included.
+            const uint64_t MinBytesPerExecution = sizeof(Viewports) + sizeof(Constants) + 5 * sizeof(UINT);
+            Assert::IsTrue(Stats.NumExecutedBytes >= 2 * MinBytesPerExecution);
+
+            Stats = NullDevice::ResetStats();
+            Assert::AreEqual(0u, (uint32_t)Stats.NumExecutedCommands);
+        }
+
+        TEST_METHOD(BuffersAreBackedByMemory)
+        {
+            CD3DX12_HEAP_PROPERTIES HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+            CD3DX12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(1024);
+            ComPtr<ID3D12Resource> Buffer;
+            Assert::IsTrue(SUCCEEDED(m_Device->CreateCommittedResource(&HeapProperties, D3D12_HEAP_FLAG_NONE, &Desc,
+                D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&Buffer))));
+
+            uint32_t* pData = nullptr;
+            Assert::IsTrue(SUCCEEDED(Buffer->Map(0, nullptr, (void**)&pData)));
+            Assert::IsTrue(pData != nullptr);
+            Assert::AreEqual(0u, pData[255], L"Buffers should start out zeroed");
+            pData[255] = 0xC0FFEE;
+            Buffer->Unmap(0, nullptr);
+
+            // The GPU virtual address is the memory itself, so it's aligned like a placed resource.
+            Assert::IsTrue(Buffer->GetGPUVirtualAddress() == (D3D12_GPU_VIRTUAL_ADDRESS)pData);
+            Assert::IsTrue(Buffer->GetGPUVirtualAddress() % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT == 0);
+
+            // Placed buffers share their heap's memory.
+            D3D12_HEAP_DESC HeapDesc = {};
+            HeapDesc.SizeInBytes = 4 * D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+            HeapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+            HeapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            ComPtr<ID3D12Heap> Heap;
+            ComPtr<ID3D12Resource> First, Second;
+            Assert::IsTrue(SUCCEEDED(m_Device->CreateHeap(&HeapDesc, IID_PPV_ARGS(&Heap))));
+            Assert::IsTrue(SUCCEEDED(m_Device->CreatePlacedResource(Heap.Get(), 0, &Desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&First))));
+            Assert::IsTrue(SUCCEEDED(m_Device->CreatePlacedResource(Heap.Get(), 2 * D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, &Desc,
+                D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&Second))));
+            Assert::IsTrue(Second->GetGPUVirtualAddress() - First->GetGPUVirtualAddress() == 2 * D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+        }
+
+        TEST_METHOD(CopyDescriptorsMovesViewsBetweenRanges)
+        {
+            D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = { D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 8, D3D12_DESCRIPTOR_HEAP_FLAG_NONE, 1 };
+            ComPtr<ID3D12DescriptorHeap> Source, Dest;
+            Assert::IsTrue(SUCCEEDED(m_Device->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(&Source))));
+            HeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+            Assert::IsTrue(SUCCEEDED(m_Device->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(&Dest))));
+            Assert::IsTrue(Dest->GetGPUDescriptorHandleForHeapStart().ptr != 0);
+            Assert::IsTrue(Source->GetGPUDescriptorHandleForHeapStart().ptr == 0, L"Only shader visible heaps have GPU handles");
+
+            const UINT Increment = m_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+            const D3D12_CPU_DESCRIPTOR_HANDLE SourceStart = Source->GetCPUDescriptorHandleForHeapStart();
+            const D3D12_CPU_DESCRIPTOR_HANDLE DestStart = Dest->GetCPUDescriptorHandleForHeapStart();
+
+            // A different view in each of the first four source descriptors
+            for (UINT i = 0; i < 4; ++i)
+            {
+                D3D12_CONSTANT_BUFFER_VIEW_DESC ViewDesc = { 0x10000 * (i + 1), 256 };
+                D3D12_CPU_DESCRIPTOR_HANDLE Handle = { SourceStart.ptr + i * Increment };
+                m_Device->CreateConstantBufferView(&ViewDesc, Handle);
+            }
+
+            // Source ranges of 1 and 3 into destination ranges of 2 and 2, the second one starting at 5
+            D3D12_CPU_DESCRIPTOR_HANDLE SourceStarts[] = { SourceStart, { SourceStart.ptr + Increment } };
+            UINT SourceSizes[] = { 1, 3 };
+            D3D12_CPU_DESCRIPTOR_HANDLE DestStarts[] = { DestStart, { DestStart.ptr + 5 * Increment } };
+            UINT DestSizes[] = { 2, 2 };
+            m_Device->CopyDescriptors(2, DestStarts, DestSizes, 2, SourceStarts, SourceSizes, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+            const UINT DestIndices[] = { 0, 1, 5, 6 };
+            for (UINT i = 0; i < 4; ++i)
+            {
+                Assert::IsTrue(memcmp((const void*)(SourceStart.ptr + i * Increment), (const void*)(DestStart.ptr + DestIndices[i] * Increment), Increment) == 0,
+                    L"A descriptor was not copied to its place");
+            }
+
+            static const uint8_t Zeros[64] = {};
+            Assert::IsTrue(memcmp((const void*)(DestStart.ptr + 2 * Increment), Zeros, Increment) == 0, L"A descriptor outside the ranges was written");
+        }
+
+        TEST_METHOD(FootprintsPitchRowsAndAlignSubresources)
+        {
+            // 2 mips of a 256x256 BC1 texture:  64 rows of 64 eight byte blocks, then 32 rows of 32
+            D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_BC1_UNORM, 256, 256, 1, 2);
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT Layouts[2];
+            UINT NumRows[2];
+            UINT64 RowSizes[2];
+            UINT64 TotalBytes = 0;
+            m_Device->GetCopyableFootprints(&Desc, 0, 2, 0, Layouts, NumRows, RowSizes, &TotalBytes);
+
+            Assert::AreEqual(64u, NumRows[0]);
+            Assert::AreEqual(512u, (uint32_t)RowSizes[0]);
+            Assert::AreEqual(512u, Layouts[0].Footprint.RowPitch);
+
+            Assert::AreEqual(32u, NumRows[1]);
+            Assert::AreEqual(256u, (uint32_t)RowSizes[1]);
+            Assert::AreEqual((uint32_t)D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, Layouts[1].Footprint.RowPitch);
+            Assert::AreEqual(64u * 512u, (uint32_t)Layouts[1].Offset);
+            Assert::AreEqual(64u * 512u + 31u * 256u + 256u, (uint32_t)TotalBytes);
+
+            // A 3 texel wide row of a 32 bit format is pitched up to 256 bytes, and the next mip starts on a
+            // 512 byte boundary.
+            Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 3, 3, 1, 2);
+            m_Device->GetCopyableFootprints(&Desc, 0, 2, 0, Layouts, NumRows, RowSizes, &TotalBytes);
+            Assert::AreEqual(12u, (uint32_t)RowSizes[0]);
+            Assert::AreEqual(256u, Layouts[0].Footprint.RowPitch);
+            Assert::AreEqual(1024u, (uint32_t)Layouts[1].Offset);
+        }
+
+    private:
+        ComPtr<ID3D12Device> m_Device;
+        ComPtr<ID3D12CommandQueue> m_Queue;
+        ComPtr<ID3D12Fence> m_Fence;
+    };
+}
@@ -0,0 +1,222 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+// Measures how long the affinity layer takes to record a frame into the command lists of two
+// linked nodes, once by recording every command into each node's list as it comes in, and once by
+// recording a command stream and replaying it onto each node when the list is closed. The native
+// command lists are mocks that only count commands, so the times are the cost of the layer itself.
+
+#include "stdafx.h"
+#include "MockD3D12.h"
+
+using Microsoft::WRL::ComPtr;
+
+static const UINT NodeCount = 2;
+static const UINT DrawsPerFrame = 10000;
+static const UINT DrawsPerPipelineState = 16;
+static const UINT PipelineStateCount = 8;
+static const UINT DescriptorTableCount = 64;
+static const UINT WarmUpFrames = 10;
+static const UINT MeasuredFrames = 100;
+
+// In LDA mode the layer expects a descriptor handle to point at one handle per node.
+static UINT64 RenderTargetViews[1][D3DX12_MAX_ACTIVE_NODES];
+static UINT64 DepthStencilViews[1][D3DX12_MAX_ACTIVE_NODES];
+static UINT64 DescriptorTables[DescriptorTableCount][D3DX12_MAX_ACTIVE_NODES];
+
+struct BenchmarkResult
+{
+    double CpuRecordMs;
+    double CpuCloseMs;
+    UINT64 NumCommands[NodeCount];
+};
+
+inline void ThrowIfFailed(HRESULT hr)
+{
+    if (FAILED(hr))
+    {
+        throw hr;
+    }
+}
+
+static void RecordFrame(
+    CD3DX12AffinityGraphicsCommandList* pCommandList,
+    CD3DX12AffinityRootSignature* pRootSignature,
+    ComPtr<CD3DX12AffinityPipelineState>* pPipelineStates)
+{
+    D3D12_VIEWPORT const Viewport = { 0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f };
+    D3D12_RECT const ScissorRect = { 0, 0, 1280, 720 };
+    FLOAT const ClearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView;
+    RenderTargetView.ptr = reinterpret_cast<SIZE_T>(RenderTargetViews[0]);
+    D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView;
+    DepthStencilView.ptr = reinterpret_cast<SIZE_T>(DepthStencilViews[0]);
+
+    pCommandList->SetGraphicsRootSignature(pRootSignature);
+    pCommandList->RSSetViewports(1, &Viewport);
+    pCommandList->RSSetScissorRects(1, &ScissorRect);
+    pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->OMSetRenderTargets(1, &RenderTargetView, FALSE, &DepthStencilView);
+    pCommandList->ClearRenderTargetView(RenderTargetView, ClearColor, 0, nullptr);
+    pCommandList->ClearDepthStencilView(DepthStencilView, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+
+    for (UINT i = 0; i < DrawsPerFrame; i++)
+    {
+        if (i % DrawsPerPipelineState == 0)
+        {
+            pCommandList->SetPipelineState(pPipelineStates[(i / DrawsPerPipelineState) % PipelineStateCount].Get());
+        }
+
+        D3D12_GPU_DESCRIPTOR_HANDLE DescriptorTable;
+        DescriptorTable.ptr = reinterpret_cast<UINT64>(DescriptorTables[i % DescriptorTableCount]);
+
+        UINT const Constants[4] = { i, i + 1, i + 2, i + 3 };
+
+        D3D12_VERTEX_BUFFER_VIEW VertexBufferView;
+        VertexBufferView.BufferLocation = 0x10000 + i * 0x1000;
+        VertexBufferView.SizeInBytes = 0x1000;
+        VertexBufferView.StrideInBytes = 32;
+
+        D3D12_INDEX_BUFFER_VIEW IndexBufferView;
+        IndexBufferView.BufferLocation = 0x80000000 + i * 0x400;
+        IndexBufferView.SizeInBytes = 0x400;
+        IndexBufferView.Format = DXGI_FORMAT_R16_UINT;
+
+        pCommandList->SetGraphicsRootDescriptorTable(0, DescriptorTable);
+        pCommandList->SetGraphicsRootConstantBufferView(1, 0x40000000 + i * 256);
+        pCommandList->SetGraphicsRoot32BitConstants(2, 4, Constants, 0);
+        pCommandList->IASetVertexBuffers(0, 1, &VertexBufferView);
+        pCommandList->IASetIndexBuffer(&IndexBufferView);
+        pCommandList->DrawIndexedInstanced(512, 1, 0, 0, 0);
+    }
+}
+
+static BenchmarkResult RunBenchmark(CD3DX12AffinityDevice* pDevice, bool RecordCommandStream)
+{
+    ComPtr<CD3DX12AffinityCommandAllocator> CommandAllocator;
+    ComPtr<CD3DX12AffinityGraphicsCommandList> CommandList;
+    ComPtr<CD3DX12AffinityRootSignature> RootSignature;
+    ComPtr<CD3DX12AffinityPipelineState> PipelineStates[PipelineStateCount];
+
+    UINT const AllNodes = (1 << NodeCount) - 1;
+    ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&CommandAllocator)));
+    ThrowIfFailed(pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, CommandAllocator.Get(), nullptr, IID_PPV_ARGS(&CommandList), AllNodes));
+    ThrowIfFailed(CommandList->Close());
+    CommandList->SetRecordCommandStream(RecordCommandStream);
+
+    // The mock device ignores the root signature blob.
+    UINT const RootSignatureBlob = 0;
+    ThrowIfFailed(pDevice->CreateRootSignature(0, &RootSignatureBlob, sizeof(RootSignatureBlob), IID_PPV_ARGS(&RootSignature)));
+
+    for (UINT i = 0; i < PipelineStateCount; i++)
+    {
+        ID3D12PipelineState* NodePipelineStates[NodeCount];
+        for (UINT n = 0; n < NodeCount; n++)
+        {
+            NodePipelineStates[n] = new MockPipelineState();
+        }
+        PipelineStates[i].Attach(new CD3DX12AffinityPipelineState(pDevice, NodePipelineStates, NodeCount));
+    }
+
+    BenchmarkResult Result = {};
+    LARGE_INTEGER Frequency;
+    QueryPerformanceFrequency(&Frequency);
+
+    for (UINT Frame = 0; Frame < WarmUpFrames + MeasuredFrames; Frame++)
+    {
+        LARGE_INTEGER Start, Recorded, Closed;
+
+        QueryPerformanceCounter(&Start);
+        ThrowIfFailed(CommandList->Reset(CommandAllocator.Get(), nullptr));
+        RecordFrame(CommandList.Get(), RootSignature.Get(), PipelineStates);
+        QueryPerformanceCounter(&Recorded);
+        ThrowIfFailed(CommandList->Close());
+        QueryPerformanceCounter(&Closed);
+
+        if (Frame >= WarmUpFrames)
+        {
+            Result.CpuRecordMs += 1000.0 * (Recorded.QuadPart - Start.QuadPart) / Frequency.QuadPart;
+            Result.CpuCloseMs += 1000.0 * (Closed.QuadPart - Recorded.QuadPart) / Frequency.QuadPart;
+        }
+    }
+
+    Result.CpuRecordMs /= MeasuredFrames;
+    Result.CpuCloseMs /= MeasuredFrames;
+
+    for (UINT n = 0; n < NodeCount; n++)
+    {
+        Result.NumCommands[n] = static_cast<MockGraphicsCommandList*>(CommandList->GetChildObject(n))->GetNumCommands();
+    }
+
+    return Result;
+}
+
+static void PrintResult(const char* Name, const BenchmarkResult& Result)
+{
+    printf("%-24s record %8.3f ms  close %8.3f ms  total %8.3f ms  commands",
+        Name, Result.CpuRecordMs, Result.CpuCloseMs, Result.CpuRecordMs + Result.CpuCloseMs);
+    for (UINT n = 0; n < NodeCount; n++)
+    {
+        printf(" %llu", Result.NumCommands[n]);
+    }
+    printf("\n");
+}
+
+int main()
+{
+    for (UINT i = 0; i < DescriptorTableCount; i++)
+    {
+        for (UINT n = 0; n < D3DX12_MAX_ACTIVE_NODES; n++)
+        {
+            DescriptorTables[i][n] = 0x100000000ull * (n + 1) + i * 32;
+        }
+    }
+    for (UINT n = 0; n < D3DX12_MAX_ACTIVE_NODES; n++)
+    {
+        RenderTargetViews[0][n] = 0x1000 * (n + 1);
+        DepthStencilViews[0][n] = 0x1000 * (n + 1) + 0x100;
+    }
+
+    try
+    {
+        ComPtr<CD3DX12AffinityDevice> Device;
+        {
+            ComPtr<ID3D12Device> MockedDevice;
+            MockedDevice.Attach(new MockDevice(NodeCount));
+            ThrowIfFailed(D3DX12AffinityCreateLDADevice(MockedDevice.Get(), &Device));
+        }
+
+        printf("%u draws per frame on %u nodes, averaged over %u frames\n", DrawsPerFrame, NodeCount, MeasuredFrames);
+
+        BenchmarkResult const Direct = RunBenchmark(Device.Get(), false);
+        BenchmarkResult const Stream = RunBenchmark(Device.Get(), true);
+
+        PrintResult("Per-node recording", Direct);
+        PrintResult("Command stream replay", Stream);
+
+        for (UINT n = 0; n < NodeCount; n++)
+        {
+            if (Direct.NumCommands[n] != Stream.NumCommands[n])
+            {
+                printf("Node %u got %llu commands from the command stream instead of %llu\n", n, Stream.NumCommands[n], Direct.NumCommands[n]);
+                return 1;
+            }
+        }
+    }
+    catch (HRESULT hr)
+    {
+        printf("Failed with HRESULT 0x%08X\n", static_cast<UINT>(hr));
+        return 1;
+    }
+
+    return 0;
+}
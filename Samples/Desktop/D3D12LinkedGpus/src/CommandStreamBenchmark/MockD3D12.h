@@ -0,0 +1,327 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// D3D12 objects that do no work, so that the benchmark only measures the affinity layer. The
+// mock device creates the other mocks and ignores the requested interface IDs, since the
+// affinity layer always asks for the interface it stores.
+
+template <typename Interface>
+class MockObject : public Interface
+{
+public:
+    MockObject() : mReferenceCount(1) {}
+    virtual ~MockObject() {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override
+    {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(Interface))
+        {
+            *ppvObject = static_cast<Interface*>(this);
+            AddRef();
+            return S_OK;
+        }
+
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return InterlockedIncrement(&mReferenceCount);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG const ReferenceCount = InterlockedDecrement(&mReferenceCount);
+        if (ReferenceCount == 0)
+        {
+            delete this;
+        }
+        return ReferenceCount;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT*, void*) override { return DXGI_ERROR_NOT_FOUND; }
+    HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void*) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, const IUnknown*) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE SetName(LPCWSTR) override { return S_OK; }
+
+private:
+    ULONG mReferenceCount;
+};
+
+template <typename Interface>
+class MockDeviceChild : public MockObject<Interface>
+{
+public:
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID, void** ppvDevice) override
+    {
+        *ppvDevice = nullptr;
+        return E_NOTIMPL;
+    }
+};
+
+class MockCommandAllocator : public MockDeviceChild<ID3D12CommandAllocator>
+{
+public:
+    HRESULT STDMETHODCALLTYPE Reset() override { return S_OK; }
+};
+
+class MockPipelineState : public MockDeviceChild<ID3D12PipelineState>
+{
+public:
+    HRESULT STDMETHODCALLTYPE GetCachedBlob(ID3DBlob** ppBlob) override
+    {
+        *ppBlob = nullptr;
+        return E_NOTIMPL;
+    }
+};
+
+class MockRootSignature : public MockDeviceChild<ID3D12RootSignature>
+{
+};
+
+class MockFence : public MockDeviceChild<ID3D12Fence>
+{
+public:
+    MockFence(UINT64 InitialValue) : mValue(InitialValue) {}
+
+    UINT64 STDMETHODCALLTYPE GetCompletedValue() override { return mValue; }
+
+    HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64, HANDLE hEvent) override
+    {
+        // Work completes as soon as it is submitted.
+        if (hEvent)
+        {
+            SetEvent(hEvent);
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Signal(UINT64 Value) override
+    {
+        mValue = Value;
+        return S_OK;
+    }
+
+private:
+    UINT64 mValue;
+};
+
+class MockCommandQueue : public MockDeviceChild<ID3D12CommandQueue>
+{
+public:
+    MockCommandQueue(const D3D12_COMMAND_QUEUE_DESC& Desc) : mDesc(Desc) {}
+
+    void STDMETHODCALLTYPE UpdateTileMappings(ID3D12Resource*, UINT, const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*, ID3D12Heap*, UINT, const D3D12_TILE_RANGE_FLAGS*, const UINT*, const UINT*, D3D12_TILE_MAPPING_FLAGS) override {}
+    void STDMETHODCALLTYPE CopyTileMappings(ID3D12Resource*, const D3D12_TILED_RESOURCE_COORDINATE*, ID3D12Resource*, const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*, D3D12_TILE_MAPPING_FLAGS) override {}
+    void STDMETHODCALLTYPE ExecuteCommandLists(UINT, ID3D12CommandList* const*) override {}
+    void STDMETHODCALLTYPE SetMarker(UINT, const void*, UINT) override {}
+    void STDMETHODCALLTYPE BeginEvent(UINT, const void*, UINT) override {}
+    void STDMETHODCALLTYPE EndEvent() override {}
+    HRESULT STDMETHODCALLTYPE Signal(ID3D12Fence* pFence, UINT64 Value) override { return pFence->Signal(Value); }
+    HRESULT STDMETHODCALLTYPE Wait(ID3D12Fence*, UINT64) override { return S_OK; }
+
+    HRESULT STDMETHODCALLTYPE GetTimestampFrequency(UINT64* pFrequency) override
+    {
+        *pFrequency = 1;
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetClockCalibration(UINT64* pGpuTimestamp, UINT64* pCpuTimestamp) override
+    {
+        *pGpuTimestamp = 0;
+        *pCpuTimestamp = 0;
+        return S_OK;
+    }
+
+    D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc() override { return mDesc; }
+
+private:
+    D3D12_COMMAND_QUEUE_DESC mDesc;
+};
+
+// Counts the commands recorded into it, so that the benchmark can check that every node got the
+// whole frame.
+class MockGraphicsCommandList : public MockDeviceChild<ID3D12GraphicsCommandList>
+{
+public:
+    MockGraphicsCommandList(D3D12_COMMAND_LIST_TYPE Type) : mType(Type), mNumCommands(0) {}
+
+    UINT64 GetNumCommands() const { return mNumCommands; }
+
+    D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType() override { return mType; }
+
+    HRESULT STDMETHODCALLTYPE Close() override { return S_OK; }
+
+    HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator*, ID3D12PipelineState*) override
+    {
+        mNumCommands = 0;
+        return S_OK;
+    }
+
+    void STDMETHODCALLTYPE ClearState(ID3D12PipelineState*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE DrawInstanced(UINT, UINT, UINT, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE Dispatch(UINT, UINT, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE CopyBufferRegion(ID3D12Resource*, UINT64, ID3D12Resource*, UINT64, UINT64) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION*, UINT, UINT, UINT, const D3D12_TEXTURE_COPY_LOCATION*, const D3D12_BOX*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE CopyResource(ID3D12Resource*, ID3D12Resource*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE CopyTiles(ID3D12Resource*, const D3D12_TILED_RESOURCE_COORDINATE*, const D3D12_TILE_REGION_SIZE*, ID3D12Resource*, UINT64, D3D12_TILE_COPY_FLAGS) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ResolveSubresource(ID3D12Resource*, UINT, ID3D12Resource*, UINT, DXGI_FORMAT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE RSSetViewports(UINT, const D3D12_VIEWPORT*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE RSSetScissorRects(UINT, const D3D12_RECT*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE OMSetBlendFactor(const FLOAT[4]) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE OMSetStencilRef(UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetPipelineState(ID3D12PipelineState*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ResourceBarrier(UINT, const D3D12_RESOURCE_BARRIER*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ExecuteBundle(ID3D12GraphicsCommandList*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetComputeRootSignature(ID3D12RootSignature*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetGraphicsRootSignature(ID3D12RootSignature*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetComputeRoot32BitConstant(UINT, UINT, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant(UINT, UINT, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetComputeRoot32BitConstants(UINT, UINT, const void*, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants(UINT, UINT, const void*, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetComputeRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetComputeRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SOSetTargets(UINT, UINT, const D3D12_STREAM_OUTPUT_BUFFER_VIEW*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE OMSetRenderTargets(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, BOOL, const D3D12_CPU_DESCRIPTOR_HANDLE*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CLEAR_FLAGS, FLOAT, UINT8, UINT, const D3D12_RECT*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE, const FLOAT[4], UINT, const D3D12_RECT*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, ID3D12Resource*, const UINT[4], UINT, const D3D12_RECT*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, ID3D12Resource*, const FLOAT[4], UINT, const D3D12_RECT*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE DiscardResource(ID3D12Resource*, const D3D12_DISCARD_REGION*) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE BeginQuery(ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE EndQuery(ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ResolveQueryData(ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT, UINT, ID3D12Resource*, UINT64) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetPredication(ID3D12Resource*, UINT64, D3D12_PREDICATION_OP) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE SetMarker(UINT, const void*, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE BeginEvent(UINT, const void*, UINT) override { ++mNumCommands; }
+    void STDMETHODCALLTYPE EndEvent() override { ++mNumCommands; }
+    void STDMETHODCALLTYPE ExecuteIndirect(ID3D12CommandSignature*, UINT, ID3D12Resource*, UINT64, ID3D12Resource*, UINT64) override { ++mNumCommands; }
+
+private:
+    D3D12_COMMAND_LIST_TYPE mType;
+    UINT64 mNumCommands;
+};
+
+// A device with linked nodes, which only creates the objects the benchmark needs.
+class MockDevice : public MockObject<ID3D12Device>
+{
+public:
+    MockDevice(UINT NodeCount) : mNodeCount(NodeCount) {}
+
+    UINT STDMETHODCALLTYPE GetNodeCount() override { return mNodeCount; }
+
+    HRESULT STDMETHODCALLTYPE CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID, void** ppCommandQueue) override
+    {
+        *ppCommandQueue = static_cast<ID3D12CommandQueue*>(new MockCommandQueue(*pDesc));
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE, REFIID, void** ppCommandAllocator) override
+    {
+        *ppCommandAllocator = static_cast<ID3D12CommandAllocator*>(new MockCommandAllocator());
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID, void** ppPipelineState) override
+    {
+        *ppPipelineState = static_cast<ID3D12PipelineState*>(new MockPipelineState());
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC*, REFIID, void** ppPipelineState) override
+    {
+        *ppPipelineState = static_cast<ID3D12PipelineState*>(new MockPipelineState());
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommandList(UINT, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator*, ID3D12PipelineState*, REFIID, void** ppCommandList) override
+    {
+        *ppCommandList = static_cast<ID3D12GraphicsCommandList*>(new MockGraphicsCommandList(type));
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CheckFeatureSupport(D3D12_FEATURE, void*, UINT) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC*, REFIID, void**) override { return E_NOTIMPL; }
+    UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) override { return 32; }
+
+    HRESULT STDMETHODCALLTYPE CreateRootSignature(UINT, const void*, SIZE_T, REFIID, void** ppvRootSignature) override
+    {
+        *ppvRootSignature = static_cast<ID3D12RootSignature*>(new MockRootSignature());
+        return S_OK;
+    }
+
+    void STDMETHODCALLTYPE CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+    void STDMETHODCALLTYPE CreateShaderResourceView(ID3D12Resource*, const D3D12_SHADER_RESOURCE_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+    void STDMETHODCALLTYPE CreateUnorderedAccessView(ID3D12Resource*, ID3D12Resource*, const D3D12_UNORDERED_ACCESS_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+    void STDMETHODCALLTYPE CreateRenderTargetView(ID3D12Resource*, const D3D12_RENDER_TARGET_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+    void STDMETHODCALLTYPE CreateDepthStencilView(ID3D12Resource*, const D3D12_DEPTH_STENCIL_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+    void STDMETHODCALLTYPE CreateSampler(const D3D12_SAMPLER_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) override {}
+    void STDMETHODCALLTYPE CopyDescriptors(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, const UINT*, UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, const UINT*, D3D12_DESCRIPTOR_HEAP_TYPE) override {}
+    void STDMETHODCALLTYPE CopyDescriptorsSimple(UINT, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_DESCRIPTOR_HEAP_TYPE) override {}
+
+    D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(UINT, UINT, const D3D12_RESOURCE_DESC*) override
+    {
+        D3D12_RESOURCE_ALLOCATION_INFO Info = {};
+        return Info;
+    }
+
+    D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties(UINT, D3D12_HEAP_TYPE) override
+    {
+        D3D12_HEAP_PROPERTIES Properties = {};
+        return Properties;
+    }
+
+    HRESULT STDMETHODCALLTYPE CreateCommittedResource(const D3D12_HEAP_PROPERTIES*, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC*, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void**) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateHeap(const D3D12_HEAP_DESC*, REFIID, void**) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreatePlacedResource(ID3D12Heap*, UINT64, const D3D12_RESOURCE_DESC*, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void**) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateReservedResource(const D3D12_RESOURCE_DESC*, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void**) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE CreateSharedHandle(ID3D12DeviceChild*, const SECURITY_ATTRIBUTES*, DWORD, LPCWSTR, HANDLE*) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE OpenSharedHandle(HANDLE, REFIID, void**) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE OpenSharedHandleByName(LPCWSTR, DWORD, HANDLE*) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE MakeResident(UINT, ID3D12Pageable* const*) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE Evict(UINT, ID3D12Pageable* const*) override { return S_OK; }
+
+    HRESULT STDMETHODCALLTYPE CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS, REFIID, void** ppFence) override
+    {
+        *ppFence = static_cast<ID3D12Fence*>(new MockFence(InitialValue));
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() override { return S_OK; }
+    void STDMETHODCALLTYPE GetCopyableFootprints(const D3D12_RESOURCE_DESC*, UINT, UINT, UINT64, D3D12_PLACED_SUBRESOURCE_FOOTPRINT*, UINT*, UINT64*, UINT64*) override {}
+    HRESULT STDMETHODCALLTYPE CreateQueryHeap(const D3D12_QUERY_HEAP_DESC*, REFIID, void**) override { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE SetStablePowerState(BOOL) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC*, ID3D12RootSignature*, REFIID, void**) override { return E_NOTIMPL; }
+    void STDMETHODCALLTYPE GetResourceTiling(ID3D12Resource*, UINT*, D3D12_PACKED_MIP_INFO*, D3D12_TILE_SHAPE*, UINT*, UINT, D3D12_SUBRESOURCE_TILING*) override {}
+
+    LUID STDMETHODCALLTYPE GetAdapterLuid() override
+    {
+        LUID Luid = {};
+        return Luid;
+    }
+
+private:
+    UINT mNodeCount;
+};
@@ -16,6 +16,11 @@ void STDMETHODCALLTYPE CD3DX12AffinityGraphicsCommandList::SetAffinity(UINT Affi
 {
     CD3DX12AffinityObject::SetAffinity(AffinityMask);
     mAccumulatedAffinityMask |= AffinityMask;
+
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetAffinityMask(AffinityMask);
+    }
 }
 
 D3D12_COMMAND_LIST_TYPE CD3DX12AffinityGraphicsCommandList::GetType()
@@ -25,6 +30,11 @@ D3D12_COMMAND_LIST_TYPE CD3DX12AffinityGraphicsCommandList::GetType()
 
 HRESULT CD3DX12AffinityGraphicsCommandList::Close()
 {
+    if (mRecordCommandStream)
+    {
+        ReplayCommandStream();
+    }
+
 #if ALWAYS_RESET_ALL_COMMAND_LISTS
     for (UINT i = 0; i < GetNodeCount(); ++i)
     {
@@ -55,6 +65,8 @@ HRESULT CD3DX12AffinityGraphicsCommandList::Reset(
     CD3DX12AffinityCommandAllocator* pAllocator,
     CD3DX12AffinityPipelineState* pInitialState)
 {
+    mRecordCommandStream = mRecordCommandStreamOnReset;
+
     if (mUseDeviceActiveMaskOnReset)
     {
         mAccumulatedAffinityMask = 0;
@@ -83,12 +95,97 @@ HRESULT CD3DX12AffinityGraphicsCommandList::Reset(
         }
     }
 
+    if (mRecordCommandStream)
+    {
+        mCommandStream.Reset(mAffinityMask);
+    }
+
     return S_OK;
 }
 
+void CD3DX12AffinityGraphicsCommandList::ReplayCommandStream()
+{
+    // The first node replays on the calling thread, every other node on its replay worker.
+    UINT const RecordedNodeMask = mCommandStream.GetRecordedNodeMask();
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+    UINT CallingThreadNode = D3DX12_MAX_ACTIVE_NODES;
+
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    {
+        if (((1 << i) & RecordedNodeMask) != 0 && mGraphicsCommandLists[i])
+        {
+            if (CallingThreadNode == D3DX12_MAX_ACTIVE_NODES)
+            {
+                CallingThreadNode = i;
+            }
+            else
+            {
+                // Workers are started the first time their node replays, and then kept until the command list
+                // is destroyed.
+                if (!mReplayWorkers[i])
+                {
+                    mReplayWorkers[i].reset(new ReplayWorker());
+                    mReplayWorkers[i]->Thread = std::thread(&CD3DX12AffinityGraphicsCommandList::ReplayWorkerThread, this, i);
+                }
+
+                ReplayWorker& Worker = *mReplayWorkers[i];
+                {
+                    std::lock_guard<std::mutex> lock(Worker.Mutex);
+                    Worker.ReplayPending = true;
+                }
+                Worker.Condition.notify_one();
+            }
+        }
+    }
+
+    if (CallingThreadNode != D3DX12_MAX_ACTIVE_NODES)
+    {
+        mCommandStream.Replay(mGraphicsCommandLists[CallingThreadNode], CallingThreadNode, Device);
+    }
+
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    {
+        if (mReplayWorkers[i])
+        {
+            ReplayWorker& Worker = *mReplayWorkers[i];
+            std::unique_lock<std::mutex> lock(Worker.Mutex);
+            Worker.Condition.wait(lock, [&Worker]() { return !Worker.ReplayPending; });
+        }
+    }
+}
+
+void CD3DX12AffinityGraphicsCommandList::ReplayWorkerThread(UINT NodeIndex)
+{
+    ReplayWorker& Worker = *mReplayWorkers[NodeIndex];
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    std::unique_lock<std::mutex> lock(Worker.Mutex);
+    for (;;)
+    {
+        Worker.Condition.wait(lock, [&Worker]() { return Worker.ReplayPending || Worker.Exit; });
+        if (!Worker.ReplayPending)
+        {
+            break;
+        }
+
+        lock.unlock();
+        mCommandStream.Replay(mGraphicsCommandLists[NodeIndex], NodeIndex, Device);
+        lock.lock();
+
+        Worker.ReplayPending = false;
+        Worker.Condition.notify_all();
+    }
+}
+
 void CD3DX12AffinityGraphicsCommandList::ClearState(
     CD3DX12AffinityPipelineState* pPipelineState)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ClearState(pPipelineState);
+        return;
+    }
+
     CD3DX12AffinityPipelineState* PipelineState = static_cast<CD3DX12AffinityPipelineState*>(pPipelineState);
 
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
@@ -107,6 +204,12 @@ void CD3DX12AffinityGraphicsCommandList::DrawInstanced(
     UINT StartVertexLocation,
     UINT StartInstanceLocation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -123,6 +226,12 @@ void CD3DX12AffinityGraphicsCommandList::Dispatch(
     UINT ThreadGroupCountY,
     UINT ThreadGroupCountZ)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.Dispatch(ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -140,6 +249,12 @@ void CD3DX12AffinityGraphicsCommandList::CopyBufferRegion(
     UINT64 SrcOffset,
     UINT64 NumBytes)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.CopyBufferRegion(pDstBuffer, DstOffset, pSrcBuffer, SrcOffset, NumBytes);
+        return;
+    }
+
     CD3DX12AffinityResource* DstBuffer = static_cast<CD3DX12AffinityResource*>(pDstBuffer);
     CD3DX12AffinityResource* SrcBuffer = static_cast<CD3DX12AffinityResource*>(pSrcBuffer);
 
@@ -162,6 +277,12 @@ void CD3DX12AffinityGraphicsCommandList::CopyTextureRegion(
     const D3DX12_AFFINITY_TEXTURE_COPY_LOCATION* pSrc,
     const D3D12_BOX* pSrcBox)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.CopyTextureRegion(pDst, DstX, DstY, DstZ, pSrc, pSrcBox);
+        return;
+    }
+
     CD3DX12AffinityResource* DstTexture = static_cast<CD3DX12AffinityResource*>(pDst->pResource);
     CD3DX12AffinityResource* SrcTexture = static_cast<CD3DX12AffinityResource*>(pSrc->pResource);
 
@@ -185,6 +306,12 @@ void CD3DX12AffinityGraphicsCommandList::CopyResource(
     CD3DX12AffinityResource* pDstResource,
     CD3DX12AffinityResource* pSrcResource)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.CopyResource(pDstResource, pSrcResource);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -204,6 +331,12 @@ void CD3DX12AffinityGraphicsCommandList::CopyTiles(
     UINT64 BufferStartOffsetInBytes,
     D3D12_TILE_COPY_FLAGS Flags)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.CopyTiles(pTiledResource, pTileRegionStartCoordinate, pTileRegionSize, pBuffer, BufferStartOffsetInBytes, Flags);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -228,6 +361,12 @@ void CD3DX12AffinityGraphicsCommandList::ResolveSubresource(
     UINT SrcSubresource,
     DXGI_FORMAT Format)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ResolveSubresource(pDstResource, DstSubresource, pSrcResource, SrcSubresource, Format);
+        return;
+    }
+
 
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
@@ -243,6 +382,12 @@ void CD3DX12AffinityGraphicsCommandList::ResolveSubresource(
 void CD3DX12AffinityGraphicsCommandList::IASetPrimitiveTopology(
     D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.IASetPrimitiveTopology(PrimitiveTopology);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -257,6 +402,12 @@ void CD3DX12AffinityGraphicsCommandList::RSSetViewports(
     UINT NumViewports,
     const D3D12_VIEWPORT* pViewports)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.RSSetViewports(NumViewports, pViewports);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -271,6 +422,12 @@ void CD3DX12AffinityGraphicsCommandList::RSSetScissorRects(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.RSSetScissorRects(NumRects, pRects);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -284,6 +441,12 @@ void CD3DX12AffinityGraphicsCommandList::RSSetScissorRects(
 void CD3DX12AffinityGraphicsCommandList::OMSetBlendFactor(
     const FLOAT BlendFactor[4])
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.OMSetBlendFactor(BlendFactor);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -297,6 +460,12 @@ void CD3DX12AffinityGraphicsCommandList::OMSetBlendFactor(
 void CD3DX12AffinityGraphicsCommandList::OMSetStencilRef(
     UINT StencilRef)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.OMSetStencilRef(StencilRef);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -311,6 +480,12 @@ void CD3DX12AffinityGraphicsCommandList::ResourceBarrier(
     UINT NumBarriers,
     const D3DX12_AFFINITY_RESOURCE_BARRIER* pBarriers)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ResourceBarrier(NumBarriers, pBarriers);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -365,6 +540,12 @@ void CD3DX12AffinityGraphicsCommandList::ResourceBarrier(
 void CD3DX12AffinityGraphicsCommandList::ExecuteBundle(
     CD3DX12AffinityGraphicsCommandList* pCommandList)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ExecuteBundle(pCommandList);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -380,6 +561,12 @@ void CD3DX12AffinityGraphicsCommandList::SetDescriptorHeaps(
     UINT NumDescriptorHeaps,
     CD3DX12AffinityDescriptorHeap** ppDescriptorHeaps)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetDescriptorHeaps(NumDescriptorHeaps, ppDescriptorHeaps);
+        return;
+    }
+
     mCachedDescriptorHeaps.resize(NumDescriptorHeaps);
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
@@ -400,6 +587,12 @@ void CD3DX12AffinityGraphicsCommandList::SetDescriptorHeaps(
 void CD3DX12AffinityGraphicsCommandList::SetComputeRootSignature(
     CD3DX12AffinityRootSignature* pRootSignature)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetComputeRootSignature(pRootSignature);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -414,6 +607,12 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRootSignature(
 void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootSignature(
     CD3DX12AffinityRootSignature* pRootSignature)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetGraphicsRootSignature(pRootSignature);
+        return;
+    }
+
     CD3DX12AffinityRootSignature* AffinityRootSignature = static_cast<CD3DX12AffinityRootSignature*>(pRootSignature);
 
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
@@ -432,6 +631,12 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRoot32BitConstant(
     UINT SrcData,
     UINT DestOffsetIn32BitValues)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetComputeRoot32BitConstants(RootParameterIndex, 1, &SrcData, DestOffsetIn32BitValues);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -448,6 +653,12 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRoot32BitConstant(
     UINT SrcData,
     UINT DestOffsetIn32BitValues)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetGraphicsRoot32BitConstants(RootParameterIndex, 1, &SrcData, DestOffsetIn32BitValues);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -465,6 +676,12 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRoot32BitConstants(
     const void* pSrcData,
     UINT DestOffsetIn32BitValues)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetComputeRoot32BitConstants(RootParameterIndex, Num32BitValuesToSet, pSrcData, DestOffsetIn32BitValues);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -482,6 +699,12 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRoot32BitConstants(
     const void* pSrcData,
     UINT DestOffsetIn32BitValues)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetGraphicsRoot32BitConstants(RootParameterIndex, Num32BitValuesToSet, pSrcData, DestOffsetIn32BitValues);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -497,6 +720,12 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRootConstantBufferView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetComputeRootConstantBufferView(RootParameterIndex, BufferLocation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -512,6 +741,12 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootConstantBufferView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetGraphicsRootConstantBufferView(RootParameterIndex, BufferLocation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -527,6 +762,12 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRootShaderResourceView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetComputeRootShaderResourceView(RootParameterIndex, BufferLocation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -542,6 +783,12 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootShaderResourceView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetGraphicsRootShaderResourceView(RootParameterIndex, BufferLocation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -557,6 +804,12 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRootUnorderedAccessView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetComputeRootUnorderedAccessView(RootParameterIndex, BufferLocation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -572,6 +825,12 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootUnorderedAccessView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetGraphicsRootUnorderedAccessView(RootParameterIndex, BufferLocation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -588,6 +847,12 @@ void CD3DX12AffinityGraphicsCommandList::IASetVertexBuffers(
     UINT NumViews,
     const D3D12_VERTEX_BUFFER_VIEW* pViews)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.IASetVertexBuffers(StartSlot, NumViews, pViews);
+        return;
+    }
+
     mCachedBufferViews.resize(NumViews);
 
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
@@ -612,6 +877,12 @@ void CD3DX12AffinityGraphicsCommandList::SOSetTargets(
     UINT NumViews,
     const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SOSetTargets(StartSlot, NumViews, pViews);
+        return;
+    }
+
     mCachedStreamOutBufferViews.resize(NumViews);
 
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
@@ -638,6 +909,12 @@ void CD3DX12AffinityGraphicsCommandList::OMSetRenderTargets(
     BOOL RTsSingleHandleToDescriptorRange,
     const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.OMSetRenderTargets(NumRenderTargetDescriptors, pRenderTargetDescriptors, RTsSingleHandleToDescriptorRange, pDepthStencilDescriptor);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -671,6 +948,12 @@ void CD3DX12AffinityGraphicsCommandList::ClearDepthStencilView(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ClearDepthStencilView(DepthStencilView, ClearFlags, Depth, Stencil, NumRects, pRects);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -689,6 +972,12 @@ void CD3DX12AffinityGraphicsCommandList::ClearRenderTargetView(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ClearRenderTargetView(RenderTargetView, ColorRGBA, NumRects, pRects);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -713,6 +1002,12 @@ void CD3DX12AffinityGraphicsCommandList::ClearUnorderedAccessViewUint(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ClearUnorderedAccessViewUint(ViewGPUHandleInCurrentHeap, ViewCPUHandle, pResource, Values, NumRects, pRects);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -735,6 +1030,12 @@ void CD3DX12AffinityGraphicsCommandList::ClearUnorderedAccessViewFloat(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ClearUnorderedAccessViewFloat(ViewGPUHandleInCurrentHeap, ViewCPUHandle, pResource, Values, NumRects, pRects);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -753,6 +1054,12 @@ void CD3DX12AffinityGraphicsCommandList::DiscardResource(
     CD3DX12AffinityResource* pResource,
     const D3D12_DISCARD_REGION* pRegion)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.DiscardResource(pResource, pRegion);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -771,6 +1078,12 @@ void CD3DX12AffinityGraphicsCommandList::BeginQuery(
     D3D12_QUERY_TYPE Type,
     UINT Index)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.BeginQuery(pQueryHeap, Type, Index);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -791,6 +1104,12 @@ void CD3DX12AffinityGraphicsCommandList::EndQuery(
     D3D12_QUERY_TYPE Type,
     UINT Index)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.EndQuery(pQueryHeap, Type, Index);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -814,6 +1133,12 @@ void CD3DX12AffinityGraphicsCommandList::ResolveQueryData(
     CD3DX12AffinityResource* pDestinationBuffer,
     UINT64 AlignedDestinationBufferOffset)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ResolveQueryData(pQueryHeap, Type, StartIndex, NumQueries, pDestinationBuffer, AlignedDestinationBufferOffset);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -838,6 +1163,12 @@ void CD3DX12AffinityGraphicsCommandList::SetPredication(
     UINT64 AlignedBufferOffset,
     D3D12_PREDICATION_OP Operation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetPredication(pBuffer, AlignedBufferOffset, Operation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -857,6 +1188,12 @@ void CD3DX12AffinityGraphicsCommandList::SetMarker(
     const void* pData,
     UINT Size)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetMarker(Metadata, pData, Size);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -876,6 +1213,12 @@ void CD3DX12AffinityGraphicsCommandList::BeginEvent(
     const void* pData,
     UINT Size)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.BeginEvent(Metadata, pData, Size);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -892,6 +1235,12 @@ void CD3DX12AffinityGraphicsCommandList::BeginEvent(
 
 void CD3DX12AffinityGraphicsCommandList::EndEvent(void)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.EndEvent();
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -911,6 +1260,12 @@ void CD3DX12AffinityGraphicsCommandList::ExecuteIndirect(
     CD3DX12AffinityResource* pCountBuffer,
     UINT64 CountBufferOffset)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.ExecuteIndirect(pCommandSignature, MaxCommandCount, pArgumentBuffer, ArgumentBufferOffset, pCountBuffer, CountBufferOffset);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -930,6 +1285,13 @@ CD3DX12AffinityGraphicsCommandList::CD3DX12AffinityGraphicsCommandList(CD3DX12Af
     : CD3DX12AffinityCommandList(device, reinterpret_cast<ID3D12CommandList**>(graphicsCommandLists), Count)
     , mUseDeviceActiveMaskOnReset(UseDeviceActiveMaskOnReset)
     , mAccumulatedAffinityMask(0)
+    , mCanRecordCommandStream(Count > 1)
+#ifdef RECORD_COMMAND_STREAMS
+    , mRecordCommandStream(Count > 1)
+#else
+    , mRecordCommandStream(false)
+#endif
+    , mRecordCommandStreamOnReset(mRecordCommandStream)
 {
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
     {
@@ -954,11 +1316,39 @@ CD3DX12AffinityGraphicsCommandList::CD3DX12AffinityGraphicsCommandList(CD3DX12Af
     {
         mAccumulatedAffinityMask = GetNodeMask();
     }
+
+    // Command lists are created open, so start recording right away.
+    if (mRecordCommandStream)
+    {
+        mCommandStream.Reset(mAffinityMask);
+    }
+}
+
+CD3DX12AffinityGraphicsCommandList::~CD3DX12AffinityGraphicsCommandList()
+{
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
+    {
+        if (mReplayWorkers[i])
+        {
+            {
+                std::lock_guard<std::mutex> lock(mReplayWorkers[i]->Mutex);
+                mReplayWorkers[i]->Exit = true;
+            }
+            mReplayWorkers[i]->Condition.notify_one();
+            mReplayWorkers[i]->Thread.join();
+        }
+    }
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetPipelineState(
     CD3DX12AffinityPipelineState* pPipelineState)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetPipelineState(pPipelineState);
+        return;
+    }
+
     CD3DX12AffinityPipelineState* PipelineState = static_cast<CD3DX12AffinityPipelineState*>(pPipelineState);
 
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
@@ -976,6 +1366,12 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRootDescriptorTable(
     UINT RootParameterIndex,
     D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetComputeRootDescriptorTable(RootParameterIndex, BaseDescriptor);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -991,6 +1387,12 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootDescriptorTable(
     UINT RootParameterIndex,
     D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.SetGraphicsRootDescriptorTable(RootParameterIndex, BaseDescriptor);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -1005,6 +1407,12 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootDescriptorTable(
 void CD3DX12AffinityGraphicsCommandList::IASetIndexBuffer(
     const D3D12_INDEX_BUFFER_VIEW* pView)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.IASetIndexBuffer(pView);
+        return;
+    }
+
     if (pView)
     {
         D3D12_INDEX_BUFFER_VIEW View = *pView;
@@ -1040,6 +1448,12 @@ void CD3DX12AffinityGraphicsCommandList::DrawIndexedInstanced(
     INT BaseVertexLocation,
     UINT StartInstanceLocation)
 {
+    if (mRecordCommandStream)
+    {
+        mCommandStream.DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+        return;
+    }
+
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
         if (((1 << i) & mAffinityMask) != 0)
@@ -1054,6 +1468,12 @@ void CD3DX12AffinityGraphicsCommandList::BroadcastResource(CD3DX12AffinityResour
     // The command list affinity must match the supplied source node
     DEBUG_ASSERT(mAffinityMask == (1 << NodeIndex));
 
+    if (mRecordCommandStream)
+    {
+        mCommandStream.BroadcastResource(pResource, NodeIndex, TargetNodeMask);
+        return;
+    }
+
     // Copy is a push operation on the Source node commandlist to a target resource
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
     {
@@ -1075,6 +1495,11 @@ ID3D12GraphicsCommandList* CD3DX12AffinityGraphicsCommandList::GetChildObject(UI
     return mGraphicsCommandLists[AffinityIndex];
 }
 
+void CD3DX12AffinityGraphicsCommandList::SetRecordCommandStream(bool RecordCommandStream)
+{
+    mRecordCommandStreamOnReset = RecordCommandStream && mCanRecordCommandStream;
+}
+
 UINT CD3DX12AffinityGraphicsCommandList::GetActiveAffinityMask()
 {
     return mAccumulatedAffinityMask;
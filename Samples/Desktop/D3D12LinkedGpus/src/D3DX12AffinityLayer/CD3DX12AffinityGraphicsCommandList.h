@@ -15,6 +15,7 @@
 #include "CD3DX12AffinityCommandList.h"
 #include "CD3DX12AffinityQueryHeap.h"
 #include "CD3DX12AffinityDevice.h"
+#include "CD3DX12AffinityCommandStream.h"
 
 class __declspec(uuid("BE1D71C8-88FD-4623-ABFA-D0E546D12FAF")) CD3DX12AffinityGraphicsCommandList : public CD3DX12AffinityCommandList
 {
@@ -275,11 +276,30 @@ public:
     void BroadcastResource(CD3DX12AffinityResource* pResource, UINT NodeIndex, UINT TargetNodeMask);
 
     CD3DX12AffinityGraphicsCommandList(CD3DX12AffinityDevice* device, ID3D12GraphicsCommandList** graphicsCommandLists, UINT Count, bool UseDeviceActiveMaskOnReset);
+    ~CD3DX12AffinityGraphicsCommandList();
 
     ID3D12GraphicsCommandList* GetChildObject(UINT AffinityIndex);
     UINT GetActiveAffinityMask();
 
+    // Chooses between recording commands once and replaying them onto each node on Close, and
+    // recording them into every node's command list as they come in. RECORD_COMMAND_STREAMS sets
+    // the default. Takes effect on the next Reset, and only applies to lists with several nodes.
+    void SetRecordCommandStream(bool RecordCommandStream);
+
 private:
+    // Replays the command stream onto one node's command list whenever the list is closed.
+    struct ReplayWorker
+    {
+        std::thread Thread;
+        std::mutex Mutex;
+        std::condition_variable Condition;
+        bool ReplayPending = false;
+        bool Exit = false;
+    };
+
+    void ReplayCommandStream();
+    void ReplayWorkerThread(UINT NodeIndex);
+
     ID3D12GraphicsCommandList* mGraphicsCommandLists[D3DX12_MAX_ACTIVE_NODES];
     UINT mAccumulatedAffinityMask;
     bool mUseDeviceActiveMaskOnReset;
@@ -288,4 +308,9 @@ private:
     std::vector<D3D12_VERTEX_BUFFER_VIEW> mCachedBufferViews;
     std::vector<D3D12_STREAM_OUTPUT_BUFFER_VIEW> mCachedStreamOutBufferViews;
     std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> mCachedRenderTargetViews;
+    bool mCanRecordCommandStream;
+    bool mRecordCommandStream;
+    bool mRecordCommandStreamOnReset;
+    CD3DX12AffinityCommandStream mCommandStream;
+    std::unique_ptr<ReplayWorker> mReplayWorkers[D3DX12_MAX_ACTIVE_NODES];
 };
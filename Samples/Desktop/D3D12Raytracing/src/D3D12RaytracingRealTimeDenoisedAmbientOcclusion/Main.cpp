@@ -19,6 +19,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
     // Initialization For WICTextureLoader.
     ThrowIfFailed(CoInitializeEx(nullptr, COINITBASE_MULTITHREADED), L"Failed to initialize WIC component");
 
+    // -samplerHarness runs the CPU sample set quality harness and exits.
+    if (wcsstr(GetCommandLineW(), L"-samplerHarness"))
+    {
+        FILE* console = nullptr;
+        if (AttachConsole(ATTACH_PARENT_PROCESS) || AllocConsole())
+        {
+            freopen_s(&console, "CONOUT$", "w", stdout);
+        }
+        Samplers::RunSamplerHarness();
+        return 0;
+    }
+
     D3D12RaytracingRealTimeDenoisedAmbientOcclusion sample(1920, 1080, L"D3D12 Raytracing - Real-Time Denoised Raytraced Ambient Occlusion");
     return Win32Application::Run(&sample, hInstance, nCmdShow);
 }
@@ -97,6 +97,11 @@ namespace RTAO_Args
         Sample::instance().RTAOComponent().RequestRecreateAOSamples();
     }
 
+    void OnSampleSetTypeChange(void*)
+    {
+        Sample::instance().RTAOComponent().RequestRecreateAOSamples();
+    }
+
     void OnToggleSppCheckerboard(void*)
     {
         if (RTAO_Args::Spp_doCheckerboard)
@@ -114,6 +119,8 @@ namespace RTAO_Args
 
     IntVar Spp(L"Render/AO/RTAO/Sampling/Rays per pixel", 1, 1, 1024, 1, OnSppSampleSetChange);
     IntVar Spp_AOSampleSetDistributedAcrossPixels(L"Render/AO/RTAO/Sampling/Sample set distribution across NxN pixels ", RPP_SAMPLSETDISTRIBUTIONACROSSPIXELS1D, 1, 8, 1, OnSppSampleSetChange);
+    const WCHAR* SampleSetTypes[Samplers::SampleSetType::Count] = { L"Multi-jittered", L"Random", L"Sobol (Owen scrambled)", L"R2", L"Blue noise" };
+    EnumVar Spp_SampleSetType(L"Render/AO/RTAO/Sampling/Sample set type", Samplers::SampleSetType::MultiJittered, Samplers::SampleSetType::Count, SampleSetTypes, OnSampleSetTypeChange);
     BoolVar Spp_doCheckerboard(L"Render/AO/RTAO/Sampling/Overrides/Do checkerboard 0.5 spp", false, OnToggleSppCheckerboard);
     BoolVar Spp_useGroundTruthSpp(L"Render/AO/RTAO/Sampling/Overrides/Do ground truth spp (no denoising): " STRINGIZE(GROUND_TRUTH_RPP), false, OnToggleSppGroundTruth);
 
@@ -438,12 +445,13 @@ void RTAO::CreateSamplesRNG()
 {
     UINT pixelsInSampleSet1D = RTAO_Args::Spp_AOSampleSetDistributedAcrossPixels;
     UINT samplesPerSet = RTAO_Args::Spp * pixelsInSampleSet1D * pixelsInSampleSet1D;
-    m_randomSampler.Reset(samplesPerSet, c_NumSampleSets, Samplers::HemisphereDistribution::Cosine);
+    m_randomSampler = Samplers::CreateSampler(static_cast<Samplers::SampleSetType::Enum>(static_cast<int>(RTAO_Args::Spp_SampleSetType)));
+    m_randomSampler->Reset(samplesPerSet, c_NumSampleSets, Samplers::HemisphereDistribution::Cosine);
 
-    UINT numSamples = m_randomSampler.NumSamples() * m_randomSampler.NumSampleSets();
+    UINT numSamples = m_randomSampler->NumSamples() * m_randomSampler->NumSampleSets();
     for (UINT i = 0; i < numSamples; i++)
     {
-        XMFLOAT3 p = m_randomSampler.GetHemisphereSample3D();
+        XMFLOAT3 p = m_randomSampler->GetHemisphereSample3D();
         // Convert [-1,1] to [0,1].
         m_samplesGPUBuffer[i].value = XMFLOAT2(p.x * 0.5f + 0.5f, p.y * 0.5f + 0.5f);
         m_hemisphereSamplesGPUBuffer[i].value = p;
@@ -487,8 +495,8 @@ void RTAO::UpdateConstantBuffer(UINT frameIndex)
     uniform_int_distribution<UINT> seedDistribution(0, UINT_MAX);
 
     m_CB->seed = RTAO_Args::RayGen_RandomFrameSeed ? seedDistribution(m_generatorURNG) : 1879;
-    m_CB->numSamplesPerSet = m_randomSampler.NumSamples();
-    m_CB->numSampleSets = m_randomSampler.NumSampleSets();
+    m_CB->numSamplesPerSet = m_randomSampler->NumSamples();
+    m_CB->numSampleSets = m_randomSampler->NumSampleSets();
     m_CB->numPixelsPerDimPerSet = RTAO_Args::Spp_AOSampleSetDistributedAcrossPixels;
 
     m_CB->useSortedRays = RTAO_Args::RaySorting_Enabled;
@@ -574,8 +582,8 @@ void RTAO::Run(
             activeRaytracingWidth,
             m_raytracingHeight,
             m_CB->seed,
-            m_randomSampler.NumSamples(),
-            m_randomSampler.NumSampleSets(),
+            m_randomSampler->NumSamples(),
+            m_randomSampler->NumSampleSets(),
             RTAO_Args::Spp_AOSampleSetDistributedAcrossPixels,
             doCheckerboardRayGeneration,
             m_checkerboardGenerateRaysForEvenPixels,
@@ -103,7 +103,7 @@ private:
     
     ConstantBuffer<RTAOConstantBuffer> m_CB;
     UINT c_NumSampleSets = 83;
-    Samplers::MultiJittered m_randomSampler;
+    std::unique_ptr<Samplers::Sampler> m_randomSampler;
     StructuredBuffer<AlignedUnitSquareSample2D> m_samplesGPUBuffer;
     StructuredBuffer<AlignedHemisphereSample3D> m_hemisphereSamplesGPUBuffer;
     BOOL m_isRecreateAOSamplesRequested = true;
@@ -35,10 +35,10 @@ UINT Sampler::GetSampleIndex()
     if (m_index % m_numSamples == 0)
     {
         // Pick a random index jump within a set.
-        m_jump = GetRandomJump();
+        m_jump = GetRandomNumber(0, m_numSamples - 1);
         
         // Pick a random set index jump.
-        m_setJump = GetRandomSetJump() * m_numSamples;
+        m_setJump = GetRandomNumber(0, m_numSampleSets - 1) * m_numSamples;
     }
     return m_setJump + m_shuffledIndices[(m_index++ + m_jump) % m_numSamples];
 }
@@ -53,25 +53,8 @@ void Sampler::Reset(UINT numSamples, UINT numSampleSets, HemisphereDistribution:
     m_shuffledIndices.resize(m_numSamples * m_numSampleSets);
     m_hemisphereSamples.resize(m_numSamples * m_numSampleSets, HemisphereSample3D(FLT_MAX, FLT_MAX, FLT_MAX));
     
-    // Reset generator and initialize distributions.
-    {
-        // Initialize to the same seed for determinism.
-        m_generatorURNG.seed(s_seed);
-
-        uniform_int_distribution<UINT> jumpDistribution(0, m_numSamples - 1);
-        uniform_int_distribution<UINT> jumpSetDistribution(0, m_numSampleSets - 1);
-
-        uniform_real_distribution<float> unitSquareDistribution(0.f, 1.f);
-
-        // Specify the next representable value for the end range, since
-        // uniform_real_distribution constructs excluding the end value [being, end).
-        uniform_real_distribution<float> unitSquareDistributionInclusive(0.f, nextafter(1.f, FLT_MAX));
-
-        GetRandomJump = bind(jumpDistribution, ref(m_generatorURNG));
-        GetRandomSetJump = bind(jumpSetDistribution, ref(m_generatorURNG));
-        GetRandomFloat01 = bind(unitSquareDistribution, ref(m_generatorURNG));
-        GetRandomFloat01inclusive = bind(unitSquareDistributionInclusive, ref(m_generatorURNG));
-    }
+    // Initialize to the same seed for determinism.
+    m_generatorURNG.seed(s_seed);
 
     // Generate random samples.
     {
@@ -116,28 +99,48 @@ HemisphereSample3D Sampler::GetHemisphereSample3D()
 
 // Initialize samples on a 3D hemisphere from 2D unit square samples
 // cosDensityPower - cosine density power {0, 1, ...}. 0:uniform, 1:cosine,...
+// Samples are mapped four at a time with DirectXMath vector ops.
 void Sampler::InitializeHemisphereSamples(float cosDensityPower)
 {
-    for (UINT i = 0; i < m_samples.size(); i++)
-    {
-        // Compute azimuth (phi) and polar angle (theta)
-        /*
-        float phi = XM_2PI * m_samples[i].x;   
-        float theta = acos(powf((1.f - m_samples[i].y), 1.f / (cosDensityPower + 1)));
-
-        // Convert the polar angles to a 3D point in local orthornomal 
-        // basis with orthogonal unit vectors along x, y, z.
-        m_hemisphereSamples[i].x = sinf(theta) * cosf(phi);
-        m_hemisphereSamples[i].y = sinf(theta) * sinf(phi);
-        m_hemisphereSamples[i].z = cosf(theta);
-        */ 
-        // Optimized version using trigonometry equations.
+    // Compute azimuth (phi) and polar angle (theta) and convert them
+    // to a 3D point in local orthonormal basis with orthogonal unit vectors along x, y, z:
+    //  x = sin(theta) * cos(phi)
+    //  y = sin(theta) * sin(phi)
+    //  z = cos(theta)
+    // where phi = 2 * PI * u.x and cos(theta) = (1 - u.y) ^ (1 / (cosDensityPower + 1)).
+    const XMVECTOR exponent = XMVectorReplicate(1.f / (cosDensityPower + 1));
+    const UINT numSamples = static_cast<UINT>(m_samples.size());
+
+    UINT i = 0;
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        XMVECTOR u = XMVectorSet(m_samples[i].x, m_samples[i + 1].x, m_samples[i + 2].x, m_samples[i + 3].x);
+        XMVECTOR v = XMVectorSet(m_samples[i].y, m_samples[i + 1].y, m_samples[i + 2].y, m_samples[i + 3].y);
+
+        XMVECTOR sinPhi, cosPhi;
+        XMVectorSinCos(&sinPhi, &cosPhi, XMVectorScale(u, XM_2PI));
+
+        XMVECTOR cosTheta = XMVectorPow(XMVectorSubtract(g_XMOne, v), exponent);
+        XMVECTOR sinTheta = XMVectorSqrt(XMVectorMax(g_XMZero, XMVectorNegativeMultiplySubtract(cosTheta, cosTheta, g_XMOne)));
+
+        XMFLOAT4 x, y, z;
+        XMStoreFloat4(&x, XMVectorMultiply(sinTheta, cosPhi));
+        XMStoreFloat4(&y, XMVectorMultiply(sinTheta, sinPhi));
+        XMStoreFloat4(&z, cosTheta);
+
+        m_hemisphereSamples[i] = HemisphereSample3D(x.x, y.x, z.x);
+        m_hemisphereSamples[i + 1] = HemisphereSample3D(x.y, y.y, z.y);
+        m_hemisphereSamples[i + 2] = HemisphereSample3D(x.z, y.z, z.z);
+        m_hemisphereSamples[i + 3] = HemisphereSample3D(x.w, y.w, z.w);
+    }
+
+    for (; i < numSamples; i++)
+    {
         float cosTheta = powf((1.f - m_samples[i].y), 1.f / (cosDensityPower + 1));
         float sinTheta = sqrtf(1.f - cosTheta * cosTheta);
         m_hemisphereSamples[i].x = sinTheta * cosf(XM_2PI * m_samples[i].x);
         m_hemisphereSamples[i].y = sinTheta * sinf(XM_2PI * m_samples[i].x);
         m_hemisphereSamples[i].z = cosTheta;
-
     }
 }
 
@@ -207,3 +210,196 @@ void Random::GenerateSamples2D()
     }
 }
 
+
+namespace
+{
+    UINT ReverseBits(UINT x)
+    {
+        x = (x << 16) | (x >> 16);
+        x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+        x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+        x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+        x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+        return x;
+    }
+
+    // Permutes bits of x such that each bit only depends on the less significant bits.
+    UINT LaineKarrasPermutation(UINT x, UINT seed)
+    {
+        x += seed;
+        x ^= x * 0x6c50b47c;
+        x ^= x * 0xb82f1e52;
+        x ^= x * 0xc7afe638;
+        x ^= x * 0x8d22f6e6;
+        return x;
+    }
+
+    // Owen scrambling: each bit is flipped based on a hash of the more significant bits.
+    UINT NestedUniformScramble(UINT x, UINT seed)
+    {
+        return ReverseBits(LaineKarrasPermutation(ReverseBits(x), seed));
+    }
+
+    UINT HashCombine(UINT seed, UINT v)
+    {
+        return seed ^ (v + (seed << 6) + (seed >> 2));
+    }
+
+    // First two dimensions of the Sobol sequence.
+    // Dimension 0 is the van der Corput sequence, dimension 1 uses
+    // the direction numbers of the primitive polynomial x + 1.
+    void Sobol2D(UINT index, UINT* x, UINT* y)
+    {
+        *x = ReverseBits(index);
+
+        UINT v = 0x80000000u;
+        UINT result = 0;
+        for (; index; index >>= 1, v ^= v >> 1)
+        {
+            if (index & 1)
+                result ^= v;
+        }
+        *y = result;
+    }
+
+    float UINTToFloat01(UINT x)
+    {
+        // Use the top 24 bits so that the result is exact and never reaches 1.
+        return (x >> 8) * (1.f / 16777216.f);
+    }
+}
+
+// Generate Owen scrambled Sobol sample patterns on unit square.
+void Sobol::GenerateSamples2D()
+{
+    for (UINT s = 0; s < NumSampleSets(); s++)
+    {
+        UINT sampleSetStartID = s * NumSamples();
+        UINT seed = GetRandomUINT();
+
+        for (UINT i = 0; i < NumSamples(); i++)
+        {
+            UINT x, y;
+            Sobol2D(i, &x, &y);
+            x = NestedUniformScramble(x, HashCombine(seed, 0));
+            y = NestedUniformScramble(y, HashCombine(seed, 1));
+            m_samples[sampleSetStartID + i] = UnitSquareSample2D(UINTToFloat01(x), UINTToFloat01(y));
+        }
+    }
+}
+
+// Generate R2 sample patterns on unit square.
+void R2::GenerateSamples2D()
+{
+    // Plastic constant - the unique real root of x^3 = x + 1.
+    const double g = 1.32471795724474602596;
+    const double a1 = 1.0 / g;
+    const double a2 = 1.0 / (g * g);
+
+    for (UINT s = 0; s < NumSampleSets(); s++)
+    {
+        UINT sampleSetStartID = s * NumSamples();
+        UnitSquareSample2D offset = RandomFloat01_2D();
+
+        for (UINT i = 0; i < NumSamples(); i++)
+        {
+            double x = offset.x + a1 * (i + 1);
+            double y = offset.y + a2 * (i + 1);
+            m_samples[sampleSetStartID + i] = UnitSquareSample2D(
+                static_cast<float>(x - floor(x)), 
+                static_cast<float>(y - floor(y)));
+        }
+    }
+}
+
+// Generate progressive blue noise sample patterns on unit square.
+// Each new sample is the best of several random candidates, i.e. the one
+// farthest from its nearest neighbor among samples placed so far.
+// A uniform grid over the torus accelerates the nearest neighbor queries.
+void BlueNoise::GenerateSamples2D()
+{
+    const UINT NumCandidates = 16;
+    const UINT N = NumSamples();
+    const UINT gridDim = max(1u, static_cast<UINT>(sqrtf(static_cast<float>(N)) / 2));
+    const float cellSize = 1.f / gridDim;
+
+    vector<vector<UINT>> grid(gridDim * gridDim);
+
+    auto CellIndex = [&](float v) { return min(static_cast<UINT>(v * gridDim), gridDim - 1); };
+
+    auto ToroidalDistanceSq = [](const UnitSquareSample2D& a, const UnitSquareSample2D& b)
+    {
+        float dx = fabsf(a.x - b.x);
+        float dy = fabsf(a.y - b.y);
+        dx = min(dx, 1.f - dx);
+        dy = min(dy, 1.f - dy);
+        return dx * dx + dy * dy;
+    };
+
+    for (UINT s = 0; s < NumSampleSets(); s++)
+    {
+        UINT sampleSetStartID = s * N;
+        for (auto& cell : grid)
+        {
+            cell.clear();
+        }
+
+        for (UINT i = 0; i < N; i++)
+        {
+            UnitSquareSample2D best = RandomFloat01_2D();
+            float bestDistSq = -1.f;
+
+            for (UINT c = 0; i > 0 && c < NumCandidates; c++)
+            {
+                UnitSquareSample2D candidate = c == 0 ? best : RandomFloat01_2D();
+                int cx = static_cast<int>(CellIndex(candidate.x));
+                int cy = static_cast<int>(CellIndex(candidate.y));
+
+                // Search rings of cells around the candidate until no closer sample can exist.
+                float nearestDistSq = FLT_MAX;
+                for (int r = 0; r <= static_cast<int>(gridDim / 2); r++)
+                {
+                    float ringDist = (r - 1) * cellSize;
+                    if (r > 0 && ringDist * ringDist > nearestDistSq)
+                        break;
+
+                    for (int y = cy - r; y <= cy + r; y++)
+                        for (int x = cx - r; x <= cx + r; x++)
+                        {
+                            if (abs(x - cx) != r && abs(y - cy) != r)
+                                continue;
+
+                            UINT wrappedX = static_cast<UINT>((x + static_cast<int>(gridDim)) % static_cast<int>(gridDim));
+                            UINT wrappedY = static_cast<UINT>((y + static_cast<int>(gridDim)) % static_cast<int>(gridDim));
+                            for (UINT neighbor : grid[wrappedY * gridDim + wrappedX])
+                            {
+                                nearestDistSq = min(nearestDistSq, ToroidalDistanceSq(candidate, m_samples[sampleSetStartID + neighbor]));
+                            }
+                        }
+                }
+
+                if (nearestDistSq > bestDistSq)
+                {
+                    bestDistSq = nearestDistSq;
+                    best = candidate;
+                }
+            }
+
+            m_samples[sampleSetStartID + i] = best;
+            grid[CellIndex(best.y) * gridDim + CellIndex(best.x)].push_back(i);
+        }
+    }
+}
+
+unique_ptr<Sampler> Samplers::CreateSampler(SampleSetType::Enum type)
+{
+    switch (type)
+    {
+    case SampleSetType::Random: return make_unique<Random>();
+    case SampleSetType::Sobol: return make_unique<Sobol>();
+    case SampleSetType::R2: return make_unique<R2>();
+    case SampleSetType::BlueNoise: return make_unique<BlueNoise>();
+    case SampleSetType::MultiJittered:
+    default: return make_unique<MultiJittered>();
+    }
+}
@@ -22,17 +22,25 @@ namespace Samplers {
             Cosine
         };
     }
+
+    namespace SampleSetType {
+        enum Enum {
+            MultiJittered,
+            Random,
+            Sobol,
+            R2,
+            BlueNoise,
+            Count
+        };
+    }
+
     class Sampler
     {
         static const UINT s_seed = 1729;
-        std::function<UINT()> GetRandomJump;        // Generates a random uniform index within [0, m_numSamples - 1]
-        std::function<UINT()> GetRandomSetJump;     // Generates a random uniform index within [0, m_numSampleSets - 1]
-        std::function<float()> GetRandomFloat01;    // Generates a random uniform float within [0,1)
-        std::function<float()> GetRandomFloat01inclusive; // Generates a random uniform float within [0,1]
     public:
         // Constructor, desctructor
         Sampler();
-        ~Sampler() {}
+        virtual ~Sampler() {}
         
         // Accessors
         UINT NumSamples() { return m_numSamples; }
@@ -51,6 +59,13 @@ namespace Samplers {
         virtual void GenerateSamples2D() = 0; // Generate sample patterns in a unit square.
         UnitSquareSample2D RandomFloat01_2D();
         UINT GetRandomNumber(UINT min, UINT max);
+        UINT GetRandomUINT() { return m_generatorURNG(); }
+
+        // Generates a random uniform float within [0,1)
+        float GetRandomFloat01()
+        {
+            return std::uniform_real_distribution<float>(0.f, 1.f)(m_generatorURNG);
+        }
 
         
         std::mt19937 m_generatorURNG;  // Uniform random number generator
@@ -114,4 +129,44 @@ namespace Samplers {
         void GenerateSamples2D();
     };
 
+    // Sobol (0,2)-sequence with hash-based Owen scrambling.
+    // Ref: Burley, Practical Hash-based Owen Scrambling, JCGT 2020.
+    // Each set is an independently scrambled copy of the sequence,
+    // so every power of two prefix of a set remains stratified
+    // in all elementary intervals.
+    class Sobol : public Sampler
+    {
+    private:
+        void GenerateSamples2D();
+    };
+
+    // R2 additive recurrence based on the plastic constant.
+    // Ref: Roberts, The Unreasonable Effectiveness of Quasirandom Sequences.
+    // Each set is toroidally shifted by a random offset 
+    // (Cranley-Patterson rotation) to decorrelate the sets.
+    class R2 : public Sampler
+    {
+    private:
+        void GenerateSamples2D();
+    };
+
+    // Progressive blue noise sets generated with Mitchell's best-candidate 
+    // algorithm on a torus. Any prefix of a set is well distributed, and
+    // the toroidal metric keeps the sets tileable across pixels.
+    // The sets are precomputed on Reset.
+    class BlueNoise : public Sampler
+    {
+    private:
+        void GenerateSamples2D();
+    };
+
+    // Creates a sampler of a given type.
+    std::unique_ptr<Sampler> CreateSampler(SampleSetType::Enum type);
+
+    // Measures quality of each sample set type on the CPU and prints a report:
+    // - L2-star discrepancy of the unit square sample sets.
+    // - RMS error of an AO estimate against an analytic reference.
+    // for a range of sample counts.
+    void RunSamplerHarness();
+
 } // namespace Samplers
\ No newline at end of file
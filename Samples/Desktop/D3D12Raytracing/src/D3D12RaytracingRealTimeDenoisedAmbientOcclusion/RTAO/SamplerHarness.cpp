@@ -0,0 +1,106 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "stdafx.h"
+#include "Sampler.h"
+
+using namespace std;
+using namespace DirectX;
+using namespace Samplers;
+
+namespace
+{
+    const wchar_t* c_sampleSetTypeNames[SampleSetType::Count] = { L"MultiJittered", L"Random", L"Sobol", L"R2", L"BlueNoise" };
+
+    // Number of sample sets to measure per sample count.
+    const UINT c_numSampleSets = 64;
+
+    // L2-star discrepancy of a 2D point set.
+    // Ref: Warnock, Computational investigations of low-discrepancy point sets, 1972.
+    double L2StarDiscrepancy(const vector<UnitSquareSample2D>& samples)
+    {
+        const double N = static_cast<double>(samples.size());
+
+        double sum1 = 0;
+        for (auto& s : samples)
+        {
+            sum1 += (1.0 - s.x * s.x) * (1.0 - s.y * s.y);
+        }
+
+        double sum2 = 0;
+        for (auto& a : samples)
+            for (auto& b : samples)
+            {
+                sum2 += (1.0 - max(a.x, b.x)) * (1.0 - max(a.y, b.y));
+            }
+
+        double discrepancySq = 1.0 / 9.0 - sum1 / (2.0 * N) + sum2 / (N * N);
+        return sqrt(max(0.0, discrepancySq));
+    }
+
+    // Test occluder: blocks all directions on one side of a vertical plane
+    // that are below an elevation of acos(c_occluderCosTheta).
+    // With cosine weighted samples, P(cos(theta) < c) = c^2 and the occluded
+    // half-plane covers half the azimuths, so the ambient visibility is 1 - c^2 / 2.
+    const float c_occluderCosTheta = 0.6f;
+    const XMFLOAT2 c_occluderPlaneNormal(0.9553365f, 0.2955202f);  // (cos 0.3, sin 0.3)
+    const double c_referenceVisibility = 1.0 - 0.5 * c_occluderCosTheta * c_occluderCosTheta;
+
+    bool IsOccluded(const HemisphereSample3D& d)
+    {
+        return d.z < c_occluderCosTheta && (d.x * c_occluderPlaneNormal.x + d.y * c_occluderPlaneNormal.y) > 0;
+    }
+}
+
+void Samplers::RunSamplerHarness()
+{
+    const UINT sampleCounts[] = { 4, 16, 64, 256, 1024 };
+
+    Utility::Printf(L"Sampler harness: %u sample sets per configuration, AO reference visibility %.4f\n", c_numSampleSets, c_referenceVisibility);
+    Utility::Printf(L"%-14s %8s %16s %14s\n", L"Sampler", L"Samples", L"L2* discrepancy", L"AO RMS error");
+
+    for (UINT type = 0; type < SampleSetType::Count; type++)
+    {
+        auto sampler = CreateSampler(static_cast<SampleSetType::Enum>(type));
+
+        for (UINT numSamples : sampleCounts)
+        {
+            sampler->Reset(numSamples, c_numSampleSets, HemisphereDistribution::Cosine);
+
+            // Each run of numSamples consecutive Get*() calls accesses one complete sample set.
+            vector<UnitSquareSample2D> set(numSamples);
+            double discrepancySum = 0;
+            double squaredErrorSum = 0;
+            for (UINT s = 0; s < c_numSampleSets; s++)
+            {
+                for (auto& sample : set)
+                {
+                    sample = sampler->GetSample2D();
+                }
+                discrepancySum += L2StarDiscrepancy(set);
+
+                UINT numVisible = 0;
+                for (UINT i = 0; i < numSamples; i++)
+                {
+                    numVisible += IsOccluded(sampler->GetHemisphereSample3D()) ? 0 : 1;
+                }
+                double error = static_cast<double>(numVisible) / numSamples - c_referenceVisibility;
+                squaredErrorSum += error * error;
+            }
+
+            Utility::Printf(L"%-14s %8u %16.6f %14.6f\n",
+                c_sampleSetTypeNames[type],
+                numSamples,
+                discrepancySum / c_numSampleSets,
+                sqrt(squaredErrorSum / c_numSampleSets));
+        }
+    }
+}
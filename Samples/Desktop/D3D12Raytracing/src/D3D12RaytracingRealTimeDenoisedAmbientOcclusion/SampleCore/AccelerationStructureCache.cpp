@@ -0,0 +1,113 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "stdafx.h"
+#include <fstream>
+#include "DirectXRaytracingHelper.h"
+#include "ParserUtils.h"
+#include "AccelerationStructureCache.h"
+
+using namespace std;
+
+namespace
+{
+    const char c_Magic[8] = { 'R', 'T', 'A', 'O', 'B', 'L', 'A', 'S' };
+
+    struct EntryHeader
+    {
+        char magic[sizeof(c_Magic)];
+        UINT version;
+        UINT reserved;
+        UINT64 key;
+        UINT64 serializedSizeInBytes;
+    };
+}
+
+UINT64 AccelerationStructureCache::GetKey(UINT64 geometryHash, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags)
+{
+    return SceneParser::HashBytes(&buildFlags, sizeof(buildFlags), geometryHash);
+}
+
+string AccelerationStructureCache::GetFilename(UINT64 key)
+{
+    char filename[32];
+    sprintf_s(filename, "%016llx.blas", key);
+    return m_directory + "\\" + filename;
+}
+
+bool AccelerationStructureCache::Load(ID3D12Device5* device, UINT64 key, UINT64 maxDeserializedSizeInBytes, ID3D12Resource** ppSerializedData)
+{
+    SceneParser::MappedFile file(GetFilename(key));
+    if (!file.IsValid() || file.Size() < sizeof(EntryHeader) + sizeof(D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER))
+    {
+        return false;
+    }
+
+    EntryHeader entryHeader;
+    memcpy(&entryHeader, file.Data(), sizeof(entryHeader));
+    if (memcmp(entryHeader.magic, c_Magic, sizeof(c_Magic)) ||
+        entryHeader.version != Version ||
+        entryHeader.key != key ||
+        entryHeader.serializedSizeInBytes != file.Size() - sizeof(EntryHeader))
+    {
+        return false;
+    }
+
+    const char* pSerializedData = file.Data() + sizeof(EntryHeader);
+    D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER serializedHeader;
+    memcpy(&serializedHeader, pSerializedData, sizeof(serializedHeader));
+
+    // Bottom-level AS don't reference other AS, so there are no pointers to patch on deserialization.
+    if (serializedHeader.SerializedSizeInBytesIncludingHeader != entryHeader.serializedSizeInBytes ||
+        serializedHeader.NumBottomLevelAccelerationStructurePointersAfterHeader != 0 ||
+        serializedHeader.DeserializedSizeInBytes > maxDeserializedSizeInBytes)
+    {
+        return false;
+    }
+
+    if (device->CheckDriverMatchingIdentifier(D3D12_SERIALIZED_DATA_RAYTRACING_ACCELERATION_STRUCTURE, &serializedHeader.DriverMatchingIdentifier) != D3D12_DRIVER_MATCHING_IDENTIFIER_COMPATIBLE_WITH_DEVICE)
+    {
+        return false;
+    }
+
+    ComPtr<ID3D12Resource> serializedData;
+    AllocateUploadBuffer(device, const_cast<char*>(pSerializedData), entryHeader.serializedSizeInBytes, &serializedData, L"Serialized bottom-level AS");
+    *ppSerializedData = serializedData.Detach();
+    return true;
+}
+
+bool AccelerationStructureCache::Save(UINT64 key, const void* pSerializedData, UINT64 serializedSizeInBytes)
+{
+    if (!CreateDirectoryA(m_directory.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        return false;
+    }
+
+    EntryHeader entryHeader = {};
+    memcpy(entryHeader.magic, c_Magic, sizeof(c_Magic));
+    entryHeader.version = Version;
+    entryHeader.key = key;
+    entryHeader.serializedSizeInBytes = serializedSizeInBytes;
+
+    // Write to a temporary file first so that an interrupted write never leaves a partial entry behind.
+    string filename = GetFilename(key);
+    string tempFilename = filename + ".tmp";
+    {
+        ofstream file(tempFilename, ios::out | ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char*>(&entryHeader), sizeof(entryHeader));
+        file.write(static_cast<const char*>(pSerializedData), static_cast<streamsize>(serializedSizeInBytes));
+        if (!file.good())
+        {
+            return false;
+        }
+    }
+    return MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+}
@@ -0,0 +1,40 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// On-disk cache of serialized bottom-level acceleration structures.
+// Entries are keyed by a hash of the source geometry and the build flags. The driver
+// matching identifier embedded in the serialized data rejects entries written by a
+// different driver or GPU, in which case the caller rebuilds and overwrites the entry.
+// Each entry is read through a single mapped view and copied straight into an upload buffer.
+class AccelerationStructureCache
+{
+public:
+    // Bump whenever the entry layout changes.
+    static const UINT Version = 1;
+
+    AccelerationStructureCache(const std::string& directory) : m_directory(directory) {}
+
+    static UINT64 GetKey(UINT64 geometryHash, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags);
+
+    // Returns true if ppSerializedData was filled with an upload buffer, in GENERIC_READ state,
+    // holding serialized data that the device can deserialize into maxDeserializedSizeInBytes.
+    bool Load(ID3D12Device5* device, UINT64 key, UINT64 maxDeserializedSizeInBytes, ID3D12Resource** ppSerializedData);
+
+    // Writes the serialized data for key. Failures are not fatal, the entry is just not written.
+    bool Save(UINT64 key, const void* pSerializedData, UINT64 serializedSizeInBytes);
+
+private:
+    std::string GetFilename(UINT64 key);
+
+    std::string m_directory;
+};
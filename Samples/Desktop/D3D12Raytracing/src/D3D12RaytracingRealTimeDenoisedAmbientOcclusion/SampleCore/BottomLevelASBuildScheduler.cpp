@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "stdafx.h"
+#include "BottomLevelASBuildScheduler.h"
+
+using namespace std;
+
+namespace
+{
+    UINT64 AlignScratchSize(UINT64 size)
+    {
+        const UINT64 Alignment = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT;
+        return (size + Alignment - 1) & ~(Alignment - 1);
+    }
+}
+
+BottomLevelASBuildPlan PlanBottomLevelASBuilds(
+    const vector<BottomLevelASBuildRequest>& requests,
+    UINT64 scratchPoolSizeInBytes,
+    const BottomLevelASBuildBudget& budget)
+{
+    BottomLevelASBuildPlan plan;
+
+    // Required builds first, then the ones that have waited the longest.
+    vector<const BottomLevelASBuildRequest*> orderedRequests;
+    for (auto& request : requests)
+    {
+        ThrowIfFalse(AlignScratchSize(request.scratchSizeInBytes) <= scratchPoolSizeInBytes, L"Scratch pool is smaller than a single build.");
+        orderedRequests.push_back(&request);
+    }
+    stable_sort(orderedRequests.begin(), orderedRequests.end(), [](auto* a, auto* b)
+    {
+        if (a->isRequired != b->isRequired)
+        {
+            return a->isRequired;
+        }
+        return a->numFramesDeferred > b->numFramesDeferred;
+    });
+
+    // Apply the budget. Once an optional build doesn't fit, everything after it is deferred
+    // as well, so that smaller builds can't keep jumping ahead of an older large one.
+    vector<const BottomLevelASBuildRequest*> acceptedRequests;
+    UINT64 numTriangles = 0;
+    UINT64 resultBytes = 0;
+    bool isBudgetExhausted = false;
+    for (auto* request : orderedRequests)
+    {
+        bool fitsBudget =
+            numTriangles + request->numTriangles <= budget.maxTrianglesPerFrame &&
+            resultBytes + request->resultSizeInBytes <= budget.maxResultBytesPerFrame;
+
+        if (request->isRequired || acceptedRequests.empty() || (fitsBudget && !isBudgetExhausted))
+        {
+            acceptedRequests.push_back(request);
+            numTriangles += request->numTriangles;
+            resultBytes += request->resultSizeInBytes;
+        }
+        else
+        {
+            isBudgetExhausted = true;
+            plan.deferredIds.push_back(request->id);
+        }
+    }
+
+    // Pack the scratch ranges into batches, largest first, each into the first batch it fits.
+    stable_sort(acceptedRequests.begin(), acceptedRequests.end(), [](auto* a, auto* b)
+    {
+        return a->scratchSizeInBytes > b->scratchSizeInBytes;
+    });
+
+    vector<UINT64> batchScratchSizes;
+    for (auto* request : acceptedRequests)
+    {
+        const UINT64 scratchSize = AlignScratchSize(request->scratchSizeInBytes);
+        UINT batch = 0;
+        while (batch < batchScratchSizes.size() && batchScratchSizes[batch] + scratchSize > scratchPoolSizeInBytes)
+        {
+            batch++;
+        }
+        if (batch == batchScratchSizes.size())
+        {
+            batchScratchSizes.push_back(0);
+        }
+
+        BottomLevelASBuildPlan::Build build;
+        build.id = request->id;
+        build.batch = batch;
+        build.scratchOffset = batchScratchSizes[batch];
+        plan.builds.push_back(build);
+
+        batchScratchSizes[batch] += scratchSize;
+        plan.scratchBytesUnpooled += scratchSize;
+    }
+    stable_sort(plan.builds.begin(), plan.builds.end(), [](auto& a, auto& b)
+    {
+        return a.batch < b.batch;
+    });
+
+    plan.numBatches = static_cast<UINT>(batchScratchSizes.size());
+    plan.numBarriers = plan.numBatches;
+    plan.numBarriersUnbatched = static_cast<UINT>(plan.builds.size());
+    for (auto batchScratchSize : batchScratchSizes)
+    {
+        plan.scratchBytesUsed = max(plan.scratchBytesUsed, batchScratchSize);
+    }
+
+    return plan;
+}
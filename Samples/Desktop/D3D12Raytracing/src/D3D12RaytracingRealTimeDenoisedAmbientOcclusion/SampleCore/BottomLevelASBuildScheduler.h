@@ -0,0 +1,84 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Plans the bottom-level AS builds recorded in a frame. It has no device dependencies,
+// so the same plan can be checked against a mock device.
+//
+// Builds share one scratch resource. Each build in a batch gets its own aligned range of
+// the pool, so the builds in a batch are independent and the driver can overlap them.
+// A single UAV barrier between batches replaces the barrier after every build that a
+// single shared scratch buffer needs.
+
+// Limits the bottom-level AS work recorded per frame. Builds past the budget are deferred
+// to a later frame, oldest first. Required builds always run and count against the budget,
+// and at least one build runs each frame so deferred work can't starve.
+struct BottomLevelASBuildBudget
+{
+    UINT64 maxTrianglesPerFrame = UINT64_MAX;
+    UINT64 maxResultBytesPerFrame = UINT64_MAX;    // Sum of ResultDataMaxSizeInBytes of the builds.
+};
+
+struct BottomLevelASBuildRequest
+{
+    UINT   id;                      // Caller's handle for the BLAS, returned in the plan.
+    UINT64 scratchSizeInBytes;
+    UINT64 resultSizeInBytes;
+    UINT64 numTriangles;
+    UINT   numFramesDeferred;       // Requests deferred for longer go first.
+    bool   isRequired;              // The BLAS has never been built, so it can't be deferred.
+};
+
+struct BottomLevelASBuildPlan
+{
+    struct Build
+    {
+        UINT   id;
+        UINT   batch;
+        UINT64 scratchOffset;       // Offset into the scratch pool.
+    };
+
+    std::vector<Build> builds;      // Sorted by batch.
+    std::vector<UINT>  deferredIds;
+    UINT               numBatches = 0;
+
+    // How the plan compares with building one after another with a UAV barrier in-between,
+    // and with giving every build its own scratch resource instead of a pool.
+    UINT   numBarriers = 0;
+    UINT   numBarriersUnbatched = 0;
+    UINT64 scratchBytesUsed = 0;    // Largest pool usage of any batch.
+    UINT64 scratchBytesUnpooled = 0;
+};
+
+// Every request's scratch size must fit into scratchPoolSizeInBytes.
+BottomLevelASBuildPlan PlanBottomLevelASBuilds(
+    const std::vector<BottomLevelASBuildRequest>& requests,
+    UINT64 scratchPoolSizeInBytes,
+    const BottomLevelASBuildBudget& budget);
+
+// Records the builds of a plan in order, with a UAV barrier at the end of each batch.
+// The barrier covers both the AS writes of the batch and the reuse of the scratch pool
+// by the next batch.
+template <typename RecordBuild, typename RecordBarrier>
+void RecordBottomLevelASBuildPlan(const BottomLevelASBuildPlan& plan, RecordBuild recordBuild, RecordBarrier recordBarrier)
+{
+    for (size_t i = 0; i < plan.builds.size(); i++)
+    {
+        recordBuild(plan.builds[i]);
+
+        const bool isLastInBatch = i + 1 == plan.builds.size() || plan.builds[i + 1].batch != plan.builds[i].batch;
+        if (isLastInBatch)
+        {
+            recordBarrier();
+        }
+    }
+}
@@ -141,6 +141,12 @@ namespace GpuKernels
             return grassStrawsX * grassStrawsY * N_GRASS_VERTICES * sizeof(VertexPositionNormalTextureTangent);
         }
 
+        UINT GetWindMapResolution()
+        {
+            auto desc = m_windTexture.resource->GetDesc();
+            return std::max(static_cast<UINT>(desc.Width), desc.Height);
+        }
+
     private:
         ComPtr<ID3D12RootSignature>         m_rootSignature;
         ComPtr<ID3D12PipelineState>         m_pipelineStateObject;
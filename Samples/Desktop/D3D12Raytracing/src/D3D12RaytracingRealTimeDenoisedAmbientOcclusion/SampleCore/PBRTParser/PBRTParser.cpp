@@ -17,6 +17,7 @@
 #include "stdafx.h"
 #include "PBRTParser.h"
 #include "PlyParser.h"
+#include "ParserUtils.h"
 
 using namespace SceneParser;
 using namespace std;
@@ -38,6 +39,14 @@ namespace PBRTParser
 
 	void PBRTParser::Parse(string filename, SceneParser::Scene &outputScene, bool bClockwiseWindingORder, bool rhCoords)
 	{
+		const string cacheFilename = filename + ".scenecache";
+		const SceneCache::Flags cacheFlags = (bClockwiseWindingORder ? 0x1 : 0) | (rhCoords ? 0x2 : 0);
+		m_loadedFromCache = m_useSceneCache && SceneCache::Load(cacheFilename, cacheFlags, outputScene);
+		if (m_loadedFromCache)
+		{
+			return;
+		}
+
 		m_fileStream = ifstream(filename);
 
 		{
@@ -89,6 +98,8 @@ namespace PBRTParser
 			}
 		}
 
+		LoadPlyMeshes(outputScene);
+
 		FixZeroVertexNormals(outputScene);
 
 		if (!rhCoords)
@@ -97,27 +108,53 @@ namespace PBRTParser
 		}
 
 		SetWindingOrder(bClockwiseWindingORder, outputScene);
+
+		if (m_useSceneCache)
+		{
+			vector<string> sourceFilenames = { filename };
+			for (auto& plyMesh : m_plyMeshes)
+			{
+				sourceFilenames.push_back(plyMesh.filename);
+			}
+			SceneCache::Save(cacheFilename, cacheFlags, sourceFilenames, outputScene);
+		}
     }
 
+	// Loads all referenced PLY files concurrently.
+	// File sizes vary a lot, so files are handed out to the worker threads one at a time.
+	void PBRTParser::LoadPlyMeshes(SceneParser::Scene &scene)
+	{
+		ParallelForEach(m_plyMeshes.size(), [&](size_t i)
+		{
+			auto& plyMesh = m_plyMeshes[i];
+			Mesh &mesh = plyMesh.isAreaLight ? scene.m_AreaLights[plyMesh.meshIndex].m_Mesh : scene.m_Meshes[plyMesh.meshIndex];
+			PlyParser::PlyParser().Parse(plyMesh.filename, mesh);
+		});
+	}
+
 
 	// Calculates vertex normals where one is not set.
 	void PBRTParser::SwapGeometryCoordinateSystem(SceneParser::Scene &scene)
 	{
-		for (auto& mesh : scene.m_Meshes)
-			for (auto& vertex : mesh.m_VertexBuffer)
+		ParallelForEach(scene.m_Meshes.size(), [&](size_t meshIndex)
+		{
+			for (auto& vertex : scene.m_Meshes[meshIndex].m_VertexBuffer)
 			{
 				vertex.Position.z = -vertex.Position.z;
 				vertex.Normal.z = -vertex.Normal.z;
 			}
+		});
 		scene.m_Camera.m_Position.z = -scene.m_Camera.m_Position.z;
 		scene.m_Camera.m_LookAt.z = -scene.m_Camera.m_LookAt.z;
 		scene.m_Camera.m_Up.z = -scene.m_Camera.m_Up.z;
 	}
 	// Calculates vertex normals where one is not set.
+	// Meshes are processed in parallel. Faces of a mesh share vertices, so each mesh is processed on a single thread.
 	void PBRTParser::FixZeroVertexNormals(SceneParser::Scene &scene)
 	{
-		for (auto& mesh : scene.m_Meshes)
+		ParallelForEach(scene.m_Meshes.size(), [&](size_t meshIndex)
 		{
+			auto& mesh = scene.m_Meshes[meshIndex];
 			const UINT numVertices = static_cast<UINT>(mesh.m_VertexBuffer.size());
 
 			// Since some vertices may be shared across faces,
@@ -185,14 +222,17 @@ namespace PBRTParser
 			{
 				XMStoreFloat3(&mesh.m_VertexBuffer[i].Normal.xmFloat3, vertexNormalsSum[i] / static_cast<float>(vertexFaceCountContributions[i]));
 			}
-		}
+		});
 	}
 
 	void PBRTParser::SetWindingOrder(bool bSetClockwiseOrder, SceneParser::Scene &scene)
 	{
+		const size_t MinTrianglesPerThread = 16384;
+
 		// Ensure LH clockwise triangle vertices order 
-		for (auto& mesh : scene.m_Meshes)
+		ParallelForEach(scene.m_Meshes.size(), [&](size_t meshIndex)
 		{
+			auto& mesh = scene.m_Meshes[meshIndex];
 			auto IsTriangleClockwiseWinded = [&](UINT index0)
 			{
 				UINT indices[3] = { mesh.m_IndexBuffer[index0], mesh.m_IndexBuffer[index0 + 1], mesh.m_IndexBuffer[index0 + 2] };
@@ -211,14 +251,18 @@ namespace PBRTParser
 				return XMVectorGetX(XMVector3Dot(faceNormal, normal)) > 0;
 			};
 
-			for (UINT j = 0; j < mesh.m_IndexBuffer.size(); j += 3)
+			// Triangles are independent, so large meshes are split across threads as well.
+			ParallelFor(mesh.m_IndexBuffer.size() / 3, MinTrianglesPerThread, [&](size_t begin, size_t end)
 			{
-				if (bSetClockwiseOrder != IsTriangleClockwiseWinded(j))
+				for (UINT j = static_cast<UINT>(3 * begin); j < 3 * end; j += 3)
 				{
-					swap(mesh.m_IndexBuffer[j], mesh.m_IndexBuffer[j + 2]);
+					if (bSetClockwiseOrder != IsTriangleClockwiseWinded(j))
+					{
+						swap(mesh.m_IndexBuffer[j], mesh.m_IndexBuffer[j + 2]);
+					}
 				}
-			}
-		}
+			});
+		});
 	};
 
     void PBRTParser::ParseWorld(ifstream &fileStream, SceneParser::Scene &outputScene)
@@ -779,12 +823,18 @@ namespace PBRTParser
         pMesh->m_pMaterial = &outputScene.m_Materials[correctedMaterialName];
         ThrowIfTrue(pMesh->m_pMaterial == nullptr, L"Material name not found");
 		pMesh->m_transform = m_currentTransform;
-        ParseShape(fileStream, outputScene, *pMesh);
+        string plyFilename = ParseShape(fileStream, outputScene, *pMesh);
+        if (!plyFilename.empty())
+        {
+            bool isAreaLight = GetCurrentAttributes().GetType() == Attributes::AreaLight;
+            size_t meshIndex = (isAreaLight ? outputScene.m_AreaLights.size() : outputScene.m_Meshes.size()) - 1;
+            m_plyMeshes.push_back({ isAreaLight, meshIndex, plyFilename });
+        }
 
 
     }
 
-    void PBRTParser::ParseShape(ifstream &fileStream, SceneParser::Scene &outputScene, SceneParser::Mesh &mesh)
+    string PBRTParser::ParseShape(ifstream &fileStream, SceneParser::Scene &outputScene, SceneParser::Mesh &mesh)
     {
         fileStream >> lastParsedWord;
         
@@ -794,9 +844,7 @@ namespace PBRTParser
             ParseExpectedWords(fileStream, ExpectedWords, ARRAYSIZE(ExpectedWords));
 
             string correctedFileName = CorrectNameString(ParseString(fileStream));
-            PlyParser::PlyParser().Parse(m_relativeDirectory + correctedFileName, mesh);
-
-
+            return m_relativeDirectory + correctedFileName;
         }
         else if (!lastParsedWord.compare("\"trianglemesh\""))
         {
@@ -944,6 +992,7 @@ namespace PBRTParser
                 mesh.GenerateTangents();
             }
         }
+        return string();
     }
 
     string PBRTParser::CorrectNameString(const string &str)
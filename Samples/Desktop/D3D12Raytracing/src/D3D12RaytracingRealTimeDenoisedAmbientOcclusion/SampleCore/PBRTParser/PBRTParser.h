@@ -17,6 +17,7 @@
 
 #pragma once
 #include "SceneParser.h"
+#include "SceneCache.h"
 
 #define PBRTPARSER_STRINGBUFFERSIZE 200
 
@@ -79,7 +80,20 @@ class PBRTParser : public SceneParser::SceneParserClass
         ~PBRTParser();
         virtual void Parse(std::string filename, SceneParser::Scene &outputScene, bool bClockwiseWindingORder = true, bool rhCoords = false);
 
+        // Parse() loads from and writes to a binary cache next to the .pbrt file when enabled.
+        void EnableSceneCache(bool enable) { m_useSceneCache = enable; }
+        bool LoadedFromCache() const { return m_loadedFromCache; }
+
     private:
+        // PLY files are loaded after the .pbrt file is parsed, once the scene's mesh vectors
+        // stop growing, so meshes are referenced by index rather than by pointer.
+        struct PlyMeshReference
+        {
+            bool isAreaLight;
+            size_t meshIndex;
+            std::string filename;
+        };
+
         void ParseFilm(std::ifstream &fileStream, SceneParser::Scene &outputScene);
         void ParseLookAt(std::ifstream &fileStream, SceneParser::Scene &outputScene);
 		void ParseCamera(std::ifstream &fileStream, SceneParser::Scene &outputScene);
@@ -91,7 +105,9 @@ class PBRTParser : public SceneParser::SceneParserClass
         void ParseAreaLightSource(std::ifstream &fileStream, SceneParser::Scene &outputScene);
         void ParseTransform();
 
-        void ParseShape(std::ifstream &fileStream, SceneParser::Scene &outputScene, SceneParser::Mesh &mesh);
+        // Returns the PLY filename if the shape is a "plymesh", otherwise the shape is parsed into mesh.
+        std::string ParseShape(std::ifstream &fileStream, SceneParser::Scene &outputScene, SceneParser::Mesh &mesh);
+        void LoadPlyMeshes(SceneParser::Scene &scene);
 
         void ParseBracketedVector3(std::istream, float &x, float &y, float &z);
 
@@ -164,6 +180,10 @@ class PBRTParser : public SceneParser::SceneParserClass
         std::string m_CurrentMaterial;
         std::stack<Attributes> m_AttributeStack;
         std::unordered_map<std::string, std::string> m_TextureNameToFileName;
+        std::vector<PlyMeshReference> m_plyMeshes;
+
+        bool m_useSceneCache = true;
+        bool m_loadedFromCache = false;
 
         XMMATRIX m_currentTransform;
 
@@ -0,0 +1,207 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <exception>
+
+namespace SceneParser
+{
+    // Read-only memory mapping of a whole file.
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::string &filename)
+        {
+            m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE)
+            {
+                return;
+            }
+
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+            {
+                return;
+            }
+            m_size = static_cast<size_t>(fileSize.QuadPart);
+
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping)
+            {
+                m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            }
+        }
+
+        ~MappedFile()
+        {
+            if (m_data)
+            {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_mapping)
+            {
+                CloseHandle(m_mapping);
+            }
+            if (m_file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(m_file);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool IsValid() const { return m_data != nullptr; }
+        const char* Data() const { return m_data; }
+        const char* End() const { return m_data + m_size; }
+        size_t Size() const { return m_size; }
+
+    private:
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    // Number of worker threads spawned by ParallelFor calls that are currently running.
+    // Nested ParallelFor calls only spawn threads for the hardware threads that are still idle.
+    inline std::atomic<size_t>& ActiveParallelForThreads()
+    {
+        static std::atomic<size_t> activeThreads(0);
+        return activeThreads;
+    }
+
+    // Splits [0, count) into contiguous ranges and calls func(begin, end) for each range
+    // on its own thread, including the calling thread. Ranges hold at least minItemsPerThread items.
+    // The first exception thrown by any range is rethrown on the calling thread.
+    template <typename Func>
+    void ParallelFor(size_t count, size_t minItemsPerThread, Func func)
+    {
+        size_t hardwareThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        size_t busyThreads = ActiveParallelForThreads().load();
+        size_t maxThreads = hardwareThreads > busyThreads ? hardwareThreads - busyThreads : 1;
+        size_t numThreads = std::max<size_t>(1, std::min(maxThreads, count / std::max<size_t>(1, minItemsPerThread)));
+        size_t itemsPerThread = (count + numThreads - 1) / std::max<size_t>(1, numThreads);
+
+        std::vector<std::exception_ptr> exceptions(numThreads);
+        auto RunRange = [&](size_t threadIndex)
+        {
+            try
+            {
+                size_t begin = threadIndex * itemsPerThread;
+                size_t end = std::min(count, begin + itemsPerThread);
+                if (begin < end)
+                {
+                    func(begin, end);
+                }
+            }
+            catch (...)
+            {
+                exceptions[threadIndex] = std::current_exception();
+            }
+        };
+
+        ActiveParallelForThreads() += numThreads - 1;
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < numThreads; i++)
+        {
+            threads.emplace_back(RunRange, i);
+        }
+        RunRange(0);
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        ActiveParallelForThreads() -= numThreads - 1;
+
+        for (auto& exception : exceptions)
+        {
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+    }
+
+    // Calls func(index) for every index in [0, count), handing out one index at a time
+    // to the worker threads. Use instead of ParallelFor when items vary a lot in cost.
+    template <typename Func>
+    void ParallelForEach(size_t count, Func func)
+    {
+        std::atomic<size_t> nextIndex(0);
+        ParallelFor(count, 1, [&](size_t, size_t)
+        {
+            for (size_t index = nextIndex++; index < count; index = nextIndex++)
+            {
+                func(index);
+            }
+        });
+    }
+
+    // 64-bit non-cryptographic hash of a byte range. Processes 32 bytes per iteration
+    // in four independent lanes, so hashing runs close to memory bandwidth.
+    inline UINT64 HashBytes(const void* pData, size_t size, UINT64 seed = 0)
+    {
+        const UINT64 Prime1 = 0x9E3779B185EBCA87ull;
+        const UINT64 Prime2 = 0xC2B2AE3D27D4EB4Full;
+        const UINT64 Prime3 = 0x165667B19E3779F9ull;
+
+        auto Rotl = [](UINT64 x, int r) { return (x << r) | (x >> (64 - r)); };
+        auto Round = [&](UINT64 acc, UINT64 input) { return Rotl(acc + input * Prime2, 31) * Prime1; };
+        auto Load = [](const char* p) { UINT64 v; memcpy(&v, p, sizeof(v)); return v; };
+
+        const char* p = static_cast<const char*>(pData);
+        const char* pEnd = p + size;
+        UINT64 hash;
+
+        if (size >= 32)
+        {
+            UINT64 lanes[4] = { seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1 };
+            for (; p + 32 <= pEnd; p += 32)
+            {
+                lanes[0] = Round(lanes[0], Load(p));
+                lanes[1] = Round(lanes[1], Load(p + 8));
+                lanes[2] = Round(lanes[2], Load(p + 16));
+                lanes[3] = Round(lanes[3], Load(p + 24));
+            }
+            hash = Rotl(lanes[0], 1) + Rotl(lanes[1], 7) + Rotl(lanes[2], 12) + Rotl(lanes[3], 18);
+            for (UINT64 lane : lanes)
+            {
+                hash = (hash ^ Round(0, lane)) * Prime1 + Prime3;
+            }
+        }
+        else
+        {
+            hash = seed + Prime3;
+        }
+        hash += size;
+
+        for (; p + 8 <= pEnd; p += 8)
+        {
+            hash = Rotl(hash ^ Round(0, Load(p)), 27) * Prime1 + Prime3;
+        }
+        for (; p < pEnd; p++)
+        {
+            hash = Rotl(hash ^ (static_cast<unsigned char>(*p) * Prime3), 11) * Prime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= Prime2;
+        hash ^= hash >> 29;
+        hash *= Prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
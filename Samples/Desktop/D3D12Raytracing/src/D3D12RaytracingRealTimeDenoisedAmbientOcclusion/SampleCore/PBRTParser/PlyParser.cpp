@@ -17,7 +17,10 @@
 #include "../../stdafx.h"
 #include <memory>
 #include <algorithm>
+#include <atomic>
+#include <type_traits>
 #include "SceneParser.h"
+#include "ParserUtils.h"
 #include "PlyParser.h"
 
 using namespace SceneParser;
@@ -33,206 +36,581 @@ void ThrowIfTrue(bool expression, string errorMessage = "")
     }
 }
 
-UINT8 PlyParser::BytesPerIntegerType(string type)
+namespace
 {
-    if (!type.compare("uint8") || !type.compare("uchar"))
+    inline UINT8 SwapBytes(UINT8 value) { return value; }
+    inline UINT16 SwapBytes(UINT16 value) { return _byteswap_ushort(value); }
+    inline UINT32 SwapBytes(UINT32 value) { return _byteswap_ulong(value); }
+    inline UINT64 SwapBytes(UINT64 value) { return _byteswap_uint64(value); }
+
+    // Loads an unaligned scalar, converting its byte order if needed.
+    template <typename T, bool Swap>
+    T LoadScalar(const char* pData)
     {
-        return 1;
+        typedef typename conditional<sizeof(T) == 1, UINT8,
+                typename conditional<sizeof(T) == 2, UINT16,
+                typename conditional<sizeof(T) == 4, UINT32, UINT64>::type>::type>::type Bits;
+
+        Bits bits;
+        memcpy(&bits, pData, sizeof(T));
+        if (Swap)
+        {
+            bits = SwapBytes(bits);
+        }
+        T value;
+        memcpy(&value, &bits, sizeof(T));
+        return value;
     }
-    else if (!type.compare("uint") || !type.compare("int"))
+
+    template <typename T, bool Swap>
+    float ReadFloat(const char* pData)
     {
-        return 4;
+        return static_cast<float>(LoadScalar<T, Swap>(pData));
     }
-    else
+
+    template <typename T, bool Swap>
+    UINT ReadUint(const char* pData)
+    {
+        return static_cast<UINT>(LoadScalar<T, Swap>(pData));
+    }
+
+    // Returns the next whitespace delimited token on the current line and advances pData past it.
+    string NextToken(const char*& pData, const char* pLineEnd)
+    {
+        while (pData < pLineEnd && isspace(static_cast<unsigned char>(*pData)))
+        {
+            pData++;
+        }
+        const char* pTokenStart = pData;
+        while (pData < pLineEnd && !isspace(static_cast<unsigned char>(*pData)))
+        {
+            pData++;
+        }
+        return string(pTokenStart, pData);
+    }
+
+    const char* FindLineEnd(const char* pData, const char* pEnd)
+    {
+        const char* pLineEnd = static_cast<const char*>(memchr(pData, '\n', pEnd - pData));
+        return pLineEnd ? pLineEnd : pEnd;
+    }
+
+    // Destination of a named vertex property within SceneParser::Vertex.
+    bool GetVertexPropertyOffset(const string &name, UINT* offset)
+    {
+        struct Mapping { const char* name; size_t offset; };
+        static const Mapping mappings[] =
+        {
+            { "x", offsetof(Vertex, Position) + 0 * sizeof(float) },
+            { "y", offsetof(Vertex, Position) + 1 * sizeof(float) },
+            { "z", offsetof(Vertex, Position) + 2 * sizeof(float) },
+            { "nx", offsetof(Vertex, Normal) + 0 * sizeof(float) },
+            { "ny", offsetof(Vertex, Normal) + 1 * sizeof(float) },
+            { "nz", offsetof(Vertex, Normal) + 2 * sizeof(float) },
+            { "u", offsetof(Vertex, UV) + 0 * sizeof(float) },
+            { "v", offsetof(Vertex, UV) + 1 * sizeof(float) },
+            { "s", offsetof(Vertex, UV) + 0 * sizeof(float) },
+            { "t", offsetof(Vertex, UV) + 1 * sizeof(float) },
+            { "texture_u", offsetof(Vertex, UV) + 0 * sizeof(float) },
+            { "texture_v", offsetof(Vertex, UV) + 1 * sizeof(float) },
+        };
+
+        for (auto& mapping : mappings)
+        {
+            if (!name.compare(mapping.name))
+            {
+                *offset = static_cast<UINT>(mapping.offset);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Number of records converted per thread at minimum.
+    const size_t c_MinVerticesPerThread = 1 << 16;
+    const size_t c_MinFacesPerThread = 1 << 16;
+}
+
+UINT PlyParser::SizeOf(ScalarType type)
+{
+    switch (type)
     {
-        ThrowIfTrue(true, "Integer type not implemented");
+    case ScalarType::Int8:
+    case ScalarType::UInt8: return 1;
+    case ScalarType::Int16:
+    case ScalarType::UInt16: return 2;
+    case ScalarType::Int32:
+    case ScalarType::UInt32:
+    case ScalarType::Float32: return 4;
+    case ScalarType::Float64: return 8;
+    default:
+        ThrowIfTrue(true, "Unknown scalar type");
         return 0;
     }
 }
 
-void PlyParser::ParseHeader()
+PlyParser::ScalarType PlyParser::ParseScalarType(const string &type)
+{
+    if (!type.compare("char") || !type.compare("int8")) return ScalarType::Int8;
+    if (!type.compare("uchar") || !type.compare("uint8")) return ScalarType::UInt8;
+    if (!type.compare("short") || !type.compare("int16")) return ScalarType::Int16;
+    if (!type.compare("ushort") || !type.compare("uint16")) return ScalarType::UInt16;
+    if (!type.compare("int") || !type.compare("int32")) return ScalarType::Int32;
+    if (!type.compare("uint") || !type.compare("uint32")) return ScalarType::UInt32;
+    if (!type.compare("float") || !type.compare("float32")) return ScalarType::Float32;
+    if (!type.compare("double") || !type.compare("float64")) return ScalarType::Float64;
+
+    ThrowIfTrue(true, "Unknown property type " + type);
+    return ScalarType::UInt8;
+}
+
+#define SELECT_READER(Func, Swap) \
+    switch (type) \
+    { \
+    case ScalarType::Int8: return Func<INT8, Swap>; \
+    case ScalarType::UInt8: return Func<UINT8, Swap>; \
+    case ScalarType::Int16: return Func<INT16, Swap>; \
+    case ScalarType::UInt16: return Func<UINT16, Swap>; \
+    case ScalarType::Int32: return Func<INT32, Swap>; \
+    case ScalarType::UInt32: return Func<UINT32, Swap>; \
+    case ScalarType::Float32: return Func<float, Swap>; \
+    case ScalarType::Float64: return Func<double, Swap>; \
+    default: return nullptr; \
+    }
+
+PlyParser::ReadFloatFunc PlyParser::GetFloatReader(ScalarType type) const
+{
+    if (m_format == Format::BinaryBigEndian)
+    {
+        SELECT_READER(ReadFloat, true);
+    }
+    SELECT_READER(ReadFloat, false);
+}
+
+PlyParser::ReadUintFunc PlyParser::GetUintReader(ScalarType type) const
 {
-    m_fileStream >> lastParsedWord;
-    ThrowIfTrue(lastParsedWord.compare("ply"), "First word in ply file expect to be \'Ply\'");
-    
-    while (m_fileStream.good())
+    if (m_format == Format::BinaryBigEndian)
     {
-        if (!lastParsedWord.compare("end_header"))
+        SELECT_READER(ReadUint, true);
+    }
+    SELECT_READER(ReadUint, false);
+}
+
+#undef SELECT_READER
+
+// Parses the header and returns a pointer to the first byte of the body.
+const char* PlyParser::ParseHeader(const char* pData, const char* pEnd)
+{
+    bool isFirstLine = true;
+    bool hasFormat = false;
+
+    while (pData < pEnd)
+    {
+        const char* pLineEnd = FindLineEnd(pData, pEnd);
+        const char* pToken = pData;
+        string keyword = NextToken(pToken, pLineEnd);
+        pData = min(pLineEnd + 1, pEnd);
+
+        if (isFirstLine)
         {
-            char tempBuffer[50];
-            m_fileStream.getline(tempBuffer, ARRAYSIZE(tempBuffer)); // Consume the last newline character;
-            break;
+            ThrowIfTrue(keyword.compare("ply"), "First word in ply file expect to be \'Ply\'");
+            isFirstLine = false;
         }
-        else if (!lastParsedWord.compare("property"))
+        else if (!keyword.compare("end_header"))
         {
-            m_fileStream >> lastParsedWord;
-            if (!lastParsedWord.compare("list"))
+            ThrowIfTrue(!hasFormat, "Ply file is missing a format");
+            return pData;
+        }
+        else if (!keyword.compare("format"))
+        {
+            string format = NextToken(pToken, pLineEnd);
+            if (!format.compare("ascii"))
             {
-                m_fileStream >> lastParsedWord;
-                m_BytesPerVertexCount = BytesPerIntegerType(lastParsedWord);
-                m_fileStream >> lastParsedWord;
-                m_BytesPerIndex = BytesPerIntegerType(lastParsedWord);
+                m_format = Format::Ascii;
             }
-            else if (!lastParsedWord.compare("float"))
+            else if (!format.compare("binary_little_endian"))
             {
-                m_fileStream >> lastParsedWord;
-                if (!lastParsedWord.compare("x"))
-                {
-                    m_elementLayout.push_back(Element(POSITION, X));
-                }
-                else if (!lastParsedWord.compare("y"))
-                {
-                    m_elementLayout.push_back(Element(POSITION, Y));
-                }
-                else if (!lastParsedWord.compare("z"))
-                {
-                    m_elementLayout.push_back(Element(POSITION, Z));
-                }
-                else if (!lastParsedWord.compare("nx"))
-                {
-                    m_elementLayout.push_back(Element(NORMAL, X));
-                }
-                else if (!lastParsedWord.compare("ny"))
+                m_format = Format::BinaryLittleEndian;
+            }
+            else if (!format.compare("binary_big_endian"))
+            {
+                m_format = Format::BinaryBigEndian;
+            }
+            else
+            {
+                ThrowIfTrue(true, "Unknown ply format " + format);
+            }
+            hasFormat = true;
+        }
+        else if (!keyword.compare("element"))
+        {
+            Element element;
+            element.name = NextToken(pToken, pLineEnd);
+            element.count = static_cast<UINT>(strtoul(NextToken(pToken, pLineEnd).c_str(), nullptr, 10));
+            m_elements.push_back(element);
+        }
+        else if (!keyword.compare("property"))
+        {
+            ThrowIfTrue(m_elements.empty(), "Property declared before an element");
+
+            Property property;
+            string type = NextToken(pToken, pLineEnd);
+            property.isList = !type.compare("list");
+            if (property.isList)
+            {
+                property.countType = ParseScalarType(NextToken(pToken, pLineEnd));
+                property.type = ParseScalarType(NextToken(pToken, pLineEnd));
+            }
+            else
+            {
+                property.type = ParseScalarType(type);
+            }
+            property.name = NextToken(pToken, pLineEnd);
+            m_elements.back().properties.push_back(property);
+        }
+        // Ignore comment, obj_info and any other lines.
+    }
+
+    ThrowIfTrue(true, "Ply header is missing end_header");
+    return pEnd;
+}
+
+// Compiles the vertex and face layouts declared in the header into converters.
+void PlyParser::CompileLayout()
+{
+    m_vertexFields.clear();
+    m_vertexStride = 0;
+    m_faceLayout = {};
+
+    for (auto& element : m_elements)
+    {
+        if (!element.name.compare("vertex"))
+        {
+            for (UINT i = 0; i < element.properties.size(); i++)
+            {
+                auto& property = element.properties[i];
+                ThrowIfTrue(property.isList, "List vertex properties are not supported");
+
+                VertexField field;
+                if (GetVertexPropertyOffset(property.name, &field.dstOffset))
                 {
-                    m_elementLayout.push_back(Element(NORMAL, Y));
+                    field.srcOffset = m_format == Format::Ascii ? i : m_vertexStride;
+                    field.read = GetFloatReader(property.type);
+                    m_vertexFields.push_back(field);
                 }
-                else if (!lastParsedWord.compare("nz"))
+                m_vertexStride += SizeOf(property.type);
+            }
+        }
+        else if (!element.name.compare("face"))
+        {
+            bool foundList = false;
+            for (UINT i = 0; i < element.properties.size(); i++)
+            {
+                auto& property = element.properties[i];
+                if (property.isList)
                 {
-                    m_elementLayout.push_back(Element(NORMAL, Z));
+                    ThrowIfTrue(foundList, "Only one list face property is supported");
+                    foundList = true;
+                    m_faceLayout.indexListProperty = i;
+                    m_faceLayout.countSize = SizeOf(property.countType);
+                    m_faceLayout.indexSize = SizeOf(property.type);
+                    m_faceLayout.readCount = GetUintReader(property.countType);
+                    m_faceLayout.readIndex = GetUintReader(property.type);
                 }
-                else if (!lastParsedWord.compare("u"))
+                else if (foundList)
                 {
-                    m_elementLayout.push_back(Element(TEXTURE, U));
+                    m_faceLayout.bytesAfterList += SizeOf(property.type);
                 }
-                else if (!lastParsedWord.compare("v"))
+                else
                 {
-                    m_elementLayout.push_back(Element(TEXTURE, V));
+                    m_faceLayout.bytesBeforeList += SizeOf(property.type);
                 }
             }
+            ThrowIfTrue(!foundList, "Face element is missing a vertex index list");
         }
-        else if (!lastParsedWord.compare("element"))
+    }
+}
+
+const char* PlyParser::ParseBinaryVertices(const char* pData, const char* pEnd, Mesh &mesh)
+{
+    const size_t numVertices = mesh.m_VertexBuffer.size();
+    ThrowIfTrue(static_cast<size_t>(pEnd - pData) < numVertices * m_vertexStride, "Unexpected end of file in vertex data");
+
+    ParallelFor(numVertices, c_MinVerticesPerThread, [&](size_t begin, size_t end)
+    {
+        const char* pRecord = pData + begin * m_vertexStride;
+        for (size_t i = begin; i < end; i++, pRecord += m_vertexStride)
         {
-            m_fileStream >> lastParsedWord;
-            if(!lastParsedWord.compare("face"))
+            char* pVertex = reinterpret_cast<char*>(&mesh.m_VertexBuffer[i]);
+            for (auto& field : m_vertexFields)
             {
-                m_fileStream >> m_numFaces;
+                *reinterpret_cast<float*>(pVertex + field.dstOffset) = field.read(pRecord + field.srcOffset);
             }
-            else if (!lastParsedWord.compare("vertex"))
+        }
+    });
+
+    return pData + numVertices * m_vertexStride;
+}
+
+const char* PlyParser::ParseBinaryFaces(const char* pData, const char* pEnd, Mesh &mesh)
+{
+    const FaceLayout& layout = m_faceLayout;
+    const size_t numFaces = mesh.m_IndexBuffer.size() / 3;
+    const UINT numVertices = static_cast<UINT>(mesh.m_VertexBuffer.size());
+    const size_t triangleStride = layout.bytesBeforeList + layout.countSize + 3 * layout.indexSize + layout.bytesAfterList;
+
+    // Fast path: assume all faces are triangles, so that every face record has the same size
+    // and ranges of faces can be converted independently. Any record that does not fit
+    // the assumption sends the whole element down the general path, which also reports errors.
+    if (static_cast<size_t>(pEnd - pData) >= numFaces * triangleStride)
+    {
+        atomic<bool> needsGeneralPath(false);
+
+        ParallelFor(numFaces, c_MinFacesPerThread, [&](size_t begin, size_t end)
+        {
+            const char* pRecord = pData + begin * triangleStride + layout.bytesBeforeList;
+            Index* pIndices = &mesh.m_IndexBuffer[3 * begin];
+            for (size_t face = begin; face < end; face++, pRecord += triangleStride)
             {
-                m_fileStream >> m_numVertices;
+                if (layout.readCount(pRecord) != 3 || needsGeneralPath)
+                {
+                    needsGeneralPath = true;
+                    return;
+                }
+
+                const char* pIndex = pRecord + layout.countSize;
+                for (UINT i = 0; i < 3; i++, pIndex += layout.indexSize)
+                {
+                    Index index = layout.readIndex(pIndex);
+                    if (index >= numVertices)
+                    {
+                        needsGeneralPath = true;
+                        return;
+                    }
+                    *pIndices++ = index;
+                }
             }
+        });
+
+        if (!needsGeneralPath)
+        {
+            return pData + numFaces * triangleStride;
         }
-        else
+    }
+
+    // Polygons: walk the variable size records and triangulate each face as a fan.
+    mesh.m_IndexBuffer.clear();
+    for (size_t face = 0; face < numFaces; face++)
+    {
+        ThrowIfTrue(static_cast<size_t>(pEnd - pData) < layout.bytesBeforeList + layout.countSize, "Unexpected end of file in face data");
+        pData += layout.bytesBeforeList;
+        UINT numIndices = layout.readCount(pData);
+        pData += layout.countSize;
+
+        ThrowIfTrue(static_cast<size_t>(pEnd - pData) < numIndices * layout.indexSize + layout.bytesAfterList, "Unexpected end of file in face data");
+        ThrowIfTrue(numIndices < 3, "Faces with fewer than 3 vertices are not supported");
+
+        Index first = layout.readIndex(pData);
+        Index previous = layout.readIndex(pData + layout.indexSize);
+        for (UINT i = 2; i < numIndices; i++)
         {
-            m_fileStream >> lastParsedWord;
+            Index current = layout.readIndex(pData + i * layout.indexSize);
+            ThrowIfTrue(max(max(first, previous), current) >= numVertices, "Vertex index out of range");
+            mesh.m_IndexBuffer.push_back(first);
+            mesh.m_IndexBuffer.push_back(previous);
+            mesh.m_IndexBuffer.push_back(current);
+            previous = current;
         }
+        pData += numIndices * layout.indexSize + layout.bytesAfterList;
     }
+    return pData;
 }
 
-UINT32 PlyParser::ParseVariableInteger(UINT8 bytePerInteger, void *pData)
+const char* PlyParser::SkipBinaryElement(const char* pData, const char* pEnd, const Element& element)
 {
-    switch (bytePerInteger)
-    {
-    case 1:
-    {
-        return (UINT32)(*(UINT8*)pData);
-    }
-    case 4:
+    for (UINT record = 0; record < element.count; record++)
     {
-        return (*(UINT32*)pData);
-    }
-    default:
-        ThrowIfTrue(true, "Unimplemented integer type");
-        return 0;
+        for (auto& property : element.properties)
+        {
+            if (property.isList)
+            {
+                ThrowIfTrue(static_cast<size_t>(pEnd - pData) < SizeOf(property.countType), "Unexpected end of file");
+                UINT count = GetUintReader(property.countType)(pData);
+                pData += SizeOf(property.countType) + count * SizeOf(property.type);
+            }
+            else
+            {
+                pData += SizeOf(property.type);
+            }
+            ThrowIfTrue(pData > pEnd, "Unexpected end of file");
+        }
     }
+    return pData;
 }
 
-void PlyParser::ParseBody(SceneParser::Mesh &mesh)
+void PlyParser::ParseAsciiBody(const char* pData, const char* pEnd, Mesh &mesh)
 {
-    ThrowIfTrue(m_fileStream.fail());
-    ThrowIfTrue(m_fileStream.eof());
-    mesh.m_VertexBuffer.resize(m_numVertices);
-	mesh.m_IndexBuffer.reserve(3 * m_numFaces);
-
-    const UINT vertexSize = static_cast<UINT>(m_elementLayout.size() * sizeof(float));
-    const UINT verticesPerBuffer = 150;
-    const UINT bufferSize = vertexSize * verticesPerBuffer;
-    unique_ptr<char[]> pLineBuffer = unique_ptr<char[]>(new char[bufferSize]);
-    char *pIterator = pLineBuffer.get();
-    
-    for (UINT vertex = 0; vertex < m_numVertices; vertex++)
+    // Index all non-empty lines, so that the records of each element can be converted in parallel.
+    vector<const char*> lines;
+    while (pData < pEnd)
     {
-        if (vertex % verticesPerBuffer == 0)
+        const char* pLineEnd = FindLineEnd(pData, pEnd);
+        const char* pFirstChar = pData;
+        while (pFirstChar < pLineEnd && isspace(static_cast<unsigned char>(*pFirstChar)))
         {
-            UINT verticesLeft = m_numVertices - vertex;
-            UINT readSize = min(verticesLeft * vertexSize, bufferSize);
+            pFirstChar++;
+        }
+        if (pFirstChar < pLineEnd)
+        {
+            lines.push_back(pFirstChar);
+        }
+        pData = pLineEnd + 1;
+    }
 
-            m_fileStream.read(pLineBuffer.get(), readSize);
-            ThrowIfTrue(m_fileStream.eof());
-            ThrowIfTrue(m_fileStream.fail(), "Failed to open a file");
+    size_t firstLine = 0;
+    for (auto& element : m_elements)
+    {
+        ThrowIfTrue(lines.size() - firstLine < element.count, "Unexpected end of file in " + element.name + " data");
+        const char* const* pLines = &lines[firstLine];
+        firstLine += element.count;
 
-            pIterator = pLineBuffer.get();
+        if (!element.name.compare("vertex"))
+        {
+            const size_t numValues = element.properties.size();
+            ParallelFor(element.count, c_MinVerticesPerThread, [&](size_t begin, size_t end)
+            {
+                vector<float> values(numValues);
+                for (size_t i = begin; i < end; i++)
+                {
+                    const char* pToken = pLines[i];
+                    for (auto& value : values)
+                    {
+                        char* pTokenEnd;
+                        value = strtof(pToken, &pTokenEnd);
+                        ThrowIfTrue(pTokenEnd == pToken, "Malformed vertex record");
+                        pToken = pTokenEnd;
+                    }
+
+                    char* pVertex = reinterpret_cast<char*>(&mesh.m_VertexBuffer[i]);
+                    for (auto& field : m_vertexFields)
+                    {
+                        *reinterpret_cast<float*>(pVertex + field.dstOffset) = values[field.srcOffset];
+                    }
+                }
+            });
         }
+        else if (!element.name.compare("face"))
+        {
+            // Faces may be polygons, so each range triangulates into its own buffer first.
+            const UINT numVertices = static_cast<UINT>(mesh.m_VertexBuffer.size());
+            const size_t maxThreads = max<size_t>(1, thread::hardware_concurrency());
+            const size_t facesPerRange = max(c_MinFacesPerThread, (element.count + maxThreads - 1) / maxThreads);
+            const size_t numRanges = (element.count + facesPerRange - 1) / facesPerRange;
+            vector<vector<Index>> rangeIndices(numRanges);
+
+            ParallelFor(numRanges, 1, [&](size_t beginRange, size_t endRange)
+            {
+                for (size_t range = beginRange; range < endRange; range++)
+                {
+                    auto& indices = rangeIndices[range];
+                    size_t end = min<size_t>(element.count, (range + 1) * facesPerRange);
+                    indices.reserve(3 * (end - range * facesPerRange));
 
-        SceneParser::Vertex &v = mesh.m_VertexBuffer[vertex];
+                    for (size_t i = range * facesPerRange; i < end; i++)
+                    {
+                        char* pToken = const_cast<char*>(pLines[i]);
+                        for (UINT property = 0; property < m_faceLayout.indexListProperty; property++)
+                        {
+                            strtod(pToken, &pToken);
+                        }
 
-        for (auto element : m_elementLayout)
-        {
-            float* pValue = nullptr;
-            switch (element.first)
+                        UINT numIndices = strtoul(pToken, &pToken, 10);
+                        ThrowIfTrue(numIndices < 3, "Faces with fewer than 3 vertices are not supported");
+
+                        Index first = strtoul(pToken, &pToken, 10);
+                        Index previous = strtoul(pToken, &pToken, 10);
+                        for (UINT j = 2; j < numIndices; j++)
+                        {
+                            Index current = strtoul(pToken, &pToken, 10);
+                            ThrowIfTrue(max(max(first, previous), current) >= numVertices, "Vertex index out of range");
+                            indices.push_back(first);
+                            indices.push_back(previous);
+                            indices.push_back(current);
+                            previous = current;
+                        }
+                    }
+                }
+            });
+
+            size_t numIndices = 0;
+            for (auto& indices : rangeIndices)
             {
-            case POSITION:
-                pValue = &v.Position[element.second];
-                break;
-            case NORMAL:
-                pValue = &v.Normal[element.second];
-                break;
-            case TEXTURE:
-                pValue = &v.UV[element.second];
-                break;
+                numIndices += indices.size();
             }
+            mesh.m_IndexBuffer.resize(numIndices);
 
-            *pValue = *(float *)pIterator;
-            pIterator += sizeof(float);
+            auto pDest = mesh.m_IndexBuffer.begin();
+            for (auto& indices : rangeIndices)
+            {
+                pDest = copy(indices.begin(), indices.end(), pDest);
+            }
         }
     }
+}
 
-    const UINT faceSize = m_BytesPerVertexCount + 3 * m_BytesPerIndex;
-    const UINT facesPerBuffer = bufferSize / faceSize;
-    const UINT faceBufferSize = faceSize * facesPerBuffer;
-    for (UINT face = 0; face < m_numFaces; face++)
+void PlyParser::Parse(const string &filename, SceneParser::Mesh &mesh)
+{
+    MappedFile file(filename);
+    ThrowIfTrue(!file.IsValid(), "Failure opening file");
+
+    const char* pBody = ParseHeader(file.Data(), file.End());
+    CompileLayout();
+
+    UINT numVertices = 0;
+    UINT numFaces = 0;
+    for (auto& element : m_elements)
     {
-        if (face % facesPerBuffer == 0)
+        if (!element.name.compare("vertex"))
         {
-            UINT facesLeft = m_numFaces - face;
-            UINT readSize = min(facesLeft * faceSize, faceBufferSize);
-            m_fileStream.read(pLineBuffer.get(), readSize);
-            ThrowIfTrue(m_fileStream.fail(), "Failed to open a files");
-
-            pIterator = pLineBuffer.get();
+            numVertices = element.count;
         }
+        else if (!element.name.compare("face"))
+        {
+            numFaces = element.count;
+        }
+    }
 
-        auto numIndicesPerFace = ParseVariableInteger(m_BytesPerVertexCount, pIterator);
-        ThrowIfTrue(numIndicesPerFace != 3, "Not supporting non-triangle faces");
-        pIterator += m_BytesPerVertexCount;
+    // Presize the buffers. Vertices that lack texture coordinates get zero UVs.
+    Vertex defaultVertex;
+    defaultVertex.UV.xmFloat2 = XMFLOAT2(0, 0);
+    mesh.m_VertexBuffer.assign(numVertices, defaultVertex);
+    mesh.m_IndexBuffer.resize(3 * static_cast<size_t>(numFaces));
 
-        for (UINT faceIndex = 0; faceIndex < numIndicesPerFace; faceIndex++)
+    if (m_format == Format::Ascii)
+    {
+        ParseAsciiBody(pBody, file.End(), mesh);
+    }
+    else
+    {
+        const char* pData = pBody;
+        for (auto& element : m_elements)
         {
-            mesh.m_IndexBuffer.push_back((int)ParseVariableInteger(m_BytesPerIndex, pIterator));
-            pIterator += m_BytesPerIndex;
+            if (!element.name.compare("vertex"))
+            {
+                pData = ParseBinaryVertices(pData, file.End(), mesh);
+            }
+            else if (!element.name.compare("face"))
+            {
+                pData = ParseBinaryFaces(pData, file.End(), mesh);
+            }
+            else
+            {
+                pData = SkipBinaryElement(pData, file.End(), element);
+            }
         }
     }
 
     mesh.GenerateTangents();
 }
 
-void PlyParser::Parse(const string &filename, SceneParser::Mesh &mesh)
-{
-    m_fileStream = ifstream(filename, ios::in | ios::binary);
-    ThrowIfTrue(!m_fileStream.good(), "Failure opening file");
-
-    ParseHeader();
-    ParseBody(mesh);
-}
-
 }
\ No newline at end of file
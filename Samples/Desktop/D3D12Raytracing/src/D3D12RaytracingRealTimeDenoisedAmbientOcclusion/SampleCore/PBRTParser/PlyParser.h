@@ -17,41 +17,91 @@
 #pragma once
 namespace PlyParser
 {
+    // Loads triangle meshes from ascii, binary little endian and binary big endian PLY files.
+    // The file is memory mapped and the header is compiled once into a table of per-property
+    // converters. Vertex and face ranges are then converted on multiple threads straight into
+    // presized vertex and index buffers.
     class PlyParser
     {
     public:
         void Parse(const std::string &filename, SceneParser::Mesh &mesh);
-        void ParseHeader();
-        void ParseBody(SceneParser::Mesh &mesh);
+
     private:
-        UINT8 BytesPerIntegerType(std::string type);
-        UINT32 ParseVariableInteger(UINT8 bytePerInteger, void *pData);
+        enum class Format
+        {
+            Ascii,
+            BinaryLittleEndian,
+            BinaryBigEndian
+        };
 
-        std::ifstream m_fileStream;
-        std::string lastParsedWord;
+        enum class ScalarType
+        {
+            Int8,
+            UInt8,
+            Int16,
+            UInt16,
+            Int32,
+            UInt32,
+            Float32,
+            Float64
+        };
 
-        enum ElementType
+        struct Property
         {
-            POSITION,
-            NORMAL,
-            TEXTURE
+            std::string name;
+            ScalarType type;
+            bool isList;
+            ScalarType countType;
         };
 
-        enum ElementIndex
+        struct Element
         {
-            U = 0,
-            V = 1,
-            X = 0,
-            Y = 1,
-            Z = 2,
+            std::string name;
+            UINT count;
+            std::vector<Property> properties;
         };
 
-        UINT8 m_BytesPerVertexCount;
-        UINT8 m_BytesPerIndex;
+        typedef float(*ReadFloatFunc)(const char*);
+        typedef UINT(*ReadUintFunc)(const char*);
+
+        // A vertex property compiled to a conversion of its source bytes into a float of SceneParser::Vertex.
+        struct VertexField
+        {
+            UINT srcOffset;         // Byte offset in a binary vertex record. Token index for ascii.
+            UINT dstOffset;         // Byte offset in SceneParser::Vertex.
+            ReadFloatFunc read;
+        };
+
+        // Face record layout, compiled from the header.
+        struct FaceLayout
+        {
+            UINT indexListProperty;     // Index of the vertex index list among the face properties.
+            UINT bytesBeforeList;       // Bytes of fixed size properties preceding the list.
+            UINT bytesAfterList;        // Bytes of fixed size properties following the list.
+            UINT countSize;
+            UINT indexSize;
+            ReadUintFunc readCount;
+            ReadUintFunc readIndex;
+        };
+
+        const char* ParseHeader(const char* pData, const char* pEnd);
+        void CompileLayout();
+
+        const char* ParseBinaryVertices(const char* pData, const char* pEnd, SceneParser::Mesh &mesh);
+        const char* ParseBinaryFaces(const char* pData, const char* pEnd, SceneParser::Mesh &mesh);
+        const char* SkipBinaryElement(const char* pData, const char* pEnd, const Element& element);
+        void ParseAsciiBody(const char* pData, const char* pEnd, SceneParser::Mesh &mesh);
+
+        static UINT SizeOf(ScalarType type);
+        static ScalarType ParseScalarType(const std::string &type);
+        ReadFloatFunc GetFloatReader(ScalarType type) const;
+        ReadUintFunc GetUintReader(ScalarType type) const;
+
+        Format m_format;
+        std::vector<Element> m_elements;
 
-        typedef std::pair<ElementType, ElementIndex> Element;
-        std::vector<Element> m_elementLayout;
-        UINT m_numFaces;
-        UINT m_numVertices;
+        std::vector<VertexField> m_vertexFields;
+        UINT m_vertexStride;    // Bytes per binary vertex record.
+        FaceLayout m_faceLayout;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,417 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "stdafx.h"
+#include <type_traits>
+#include "SceneParser.h"
+#include "ParserUtils.h"
+#include "SceneCache.h"
+
+using namespace std;
+
+namespace SceneParser
+{
+namespace SceneCache
+{
+
+namespace
+{
+    const char c_Magic[8] = { 'P', 'B', 'R', 'T', 'S', 'C', 'N', '\0' };
+
+    static_assert(is_trivially_copyable<Camera>::value, "Camera is stored as raw bytes");
+    static_assert(is_trivially_copyable<Vertex>::value, "Vertices are stored as raw bytes");
+
+    struct SourceFile
+    {
+        string filename;
+        UINT64 size = 0;
+        UINT64 lastWriteTime = 0;
+        UINT64 hash = 0;
+    };
+
+    // Reads the size and last write time of a source file from the file system, without opening it.
+    bool GetSourceFileStamp(SourceFile &source)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+        if (!GetFileAttributesExA(source.filename.c_str(), GetFileExInfoStandard, &attributes))
+        {
+            return false;
+        }
+        source.size = (static_cast<UINT64>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+        source.lastWriteTime = (static_cast<UINT64>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+        return true;
+    }
+
+    // Hashes the current contents of the given source files. Returns false if any of them can't be read.
+    bool HashSourceFiles(vector<SourceFile*> &sources)
+    {
+        atomic<bool> allValid(true);
+        ParallelForEach(sources.size(), [&](size_t i)
+        {
+            MappedFile file(sources[i]->filename);
+            if (!file.IsValid())
+            {
+                allValid = false;
+                return;
+            }
+            sources[i]->size = file.Size();
+            sources[i]->hash = HashBytes(file.Data(), file.Size());
+        });
+        return allValid;
+    }
+
+    class Writer
+    {
+    public:
+        void Write(const void *pData, size_t size)
+        {
+            const char *pBytes = static_cast<const char*>(pData);
+            m_buffer.insert(m_buffer.end(), pBytes, pBytes + size);
+        }
+
+        template <typename T>
+        void Write(const T &value)
+        {
+            static_assert(is_trivially_copyable<T>::value, "Only trivially copyable types can be written directly");
+            Write(&value, sizeof(T));
+        }
+
+        void Write(const string &str)
+        {
+            Write(static_cast<UINT64>(str.size()));
+            Write(str.data(), str.size());
+        }
+
+        template <typename T>
+        void Write(const vector<T> &values)
+        {
+            static_assert(is_trivially_copyable<T>::value, "Only trivially copyable types can be written directly");
+            Write(static_cast<UINT64>(values.size()));
+            Write(values.data(), values.size() * sizeof(T));
+        }
+
+        const vector<char>& Buffer() const { return m_buffer; }
+
+    private:
+        vector<char> m_buffer;
+    };
+
+    // Reads from a mapped cache file. Reading past the end marks the reader as failed
+    // and returns zeroed data, so callers only need to check IsValid() once at the end.
+    class Reader
+    {
+    public:
+        Reader(const char *pData, const char *pEnd) : m_pData(pData), m_pEnd(pEnd) {}
+
+        void Read(void *pData, size_t size)
+        {
+            if (!m_valid || static_cast<size_t>(m_pEnd - m_pData) < size)
+            {
+                m_valid = false;
+                memset(pData, 0, size);
+                return;
+            }
+            memcpy(pData, m_pData, size);
+            m_pData += size;
+        }
+
+        template <typename T>
+        void Read(T &value)
+        {
+            static_assert(is_trivially_copyable<T>::value, "Only trivially copyable types can be read directly");
+            Read(&value, sizeof(T));
+        }
+
+        void Read(string &str)
+        {
+            UINT64 size = ReadCount(1);
+            str.assign(m_pData, static_cast<size_t>(size));
+            m_pData += size;
+        }
+
+        template <typename T>
+        void Read(vector<T> &values)
+        {
+            static_assert(is_trivially_copyable<T>::value, "Only trivially copyable types can be read directly");
+            UINT64 count = ReadCount(sizeof(T));
+            values.resize(static_cast<size_t>(count));
+            Read(values.data(), values.size() * sizeof(T));
+        }
+
+        bool IsValid() const { return m_valid; }
+        bool IsAtEnd() const { return m_pData == m_pEnd; }
+
+    private:
+        // Reads an element count and validates it against the remaining data.
+        UINT64 ReadCount(size_t elementSize)
+        {
+            UINT64 count = 0;
+            Read(count);
+            if (count > static_cast<UINT64>(m_pEnd - m_pData) / elementSize)
+            {
+                m_valid = false;
+                return 0;
+            }
+            return count;
+        }
+
+        const char *m_pData;
+        const char *m_pEnd;
+        bool m_valid = true;
+    };
+
+    void WriteMaterial(Writer &writer, const Material &material)
+    {
+        writer.Write(material.m_MaterialName);
+        writer.Write(material.m_Type);
+        writer.Write(material.m_Kd);
+        writer.Write(material.m_Ks);
+        writer.Write(material.m_Kr);
+        writer.Write(material.m_Kt);
+        writer.Write(material.m_Opacity);
+        writer.Write(material.m_Eta);
+        writer.Write(material.m_Roughness);
+        writer.Write(material.m_DiffuseTextureFilename);
+        writer.Write(material.m_SpecularTextureFilename);
+        writer.Write(material.m_OpacityTextureFilename);
+        writer.Write(material.m_NormalMapTextureFilename);
+    }
+
+    void ReadMaterial(Reader &reader, Material &material)
+    {
+        reader.Read(material.m_MaterialName);
+        reader.Read(material.m_Type);
+        reader.Read(material.m_Kd);
+        reader.Read(material.m_Ks);
+        reader.Read(material.m_Kr);
+        reader.Read(material.m_Kt);
+        reader.Read(material.m_Opacity);
+        reader.Read(material.m_Eta);
+        reader.Read(material.m_Roughness);
+        reader.Read(material.m_DiffuseTextureFilename);
+        reader.Read(material.m_SpecularTextureFilename);
+        reader.Read(material.m_OpacityTextureFilename);
+        reader.Read(material.m_NormalMapTextureFilename);
+    }
+
+    // Meshes reference their material by its key in Scene::m_Materials.
+    void WriteMesh(Writer &writer, const Mesh &mesh, const unordered_map<const Material*, string> &materialKeys)
+    {
+        auto materialKey = materialKeys.find(mesh.m_pMaterial);
+        writer.Write(materialKey != materialKeys.end() ? materialKey->second : string());
+        writer.Write(mesh.m_transform);
+        writer.Write(mesh.m_VertexBuffer);
+        writer.Write(mesh.m_IndexBuffer);
+    }
+
+    void ReadMesh(Reader &reader, Mesh &mesh, Scene &scene)
+    {
+        string materialKey;
+        reader.Read(materialKey);
+        auto material = scene.m_Materials.find(materialKey);
+        mesh.m_pMaterial = material != scene.m_Materials.end() ? &material->second : nullptr;
+        reader.Read(mesh.m_transform);
+        reader.Read(mesh.m_VertexBuffer);
+        reader.Read(mesh.m_IndexBuffer);
+    }
+}
+
+bool Load(const string &cacheFilename, Flags flags, Scene &scene)
+{
+    MappedFile file(cacheFilename);
+    if (!file.IsValid())
+    {
+        return false;
+    }
+    Reader reader(file.Data(), file.End());
+
+    char magic[sizeof(c_Magic)];
+    UINT version, cachedFlags;
+    reader.Read(magic, sizeof(magic));
+    reader.Read(version);
+    reader.Read(cachedFlags);
+    if (!reader.IsValid() || memcmp(magic, c_Magic, sizeof(c_Magic)) || version != Version || cachedFlags != flags)
+    {
+        return false;
+    }
+
+    // Validate against the current source files.
+    UINT numSources;
+    reader.Read(numSources);
+    vector<SourceFile> cachedSources(numSources);
+    for (auto& source : cachedSources)
+    {
+        reader.Read(source.filename);
+        reader.Read(source.size);
+        reader.Read(source.lastWriteTime);
+        reader.Read(source.hash);
+    }
+    if (!reader.IsValid())
+    {
+        return false;
+    }
+
+    // A source whose size and last write time are unchanged is taken to be unchanged. Only sources
+    // that were written to since are hashed, so a touched but otherwise unmodified file still hits.
+    vector<SourceFile> currentSources(numSources);
+    vector<SourceFile*> touchedSources;
+    for (UINT i = 0; i < numSources; i++)
+    {
+        currentSources[i].filename = cachedSources[i].filename;
+        if (!GetSourceFileStamp(currentSources[i]) || currentSources[i].size != cachedSources[i].size)
+        {
+            return false;
+        }
+        if (currentSources[i].lastWriteTime != cachedSources[i].lastWriteTime)
+        {
+            touchedSources.push_back(&currentSources[i]);
+        }
+        else
+        {
+            currentSources[i].hash = cachedSources[i].hash;
+        }
+    }
+    if (!HashSourceFiles(touchedSources))
+    {
+        return false;
+    }
+    for (UINT i = 0; i < numSources; i++)
+    {
+        if (currentSources[i].size != cachedSources[i].size || currentSources[i].hash != cachedSources[i].hash)
+        {
+            return false;
+        }
+    }
+
+    // Read the scene into a temporary so that a truncated cache leaves scene untouched.
+    Scene cachedScene;
+    reader.Read(cachedScene.m_Camera);
+    reader.Read(cachedScene.m_Film.m_ResolutionX);
+    reader.Read(cachedScene.m_Film.m_ResolutionY);
+    reader.Read(cachedScene.m_Film.m_Filename);
+
+    UINT64 numMaterials;
+    reader.Read(numMaterials);
+    for (UINT64 i = 0; i < numMaterials && reader.IsValid(); i++)
+    {
+        string key;
+        reader.Read(key);
+        ReadMaterial(reader, cachedScene.m_Materials[key]);
+    }
+
+    UINT64 numMeshes;
+    reader.Read(numMeshes);
+    for (UINT64 i = 0; i < numMeshes && reader.IsValid(); i++)
+    {
+        cachedScene.m_Meshes.push_back(Mesh());
+        ReadMesh(reader, cachedScene.m_Meshes.back(), cachedScene);
+    }
+
+    UINT64 numAreaLights;
+    reader.Read(numAreaLights);
+    for (UINT64 i = 0; i < numAreaLights && reader.IsValid(); i++)
+    {
+        Vector3 lightColor;
+        reader.Read(lightColor);
+        cachedScene.m_AreaLights.push_back(AreaLight(lightColor));
+        ReadMesh(reader, cachedScene.m_AreaLights.back().m_Mesh, cachedScene);
+    }
+
+    reader.Read(cachedScene.m_EnvironmentMap.m_FileName);
+    reader.Read(cachedScene.m_transform);
+
+    if (!reader.IsValid() || !reader.IsAtEnd())
+    {
+        return false;
+    }
+
+    scene = move(cachedScene);
+    return true;
+}
+
+bool Save(const string &cacheFilename, Flags flags, const vector<string> &sourceFilenames, const Scene &scene)
+{
+    // Stamp before hashing, so a file written to while it is hashed has a newer time than the cache
+    // records, and is hashed again on the next load.
+    vector<SourceFile> sources(sourceFilenames.size());
+    vector<SourceFile*> allSources(sources.size());
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        sources[i].filename = sourceFilenames[i];
+        if (!GetSourceFileStamp(sources[i]))
+        {
+            return false;
+        }
+        allSources[i] = &sources[i];
+    }
+    if (!HashSourceFiles(allSources))
+    {
+        return false;
+    }
+
+    Writer writer;
+    writer.Write(c_Magic, sizeof(c_Magic));
+    writer.Write(Version);
+    writer.Write(flags);
+    writer.Write(static_cast<UINT>(sources.size()));
+    for (auto& source : sources)
+    {
+        writer.Write(source.filename);
+        writer.Write(source.size);
+        writer.Write(source.lastWriteTime);
+        writer.Write(source.hash);
+    }
+
+    writer.Write(scene.m_Camera);
+    writer.Write(scene.m_Film.m_ResolutionX);
+    writer.Write(scene.m_Film.m_ResolutionY);
+    writer.Write(scene.m_Film.m_Filename);
+
+    unordered_map<const Material*, string> materialKeys;
+    writer.Write(static_cast<UINT64>(scene.m_Materials.size()));
+    for (auto& material : scene.m_Materials)
+    {
+        materialKeys[&material.second] = material.first;
+        writer.Write(material.first);
+        WriteMaterial(writer, material.second);
+    }
+
+    writer.Write(static_cast<UINT64>(scene.m_Meshes.size()));
+    for (auto& mesh : scene.m_Meshes)
+    {
+        WriteMesh(writer, mesh, materialKeys);
+    }
+
+    writer.Write(static_cast<UINT64>(scene.m_AreaLights.size()));
+    for (auto& areaLight : scene.m_AreaLights)
+    {
+        writer.Write(areaLight.m_LightColor);
+        WriteMesh(writer, areaLight.m_Mesh, materialKeys);
+    }
+
+    writer.Write(scene.m_EnvironmentMap.m_FileName);
+    writer.Write(scene.m_transform);
+
+    // Write to a temporary file first so that an interrupted write never leaves a partial cache behind.
+    string tempFilename = cacheFilename + ".tmp";
+    {
+        ofstream file(tempFilename, ios::out | ios::binary | ios::trunc);
+        file.write(writer.Buffer().data(), writer.Buffer().size());
+        if (!file.good())
+        {
+            return false;
+        }
+    }
+    return MoveFileExA(tempFilename.c_str(), cacheFilename.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+}
+
+}
+}
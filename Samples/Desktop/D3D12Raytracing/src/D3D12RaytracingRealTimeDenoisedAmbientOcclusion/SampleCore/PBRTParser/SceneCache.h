@@ -0,0 +1,36 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+#include "SceneParser.h"
+
+namespace SceneParser
+{
+    // Binary cache of a fully processed Scene.
+    // The cache stores the size, last write time and content hash of every source file the
+    // scene was parsed from, and is only loaded if all of them still match. Only sources with
+    // a new write time are hashed again. Cached data is copied out of a single mapped view of
+    // the cache file.
+    namespace SceneCache
+    {
+        // Bump whenever the file layout or the parser's output changes.
+        static const UINT Version = 2;
+
+        // Options the scene was parsed with. A cache is only valid for the same options.
+        typedef UINT Flags;
+
+        // Returns true if scene was filled in from a valid, up to date cache file.
+        bool Load(const std::string &cacheFilename, Flags flags, Scene &scene);
+
+        // Writes scene to cacheFilename. Failures are not fatal, the cache is just not written.
+        bool Save(const std::string &cacheFilename, Flags flags, const std::vector<std::string> &sourceFilenames, const Scene &scene);
+    }
+}
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include "ParserUtils.h"
+
 namespace SceneParser
 {
 
@@ -195,42 +197,46 @@ namespace SceneParser
 
         void GenerateTangents()
         {
-            // Zero tangents.
-            for (auto& vertex : m_VertexBuffer)
+            const size_t MinTrianglesPerThread = 16384;
+            const size_t MinVerticesPerThread = 32768;
+            const size_t numTriangles = m_IndexBuffer.size() / 3;
+
+            // Calculate per triangle tangents.
+            std::vector<XMFLOAT3> triangleTangents(numTriangles);
+            ParallelFor(numTriangles, MinTrianglesPerThread, [&](size_t begin, size_t end)
             {
-                vertex.Tangent.xmFloat3 = XMFLOAT3(0, 0, 0);
-            }
+                for (size_t t = begin; t < end; t++)
+                {
+                    const Vertex& v0 = m_VertexBuffer[m_IndexBuffer[3 * t]];
+                    const Vertex& v1 = m_VertexBuffer[m_IndexBuffer[3 * t + 1]];
+                    const Vertex& v2 = m_VertexBuffer[m_IndexBuffer[3 * t + 2]];
+                    triangleTangents[t] = CalculateTangent(
+                        v0.Position.xmFloat3, v1.Position.xmFloat3, v2.Position.xmFloat3,
+                        v0.UV.xmFloat2, v1.UV.xmFloat2, v2.UV.xmFloat2);
+                }
+            });
 
             // Add tangents from all triangles a vertex corresponds to.
-            for (UINT i = 0; i < m_IndexBuffer.size(); i += 3)
+            // Vertices are shared across triangles, so the scatter stays serial.
+            std::vector<XMFLOAT3> vertexTangents(m_VertexBuffer.size(), XMFLOAT3(0, 0, 0));
+            for (size_t t = 0; t < numTriangles; t++)
             {
-                auto& index0 = m_IndexBuffer[i];
-                auto& index1 = m_IndexBuffer[i+1];
-                auto& index2 = m_IndexBuffer[i+2];
-                XMFLOAT3& v0 = m_VertexBuffer[index0].Position.xmFloat3;
-                XMFLOAT3& v1 = m_VertexBuffer[index1].Position.xmFloat3;
-                XMFLOAT3& v2 = m_VertexBuffer[index2].Position.xmFloat3;
-
-                XMFLOAT2& uv0 = m_VertexBuffer[index0].UV.xmFloat2;
-                XMFLOAT2& uv1 = m_VertexBuffer[index1].UV.xmFloat2;
-                XMFLOAT2& uv2 = m_VertexBuffer[index2].UV.xmFloat2;
-
-                Vector3& tangent1 = m_VertexBuffer[index0].Tangent;
-                Vector3& tangent2 = m_VertexBuffer[index1].Tangent;
-                Vector3& tangent3 = m_VertexBuffer[index2].Tangent;
-
-                XMVECTOR tangent = XMLoadFloat3(&CalculateTangent(v0, v1, v2, uv0, uv1, uv2));
-
-                XMStoreFloat3(&tangent1.xmFloat3, tangent1.GetXMVECTOR() + tangent);
-                XMStoreFloat3(&tangent2.xmFloat3, tangent2.GetXMVECTOR() + tangent);
-                XMStoreFloat3(&tangent3.xmFloat3, tangent3.GetXMVECTOR() + tangent);
+                XMVECTOR tangent = XMLoadFloat3(&triangleTangents[t]);
+                for (size_t i = 0; i < 3; i++)
+                {
+                    XMFLOAT3& vertexTangent = vertexTangents[m_IndexBuffer[3 * t + i]];
+                    XMStoreFloat3(&vertexTangent, XMLoadFloat3(&vertexTangent) + tangent);
+                }
             }
 
             // Renormalize the tangents.
-            for (auto& vertex : m_VertexBuffer)
+            ParallelFor(m_VertexBuffer.size(), MinVerticesPerThread, [&](size_t begin, size_t end)
             {
-                XMStoreFloat3(&vertex.Tangent.xmFloat3, XMVector3Normalize(XMLoadFloat3(&vertex.Tangent.xmFloat3)));
-            }
+                for (size_t i = begin; i < end; i++)
+                {
+                    XMStoreFloat3(&m_VertexBuffer[i].Tangent.xmFloat3, XMVector3Normalize(XMLoadFloat3(&vertexTangents[i])));
+                }
+            });
         }
     };
 
@@ -13,6 +13,7 @@
 #include "RaytracingAccelerationStructure.h"
 #include "D3D12RaytracingRealTimeDenoisedAmbientOcclusion.h"
 #include "EngineProfiling.h"
+#include "AccelerationStructureCache.h"
 
 using namespace std;
 
@@ -106,6 +107,7 @@ void BottomLevelAccelerationStructure::Initialize(
 
     m_buildFlags = buildFlags;
     m_name = bottomLevelASGeometry.GetName();
+    m_geometryHash = bottomLevelASGeometry.m_geometryHash;
     
     if (allowUpdate)
     {
@@ -116,10 +118,46 @@ void BottomLevelAccelerationStructure::Initialize(
 	ComputePrebuildInfo(device);
 	AllocateResource(device);
 
+    m_numTriangles = 0;
+    for (auto& geometryDesc : m_geometryDescs)
+    {
+        auto& triangles = geometryDesc.Triangles;
+        m_numTriangles += (triangles.IndexFormat != DXGI_FORMAT_UNKNOWN ? triangles.IndexCount : triangles.VertexCount) / 3;
+    }
+
+    m_isGeometryDirty.assign(m_geometryDescs.size(), false);
+    ClearGeometryChanges();
+    m_displacementSinceRebuild = 0;
+    m_numUpdatesSinceRebuild = 0;
+
 	m_isDirty = true;
     m_isBuilt = false;
 }
 
+void BottomLevelAccelerationStructure::SetGeometryDirty(UINT geometryIndex, float relativeDisplacement)
+{
+    if (!m_isGeometryDirty[geometryIndex])
+    {
+        m_isGeometryDirty[geometryIndex] = true;
+        m_numDirtyGeometries++;
+    }
+    m_pendingDisplacement = max(m_pendingDisplacement, relativeDisplacement);
+    m_isDirty = true;
+}
+
+void BottomLevelAccelerationStructure::ClearGeometryChanges()
+{
+    fill(m_isGeometryDirty.begin(), m_isGeometryDirty.end(), false);
+    m_numDirtyGeometries = 0;
+    m_pendingDisplacement = 0;
+}
+
+void BottomLevelAccelerationStructure::SkipBuild()
+{
+    ClearGeometryChanges();
+    m_isDirty = false;
+}
+
 // The caller must add a UAV barrier before using the resource.
 void BottomLevelAccelerationStructure::Build(
     ID3D12GraphicsCommandList4* commandList, 
@@ -127,7 +165,21 @@ void BottomLevelAccelerationStructure::Build(
     ID3D12DescriptorHeap* descriptorHeap, 
     D3D12_GPU_VIRTUAL_ADDRESS baseGeometryTransformGPUAddress)
 {
-	ThrowIfFalse(m_prebuildInfo.ScratchDataSizeInBytes <= scratch->GetDesc().Width, L"Insufficient scratch buffer size provided!");
+    Build(commandList, scratch->GetGPUVirtualAddress(), scratch->GetDesc().Width, descriptorHeap, baseGeometryTransformGPUAddress);
+}
+
+// Builds using scratchSizeInBytes of scratch memory at scratchGPUAddress, which may be a range of a larger resource
+// shared with other builds. The caller must add a UAV barrier before using the resource or reusing the scratch range.
+void BottomLevelAccelerationStructure::Build(
+    ID3D12GraphicsCommandList4* commandList,
+    D3D12_GPU_VIRTUAL_ADDRESS scratchGPUAddress,
+    UINT64 scratchSizeInBytes,
+    ID3D12DescriptorHeap* descriptorHeap,
+    D3D12_GPU_VIRTUAL_ADDRESS baseGeometryTransformGPUAddress)
+{
+	ThrowIfFalse(ScratchSizeForNextBuild() <= scratchSizeInBytes, L"Insufficient scratch buffer size provided!");
+    ThrowIfFalse(!m_isCompacted, L"A compacted acceleration structure must be uncompacted before it is rebuilt.");
+    const bool performUpdate = WillUpdateOnBuild();
 	
     if (baseGeometryTransformGPUAddress > 0)
     {
@@ -145,7 +197,7 @@ void BottomLevelAccelerationStructure::Build(
         bottomLevelInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
         bottomLevelInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
         bottomLevelInputs.Flags = m_buildFlags;
-		if (m_isBuilt && m_allowUpdate && m_updateOnBuild)
+		if (performUpdate)
 		{
             bottomLevelInputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
             bottomLevelBuildDesc.SourceAccelerationStructureData = m_accelerationStructure->GetGPUVirtualAddress();
@@ -153,17 +205,72 @@ void BottomLevelAccelerationStructure::Build(
         bottomLevelInputs.NumDescs = static_cast<UINT>(m_cacheGeometryDescs[currentID].size());
         bottomLevelInputs.pGeometryDescs = m_cacheGeometryDescs[currentID].data();
 
-		bottomLevelBuildDesc.ScratchAccelerationStructureData = scratch->GetGPUVirtualAddress();
+		bottomLevelBuildDesc.ScratchAccelerationStructureData = scratchGPUAddress;
 		bottomLevelBuildDesc.DestAccelerationStructureData = m_accelerationStructure->GetGPUVirtualAddress();
 	}
 
 	commandList->SetDescriptorHeaps(1, &descriptorHeap);
     commandList->BuildRaytracingAccelerationStructure(&bottomLevelBuildDesc, 0, nullptr);
 
+    if (performUpdate)
+    {
+        m_displacementSinceRebuild += m_pendingDisplacement;
+        m_numUpdatesSinceRebuild++;
+    }
+    else
+    {
+        m_displacementSinceRebuild = 0;
+        m_numUpdatesSinceRebuild = 0;
+    }
+    ClearGeometryChanges();
+    m_isRebuildRequested = false;
+
 	m_isDirty = false;
     m_isBuilt = true;
 }
 
+// Restores the AS from data serialized by a previous run, in place of a build.
+// serializedData must stay alive until the command list has finished executing.
+// The caller must add a UAV barrier before using the resource.
+void BottomLevelAccelerationStructure::Deserialize(ID3D12GraphicsCommandList4* commandList, ID3D12Resource* serializedData)
+{
+    commandList->CopyRaytracingAccelerationStructure(
+        m_accelerationStructure->GetGPUVirtualAddress(),
+        serializedData->GetGPUVirtualAddress(),
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE);
+
+    ClearGeometryChanges();
+    m_displacementSinceRebuild = 0;
+    m_numUpdatesSinceRebuild = 0;
+    m_isRebuildRequested = false;
+
+    m_isDirty = false;
+    m_isBuilt = true;
+}
+
+ComPtr<ID3D12Resource> BottomLevelAccelerationStructure::Compact(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList, UINT64 compactedSizeInBytes)
+{
+    ComPtr<ID3D12Resource> sourceResource = m_accelerationStructure;
+    AllocateUAVBuffer(device, compactedSizeInBytes, &m_accelerationStructure, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, m_name.c_str());
+
+    commandList->CopyRaytracingAccelerationStructure(
+        m_accelerationStructure->GetGPUVirtualAddress(),
+        sourceResource->GetGPUVirtualAddress(),
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+    m_isCompacted = true;
+    return sourceResource;
+}
+
+ComPtr<ID3D12Resource> BottomLevelAccelerationStructure::Uncompact(ID3D12Device5* device)
+{
+    ComPtr<ID3D12Resource> compactedResource = m_accelerationStructure;
+    AllocateResource(device);
+
+    m_isCompacted = false;
+    return compactedResource;
+}
+
 void TopLevelAccelerationStructure::ComputePrebuildInfo(ID3D12Device5* device, UINT numBottomLevelASInstanceDescs)
 {
 	// Get the size requirements for the scratch and AS buffers.
@@ -228,9 +335,12 @@ void TopLevelAccelerationStructure::Build(ID3D12GraphicsCommandList4* commandLis
     m_isBuilt = true;
 }
 
+const UINT64 RaytracingAccelerationStructureManager::MaxScratchPoolSizeInBytes;
+
 RaytracingAccelerationStructureManager::RaytracingAccelerationStructureManager(ID3D12Device5* device, UINT numBottomLevelInstances, UINT frameCount)
 {
     m_bottomLevelASInstanceDescs.Create(device, numBottomLevelInstances, frameCount, L"Bottom-Level Acceleration Structure Instance descs.");
+    m_compactionQueries.resize(frameCount);
 }
 
 // Adds a bottom-level Acceleration Structure.
@@ -250,8 +360,10 @@ void RaytracingAccelerationStructureManager::AddBottomLevelAS(
 
     bottomLevelAS.Initialize(device, buildFlags, bottomLevelASGeometry, allowUpdate);
 
+    const UINT64 Alignment = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT;
     m_ASmemoryFootprint += bottomLevelAS.RequiredResultDataSizeInBytes();
     m_scratchResourceSize = max(bottomLevelAS.RequiredScratchSize(), m_scratchResourceSize);
+    m_totalBottomLevelScratchSize += (bottomLevelAS.RequiredScratchSize() + Alignment - 1) & ~(Alignment - 1);
 
     m_vBottomLevelAS[bottomLevelAS.GetName()] = bottomLevelAS;
 }
@@ -302,10 +414,178 @@ void RaytracingAccelerationStructureManager::InitializeTopLevelAS(
     m_ASmemoryFootprint += m_topLevelAS.RequiredResultDataSizeInBytes();
     m_scratchResourceSize = max(m_topLevelAS.RequiredScratchSize(), m_scratchResourceSize);
 
+    // Size the pool to build all bottom-level AS in one batch, within reason.
+    m_scratchResourceSize = max(m_scratchResourceSize, min(m_totalBottomLevelScratchSize, MaxScratchPoolSizeInBytes));
+
     AllocateUAVBuffer(device, m_scratchResourceSize, &m_accelerationStructureScratch, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, L"Acceleration structure scratch resource");
+
+    UINT numCompactableBottomLevelAS = 0;
+    for (auto& bottomLevelASpair : m_vBottomLevelAS)
+    {
+        if (bottomLevelASpair.second.AllowsCompaction())
+        {
+            numCompactableBottomLevelAS++;
+        }
+    }
+    if (numCompactableBottomLevelAS > 0)
+    {
+        const UINT64 postbuildInfoSize = numCompactableBottomLevelAS * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+        for (auto& query : m_compactionQueries)
+        {
+            AllocateUAVBuffer(device, postbuildInfoSize, &query.postbuildInfo, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, L"Bottom-level AS compacted size postbuild info");
+            AllocateReadBackBuffer(device, postbuildInfoSize, &query.postbuildInfoReadback, D3D12_RESOURCE_STATE_COPY_DEST, L"Bottom-level AS compacted size postbuild info readback");
+        }
+    }
+}
+
+// Points every instance of the bottom-level AS at oldAddress to newAddress.
+void RaytracingAccelerationStructureManager::RelocateBottomLevelAS(D3D12_GPU_VIRTUAL_ADDRESS oldAddress, D3D12_GPU_VIRTUAL_ADDRESS newAddress)
+{
+    for (UINT i = 0; i < m_numBottomLevelASInstances; i++)
+    {
+        auto& instanceDesc = m_bottomLevelASInstanceDescs[i];
+        if (instanceDesc.AccelerationStructure == oldAddress)
+        {
+            instanceDesc.AccelerationStructure = newAddress;
+        }
+    }
+}
+
+// Compacts the bottom-level AS whose compacted sizes were queried the last time this frameIndex was built.
+// BLAS that are about to be rebuilt are skipped, they're queued again once the rebuild is done.
+void RaytracingAccelerationStructureManager::CompleteCompaction(
+    ID3D12Device5* device,
+    ID3D12GraphicsCommandList4* commandList,
+    UINT frameIndex,
+    const set<BottomLevelAccelerationStructure*>& bottomLevelASToBuild)
+{
+    auto& query = m_compactionQueries[frameIndex];
+    if (query.bottomLevelAS.empty())
+    {
+        return;
+    }
+
+    bool compactedAny = false;
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC* pPostbuildInfo;
+    const UINT64 postbuildInfoSize = query.bottomLevelAS.size() * sizeof(*pPostbuildInfo);
+    ThrowIfFailed(query.postbuildInfoReadback->Map(0, &CD3DX12_RANGE(0, static_cast<SIZE_T>(postbuildInfoSize)), reinterpret_cast<void**>(&pPostbuildInfo)));
+    for (size_t i = 0; i < query.bottomLevelAS.size(); i++)
+    {
+        auto bottomLevelAS = query.bottomLevelAS[i];
+        m_queuedCompactions.erase(bottomLevelAS);
+
+        const UINT64 compactedSize = pPostbuildInfo[i].CompactedSizeInBytes;
+        if (bottomLevelAS->IsDirty() || bottomLevelASToBuild.count(bottomLevelAS) || compactedSize == 0 || compactedSize >= bottomLevelAS->ResourceSize())
+        {
+            continue;
+        }
+
+        const UINT64 originalSize = bottomLevelAS->ResourceSize();
+        const D3D12_GPU_VIRTUAL_ADDRESS originalAddress = bottomLevelAS->GetResource()->GetGPUVirtualAddress();
+        query.retiredResources.push_back(bottomLevelAS->Compact(device, commandList, compactedSize));
+        RelocateBottomLevelAS(originalAddress, bottomLevelAS->GetResource()->GetGPUVirtualAddress());
+
+        m_ASmemoryFootprint -= originalSize - compactedSize;
+        compactedAny = true;
+    }
+    query.postbuildInfoReadback->Unmap(0, &CD3DX12_RANGE(0, 0));
+    query.bottomLevelAS.clear();
+
+    if (compactedAny)
+    {
+        commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(nullptr));
+    }
 }
 
-// Builds all bottom-level and top-level Acceleration Structures.
+// Queries the compacted size of every built, compactable bottom-level AS that isn't compacted or queued yet.
+// Must be recorded after the builds of those BLAS have completed.
+void RaytracingAccelerationStructureManager::QueueCompaction(ID3D12GraphicsCommandList4* commandList, UINT frameIndex)
+{
+    auto& query = m_compactionQueries[frameIndex];
+    vector<D3D12_GPU_VIRTUAL_ADDRESS> sourceAddresses;
+    for (auto& bottomLevelASpair : m_vBottomLevelAS)
+    {
+        auto& bottomLevelAS = bottomLevelASpair.second;
+        if (bottomLevelAS.AllowsCompaction() && bottomLevelAS.IsBuilt() && !bottomLevelAS.IsDirty() &&
+            !bottomLevelAS.IsCompacted() && !m_queuedCompactions.count(&bottomLevelAS))
+        {
+            query.bottomLevelAS.push_back(&bottomLevelAS);
+            m_queuedCompactions.insert(&bottomLevelAS);
+            sourceAddresses.push_back(bottomLevelAS.GetResource()->GetGPUVirtualAddress());
+        }
+    }
+
+    if (sourceAddresses.empty())
+    {
+        return;
+    }
+
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfoDesc = {};
+    postbuildInfoDesc.DestBuffer = query.postbuildInfo->GetGPUVirtualAddress();
+    postbuildInfoDesc.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+    commandList->EmitRaytracingAccelerationStructurePostbuildInfo(&postbuildInfoDesc, static_cast<UINT>(sourceAddresses.size()), sourceAddresses.data());
+
+    const UINT64 postbuildInfoSize = sourceAddresses.size() * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+    commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(query.postbuildInfo.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+    commandList->CopyBufferRegion(query.postbuildInfoReadback.Get(), 0, query.postbuildInfo.Get(), 0, postbuildInfoSize);
+    commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(query.postbuildInfo.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+}
+
+// Decides how each dirty bottom-level AS that is updated on build gets built this frame. Changes that didn't
+// move any geometry are skipped, BLAS whose refits are estimated to have degraded them too much are rebuilt,
+// and BLAS that have been updated for long enough are rebuilt periodically, a few per frame.
+void RaytracingAccelerationStructureManager::ApplyRefitPolicy()
+{
+    vector<BottomLevelAccelerationStructure*> dueForRebuild;
+    for (auto& bottomLevelASpair : m_vBottomLevelAS)
+    {
+        auto& bottomLevelAS = bottomLevelASpair.second;
+        if (!bottomLevelAS.IsDirty() || !bottomLevelAS.WillUpdateOnBuild())
+        {
+            continue;
+        }
+
+        if (bottomLevelAS.HasOnlyUnmovedGeometryChanges())
+        {
+            bottomLevelAS.SkipBuild();
+            m_lastUpdateStats.numSkipped++;
+        }
+        else if (bottomLevelAS.EstimatedRefitCostIncrease() > m_refitPolicy.maxEstimatedCostIncrease)
+        {
+            bottomLevelAS.RequestRebuild();
+            m_lastUpdateStats.numCostRebuilds++;
+        }
+        else if (bottomLevelAS.NumUpdatesSinceRebuild() >= m_refitPolicy.maxUpdatesBetweenRebuilds)
+        {
+            dueForRebuild.push_back(&bottomLevelAS);
+        }
+    }
+
+    // The ones updated the longest go first. Once spread out, BLAS stay staggered.
+    sort(dueForRebuild.begin(), dueForRebuild.end(), [](auto* a, auto* b)
+    {
+        return a->NumUpdatesSinceRebuild() > b->NumUpdatesSinceRebuild();
+    });
+    UINT numPeriodicRebuilds = min(static_cast<UINT>(dueForRebuild.size()), m_refitPolicy.maxPeriodicRebuildsPerFrame);
+    for (UINT i = 0; i < numPeriodicRebuilds; i++)
+    {
+        dueForRebuild[i]->RequestRebuild();
+    }
+    m_lastUpdateStats.numPeriodicRebuilds = numPeriodicRebuilds;
+}
+
+void RaytracingAccelerationStructureManager::UpdateProfilingCounters()
+{
+    EngineProfiling::SetCounter(L"BLAS updates", m_lastUpdateStats.numUpdates);
+    EngineProfiling::SetCounter(L"BLAS rebuilds", m_lastUpdateStats.numRebuilds);
+    EngineProfiling::SetCounter(L"BLAS rebuilds - refit cost", m_lastUpdateStats.numCostRebuilds);
+    EngineProfiling::SetCounter(L"BLAS rebuilds - periodic", m_lastUpdateStats.numPeriodicRebuilds);
+    EngineProfiling::SetCounter(L"BLAS skipped", m_lastUpdateStats.numSkipped);
+    EngineProfiling::SetCounter(L"BLAS deferred", m_lastUpdateStats.numDeferred);
+}
+
+// Builds all dirty bottom-level AS, within the build budget, and the top-level AS.
+// Requires: the GPU to have finished the frame that last used frameIndex, as DeviceResources guarantees.
 void RaytracingAccelerationStructureManager::Build(
     ID3D12GraphicsCommandList4* commandList, 
     ID3D12DescriptorHeap* descriptorHeap,
@@ -314,27 +594,99 @@ void RaytracingAccelerationStructureManager::Build(
 {
     ScopedTimer _prof(L"Acceleration Structure build", commandList);
 
-    m_bottomLevelASInstanceDescs.CopyStagingToGpu(frameIndex);
+    ComPtr<ID3D12Device5> device;
+    ThrowIfFailed(commandList->GetDevice(IID_PPV_ARGS(&device)));
+
+    // Resources replaced the last time this frameIndex was built are no longer in use.
+    m_compactionQueries[frameIndex].retiredResources.clear();
 
-    // Build all bottom-level AS.
+    m_lastUpdateStats = BottomLevelASUpdateStats();
+    if (!bForceBuild)
     {
-        ScopedTimer _prof(L"Bottom Level AS", commandList);
+        ApplyRefitPolicy();
+    }
+
+    // Plan the bottom-level AS builds.
+    vector<BottomLevelAccelerationStructure*> bottomLevelASToBuild;
+    {
+        vector<BottomLevelASBuildRequest> requests;
         for (auto& bottomLevelASpair : m_vBottomLevelAS)
         {
             auto& bottomLevelAS = bottomLevelASpair.second;
             if (bForceBuild || bottomLevelAS.IsDirty())
             {
-                ScopedTimer _prof(bottomLevelAS.GetName(), commandList);
+                BottomLevelASBuildRequest request;
+                request.id = static_cast<UINT>(bottomLevelASToBuild.size());
+                request.scratchSizeInBytes = bottomLevelAS.ScratchSizeForNextBuild();
+                request.resultSizeInBytes = bottomLevelAS.RequiredResultDataSizeInBytes();
+                request.numTriangles = bottomLevelAS.GetNumTriangles();
+                request.numFramesDeferred = m_numFramesDeferred[bottomLevelAS.GetName()];
+                request.isRequired = !bottomLevelAS.IsBuilt();
+                requests.push_back(request);
+                bottomLevelASToBuild.push_back(&bottomLevelAS);
+            }
+        }
+        m_lastBuildPlan = PlanBottomLevelASBuilds(requests, m_scratchResourceSize, m_buildBudget);
+        m_lastUpdateStats.numDeferred = static_cast<UINT>(m_lastBuildPlan.deferredIds.size());
 
-                D3D12_GPU_VIRTUAL_ADDRESS baseGeometryTransformGpuAddress = 0;
-                bottomLevelAS.Build(commandList, m_accelerationStructureScratch.Get(), descriptorHeap, baseGeometryTransformGpuAddress);
+        for (auto id : m_lastBuildPlan.deferredIds)
+        {
+            m_numFramesDeferred[bottomLevelASToBuild[id]->GetName()]++;
+        }
+    }
 
-                // Since a single scratch resource is reused, put a barrier in-between each call.
-                // PEFORMANCE tip: use separate scratch memory per BLAS build to allow a GPU driver to overlap build calls.
-                commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(bottomLevelAS.GetResource()));
-            }
+    set<BottomLevelAccelerationStructure*> plannedBottomLevelAS;
+    for (auto& build : m_lastBuildPlan.builds)
+    {
+        auto bottomLevelAS = bottomLevelASToBuild[build.id];
+        plannedBottomLevelAS.insert(bottomLevelAS);
+        m_numFramesDeferred[bottomLevelAS->GetName()] = 0;
+
+        // A compacted BLAS is too small to be rebuilt in place.
+        if (bottomLevelAS->IsCompacted())
+        {
+            const UINT64 compactedSize = bottomLevelAS->ResourceSize();
+            const D3D12_GPU_VIRTUAL_ADDRESS compactedAddress = bottomLevelAS->GetResource()->GetGPUVirtualAddress();
+            m_compactionQueries[frameIndex].retiredResources.push_back(bottomLevelAS->Uncompact(device.Get()));
+            RelocateBottomLevelAS(compactedAddress, bottomLevelAS->GetResource()->GetGPUVirtualAddress());
+            m_ASmemoryFootprint += bottomLevelAS->ResourceSize() - compactedSize;
         }
     }
+    CompleteCompaction(device.Get(), commandList, frameIndex, plannedBottomLevelAS);
+
+    // Instance descs have to be final by now, compaction moves BLAS.
+    m_bottomLevelASInstanceDescs.CopyStagingToGpu(frameIndex);
+
+    // Build bottom-level AS. Builds in a batch use disjoint ranges of the scratch pool,
+    // so a driver can overlap them and they only need a barrier at the end of the batch.
+    {
+        ScopedTimer _prof(L"Bottom Level AS", commandList);
+        const D3D12_GPU_VIRTUAL_ADDRESS scratchGPUAddress = m_accelerationStructureScratch->GetGPUVirtualAddress();
+        RecordBottomLevelASBuildPlan(m_lastBuildPlan,
+            [&](const BottomLevelASBuildPlan::Build& build)
+            {
+                auto bottomLevelAS = bottomLevelASToBuild[build.id];
+                ScopedTimer _prof(bottomLevelAS->GetName(), commandList);
+
+                if (bottomLevelAS->WillUpdateOnBuild())
+                {
+                    m_lastUpdateStats.numUpdates++;
+                }
+                else
+                {
+                    m_lastUpdateStats.numRebuilds++;
+                }
+                D3D12_GPU_VIRTUAL_ADDRESS baseGeometryTransformGpuAddress = 0;
+                bottomLevelAS->Build(commandList, scratchGPUAddress + build.scratchOffset, bottomLevelAS->ScratchSizeForNextBuild(), descriptorHeap, baseGeometryTransformGpuAddress);
+            },
+            [&]()
+            {
+                commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(nullptr));
+            });
+    }
+
+    QueueCompaction(commandList, frameIndex);
+    UpdateProfilingCounters();
     
     // Build the top-level AS.
     {
@@ -348,6 +700,132 @@ void RaytracingAccelerationStructureManager::Build(
     }
 }
 
+// Builds all cacheable bottom-level AS ahead of the first frame. BLAS found in the cache are
+// deserialized, the rest are built and then serialized into the cache for the next run.
+// Returns the number of cache hits. Flushes the GPU and leaves the command list closed.
+// Requires: InitializeTopLevelAS() to have allocated the scratch resource.
+UINT RaytracingAccelerationStructureManager::BuildBottomLevelASWithCache(
+    DX::DeviceResources* deviceResources,
+    ID3D12DescriptorHeap* descriptorHeap,
+    AccelerationStructureCache& cache)
+{
+    auto device = deviceResources->GetD3DDevice();
+    auto commandList = deviceResources->GetCommandList();
+
+    deviceResources->WaitForGpu();
+    deviceResources->ResetCommandAllocatorAndCommandlist();
+
+    UINT numCacheHits = 0;
+    vector<ComPtr<ID3D12Resource>> cachedData;
+    vector<BottomLevelAccelerationStructure*> cacheMisses;
+    vector<UINT64> cacheMissKeys;
+    for (auto& bottomLevelASpair : m_vBottomLevelAS)
+    {
+        auto& bottomLevelAS = bottomLevelASpair.second;
+        if (!bottomLevelAS.IsCacheable())
+        {
+            continue;
+        }
+
+        UINT64 key = AccelerationStructureCache::GetKey(bottomLevelAS.GetGeometryHash(), bottomLevelAS.BuildFlags());
+        ComPtr<ID3D12Resource> serializedData;
+        if (cache.Load(device, key, bottomLevelAS.ResourceSize(), &serializedData))
+        {
+            bottomLevelAS.Deserialize(commandList, serializedData.Get());
+            cachedData.push_back(serializedData);
+            numCacheHits++;
+        }
+        else
+        {
+            bottomLevelAS.Build(commandList, m_accelerationStructureScratch.Get(), descriptorHeap);
+            cacheMisses.push_back(&bottomLevelAS);
+            cacheMissKeys.push_back(key);
+        }
+
+        // Since a single scratch resource is reused, put a barrier in-between each call.
+        commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(bottomLevelAS.GetResource()));
+    }
+
+    if (cacheMisses.empty())
+    {
+        deviceResources->ExecuteCommandList();
+        deviceResources->WaitForGpu();
+        return numCacheHits;
+    }
+
+    // Query the serialized sizes of the freshly built BLAS.
+    const UINT numCacheMisses = static_cast<UINT>(cacheMisses.size());
+    const UINT64 postbuildInfoSize = numCacheMisses * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION_DESC);
+    ComPtr<ID3D12Resource> postbuildInfo;
+    ComPtr<ID3D12Resource> postbuildInfoReadback;
+    AllocateUAVBuffer(device, postbuildInfoSize, &postbuildInfo, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, L"Bottom-level AS serialization postbuild info");
+    AllocateReadBackBuffer(device, postbuildInfoSize, &postbuildInfoReadback, D3D12_RESOURCE_STATE_COPY_DEST, L"Bottom-level AS serialization postbuild info readback");
+    {
+        vector<D3D12_GPU_VIRTUAL_ADDRESS> sourceAddresses;
+        for (auto bottomLevelAS : cacheMisses)
+        {
+            sourceAddresses.push_back(bottomLevelAS->GetResource()->GetGPUVirtualAddress());
+        }
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfoDesc = {};
+        postbuildInfoDesc.DestBuffer = postbuildInfo->GetGPUVirtualAddress();
+        postbuildInfoDesc.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION;
+        commandList->EmitRaytracingAccelerationStructurePostbuildInfo(&postbuildInfoDesc, numCacheMisses, sourceAddresses.data());
+
+        commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(postbuildInfo.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+        commandList->CopyResource(postbuildInfoReadback.Get(), postbuildInfo.Get());
+    }
+    deviceResources->ExecuteCommandList();
+    deviceResources->WaitForGpu();
+
+    // Serialize all of them into a single buffer and read it back.
+    vector<UINT64> serializedSizes(numCacheMisses);
+    vector<UINT64> serializedOffsets(numCacheMisses);
+    UINT64 totalSerializedSize = 0;
+    {
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION_DESC* pPostbuildInfo;
+        ThrowIfFailed(postbuildInfoReadback->Map(0, nullptr, reinterpret_cast<void**>(&pPostbuildInfo)));
+        for (UINT i = 0; i < numCacheMisses; i++)
+        {
+            const UINT64 Alignment = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT;
+            serializedSizes[i] = pPostbuildInfo[i].SerializedSizeInBytes;
+            serializedOffsets[i] = totalSerializedSize;
+            totalSerializedSize += (serializedSizes[i] + Alignment - 1) & ~(Alignment - 1);
+        }
+        postbuildInfoReadback->Unmap(0, &CD3DX12_RANGE(0, 0));
+    }
+
+    ComPtr<ID3D12Resource> serializedData;
+    ComPtr<ID3D12Resource> serializedDataReadback;
+    AllocateUAVBuffer(device, totalSerializedSize, &serializedData, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, L"Serialized bottom-level AS");
+    AllocateReadBackBuffer(device, totalSerializedSize, &serializedDataReadback, D3D12_RESOURCE_STATE_COPY_DEST, L"Serialized bottom-level AS readback");
+
+    deviceResources->ResetCommandAllocatorAndCommandlist();
+    for (UINT i = 0; i < numCacheMisses; i++)
+    {
+        commandList->CopyRaytracingAccelerationStructure(
+            serializedData->GetGPUVirtualAddress() + serializedOffsets[i],
+            cacheMisses[i]->GetResource()->GetGPUVirtualAddress(),
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE);
+    }
+    commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(serializedData.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+    commandList->CopyResource(serializedDataReadback.Get(), serializedData.Get());
+    deviceResources->ExecuteCommandList();
+    deviceResources->WaitForGpu();
+
+    {
+        BYTE* pSerializedData;
+        ThrowIfFailed(serializedDataReadback->Map(0, nullptr, reinterpret_cast<void**>(&pSerializedData)));
+        for (UINT i = 0; i < numCacheMisses; i++)
+        {
+            cache.Save(cacheMissKeys[i], pSerializedData + serializedOffsets[i], serializedSizes[i]);
+        }
+        serializedDataReadback->Unmap(0, &CD3DX12_RANGE(0, 0));
+    }
+
+    return numCacheHits;
+}
+
 void BottomLevelAccelerationStructureInstanceDesc::SetTransform(const XMMATRIX& transform)
 {
     XMStoreFloat3x4(reinterpret_cast<XMFLOAT3X4*>(Transform), transform);
@@ -13,6 +13,9 @@
 
 #include "RayTracingHlslCompat.h"
 #include "RaytracingSceneDefines.h"
+#include "BottomLevelASBuildScheduler.h"
+
+class AccelerationStructureCache;
 
 struct AccelerationStructureBuffers
 {
@@ -35,9 +38,15 @@ public:
     ID3D12Resource* GetResource();
 	const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO& PrebuildInfo() { return m_prebuildInfo; }
     const std::wstring& GetName() { return m_name; }
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS BuildFlags() { return m_buildFlags; }
 
     void SetDirty(bool isDirty) { m_isDirty = isDirty; }
     bool IsDirty() { return m_isDirty; }
+    bool IsBuilt() { return m_isBuilt; }
+    bool WillUpdateOnBuild() { return m_isBuilt && m_allowUpdate && m_updateOnBuild && !m_isRebuildRequested; }
+    // Makes the next build a full rebuild even if the AS would otherwise be updated.
+    void RequestRebuild() { m_isRebuildRequested = true; }
+    UINT64 ScratchSizeForNextBuild() { return WillUpdateOnBuild() ? m_prebuildInfo.UpdateScratchDataSizeInBytes : m_prebuildInfo.ScratchDataSizeInBytes; }
     UINT64 ResourceSize() { return GetResource()->GetDesc().Width; }
 
 protected:
@@ -50,6 +59,7 @@ protected:
     bool m_isDirty = true; // whether the AS has been modified and needs to be rebuilt.
     bool m_updateOnBuild = false;
     bool m_allowUpdate = false;
+    bool m_isRebuildRequested = false;
 
 	void AllocateResource(ID3D12Device5* device);
 };
@@ -66,6 +76,7 @@ public:
     UINT                            m_ibStrideInBytes = 0;
     DXGI_FORMAT                     m_vertexFormat = DXGI_FORMAT_UNKNOWN;
     UINT                            m_vbStrideInBytes = 0;
+    UINT64                          m_geometryHash = 0;     // Hash of the source geometry, 0 if the BLAS can't be cached.
 
     BottomLevelAccelerationStructureGeometry() {}
     BottomLevelAccelerationStructureGeometry(const wchar_t* name) : m_name(name) {}
@@ -83,6 +94,9 @@ public:
 
     void Initialize(ID3D12Device5* device, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags, BottomLevelAccelerationStructureGeometry& bottomLevelASGeometry, bool allowUpdate = false, bool bUpdateOnBuild = false);
     void Build(ID3D12GraphicsCommandList4* commandList, ID3D12Resource* scratch, ID3D12DescriptorHeap* descriptorHeap, D3D12_GPU_VIRTUAL_ADDRESS baseGeometryTransformGPUAddress = 0);
+    void Build(ID3D12GraphicsCommandList4* commandList, D3D12_GPU_VIRTUAL_ADDRESS scratchGPUAddress, UINT64 scratchSizeInBytes, ID3D12DescriptorHeap* descriptorHeap, D3D12_GPU_VIRTUAL_ADDRESS baseGeometryTransformGPUAddress = 0);
+
+    void Deserialize(ID3D12GraphicsCommandList4* commandList, ID3D12Resource* serializedData);
 
     void UpdateGeometryDescsTransform(D3D12_GPU_VIRTUAL_ADDRESS baseGeometryTransformGPUAddress);
     
@@ -92,12 +106,55 @@ public:
 	const XMMATRIX& GetTransform() { return m_transform; }
     std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>& GetGeometryDescs() { return m_geometryDescs; }
 
+    UINT64 GetGeometryHash() { return m_geometryHash; }
+    // Updateable BLAS are rebuilt every frame, so only static ones are worth caching.
+    bool IsCacheable() { return m_geometryHash != 0 && !m_allowUpdate; }
+    UINT64 GetNumTriangles() { return m_numTriangles; }
+
+    // Likewise only static BLAS built with ALLOW_COMPACTION are compacted.
+    bool AllowsCompaction() { return !m_allowUpdate && (m_buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION); }
+    bool IsCompacted() { return m_isCompacted; }
+    // Per-geometry change tracking. relativeDisplacement is how far the geometry's vertices moved since it was
+    // last marked dirty, relative to the extent of the BLAS. Pass 0 if the geometry was regenerated unchanged.
+    void SetGeometryDirty(UINT geometryIndex, float relativeDisplacement = 1.f);
+    bool IsGeometryDirty(UINT geometryIndex) { return m_isGeometryDirty[geometryIndex]; }
+    // Whether all pending changes were marked through SetGeometryDirty() and none of them moved any vertices.
+    bool HasOnlyUnmovedGeometryChanges() { return m_numDirtyGeometries > 0 && m_pendingDisplacement == 0; }
+    // Drops the pending changes without building, for when they leave the AS valid as it is.
+    void SkipBuild();
+    // Estimated traversal cost increase over a fresh build once the pending changes are refitted.
+    // Refitted node bounds grow by up to the accumulated displacement on each side, and their surface area with the square of that.
+    float EstimatedRefitCostIncrease()
+    {
+        float displacement = m_displacementSinceRebuild + m_pendingDisplacement;
+        return (1 + 2 * displacement) * (1 + 2 * displacement) - 1;
+    }
+    UINT NumUpdatesSinceRebuild() { return m_numUpdatesSinceRebuild; }
+
+    // Copies the AS into a new resource of compactedSizeInBytes and switches to it. Returns the previous
+    // resource, which must stay alive until the command list has finished executing.
+    ComPtr<ID3D12Resource> Compact(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList, UINT64 compactedSizeInBytes);
+    // Switches back to a resource that can hold a full build. Returns the compacted resource,
+    // with the same lifetime requirement as Compact().
+    ComPtr<ID3D12Resource> Uncompact(ID3D12Device5* device);
+
 private:
     std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> m_geometryDescs;
     UINT currentID = 0; 
     std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> m_cacheGeometryDescs[3];
     DirectX::XMMATRIX m_transform;
     UINT m_instanceContributionToHitGroupIndex = 0;
+    UINT64 m_geometryHash = 0;
+    UINT64 m_numTriangles = 0;
+    bool m_isCompacted = false;
+
+    std::vector<bool> m_isGeometryDirty;
+    UINT m_numDirtyGeometries = 0;
+    float m_pendingDisplacement = 0;        // Largest displacement of any geometry since the last build.
+    float m_displacementSinceRebuild = 0;   // Accumulated over the updates since the last rebuild.
+    UINT m_numUpdatesSinceRebuild = 0;
+
+    void ClearGeometryChanges();
 
 	void BuildGeometryDescs(BottomLevelAccelerationStructureGeometry& bottomLevelASGeometry);
 	void ComputePrebuildInfo(ID3D12Device5* device);
@@ -125,6 +182,25 @@ struct BottomLevelAccelerationStructureInstanceDesc : public D3D12_RAYTRACING_IN
 static_assert(sizeof(BottomLevelAccelerationStructureInstanceDesc) == sizeof(D3D12_RAYTRACING_INSTANCE_DESC), L"This is a wrapper used in place of the desc. It has to have the same size");
 
 
+// Chooses between updating and rebuilding the dirty bottom-level AS that allow updates.
+struct BottomLevelASRefitPolicy
+{
+    float maxEstimatedCostIncrease = 0.25f;     // Rebuild once refits are estimated to have made traversal this much more expensive.
+    UINT  maxUpdatesBetweenRebuilds = 60;       // Rebuild periodically, since the estimate relies on the caller's displacements.
+    UINT  maxPeriodicRebuildsPerFrame = 1;      // BLAS due at the same time are spread over several frames.
+};
+
+// What the last Build() call did with the bottom-level AS.
+struct BottomLevelASUpdateStats
+{
+    UINT numUpdates = 0;
+    UINT numRebuilds = 0;
+    UINT numCostRebuilds = 0;       // Rebuilds requested by the refit policy. They count towards numRebuilds unless deferred.
+    UINT numPeriodicRebuilds = 0;   // Likewise.
+    UINT numSkipped = 0;
+    UINT numDeferred = 0;
+};
+
 class RaytracingAccelerationStructureManager
 {
 public:
@@ -135,6 +211,7 @@ public:
     UINT AddBottomLevelASInstance(const std::wstring& bottomLevelASname, UINT instanceContributionToHitGroupIndex = UINT_MAX, XMMATRIX transform = XMMatrixIdentity(), BYTE InstanceMask = 1);
     void InitializeTopLevelAS(ID3D12Device5* device, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags, bool allowUpdate = false, bool performUpdateOnBuild = false, const wchar_t* resourceName = nullptr);
     void Build(ID3D12GraphicsCommandList4* commandList, ID3D12DescriptorHeap* descriptorHeap, UINT frameIndex, bool bForceBuild = false);
+    UINT BuildBottomLevelASWithCache(DX::DeviceResources* deviceResources, ID3D12DescriptorHeap* descriptorHeap, AccelerationStructureCache& cache);
     BottomLevelAccelerationStructureInstanceDesc& GetBottomLevelASInstance(UINT bottomLevelASinstanceIndex) { return m_bottomLevelASInstanceDescs[bottomLevelASinstanceIndex]; }
     const StructuredBuffer<BottomLevelAccelerationStructureInstanceDesc>& GetBottomLevelASInstancesBuffer() { return m_bottomLevelASInstanceDescs; }
 
@@ -144,12 +221,47 @@ public:
     UINT GetNumberOfBottomLevelASInstances() { return static_cast<UINT>(m_bottomLevelASInstanceDescs.NumElements()); }
     UINT GetMaxInstanceContributionToHitGroupIndex();
 
+    void SetBuildBudget(const BottomLevelASBuildBudget& budget) { m_buildBudget = budget; }
+    // The bottom-level AS builds recorded by the last Build() call.
+    const BottomLevelASBuildPlan& GetLastBuildPlan() { return m_lastBuildPlan; }
+    void SetRefitPolicy(const BottomLevelASRefitPolicy& policy) { m_refitPolicy = policy; }
+    const BottomLevelASUpdateStats& GetLastUpdateStats() { return m_lastUpdateStats; }
+
 private:
+    // Bottom-level AS builds share a scratch pool of up to this size, so that a batch of builds can run without barriers in-between.
+    static const UINT64 MaxScratchPoolSizeInBytes = 64 * 1024 * 1024;
+
+    // Compacted sizes are read back when the same frameIndex comes around again,
+    // by which time the GPU has finished the frame that wrote them.
+    struct CompactionQuery
+    {
+        ComPtr<ID3D12Resource> postbuildInfo;
+        ComPtr<ID3D12Resource> postbuildInfoReadback;
+        std::vector<BottomLevelAccelerationStructure*> bottomLevelAS;
+        std::vector<ComPtr<ID3D12Resource>> retiredResources;   // Replaced AS resources still referenced by in-flight frames.
+    };
+
+    void CompleteCompaction(ID3D12Device5* device, ID3D12GraphicsCommandList4* commandList, UINT frameIndex, const std::set<BottomLevelAccelerationStructure*>& bottomLevelASToBuild);
+    void QueueCompaction(ID3D12GraphicsCommandList4* commandList, UINT frameIndex);
+    void RelocateBottomLevelAS(D3D12_GPU_VIRTUAL_ADDRESS oldAddress, D3D12_GPU_VIRTUAL_ADDRESS newAddress);
+    void ApplyRefitPolicy();
+    void UpdateProfilingCounters();
+
     TopLevelAccelerationStructure m_topLevelAS;
     std::map<std::wstring, BottomLevelAccelerationStructure> m_vBottomLevelAS;
     StructuredBuffer<BottomLevelAccelerationStructureInstanceDesc> m_bottomLevelASInstanceDescs;
     UINT m_numBottomLevelASInstances = 0;
     ComPtr<ID3D12Resource>	m_accelerationStructureScratch;
     UINT64 m_scratchResourceSize = 0;
+    UINT64 m_totalBottomLevelScratchSize = 0;
     UINT64 m_ASmemoryFootprint = 0;
+
+    BottomLevelASBuildBudget m_buildBudget;
+    BottomLevelASBuildPlan m_lastBuildPlan;
+    std::map<std::wstring, UINT> m_numFramesDeferred;
+    BottomLevelASRefitPolicy m_refitPolicy;
+    BottomLevelASUpdateStats m_lastUpdateStats;
+
+    std::vector<CompactionQuery> m_compactionQueries;
+    std::set<BottomLevelAccelerationStructure*> m_queuedCompactions;
 };
\ No newline at end of file
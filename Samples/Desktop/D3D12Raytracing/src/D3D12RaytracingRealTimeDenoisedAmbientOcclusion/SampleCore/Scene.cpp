@@ -18,6 +18,8 @@
 #include "Scene.h"
 #include "RaytracingSceneDefines.h"
 #include "D3D12RaytracingRealTimeDenoisedAmbientOcclusion.h"
+#include "AccelerationStructureCache.h"
+#include <chrono>
 
 using namespace std;
 using namespace DX;
@@ -49,6 +51,12 @@ namespace Scene_Args
     NumVar CameraRotationDuration(L"Scene/Camera rotation time", 48.f, 1.f, 120.f, 1.f);
     BoolVar AnimateGrass(L"Scene/Animate grass", true);
     BoolVar AnimateScene(L"Scene/Animate scene", true);
+    BoolVar UsePBRTSceneCache(L"Scene/Use PBRT scene cache", true);
+    BoolVar UseAccelerationStructureCache(L"Scene/Use acceleration structure cache", true);
+
+    // 0 leaves the bottom-level AS builds of a frame unlimited.
+    IntVar BLASBuildBudgetKTriangles(L"Scene/AS build budget/Max triangles per frame (K)", 0, 0, 16384, 64);
+    IntVar BLASBuildBudgetMB(L"Scene/AS build budget/Max BLAS MB per frame", 0, 0, 1024, 4);
 }
 
 Scene::Scene()
@@ -258,10 +266,24 @@ void Scene::LoadPBRTScene()
     resourceUpload.Begin();
 
     bool isVertexAnimated = false;
+    double totalParseTimeMs = 0;
     for (auto& pbrtSceneDefinition : pbrtSceneDefinitions)
     {
         SceneParser::Scene pbrtScene;
-        PBRTParser::PBRTParser().Parse(pbrtSceneDefinition.path, pbrtScene);
+        {
+            auto startTime = chrono::high_resolution_clock::now();
+
+            PBRTParser::PBRTParser parser;
+            parser.EnableSceneCache(Scene_Args::UsePBRTSceneCache);
+            parser.Parse(pbrtSceneDefinition.path, pbrtScene);
+
+            double parseTimeMs = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - startTime).count();
+            totalParseTimeMs += parseTimeMs;
+
+            wchar_t message[256];
+            swprintf_s(message, L"PBRT scene %s: %.1f ms (%s)\n", pbrtSceneDefinition.name.c_str(), parseTimeMs, parser.LoadedFromCache() ? L"cache" : L"parsed");
+            OutputDebugStringW(message);
+        }
 
         auto& bottomLevelASGeometry = m_bottomLevelASGeometries[pbrtSceneDefinition.name];
         bottomLevelASGeometry.SetName(pbrtSceneDefinition.name);
@@ -383,9 +405,19 @@ void Scene::LoadPBRTScene()
 
             bottomLevelASGeometry.m_geometryInstances.push_back(GeometryInstance(geometry, materialID, diffuseTextureHandle, normalTextureHandle, geometryFlags, isVertexAnimated));
             numTriangles += desc.ib.count / 3;
+
+            // Identifies the BLAS in the acceleration structure cache.
+            auto& geometryHash = bottomLevelASGeometry.m_geometryHash;
+            geometryHash = SceneParser::HashBytes(vertexBuffer.data(), vertexBuffer.size() * sizeof(vertexBuffer[0]), geometryHash);
+            geometryHash = SceneParser::HashBytes(indexBuffer.data(), indexBuffer.size() * sizeof(indexBuffer[0]), geometryHash);
+            geometryHash = SceneParser::HashBytes(&geometryFlags, sizeof(geometryFlags), geometryHash);
         }
     }
 
+    wchar_t message[256];
+    swprintf_s(message, L"PBRT scenes loaded in %.1f ms\n", totalParseTimeMs);
+    OutputDebugStringW(message);
+
     // Upload the resources to the GPU.
     auto finish = resourceUpload.End(commandQueue);
 
@@ -623,7 +655,13 @@ void Scene::InitializeAllBottomLevelAccelerationStructures()
         {
             updateOnBuild = true;
         }
-        m_accelerationStructure->AddBottomLevelAS(device, buildFlags, bottomLevelASGeometry, updateOnBuild, updateOnBuild);
+        // Static BLAS are compacted once built.
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS bottomLevelBuildFlags = buildFlags;
+        if (!updateOnBuild)
+        {
+            bottomLevelBuildFlags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION;
+        }
+        m_accelerationStructure->AddBottomLevelAS(device, bottomLevelBuildFlags, bottomLevelASGeometry, updateOnBuild, updateOnBuild);
     }
 }
 
@@ -712,6 +750,20 @@ void Scene::InitializeAccelerationStructures()
     bool allowUpdate = false;
     bool performUpdateOnBuild = false;
     m_accelerationStructure->InitializeTopLevelAS(device, buildFlags, allowUpdate, performUpdateOnBuild, L"Top-Level Acceleration Structure");
+
+    // Restore static BLAS from the cache so that the first frame only has to build the rest.
+    if (Scene_Args::UseAccelerationStructureCache)
+    {
+        auto startTime = chrono::high_resolution_clock::now();
+
+        AccelerationStructureCache cache("Assets\\BLASCache");
+        UINT numCacheHits = m_accelerationStructure->BuildBottomLevelASWithCache(m_deviceResources.get(), m_cbvSrvUavHeap->GetHeap(), cache);
+
+        double buildTimeMs = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - startTime).count();
+        wchar_t message[256];
+        swprintf_s(message, L"Bottom-level AS built in %.1f ms (%u from cache)\n", buildTimeMs, numCacheHits);
+        OutputDebugStringW(message);
+    }
 }
 
 void GetGrassParameters(GenerateGrassStrawsConstantBuffer_AppParams* params, UINT LOD, float totalTime)
@@ -740,6 +792,28 @@ void GetGrassParameters(GenerateGrassStrawsConstantBuffer_AppParams* params, UIN
     params->positionJitterStrength = g_UIparameters.GrassGeometryLOD[LOD].RandomPositionJitterStrength;
 }
 
+// Estimates how far the straws of a grass patch move from prevParams to params, relative to the patch width.
+// Only the wind animation is estimated, any other parameter change is reported as a full displacement.
+float EstimateGrassDisplacement(const GenerateGrassStrawsConstantBuffer_AppParams& params, const GenerateGrassStrawsConstantBuffer_AppParams& prevParams, UINT windMapResolution)
+{
+    GenerateGrassStrawsConstantBuffer_AppParams unanimatedParams = params;
+    unanimatedParams.timeOffset = prevParams.timeOffset;
+    if (memcmp(&unanimatedParams, &prevParams, sizeof(params)) != 0)
+    {
+        return 1;
+    }
+
+    // The wind map is sampled with a linear filter, so the wind noise changes by at most one per texel the lookup moves.
+    float du = params.timeOffset.x - prevParams.timeOffset.x;
+    float dv = params.timeOffset.y - prevParams.timeOffset.y;
+    float windNoiseChange = min(1.f, sqrtf(du * du + dv * dv) * windMapResolution);
+
+    // The noise is weighted by 2.5 in GenerateGrassStrawsCS, and a straw bends by at most its length.
+    float strawLength = params.grassScale * params.grassHeight;
+    float strawTipDisplacement = strawLength * min(1.f, 2.5f * params.windStrength * windNoiseChange);
+    return strawTipDisplacement / params.patchSize.x;
+}
+
 void Scene::GenerateGrassGeometry()
 {
     auto commandList = m_deviceResources->GetCommandList();
@@ -752,7 +826,7 @@ void Scene::GenerateGrassGeometry()
     // Update all LODs.
     for (UINT i = 0; i < UIParameters::NumGrassGeometryLODs; i++)
     {
-        GenerateGrassStrawsConstantBuffer_AppParams params;
+        GenerateGrassStrawsConstantBuffer_AppParams params = {};
         GetGrassParameters(&params, i, totalTime);
 
         UINT vbID = m_currentGrassPatchVBIndex & 1;
@@ -774,11 +848,15 @@ void Scene::GenerateGrassGeometry()
         }
 
         // Point bottom-levelAS VB pointer to the updated VB.
+        // Regenerating the same straws leaves the AS valid, so the AS manager can skip the update.
         auto& bottomLevelAS = m_accelerationStructure->GetBottomLevelAS(L"Grass Patch LOD " + to_wstring(i));
         auto& geometryDesc = bottomLevelAS.GetGeometryDescs()[0];
         geometryDesc.Triangles.VertexBuffer.StartAddress = grassPatchVB.resource->GetGPUVirtualAddress();
-        bottomLevelAS.SetDirty(true);
+        float displacement = m_isPrevFrameGrassParamsValid ? EstimateGrassDisplacement(params, m_prevFrameGrassParams[i], m_grassGeometryGenerator.GetWindMapResolution()) : 1.f;
+        bottomLevelAS.SetGeometryDirty(0, displacement);
+        m_prevFrameGrassParams[i] = params;
     }
+    m_isPrevFrameGrassParamsValid = true;
 
     // Update bottom-level AS instances.
     {
@@ -873,9 +951,27 @@ void Scene::UpdateAccelerationStructure()
     auto resourceStateTracker = m_deviceResources->GetGpuResourceStateTracker();
     auto frameIndex = m_deviceResources->GetCurrentFrameIndex();
 
+    BottomLevelASBuildBudget buildBudget;
+    if (Scene_Args::BLASBuildBudgetKTriangles > 0)
+    {
+        buildBudget.maxTrianglesPerFrame = static_cast<UINT64>(Scene_Args::BLASBuildBudgetKTriangles) * 1024;
+    }
+    if (Scene_Args::BLASBuildBudgetMB > 0)
+    {
+        buildBudget.maxResultBytesPerFrame = static_cast<UINT64>(Scene_Args::BLASBuildBudgetMB) * 1024 * 1024;
+    }
+    m_accelerationStructure->SetBuildBudget(buildBudget);
+
     resourceStateTracker->FlushResourceBarriers();
     m_accelerationStructure->Build(commandList, m_cbvSrvUavHeap->GetHeap(), frameIndex);
 
+    // Compare the batched, pooled builds with one barrier per build and a scratch buffer per build.
+    auto& buildPlan = m_accelerationStructure->GetLastBuildPlan();
+    EngineProfiling::SetCounter(L"BLAS build barriers", buildPlan.numBarriers);
+    EngineProfiling::SetCounter(L"BLAS build barriers - unbatched", buildPlan.numBarriersUnbatched);
+    EngineProfiling::SetCounter(L"BLAS build scratch KB", buildPlan.scratchBytesUsed / 1024);
+    EngineProfiling::SetCounter(L"BLAS build scratch KB - unpooled", buildPlan.scratchBytesUnpooled / 1024);
+
     // Copy previous frame Bottom Level AS instance transforms to GPU. 
     m_prevFrameBottomLevelASInstanceTransforms.CopyStagingToGpu(frameIndex);
 
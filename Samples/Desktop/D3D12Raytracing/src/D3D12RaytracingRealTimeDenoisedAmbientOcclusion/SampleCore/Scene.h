@@ -97,6 +97,8 @@ private:
     UINT                                m_currentGrassPatchVBIndex = 0;
     UINT                                m_grassInstanceShaderRecordOffsets[2];
     UINT                                m_prevFrameLODs[NumGrassPatchesX * NumGrassPatchesZ];
+    GenerateGrassStrawsConstantBuffer_AppParams m_prevFrameGrassParams[UIParameters::NumGrassGeometryLODs];
+    bool                                m_isPrevFrameGrassParamsValid = false;
 
     std::map<std::wstring, BottomLevelAccelerationStructureGeometry> m_bottomLevelASGeometries;
     std::unique_ptr<RaytracingAccelerationStructureManager> m_accelerationStructure;
@@ -17,6 +17,7 @@
 #include <vector>
 #include <unordered_map>
 #include <array>
+#include <map>
 
 using namespace std;
 using namespace DX;
@@ -24,6 +25,7 @@ using namespace DX;
 namespace EngineProfiling
 {
     bool Paused = false;
+    map<wstring, UINT64> Counters;
 }
 
 namespace
@@ -321,6 +323,11 @@ namespace EngineProfiling
         return Paused;
     }
 
+    void SetCounter(const wstring& name, UINT64 value)
+    {
+        Counters[name] = value;
+    }
+
     void DisplayFrameRate(wstringstream& Text, UINT indent)
     {
         if (!DrawFrameRate)
@@ -361,6 +368,15 @@ namespace EngineProfiling
             Text << L"GPU[ms]\n";
 
             NestedTimingTree::Display(Text, indent, expandAllNodes);
+
+            if (!Counters.empty())
+            {
+                Text << Indent(indent) << L"Counters\n";
+                for (auto& counter : Counters)
+                {
+                    Text << Indent(indent + 2) << counter.first << L": " << counter.second << L"\n";
+                }
+            }
         }
     }
 
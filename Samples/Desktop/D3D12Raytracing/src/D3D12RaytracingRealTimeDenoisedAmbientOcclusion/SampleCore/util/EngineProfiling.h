@@ -32,6 +32,9 @@ namespace EngineProfiling
     void BeginBlock(const std::wstring& name, ID3D12GraphicsCommandList4* CommandList = nullptr);
     void EndBlock(ID3D12GraphicsCommandList4* CommandList = nullptr);
 
+    // Per-frame counters, shown below the profiler. A counter keeps its value until it's set again.
+    void SetCounter(const std::wstring& name, UINT64 value);
+
     void DisplayFrameRate(std::wstringstream& Text, UINT indent);
     void Display(std::wstringstream& text, UINT indent, bool expandAllNodes = false);
     bool IsPaused();
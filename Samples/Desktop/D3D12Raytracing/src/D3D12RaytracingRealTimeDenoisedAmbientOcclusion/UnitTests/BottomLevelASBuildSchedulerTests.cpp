@@ -0,0 +1,363 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "stdafx.h"
+#include "BottomLevelASBuildScheduler.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace BottomLevelASBuildSchedulerTests
+{
+    const UINT64 KB = 1024;
+
+    // Stands in for ID3D12Device5 when sizing builds. Sizes grow linearly with the
+    // triangle count, so a test can pick the scratch size of a build by its triangles.
+    class MockDevice
+    {
+    public:
+        static const UINT64 ScratchBytesPerTriangle = 1 * KB;
+        static const UINT64 ResultBytesPerTriangle = 2 * KB;
+
+        void GetRaytracingAccelerationStructurePrebuildInfo(
+            const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS* pDesc,
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO* pInfo)
+        {
+            UINT64 numTriangles = 0;
+            for (UINT i = 0; i < pDesc->NumDescs; i++)
+            {
+                numTriangles += pDesc->pGeometryDescs[i].Triangles.IndexCount / 3;
+            }
+            pInfo->ScratchDataSizeInBytes = numTriangles * ScratchBytesPerTriangle;
+            pInfo->UpdateScratchDataSizeInBytes = pInfo->ScratchDataSizeInBytes / 2;
+            pInfo->ResultDataMaxSizeInBytes = numTriangles * ResultBytesPerTriangle;
+        }
+    };
+
+    // Stands in for ID3D12GraphicsCommandList4. It records builds and barriers and fails
+    // the test when two builds use overlapping scratch memory without a barrier between them.
+    class MockCommandList
+    {
+    public:
+        MockCommandList(D3D12_GPU_VIRTUAL_ADDRESS scratchAddress, UINT64 scratchSize) :
+            m_scratchAddress(scratchAddress),
+            m_scratchSize(scratchSize)
+        {}
+
+        void BuildRaytracingAccelerationStructure(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* pDesc, UINT64 scratchSizeInBytes)
+        {
+            const D3D12_GPU_VIRTUAL_ADDRESS start = pDesc->ScratchAccelerationStructureData;
+            const D3D12_GPU_VIRTUAL_ADDRESS end = start + scratchSizeInBytes;
+
+            Assert::IsTrue(start >= m_scratchAddress && end <= m_scratchAddress + m_scratchSize, L"Scratch range is outside of the pool.");
+            Assert::AreEqual(0ull, start % D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT, L"Scratch range is misaligned.");
+            for (auto& range : m_scratchRangesSinceBarrier)
+            {
+                Assert::IsTrue(end <= range.first || start >= range.second, L"Builds share scratch memory without a barrier.");
+            }
+            m_scratchRangesSinceBarrier.push_back(make_pair(start, end));
+            m_scratchOffsets.push_back(start - m_scratchAddress);
+            m_numBuilds++;
+        }
+
+        void ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* pBarriers)
+        {
+            for (UINT i = 0; i < numBarriers; i++)
+            {
+                Assert::IsTrue(pBarriers[i].Type == D3D12_RESOURCE_BARRIER_TYPE_UAV);
+            }
+            Assert::IsFalse(m_scratchRangesSinceBarrier.empty(), L"Barrier without any build before it.");
+            m_scratchRangesSinceBarrier.clear();
+            m_numBarriers += numBarriers;
+        }
+
+        UINT NumBuilds() const { return m_numBuilds; }
+        UINT NumBarriers() const { return m_numBarriers; }
+        bool HasUnfinishedBuilds() const { return !m_scratchRangesSinceBarrier.empty(); }
+        const vector<UINT64>& ScratchOffsets() const { return m_scratchOffsets; }
+
+    private:
+        D3D12_GPU_VIRTUAL_ADDRESS m_scratchAddress;
+        UINT64 m_scratchSize;
+        vector<pair<D3D12_GPU_VIRTUAL_ADDRESS, D3D12_GPU_VIRTUAL_ADDRESS>> m_scratchRangesSinceBarrier;
+        vector<UINT64> m_scratchOffsets;
+        UINT m_numBuilds = 0;
+        UINT m_numBarriers = 0;
+    };
+
+    // A bottom-level AS the way the sample describes it, sized by the mock device.
+    struct MockBottomLevelAS
+    {
+        UINT64 numTriangles;
+        UINT   numFramesDeferred;
+        bool   isBuilt;
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+    };
+
+    class BottomLevelASBuildSchedulerTest
+    {
+    public:
+        static const D3D12_GPU_VIRTUAL_ADDRESS ScratchAddress = 0x10000000;
+
+        BottomLevelASBuildSchedulerTest(UINT64 scratchPoolSizeInBytes) :
+            m_scratchPoolSize(scratchPoolSizeInBytes)
+        {}
+
+        void AddBottomLevelAS(UINT64 numTriangles, bool isBuilt = true, UINT numFramesDeferred = 0)
+        {
+            D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
+            geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+            geometryDesc.Triangles.IndexCount = static_cast<UINT>(numTriangles * 3);
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
+            inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            inputs.NumDescs = 1;
+            inputs.pGeometryDescs = &geometryDesc;
+
+            MockBottomLevelAS bottomLevelAS = { numTriangles, numFramesDeferred, isBuilt };
+            m_device.GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &bottomLevelAS.prebuildInfo);
+            m_bottomLevelAS.push_back(bottomLevelAS);
+        }
+
+        BottomLevelASBuildPlan Plan(const BottomLevelASBuildBudget& budget = BottomLevelASBuildBudget())
+        {
+            vector<BottomLevelASBuildRequest> requests;
+            for (UINT i = 0; i < m_bottomLevelAS.size(); i++)
+            {
+                auto& bottomLevelAS = m_bottomLevelAS[i];
+                BottomLevelASBuildRequest request;
+                request.id = i;
+                request.scratchSizeInBytes = bottomLevelAS.prebuildInfo.ScratchDataSizeInBytes;
+                request.resultSizeInBytes = bottomLevelAS.prebuildInfo.ResultDataMaxSizeInBytes;
+                request.numTriangles = bottomLevelAS.numTriangles;
+                request.numFramesDeferred = bottomLevelAS.numFramesDeferred;
+                request.isRequired = !bottomLevelAS.isBuilt;
+                requests.push_back(request);
+            }
+            return PlanBottomLevelASBuilds(requests, m_scratchPoolSize, budget);
+        }
+
+        // Records the plan the way RaytracingAccelerationStructure::Build() does.
+        MockCommandList Record(const BottomLevelASBuildPlan& plan)
+        {
+            MockCommandList commandList(ScratchAddress, m_scratchPoolSize);
+            RecordBottomLevelASBuildPlan(plan,
+                [&](const BottomLevelASBuildPlan::Build& build)
+                {
+                    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+                    buildDesc.ScratchAccelerationStructureData = ScratchAddress + build.scratchOffset;
+                    commandList.BuildRaytracingAccelerationStructure(&buildDesc, m_bottomLevelAS[build.id].prebuildInfo.ScratchDataSizeInBytes);
+                },
+                [&]()
+                {
+                    D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+                    commandList.ResourceBarrier(1, &barrier);
+                });
+            Assert::IsFalse(commandList.HasUnfinishedBuilds(), L"The last batch isn't followed by a barrier.");
+            return commandList;
+        }
+
+    private:
+        MockDevice m_device;
+        UINT64 m_scratchPoolSize;
+        vector<MockBottomLevelAS> m_bottomLevelAS;
+    };
+
+    vector<UINT> BuildIdsInBatch(const BottomLevelASBuildPlan& plan, UINT batch)
+    {
+        vector<UINT> ids;
+        for (auto& build : plan.builds)
+        {
+            if (build.batch == batch)
+            {
+                ids.push_back(build.id);
+            }
+        }
+        return ids;
+    }
+
+    TEST_CLASS(PlanBottomLevelASBuildsTests)
+    {
+    public:
+        TEST_METHOD(SplitsBuildsIntoBatchesThatFitThePool)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+            test.AddBottomLevelAS(600);
+            test.AddBottomLevelAS(500);
+            test.AddBottomLevelAS(400);
+            test.AddBottomLevelAS(300);
+            test.AddBottomLevelAS(200);
+
+            auto plan = test.Plan();
+
+            // Largest first, each into the first batch it fits: {600, 400} and {500, 300, 200}.
+            Assert::AreEqual(2u, plan.numBatches);
+            Assert::AreEqual(5u, static_cast<UINT>(plan.builds.size()));
+            Assert::IsTrue(plan.deferredIds.empty());
+            Assert::IsTrue(vector<UINT>({ 0, 2 }) == BuildIdsInBatch(plan, 0));
+            Assert::IsTrue(vector<UINT>({ 1, 3, 4 }) == BuildIdsInBatch(plan, 1));
+
+            Assert::AreEqual(2u, plan.numBarriers);
+            Assert::AreEqual(5u, plan.numBarriersUnbatched);
+
+            auto commandList = test.Record(plan);
+            Assert::AreEqual(5u, commandList.NumBuilds());
+            Assert::AreEqual(plan.numBarriers, commandList.NumBarriers());
+        }
+
+        TEST_METHOD(ReusesScratchMemoryAcrossBatches)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+            test.AddBottomLevelAS(600);
+            test.AddBottomLevelAS(500);
+            test.AddBottomLevelAS(400);
+            test.AddBottomLevelAS(300);
+            test.AddBottomLevelAS(200);
+
+            auto plan = test.Plan();
+
+            // Every batch starts over at the beginning of the pool.
+            auto commandList = test.Record(plan);
+            Assert::IsTrue(vector<UINT64>({ 0, 600 * KB, 0, 500 * KB, 800 * KB }) == commandList.ScratchOffsets());
+
+            Assert::AreEqual(1000 * KB, plan.scratchBytesUsed);
+            Assert::AreEqual(2000 * KB, plan.scratchBytesUnpooled);
+        }
+
+        TEST_METHOD(AlignsScratchRanges)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+            test.AddBottomLevelAS(1);
+            test.AddBottomLevelAS(1);
+            test.AddBottomLevelAS(1);
+
+            auto plan = test.Plan();
+            Assert::AreEqual(1u, plan.numBatches);
+            Assert::AreEqual(3 * KB, plan.scratchBytesUsed);
+
+            // The mock device only returns aligned sizes, so request unaligned ones directly.
+            vector<BottomLevelASBuildRequest> requests(2);
+            for (UINT i = 0; i < 2; i++)
+            {
+                requests[i] = { i, 100, 100, 1, 0, false };
+            }
+            auto unalignedPlan = PlanBottomLevelASBuilds(requests, 512, BottomLevelASBuildBudget());
+            Assert::AreEqual(1u, unalignedPlan.numBatches);
+            Assert::AreEqual(0ull, unalignedPlan.builds[0].scratchOffset);
+            Assert::AreEqual(static_cast<UINT64>(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT), unalignedPlan.builds[1].scratchOffset);
+            Assert::AreEqual(512ull, unalignedPlan.scratchBytesUsed);
+        }
+
+        TEST_METHOD(SmallBuildsNeedASingleBarrier)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+            for (UINT i = 0; i < 16; i++)
+            {
+                test.AddBottomLevelAS(64);
+            }
+
+            auto plan = test.Plan();
+            Assert::AreEqual(1u, plan.numBatches);
+            Assert::AreEqual(1u, plan.numBarriers);
+            Assert::AreEqual(16u, plan.numBarriersUnbatched);
+            Assert::AreEqual(1024 * KB, plan.scratchBytesUsed);
+
+            auto commandList = test.Record(plan);
+            Assert::AreEqual(16u, commandList.NumBuilds());
+            Assert::AreEqual(1u, commandList.NumBarriers());
+        }
+
+        TEST_METHOD(BuildsLargerThanHalfThePoolEachGetABatch)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+            test.AddBottomLevelAS(800);
+            test.AddBottomLevelAS(700);
+            test.AddBottomLevelAS(600);
+
+            auto plan = test.Plan();
+            Assert::AreEqual(3u, plan.numBatches);
+            Assert::AreEqual(plan.numBarriersUnbatched, plan.numBarriers);
+            Assert::AreEqual(800 * KB, plan.scratchBytesUsed);
+
+            auto commandList = test.Record(plan);
+            Assert::IsTrue(vector<UINT64>({ 0, 0, 0 }) == commandList.ScratchOffsets());
+            Assert::AreEqual(3u, commandList.NumBarriers());
+        }
+
+        TEST_METHOD(DefersBuildsPastTheBudget)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+            test.AddBottomLevelAS(100, false);      // 0: never built
+            test.AddBottomLevelAS(500, true, 0);    // 1
+            test.AddBottomLevelAS(600, true, 2);    // 2: deferred for two frames already
+            test.AddBottomLevelAS(50, true, 0);     // 3
+
+            BottomLevelASBuildBudget budget;
+            budget.maxTrianglesPerFrame = 800;
+            auto plan = test.Plan(budget);
+
+            // The required build and the oldest deferred one fit. Once 1 doesn't, 3 can't jump ahead of it.
+            Assert::IsTrue(vector<UINT>({ 1, 3 }) == plan.deferredIds);
+            Assert::AreEqual(2u, static_cast<UINT>(plan.builds.size()));
+            Assert::IsTrue(vector<UINT>({ 2, 0 }) == BuildIdsInBatch(plan, 0));
+
+            auto commandList = test.Record(plan);
+            Assert::AreEqual(2u, commandList.NumBuilds());
+            Assert::AreEqual(1u, commandList.NumBarriers());
+        }
+
+        TEST_METHOD(BudgetNeverDefersRequiredBuilds)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+            test.AddBottomLevelAS(600, false);
+            test.AddBottomLevelAS(600, false);
+            test.AddBottomLevelAS(10, true);
+
+            BottomLevelASBuildBudget budget;
+            budget.maxTrianglesPerFrame = 100;
+            budget.maxResultBytesPerFrame = 100 * MockDevice::ResultBytesPerTriangle;
+            auto plan = test.Plan(budget);
+
+            Assert::IsTrue(vector<UINT>({ 2 }) == plan.deferredIds);
+            Assert::AreEqual(2u, plan.numBatches);
+            test.Record(plan);
+        }
+
+        TEST_METHOD(BudgetAlwaysLetsOneBuildThrough)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+            test.AddBottomLevelAS(300, true, 1);
+            test.AddBottomLevelAS(200, true, 0);
+
+            BottomLevelASBuildBudget budget;
+            budget.maxResultBytesPerFrame = MockDevice::ResultBytesPerTriangle;
+            auto plan = test.Plan(budget);
+
+            Assert::AreEqual(1u, static_cast<UINT>(plan.builds.size()));
+            Assert::AreEqual(0u, plan.builds[0].id);
+            Assert::IsTrue(vector<UINT>({ 1 }) == plan.deferredIds);
+        }
+
+        TEST_METHOD(EmptyPlanRecordsNothing)
+        {
+            BottomLevelASBuildSchedulerTest test(1024 * KB);
+
+            auto plan = test.Plan();
+            Assert::AreEqual(0u, plan.numBatches);
+            Assert::AreEqual(0u, plan.numBarriers);
+            Assert::AreEqual(0ull, plan.scratchBytesUsed);
+
+            auto commandList = test.Record(plan);
+            Assert::AreEqual(0u, commandList.NumBuilds());
+            Assert::AreEqual(0u, commandList.NumBarriers());
+        }
+    };
+}
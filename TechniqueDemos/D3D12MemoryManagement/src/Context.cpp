@@ -200,6 +200,26 @@ void Context::WaitForAllFrames()
     }
 }
 
+//
+// Retires every active frame whose fence has already completed, without waiting on
+// the frames that are still running on the GPU.
+//
+void Context::RetireCompletedFrames()
+{
+    UINT64 CompletedFence = m_pFenceObject->GetCompletedValue();
+
+    while (!IsListEmpty(&m_ActiveFrameListHead))
+    {
+        Frame* pFrame = static_cast<Frame*>(m_ActiveFrameListHead.Flink);
+        if (pFrame->CompletionFence > CompletedFence)
+        {
+            break;
+        }
+
+        RetireFrameInternal(pFrame);
+    }
+}
+
 HRESULT Context::InitializeFrame(Frame* pFrame, D3D12_COMMAND_LIST_TYPE Type)
 {
     HRESULT hr;
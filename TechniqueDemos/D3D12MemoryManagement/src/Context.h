@@ -92,6 +92,7 @@ public:
     void WaitForFence(UINT64 Fence);
     void WaitForSingleFrame();
     void WaitForAllFrames();
+    void RetireCompletedFrames();
 
     void Flush();
 
@@ -100,6 +101,11 @@ public:
         return m_pCommandQueue;
     }
 
+    inline bool IsRecording() const
+    {
+        return m_pCurrentFrame != nullptr;
+    }
+
     inline UINT32 GetActiveFrameCount() const
     {
         return m_ActiveFrames;
@@ -167,12 +167,29 @@ HRESULT D3D12MemoryManagement::CreateDeviceIndependentState()
     m_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_TRAILING);
     m_pTextFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
 
+    //
+    // The tile residency manager only tracks which pool tile backs which resource tile,
+    // so it survives device removal. The tile pool heap itself is device dependent.
+    //
+    hr = m_TileResidency.Init(TILE_POOL_SIZE / TILE_SIZE, MAX_TILE_MAPPINGS_PER_UPDATE);
+    if (FAILED(hr))
+    {
+        LOG_ERROR("Failed to initialize tile residency, hr=0x%.8x", hr);
+        return hr;
+    }
+
     return S_OK;
 }
 
 void D3D12MemoryManagement::DestroyDeviceDependentState()
 {
     SafeRelease(m_pTextBrush);
+
+    //
+    // The tile pool and the reserved resources are recreated from the resources' new
+    // device state the next time tile residency is updated.
+    //
+    DestroyTileResidencyState();
 }
 
 void D3D12MemoryManagement::DestroyDeviceIndependentState()
@@ -261,6 +278,16 @@ HRESULT D3D12MemoryManagement::LoadAssets()
         ++ImageIndex;
     }
 
+    try
+    {
+        m_TileFeedback.resize(m_Images.size());
+    }
+    catch (std::bad_alloc&)
+    {
+        LOG_ERROR("Out of memory allocating tile feedback");
+        return E_OUTOFMEMORY;
+    }
+
     return S_OK;
 }
 
@@ -359,6 +386,18 @@ bool D3D12MemoryManagement::HandleMessage(HWND hwnd, UINT Message, WPARAM wParam
             {
                 m_bPresentOnVsync = !m_bPresentOnVsync;
             }
+            else if (wParam == GetVirtualKeyFromCharacter('t')) // Toggle 't'ile residency.
+            {
+                m_bTileResidency = !m_bTileResidency;
+                if (!m_bTileResidency)
+                {
+                    //
+                    // Tile mapping updates may still be queued against the tile pool.
+                    //
+                    m_RenderContext.Flush();
+                    DestroyTileResidencyState();
+                }
+            }
     #if(_DEBUG)
             //
             // In debug builds, allow simulated device removed errors for testing purposes.
@@ -524,10 +563,199 @@ void D3D12MemoryManagement::CalculateImagePagingData(const RectF* pViewportBound
     *pPrefetchMip = PrefetchMip;
 }
 
+//
+// Creates the tile pool heap, and a reserved resource for each image to map its tiles
+// to. The reserved resources share the description, and therefore the tiling, of the
+// images, but they are never sampled, since per-mip paging already maps the images.
+//
+HRESULT D3D12MemoryManagement::CreateTileResidencyState()
+{
+    HRESULT hr;
+
+    D3D12_HEAP_DESC HeapDesc = {};
+    HeapDesc.SizeInBytes = TILE_POOL_SIZE;
+    HeapDesc.Alignment = 0;
+    HeapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    HeapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    HeapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    HeapDesc.Flags = D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES | D3D12_HEAP_FLAG_DENY_BUFFERS;
+
+    hr = m_pDevice->CreateHeap(&HeapDesc, IID_PPV_ARGS(&m_pTilePool));
+    if (FAILED(hr))
+    {
+        LOG_WARNING("Failed to create tile pool heap, hr=0x%.8x", hr);
+        return hr;
+    }
+
+    try
+    {
+        m_TileResources.assign(m_Images.size(), nullptr);
+
+        //
+        // Every mapping may need to unmap the tile it evicts as well. Each operation
+        // covers a single tile, so the region sizes and range counts never change.
+        //
+        D3D12_TILE_REGION_SIZE SingleTile = {};
+        SingleTile.NumTiles = 1;
+
+        m_TileMappingCoordinates.resize(MAX_TILE_MAPPINGS_PER_UPDATE * 2);
+        m_TileMappingRegionSizes.assign(MAX_TILE_MAPPINGS_PER_UPDATE * 2, SingleTile);
+        m_TileMappingRangeFlags.resize(MAX_TILE_MAPPINGS_PER_UPDATE * 2);
+        m_TileMappingRangeOffsets.resize(MAX_TILE_MAPPINGS_PER_UPDATE * 2);
+        m_TileMappingRangeCounts.assign(MAX_TILE_MAPPINGS_PER_UPDATE * 2, 1);
+    }
+    catch (std::bad_alloc&)
+    {
+        LOG_WARNING("Out of memory allocating tile residency state");
+        return E_OUTOFMEMORY;
+    }
+
+    for (size_t i = 0; i < m_Images.size(); ++i)
+    {
+        D3D12_RESOURCE_DESC Desc = m_Images[i].pResource->pDeviceState->pD3DResource->GetDesc();
+
+        hr = m_pDevice->CreateReservedResource(&Desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_TileResources[i]));
+        if (FAILED(hr))
+        {
+            LOG_WARNING("Failed to create reserved resource for tile residency, hr=0x%.8x", hr);
+            return hr;
+        }
+    }
+
+    return S_OK;
+}
+
+//
+// The caller must ensure that no tile mapping updates are pending on the render queue.
+//
+void D3D12MemoryManagement::DestroyTileResidencyState()
+{
+    for (auto& pTileResource : m_TileResources)
+    {
+        SafeRelease(pTileResource);
+    }
+    m_TileResources.clear();
+
+    SafeRelease(m_pTilePool);
+
+    m_TileResidency.Reset();
+}
+
+//
+// Applies the mapping operations of the last update to the tile pool. Consecutive
+// operations on the same resource are submitted together, and the order of operations
+// is kept, since an evicted tile is unmapped before its pool tile is mapped again.
+//
+void D3D12MemoryManagement::ApplyTileMappings()
+{
+    const std::vector<TileMappingOperation>& Operations = m_TileResidency.GetOperations();
+    ID3D12CommandQueue* pCommandQueue = m_RenderContext.GetCommandQueue();
+
+    assert(Operations.size() <= m_TileMappingCoordinates.size());
+
+    size_t First = 0;
+    while (First < Operations.size())
+    {
+        UINT ResourceIndex = Operations[First].ResourceIndex;
+        UINT NumTiles = 0;
+
+        for (size_t i = First; i < Operations.size() && Operations[i].ResourceIndex == ResourceIndex; ++i)
+        {
+            const TileMappingOperation* pOperation = &Operations[i];
+
+            m_TileMappingCoordinates[NumTiles] = pOperation->Coordinate;
+            if (pOperation->PoolTileIndex == INVALID_TILE_SLOT)
+            {
+                m_TileMappingRangeFlags[NumTiles] = D3D12_TILE_RANGE_FLAG_NULL;
+                m_TileMappingRangeOffsets[NumTiles] = 0;
+            }
+            else
+            {
+                m_TileMappingRangeFlags[NumTiles] = D3D12_TILE_RANGE_FLAG_NONE;
+                m_TileMappingRangeOffsets[NumTiles] = pOperation->PoolTileIndex;
+            }
+            ++NumTiles;
+        }
+
+        pCommandQueue->UpdateTileMappings(
+            m_TileResources[ResourceIndex],
+            NumTiles,
+            m_TileMappingCoordinates.data(),
+            m_TileMappingRegionSizes.data(),
+            m_pTilePool,
+            NumTiles,
+            m_TileMappingRangeFlags.data(),
+            m_TileMappingRangeOffsets.data(),
+            m_TileMappingRangeCounts.data(),
+            D3D12_TILE_MAPPING_FLAG_NONE);
+
+        First += NumTiles;
+    }
+}
+
+//
+// Updates tile residency from the feedback this frame read back the last time it was
+// rendered, then renders the feedback for the current scene camera. The feedback only
+// contains what is visible, so unlike per-mip paging, tiles are not prefetched.
+//
+void D3D12MemoryManagement::UpdateTileResidency(const RectF* pSceneBounds)
+{
+    if (m_pTilePool == nullptr)
+    {
+        HRESULT hr = CreateTileResidencyState();
+        if (FAILED(hr))
+        {
+            LOG_WARNING("Disabling tile residency, hr=0x%.8x", hr);
+            DestroyTileResidencyState();
+            m_bTileResidency = false;
+            return;
+        }
+    }
+
+    UINT Width;
+    UINT Height;
+    UINT RowPitchInTexels;
+    const UINT32* pTexels = MapFeedback(&Width, &Height, &RowPitchInTexels);
+    if (pTexels != nullptr)
+    {
+        for (size_t i = 0; i < m_Images.size(); ++i)
+        {
+            m_TileFeedback[i].pResource = m_Images[i].pResource;
+        }
+
+        DecodeTileFeedback(pTexels, Width, Height, RowPitchInTexels, m_TileFeedback.data(), (UINT)m_TileFeedback.size());
+        UnmapFeedback();
+
+        m_TileResidency.Update(m_TileFeedback.data(), (UINT)m_TileFeedback.size());
+        ApplyTileMappings();
+    }
+
+    BeginFeedbackPass(m_pSceneCamera);
+
+    for (size_t i = 0; i < m_Images.size(); ++i)
+    {
+        if (RectIntersects(m_Images[i].Bounds, *pSceneBounds))
+        {
+            DrawFeedbackRectangle(&m_Images[i].Bounds, m_Images[i].pResource, (UINT)i);
+        }
+    }
+
+    EndFeedbackPass();
+}
+
 HRESULT D3D12MemoryManagement::RenderScene(const RectF& ViewportBounds)
 {
     RectF SceneBounds = m_pSceneCamera->GenerateViewportBounds();
 
+    //
+    // Tile residency renders its own feedback pass from the scene camera before the
+    // scene, so it doesn't change what is drawn.
+    //
+    if (m_bTileResidency)
+    {
+        UpdateTileResidency(&SceneBounds);
+    }
+
     for (auto& Img : m_Images)
     {
         Resource* pResource = Img.pResource;
@@ -659,8 +887,8 @@ HRESULT D3D12MemoryManagement::RenderUI()
 
             TextRect.left = 8;
             TextRect.top = 8;
-            TextRect.right = 256;
-            TextRect.bottom = 256;
+            TextRect.right = 320;
+            TextRect.bottom = 320;
 
             float StatTimeBetweenFrames = AverageStatistics(m_StatTimeBetweenFrames, STATISTIC_COUNT);
             float StatRenderScene = AverageStatistics(m_StatRenderScene, STATISTIC_COUNT);
@@ -668,7 +896,7 @@ HRESULT D3D12MemoryManagement::RenderUI()
 
             m_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING);
             m_pTextFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR);
-            wchar_t FPSString[128];
+            wchar_t FPSString[512];
             swprintf_s(
                 FPSString,
                 _TRUNCATE,
@@ -676,12 +904,42 @@ HRESULT D3D12MemoryManagement::RenderUI()
                 L"Glitch Count: %d\n"
                 L"\n"
                 L"RenderScene: %.2f ms\n"
-                L"RenderUI: %.2f ms",
+                L"RenderUI: %.2f ms\n"
+                L"\n"
+                L"Uploads: %.1f MB/s\n"
+                L"Paging Create: %.1f ms/s\n"
+                L"Paging Copy: %.1f ms/s\n"
+                L"Decode: %.1f ms/s",
                 (UINT)(1.0f / StatTimeBetweenFrames),
                 StatTimeBetweenFrames * 1000.0f,
                 GetGlitchCount(),
                 StatRenderScene * 1000.0f,
-                StatRenderUI * 1000.0f);
+                StatRenderUI * 1000.0f,
+                m_StatUploadBytesPerSecond / _1MB,
+                m_StatPagingCreateTime * 1000.0f,
+                m_StatPagingCopyTime * 1000.0f,
+                m_StatPagingDecodeTime * 1000.0f);
+
+            if (m_bTileResidency)
+            {
+                const TileResidencyStatistics& TileStats = m_TileResidency.GetStatistics();
+
+                size_t Length = wcslen(FPSString);
+                swprintf_s(
+                    FPSString + Length,
+                    ARRAYSIZE(FPSString) - Length,
+                    L"\n"
+                    L"\n"
+                    L"Per-Mip Residency: %.1f MB\n"
+                    L"Tile Residency: %.1f MB (%.1f MB required)\n"
+                    L"Tiles Mapped: %d, Evicted: %d, Deferred: %d",
+                    (float)TileStats.PerMipBytes / _1MB,
+                    (float)TileStats.ResidentBytes / _1MB,
+                    (float)TileStats.RequiredBytes / _1MB,
+                    TileStats.MappedTiles,
+                    TileStats.EvictedTiles,
+                    TileStats.DeferredTiles);
+            }
 
             m_pD2DContext->DrawTextW(
                 FPSString,
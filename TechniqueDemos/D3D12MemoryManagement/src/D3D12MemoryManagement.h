@@ -60,6 +60,27 @@ private:
     bool m_bFullscreen = false;
     RECT m_WindowRect;
 
+    //
+    // Tile residency, fed with one feedback map per image read back from the feedback
+    // target. Tiles are mapped from a tile pool heap into a reserved resource per image
+    // with the same tiling as the image, while the images themselves are still rendered
+    // from per-mip paging. It is off by default, and created the first time it is used.
+    //
+    bool m_bTileResidency = false;
+    TileResidencyManager m_TileResidency;
+    std::vector<TileFeedback> m_TileFeedback;
+    ID3D12Heap* m_pTilePool = nullptr;
+    std::vector<ID3D12Resource*> m_TileResources;
+
+    //
+    // Arguments of UpdateTileMappings, sized for the most operations an update can produce.
+    //
+    std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_TileMappingCoordinates;
+    std::vector<D3D12_TILE_REGION_SIZE> m_TileMappingRegionSizes;
+    std::vector<D3D12_TILE_RANGE_FLAGS> m_TileMappingRangeFlags;
+    std::vector<UINT> m_TileMappingRangeOffsets;
+    std::vector<UINT> m_TileMappingRangeCounts;
+
     //
     // D2D UI rendering
     //
@@ -86,6 +107,11 @@ protected:
         UINT8* pVisibleMip,
         UINT8* pPrefetchMip);
 
+    HRESULT CreateTileResidencyState();
+    void DestroyTileResidencyState();
+    void ApplyTileMappings();
+    void UpdateTileResidency(const RectF* pSceneBounds);
+
 public:
     D3D12MemoryManagement();
     virtual ~D3D12MemoryManagement();
@@ -0,0 +1,62 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+//
+// Must match TILE_FEEDBACK_RESOLUTION and the texel packing in TileResidency.h.
+//
+#define TILE_FEEDBACK_RESOLUTION 16
+
+cbuffer Projection : register(b0)
+{
+    float4x4 GProjectionMatrix;
+};
+
+cbuffer Feedback : register(b1)
+{
+    uint GFeedbackIndex;
+    uint2 GTextureSize;
+
+    // log2 of the number of window pixels covered by a feedback texel along each axis.
+    float GFeedbackScale;
+};
+
+struct PSInput
+{
+    float4 Position : SV_POSITION;
+    float2 UV : TEXCOORD;
+};
+
+PSInput VShader(float3 Position : POSITION, float2 UV : TEXCOORD)
+{
+    PSInput Result;
+
+    Result.Position = float4(Position, 1.0f);
+    Result.Position = mul(GProjectionMatrix, Result.Position);
+    Result.UV = UV;
+
+    return Result;
+}
+
+uint PShader(PSInput Input) : SV_TARGET
+{
+    //
+    // Select the mip the same way the full resolution pass samples it. The derivatives
+    // span several window pixels, since the feedback target has a lower resolution.
+    //
+    float2 Texels = Input.UV * GTextureSize;
+    float2 dx = ddx(Texels);
+    float2 dy = ddy(Texels);
+    float Mip = 0.5f * log2(max(dot(dx, dx), dot(dy, dy))) - GFeedbackScale;
+
+    uint2 Cell = min((uint2)(saturate(Input.UV) * TILE_FEEDBACK_RESOLUTION), TILE_FEEDBACK_RESOLUTION - 1);
+
+    return ((GFeedbackIndex + 1) << 16) | (Cell.y << 12) | (Cell.x << 8) | (uint)clamp(Mip, 0.0f, 255.0f);
+}
@@ -23,6 +23,7 @@
 // broken up into multiple transfers.
 //
 #define MAX_TRANSFER_SIZE _32MB
+static_assert(MAX_TRANSFER_SIZE <= STAGING_RING_SIZE, "A transfer must fit in the staging ring");
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT Message, WPARAM wParam, LPARAM lParam)
 {
@@ -153,6 +154,7 @@ HRESULT DX12Framework::CreateDeviceIndependentStateInternal()
     //
     QueryPerformanceFrequency(&m_PerformanceFrequency);
     QueryPerformanceCounter(&m_LastFrameCounter);
+    m_LastPagingStatCounter = m_LastFrameCounter;
 
     //
     // Initialize WIC.
@@ -490,6 +492,13 @@ HRESULT DX12Framework::CreateDeviceDependentStateInternal()
         return hr;
     }
 
+    hr = m_FeedbackShader.CreateDeviceDependentState(m_pDevice, L"Assets\\Shaders\\Feedback.hlsl");
+    if (FAILED(hr))
+    {
+        LOG_WARNING("Failed to initialize feedback shader");
+        return hr;
+    }
+
     //
     // Create a basic Flip-Discard swapchain.
     //
@@ -525,12 +534,12 @@ HRESULT DX12Framework::CreateDeviceDependentStateInternal()
     }
 
     //
-    // Create RTV heap for render target.
+    // Create RTV heap for the back buffers, followed by the feedback target.
     //
     {
         D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = {};
 
-        HeapDesc.NumDescriptors = SWAPCHAIN_BUFFER_COUNT;
+        HeapDesc.NumDescriptors = SWAPCHAIN_BUFFER_COUNT + 1;
         HeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
         HeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         hr = m_pDevice->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(&m_pRtvHeap));
@@ -541,33 +550,6 @@ HRESULT DX12Framework::CreateDeviceDependentStateInternal()
         }
     }
 
-    //
-    // If enabled, create the shared staging resource used for transfers.
-    //
-    if (m_bUseSharedStagingSurface)
-    {
-        hr = m_pDevice->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(MAX_TRANSFER_SIZE),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_pStagingSurface));
-        if (FAILED(hr))
-        {
-            LOG_ERROR("Failed to create staging upload buffer, hr=0x%.8x", hr);
-            return hr;
-        }
-
-        CD3DX12_RANGE readRange(0, 0);
-        hr = m_pStagingSurface->Map(0, &readRange, &m_pStagingSurfaceData);
-        if (FAILED(hr))
-        {
-            LOG_ERROR("Failed to map upload buffer data, hr=0x%.8x", hr);
-            return hr;
-        }
-    }
-
     //
     // Create 11On12 state to enable D2D rendering on D3D12.
     //
@@ -701,6 +683,7 @@ void DX12Framework::DestroyDeviceDependentStateInternal()
 
     m_TextureShader.DestroyDeviceDependentState();
     m_ColorShader.DestroyDeviceDependentState();
+    m_FeedbackShader.DestroyDeviceDependentState();
 
     {
         LIST_ENTRY* pResourceEntry = m_ResourceListHead.Flink;
@@ -737,7 +720,6 @@ void DX12Framework::DestroyDeviceDependentStateInternal()
     SafeRelease(m_pDevice);
     SafeRelease(m_pDXGISwapChain);
     SafeRelease(m_pRtvHeap);
-    SafeRelease(m_pStagingSurface);
 
     SafeRelease(m_p11Device);
     SafeRelease(m_p11On12Device);
@@ -750,6 +732,7 @@ void DX12Framework::DestroyDeviceDependentStateInternal()
         SafeRelease(m_pWrappedBackBuffers[i]);
         SafeRelease(m_pD2DRenderTargets[i]);
     }
+    SafeRelease(m_pFeedbackTarget);
 
     if (m_p11Context)
     {
@@ -819,6 +802,44 @@ HRESULT DX12Framework::CreateSwapChainResources()
         }
     }
 
+    //
+    // Create the visibility feedback target at a fraction of the window resolution. The
+    // target is only read by copies, so it rests in the copy source state between frames.
+    //
+    {
+        m_FeedbackWidth = max((UINT)(m_WindowWidth + FEEDBACK_TARGET_SCALE - 1) / FEEDBACK_TARGET_SCALE, 1u);
+        m_FeedbackHeight = max((UINT)(m_WindowHeight + FEEDBACK_TARGET_SCALE - 1) / FEEDBACK_TARGET_SCALE, 1u);
+
+        D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Tex2D(
+            FEEDBACK_TARGET_FORMAT,
+            m_FeedbackWidth,
+            m_FeedbackHeight,
+            1,
+            1,
+            1,
+            0,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+
+        D3D12_CLEAR_VALUE ClearValue = {};
+        ClearValue.Format = FEEDBACK_TARGET_FORMAT;
+
+        hr = m_pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &Desc,
+            D3D12_RESOURCE_STATE_COPY_SOURCE,
+            &ClearValue,
+            IID_PPV_ARGS(&m_pFeedbackTarget));
+        if (FAILED(hr))
+        {
+            LOG_ERROR("Failed to create feedback target, hr=0x%.8x", hr);
+            return hr;
+        }
+
+        CD3DX12_CPU_DESCRIPTOR_HANDLE handle(m_pRtvHeap->GetCPUDescriptorHandleForHeapStart(), SWAPCHAIN_BUFFER_COUNT, m_DescriptorInfo.RtvDescriptorSize);
+        m_pDevice->CreateRenderTargetView(m_pFeedbackTarget, nullptr, handle);
+    }
+
     return S_OK;
 }
 
@@ -837,6 +858,8 @@ void DX12Framework::DestroySwapChainResources()
     //
     m_p11Context->Flush();
     m_RenderContext.Flush();
+
+    SafeRelease(m_pFeedbackTarget);
 }
 
 HRESULT DX12Framework::InitDynamicBuffer(DynamicBuffer* pBuffer)
@@ -1316,8 +1339,9 @@ HRESULT DX12Framework::CreateResourceDeviceState(Resource* pResource, UINT NumMi
     UINT NumTiles;
     D3D12_PACKED_MIP_INFO PackedMipInfo;
     D3D12_SUBRESOURCE_TILING SubresourceTiling[MAX_MIP_COUNT];
+    D3D12_TILE_SHAPE StandardTileShape;
     UINT NumResourceTilings = MAX_MIP_COUNT;
-    m_pDevice->GetResourceTiling(pTiledResource, &NumTiles, &PackedMipInfo, nullptr, &NumResourceTilings, 0, SubresourceTiling);
+    m_pDevice->GetResourceTiling(pTiledResource, &NumTiles, &PackedMipInfo, &StandardTileShape, &NumResourceTilings, 0, SubresourceTiling);
 
     //
     // Save off the number of packed and non-packed (standard) mipmaps.
@@ -1414,6 +1438,9 @@ HRESULT DX12Framework::CreateResourceDeviceState(Resource* pResource, UINT NumMi
 
     pDeviceState->pD3DResource = pTiledResource;
     pDeviceState->NumHeaps = CurrentHeapCount;
+    pDeviceState->StandardTileShape = StandardTileShape;
+    pDeviceState->Width = Width;
+    pDeviceState->Height = Height;
 
     pResource->PackedMipTileCount = PackedMipInfo.NumTilesForPackedMips;
     pResource->NumStandardMips = PackedMipInfo.NumStandardMips;
@@ -1436,6 +1463,8 @@ HRESULT DX12Framework::CreateResourceDeviceState(Resource* pResource, UINT NumMi
 
     pResource->TrimLimit = ERTP_None;
     pResource->bIgnoreBudget = false;
+    pResource->bPagingPending = false;
+    pResource->pDecodeRequest = nullptr;
 
     pResource->PagingEntry.Flink = nullptr;
 
@@ -1554,17 +1583,18 @@ HRESULT DX12Framework::GetBitmapFrameInfo(IWICBitmapFrameDecode* pFrame, BitmapF
 }
 
 //
-// LoadMip is in charge of creating resource data. If necessary, LoadMip will create the
-// heaps (physical memory) for the mipmap, update the virtual address mappings, and copy
-// the pixel data from the WIC image source.
+// DecodeMip runs on the paging thread pool. It decodes the pixel data of a mipmap from
+// the WIC image source (or generates it), and converts it to the resource format, into
+// system memory laid out for the copy to the reserved resource.
 //
-HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
+HRESULT DX12Framework::DecodeMip(DecodeRequest* pRequest)
 {
     HRESULT hr;
 
-    LOG_MESSAGE("Loading mip %d", Mip);
+    Resource* pResource = pRequest->pResource;
+    UINT32 Mip = pRequest->Mip;
 
-    UINT32 MipHeap = Mip;
+    LOG_MESSAGE("Decoding mip %d", Mip);
 
     UINT NumMips = GetResourceMipCount(pResource);
     if (Mip >= NumMips)
@@ -1573,6 +1603,9 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
         return S_FALSE;
     }
 
+    LARGE_INTEGER DecodeStartTick;
+    QueryPerformanceCounter(&DecodeStartTick);
+
     BitmapFrameInfo MipFrameInfo = {};
 
     ComPtr<IWICDdsDecoder> pDdsDecoder;
@@ -1665,6 +1698,88 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
         MipFrameInfo.HeightInBlocks = resourceDesc.Height >> Mip;
     }
 
+    pRequest->BlockHeight = MipFrameInfo.BlockHeight;
+    pRequest->WidthInTexels = MipFrameInfo.WidthInBlocks * MipFrameInfo.BlockWidth;
+
+    pRequest->pData = static_cast<BYTE*>(malloc(static_cast<size_t>(pRequest->SizeInBytes)));
+    if (pRequest->pData == nullptr)
+    {
+        LOG_ERROR("Failed to allocate %llu bytes for decoding mip %d", pRequest->SizeInBytes, Mip);
+        return E_OUTOFMEMORY;
+    }
+
+    //
+    // Large mipmaps are decoded in bands of rows, so that the decode can stop early if the
+    // request is cancelled.
+    //
+    const UINT RowPitch = pRequest->Layout.Footprint.RowPitch;
+    UINT32 MaxBandHeightInBlocks = static_cast<UINT32>(MAX_TRANSFER_SIZE / RowPitch);
+    UINT32 CurrentRowInBlocks = 0;
+
+    while (CurrentRowInBlocks < pRequest->NumRows)
+    {
+        if (pRequest->bCancelled)
+        {
+            return E_ABORT;
+        }
+
+        UINT32 BandHeightInBlocks = min(pRequest->NumRows - CurrentRowInBlocks, MaxBandHeightInBlocks);
+        UINT32 BandSize = RowPitch * BandHeightInBlocks;
+        BYTE* pBandData = pRequest->pData + static_cast<UINT64>(RowPitch) * CurrentRowInBlocks;
+
+        WICRect SourceRect;
+        SourceRect.X = 0;
+        SourceRect.Y = CurrentRowInBlocks;
+        SourceRect.Width = MipFrameInfo.WidthInBlocks;
+        SourceRect.Height = BandHeightInBlocks;
+
+        //
+        // The copy differs slightly based on whether or not this is a DDS file with block compressed data.
+        //
+        if (pDdsFrame)
+        {
+            hr = pDdsFrame->CopyBlocks(&SourceRect, RowPitch, BandSize, pBandData);
+        }
+        else if (pSourceBitmap.Get())
+        {
+            hr = pSourceBitmap->CopyPixels(&SourceRect, RowPitch, BandSize, pBandData);
+        }
+        else
+        {
+            hr = GenerateMip(pResource->GeneratedImageIndex, &SourceRect, RowPitch, BandSize, (UINT*)pBandData);
+        }
+        if (FAILED(hr))
+        {
+            LOG_ERROR("Failed to decode frame data for mip %d, hr=0x%.8x", Mip, hr);
+            return hr;
+        }
+
+        CurrentRowInBlocks += BandHeightInBlocks;
+    }
+
+    LARGE_INTEGER DecodeEndTick;
+    QueryPerformanceCounter(&DecodeEndTick);
+    InterlockedExchangeAdd64(&m_PagingDecodeTicks, DecodeEndTick.QuadPart - DecodeStartTick.QuadPart);
+
+    return S_OK;
+}
+
+//
+// UploadMip runs on the paging thread once a mipmap has been decoded. If necessary, it
+// creates the heaps (physical memory) for the mipmap and updates the virtual address
+// mappings, and then records the copy of the decoded pixel data into the current paging
+// frame.
+//
+HRESULT DX12Framework::UploadMip(DecodeRequest* pRequest)
+{
+    HRESULT hr;
+
+    Resource* pResource = pRequest->pResource;
+    UINT32 Mip = pRequest->Mip;
+    UINT32 MipHeap = Mip;
+
+    LOG_MESSAGE("Uploading mip %d", Mip);
+
     UINT NumTiles;
     UINT WidthInTiles;
 
@@ -1684,6 +1799,9 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
         NumTiles = WidthInTiles * pResource->pDeviceState->Mips[MipHeap].Desc.HeightInTiles;
     }
 
+    LARGE_INTEGER CreateStartTick;
+    QueryPerformanceCounter(&CreateStartTick);
+
     //
     // Round up the number of heaps needed for this mip.
     //
@@ -1731,52 +1849,6 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
         }
     }
 
-    //
-    // Calculate the required size of the upload buffer for transferring the contents
-    // to the new heaps.
-    //
-    UINT64 UploadBufferSize = GetRequiredIntermediateSize(pResource->pDeviceState->pD3DResource, Mip, 1);
-
-    ID3D12Resource* pUploadSurface;
-    void* pUploadData;
-
-    //
-    // If we are using a shared staging surface, we don't have to create a new upload
-    // resource for each transfer. This feature is currently experimental, and disabled
-    // by default.
-    //
-    ComPtr<ID3D12Resource> pUploadBuffer;
-    if (m_bUseSharedStagingSurface)
-    {
-        pUploadSurface = m_pStagingSurface;
-        pUploadData = m_pStagingSurfaceData;
-    }
-    else
-    {
-        hr = m_pDevice->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(UploadBufferSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&pUploadBuffer));
-        if (FAILED(hr))
-        {
-            LOG_ERROR("Failed to create upload buffer, hr=0x%.8x", hr);
-            return hr;
-        }
-
-        CD3DX12_RANGE readRange(0, 0);
-        hr = pUploadBuffer->Map(0, &readRange, &pUploadData);
-        if (FAILED(hr))
-        {
-            LOG_ERROR("Failed to map upload buffer, hr=0x%.8x", hr);
-            return hr;
-        }
-
-        pUploadSurface = pUploadBuffer.Get();
-    }
-
     //
     // Map the reserved resource (e.g. the virtual address we created with the resource)
     // to the heaps that back them. Page table updates for tiled resources can be costly,
@@ -1821,75 +1893,41 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
         }
     }
 
+    LARGE_INTEGER CopyStartTick;
+    QueryPerformanceCounter(&CopyStartTick);
+    InterlockedExchangeAdd64(&m_PagingCreateTicks, CopyStartTick.QuadPart - CreateStartTick.QuadPart);
+
     //
-    // Copy the pixel data into the staging resource, and then transfer it to the
-    // reserved resource via CopyTextureRegion.
+    // Copy the decoded pixel data into the staging ring, and then transfer it to the
+    // reserved resource via CopyTextureRegion. Mipmaps larger than a single transfer
+    // are split into bands of rows, each staged in its own part of the ring.
     //
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT Layout;
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& Layout = pRequest->Layout;
+    UINT32 MaxTransferHeightInBlocks = static_cast<UINT32>(MAX_TRANSFER_SIZE / Layout.Footprint.RowPitch);
+    UINT32 CurrentRowInBlocks = 0;
 
-    UINT NumRows;
-    UINT64 RowSizeInBytes;
-    UINT64 TotalBytes;
-    D3D12_RESOURCE_DESC Desc = pResource->pDeviceState->pD3DResource->GetDesc();
-    m_pDevice->GetCopyableFootprints(&Desc, Mip, 1, 0, &Layout, &NumRows, &RowSizeInBytes, &TotalBytes);
-    UINT64 RemainingBytes = TotalBytes;
-
-    UINT32 CurrentRow = 0;
-
-    while (RemainingBytes > 0)
+    while (CurrentRowInBlocks < pRequest->NumRows)
     {
-        UINT32 MaxTransferHeightInBlocks;
+        UINT32 TransferHeightInBlocks = min(pRequest->NumRows - CurrentRowInBlocks, MaxTransferHeightInBlocks);
+        UINT32 TransferHeightInRows = TransferHeightInBlocks * pRequest->BlockHeight;
+        UINT32 TransferSize = Layout.Footprint.RowPitch * TransferHeightInBlocks;
 
         //
-        // Begin a paging frame. Each paging operation (i.e. a copy/transfer) must be contained
-        // within a paging frame so we can track and synchronize the operation on the context.
-        //
-        m_PagingContext.Begin();
-
-        UINT64 BytesInTransfer;
-        if (m_bUseSharedStagingSurface)
-        {
-            MaxTransferHeightInBlocks = static_cast<UINT32>(MAX_TRANSFER_SIZE / Layout.Footprint.RowPitch);
-            BytesInTransfer = min(MAX_TRANSFER_SIZE, RemainingBytes);
-        }
-        else
-        {
-            MaxTransferHeightInBlocks = NumRows;
-            BytesInTransfer = RemainingBytes;
-        }
-
-        UINT32 TransferHeightInBlocks = static_cast<UINT32>((BytesInTransfer + Layout.Footprint.RowPitch - 1) / Layout.Footprint.RowPitch);
-        TransferHeightInBlocks = min(TransferHeightInBlocks, MaxTransferHeightInBlocks);
-
-        UINT32 TransferHeightInRows = TransferHeightInBlocks * MipFrameInfo.BlockHeight;
-
-        WICRect SourceRect;
-        SourceRect.X = 0;
-        SourceRect.Y = CurrentRow / MipFrameInfo.BlockHeight;
-        SourceRect.Width = MipFrameInfo.WidthInBlocks;
-        SourceRect.Height = TransferHeightInBlocks;
-
-        //
-        // The copy differs slightly based on whether or not this is a DDS file with block compressed data.
+        // Sub-allocate the staging memory for this transfer. This begins a paging frame if
+        // one is not already being recorded, and the copy is submitted with every other copy
+        // recorded by the paging thread before it next submits.
         //
-        if (pDdsFrame)
-        {
-            hr = pDdsFrame->CopyBlocks(&SourceRect, Layout.Footprint.RowPitch, Layout.Footprint.RowPitch * TransferHeightInBlocks, ((BYTE*)pUploadData));
-        }
-        else if (pSourceBitmap.Get())
-        {
-            hr = pSourceBitmap->CopyPixels(&SourceRect, Layout.Footprint.RowPitch, Layout.Footprint.RowPitch * TransferHeightInBlocks, ((BYTE*)pUploadData));
-        }
-        else
-        {
-            hr = GenerateMip(pResource->GeneratedImageIndex, &SourceRect, Layout.Footprint.RowPitch, Layout.Footprint.RowPitch * TransferHeightInBlocks, (UINT*)pUploadData);
-        }
+        UINT64 StagingOffset;
+        void* pUploadData;
+        hr = m_PagingContext.AllocateStaging(TransferSize, &StagingOffset, &pUploadData);
         if (FAILED(hr))
         {
-            LOG_ERROR("Failed to copy frame data to upload staging buffer, hr=0x%.8x", hr);
+            LOG_WARNING("Failed to allocate staging memory for resource 0x%p, mip %d. hr=0x%.8x", pResource, Mip, hr);
             return hr;
         }
 
+        memcpy(pUploadData, pRequest->pData + static_cast<UINT64>(Layout.Footprint.RowPitch) * CurrentRowInBlocks, TransferSize);
+
         //
         // Copy the texture region on the copy command queue.
         //
@@ -1900,43 +1938,50 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
             0,                      // UINT left;
             0,                      // UINT top;
             0,                      // UINT front;
-            MipFrameInfo.WidthInBlocks * MipFrameInfo.BlockWidth, // UINT right;
+            pRequest->WidthInTexels, // UINT right;
             TransferHeightInRows,   // UINT bottom;
             1,                      // UINT back;
         };
 
         CD3DX12_TEXTURE_COPY_LOCATION Dst(pResource->pDeviceState->pD3DResource, Mip);
-        CD3DX12_TEXTURE_COPY_LOCATION Src(pUploadSurface, Layout);
+        CD3DX12_TEXTURE_COPY_LOCATION Src(m_PagingContext.GetStagingRing(), Layout);
         Src.PlacedFootprint.Footprint.Height = TransferHeightInRows;
-        Src.PlacedFootprint.Offset = 0;
-        pPagingFrame->pCommandList->CopyTextureRegion(&Dst, 0, CurrentRow, 0, &Src, &SrcBox);
+        Src.PlacedFootprint.Offset = StagingOffset;
+        pPagingFrame->pCommandList->CopyTextureRegion(&Dst, 0, CurrentRowInBlocks * pRequest->BlockHeight, 0, &Src, &SrcBox);
 
-        //
-        // Synchronize on this transfer. An application may extend this implementation
-        // to support multiple operations at a time (by allowing multiple paging frames
-        // to run concurrently). However, in the interest of simplifying the concepts
-        // in the sample, it was opted to serialize paging operations to make things
-        // easier to understand.
-        //
-        hr = m_PagingContext.Execute();
-        if (FAILED(hr))
-        {
-            LOG_WARNING("Failed to transfer content for resource 0x%p, mip %d. hr=0x%.8x", pResource, Mip, hr);
-            return hr;
-        }
-
-        m_PagingContext.End();
-        m_PagingContext.Flush();
+        InterlockedExchangeAdd64(&m_PagingUploadBytes, TransferSize);
 
-        CurrentRow += TransferHeightInRows;
-        RemainingBytes -= BytesInTransfer;
+        CurrentRowInBlocks += TransferHeightInBlocks;
     }
 
+    //
+    // The mip cannot be used for rendering until its copies have completed, so it is
+    // committed when the paging frame holding the last of them retires.
+    //
+    m_PagingContext.AddPendingMip(pResource, static_cast<UINT8>(Mip));
+
+    LARGE_INTEGER CopyEndTick;
+    QueryPerformanceCounter(&CopyEndTick);
+    InterlockedExchangeAdd64(&m_PagingCopyTicks, CopyEndTick.QuadPart - CopyStartTick.QuadPart);
+
+    return S_OK;
+}
+
+//
+// Called when the paging frame that copied a mipmap retires. The mipmap is now
+// resident and fully initialized, and can be used for rendering.
+//
+void DX12Framework::CommitMip(Resource* pResource, UINT8 Mip)
+{
+    pResource->bPagingPending = false;
     pResource->MostDetailedMipResident = Mip;
 
     AddResourceCommitment(pResource);
 
-    return S_OK;
+    //
+    // Reprioritize the resource, since it may need more detailed mipmaps.
+    //
+    m_pWorkerThread->PrioritizeResource(pResource);
 }
 
 _Use_decl_annotations_
@@ -2247,45 +2292,227 @@ HRESULT DX12Framework::OnSizeChanged()
     return S_OK;
 }
 
-void DX12Framework::PrepareRendering()
+//
+// Binds a render target along with a viewport and scissor rect covering all of it.
+//
+static void SetRenderTarget(ID3D12GraphicsCommandList* pCommandList, D3D12_CPU_DESCRIPTOR_HANDLE RtvHandle, UINT Width, UINT Height)
+{
+    D3D12_VIEWPORT Viewport;
+    Viewport.TopLeftX = 0.0f;
+    Viewport.TopLeftY = 0.0f;
+    Viewport.Width = static_cast<FLOAT>(Width);
+    Viewport.Height = static_cast<FLOAT>(Height);
+    Viewport.MinDepth = 0.0f;
+    Viewport.MaxDepth = 1.0f;
+    pCommandList->RSSetViewports(1, &Viewport);
+
+    D3D12_RECT ScissorRect;
+    ScissorRect.left = 0;
+    ScissorRect.top = 0;
+    ScissorRect.right = Width;
+    ScissorRect.bottom = Height;
+    pCommandList->RSSetScissorRects(1, &ScissorRect);
+
+    pCommandList->OMSetRenderTargets(1, &RtvHandle, true, nullptr);
+}
+
+void DX12Framework::BeginFeedbackPass(const Camera* pCamera)
 {
+    static const float ClearColor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    RenderFrame* pCurrentFrame = m_RenderContext.GetCurrentFrame();
+    ID3D12GraphicsCommandList* pCommandList = pCurrentFrame->pCommandList;
+
+    pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_pFeedbackTarget, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE RtvHandle(m_pRtvHeap->GetCPUDescriptorHandleForHeapStart(), SWAPCHAIN_BUFFER_COUNT, m_DescriptorInfo.RtvDescriptorSize);
+    SetRenderTarget(pCommandList, RtvHandle, m_FeedbackWidth, m_FeedbackHeight);
+    pCommandList->ClearRenderTargetView(RtvHandle, ClearColor, 0, nullptr);
+
     //
-    // Reset the shader.
+    // The feedback pass is rendered from the camera driving residency, which may differ
+    // from the camera the scene is displayed with.
     //
+    UINT32 ConstantBufferSize = CalculateConstantBufferSize(sizeof(DirectX::XMMATRIX));
+
+    void* pViewProjection;
+    UINT32 ViewProjectionOffset;
+    HRESULT hr = pCurrentFrame->ConstantBuffer.Allocate(ConstantBufferSize, 1, &pViewProjection, &ViewProjectionOffset);
+    if (hr == E_OUTOFMEMORY)
+    {
+        RenameDynamicBuffer(&pCurrentFrame->ConstantBuffer);
+        hr = pCurrentFrame->ConstantBuffer.Allocate(ConstantBufferSize, 1, &pViewProjection, &ViewProjectionOffset);
+        assert(SUCCEEDED(hr));
+    }
+
+    *(DirectX::XMMATRIX*)pViewProjection = pCamera->GetViewProjectionMatrix();
+
+    pCurrentFrame->FeedbackCameraAddress = pCurrentFrame->ConstantBuffer.GetGPUVirtualAddress() + ViewProjectionOffset;
+
     m_pCurrentShader = nullptr;
+    SetShader(pCurrentFrame, &m_FeedbackShader);
 }
 
-void DX12Framework::PrepareFrame(RenderFrame* pFrame, const Camera* pCamera)
+void DX12Framework::DrawFeedbackRectangle(const RectF* pDest, Resource* pResource, UINT FeedbackIndex)
 {
-    static const float ClearColor[] = { 0.35f, 0.35f, 0.35f, 1.0f };
-    ID3D12GraphicsCommandList* pCommandList = pFrame->pCommandList;
+    RenderFrame* pCurrentFrame = m_RenderContext.GetCurrentFrame();
+    ID3D12GraphicsCommandList* pCommandList = pCurrentFrame->pCommandList;
+
+    SetShader(pCurrentFrame, &m_FeedbackShader);
+
+    typedef FeedbackShader::VertexFormat VertexType;
+
+    VertexType Vertices[] =
+    {
+        { { pDest->Left,  pDest->Top,    1.0f }, { 0.0f, 0.0f } }, // Top Left
+        { { pDest->Right, pDest->Bottom, 1.0f }, { 1.0f, 1.0f } }, // Bottom Right
+        { { pDest->Left,  pDest->Bottom, 1.0f }, { 0.0f, 1.0f } }, // Bottom Left
+
+        { { pDest->Right, pDest->Bottom, 1.0f }, { 1.0f, 1.0f } }, // Bottom Right
+        { { pDest->Left,  pDest->Top,    1.0f }, { 0.0f, 0.0f } }, // Top Left
+        { { pDest->Right, pDest->Top,    1.0f }, { 1.0f, 0.0f } }, // Top Right
+    };
+
+    VertexType* pVertices;
+    UINT32 Offset;
+    HRESULT hrVertexBuffer = pCurrentFrame->VertexBuffer.Allocate(sizeof(VertexType), 6, (void**)&pVertices, &Offset);
+
+    if (hrVertexBuffer == E_OUTOFMEMORY)
+    {
+        RenameDynamicBuffer(&pCurrentFrame->VertexBuffer);
+        ResetShader(pCurrentFrame);
+        hrVertexBuffer = pCurrentFrame->VertexBuffer.Allocate(sizeof(VertexType), 6, (void**)&pVertices, &Offset);
+        assert(SUCCEEDED(hrVertexBuffer));
+    }
+
+    memcpy(pVertices, Vertices, sizeof(Vertices));
+
+    //
+    // The shader computes the mipmap from the texel footprint of each feedback texel,
+    // so it needs the size of the most detailed mipmap rather than what is resident.
+    //
+    FeedbackShader::Constants Constants;
+    Constants.FeedbackIndex = FeedbackIndex;
+    Constants.TextureWidth = pResource->pDeviceState->Width;
+    Constants.TextureHeight = pResource->pDeviceState->Height;
+    Constants.FeedbackScale = static_cast<float>(FEEDBACK_TARGET_SCALE_LOG2);
+    pCommandList->SetGraphicsRoot32BitConstants(1, sizeof(Constants) / sizeof(UINT), &Constants, 0);
+
+    pCommandList->DrawInstanced(6, 1, Offset / sizeof(VertexType), 0);
+}
+
+void DX12Framework::EndFeedbackPass()
+{
+    RenderFrame* pCurrentFrame = m_RenderContext.GetCurrentFrame();
+    ID3D12GraphicsCommandList* pCommandList = pCurrentFrame->pCommandList;
+
+    pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_pFeedbackTarget, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+    //
+    // Copy the feedback into this frame's readback buffer, which is read the next time
+    // this frame comes around, once the GPU is guaranteed to be done with it. The buffer
+    // is recreated when the target outgrows it.
+    //
+    D3D12_RESOURCE_DESC Desc = m_pFeedbackTarget->GetDesc();
+    UINT64 TotalBytes;
+    m_pDevice->GetCopyableFootprints(&Desc, 0, 1, 0, &pCurrentFrame->FeedbackLayout, nullptr, nullptr, &TotalBytes);
+
+    pCurrentFrame->bFeedbackWritten = false;
+
+    if (pCurrentFrame->FeedbackReadbackSize < TotalBytes)
+    {
+        SafeRelease(pCurrentFrame->pFeedbackReadback);
+        pCurrentFrame->FeedbackReadbackSize = 0;
+
+        HRESULT hr = m_pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(TotalBytes),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&pCurrentFrame->pFeedbackReadback));
+        if (FAILED(hr))
+        {
+            LOG_WARNING("Failed to create feedback readback buffer, hr=0x%.8x", hr);
+        }
+        else
+        {
+            pCurrentFrame->FeedbackReadbackSize = TotalBytes;
+        }
+    }
+
+    if (pCurrentFrame->pFeedbackReadback != nullptr)
+    {
+        CD3DX12_TEXTURE_COPY_LOCATION Dest(pCurrentFrame->pFeedbackReadback, pCurrentFrame->FeedbackLayout);
+        CD3DX12_TEXTURE_COPY_LOCATION Source(m_pFeedbackTarget, 0);
+        pCommandList->CopyTextureRegion(&Dest, 0, 0, 0, &Source, nullptr);
+        pCurrentFrame->bFeedbackWritten = true;
+    }
+
+    //
+    // Return to the back buffer for the rest of the scene.
+    //
+    UINT BackBufferIndex = m_pDXGISwapChain->GetCurrentBackBufferIndex();
+    CD3DX12_CPU_DESCRIPTOR_HANDLE RtvHandle(m_pRtvHeap->GetCPUDescriptorHandleForHeapStart(), BackBufferIndex, m_DescriptorInfo.RtvDescriptorSize);
+    SetRenderTarget(pCommandList, RtvHandle, m_WindowWidth, m_WindowHeight);
+}
+
+const UINT32* DX12Framework::MapFeedback(UINT* pWidth, UINT* pHeight, UINT* pRowPitchInTexels)
+{
+    RenderFrame* pCurrentFrame = m_RenderContext.GetCurrentFrame();
 
     //
-    // Setup viewport and scissor rect.
+    // The current frame has retired, so the feedback it copied the last time around
+    // is complete.
     //
+    if (!pCurrentFrame->bFeedbackWritten)
     {
-        D3D12_VIEWPORT Viewport;
-        Viewport.TopLeftX = 0.0f;
-        Viewport.TopLeftY = 0.0f;
-        Viewport.Width = static_cast<FLOAT>(m_WindowWidth);
-        Viewport.Height = static_cast<FLOAT>(m_WindowHeight);
-        Viewport.MinDepth = 0.0f;
-        Viewport.MaxDepth = 1.0f;
-        pCommandList->RSSetViewports(1, &Viewport);
+        return nullptr;
+    }
 
-        D3D12_RECT ScissorRect;
-        ScissorRect.left = 0;
-        ScissorRect.top = 0;
-        ScissorRect.right = m_WindowWidth;
-        ScissorRect.bottom = m_WindowHeight;
-        pCommandList->RSSetScissorRects(1, &ScissorRect);
+    void* pData;
+    CD3DX12_RANGE ReadRange(0, static_cast<SIZE_T>(pCurrentFrame->FeedbackReadbackSize));
+    HRESULT hr = pCurrentFrame->pFeedbackReadback->Map(0, &ReadRange, &pData);
+    if (FAILED(hr))
+    {
+        LOG_WARNING("Failed to map feedback readback buffer, hr=0x%.8x", hr);
+        return nullptr;
     }
 
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& Layout = pCurrentFrame->FeedbackLayout;
+    *pWidth = Layout.Footprint.Width;
+    *pHeight = Layout.Footprint.Height;
+    *pRowPitchInTexels = Layout.Footprint.RowPitch / sizeof(UINT32);
+
+    return reinterpret_cast<const UINT32*>(static_cast<const BYTE*>(pData) + Layout.Offset);
+}
+
+void DX12Framework::UnmapFeedback()
+{
+    RenderFrame* pCurrentFrame = m_RenderContext.GetCurrentFrame();
+
+    CD3DX12_RANGE WrittenRange(0, 0);
+    pCurrentFrame->pFeedbackReadback->Unmap(0, &WrittenRange);
+    pCurrentFrame->bFeedbackWritten = false;
+}
+
+void DX12Framework::PrepareRendering()
+{
+    //
+    // Reset the shader.
+    //
+    m_pCurrentShader = nullptr;
+}
+
+void DX12Framework::PrepareFrame(RenderFrame* pFrame, const Camera* pCamera)
+{
+    static const float ClearColor[] = { 0.35f, 0.35f, 0.35f, 1.0f };
+    ID3D12GraphicsCommandList* pCommandList = pFrame->pCommandList;
+
     UINT BackBufferIndex = m_pDXGISwapChain->GetCurrentBackBufferIndex();
     pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_pRenderTargets[BackBufferIndex], D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
 
     CD3DX12_CPU_DESCRIPTOR_HANDLE RtvHandle(m_pRtvHeap->GetCPUDescriptorHandleForHeapStart(), BackBufferIndex, m_DescriptorInfo.RtvDescriptorSize);
-    pCommandList->OMSetRenderTargets(1, &RtvHandle, true, nullptr);
+    SetRenderTarget(pCommandList, RtvHandle, m_WindowWidth, m_WindowHeight);
     pCommandList->ClearRenderTargetView(RtvHandle, ClearColor, 0, nullptr);
 
     //
@@ -2314,6 +2541,31 @@ static float CalculateDeltaTime(LONGLONG CurrentTick, LONGLONG PreviousTick, LON
     return (float)(((CurrentTick - PreviousTick) / (double)PerformanceFrequency));
 }
 
+//
+// Converts the paging thread's counters into rates. The counters are sampled over
+// a full second, since paging work arrives in bursts rather than every frame.
+//
+void DX12Framework::UpdatePagingStatistics(LARGE_INTEGER CurrentTick)
+{
+    float ElapsedTime = CalculateDeltaTime(CurrentTick.QuadPart, m_LastPagingStatCounter.QuadPart, m_PerformanceFrequency.QuadPart);
+    if (ElapsedTime < 1.0f)
+    {
+        return;
+    }
+
+    LONG64 UploadBytes = InterlockedExchange64(&m_PagingUploadBytes, 0);
+    LONG64 CreateTicks = InterlockedExchange64(&m_PagingCreateTicks, 0);
+    LONG64 CopyTicks = InterlockedExchange64(&m_PagingCopyTicks, 0);
+    LONG64 DecodeTicks = InterlockedExchange64(&m_PagingDecodeTicks, 0);
+
+    m_StatUploadBytesPerSecond = UploadBytes / ElapsedTime;
+    m_StatPagingCreateTime = CalculateDeltaTime(CreateTicks, 0, m_PerformanceFrequency.QuadPart) / ElapsedTime;
+    m_StatPagingCopyTime = CalculateDeltaTime(CopyTicks, 0, m_PerformanceFrequency.QuadPart) / ElapsedTime;
+    m_StatPagingDecodeTime = CalculateDeltaTime(DecodeTicks, 0, m_PerformanceFrequency.QuadPart) / ElapsedTime;
+
+    m_LastPagingStatCounter = CurrentTick;
+}
+
 HRESULT DX12Framework::RenderInternal()
 {
     HRESULT hr;
@@ -2325,6 +2577,8 @@ HRESULT DX12Framework::RenderInternal()
     m_StatTimeBetweenFrames[m_StatIndex] = CalculateDeltaTime(CurrentTick.QuadPart, PrevTick.QuadPart, m_PerformanceFrequency.QuadPart);
     m_LastFrameCounter = CurrentTick;
 
+    UpdatePagingStatistics(CurrentTick);
+
     //
     // Prepare for a new frame.
     //
@@ -2437,7 +2691,7 @@ void DX12Framework::SetShader(RenderFrame* pFrame, const Shader* pShader)
 
         ID3D12DescriptorHeap* ppHeaps[] = { pFrame->SrvCbvHeap.m_pHeap->pHeap };
         pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-        pCommandList->SetGraphicsRootConstantBufferView(0, pFrame->CameraAddress);
+        pCommandList->SetGraphicsRootConstantBufferView(0, (pShader == &m_FeedbackShader) ? pFrame->FeedbackCameraAddress : pFrame->CameraAddress);
 
         pFrame->VertexBuffer.Align(pShader->GetVertexSize());
 
@@ -2496,10 +2750,13 @@ HRESULT DX12Framework::PageInNextLevelOfDetail(Resource* pResource)
         // where the heap has been created, but we still need to copy the pixel data
         // and possibly update the virtual address.
         //
-        hr = LoadMip(pResource, Mip);
+        // The mip is decoded on the thread pool, and uploaded by the worker thread once
+        // decoding completes.
+        //
+        hr = m_pWorkerThread->QueueDecode(pResource, Mip);
         if (FAILED(hr))
         {
-            LOG_WARNING("Failed to load mip");
+            LOG_WARNING("Failed to queue mip for decoding");
             return hr;
         }
     }
@@ -2596,6 +2853,15 @@ bool DX12Framework::TrimToTarget(ResourceTrimPass MaxPass, UINT64 TargetUsage)
                     continue;
                 }
 
+                if (pResource->bPagingPending)
+                {
+                    //
+                    // A more detailed mip is still being copied for this resource, and will
+                    // be committed on top of the mips that are currently resident.
+                    //
+                    continue;
+                }
+
                 ResourceMip* pResourceMip = &pResource->pDeviceState->Mips[Mip];
 
                 UINT64 WaitFence = 0;
@@ -2720,13 +2986,6 @@ void DX12Framework::LoadConfig(int argc, LPCSTR argv[])
     //
     // Load configuration options here.
     //
-    for (int i = 1; i < argc; ++i)
-    {
-        LPCSTR pArg = argv[i];
-
-        if (_strcmpi(pArg, "-sharedstaging") == 0)
-        {
-            m_bUseSharedStagingSurface = true;
-        }
-    }
+    UNREFERENCED_PARAMETER(argc);
+    UNREFERENCED_PARAMETER(argv);
 }
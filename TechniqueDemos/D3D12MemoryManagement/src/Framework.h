@@ -82,7 +82,7 @@ private:
     void TrimMip(Resource* pResource, UINT8 Mip);
     HRESULT GetDdsFrameInfo(IWICDdsFrameDecode* pFrame, BitmapFrameInfo* pFormatInfo);
     HRESULT GetBitmapFrameInfo(IWICBitmapFrameDecode* pFrame, BitmapFrameInfo* pFormatInfo);
-    HRESULT LoadMip(Resource* pResource, UINT32 Mip);
+    void CommitMip(Resource* pResource, UINT8 Mip);
     HRESULT GenerateMip(UINT ImageIndex, WICRect* pRect, UINT RowPitch, UINT BufferSizeInBytes, _In_reads_bytes_(BufferSizeInBytes) UINT* pBuffer);
     void RemoveResourceCommitment(Resource* pResource);
     void AddResourceCommitment(Resource* pResource);
@@ -116,6 +116,7 @@ private:
     void PrepareFrame(RenderFrame* pFrame, const Camera* pCamera);
     void PrepareRendering();
     HRESULT RenderInternal();
+    void UpdatePagingStatistics(LARGE_INTEGER CurrentTick);
 
     HRESULT OnSizeChanged();
 
@@ -137,8 +138,14 @@ protected:
     ID3D12DescriptorHeap* m_pRtvHeap = nullptr;
     IDXGISwapChain3* m_pDXGISwapChain = nullptr;
     ID3D12Resource* m_pRenderTargets[SWAPCHAIN_BUFFER_COUNT];
-    ID3D12Resource* m_pStagingSurface = nullptr;
-    void* m_pStagingSurfaceData = nullptr;
+
+    //
+    // Low resolution target recording which mipmap of each image is visible, read back
+    // by the CPU to drive tile residency.
+    //
+    ID3D12Resource* m_pFeedbackTarget = nullptr;
+    UINT m_FeedbackWidth = 0;
+    UINT m_FeedbackHeight = 0;
 
     //
     // 11On12 interface for UI
@@ -180,6 +187,7 @@ protected:
 
     TextureShader m_TextureShader;
     ColorShader m_ColorShader;
+    FeedbackShader m_FeedbackShader;
     const Shader* m_pCurrentShader = nullptr;
 
     DWORD m_ThreadContextWaitHandleIndex = 0;
@@ -203,7 +211,22 @@ protected:
     UINT m_PreviousRefreshCount = 0;
     UINT m_GlitchCount = 0;
 
-    bool m_bUseSharedStagingSurface = false;
+    //
+    // Paging stats, accumulated by the paging thread and sampled once per second by
+    // the render thread. Create time covers heap creation and tile mapping updates,
+    // and copy time covers filling the staging ring and recording the copies. Decode
+    // time is summed over every thread pool thread decoding mipmaps.
+    //
+    volatile LONG64 m_PagingUploadBytes = 0;
+    volatile LONG64 m_PagingCreateTicks = 0;
+    volatile LONG64 m_PagingCopyTicks = 0;
+    volatile LONG64 m_PagingDecodeTicks = 0;
+    LARGE_INTEGER m_LastPagingStatCounter = {};
+    float m_StatUploadBytesPerSecond = 0.0f;
+    float m_StatPagingCreateTime = 0.0f;
+    float m_StatPagingCopyTime = 0.0f;
+    float m_StatPagingDecodeTime = 0.0f;
+
     bool m_bPresentOnVsync = true;
 
     HRESULT m_SimulatedRenderResult = S_OK;
@@ -228,6 +251,15 @@ public:
     void FillRectangle(const RectF* pDest, const ColorF* pColor);
     void FillRectangle(const RectF* pDest, const ColorF* pColor, Resource* pResource);
 
+    //
+    // Visibility feedback
+    //
+    void BeginFeedbackPass(const Camera* pCamera);
+    void DrawFeedbackRectangle(const RectF* pDest, Resource* pResource, UINT FeedbackIndex);
+    void EndFeedbackPass();
+    const UINT32* MapFeedback(UINT* pWidth, UINT* pHeight, UINT* pRowPitchInTexels);
+    void UnmapFeedback();
+
     virtual HRESULT RenderScene(const RectF& ViewportBounds) = 0;
     virtual HRESULT RenderUI() = 0;
 
@@ -249,6 +281,8 @@ public:
         m_pWorkerThread->EnqueueResource(pResource);
     }
     HRESULT PageInNextLevelOfDetail(Resource* pResource);
+    HRESULT DecodeMip(DecodeRequest* pRequest);
+    HRESULT UploadMip(DecodeRequest* pRequest);
     bool TrimToTarget(ResourceTrimPass TrimLimit, UINT64 TargetUsage);
     inline bool TrimToBudget(ResourceTrimPass TrimLimit)
     {
@@ -298,6 +332,11 @@ public:
         return m_pDXGIAdapter;
     }
 
+    inline PagingContext* GetPagingContext()
+    {
+        return &m_PagingContext;
+    }
+
     inline ID3D12DescriptorHeap* GetRtvDescriptorHeap()
     {
         return m_pRtvHeap;
@@ -18,13 +18,23 @@
 // prefetching, trimming, etc occurs. The worker thread is responsible for creating and
 // mapping the heaps for the resource mipmaps as they are needed.
 //
+// Paging a mipmap in from disk is a pipeline of three stages. The worker thread prioritizes
+// and selects resources, and queues their mipmaps for decoding. The thread pool decodes and
+// converts the pixel data. The worker thread then creates the heaps, maps the tiles, and
+// uploads the decoded data on the copy queue.
+//
 
 PagingWorkerThread::PagingWorkerThread(DX12Framework* pFramework) :
     m_pFramework(pFramework),
     m_hThread(nullptr),
     m_CurrentStatus(EWTS_Suspended),
     m_RequestedStatus(EWTS_Suspended),
-    m_BudgetNotificationCookie(0)
+    m_BudgetNotificationCookie(0),
+    m_SelectedPriority(_ERP_COUNT),
+    m_pDecodeWork(nullptr),
+    m_DecodesInFlight(0),
+    m_DecodeBytesInFlight(0),
+    m_bCancelAllDecodes(FALSE)
 {
     InitializeListHead(&m_PrioritizationListHead);
     for (int i = 0; i < _ERP_COUNT; ++i)
@@ -32,7 +42,11 @@ PagingWorkerThread::PagingWorkerThread(DX12Framework* pFramework) :
         InitializeListHead(&m_PriorityQueues[i]);
     }
 
+    InitializeListHead(&m_DecodeQueueHead);
+    InitializeListHead(&m_DecodedListHead);
+
     InitializeCriticalSection(&m_PrioritizationListLock);
+    InitializeCriticalSection(&m_DecodeListLock);
 
     ZeroMemory(m_hWakeEvents, sizeof(m_hWakeEvents));
 }
@@ -51,6 +65,18 @@ PagingWorkerThread::~PagingWorkerThread()
         CloseHandle(m_hThread);
     }
 
+    if (m_pDecodeWork)
+    {
+        //
+        // The worker thread waits for every decode before it exits, but the work object may
+        // not have been used at all if the thread failed to start.
+        //
+        WaitForThreadpoolWorkCallbacks(m_pDecodeWork, TRUE);
+        CloseThreadpoolWork(m_pDecodeWork);
+    }
+
+    DeleteCriticalSection(&m_DecodeListLock);
+
     for (UINT i = 0; i < _countof(m_hWakeEvents); ++i)
     {
         if (m_hWakeEvents[i] != INVALID_HANDLE_VALUE)
@@ -93,6 +119,13 @@ HRESULT PagingWorkerThread::Init()
         return HRESULT_FROM_WIN32(GetLastError());
     }
 
+    m_pDecodeWork = CreateThreadpoolWork(PagingWorkerThread::DecodeCallback, this, nullptr);
+    if (m_pDecodeWork == nullptr)
+    {
+        LOG_ERROR("Failed to create decode thread pool work, Error=0x%.8x", GetLastError());
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
     m_hThread = CreateThread(nullptr, 0, PagingWorkerThread::ThreadEntry, this, 0, nullptr);
     if (m_hThread == nullptr)
     {
@@ -119,15 +152,6 @@ HRESULT PagingWorkerThread::Init()
     return S_OK;
 }
 
-void PagingWorkerThread::Flush()
-{
-    bool bMoreWork = true;
-    while (bMoreWork)
-    {
-        ProcessSubmission(&bMoreWork);
-    }
-}
-
 DWORD CALLBACK PagingWorkerThread::ThreadEntry(void* pArg)
 {
     PagingWorkerThread* pWorkerThread = (PagingWorkerThread*)pArg;
@@ -206,6 +230,10 @@ DWORD PagingWorkerThread::Run()
                 ProcessBudgetChangeNotification();
                 bMoreWork = true;
             }
+            else if (Reason == EWR_DecodeComplete)
+            {
+                bMoreWork = true;
+            }
             else
             {
                 assert(false);
@@ -245,6 +273,12 @@ void PagingWorkerThread::ProcessStatusChangeRequest()
     {
         if (m_RequestedStatus == EWTS_Shutdown)
         {
+            //
+            // Cancel the decodes, and wait for the paging frames in flight, which commits
+            // their mipmaps, before discarding the work they may have queued.
+            //
+            CancelDecodes();
+            m_pFramework->GetPagingContext()->Flush();
             DiscardPendingWork();
         }
     }
@@ -259,41 +293,93 @@ void PagingWorkerThread::ProcessSubmission(bool* pMoreWork)
 {
     *pMoreWork = true;
 
+    PagingContext* pPagingContext = m_pFramework->GetPagingContext();
+
     //
-    // Select the highest priority paging operation from the priority queues. SelectResource
-    // may return null if there are no entries, or if none of the operations can be selected
-    // (e.g. paging in the resources may go over the budget)
+    // Retire the paging frames that have completed since the last submission. This commits
+    // their mipmaps for rendering, and reprioritizes the resources they were loading.
     //
-    Resource* pResource = SelectResource();
-    if (pResource == nullptr)
-    {
-        *pMoreWork = false;
-        return;
-    }
+    pPagingContext->RetireCompletedFrames();
 
     //
-    // Process the request.
+    // Upload the mipmaps that the thread pool has finished decoding.
     //
-    HRESULT hr = m_pFramework->PageInNextLevelOfDetail(pResource);
+    UINT NumUploads;
+    HRESULT hr = ProcessDecodedRequests(&NumUploads);
     if (FAILED(hr))
     {
         *pMoreWork = false;
     }
 
     //
-    // After the paging operation completes, we need to reprioritize this specific resource.
+    // Page in several resources per submission. Mipmaps that must be loaded from disk are
+    // queued for decoding, and are uploaded by a later submission once decoded. Resources
+    // that were only evicted are made resident right away. The amount of decoded data in
+    // flight is bounded, so selection stops once the decode stage is full.
     //
-    PrioritizeResource(pResource);
+    UINT NumOperations = 0;
+    while (*pMoreWork &&
+           NumOperations < MAX_PAGING_BATCH_OPERATIONS &&
+           m_DecodeBytesInFlight < MAX_DECODE_MEMORY)
+    {
+        //
+        // Select the highest priority paging operation from the priority queues. SelectResource
+        // may return null if there are no entries, or if none of the operations can be selected
+        // (e.g. paging in the resources may go over the budget)
+        //
+        Resource* pResource = SelectResource();
+        if (pResource == nullptr)
+        {
+            break;
+        }
 
-    //
-    // Update the video memory info to see if we need to trim anything. This may be the case
-    // if the kernel recalculated the budget while processing the operation, or if we paged in
-    // a critical resource (such as a packed mipmap), which can let us go over budget.
-    //
-    m_pFramework->UpdateVideoMemoryInfo();
-    if (m_pFramework->IsOverBudget())
+        ++NumOperations;
+
+        //
+        // Process the request.
+        //
+        hr = m_pFramework->PageInNextLevelOfDetail(pResource);
+
+        //
+        // After the paging operation completes, we need to reprioritize this specific resource.
+        // Resources whose mip is still being decoded or copied are reprioritized when it is
+        // committed.
+        //
+        PrioritizeResource(pResource);
+
+        //
+        // Update the video memory info to see if we need to trim anything. This may be the case
+        // if the kernel recalculated the budget while processing the operation, or if we paged in
+        // a critical resource (such as a packed mipmap), which can let us go over budget.
+        //
+        m_pFramework->UpdateVideoMemoryInfo();
+        if (m_pFramework->IsOverBudget())
+        {
+            m_pFramework->TrimToBudget(pResource->TrimLimit);
+        }
+
+        if (FAILED(hr))
+        {
+            *pMoreWork = false;
+        }
+    }
+
+    pPagingContext->Submit();
+
+    if ((NumOperations == 0 && NumUploads == 0) || !*pMoreWork)
     {
-        m_pFramework->TrimToBudget(pResource->TrimLimit);
+        //
+        // The worker thread is about to go idle, so wait for the mipmaps that are still being
+        // copied. Committing them reprioritizes their resources, which may queue up more work
+        // (such as the next mip level), so only stop once nothing was in flight. Decodes that
+        // are still running wake the worker thread when they complete.
+        //
+        if (pPagingContext->GetActiveFrameCount() == 0)
+        {
+            *pMoreWork = false;
+        }
+
+        pPagingContext->Flush();
     }
 }
 
@@ -372,6 +458,11 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
     bool AnyPackedMipsMissing = MostDetailedMipResident > GetLeastDetailedMipHeapIndex(pResource);
     bool IsInPrefetchZone = (PrefetchMip != UNDEFINED_MIPMAP_INDEX);
 
+    ResourcePriority Priority = _ERP_COUNT;
+    bool bInsertAtHead = false;
+    ResourceTrimPass TrimLimit = pResource->TrimLimit;
+    bool bIgnoreBudget = pResource->bIgnoreBudget;
+
     if (AnyPackedMipsMissing && IsInPrefetchZone)
     {
         //
@@ -381,9 +472,9 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
         // else. We want to make sure the user has *something* to see, even if it's just
         // the 1x1 mipmap of a rough color.
         //
-        InsertTailList(&m_PriorityQueues[ERP_VeryHigh], &pResource->PagingEntry);
-        pResource->TrimLimit = ERTP_Visible;
-        pResource->bIgnoreBudget = true;
+        Priority = ERP_VeryHigh;
+        TrimLimit = ERTP_Visible;
+        bIgnoreBudget = true;
     }
     else if (IsMoreDetailedMip(MostDetailedMipResident, VisibleMip))
     {
@@ -392,8 +483,8 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
         // one currently resident. This is high priority, because we want what's on screen
         // to be visually correct.
         //
-        InsertTailList(&m_PriorityQueues[ERP_High], &pResource->PagingEntry);
-        pResource->TrimLimit = ERTP_NonVisible;
+        Priority = ERP_High;
+        TrimLimit = ERTP_NonVisible;
     }
     else if (AnyPackedMipsMissing)
     {
@@ -402,9 +493,10 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
         // camera to be considered a lower priority. We will make sure that the stuff the user
         // sees on screen gets loaded before this.
         //
-        InsertHeadList(&m_PriorityQueues[ERP_Medium], &pResource->PagingEntry);
-        pResource->TrimLimit = ERTP_Visible;
-        pResource->bIgnoreBudget = true;
+        Priority = ERP_Medium;
+        bInsertAtHead = true;
+        TrimLimit = ERTP_Visible;
+        bIgnoreBudget = true;
     }
     else if (IsMoreDetailedMip(MostDetailedMipResident, PrefetchMip))
     {
@@ -412,8 +504,8 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
         // This is a proximity prefetched mipmap. The user cannot see this mipmap yet, but it
         // is nearby. We want to reduce any texture popping that may occur as the user scrolls
         //
-        InsertTailList(&m_PriorityQueues[ERP_Medium], &pResource->PagingEntry);
-        pResource->TrimLimit = ERTP_NonPrefetchable;
+        Priority = ERP_Medium;
+        TrimLimit = ERTP_NonPrefetchable;
 
         assert(PrefetchMip != UNDEFINED_MIPMAP_INDEX);
     }
@@ -425,8 +517,43 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
         // occur after everything else, but will help guarantee that the user gets a smooth
         // experience at all times by prefetching the texture data prior to being needed.
         //
-        InsertTailList(&m_PriorityQueues[ERP_Low], &pResource->PagingEntry);
-        pResource->TrimLimit = ERTP_None;
+        Priority = ERP_Low;
+        TrimLimit = ERTP_None;
+    }
+
+    if (pResource->bPagingPending)
+    {
+        //
+        // A mip is already being paged in for this resource, and the resource will be queued
+        // again once it is committed. If the camera has moved so that the mip being decoded is
+        // no longer as important, cancel the decode so the thread pool can move on to the
+        // resources that are now more important.
+        //
+        DecodeRequest* pRequest = pResource->pDecodeRequest;
+        if (pRequest != nullptr && Priority > pRequest->Priority)
+        {
+            InterlockedExchange(&pRequest->bCancelled, TRUE);
+        }
+        return;
+    }
+
+    //
+    // The trim limit and budget override belong to the mip that is paged in next, so they
+    // are left alone while a decode is in flight.
+    //
+    pResource->TrimLimit = TrimLimit;
+    pResource->bIgnoreBudget = bIgnoreBudget;
+
+    if (Priority != _ERP_COUNT)
+    {
+        if (bInsertAtHead)
+        {
+            InsertHeadList(&m_PriorityQueues[Priority], &pResource->PagingEntry);
+        }
+        else
+        {
+            InsertTailList(&m_PriorityQueues[Priority], &pResource->PagingEntry);
+        }
     }
 }
 
@@ -501,6 +628,7 @@ Resource* PagingWorkerThread::SelectResource()
             RemoveEntryList(pEntry);
             pEntry->Flink = nullptr;
             pResource->bIgnoreBudget = false;
+            m_SelectedPriority = static_cast<ResourcePriority>(i);
 
             return pResource;
         }
@@ -509,10 +637,200 @@ Resource* PagingWorkerThread::SelectResource()
     return nullptr;
 }
 
+//
+// Queues a mipmap to be decoded on the thread pool. The resource stays out of the priority
+// queues until the mipmap has been decoded, uploaded and committed.
+//
+HRESULT PagingWorkerThread::QueueDecode(Resource* pResource, UINT8 Mip)
+{
+    DecodeRequest* pRequest;
+
+    try
+    {
+        pRequest = new DecodeRequest();
+    }
+    catch (std::bad_alloc&)
+    {
+        LOG_ERROR("Failed to allocate decode request");
+        return E_OUTOFMEMORY;
+    }
+
+    pRequest->pResource = pResource;
+    pRequest->Mip = Mip;
+    pRequest->bCancelled = FALSE;
+    pRequest->pData = nullptr;
+    pRequest->Result = E_PENDING;
+
+    //
+    // Decodes are only queued for the resource that was just selected, so this is the
+    // priority the resource was selected with.
+    //
+    pRequest->Priority = m_SelectedPriority;
+
+    UINT64 RowSizeInBytes;
+    UINT64 TotalBytes;
+    D3D12_RESOURCE_DESC Desc = pResource->pDeviceState->pD3DResource->GetDesc();
+    m_pFramework->GetDevice()->GetCopyableFootprints(&Desc, Mip, 1, 0, &pRequest->Layout, &pRequest->NumRows, &RowSizeInBytes, &TotalBytes);
+    pRequest->SizeInBytes = static_cast<UINT64>(pRequest->Layout.Footprint.RowPitch) * pRequest->NumRows;
+
+    pResource->pDecodeRequest = pRequest;
+    pResource->bPagingPending = true;
+
+    ++m_DecodesInFlight;
+    m_DecodeBytesInFlight += pRequest->SizeInBytes;
+
+    EnterCriticalSection(&m_DecodeListLock);
+    InsertTailList(&m_DecodeQueueHead, pRequest);
+    LeaveCriticalSection(&m_DecodeListLock);
+
+    SubmitThreadpoolWork(m_pDecodeWork);
+
+    return S_OK;
+}
+//
+// Decodes the request at the head of the decode queue. This runs on the thread pool, once
+// for every submission of the decode work object.
+//
+VOID CALLBACK PagingWorkerThread::DecodeCallback(PTP_CALLBACK_INSTANCE /*pInstance*/, void* pArg, PTP_WORK /*pWork*/)
+{
+    PagingWorkerThread* pWorkerThread = static_cast<PagingWorkerThread*>(pArg);
+
+    EnterCriticalSection(&pWorkerThread->m_DecodeListLock);
+    assert(!IsListEmpty(&pWorkerThread->m_DecodeQueueHead));
+    DecodeRequest* pRequest = static_cast<DecodeRequest*>(RemoveHeadList(&pWorkerThread->m_DecodeQueueHead));
+    LeaveCriticalSection(&pWorkerThread->m_DecodeListLock);
+
+    if (pRequest->bCancelled || pWorkerThread->m_bCancelAllDecodes)
+    {
+        pRequest->Result = E_ABORT;
+    }
+    else
+    {
+        pRequest->Result = pWorkerThread->m_pFramework->DecodeMip(pRequest);
+    }
+
+    EnterCriticalSection(&pWorkerThread->m_DecodeListLock);
+    InsertTailList(&pWorkerThread->m_DecodedListHead, pRequest);
+    LeaveCriticalSection(&pWorkerThread->m_DecodeListLock);
+
+    SetEvent(pWorkerThread->m_hWakeEvents[EWR_DecodeComplete]);
+}
+
+//
+// Uploads the mipmaps that have finished decoding, until the current paging frame is full.
+// Cancelled or failed requests are discarded, and their resources are queued again.
+//
+HRESULT PagingWorkerThread::ProcessDecodedRequests(UINT* pNumUploads)
+{
+    HRESULT Result = S_OK;
+    PagingContext* pPagingContext = m_pFramework->GetPagingContext();
+
+    *pNumUploads = 0;
+
+    while (pPagingContext->GetRecordedStagingBytes() < MAX_PAGING_BATCH_SIZE)
+    {
+        DecodeRequest* pRequest = nullptr;
+
+        EnterCriticalSection(&m_DecodeListLock);
+        if (!IsListEmpty(&m_DecodedListHead))
+        {
+            pRequest = static_cast<DecodeRequest*>(RemoveHeadList(&m_DecodedListHead));
+        }
+        LeaveCriticalSection(&m_DecodeListLock);
+
+        if (pRequest == nullptr)
+        {
+            break;
+        }
+
+        Resource* pResource = pRequest->pResource;
+        pResource->pDecodeRequest = nullptr;
+
+        HRESULT hr = pRequest->Result;
+        if (hr == S_OK)
+        {
+            hr = m_pFramework->UploadMip(pRequest);
+        }
+        else if (hr == E_ABORT)
+        {
+            LOG_MESSAGE("WT: Cancelled decode of resource 0x%p mip %d", pResource, pRequest->Mip);
+        }
+
+        if (hr == S_OK)
+        {
+            ++*pNumUploads;
+        }
+        else
+        {
+            //
+            // The mip will not be committed, so queue the resource again at its current priority.
+            //
+            pResource->bPagingPending = false;
+            PrioritizeResource(pResource);
+
+            if (FAILED(hr) && hr != E_ABORT)
+            {
+                LOG_WARNING("Failed to page in resource 0x%p mip %d, hr=0x%.8x", pResource, pRequest->Mip, hr);
+                Result = hr;
+            }
+        }
+
+        CompleteDecodeRequest(pRequest);
+
+        //
+        // Creating the heaps for the mip may have brought us over budget.
+        //
+        m_pFramework->UpdateVideoMemoryInfo();
+        if (m_pFramework->IsOverBudget())
+        {
+            m_pFramework->TrimToBudget(pResource->TrimLimit);
+        }
+    }
+
+    return Result;
+}
+
+void PagingWorkerThread::CompleteDecodeRequest(DecodeRequest* pRequest)
+{
+    assert(m_DecodesInFlight > 0);
+    assert(m_DecodeBytesInFlight >= pRequest->SizeInBytes);
+
+    --m_DecodesInFlight;
+    m_DecodeBytesInFlight -= pRequest->SizeInBytes;
+
+    free(pRequest->pData);
+    delete pRequest;
+}
+
+//
+// Cancels every decode that has not started, waits for the ones that are running, and
+// discards their results. Used when the worker thread shuts down.
+//
+void PagingWorkerThread::CancelDecodes()
+{
+    InterlockedExchange(&m_bCancelAllDecodes, TRUE);
+    WaitForThreadpoolWorkCallbacks(m_pDecodeWork, FALSE);
+
+    assert(IsListEmpty(&m_DecodeQueueHead));
+
+    while (!IsListEmpty(&m_DecodedListHead))
+    {
+        DecodeRequest* pRequest = static_cast<DecodeRequest*>(RemoveHeadList(&m_DecodedListHead));
+
+        pRequest->pResource->pDecodeRequest = nullptr;
+        pRequest->pResource->bPagingPending = false;
+
+        CompleteDecodeRequest(pRequest);
+    }
+
+    assert(m_DecodesInFlight == 0);
+}
+
 //
 // PagingContext
 //
 #define PAGING_CONTEXT_COMMAND_LIST_TYPE D3D12_COMMAND_LIST_TYPE_COPY
+#define PAGING_FRAME_COUNT 2
 
 PagingContext::PagingContext(DX12Framework* pFramework) :
     Context(pFramework)
@@ -537,16 +855,21 @@ HRESULT PagingContext::CreateDeviceDependentState()
     try
     {
         //
-        // The paging context always has only a single frame, since we will only process
-        // one paging operation at a time.
+        // The paging thread records the next submission while the previous one is still
+        // copying on the GPU, so the paging context has more than one frame.
         //
-        PagingFrame* pFrame = new PagingFrame();
-
-        hr = InitializeFrame(pFrame, PAGING_CONTEXT_COMMAND_LIST_TYPE);
-        if (FAILED(hr))
+        for (UINT i = 0; i < PAGING_FRAME_COUNT; ++i)
         {
-            LOG_WARNING("Failed to initialize frame object, hr=0x%.8x", hr);
-            return hr;
+            PagingFrame* pFrame = new PagingFrame();
+            pFrame->StagingRingEnd = 0;
+            pFrame->StagingBytes = 0;
+
+            hr = InitializeFrame(pFrame, PAGING_CONTEXT_COMMAND_LIST_TYPE);
+            if (FAILED(hr))
+            {
+                LOG_WARNING("Failed to initialize frame object, hr=0x%.8x", hr);
+                return hr;
+            }
         }
     }
     catch (std::bad_alloc&)
@@ -559,6 +882,34 @@ HRESULT PagingContext::CreateDeviceDependentState()
         return E_OUTOFMEMORY;
     }
 
+    //
+    // Create the staging ring. It stays mapped for the lifetime of the device, since
+    // upload heaps may be written by the CPU while the GPU reads other parts of them.
+    //
+    hr = m_pFramework->GetDevice()->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(STAGING_RING_SIZE),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_pStagingRing));
+    if (FAILED(hr))
+    {
+        LOG_ERROR("Failed to create staging ring buffer, hr=0x%.8x", hr);
+        return hr;
+    }
+
+    CD3DX12_RANGE readRange(0, 0);
+    hr = m_pStagingRing->Map(0, &readRange, reinterpret_cast<void**>(&m_pStagingRingData));
+    if (FAILED(hr))
+    {
+        LOG_ERROR("Failed to map staging ring buffer, hr=0x%.8x", hr);
+        return hr;
+    }
+
+    m_StagingRingHead = 0;
+    m_StagingRingTail = 0;
+
     return S_OK;
 }
 
@@ -586,5 +937,139 @@ void PagingContext::DestroyDeviceDependentState()
         SafeDelete(pFrame);
     }
 
+    SafeRelease(m_pStagingRing);
+    m_pStagingRingData = nullptr;
+
     Context::DestroyDeviceDependentState();
 }
+
+//
+// Sub-allocates staging memory for a transfer recorded into the current paging frame,
+// beginning a new frame if none is being recorded. When the ring is full, the oldest
+// frames are retired to make room, and if the space is held by the frame being
+// recorded, that frame is submitted first.
+//
+HRESULT PagingContext::AllocateStaging(UINT64 Size, UINT64* pOffset, void** ppData)
+{
+    HRESULT hr;
+
+    assert(Size <= STAGING_RING_SIZE);
+
+    for (;;)
+    {
+        if (m_StagingRingHead == m_StagingRingTail)
+        {
+            //
+            // Nothing is in flight, so restart at the beginning of the ring. This
+            // guarantees that any allocation up to the size of the ring will fit.
+            //
+            m_StagingRingHead = AlignUp(m_StagingRingHead, STAGING_RING_SIZE);
+            m_StagingRingTail = m_StagingRingHead;
+        }
+
+        //
+        // Placed footprints must be aligned, and an allocation may not wrap around the
+        // end of the ring, since the copy reads it as one contiguous range.
+        //
+        UINT64 Start = AlignUp(m_StagingRingHead, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        if ((Start % STAGING_RING_SIZE) + Size > STAGING_RING_SIZE)
+        {
+            Start = AlignUp(Start, STAGING_RING_SIZE);
+        }
+
+        if (Start + Size - m_StagingRingTail <= STAGING_RING_SIZE)
+        {
+            if (!IsRecording())
+            {
+                Begin();
+            }
+
+            PagingFrame* pFrame = GetCurrentFrame();
+
+            m_StagingRingHead = Start + Size;
+            pFrame->StagingRingEnd = m_StagingRingHead;
+            pFrame->StagingBytes += Size;
+
+            *pOffset = Start % STAGING_RING_SIZE;
+            *ppData = m_pStagingRingData + *pOffset;
+
+            return S_OK;
+        }
+
+        if (!IsListEmpty(&m_ActiveFrameListHead))
+        {
+            WaitForSingleFrame();
+        }
+        else
+        {
+            //
+            // The frame being recorded holds everything that is in use, so it must be
+            // submitted before its space can be retired.
+            //
+            assert(IsRecording());
+
+            hr = Submit();
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+    }
+}
+
+//
+// Commits Mip for pResource once the copies recorded so far in the current paging
+// frame have completed on the GPU.
+//
+void PagingContext::AddPendingMip(Resource* pResource, UINT8 Mip)
+{
+    assert(IsRecording());
+
+    PendingMip Pending = { pResource, Mip };
+    GetCurrentFrame()->PendingMips.push_back(Pending);
+
+    pResource->bPagingPending = true;
+}
+
+//
+// Submits the current paging frame, if any, as a single command list execution.
+//
+HRESULT PagingContext::Submit()
+{
+    if (!IsRecording())
+    {
+        return S_OK;
+    }
+
+    HRESULT hr = Execute();
+    if (FAILED(hr))
+    {
+        LOG_WARNING("Failed to submit paging frame, hr=0x%.8x", hr);
+    }
+
+    //
+    // The frame is ended even if it could not be executed, so that it still retires
+    // and releases its part of the staging ring.
+    //
+    End();
+
+    return hr;
+}
+
+void PagingContext::RetireFrame(Frame* pFrame)
+{
+    PagingFrame* pPagingFrame = static_cast<PagingFrame*>(pFrame);
+
+    //
+    // Frames retire in submission order, so everything staged up to the end of this
+    // frame has been consumed by the GPU.
+    //
+    m_StagingRingTail = max(m_StagingRingTail, pPagingFrame->StagingRingEnd);
+    pPagingFrame->StagingBytes = 0;
+
+    for (const PendingMip& Pending : pPagingFrame->PendingMips)
+    {
+        m_pFramework->CommitMip(Pending.pResource, Pending.Mip);
+    }
+    pPagingFrame->PendingMips.clear();
+}
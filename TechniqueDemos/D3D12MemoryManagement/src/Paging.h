@@ -32,6 +32,10 @@ enum WakeReason
     // resources to remain under the budget.
     EWR_BudgetNotification,
 
+    // Indicates that the thread pool finished decoding one or more mipmaps, which
+    // the worker thread can now upload.
+    EWR_DecodeComplete,
+
     _EWR_COUNT
 };
 
@@ -47,6 +51,32 @@ enum WorkerThreadStatus
     _EWTS_COUNT
 };
 
+//
+// A request to decode a single mipmap on the thread pool. The pixels are decoded into
+// system memory using the same layout as the copy footprint, so that uploading them
+// only requires copying each band of rows into the staging ring.
+//
+struct DecodeRequest : LIST_ENTRY
+{
+    Resource* pResource;
+    UINT8 Mip;
+
+    // The priority of the resource when the request was queued. The request is cancelled
+    // if the resource is reprioritized lower before it has been decoded.
+    ResourcePriority Priority;
+    volatile LONG bCancelled;
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT Layout;
+    UINT NumRows;
+    UINT64 SizeInBytes;
+
+    // Filled in by the decode.
+    UINT BlockHeight;
+    UINT WidthInTexels;
+    BYTE* pData;
+    HRESULT Result;
+};
+
 //
 // The paging worker thread is the powerhouse behind all paging and texture streaming
 // for the sample.
@@ -86,13 +116,36 @@ private:
     // resources in these arrays in strict order.
     LIST_ENTRY m_PriorityQueues[_ERP_COUNT];
 
+    // The priority queue that the most recently selected resource was taken from.
+    ResourcePriority m_SelectedPriority;
+
+    //
+    // Decoding is done on the thread pool, so that the worker thread only prioritizes
+    // resources and uploads mipmaps. Each submission of the work object decodes the
+    // request at the head of the decode queue, and moves it to the decoded list.
+    //
+    PTP_WORK m_pDecodeWork;
+
+    // Lock for accessing the decode queue and decoded list, which are shared with the
+    // thread pool.
+    CRITICAL_SECTION m_DecodeListLock;
+    LIST_ENTRY m_DecodeQueueHead;
+    LIST_ENTRY m_DecodedListHead;
+
+    // The number and total size of the requests that are queued, being decoded, or waiting
+    // to be uploaded. These are only accessed by the worker thread.
+    UINT m_DecodesInFlight;
+    UINT64 m_DecodeBytesInFlight;
+
+    // Set on shutdown, so that the thread pool skips the decodes that have not started.
+    volatile LONG m_bCancelAllDecodes;
+
 private:
     PagingWorkerThread(DX12Framework* pFramework);
     ~PagingWorkerThread();
 
     HRESULT Init();
 
-    void Flush();
     void DiscardPendingWork();
     DWORD Run();
 
@@ -105,16 +158,37 @@ private:
     void ProcessSubmission(bool* pMoreWork);
     void ProcessBudgetChangeNotification();
 
+    HRESULT QueueDecode(Resource* pResource, UINT8 Mip);
+    HRESULT ProcessDecodedRequests(UINT* pNumUploads);
+    void CompleteDecodeRequest(DecodeRequest* pRequest);
+    void CancelDecodes();
+
     void SetStatus(WorkerThreadStatus Status);
 
     static DWORD CALLBACK ThreadEntry(void* pArg);
+    static VOID CALLBACK DecodeCallback(PTP_CALLBACK_INSTANCE pInstance, void* pArg, PTP_WORK pWork);
 };
 
 //
-// A paging frame does not have any special state.
+// A mipmap whose copies were recorded into a paging frame. The mipmap is committed
+// for rendering once the frame has completed on the GPU.
+//
+struct PendingMip
+{
+    Resource* pResource;
+    UINT8 Mip;
+};
+
+//
+// A paging frame holds every copy recorded by the paging thread during a single
+// submission. It tracks the end of the staging ring space it used, so that the
+// space can be reused when the frame retires, and the mipmaps it is loading.
 //
 struct PagingFrame : Frame
 {
+    UINT64 StagingRingEnd;
+    UINT64 StagingBytes;
+    std::vector<PendingMip> PendingMips;
 };
 
 //
@@ -126,8 +200,25 @@ struct PagingFrame : Frame
 // the paging operations to run completely in parallel with 3D graphics work
 // submitted on the 3D engines.
 //
+// Pixel data is staged in a single persistently mapped upload buffer, which is used
+// as a ring. Each transfer sub-allocates from the head of the ring, and the tail
+// advances as paging frames retire, so no upload resources are created while paging.
+//
 class PagingContext : public Context
 {
+private:
+    ID3D12Resource* m_pStagingRing = nullptr;
+    BYTE* m_pStagingRingData = nullptr;
+
+    // Positions in the staging ring. These only ever increase, and are wrapped to an
+    // offset in the ring buffer when allocating. Everything between the tail and the
+    // head is in use by frames that have not yet retired.
+    UINT64 m_StagingRingHead = 0;
+    UINT64 m_StagingRingTail = 0;
+
+protected:
+    virtual void RetireFrame(Frame* pFrame) override;
+
 public:
     PagingContext(DX12Framework* pFramework);
     ~PagingContext();
@@ -135,8 +226,22 @@ public:
     HRESULT CreateDeviceDependentState();
     void DestroyDeviceDependentState();
 
+    HRESULT AllocateStaging(UINT64 Size, UINT64* pOffset, void** ppData);
+    void AddPendingMip(Resource* pResource, UINT8 Mip);
+    HRESULT Submit();
+
     inline PagingFrame* GetCurrentFrame() const
     {
         return static_cast<PagingFrame*>(m_pCurrentFrame);
     }
+
+    inline ID3D12Resource* GetStagingRing() const
+    {
+        return m_pStagingRing;
+    }
+
+    inline UINT64 GetRecordedStagingBytes() const
+    {
+        return m_pCurrentFrame ? GetCurrentFrame()->StagingBytes : 0;
+    }
 };
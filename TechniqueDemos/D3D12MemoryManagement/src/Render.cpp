@@ -75,6 +75,10 @@ HRESULT RenderContext::CreateDeviceDependentState(UINT FrameCount)
 
             InitializeListHead(&pFrame->PendingBufferListHead);
             InitializeListHead(&pFrame->PendingHeapListHead);
+
+            pFrame->pFeedbackReadback = nullptr;
+            pFrame->FeedbackReadbackSize = 0;
+            pFrame->bFeedbackWritten = false;
         }
     }
     catch (std::bad_alloc&)
@@ -107,6 +111,7 @@ void RenderContext::DestroyDeviceDependentState()
 
         SafeRelease(pFrame->pCommandAllocator);
         SafeRelease(pFrame->pCommandList);
+        SafeRelease(pFrame->pFeedbackReadback);
         m_pFramework->DestroyDynamicBuffer(&pFrame->VertexBuffer);
         m_pFramework->DestroyDynamicBuffer(&pFrame->ConstantBuffer);
         m_pFramework->DestroyDynamicDescriptorHeap(&pFrame->SrvCbvHeap);
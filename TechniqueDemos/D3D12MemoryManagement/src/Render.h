@@ -30,6 +30,16 @@ struct RenderFrame : Frame
     DynamicDescriptorHeap SrvCbvHeap;
 
     D3D12_GPU_VIRTUAL_ADDRESS CameraAddress;
+
+    //
+    // Readback of the visibility feedback target, copied at the end of the feedback pass.
+    // It may only be mapped once the frame has retired, and grows with the target.
+    //
+    ID3D12Resource* pFeedbackReadback;
+    UINT64 FeedbackReadbackSize;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT FeedbackLayout;
+    D3D12_GPU_VIRTUAL_ADDRESS FeedbackCameraAddress;
+    bool bFeedbackWritten;
 };
 
 //
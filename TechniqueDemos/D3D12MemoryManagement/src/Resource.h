@@ -80,6 +80,13 @@ struct ResourceDeviceState
     ID3D12Resource* pD3DResource;
     UINT32 NumHeaps;
 
+    // The texel dimensions of a single tile in the standard (non-packed) mipmaps.
+    D3D12_TILE_SHAPE StandardTileShape;
+
+    // The texel dimensions of the most detailed mipmap.
+    UINT Width;
+    UINT Height;
+
     //
     // Mips must always be the last element, since it is actually a dynamic array.
     // The actual count of the array is equal to the number of unique mip heaps.
@@ -157,6 +164,15 @@ struct Resource
     // to ensure that every resource has at least some low quality content.
     bool bIgnoreBudget : 1;
 
+    // True while the next mip level is being decoded, or its copies have been recorded
+    // by the paging thread but have not yet completed on the GPU. The resource is
+    // neither queued nor trimmed until the paging frame retires and commits the mip.
+    bool bPagingPending : 1;
+
+    // The decode request for the mip that is being paged in, until it has been decoded
+    // and uploaded. Only accessed by the paging thread.
+    DecodeRequest* pDecodeRequest;
+
     // The maximum trimming pass that should be used to help resolve paging failures
     // when paging in a resource would normally go over the budget. This limitation
     // prevents resources from recursively trimming one another by preventing lower
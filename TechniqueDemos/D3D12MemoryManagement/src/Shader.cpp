@@ -27,7 +27,8 @@ HRESULT Shader::CreateDeviceDependentState(
     D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc,
     D3D12_INPUT_ELEMENT_DESC* pInputElements,
     UINT InputElementCount,
-    bool bEnableAlpha)
+    bool bEnableAlpha,
+    DXGI_FORMAT RenderTargetFormat)
 {
     HRESULT hr;
 
@@ -145,7 +146,7 @@ HRESULT Shader::CreateDeviceDependentState(
         PsoDesc.SampleMask = UINT_MAX;
         PsoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
         PsoDesc.NumRenderTargets = 1;
-        PsoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        PsoDesc.RTVFormats[0] = RenderTargetFormat;
         PsoDesc.SampleDesc.Count = 1;
 
         hr = pDevice->CreateGraphicsPipelineState(&PsoDesc, IID_PPV_ARGS(&m_pPipelineState));
@@ -196,7 +197,7 @@ HRESULT TextureShader::CreateDeviceDependentState(ID3D12Device* pDevice, const w
         { "COLOR",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 20, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
     };
 
-    return Shader::CreateDeviceDependentState(pDevice, pShaderFile, &RootSignatureDesc, InputElementDescs, _countof(InputElementDescs), false);
+    return Shader::CreateDeviceDependentState(pDevice, pShaderFile, &RootSignatureDesc, InputElementDescs, _countof(InputElementDescs), false, DXGI_FORMAT_R8G8B8A8_UNORM);
 }
 
 //
@@ -222,5 +223,31 @@ HRESULT ColorShader::CreateDeviceDependentState(ID3D12Device* pDevice, const wch
         { "COLOR",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
     };
 
-    return Shader::CreateDeviceDependentState(pDevice, pShaderFile, &RootSignatureDesc, InputElementDescs, _countof(InputElementDescs), true);
+    return Shader::CreateDeviceDependentState(pDevice, pShaderFile, &RootSignatureDesc, InputElementDescs, _countof(InputElementDescs), true, DXGI_FORMAT_R8G8B8A8_UNORM);
+}
+
+//
+// FeedbackShader
+//
+FeedbackShader::FeedbackShader() :
+    Shader(sizeof(VertexFormat))
+{
+}
+
+HRESULT FeedbackShader::CreateDeviceDependentState(ID3D12Device* pDevice, const wchar_t* pShaderFile)
+{
+    CD3DX12_ROOT_PARAMETER1 RootParameters[2];
+    RootParameters[0].InitAsConstantBufferView(0);
+    RootParameters[1].InitAsConstants(sizeof(Constants) / sizeof(UINT), 1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+
+    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC RootSignatureDesc;
+    RootSignatureDesc.Init_1_1(_countof(RootParameters), RootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+    D3D12_INPUT_ELEMENT_DESC InputElementDescs[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+    };
+
+    return Shader::CreateDeviceDependentState(pDevice, pShaderFile, &RootSignatureDesc, InputElementDescs, _countof(InputElementDescs), false, FEEDBACK_TARGET_FORMAT);
 }
@@ -27,7 +27,8 @@ protected:
         D3D12_VERSIONED_ROOT_SIGNATURE_DESC* pRootSignatureDesc,
         D3D12_INPUT_ELEMENT_DESC* pInputElements,
         UINT InputElementCount,
-        bool bEnableAlpha);
+        bool bEnableAlpha,
+        DXGI_FORMAT RenderTargetFormat);
 
 public:
     Shader(UINT32 VertexSize);
@@ -87,3 +88,32 @@ public:
 
     HRESULT CreateDeviceDependentState(ID3D12Device* pDevice, const wchar_t* pShaderFile);
 };
+
+//
+// Creates a shader with a root signature and pipeline state that renders textured quads
+// into the visibility feedback target. The feedback index and texture size of each quad
+// are passed as root constants.
+//
+class FeedbackShader : public Shader
+{
+public:
+    struct VertexFormat
+    {
+        float Position[3];
+        float TexCoords[2];
+    };
+
+    struct Constants
+    {
+        UINT FeedbackIndex;
+        UINT TextureWidth;
+        UINT TextureHeight;
+
+        // log2 of the number of window pixels covered by a feedback texel along each axis.
+        float FeedbackScale;
+    };
+
+    FeedbackShader();
+
+    HRESULT CreateDeviceDependentState(ID3D12Device* pDevice, const wchar_t* pShaderFile);
+};
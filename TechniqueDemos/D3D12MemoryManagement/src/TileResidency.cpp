@@ -0,0 +1,412 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "stdafx.h"
+
+TileResidencyManager::TileResidencyManager()
+{
+    InitializeListHead(&m_FreeListHead);
+    InitializeListHead(&m_LRUListHead);
+
+    ZeroMemory(&m_Statistics, sizeof(m_Statistics));
+}
+
+HRESULT TileResidencyManager::Init(UINT NumPoolTiles, UINT MaxMappingsPerUpdate)
+{
+    //
+    // The pool tiles are linked into the free and LRU lists, so the pool can never
+    // be reallocated once it has been created.
+    //
+    assert(m_PoolTiles.empty());
+
+    try
+    {
+        m_PoolTiles.resize(NumPoolTiles);
+
+        //
+        // Every mapping may need to unmap the tile it evicts as well.
+        //
+        m_Operations.reserve(MaxMappingsPerUpdate * 2);
+    }
+    catch (std::bad_alloc&)
+    {
+        LOG_ERROR("Out of memory allocating the tile pool");
+        return E_OUTOFMEMORY;
+    }
+
+    for (auto& PoolTile : m_PoolTiles)
+    {
+        PoolTile.ResourceIndex = 0;
+        PoolTile.GridIndex = 0;
+        PoolTile.LastUsedUpdate = 0;
+        InsertTailList(&m_FreeListHead, &PoolTile.ListEntry);
+    }
+
+    m_MaxMappingsPerUpdate = MaxMappingsPerUpdate;
+
+    return S_OK;
+}
+
+void TileResidencyManager::Reset()
+{
+    for (UINT i = 0; i < (UINT)m_Resources.size(); ++i)
+    {
+        ReleaseResourceTiles(i);
+    }
+    m_Resources.clear();
+
+    for (UINT8 Mip = 0; Mip < MAX_MIP_COUNT; ++Mip)
+    {
+        m_MissingTiles[Mip].clear();
+    }
+
+    m_Operations.clear();
+    ZeroMemory(&m_Statistics, sizeof(m_Statistics));
+}
+
+void TileResidencyManager::InitializeResourceTiles(UINT ResourceIndex, Resource* pResource)
+{
+    ResourceTiles* pTiles = &m_Resources[ResourceIndex];
+    const ResourceDeviceState* pDeviceState = pResource->pDeviceState;
+
+    UINT NumTiles = 0;
+    for (UINT8 Mip = 0; Mip < pResource->NumStandardMips; ++Mip)
+    {
+        const MipDescription* pDesc = &pDeviceState->Mips[Mip].Desc;
+
+        pTiles->GridOffset[Mip] = NumTiles;
+        NumTiles += pDesc->WidthInTiles * pDesc->HeightInTiles;
+    }
+
+    GridTile Unmapped = { INVALID_TILE_SLOT, 0 };
+    pTiles->Tiles.assign(NumTiles, Unmapped);
+    pTiles->pResource = pResource;
+}
+
+void TileResidencyManager::ReleaseResourceTiles(UINT ResourceIndex)
+{
+    ResourceTiles* pTiles = &m_Resources[ResourceIndex];
+
+    //
+    // The tiles are returned to the pool without unmapping them. The caller releases the
+    // tile mappings along with the resource it mapped them to.
+    //
+    for (auto& Tile : pTiles->Tiles)
+    {
+        if (Tile.PoolTileIndex != INVALID_TILE_SLOT)
+        {
+            PoolTile* pPoolTile = &m_PoolTiles[Tile.PoolTileIndex];
+            RemoveEntryList(&pPoolTile->ListEntry);
+            InsertTailList(&m_FreeListHead, &pPoolTile->ListEntry);
+
+            --m_NumResidentTiles;
+        }
+    }
+
+    pTiles->Tiles.clear();
+    pTiles->pResource = nullptr;
+}
+
+//
+// Requests every tile of a mip which is covered by a feedback cell that samples this
+// mip, or a more detailed one. Resident tiles are moved to the front of the LRU list,
+// and missing tiles are queued to be mapped.
+//
+void TileResidencyManager::RequestTiles(UINT ResourceIndex, UINT8 Mip, const TileFeedback* pFeedback, UINT* pNumRequestedTiles)
+{
+    ResourceTiles* pTiles = &m_Resources[ResourceIndex];
+    const ResourceDeviceState* pDeviceState = pTiles->pResource->pDeviceState;
+    const MipDescription* pDesc = &pDeviceState->Mips[Mip].Desc;
+    const D3D12_TILE_SHAPE* pTileShape = &pDeviceState->StandardTileShape;
+
+    UINT64 MipWidth = max((UINT64)(pDeviceState->Width >> Mip), (UINT64)1);
+    UINT64 MipHeight = max((UINT64)(pDeviceState->Height >> Mip), (UINT64)1);
+
+    for (UINT CellY = 0; CellY < TILE_FEEDBACK_RESOLUTION; ++CellY)
+    {
+        for (UINT CellX = 0; CellX < TILE_FEEDBACK_RESOLUTION; ++CellX)
+        {
+            if (pFeedback->MinMip[CellY][CellX] > Mip)
+            {
+                continue;
+            }
+
+            //
+            // Find the range of texels covered by the cell in this mip, and the tiles
+            // which contain them.
+            //
+            UINT64 FirstTexelX = CellX * MipWidth / TILE_FEEDBACK_RESOLUTION;
+            UINT64 LastTexelX = ((CellX + 1) * MipWidth + TILE_FEEDBACK_RESOLUTION - 1) / TILE_FEEDBACK_RESOLUTION - 1;
+            UINT64 FirstTexelY = CellY * MipHeight / TILE_FEEDBACK_RESOLUTION;
+            UINT64 LastTexelY = ((CellY + 1) * MipHeight + TILE_FEEDBACK_RESOLUTION - 1) / TILE_FEEDBACK_RESOLUTION - 1;
+
+            UINT FirstTileX = (UINT)(FirstTexelX / pTileShape->WidthInTexels);
+            UINT LastTileX = min((UINT)(LastTexelX / pTileShape->WidthInTexels), pDesc->WidthInTiles - 1);
+            UINT FirstTileY = (UINT)(FirstTexelY / pTileShape->HeightInTexels);
+            UINT LastTileY = min((UINT)(LastTexelY / pTileShape->HeightInTexels), pDesc->HeightInTiles - 1);
+
+            for (UINT TileY = FirstTileY; TileY <= LastTileY; ++TileY)
+            {
+                for (UINT TileX = FirstTileX; TileX <= LastTileX; ++TileX)
+                {
+                    UINT GridIndex = pTiles->GridOffset[Mip] + TileY * pDesc->WidthInTiles + TileX;
+                    GridTile* pTile = &pTiles->Tiles[GridIndex];
+
+                    if (pTile->LastRequestedUpdate == m_UpdateIndex)
+                    {
+                        continue;
+                    }
+
+                    pTile->LastRequestedUpdate = m_UpdateIndex;
+                    ++*pNumRequestedTiles;
+
+                    if (pTile->PoolTileIndex != INVALID_TILE_SLOT)
+                    {
+                        PoolTile* pPoolTile = &m_PoolTiles[pTile->PoolTileIndex];
+                        pPoolTile->LastUsedUpdate = m_UpdateIndex;
+
+                        RemoveEntryList(&pPoolTile->ListEntry);
+                        InsertHeadList(&m_LRUListHead, &pPoolTile->ListEntry);
+                    }
+                    else
+                    {
+                        MissingTile Missing = { ResourceIndex, GridIndex };
+                        m_MissingTiles[Mip].push_back(Missing);
+                    }
+                }
+            }
+        }
+    }
+}
+
+//
+// Maps a missing tile to a free pool tile, or to the least recently used pool tile.
+// Returns false if every pool tile has been requested during this update.
+//
+bool TileResidencyManager::MapTile(const MissingTile* pTile)
+{
+    PoolTile* pPoolTile;
+
+    if (!IsListEmpty(&m_FreeListHead))
+    {
+        pPoolTile = CONTAINING_RECORD(RemoveHeadList(&m_FreeListHead), PoolTile, ListEntry);
+        ++m_NumResidentTiles;
+    }
+    else
+    {
+        if (IsListEmpty(&m_LRUListHead))
+        {
+            return false;
+        }
+
+        pPoolTile = CONTAINING_RECORD(m_LRUListHead.Blink, PoolTile, ListEntry);
+        if (pPoolTile->LastUsedUpdate == m_UpdateIndex)
+        {
+            return false;
+        }
+
+        RemoveEntryList(&pPoolTile->ListEntry);
+
+        m_Resources[pPoolTile->ResourceIndex].Tiles[pPoolTile->GridIndex].PoolTileIndex = INVALID_TILE_SLOT;
+        AddOperation(pPoolTile->ResourceIndex, pPoolTile->GridIndex, INVALID_TILE_SLOT);
+
+        ++m_Statistics.EvictedTiles;
+    }
+
+    UINT PoolTileIndex = (UINT)(pPoolTile - m_PoolTiles.data());
+
+    pPoolTile->ResourceIndex = pTile->ResourceIndex;
+    pPoolTile->GridIndex = pTile->GridIndex;
+    pPoolTile->LastUsedUpdate = m_UpdateIndex;
+    InsertHeadList(&m_LRUListHead, &pPoolTile->ListEntry);
+
+    m_Resources[pTile->ResourceIndex].Tiles[pTile->GridIndex].PoolTileIndex = PoolTileIndex;
+    AddOperation(pTile->ResourceIndex, pTile->GridIndex, PoolTileIndex);
+
+    ++m_Statistics.MappedTiles;
+
+    return true;
+}
+
+void TileResidencyManager::AddOperation(UINT ResourceIndex, UINT GridIndex, UINT PoolTileIndex)
+{
+    const ResourceTiles* pTiles = &m_Resources[ResourceIndex];
+    const Resource* pResource = pTiles->pResource;
+
+    //
+    // The tile grids are stored in mip order, so the mip of a tile is the last one
+    // whose grid starts at or before it.
+    //
+    UINT8 Mip = pResource->NumStandardMips - 1;
+    while (pTiles->GridOffset[Mip] > GridIndex)
+    {
+        --Mip;
+    }
+
+    UINT WidthInTiles = pResource->pDeviceState->Mips[Mip].Desc.WidthInTiles;
+    UINT TileIndex = GridIndex - pTiles->GridOffset[Mip];
+
+    TileMappingOperation Operation;
+    Operation.pResource = pTiles->pResource;
+    Operation.ResourceIndex = ResourceIndex;
+    Operation.Coordinate = CD3DX12_TILED_RESOURCE_COORDINATE(TileIndex % WidthInTiles, TileIndex / WidthInTiles, 0, Mip);
+    Operation.PoolTileIndex = PoolTileIndex;
+
+    m_Operations.push_back(Operation);
+}
+
+UINT64 TileResidencyManager::CalculatePerMipBytes(const Resource* pResource, const TileFeedback* pFeedback) const
+{
+    UINT8 MostDetailedMip = UNDEFINED_MIPMAP_INDEX;
+    for (UINT CellY = 0; CellY < TILE_FEEDBACK_RESOLUTION; ++CellY)
+    {
+        for (UINT CellX = 0; CellX < TILE_FEEDBACK_RESOLUTION; ++CellX)
+        {
+            MostDetailedMip = ChooseMoreDetailedMip(MostDetailedMip, pFeedback->MinMip[CellY][CellX]);
+        }
+    }
+
+    UINT64 Bytes = 0;
+    for (UINT8 Mip = MostDetailedMip; Mip < pResource->NumStandardMips; ++Mip)
+    {
+        const MipDescription* pDesc = &pResource->pDeviceState->Mips[Mip].Desc;
+        Bytes += (UINT64)pDesc->WidthInTiles * pDesc->HeightInTiles * TILE_SIZE;
+    }
+
+    return Bytes;
+}
+
+void DecodeTileFeedback(
+    const UINT32* pTexels,
+    UINT Width,
+    UINT Height,
+    UINT RowPitchInTexels,
+    TileFeedback* pFeedback,
+    UINT NumResources)
+{
+    for (UINT i = 0; i < NumResources; ++i)
+    {
+        memset(pFeedback[i].MinMip, UNDEFINED_MIPMAP_INDEX, sizeof(pFeedback[i].MinMip));
+    }
+
+    for (UINT Y = 0; Y < Height; ++Y)
+    {
+        const UINT32* pRow = pTexels + (size_t)Y * RowPitchInTexels;
+
+        for (UINT X = 0; X < Width; ++X)
+        {
+            UINT32 Texel = pRow[X];
+            if (Texel == 0)
+            {
+                continue;
+            }
+
+            UINT FeedbackIndex = (Texel >> TILE_FEEDBACK_INDEX_SHIFT) - 1;
+            if (FeedbackIndex >= NumResources)
+            {
+                continue;
+            }
+
+            UINT CellY = (Texel >> TILE_FEEDBACK_CELL_Y_SHIFT) % TILE_FEEDBACK_RESOLUTION;
+            UINT CellX = (Texel >> TILE_FEEDBACK_CELL_X_SHIFT) % TILE_FEEDBACK_RESOLUTION;
+
+            //
+            // Mips beyond the last valid index are clamped, so that they can't be mistaken
+            // for cells which were not sampled.
+            //
+            UINT8 Mip = (UINT8)min(Texel & TILE_FEEDBACK_MIP_MASK, (UINT32)(UNDEFINED_MIPMAP_INDEX - 1));
+
+            UINT8* pMinMip = &pFeedback[FeedbackIndex].MinMip[CellY][CellX];
+            *pMinMip = ChooseMoreDetailedMip(*pMinMip, Mip);
+        }
+    }
+}
+
+void TileResidencyManager::Update(const TileFeedback* pFeedback, UINT NumResources)
+{
+    ++m_UpdateIndex;
+
+    m_Operations.clear();
+    ZeroMemory(&m_Statistics, sizeof(m_Statistics));
+
+    for (UINT8 Mip = 0; Mip < MAX_MIP_COUNT; ++Mip)
+    {
+        m_MissingTiles[Mip].clear();
+    }
+
+    //
+    // Release the tiles of resources which are no longer part of the feedback.
+    //
+    for (UINT i = NumResources; i < (UINT)m_Resources.size(); ++i)
+    {
+        ReleaseResourceTiles(i);
+    }
+
+    UINT NumRequestedTiles = 0;
+    UINT64 PackedMipBytes = 0;
+
+    try
+    {
+        m_Resources.resize(NumResources);
+
+        for (UINT i = 0; i < NumResources; ++i)
+        {
+            Resource* pResource = pFeedback[i].pResource;
+            if (m_Resources[i].pResource != pResource)
+            {
+                ReleaseResourceTiles(i);
+                InitializeResourceTiles(i, pResource);
+            }
+
+            //
+            // Request tiles from the most detailed mip to the least detailed one, so that
+            // less detailed tiles end up nearer the front of the LRU list, and are evicted
+            // after the more detailed tiles that depend on them.
+            //
+            for (UINT8 Mip = 0; Mip < pResource->NumStandardMips; ++Mip)
+            {
+                RequestTiles(i, Mip, &pFeedback[i], &NumRequestedTiles);
+            }
+
+            PackedMipBytes += (UINT64)pResource->PackedMipTileCount * TILE_SIZE;
+            m_Statistics.PerMipBytes += CalculatePerMipBytes(pResource, &pFeedback[i]);
+        }
+    }
+    catch (std::bad_alloc&)
+    {
+        LOG_WARNING("Out of memory updating tile residency");
+        return;
+    }
+
+    //
+    // Map missing tiles from the least detailed mip to the most detailed one, so that
+    // there is always a less detailed tile to sample while the more detailed ones are
+    // streamed in.
+    //
+    UINT NumMappings = 0;
+    for (UINT8 Mip = MAX_MIP_COUNT; Mip-- > 0;)
+    {
+        for (auto& Missing : m_MissingTiles[Mip])
+        {
+            if (NumMappings == m_MaxMappingsPerUpdate || !MapTile(&Missing))
+            {
+                ++m_Statistics.DeferredTiles;
+                continue;
+            }
+
+            ++NumMappings;
+        }
+    }
+
+    m_Statistics.PerMipBytes += PackedMipBytes;
+    m_Statistics.RequiredBytes = (UINT64)NumRequestedTiles * TILE_SIZE + PackedMipBytes;
+    m_Statistics.ResidentBytes = (UINT64)m_NumResidentTiles * TILE_SIZE + PackedMipBytes;
+}
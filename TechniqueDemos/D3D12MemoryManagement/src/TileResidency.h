@@ -0,0 +1,187 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+//
+// The feedback map divides each image into a grid of cells, each of which stores the
+// most detailed mip that is sampled anywhere in the cell. Feedback.hlsl must use the
+// same resolution.
+//
+#define TILE_FEEDBACK_RESOLUTION 16
+
+//
+// Each texel of the feedback target stores the feedback index of the image drawn there
+// plus one, and the cell and mip that the image sampled. Texels that no image covers
+// are cleared to zero.
+//
+#define TILE_FEEDBACK_INDEX_SHIFT 16
+#define TILE_FEEDBACK_CELL_Y_SHIFT 12
+#define TILE_FEEDBACK_CELL_X_SHIFT 8
+#define TILE_FEEDBACK_MIP_MASK 0xFF
+
+#define INVALID_TILE_SLOT 0xFFFFFFFF
+
+//
+// The per-resource visibility feedback consumed by the tile residency manager. Cells
+// which are not visible or prefetched store UNDEFINED_MIPMAP_INDEX.
+//
+struct TileFeedback
+{
+    Resource* pResource;
+    UINT8 MinMip[TILE_FEEDBACK_RESOLUTION][TILE_FEEDBACK_RESOLUTION];
+};
+
+//
+// Fills one feedback map per resource from a readback of the feedback target. The
+// resource of each feedback map must be set by the caller.
+//
+void DecodeTileFeedback(
+    const UINT32* pTexels,
+    UINT Width,
+    UINT Height,
+    UINT RowPitchInTexels,
+    TileFeedback* pFeedback,
+    UINT NumResources);
+
+//
+// A single tile mapping change produced by an update. Coordinate and PoolTileIndex are
+// the tiled resource coordinate and heap range start offset to pass to
+// UpdateTileMappings. Unmapped tiles have a PoolTileIndex of INVALID_TILE_SLOT.
+//
+struct TileMappingOperation
+{
+    Resource* pResource;
+    UINT ResourceIndex;
+    D3D12_TILED_RESOURCE_COORDINATE Coordinate;
+    UINT PoolTileIndex;
+};
+
+//
+// Memory usage measured by the last update. Both totals include the packed mipmaps,
+// which are always paged as a whole.
+//
+struct TileResidencyStatistics
+{
+    // Memory per-mip paging would need for the same feedback, with every mipmap from
+    // the most detailed one requested down to the least detailed one fully resident.
+    UINT64 PerMipBytes;
+
+    // Memory of the tiles requested by the feedback.
+    UINT64 RequiredBytes;
+
+    // Memory of the tiles currently mapped from the tile pool.
+    UINT64 ResidentBytes;
+
+    UINT MappedTiles;
+    UINT EvictedTiles;
+
+    // Requested tiles which could not be mapped, because the pool was full of tiles
+    // requested this update, or the per-update mapping limit was reached.
+    UINT DeferredTiles;
+};
+
+//
+// Tracks the residency of the standard mipmaps of reserved resources at the granularity
+// of single 64KB tiles. Every update, the tiles covered by each cell of the feedback map
+// are requested at the cell's mip and all less detailed mips, so a partly visible image
+// only needs the visible part of its detailed mipmaps. Missing tiles are mapped from a
+// fixed size tile pool, least detailed mip first, and the least recently used tiles are
+// evicted when the pool is full.
+//
+// The manager only runs on the CPU, and never touches the D3D12 objects of the resources.
+// It produces the tile mapping operations for the caller to apply to its tile pool, and
+// the statistics to measure the tile residency policy against per-mip paging.
+//
+class TileResidencyManager
+{
+private:
+    //
+    // A slot in the tile pool. A slot is either in the free list, or in the LRU list
+    // and mapped to one tile of a resource.
+    //
+    struct PoolTile
+    {
+        LIST_ENTRY ListEntry;
+        UINT ResourceIndex;
+        UINT GridIndex;
+        UINT64 LastUsedUpdate;
+    };
+
+    struct GridTile
+    {
+        UINT PoolTileIndex;
+        UINT64 LastRequestedUpdate;
+    };
+
+    //
+    // Per-resource tile grids for each standard mipmap, stored back to back in Tiles.
+    //
+    struct ResourceTiles
+    {
+        Resource* pResource;
+        UINT GridOffset[MAX_MIP_COUNT];
+        std::vector<GridTile> Tiles;
+    };
+
+    struct MissingTile
+    {
+        UINT ResourceIndex;
+        UINT GridIndex;
+    };
+
+    std::vector<PoolTile> m_PoolTiles;
+    LIST_ENTRY m_FreeListHead;
+    LIST_ENTRY m_LRUListHead;
+    UINT m_NumResidentTiles = 0;
+
+    std::vector<ResourceTiles> m_Resources;
+    std::vector<MissingTile> m_MissingTiles[MAX_MIP_COUNT];
+    std::vector<TileMappingOperation> m_Operations;
+
+    UINT64 m_UpdateIndex = 0;
+    UINT m_MaxMappingsPerUpdate = 0;
+    TileResidencyStatistics m_Statistics;
+
+    void InitializeResourceTiles(UINT ResourceIndex, Resource* pResource);
+    void ReleaseResourceTiles(UINT ResourceIndex);
+    void RequestTiles(UINT ResourceIndex, UINT8 Mip, const TileFeedback* pFeedback, UINT* pNumRequestedTiles);
+    bool MapTile(const MissingTile* pTile);
+    void AddOperation(UINT ResourceIndex, UINT GridIndex, UINT PoolTileIndex);
+    UINT64 CalculatePerMipBytes(const Resource* pResource, const TileFeedback* pFeedback) const;
+
+public:
+    TileResidencyManager();
+
+    HRESULT Init(UINT NumPoolTiles, UINT MaxMappingsPerUpdate);
+
+    //
+    // Releases every tile in the pool. Must be called when the device dependent state of
+    // the resources is destroyed, since their tile grids may change on the new device.
+    //
+    void Reset();
+
+    //
+    // Updates tile residency from one feedback map per resource. Resources are identified
+    // by their index in the feedback array, which should remain stable between updates.
+    //
+    void Update(const TileFeedback* pFeedback, UINT NumResources);
+
+    inline const std::vector<TileMappingOperation>& GetOperations() const
+    {
+        return m_Operations;
+    }
+
+    inline const TileResidencyStatistics& GetStatistics() const
+    {
+        return m_Statistics;
+    }
+};
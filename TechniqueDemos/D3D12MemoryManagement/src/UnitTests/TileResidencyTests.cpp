@@ -0,0 +1,319 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "stdafx.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TileResidencyTests
+{
+    static const UINT TileWidthInTexels = 128;
+    static const UINT TileHeightInTexels = 128;
+
+    //
+    // A resource with only the state the tile residency manager reads. There is no D3D12
+    // resource behind it, and every mip uses 128x128 texel tiles, like a 32bpp format.
+    //
+    class TestResource
+    {
+    private:
+        Resource m_Resource;
+        std::vector<BYTE> m_DeviceState;
+
+    public:
+        TestResource(UINT Width, UINT Height, UINT8 NumStandardMips)
+        {
+            ZeroMemory(&m_Resource, sizeof(m_Resource));
+            m_Resource.NumStandardMips = NumStandardMips;
+            m_Resource.NumPackedMips = 1;
+            m_Resource.PackedMipTileCount = 1;
+
+            m_DeviceState.resize(sizeof(ResourceDeviceState) - sizeof(ResourceMip) + (NumStandardMips + 1) * sizeof(ResourceMip));
+
+            ResourceDeviceState* pDeviceState = reinterpret_cast<ResourceDeviceState*>(m_DeviceState.data());
+            pDeviceState->StandardTileShape.WidthInTexels = TileWidthInTexels;
+            pDeviceState->StandardTileShape.HeightInTexels = TileHeightInTexels;
+            pDeviceState->StandardTileShape.DepthInTexels = 1;
+            pDeviceState->Width = Width;
+            pDeviceState->Height = Height;
+
+            for (UINT8 Mip = 0; Mip < NumStandardMips; ++Mip)
+            {
+                UINT MipWidth = max(Width >> Mip, 1u);
+                UINT MipHeight = max(Height >> Mip, 1u);
+
+                pDeviceState->Mips[Mip].Desc.WidthInTiles = (MipWidth + TileWidthInTexels - 1) / TileWidthInTexels;
+                pDeviceState->Mips[Mip].Desc.HeightInTiles = (MipHeight + TileHeightInTexels - 1) / TileHeightInTexels;
+            }
+
+            m_Resource.pDeviceState = pDeviceState;
+        }
+
+        Resource* Get()
+        {
+            return &m_Resource;
+        }
+    };
+
+    static void ClearFeedback(TileFeedback* pFeedback, Resource* pResource)
+    {
+        pFeedback->pResource = pResource;
+        memset(pFeedback->MinMip, UNDEFINED_MIPMAP_INDEX, sizeof(pFeedback->MinMip));
+    }
+
+    static void FillFeedback(TileFeedback* pFeedback, Resource* pResource, UINT8 Mip)
+    {
+        pFeedback->pResource = pResource;
+        memset(pFeedback->MinMip, Mip, sizeof(pFeedback->MinMip));
+    }
+
+    static UINT32 PackFeedbackTexel(UINT FeedbackIndex, UINT CellX, UINT CellY, UINT Mip)
+    {
+        return ((FeedbackIndex + 1) << TILE_FEEDBACK_INDEX_SHIFT) |
+            (CellY << TILE_FEEDBACK_CELL_Y_SHIFT) |
+            (CellX << TILE_FEEDBACK_CELL_X_SHIFT) |
+            Mip;
+    }
+
+    static void AssertOperation(
+        const TileMappingOperation& Operation,
+        UINT ResourceIndex,
+        UINT X,
+        UINT Y,
+        UINT Mip,
+        UINT PoolTileIndex)
+    {
+        Assert::AreEqual(ResourceIndex, Operation.ResourceIndex);
+        Assert::AreEqual(X, Operation.Coordinate.X);
+        Assert::AreEqual(Y, Operation.Coordinate.Y);
+        Assert::AreEqual(0u, Operation.Coordinate.Z);
+        Assert::AreEqual(Mip, Operation.Coordinate.Subresource);
+        Assert::AreEqual(PoolTileIndex, Operation.PoolTileIndex);
+    }
+
+    TEST_CLASS(TileResidencyManagerTests)
+    {
+    public:
+
+        TEST_METHOD(MapsTilesUnderSampledCellsInEveryLessDetailedMip)
+        {
+            TestResource Image(512, 256, 3);
+
+            TileResidencyManager Manager;
+            Assert::AreEqual(S_OK, Manager.Init(16, 16));
+
+            //
+            // Only the bottom right cell is sampled. At 512x256, 256x128 and 128x64 texels,
+            // it lies in tile (3, 1), (1, 0) and (0, 0) of each mip.
+            //
+            TileFeedback Feedback;
+            ClearFeedback(&Feedback, Image.Get());
+            Feedback.MinMip[TILE_FEEDBACK_RESOLUTION - 1][TILE_FEEDBACK_RESOLUTION - 1] = 0;
+
+            Manager.Update(&Feedback, 1);
+
+            const std::vector<TileMappingOperation>& Operations = Manager.GetOperations();
+            Assert::AreEqual(3u, (UINT)Operations.size());
+            AssertOperation(Operations[0], 0, 0, 0, 2, 0);
+            AssertOperation(Operations[1], 0, 1, 0, 1, 1);
+            AssertOperation(Operations[2], 0, 3, 1, 0, 2);
+
+            //
+            // The byte counts include the packed mip tile. Per-mip paging would need all
+            // 4x2 + 2x1 + 1x1 tiles of the three mips.
+            //
+            const TileResidencyStatistics& Statistics = Manager.GetStatistics();
+            Assert::AreEqual(3u, Statistics.MappedTiles);
+            Assert::AreEqual(0u, Statistics.DeferredTiles);
+            Assert::AreEqual(4u, (UINT)(Statistics.RequiredBytes / TILE_SIZE));
+            Assert::AreEqual(4u, (UINT)(Statistics.ResidentBytes / TILE_SIZE));
+            Assert::AreEqual(12u, (UINT)(Statistics.PerMipBytes / TILE_SIZE));
+
+            //
+            // Resident tiles are not mapped again.
+            //
+            Manager.Update(&Feedback, 1);
+            Assert::IsTrue(Manager.GetOperations().empty());
+        }
+
+        TEST_METHOD(EvictsLeastRecentlyUsedTile)
+        {
+            TestResource ImageA(256, 256, 1);
+            TestResource ImageB(128, 128, 1);
+
+            TileResidencyManager Manager;
+            Assert::AreEqual(S_OK, Manager.Init(4, 16));
+
+            TileFeedback Feedback[2];
+            FillFeedback(&Feedback[0], ImageA.Get(), 0);
+            ClearFeedback(&Feedback[1], ImageB.Get());
+
+            //
+            // Fill the pool with the four tiles of A, then only sample the three tiles of A
+            // outside of the top left quadrant, so that tile (0, 0) is the least recently used.
+            //
+            Manager.Update(Feedback, 2);
+            Assert::AreEqual(4u, Manager.GetStatistics().MappedTiles);
+            AssertOperation(Manager.GetOperations()[0], 0, 0, 0, 0, 0);
+
+            for (UINT CellY = 0; CellY < TILE_FEEDBACK_RESOLUTION / 2; ++CellY)
+            {
+                for (UINT CellX = 0; CellX < TILE_FEEDBACK_RESOLUTION / 2; ++CellX)
+                {
+                    Feedback[0].MinMip[CellY][CellX] = UNDEFINED_MIPMAP_INDEX;
+                }
+            }
+
+            Manager.Update(Feedback, 2);
+            Assert::IsTrue(Manager.GetOperations().empty());
+
+            //
+            // Sampling B needs a pool tile, which is taken from A's tile (0, 0). The tile is
+            // unmapped from A before it is mapped to B.
+            //
+            ClearFeedback(&Feedback[0], ImageA.Get());
+            FillFeedback(&Feedback[1], ImageB.Get(), 0);
+
+            Manager.Update(Feedback, 2);
+
+            const std::vector<TileMappingOperation>& Operations = Manager.GetOperations();
+            Assert::AreEqual(2u, (UINT)Operations.size());
+            AssertOperation(Operations[0], 0, 0, 0, 0, INVALID_TILE_SLOT);
+            AssertOperation(Operations[1], 1, 0, 0, 0, 0);
+
+            const TileResidencyStatistics& Statistics = Manager.GetStatistics();
+            Assert::AreEqual(1u, Statistics.MappedTiles);
+            Assert::AreEqual(1u, Statistics.EvictedTiles);
+            Assert::AreEqual(0u, Statistics.DeferredTiles);
+        }
+
+        TEST_METHOD(DefersTilesWhenPoolIsFullOfRequestedTiles)
+        {
+            TestResource Image(256, 256, 1);
+
+            TileResidencyManager Manager;
+            Assert::AreEqual(S_OK, Manager.Init(2, 16));
+
+            TileFeedback Feedback;
+            FillFeedback(&Feedback, Image.Get(), 0);
+
+            //
+            // Tiles requested by the same update are never evicted for one another, so the
+            // two tiles which don't fit stay deferred for as long as all four are sampled.
+            //
+            for (UINT Update = 0; Update < 2; ++Update)
+            {
+                Manager.Update(&Feedback, 1);
+
+                const TileResidencyStatistics& Statistics = Manager.GetStatistics();
+                Assert::AreEqual(Update == 0 ? 2u : 0u, Statistics.MappedTiles);
+                Assert::AreEqual(0u, Statistics.EvictedTiles);
+                Assert::AreEqual(2u, Statistics.DeferredTiles);
+                Assert::AreEqual(5u, (UINT)(Statistics.RequiredBytes / TILE_SIZE));
+                Assert::AreEqual(3u, (UINT)(Statistics.ResidentBytes / TILE_SIZE));
+            }
+        }
+
+        TEST_METHOD(LimitsMappingsPerUpdateLeastDetailedMipFirst)
+        {
+            TestResource Image(256, 256, 2);
+
+            TileResidencyManager Manager;
+            Assert::AreEqual(S_OK, Manager.Init(16, 1));
+
+            TileFeedback Feedback;
+            FillFeedback(&Feedback, Image.Get(), 0);
+
+            Manager.Update(&Feedback, 1);
+            Assert::AreEqual(1u, (UINT)Manager.GetOperations().size());
+            AssertOperation(Manager.GetOperations()[0], 0, 0, 0, 1, 0);
+            Assert::AreEqual(4u, Manager.GetStatistics().DeferredTiles);
+
+            Manager.Update(&Feedback, 1);
+            Assert::AreEqual(1u, (UINT)Manager.GetOperations().size());
+            AssertOperation(Manager.GetOperations()[0], 0, 0, 0, 0, 1);
+            Assert::AreEqual(3u, Manager.GetStatistics().DeferredTiles);
+        }
+
+        TEST_METHOD(ResetReturnsEveryTileToThePool)
+        {
+            TestResource Image(256, 256, 1);
+
+            TileResidencyManager Manager;
+            Assert::AreEqual(S_OK, Manager.Init(4, 16));
+
+            TileFeedback Feedback;
+            FillFeedback(&Feedback, Image.Get(), 0);
+
+            Manager.Update(&Feedback, 1);
+            Manager.Reset();
+            Manager.Update(&Feedback, 1);
+
+            const TileResidencyStatistics& Statistics = Manager.GetStatistics();
+            Assert::AreEqual(4u, Statistics.MappedTiles);
+            Assert::AreEqual(0u, Statistics.EvictedTiles);
+            Assert::AreEqual(0u, Statistics.DeferredTiles);
+        }
+    };
+
+    TEST_CLASS(DecodeTileFeedbackTests)
+    {
+    public:
+
+        TEST_METHOD(KeepsMostDetailedMipOfEachCell)
+        {
+            TestResource ImageA(256, 256, 1);
+            TestResource ImageB(256, 256, 1);
+
+            //
+            // Two rows of three texels, padded to a row pitch of four texels. The padding
+            // holds a valid texel, which must not be decoded.
+            //
+            const UINT32 Texels[] =
+            {
+                PackFeedbackTexel(0, 3, 5, 1), PackFeedbackTexel(0, 3, 5, 2), 0, PackFeedbackTexel(1, 0, 0, 0),
+                PackFeedbackTexel(1, 15, 0, 200), PackFeedbackTexel(7, 1, 1, 0), PackFeedbackTexel(0, 4, 5, 3), PackFeedbackTexel(1, 0, 0, 0),
+            };
+
+            TileFeedback Feedback[2];
+            Feedback[0].pResource = ImageA.Get();
+            Feedback[1].pResource = ImageB.Get();
+            Feedback[1].MinMip[0][0] = 0;
+
+            DecodeTileFeedback(Texels, 3, 2, 4, Feedback, 2);
+
+            Assert::IsTrue(Feedback[0].pResource == ImageA.Get());
+            Assert::AreEqual(1u, (UINT)Feedback[0].MinMip[5][3]);
+            Assert::AreEqual(3u, (UINT)Feedback[0].MinMip[5][4]);
+
+            //
+            // Mips past the last valid index are clamped, and the texel of the image that
+            // doesn't exist is ignored.
+            //
+            Assert::AreEqual((UINT)UNDEFINED_MIPMAP_INDEX - 1, (UINT)Feedback[1].MinMip[0][15]);
+            Assert::AreEqual((UINT)UNDEFINED_MIPMAP_INDEX, (UINT)Feedback[1].MinMip[0][0]);
+            Assert::AreEqual((UINT)UNDEFINED_MIPMAP_INDEX, (UINT)Feedback[0].MinMip[1][1]);
+
+            UINT NumSampledCells = 0;
+            for (UINT i = 0; i < 2; ++i)
+            {
+                for (UINT CellY = 0; CellY < TILE_FEEDBACK_RESOLUTION; ++CellY)
+                {
+                    for (UINT CellX = 0; CellX < TILE_FEEDBACK_RESOLUTION; ++CellX)
+                    {
+                        NumSampledCells += Feedback[i].MinMip[CellY][CellX] != UNDEFINED_MIPMAP_INDEX;
+                    }
+                }
+            }
+            Assert::AreEqual(3u, NumSampledCells);
+        }
+    };
+}
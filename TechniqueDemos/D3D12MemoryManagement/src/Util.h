@@ -23,6 +23,14 @@ bool GetTargetPixelFormat(const GUID* pSourceFormat, GUID* pTargetFormat);
 //
 DXGI_FORMAT GetDXGIFormatFromPixelFormat(const GUID* pPixelFormat);
 
+//
+// Rounds Value up to the next multiple of Alignment, which must be a power of two.
+//
+inline UINT64 AlignUp(UINT64 Value, UINT64 Alignment)
+{
+    return (Value + Alignment - 1) & ~(Alignment - 1);
+}
+
 //
 // Gets the index to the least detailed mipmap for the specified resource.
 //
@@ -28,6 +28,35 @@
 #define TILE_SIZE _64KB
 #define MAX_HEAP_SIZE _16MB
 
+//
+// Specifies the size of the upload ring used by the paging context to stage mipmap
+// data, and the amount of staged data the paging thread gathers into one submission.
+//
+#define STAGING_RING_SIZE _64MB
+#define MAX_PAGING_BATCH_SIZE _16MB
+#define MAX_PAGING_BATCH_OPERATIONS 32
+
+//
+// Specifies how much decoded pixel data may be queued, decoding, or waiting to be
+// uploaded at once. This bounds the system memory used by the decode thread pool.
+//
+#define MAX_DECODE_MEMORY _64MB
+
+//
+// Specifies the size of the tile pool heap used by tile residency, and how many tiles
+// may be mapped each frame.
+//
+#define TILE_POOL_SIZE _256MB
+#define MAX_TILE_MAPPINGS_PER_UPDATE 256
+
+//
+// The visibility feedback target has one texel per FEEDBACK_TARGET_SCALE x
+// FEEDBACK_TARGET_SCALE window pixels. FEEDBACK_TARGET_SCALE_LOG2 must match it.
+//
+#define FEEDBACK_TARGET_SCALE 8
+#define FEEDBACK_TARGET_SCALE_LOG2 3
+#define FEEDBACK_TARGET_FORMAT DXGI_FORMAT_R32_UINT
+
 //
 // Specifies the default size of a buffer in a dynamic buffer.
 //
@@ -76,6 +105,7 @@ struct RenderFrame;
 struct ResourceMip;
 struct ResourceDeviceState;
 struct Resource;
+struct DecodeRequest;
 struct Buffer;
 struct DescriptorHeap;
 
@@ -125,6 +155,7 @@ struct ColorF
 #include "Render.h"
 #include "Paging.h"
 #include "Framework.h"
+#include "TileResidency.h"
 
 template<typename T>
 inline void SafeRelease(T *&rpInterface)